@@ -0,0 +1,195 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "core/outputbackend.h"
+#include "internalwindow.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <QPaintEvent>
+#include <QPainter>
+#include <QQuickItem>
+#include <QQuickView>
+#include <QRasterWindow>
+#include <QTemporaryDir>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_backingstore-0");
+
+class RasterWindow : public QRasterWindow
+{
+    Q_OBJECT
+public:
+    QColor color = Qt::red;
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        QPainter p(this);
+        for (const QRect &rect : event->region()) {
+            p.fillRect(rect, color);
+        }
+    }
+};
+
+class BackingStoreTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testPartialRepaint();
+    void testBuffersReused();
+    void benchmarkQuickAnimation();
+
+private:
+    InternalWindow *waitForInternalWindow(QWindow *window);
+    void repaint(QWindow *window);
+};
+
+void BackingStoreTest::initTestCase()
+{
+    // QtQuick windows are painted by the raster backing store only with the software renderer.
+    qputenv("QT_QUICK_BACKEND", QByteArrayLiteral("software"));
+
+    qRegisterMetaType<KWin::InternalWindow *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024)));
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+}
+
+InternalWindow *BackingStoreTest::waitForInternalWindow(QWindow *window)
+{
+    QSignalSpy windowAddedSpy(workspace(), &Workspace::internalWindowAdded);
+    window->show();
+    if (!windowAddedSpy.wait()) {
+        return nullptr;
+    }
+    auto internalWindow = windowAddedSpy.first().first().value<InternalWindow *>();
+    if (internalWindow->handle() != window) {
+        return nullptr;
+    }
+    return internalWindow;
+}
+
+void BackingStoreTest::repaint(QWindow *window)
+{
+    // Paint and present the window right away rather than on the next update request.
+    QEvent event(QEvent::UpdateRequest);
+    QCoreApplication::sendEvent(window, &event);
+}
+
+void BackingStoreTest::testPartialRepaint()
+{
+    // This test verifies that the parts of a window that are not repainted keep their contents,
+    // no matter which buffer the window is painted to.
+    RasterWindow window;
+    window.setGeometry(0, 0, 100, 100);
+    InternalWindow *internalWindow = waitForInternalWindow(&window);
+    QVERIFY(internalWindow);
+    QTRY_COMPARE(internalWindow->internalImageObject().pixel(50, 50), QColor(Qt::red).rgb());
+
+    const struct
+    {
+        QRect rect;
+        QColor color;
+    } frames[] = {
+        {QRect(0, 0, 50, 100), Qt::green},
+        {QRect(50, 0, 50, 50), Qt::blue},
+        {QRect(25, 25, 50, 50), Qt::yellow},
+        {QRect(0, 50, 100, 50), Qt::cyan},
+        {QRect(90, 0, 10, 10), Qt::magenta},
+    };
+
+    QImage expected(100, 100, QImage::Format_ARGB32_Premultiplied);
+    expected.fill(Qt::red);
+    for (const auto &frame : frames) {
+        window.color = frame.color;
+        window.update(frame.rect);
+        repaint(&window);
+
+        QPainter(&expected).fillRect(frame.rect, frame.color);
+        const QImage image = internalWindow->internalImageObject();
+        for (int y = 5; y < 100; y += 10) {
+            for (int x = 5; x < 100; x += 10) {
+                QCOMPARE(image.pixel(x, y), expected.pixel(x, y));
+            }
+        }
+    }
+}
+
+void BackingStoreTest::testBuffersReused()
+{
+    // This test verifies that the window is painted to a small set of buffers, rather than to
+    // a copy of the buffer for every frame.
+    RasterWindow window;
+    window.setGeometry(0, 0, 100, 100);
+    InternalWindow *internalWindow = waitForInternalWindow(&window);
+    QVERIFY(internalWindow);
+
+    QSet<const uchar *> buffers;
+    for (int i = 0; i < 20; ++i) {
+        window.color = QColor::fromHsv(i * 15, 255, 255);
+        window.update(QRect(i * 5, 0, 5, 5));
+        repaint(&window);
+        buffers.insert(internalWindow->internalImageObject().constBits());
+    }
+    QVERIFY(buffers.count() <= 3);
+}
+
+void BackingStoreTest::benchmarkQuickAnimation()
+{
+    // Moves a rectangle across an internal QtQuick window, one frame at a time.
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QFile file(directory.filePath(QStringLiteral("animation.qml")));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArrayLiteral("import QtQuick 2.15\n"
+                                 "Rectangle {\n"
+                                 "    width: 400; height: 300; color: \"white\"\n"
+                                 "    Rectangle { objectName: \"box\"; width: 50; height: 50; color: \"red\" }\n"
+                                 "}\n"));
+    file.close();
+
+    QQuickView view;
+    view.setFlags(Qt::FramelessWindowHint);
+    view.setSource(QUrl::fromLocalFile(file.fileName()));
+    QCOMPARE(view.status(), QQuickView::Ready);
+    QQuickItem *box = view.rootObject()->findChild<QQuickItem *>(QStringLiteral("box"));
+    QVERIFY(box);
+
+    InternalWindow *internalWindow = waitForInternalWindow(&view);
+    QVERIFY(internalWindow);
+
+    int frame = 0;
+    QSet<const uchar *> buffers;
+    QBENCHMARK {
+        for (int i = 0; i < 100; ++i) {
+            box->setX((frame++ * 7) % 350);
+            repaint(&view);
+            buffers.insert(internalWindow->internalImageObject().constBits());
+        }
+    }
+    // However many frames get painted, the same few buffers keep getting reused.
+    QVERIFY(frame >= 100);
+    QVERIFY(buffers.count() <= 3);
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::BackingStoreTest)
+#include "backingstore_test.moc"
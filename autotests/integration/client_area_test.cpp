@@ -0,0 +1,219 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "cursor.h"
+#include "virtualdesktops.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_client_area-0");
+
+class ClientAreaTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testPanelStrut();
+    void testOtherDesktop();
+    void benchmarkTogglePanel_data();
+    void benchmarkTogglePanel();
+
+private:
+    Window *createPanel();
+    bool setPanelExclusiveZone(int zone, Window *window);
+    Window *createWindow(const QSize &size, const QPointF &position);
+
+    std::unique_ptr<KWayland::Client::Surface> m_panelSurface;
+    std::unique_ptr<Test::LayerSurfaceV1> m_panelShellSurface;
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> m_surfaces;
+    std::vector<std::unique_ptr<Test::XdgToplevel>> m_shellSurfaces;
+};
+
+void ClientAreaTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection,
+                              Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024) << QRect(1280, 0, 1280, 1024) << QRect(2560, 0, 1280, 1024) << QRect(3840, 0, 1280, 1024)));
+
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QCOMPARE(workspace()->outputs().count(), 4);
+}
+
+void ClientAreaTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection(Test::AdditionalWaylandInterface::LayerShellV1));
+
+    workspace()->setActiveOutput(QPoint(640, 512));
+    Cursors::self()->mouse()->setPos(QPoint(640, 512));
+}
+
+void ClientAreaTest::cleanup()
+{
+    m_shellSurfaces.clear();
+    m_surfaces.clear();
+    m_panelShellSurface.reset();
+    m_panelSurface.reset();
+    Test::destroyWaylandConnection();
+    VirtualDesktopManager::self()->setCount(1);
+}
+
+Window *ClientAreaTest::createPanel()
+{
+    // A panel along the bottom of the first output, initially without a strut.
+    m_panelSurface.reset(Test::createSurface());
+    m_panelShellSurface.reset(Test::createLayerSurfaceV1(m_panelSurface.get(), QStringLiteral("dock")));
+    m_panelShellSurface->set_anchor(Test::LayerSurfaceV1::anchor_bottom | Test::LayerSurfaceV1::anchor_left | Test::LayerSurfaceV1::anchor_right);
+    m_panelShellSurface->set_size(0, 40);
+    m_panelSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+
+    QSignalSpy configureRequestedSpy(m_panelShellSurface.get(), &Test::LayerSurfaceV1::configureRequested);
+    if (!configureRequestedSpy.wait()) {
+        return nullptr;
+    }
+    m_panelShellSurface->ack_configure(configureRequestedSpy.last().at(0).toUInt());
+    return Test::renderAndWaitForShown(m_panelSurface.get(), configureRequestedSpy.last().at(1).toSize(), Qt::red);
+}
+
+bool ClientAreaTest::setPanelExclusiveZone(int zone, Window *window)
+{
+    // The window is expected to follow the edge of the client area.
+    QSignalSpy frameGeometryChangedSpy(window, &Window::frameGeometryChanged);
+    m_panelShellSurface->set_exclusive_zone(zone);
+    m_panelSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    return frameGeometryChangedSpy.wait();
+}
+
+Window *ClientAreaTest::createWindow(const QSize &size, const QPointF &position)
+{
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), size, Qt::blue);
+    if (!window) {
+        return nullptr;
+    }
+    window->move(position);
+    m_surfaces.push_back(std::move(surface));
+    m_shellSurfaces.push_back(std::move(shellSurface));
+    return window;
+}
+
+void ClientAreaTest::testPanelStrut()
+{
+    // This test verifies that the client areas follow the strut of a panel, and that the windows
+    // at the edge of the client area are kept there.
+    const QVector<Output *> outputs = workspace()->outputs();
+    VirtualDesktop *desktop = VirtualDesktopManager::self()->currentDesktop();
+
+    Window *panel = createPanel();
+    QVERIFY(panel);
+    QCOMPARE(panel->frameGeometry(), QRect(0, 984, 1280, 40));
+    Window *bottom = createWindow(QSize(100, 100), QPointF(100, 924));
+    QVERIFY(bottom);
+    Window *other = createWindow(QSize(100, 100), QPointF(1280 + 100, 924));
+    QVERIFY(other);
+
+    QVERIFY(setPanelExclusiveZone(40, bottom));
+    QCOMPARE(bottom->frameGeometry(), QRect(100, 884, 100, 100));
+    QCOMPARE(other->frameGeometry(), QRect(1280 + 100, 924, 100, 100));
+    QCOMPARE(workspace()->clientArea(MaximizeArea, outputs[0], desktop), QRect(0, 0, 1280, 984));
+    QCOMPARE(workspace()->clientArea(MaximizeArea, outputs[1], desktop), QRect(1280, 0, 1280, 1024));
+    QCOMPARE(workspace()->clientArea(WorkArea, outputs[0], desktop), QRect(0, 0, 5120, 984));
+    QCOMPARE(workspace()->restrictedMoveArea(desktop), StrutRects{StrutRect(0, 984, 1280, 40, StrutAreaBottom)});
+
+    QVERIFY(setPanelExclusiveZone(0, bottom));
+    QCOMPARE(bottom->frameGeometry(), QRect(100, 924, 100, 100));
+    QCOMPARE(other->frameGeometry(), QRect(1280 + 100, 924, 100, 100));
+    QCOMPARE(workspace()->clientArea(MaximizeArea, outputs[0], desktop), QRect(0, 0, 1280, 1024));
+    QCOMPARE(workspace()->clientArea(WorkArea, outputs[0], desktop), QRect(0, 0, 5120, 1024));
+    QVERIFY(workspace()->restrictedMoveArea(desktop).isEmpty());
+}
+
+void ClientAreaTest::testOtherDesktop()
+{
+    // This test verifies that the windows on other virtual desktops are kept at the edge of
+    // the client area too.
+    VirtualDesktopManager::self()->setCount(2);
+    VirtualDesktop *desktop = VirtualDesktopManager::self()->desktopForX11Id(2);
+
+    Window *panel = createPanel();
+    QVERIFY(panel);
+    Window *window = createWindow(QSize(100, 100), QPointF(100, 924));
+    QVERIFY(window);
+    window->enterDesktop(desktop);
+    window->leaveDesktop(VirtualDesktopManager::self()->desktopForX11Id(1));
+    QVERIFY(!window->isOnCurrentDesktop());
+
+    QVERIFY(setPanelExclusiveZone(40, window));
+    QCOMPARE(window->frameGeometry(), QRect(100, 884, 100, 100));
+    QCOMPARE(workspace()->clientArea(MaximizeArea, workspace()->outputs()[0], desktop), QRect(0, 0, 1280, 984));
+
+    QVERIFY(setPanelExclusiveZone(0, window));
+    QCOMPARE(window->frameGeometry(), QRect(100, 924, 100, 100));
+}
+
+void ClientAreaTest::benchmarkTogglePanel_data()
+{
+    QTest::addColumn<int>("windowCount");
+    QTest::addColumn<int>("desktopCount");
+
+    QTest::newRow("50 windows, 4 desktops") << 50 << 4;
+    QTest::newRow("200 windows, 4 desktops") << 200 << 4;
+    QTest::newRow("200 windows, 20 desktops") << 200 << 20;
+}
+
+void ClientAreaTest::benchmarkTogglePanel()
+{
+    // Toggles the strut of a panel on the first output while the windows are spread over all
+    // outputs and virtual desktops.
+    QFETCH(int, windowCount);
+    QFETCH(int, desktopCount);
+
+    VirtualDesktopManager::self()->setCount(desktopCount);
+    const QVector<VirtualDesktop *> desktops = VirtualDesktopManager::self()->desktops();
+    const QVector<Output *> outputs = workspace()->outputs();
+
+    QVERIFY(createPanel());
+    Window *bottom = createWindow(QSize(100, 100), QPointF(100, 924));
+    QVERIFY(bottom);
+    for (int i = 0; i < windowCount; ++i) {
+        const QRect geometry = outputs[i % outputs.count()]->geometry();
+        Window *window = createWindow(QSize(200, 150), geometry.topLeft() + QPointF(50 + (i * 37) % 800, 50 + (i * 53) % 600));
+        QVERIFY(window);
+        VirtualDesktop *desktop = desktops[i % desktops.count()];
+        if (!window->isOnDesktop(desktop)) {
+            window->enterDesktop(desktop);
+            window->leaveDesktop(VirtualDesktopManager::self()->currentDesktop());
+        }
+    }
+
+    QBENCHMARK {
+        QVERIFY(setPanelExclusiveZone(40, bottom));
+        QVERIFY(setPanelExclusiveZone(0, bottom));
+    }
+}
+
+WAYLANDTEST_MAIN(ClientAreaTest)
+#include "client_area_test.moc"
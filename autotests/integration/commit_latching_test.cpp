@@ -0,0 +1,348 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "core/renderloop.h"
+#include "core/renderloop_p.h"
+#include "effectloader.h"
+#include "scene/latencytracker.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+#include <QTimer>
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_commit_latching-0");
+
+/**
+ * Commits a new buffer at a fixed offset after every presented frame, like a game that starts
+ * rendering a new frame when the previous one has been shown.
+ */
+class SyntheticClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    SyntheticClient(KWayland::Client::Surface *surface, const QSize &size, RenderLoop *renderLoop, std::chrono::milliseconds offset)
+        : m_surface(surface)
+        , m_size(size)
+        , m_offset(offset)
+    {
+        m_timer.setSingleShot(true);
+        m_timer.setTimerType(Qt::PreciseTimer);
+        connect(&m_timer, &QTimer::timeout, this, &SyntheticClient::commit);
+        connect(renderLoop, &RenderLoop::framePresented, this, [this](RenderLoop *, std::chrono::nanoseconds timestamp) {
+            if (!m_running) {
+                return;
+            }
+            const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now().time_since_epoch() - timestamp;
+            m_timer.start(std::max(std::chrono::duration_cast<std::chrono::milliseconds>(m_offset - elapsed), 0ms));
+        });
+    }
+
+    void start()
+    {
+        m_running = true;
+        commit();
+    }
+    void stop()
+    {
+        m_running = false;
+        m_timer.stop();
+    }
+
+private:
+    void commit()
+    {
+        m_red = !m_red;
+        Test::render(m_surface, m_size, m_red ? Qt::red : Qt::blue, QImage::Format_RGB32);
+        Test::flushWaylandConnection();
+    }
+
+    KWayland::Client::Surface *m_surface;
+    const QSize m_size;
+    const std::chrono::milliseconds m_offset;
+    QTimer m_timer;
+    bool m_running = false;
+    bool m_red = false;
+};
+
+class CommitLatchingTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testLatchFullscreenCommits();
+    void testNoLatchingForWindows();
+    void testFallbackWhenCommitsStop();
+    void benchmarkLatency_data();
+    void benchmarkLatency();
+
+private:
+    struct Client
+    {
+        std::unique_ptr<KWayland::Client::Surface> surface;
+        std::unique_ptr<Test::XdgToplevel> shellSurface;
+        Window *window = nullptr;
+        QSize size;
+    };
+    void createWindow(Client *client, const QString &title, bool fullScreen);
+    bool waitForFrames(int count);
+    LatencyTracker::Statistics surfaceStatistics(const QString &caption) const;
+
+    RenderLoop *m_renderLoop = nullptr;
+};
+
+void CommitLatchingTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+
+    m_renderLoop = workspace()->outputs().constFirst()->renderLoop();
+    // Compositing normally starts about 11ms before the vblank at 60Hz.
+    m_renderLoop->setLatencyPolicy(LatencyMedium);
+}
+
+void CommitLatchingTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void CommitLatchingTest::cleanup()
+{
+    Compositor::self()->latencyTracker()->setEnabled(false);
+    RenderLoopPrivate::get(m_renderLoop)->commitLatching = true;
+    Test::destroyWaylandConnection();
+}
+
+void CommitLatchingTest::createWindow(Client *client, const QString &title, bool fullScreen)
+{
+    client->surface = Test::createSurface();
+    client->shellSurface.reset(Test::createXdgToplevelSurface(client->surface.get(), Test::CreationSetup::CreateOnly));
+    client->shellSurface->set_title(title);
+    if (fullScreen) {
+        client->shellSurface->set_fullscreen(nullptr);
+    }
+    QSignalSpy toplevelConfigureRequestedSpy(client->shellSurface.get(), &Test::XdgToplevel::configureRequested);
+    QSignalSpy surfaceConfigureRequestedSpy(client->shellSurface->xdgSurface(), &Test::XdgSurface::configureRequested);
+    client->surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(surfaceConfigureRequestedSpy.wait());
+
+    client->size = fullScreen ? toplevelConfigureRequestedSpy.last().at(0).toSize() : QSize(100, 50);
+    client->shellSurface->xdgSurface()->ack_configure(surfaceConfigureRequestedSpy.last().at(0).toUInt());
+    client->window = Test::renderAndWaitForShown(client->surface.get(), client->size, Qt::blue, QImage::Format_RGB32);
+    QVERIFY(client->window);
+    QCOMPARE(client->window->isFullScreen(), fullScreen);
+}
+
+bool CommitLatchingTest::waitForFrames(int count)
+{
+    QSignalSpy framePresentedSpy(m_renderLoop, &RenderLoop::framePresented);
+    while (framePresentedSpy.count() < count) {
+        if (!framePresentedSpy.wait()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+LatencyTracker::Statistics CommitLatchingTest::surfaceStatistics(const QString &caption) const
+{
+    const auto clients = Compositor::self()->latencyTracker()->clientStatistics();
+    for (const LatencyTracker::ClientStatistics &client : clients) {
+        for (const LatencyTracker::SurfaceStatistics &surface : client.surfaces) {
+            if (surface.caption == caption) {
+                return surface.latency;
+            }
+        }
+    }
+    return LatencyTracker::Statistics();
+}
+
+void CommitLatchingTest::testLatchFullscreenCommits()
+{
+    // This test verifies that the render loop learns when a fullscreen window commits and
+    // waits for the commits that arrive after compositing would normally have started.
+    Client background;
+    createWindow(&background, QStringLiteral("background"), false);
+    QVERIFY(background.window);
+    Client fullScreen;
+    createWindow(&fullScreen, QStringLiteral("fullscreen"), true);
+    QVERIFY(fullScreen.window);
+
+    // The background window commits right after every vblank, which starts compositing at the
+    // usual time. The fullscreen window commits a few milliseconds later.
+    SyntheticClient backgroundClient(background.surface.get(), background.size, m_renderLoop, 0ms);
+    SyntheticClient fullScreenClient(fullScreen.surface.get(), fullScreen.size, m_renderLoop, 8ms);
+    backgroundClient.start();
+    fullScreenClient.start();
+    QVERIFY(waitForFrames(30));
+
+    RenderLoopPrivate *renderLoopPrivate = RenderLoopPrivate::get(m_renderLoop);
+    QCOMPARE(renderLoopPrivate->latchSurface.data(), fullScreen.window->surface());
+    const std::chrono::nanoseconds vblankInterval(1'000'000'000'000 / m_renderLoop->refreshRate());
+    QVERIFY(renderLoopPrivate->commitJournals.value(fullScreen.window->surface()).predict(vblankInterval / 10).has_value());
+
+    const quint64 latched = renderLoopPrivate->latchedCommits;
+    const quint64 missed = renderLoopPrivate->missedCommits;
+    QVERIFY(waitForFrames(60));
+    QVERIFY(renderLoopPrivate->latchedCommits > latched);
+    QVERIFY(renderLoopPrivate->latchedCommits - latched > renderLoopPrivate->missedCommits - missed);
+
+    backgroundClient.stop();
+    fullScreenClient.stop();
+}
+
+void CommitLatchingTest::testNoLatchingForWindows()
+{
+    // This test verifies that compositing never waits for a window that is not fullscreen, even
+    // if it is active and commits regularly, so the other windows don't pay for the wait.
+    Client background;
+    createWindow(&background, QStringLiteral("background"), false);
+    QVERIFY(background.window);
+    Client focused;
+    createWindow(&focused, QStringLiteral("focused"), false);
+    QVERIFY(focused.window);
+    QCOMPARE(workspace()->activeWindow(), focused.window);
+
+    SyntheticClient backgroundClient(background.surface.get(), background.size, m_renderLoop, 0ms);
+    SyntheticClient focusedClient(focused.surface.get(), focused.size, m_renderLoop, 8ms);
+    backgroundClient.start();
+    focusedClient.start();
+
+    RenderLoopPrivate *renderLoopPrivate = RenderLoopPrivate::get(m_renderLoop);
+    const quint64 latched = renderLoopPrivate->latchedCommits;
+    const quint64 missed = renderLoopPrivate->missedCommits;
+    int waits = 0;
+    connect(Compositor::self(), &Compositor::aboutToComposite, this, [renderLoopPrivate, &waits]() {
+        waits += renderLoopPrivate->waitingForCommit ? 1 : 0;
+    });
+    QVERIFY(waitForFrames(60));
+    disconnect(Compositor::self(), &Compositor::aboutToComposite, this, nullptr);
+
+    QVERIFY(!renderLoopPrivate->latchSurface);
+    QCOMPARE(waits, 0);
+    QCOMPARE(renderLoopPrivate->latchedCommits, latched);
+    QCOMPARE(renderLoopPrivate->missedCommits, missed);
+
+    backgroundClient.stop();
+    focusedClient.stop();
+}
+
+void CommitLatchingTest::testFallbackWhenCommitsStop()
+{
+    // This test verifies that the render loop stops waiting for the fullscreen window once it no
+    // longer commits when predicted, and that the other windows keep getting presented.
+    Client background;
+    createWindow(&background, QStringLiteral("background"), false);
+    QVERIFY(background.window);
+    Client fullScreen;
+    createWindow(&fullScreen, QStringLiteral("fullscreen"), true);
+    QVERIFY(fullScreen.window);
+
+    SyntheticClient backgroundClient(background.surface.get(), background.size, m_renderLoop, 0ms);
+    SyntheticClient fullScreenClient(fullScreen.surface.get(), fullScreen.size, m_renderLoop, 8ms);
+    backgroundClient.start();
+    fullScreenClient.start();
+    QVERIFY(waitForFrames(30));
+
+    RenderLoopPrivate *renderLoopPrivate = RenderLoopPrivate::get(m_renderLoop);
+    const std::chrono::nanoseconds vblankInterval(1'000'000'000'000 / m_renderLoop->refreshRate());
+    QVERIFY(renderLoopPrivate->commitJournals.value(fullScreen.window->surface()).predict(vblankInterval / 10).has_value());
+
+    // Every frame is still presented while the predicted commits fail to arrive, and the
+    // render loop gives up after a few misses.
+    const quint64 latched = renderLoopPrivate->latchedCommits;
+    const quint64 missed = renderLoopPrivate->missedCommits;
+    fullScreenClient.stop();
+    QSignalSpy framePresentedSpy(m_renderLoop, &RenderLoop::framePresented);
+    while (framePresentedSpy.count() < 10) {
+        QVERIFY(framePresentedSpy.wait(100));
+    }
+    QVERIFY(!renderLoopPrivate->commitJournals.value(fullScreen.window->surface()).predict(vblankInterval / 10).has_value());
+    QVERIFY(!renderLoopPrivate->waitingForCommit);
+    QVERIFY(renderLoopPrivate->missedCommits > missed);
+    QVERIFY(renderLoopPrivate->missedCommits - missed <= 3);
+    QVERIFY(renderLoopPrivate->latchedCommits - latched <= 1);
+
+    backgroundClient.stop();
+}
+
+void CommitLatchingTest::benchmarkLatency_data()
+{
+    QTest::addColumn<bool>("latching");
+
+    QTest::newRow("without latching") << false;
+    QTest::newRow("with latching") << true;
+}
+
+void CommitLatchingTest::benchmarkLatency()
+{
+    // This benchmark reports the average latency of a fullscreen window that commits a few
+    // milliseconds after compositing would normally start.
+    QFETCH(bool, latching);
+    RenderLoopPrivate::get(m_renderLoop)->commitLatching = latching;
+
+    Client background;
+    createWindow(&background, QStringLiteral("background"), false);
+    QVERIFY(background.window);
+    Client fullScreen;
+    createWindow(&fullScreen, QStringLiteral("fullscreen"), true);
+    QVERIFY(fullScreen.window);
+
+    SyntheticClient backgroundClient(background.surface.get(), background.size, m_renderLoop, 0ms);
+    SyntheticClient fullScreenClient(fullScreen.surface.get(), fullScreen.size, m_renderLoop, 8ms);
+    backgroundClient.start();
+    fullScreenClient.start();
+    QVERIFY(waitForFrames(30));
+
+    LatencyTracker *tracker = Compositor::self()->latencyTracker();
+    tracker->setEnabled(true);
+    QVERIFY(waitForFrames(120));
+    backgroundClient.stop();
+    fullScreenClient.stop();
+
+    const LatencyTracker::Statistics statistics = surfaceStatistics(QStringLiteral("fullscreen"));
+    tracker->setEnabled(false);
+    QVERIFY(statistics.frames > 0);
+    QTest::setBenchmarkResult(std::chrono::duration<qreal, std::milli>(statistics.average).count(), QTest::WalltimeMilliseconds);
+}
+
+WAYLANDTEST_MAIN(CommitLatchingTest)
+#include "commit_latching_test.moc"
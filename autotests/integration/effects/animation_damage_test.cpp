@@ -0,0 +1,253 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "cursor.h"
+#include "deleted.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "kwinanimationeffect.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+#include <cmath>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_animation_damage-0");
+
+/**
+ * Records the region that gets repainted on every screen.
+ */
+class DamageRecorderEffect : public Effect
+{
+    Q_OBJECT
+
+public:
+    struct Frame
+    {
+        EffectScreen *screen;
+        QRegion region;
+    };
+
+    void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override
+    {
+        m_frames.append(Frame{data.screen(), region});
+        effects->paintScreen(mask, region, data);
+    }
+
+    QVector<Frame> takeFrames()
+    {
+        return std::exchange(m_frames, {});
+    }
+
+private:
+    QVector<Frame> m_frames;
+};
+
+/**
+ * Spins a window once about the z axis.
+ */
+class SpinEffect : public AnimationEffect
+{
+    Q_OBJECT
+
+public:
+    void spin(EffectWindow *w)
+    {
+        uint meta = 0;
+        setMetaData(Axis, Qt::ZAxis, meta);
+        animate(w, Rotation, meta, 300, FPx2(360.0), QEasingCurve(), 0, FPx2(0.0), false, false);
+    }
+};
+
+static qint64 pixelCount(const QRegion &region)
+{
+    qint64 count = 0;
+    for (const QRect &rect : region) {
+        count += qint64(rect.width()) * rect.height();
+    }
+    return count;
+}
+
+class AnimationDamageTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testOpenCloseDamage_data();
+    void testOpenCloseDamage();
+    void testRotationDamage();
+
+private:
+    void verifyFrames(const QVector<DamageRecorderEffect::Frame> &frames, const QRect &allowed);
+
+    QPointer<DamageRecorderEffect> m_recorder;
+};
+
+void AnimationDamageTest::initTestCase()
+{
+    qputenv("XDG_DATA_DIRS", QCoreApplication::applicationDirPath().toUtf8());
+
+    qRegisterMetaType<KWin::Window *>();
+    qRegisterMetaType<KWin::Deleted *>();
+    qRegisterMetaType<KWin::Effect *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024) << QRect(1280, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+    qputenv("KWIN_EFFECTS_FORCE_ANIMATIONS", QByteArrayLiteral("1"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void AnimationDamageTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    workspace()->setActiveOutput(QPoint(640, 512));
+    KWin::Cursors::self()->mouse()->setPos(QPoint(640, 512));
+
+    // Inject the recorder into the loaded effects, see also the scripted effects test.
+    m_recorder = new DamageRecorderEffect();
+    const auto children = effects->children();
+    for (QObject *child : children) {
+        if (qstrcmp(child->metaObject()->className(), "KWin::EffectLoader") == 0) {
+            QMetaObject::invokeMethod(child, "effectLoaded", Q_ARG(KWin::Effect *, m_recorder.data()), Q_ARG(QString, QStringLiteral("damagerecorder")));
+            break;
+        }
+    }
+    QVERIFY(static_cast<EffectsHandlerImpl *>(effects)->isEffectLoaded(QStringLiteral("damagerecorder")));
+}
+
+void AnimationDamageTest::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+    QVERIFY(!m_recorder);
+
+    Test::destroyWaylandConnection();
+}
+
+void AnimationDamageTest::verifyFrames(const QVector<DamageRecorderEffect::Frame> &frames, const QRect &allowed)
+{
+    const QRect firstOutput = workspace()->outputs().constFirst()->geometry();
+
+    qint64 repainted = 0;
+    qint64 full = 0;
+    for (const DamageRecorderEffect::Frame &frame : frames) {
+        // Nothing happens on the second output.
+        QCOMPARE(frame.screen->geometry(), firstOutput);
+        QVERIFY2((frame.region - allowed).isEmpty(), "repainted area outside of the animated window");
+        repainted += pixelCount(frame.region);
+        full += qint64(firstOutput.width()) * firstOutput.height();
+    }
+    QVERIFY(!frames.isEmpty());
+    QVERIFY(repainted < full);
+}
+
+void AnimationDamageTest::testOpenCloseDamage_data()
+{
+    QTest::addColumn<QString>("effectName");
+
+    QTest::newRow("Fade") << QStringLiteral("kwin4_effect_fade");
+    QTest::newRow("Scale") << QStringLiteral("kwin4_effect_scale");
+}
+
+void AnimationDamageTest::testOpenCloseDamage()
+{
+    // This test verifies that the open and close animations of the standard effects only repaint
+    // the area of the animated window, on the output that shows it.
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QFETCH(QString, effectName);
+    QVERIFY(effectsImpl->loadEffect(effectName));
+    Effect *effect = effectsImpl->findEffect(effectName);
+    QVERIFY(effect);
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    m_recorder->takeFrames();
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+    QVERIFY(effect->isActive());
+    const QRect allowed = window->frameGeometry().toAlignedRect().adjusted(-2, -2, 2, 2);
+
+    QTRY_VERIFY(!effect->isActive());
+    verifyFrames(m_recorder->takeFrames(), allowed);
+
+    QSignalSpy windowClosedSpy(window, &Window::windowClosed);
+    shellSurface.reset();
+    surface.reset();
+    QVERIFY(windowClosedSpy.wait());
+    QVERIFY(effect->isActive());
+
+    QTRY_VERIFY(!effect->isActive());
+    verifyFrames(m_recorder->takeFrames(), allowed);
+}
+
+void AnimationDamageTest::testRotationDamage()
+{
+    // This test verifies that a rotation about the z axis only repaints the circle the window
+    // sweeps through, rather than the whole screen.
+    QPointer<SpinEffect> effect = new SpinEffect();
+    const auto children = effects->children();
+    for (QObject *child : children) {
+        if (qstrcmp(child->metaObject()->className(), "KWin::EffectLoader") == 0) {
+            QMetaObject::invokeMethod(child, "effectLoaded", Q_ARG(KWin::Effect *, effect.data()), Q_ARG(QString, QStringLiteral("spin")));
+            break;
+        }
+    }
+    QVERIFY(static_cast<EffectsHandlerImpl *>(effects)->isEffectLoaded(QStringLiteral("spin")));
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+
+    // The rotation origin lies within the window, so the window can't get further away from
+    // it than the length of its diagonal.
+    const QRectF expanded = window->effectWindow()->expandedGeometry();
+    const int radius = std::ceil(std::hypot(expanded.width(), expanded.height())) + 2;
+    const QRect allowed = expanded.toAlignedRect().adjusted(-radius, -radius, radius, radius);
+
+    m_recorder->takeFrames();
+    effect->spin(window->effectWindow());
+    QVERIFY(effect->isActive());
+    QTRY_VERIFY(!effect->isActive());
+    verifyFrames(m_recorder->takeFrames(), allowed);
+}
+
+WAYLANDTEST_MAIN(AnimationDamageTest)
+#include "animation_damage_test.moc"
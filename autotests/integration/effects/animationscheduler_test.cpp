@@ -0,0 +1,262 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "kwinanimationeffect.h"
+#include "libkwineffects/animationscheduler_p.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_animation_scheduler-0");
+
+class AnimationSchedulerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testRegistration();
+    void testFrameClock();
+    void testAdvanceAllEffects();
+    void testAdvancePaintedEffects();
+    void benchmarkOpenClose_data();
+    void benchmarkOpenClose();
+
+private:
+    void loadEffects(const QStringList &effectNames);
+};
+
+void AnimationSchedulerTest::initTestCase()
+{
+    qputenv("XDG_DATA_DIRS", QCoreApplication::applicationDirPath().toUtf8());
+
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024) << QRect(1280, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+    qputenv("KWIN_EFFECTS_FORCE_ANIMATIONS", QByteArrayLiteral("1"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void AnimationSchedulerTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void AnimationSchedulerTest::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+
+    Test::destroyWaylandConnection();
+}
+
+void AnimationSchedulerTest::loadEffects(const QStringList &effectNames)
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    for (const QString &effectName : effectNames) {
+        QVERIFY(effectsImpl->loadEffect(effectName));
+    }
+    QCOMPARE(effectsImpl->loadedEffects().count(), effectNames.count());
+}
+
+void AnimationSchedulerTest::testRegistration()
+{
+    // This test verifies that animation effects register with the scheduler and that the
+    // scheduler sees the animations of all effects.
+    AnimationScheduler *scheduler = AnimationScheduler::self();
+    const int initialEffects = scheduler->statistics().effects;
+
+    loadEffects({QStringLiteral("kwin4_effect_fade"), QStringLiteral("kwin4_effect_scale")});
+    QCOMPARE(scheduler->statistics().effects, initialEffects + 2);
+    QCOMPARE(scheduler->statistics().animatingEffects, 0);
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+    QCOMPARE(scheduler->statistics().animatingEffects, 2);
+    QCOMPARE(scheduler->statistics().windows, 2);
+
+    QTRY_COMPARE(scheduler->statistics().animatingEffects, 0);
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    effectsImpl->unloadAllEffects();
+    QCOMPARE(scheduler->statistics().effects, initialEffects);
+}
+
+void AnimationSchedulerTest::testFrameClock()
+{
+    // This test verifies that the animation clock is frozen while a frame is painted and live
+    // otherwise.
+    AnimationScheduler *scheduler = AnimationScheduler::self();
+
+    const qint64 before = scheduler->clock();
+    QTest::qWait(5);
+    QVERIFY(scheduler->clock() > before);
+
+    const std::chrono::milliseconds presentTime = scheduler->presentTime();
+    scheduler->beginFrame(nullptr, presentTime);
+    const qint64 frameClock = scheduler->clock();
+    scheduler->beginFrame(nullptr, presentTime);
+    QTest::qWait(5);
+    QCOMPARE(scheduler->clock(), frameClock);
+    scheduler->endFrame();
+    QCOMPARE(scheduler->clock(), frameClock);
+    scheduler->endFrame();
+    QVERIFY(scheduler->clock() > frameClock);
+}
+
+void AnimationSchedulerTest::testAdvanceAllEffects()
+{
+    // This test verifies that the animations of every painted effect are advanced, not only
+    // those of the effect that started the frame.
+    loadEffects({QStringLiteral("kwin4_effect_fade"), QStringLiteral("kwin4_effect_scale")});
+    AnimationScheduler *scheduler = AnimationScheduler::self();
+    const quint64 frames = scheduler->statistics().frames;
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+    QCOMPARE(scheduler->statistics().animatingEffects, 2);
+
+    QTRY_COMPARE(scheduler->statistics().animatingEffects, 0);
+    QVERIFY(scheduler->statistics().frames > frames);
+}
+
+void AnimationSchedulerTest::testAdvancePaintedEffects()
+{
+    // This test verifies that only the animations of the effects painted in a frame are
+    // advanced, and only once per frame.
+    loadEffects({QStringLiteral("kwin4_effect_fade"), QStringLiteral("kwin4_effect_scale")});
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    auto fade = qobject_cast<AnimationEffect *>(effectsImpl->findEffect(QStringLiteral("kwin4_effect_fade")));
+    auto scale = qobject_cast<AnimationEffect *>(effectsImpl->findEffect(QStringLiteral("kwin4_effect_scale")));
+    QVERIFY(fade);
+    QVERIFY(scale);
+    AnimationScheduler *scheduler = AnimationScheduler::self();
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+    QCOMPARE(scheduler->statistics().animatingEffects, 2);
+
+    // Reuse the timestamp of the last frame, the timelines must not go back in time.
+    const std::chrono::milliseconds presentTime = scheduler->presentTime();
+    const quint64 frames = scheduler->statistics().frames;
+    const quint64 advanced = scheduler->statistics().advancedEffects;
+
+    scheduler->beginFrame(fade, presentTime);
+    QCOMPARE(scheduler->statistics().frames, frames + 1);
+    QCOMPARE(scheduler->statistics().advancedEffects, advanced + 1);
+
+    scheduler->beginFrame(fade, presentTime);
+    QCOMPARE(scheduler->statistics().advancedEffects, advanced + 1);
+
+    scheduler->beginFrame(scale, presentTime);
+    QCOMPARE(scheduler->statistics().frames, frames + 1);
+    QCOMPARE(scheduler->statistics().advancedEffects, advanced + 2);
+
+    scheduler->endFrame();
+    scheduler->endFrame();
+    scheduler->endFrame();
+
+    QTRY_COMPARE(scheduler->statistics().animatingEffects, 0);
+}
+
+void AnimationSchedulerTest::benchmarkOpenClose_data()
+{
+    QTest::addColumn<QStringList>("effectNames");
+
+    QTest::newRow("no effects") << QStringList{};
+    QTest::newRow("scripted effects") << QStringList{
+        QStringLiteral("kwin4_effect_fade"),
+        QStringLiteral("kwin4_effect_scale"),
+        QStringLiteral("kwin4_effect_squash"),
+        QStringLiteral("kwin4_effect_maximize"),
+        QStringLiteral("kwin4_effect_dialogparent"),
+        QStringLiteral("kwin4_effect_fadingpopups"),
+        QStringLiteral("kwin4_effect_morphingpopups"),
+    };
+}
+
+void AnimationSchedulerTest::benchmarkOpenClose()
+{
+    // This benchmark opens and closes 200 windows with the scripted animation effects loaded
+    // and waits until all animations are finished.
+    QFETCH(QStringList, effectNames);
+    loadEffects(effectNames);
+
+    AnimationScheduler *scheduler = AnimationScheduler::self();
+    scheduler->resetStatistics();
+
+    const int windowCount = 200;
+    int peakAnimations = 0;
+    QBENCHMARK_ONCE {
+        std::vector<std::unique_ptr<KWayland::Client::Surface>> surfaces;
+        std::vector<std::unique_ptr<Test::XdgToplevel>> shellSurfaces;
+        for (int i = 0; i < windowCount; ++i) {
+            surfaces.push_back(Test::createSurface());
+            shellSurfaces.emplace_back(Test::createXdgToplevelSurface(surfaces.back().get()));
+            Window *window = Test::renderAndWaitForShown(surfaces.back().get(), QSize(100, 50), Qt::blue);
+            QVERIFY(window);
+            peakAnimations = std::max(peakAnimations, scheduler->statistics().animations);
+        }
+
+        QSignalSpy windowRemovedSpy(workspace(), &Workspace::windowRemoved);
+        shellSurfaces.clear();
+        surfaces.clear();
+        QTRY_COMPARE(windowRemovedSpy.count(), windowCount);
+        peakAnimations = std::max(peakAnimations, scheduler->statistics().animations);
+
+        QTRY_COMPARE_WITH_TIMEOUT(scheduler->statistics().animatingEffects, 0, 30000);
+    }
+
+    const AnimationScheduler::Statistics statistics = scheduler->statistics();
+    QCOMPARE(statistics.animations, 0);
+    QCOMPARE(peakAnimations > 0, !effectNames.isEmpty());
+    QCOMPARE(statistics.frames > 0, !effectNames.isEmpty());
+}
+
+WAYLANDTEST_MAIN(AnimationSchedulerTest)
+#include "animationscheduler_test.moc"
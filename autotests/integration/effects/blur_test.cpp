@@ -0,0 +1,196 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "core/renderloop.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "wayland/surface_interface.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_blur-0");
+
+// Every render target of the blur effect uses four bytes per pixel.
+static const qint64 s_outputBytes = qint64(1280) * 1024 * 4;
+
+class BlurTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testRenderTargetsPerOutput();
+    void testCachedBlur();
+
+private:
+    Effect *loadBlur();
+    Window *createBlurredWindow(KWayland::Client::Surface *surface, const QPoint &position);
+};
+
+void BlurTest::initTestCase()
+{
+    qputenv("XDG_DATA_DIRS", QCoreApplication::applicationDirPath().toUtf8());
+
+    qRegisterMetaType<KWin::Window *>();
+    qRegisterMetaType<KWin::Effect *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024) << QRect(1280, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+    qputenv("KWIN_EFFECTS_FORCE_ANIMATIONS", QByteArrayLiteral("1"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void BlurTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void BlurTest::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+
+    Test::destroyWaylandConnection();
+}
+
+Effect *BlurTest::loadBlur()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    if (!effectsImpl->loadEffect(QStringLiteral("blur"))) {
+        return nullptr;
+    }
+    return effectsImpl->findEffect(QStringLiteral("blur"));
+}
+
+Window *BlurTest::createBlurredWindow(KWayland::Client::Surface *surface, const QPoint &position)
+{
+    Window *window = Test::renderAndWaitForShown(surface, QSize(100, 50), QColor(0, 0, 255, 128));
+    if (!window) {
+        return nullptr;
+    }
+    // An empty blur region blurs the whole window.
+    window->effectWindow()->setData(WindowBlurBehindRole, 1);
+    window->move(position);
+    return window;
+}
+
+void BlurTest::testRenderTargetsPerOutput()
+{
+    // This test verifies that the render targets of the blur effect are allocated per output,
+    // and only for the outputs that show a blurred window.
+    Effect *blur = loadBlur();
+    QVERIFY(blur);
+    QCOMPARE(blur->property("renderTargetPoolCount").toInt(), 0);
+    QCOMPARE(blur->property("renderTargetMemory").toLongLong(), qint64(0));
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = createBlurredWindow(surface.get(), QPoint(100, 100));
+    QVERIFY(window);
+
+    // The render targets are as big as the first output, not as the whole screen.
+    QTRY_COMPARE(blur->property("renderTargetPoolCount").toInt(), 1);
+    qint64 memory = blur->property("renderTargetMemory").toLongLong();
+    QVERIFY(memory >= 2 * s_outputBytes);
+    QVERIFY(memory < 3 * s_outputBytes);
+
+    // Once the window is on the second output, that output gets its own render targets.
+    window->move(QPoint(1280 + 100, 100));
+    QTRY_COMPARE(blur->property("renderTargetPoolCount").toInt(), 2);
+    memory = blur->property("renderTargetMemory").toLongLong();
+    QVERIFY(memory >= 4 * s_outputBytes);
+    QVERIFY(memory < 6 * s_outputBytes);
+}
+
+void BlurTest::testCachedBlur()
+{
+    // This test verifies that the blurred background of a window is reused as long as nothing
+    // behind the window changes, and blurred again when it does.
+    Effect *blur = loadBlur();
+    QVERIFY(blur);
+    RenderLoop *renderLoop = workspace()->outputs().constFirst()->renderLoop();
+
+    std::unique_ptr<KWayland::Client::Surface> backgroundSurface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> backgroundShellSurface(Test::createXdgToplevelSurface(backgroundSurface.get()));
+    Window *background = Test::renderAndWaitForShown(backgroundSurface.get(), QSize(400, 300), Qt::red);
+    QVERIFY(background);
+    background->move(QPoint(50, 50));
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = createBlurredWindow(surface.get(), QPoint(100, 100));
+    QVERIFY(window);
+    QTRY_COMPARE(blur->property("renderTargetPoolCount").toInt(), 1);
+
+    // Only the blurred window changes, so the blurred background can be reused.
+    const qint64 initialHits = blur->property("cachedBlurHits").toLongLong();
+    for (int i = 0; i < 3; ++i) {
+        QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+        Test::render(surface.get(), QSize(100, 50), QColor(0, i * 100, 255, 128));
+        QVERIFY(framePresentedSpy.wait());
+    }
+    QTRY_VERIFY(blur->property("cachedBlurHits").toLongLong() > initialHits);
+
+    // The window behind the blurred window changes, the background has to be blurred again.
+    qint64 hits = blur->property("cachedBlurHits").toLongLong();
+    {
+        QSignalSpy committedSpy(background->surface(), &KWaylandServer::SurfaceInterface::committed);
+        Test::render(backgroundSurface.get(), QSize(400, 300), Qt::green);
+        QVERIFY(committedSpy.wait());
+        QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+        QVERIFY(framePresentedSpy.wait());
+        QCOMPARE(blur->property("cachedBlurHits").toLongLong(), hits);
+    }
+
+    // The window behind the blurred window goes away without damaging any window.
+    hits = blur->property("cachedBlurHits").toLongLong();
+    {
+        QSignalSpy windowClosedSpy(background, &Window::windowClosed);
+        backgroundShellSurface.reset();
+        backgroundSurface.reset();
+        QVERIFY(windowClosedSpy.wait());
+        QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+        QVERIFY(framePresentedSpy.wait());
+        QCOMPARE(blur->property("cachedBlurHits").toLongLong(), hits);
+    }
+}
+
+WAYLANDTEST_MAIN(BlurTest)
+#include "blur_test.moc"
@@ -0,0 +1,359 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "core/renderloop.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_effect_chain-0");
+
+class ChainTestEffect : public Effect
+{
+    Q_OBJECT
+
+public:
+    ChainTestEffect(PaintHooks hooks, bool active)
+        : m_hooks(hooks)
+        , m_active(active)
+    {
+    }
+
+    bool isActive() const override
+    {
+        ++isActiveCalls;
+        return m_active;
+    }
+    void setActive(bool active)
+    {
+        m_active = active;
+        if (m_hooks.testFlag(NotifiesActiveChanged)) {
+            Q_EMIT activeChanged();
+        }
+    }
+    PaintHooks paintHooks() const override
+    {
+        return m_hooks;
+    }
+
+    void prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseconds presentTime) override
+    {
+        ++prePaintScreenCalls;
+        effects->prePaintScreen(data, presentTime);
+    }
+    void prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::chrono::milliseconds presentTime) override
+    {
+        ++prePaintWindowCalls;
+        paintedWindows.insert(w);
+        effects->prePaintWindow(w, data, presentTime);
+    }
+    void postPaintWindow(EffectWindow *w) override
+    {
+        ++postPaintWindowCalls;
+        effects->postPaintWindow(w);
+    }
+
+    mutable int isActiveCalls = 0;
+    int prePaintScreenCalls = 0;
+    int prePaintWindowCalls = 0;
+    int postPaintWindowCalls = 0;
+    QSet<EffectWindow *> paintedWindows;
+
+private:
+    const PaintHooks m_hooks;
+    bool m_active;
+};
+
+class EffectChainTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testRebuildOnActivation();
+    void testNotifiedActivation();
+    void testPaintHooks();
+    void testFilterWindows();
+    void benchmarkWindowChain_data();
+    void benchmarkWindowChain();
+
+private:
+    ChainTestEffect *addEffect(const QString &name, Effect::PaintHooks hooks, bool active);
+    bool renderFrame();
+};
+
+void EffectChainTest::initTestCase()
+{
+    qputenv("XDG_DATA_DIRS", QCoreApplication::applicationDirPath().toUtf8());
+
+    qRegisterMetaType<KWin::Window *>();
+    qRegisterMetaType<KWin::Effect *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024) << QRect(1280, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+    qputenv("KWIN_EFFECTS_FORCE_ANIMATIONS", QByteArrayLiteral("1"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void EffectChainTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void EffectChainTest::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+
+    Test::destroyWaylandConnection();
+}
+
+ChainTestEffect *EffectChainTest::addEffect(const QString &name, Effect::PaintHooks hooks, bool active)
+{
+    // Test effects are not plugins, so they have to be announced through the internal
+    // effect loader just like the scripted effects test does it.
+    auto effect = new ChainTestEffect(hooks, active);
+    const auto children = effects->children();
+    for (QObject *child : children) {
+        if (qstrcmp(child->metaObject()->className(), "KWin::EffectLoader") == 0) {
+            QMetaObject::invokeMethod(child, "effectLoaded", Q_ARG(KWin::Effect *, effect), Q_ARG(QString, name));
+            break;
+        }
+    }
+    return effect;
+}
+
+bool EffectChainTest::renderFrame()
+{
+    RenderLoop *renderLoop = workspace()->outputs().constFirst()->renderLoop();
+    QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+    effects->addRepaintFull();
+    return framePresentedSpy.wait();
+}
+
+void EffectChainTest::testRebuildOnActivation()
+{
+    // This test verifies that the paint chains are only rebuilt when an effect becomes active
+    // or inactive, not every frame.
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+
+    QList<ChainTestEffect *> inactiveEffects;
+    for (int i = 0; i < 40; ++i) {
+        inactiveEffects << addEffect(QStringLiteral("inactive%1").arg(i), Effect::AllPaintHooks, false);
+    }
+    addEffect(QStringLiteral("active"), Effect::AllPaintHooks, true);
+    QCOMPARE(effectsImpl->loadedEffects().count(), 41);
+
+    QVERIFY(renderFrame());
+    const quint64 rebuilds = effectsImpl->paintChainStatistics().rebuilds;
+    QCOMPARE(effectsImpl->paintChainStatistics().activeEffects, 1);
+
+    QVERIFY(renderFrame());
+    QVERIFY(renderFrame());
+    QCOMPARE(effectsImpl->paintChainStatistics().rebuilds, rebuilds);
+
+    inactiveEffects[10]->setActive(true);
+    QVERIFY(renderFrame());
+    QCOMPARE(effectsImpl->paintChainStatistics().rebuilds, rebuilds + 1);
+    QCOMPARE(effectsImpl->paintChainStatistics().activeEffects, 2);
+    QVERIFY(inactiveEffects[10]->prePaintScreenCalls > 0);
+    QCOMPARE(inactiveEffects[9]->prePaintScreenCalls, 0);
+
+    inactiveEffects[10]->setActive(false);
+    QVERIFY(renderFrame());
+    QCOMPARE(effectsImpl->paintChainStatistics().rebuilds, rebuilds + 2);
+    QCOMPARE(effectsImpl->paintChainStatistics().activeEffects, 1);
+}
+
+void EffectChainTest::testNotifiedActivation()
+{
+    // This test verifies that effects that notify about activation changes are not asked
+    // whether they are active every frame.
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+
+    QList<ChainTestEffect *> notifyingEffects;
+    for (int i = 0; i < 40; ++i) {
+        notifyingEffects << addEffect(QStringLiteral("notifying%1").arg(i), Effect::AllPaintHooks | Effect::NotifiesActiveChanged, false);
+    }
+    ChainTestEffect *polledEffect = addEffect(QStringLiteral("polled"), Effect::AllPaintHooks, true);
+
+    QVERIFY(renderFrame());
+    const quint64 rebuilds = effectsImpl->paintChainStatistics().rebuilds;
+    QCOMPARE(effectsImpl->paintChainStatistics().activeEffects, 1);
+    QCOMPARE(effectsImpl->paintChainStatistics().polledEffects, 1);
+
+    const int isActiveCalls = notifyingEffects[10]->isActiveCalls;
+    const int polledIsActiveCalls = polledEffect->isActiveCalls;
+    QVERIFY(renderFrame());
+    QVERIFY(renderFrame());
+    QCOMPARE(effectsImpl->paintChainStatistics().rebuilds, rebuilds);
+    QCOMPARE(notifyingEffects[10]->isActiveCalls, isActiveCalls);
+    QVERIFY(polledEffect->isActiveCalls > polledIsActiveCalls);
+
+    notifyingEffects[10]->setActive(true);
+    QVERIFY(renderFrame());
+    QCOMPARE(effectsImpl->paintChainStatistics().rebuilds, rebuilds + 1);
+    QCOMPARE(effectsImpl->paintChainStatistics().activeEffects, 2);
+    QVERIFY(notifyingEffects[10]->prePaintScreenCalls > 0);
+    QCOMPARE(notifyingEffects[9]->prePaintScreenCalls, 0);
+
+    notifyingEffects[10]->setActive(false);
+    QVERIFY(renderFrame());
+    QCOMPARE(effectsImpl->paintChainStatistics().rebuilds, rebuilds + 2);
+    QCOMPARE(effectsImpl->paintChainStatistics().activeEffects, 1);
+}
+
+void EffectChainTest::testPaintHooks()
+{
+    // This test verifies that an effect is skipped in the hooks it doesn't take part in.
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+
+    ChainTestEffect *screenEffect = addEffect(QStringLiteral("screen"), Effect::PrePaintScreenHook, true);
+    ChainTestEffect *windowEffect = addEffect(QStringLiteral("window"), Effect::PrePaintWindowHook | Effect::PostPaintWindowHook, true);
+
+    QVERIFY(renderFrame());
+    QVERIFY(screenEffect->prePaintScreenCalls > 0);
+    QCOMPARE(screenEffect->prePaintWindowCalls, 0);
+    QCOMPARE(screenEffect->postPaintWindowCalls, 0);
+    QCOMPARE(windowEffect->prePaintScreenCalls, 0);
+    QVERIFY(windowEffect->prePaintWindowCalls > 0);
+    QVERIFY(windowEffect->postPaintWindowCalls > 0);
+    QVERIFY(windowEffect->paintedWindows.contains(window->effectWindow()));
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QCOMPARE(effectsImpl->paintChainStatistics().activeEffects, 2);
+    QCOMPARE(effectsImpl->paintChainStatistics().windowEffects, 1);
+}
+
+void EffectChainTest::testFilterWindows()
+{
+    // This test verifies that the window hooks of an effect that filters windows are only
+    // called for the windows the effect has marked.
+    std::unique_ptr<KWayland::Client::Surface> surface1(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface1(Test::createXdgToplevelSurface(surface1.get()));
+    Window *window1 = Test::renderAndWaitForShown(surface1.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window1);
+    std::unique_ptr<KWayland::Client::Surface> surface2(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface2(Test::createXdgToplevelSurface(surface2.get()));
+    Window *window2 = Test::renderAndWaitForShown(surface2.get(), QSize(100, 50), Qt::red);
+    QVERIFY(window2);
+
+    ChainTestEffect *effect = addEffect(QStringLiteral("filter"), Effect::AllPaintHooks | Effect::FilterWindows, true);
+    window1->effectWindow()->setEffectInterest(effect, true);
+    QVERIFY(window1->effectWindow()->hasEffectInterest(effect));
+    QVERIFY(!window2->effectWindow()->hasEffectInterest(effect));
+
+    QVERIFY(renderFrame());
+    QVERIFY(effect->paintedWindows.contains(window1->effectWindow()));
+    QVERIFY(!effect->paintedWindows.contains(window2->effectWindow()));
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QCOMPARE(effectsImpl->paintChainStatistics().filteringEffects, 1);
+
+    window1->effectWindow()->setEffectInterest(effect, false);
+    effect->paintedWindows.clear();
+    QVERIFY(renderFrame());
+    QVERIFY(effect->paintedWindows.isEmpty());
+}
+
+void EffectChainTest::benchmarkWindowChain_data()
+{
+    QTest::addColumn<int>("windowCount");
+    QTest::addColumn<int>("effectCount");
+
+    for (int windowCount : {10, 100}) {
+        for (int effectCount : {0, 40}) {
+            QTest::addRow("%d windows, %d effects", windowCount, effectCount) << windowCount << effectCount;
+        }
+    }
+}
+
+void EffectChainTest::benchmarkWindowChain()
+{
+    // Measures the cost of walking the window paint hooks of the effect chain for every window.
+    // Most effects are idle, a few are active but only paint the screen or the windows they
+    // animate, which is what a desktop looks like most of the time.
+    QFETCH(int, windowCount);
+    QFETCH(int, effectCount);
+
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> surfaces;
+    std::vector<std::unique_ptr<Test::XdgToplevel>> shellSurfaces;
+    for (int i = 0; i < windowCount; ++i) {
+        surfaces.emplace_back(Test::createSurface());
+        shellSurfaces.emplace_back(Test::createXdgToplevelSurface(surfaces.back().get()));
+        QVERIFY(Test::renderAndWaitForShown(surfaces.back().get(), QSize(100, 50), Qt::blue));
+    }
+
+    for (int i = 0; i < effectCount; ++i) {
+        if (i % 20 == 0) {
+            addEffect(QStringLiteral("screen%1").arg(i), Effect::PrePaintScreenHook | Effect::PaintScreenHook, true);
+        } else if (i % 20 == 1) {
+            addEffect(QStringLiteral("filter%1").arg(i), Effect::AllPaintHooks | Effect::FilterWindows, true);
+        } else {
+            addEffect(QStringLiteral("inactive%1").arg(i), Effect::AllPaintHooks, false);
+        }
+    }
+    QVERIFY(renderFrame());
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    const EffectWindowList windows = effects->stackingOrder();
+    QBENCHMARK {
+        effectsImpl->startPaint();
+        for (EffectWindow *window : windows) {
+            WindowPrePaintData data;
+            data.mask = 0;
+            effectsImpl->prePaintWindow(window, data, std::chrono::milliseconds::zero());
+            effectsImpl->postPaintWindow(window);
+        }
+    }
+
+    // Only the filtering effects take part in the window paint hooks, one in every twenty.
+    const EffectsHandlerImpl::PaintChainStatistics statistics = effectsImpl->paintChainStatistics();
+    QCOMPARE(statistics.activeEffects, effectCount / 10);
+    QCOMPARE(statistics.windowEffects, effectCount / 20);
+    QCOMPARE(statistics.filteringEffects, effectCount / 20);
+}
+
+WAYLANDTEST_MAIN(EffectChainTest)
+#include "effect_chain_test.moc"
@@ -0,0 +1,146 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <kwineffects.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_effect_loading-0");
+
+class EffectLoadingTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testDeferredLoading();
+    void testLoadTime();
+};
+
+void EffectLoadingTest::initTestCase()
+{
+    qputenv("XDG_DATA_DIRS", QCoreApplication::applicationDirPath().toUtf8());
+
+    qRegisterMetaType<KWin::Effect *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024) << QRect(1280, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+    qputenv("KWIN_EFFECTS_FORCE_ANIMATIONS", QByteArrayLiteral("1"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void EffectLoadingTest::cleanup()
+{
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+}
+
+void EffectLoadingTest::testDeferredLoading()
+{
+    // This test verifies that effects with a deferred load priority are only loaded once
+    // deferred loading is allowed, after the effects that are needed for the first frame.
+    const QStringList startupEffects{
+        QStringLiteral("kwin4_effect_fade"),
+        QStringLiteral("slidingpopups"),
+    };
+    const QStringList deferredEffects{
+        QStringLiteral("mousemark"),
+        QStringLiteral("zoom"),
+    };
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), startupEffects.contains(name) || deferredEffects.contains(name));
+    }
+    config->sync();
+
+    EffectLoader loader;
+    loader.setConfig(config);
+    loader.setDeferredLoadingAllowed(false);
+    QSignalSpy effectLoadedSpy(&loader, &AbstractEffectLoader::effectLoaded);
+    QVERIFY(effectLoadedSpy.isValid());
+
+    loader.queryAndLoadAll();
+    QTRY_COMPARE(effectLoadedSpy.count(), startupEffects.count());
+    QTest::qWait(100);
+    QCOMPARE(effectLoadedSpy.count(), startupEffects.count());
+
+    QStringList loadedEffects;
+    for (const QList<QVariant> &arguments : std::as_const(effectLoadedSpy)) {
+        loadedEffects << arguments.at(1).toString();
+    }
+    loadedEffects.sort();
+    QCOMPARE(loadedEffects, startupEffects);
+
+    loader.setDeferredLoadingAllowed(true);
+    QTRY_COMPARE(effectLoadedSpy.count(), startupEffects.count() + deferredEffects.count());
+
+    const QHash<QString, std::chrono::microseconds> loadTimes = loader.loadTimes();
+    std::chrono::microseconds startupTime = std::chrono::microseconds::zero();
+    std::chrono::microseconds deferredTime = std::chrono::microseconds::zero();
+    for (const QString &name : startupEffects) {
+        QVERIFY(loadTimes.contains(name));
+        startupTime += loadTimes.value(name);
+    }
+    for (const QString &name : deferredEffects) {
+        QVERIFY(loadTimes.contains(name));
+        deferredTime += loadTimes.value(name);
+    }
+    QVERIFY(startupTime > std::chrono::microseconds::zero());
+    QVERIFY(deferredTime > std::chrono::microseconds::zero());
+
+    for (const QList<QVariant> &arguments : std::as_const(effectLoadedSpy)) {
+        delete arguments.at(0).value<Effect *>();
+    }
+}
+
+void EffectLoadingTest::testLoadTime()
+{
+    // This test verifies that the load time of an effect is exposed.
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QCOMPARE(effectsImpl->effectLoadTime(QStringLiteral("doesnotexist")), qint64(-1));
+
+    QVERIFY(effectsImpl->loadEffect(QStringLiteral("kwin4_effect_fade")));
+    QVERIFY(effectsImpl->effectLoadTime(QStringLiteral("kwin4_effect_fade")) >= 0);
+    QVERIFY(effectsImpl->supportInformation(QStringLiteral("kwin4_effect_fade")).contains(QLatin1String("Load time:")));
+}
+
+WAYLANDTEST_MAIN(EffectLoadingTest)
+#include "effect_loading_test.moc"
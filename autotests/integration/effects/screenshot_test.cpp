@@ -0,0 +1,295 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "core/renderloop.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "wayland/surface_interface.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+#include <QDBusConnection>
+#include <QDBusPendingReply>
+#include <QDBusUnixFileDescriptor>
+#include <QFileInfo>
+#include <QPainter>
+#include <QScopeGuard>
+#include <QTemporaryFile>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_screenshot-0");
+static const QString s_clientConnectionName = QStringLiteral("screenshot-test-client");
+
+class ScreenShotTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void testCaptureAreaToPipe();
+    void testCaptureAreaToMemoryFile();
+    void testCaptureAreaToRegularFile();
+    void testCaptureWindowToMemoryFile();
+
+private:
+    Window *createWindow();
+    QVariantMap captureArea(const QRect &area, int fileDescriptor);
+    QVariantMap capture(const QString &method, QVariantList arguments, int fileDescriptor);
+    static bool verifyImage(const QImage &image);
+
+    std::unique_ptr<KWayland::Client::Surface> m_surface;
+    std::unique_ptr<Test::XdgToplevel> m_shellSurface;
+};
+
+// The window is red in its top half and blue in its bottom half, which catches flipped and
+// swizzled readbacks.
+static const QRect s_windowGeometry(100, 100, 100, 50);
+
+void ScreenShotTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+    qputenv("KWIN_SCREENSHOT_NO_PERMISSION_CHECKS", QByteArrayLiteral("1"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+
+    // The requests have to go through the bus, the compositor replies asynchronously.
+    QVERIFY(QDBusConnection::connectToBus(QDBusConnection::SessionBus, s_clientConnectionName).isConnected());
+}
+
+void ScreenShotTest::cleanupTestCase()
+{
+    QDBusConnection::disconnectFromBus(s_clientConnectionName);
+}
+
+void ScreenShotTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl->loadEffect(QStringLiteral("screenshot")));
+}
+
+void ScreenShotTest::cleanup()
+{
+    m_shellSurface.reset();
+    m_surface.reset();
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    effectsImpl->unloadAllEffects();
+    QVERIFY(effectsImpl->loadedEffects().isEmpty());
+
+    Test::destroyWaylandConnection();
+}
+
+Window *ScreenShotTest::createWindow()
+{
+    m_surface = Test::createSurface();
+    m_shellSurface.reset(Test::createXdgToplevelSurface(m_surface.get()));
+    Window *window = Test::renderAndWaitForShown(m_surface.get(), s_windowGeometry.size(), Qt::blue);
+    if (!window) {
+        return nullptr;
+    }
+    window->move(s_windowGeometry.topLeft());
+
+    QImage image(s_windowGeometry.size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::blue);
+    QPainter painter(&image);
+    painter.fillRect(0, 0, image.width(), image.height() / 2, Qt::red);
+    painter.end();
+    QSignalSpy damagedSpy(window->surface(), &KWaylandServer::SurfaceInterface::damaged);
+    Test::render(m_surface.get(), image);
+    if (!damagedSpy.wait()) {
+        return nullptr;
+    }
+    return window;
+}
+
+QVariantMap ScreenShotTest::captureArea(const QRect &area, int fileDescriptor)
+{
+    return capture(QStringLiteral("CaptureArea"), {area.x(), area.y(), uint(area.width()), uint(area.height())}, fileDescriptor);
+}
+
+QVariantMap ScreenShotTest::capture(const QString &method, QVariantList arguments, int fileDescriptor)
+{
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.KWin.ScreenShot2"),
+                                                  QStringLiteral("/org/kde/KWin/ScreenShot2"),
+                                                  QStringLiteral("org.kde.KWin.ScreenShot2"),
+                                                  method);
+    arguments << QVariantMap() << QVariant::fromValue(QDBusUnixFileDescriptor(fileDescriptor));
+    message.setArguments(arguments);
+
+    QDBusPendingReply<QVariantMap> reply = QDBusConnection(s_clientConnectionName).asyncCall(message);
+    QDBusPendingCallWatcher watcher(reply);
+    QSignalSpy finishedSpy(&watcher, &QDBusPendingCallWatcher::finished);
+    if (!reply.isFinished() && !finishedSpy.wait()) {
+        return QVariantMap();
+    }
+    if (reply.isError()) {
+        qWarning() << reply.error();
+        return QVariantMap();
+    }
+    return reply.value();
+}
+
+bool ScreenShotTest::verifyImage(const QImage &image)
+{
+    if (image.size() != s_windowGeometry.size()) {
+        return false;
+    }
+    return image.pixelColor(0, 0) == QColor(Qt::red)
+        && image.pixelColor(image.width() - 1, image.height() / 2 - 1) == QColor(Qt::red)
+        && image.pixelColor(0, image.height() / 2) == QColor(Qt::blue)
+        && image.pixelColor(image.width() - 1, image.height() - 1) == QColor(Qt::blue);
+}
+
+static QImage imageFromResults(const QVariantMap &results, const uchar *data)
+{
+    const QImage image(data,
+                       results.value(QStringLiteral("width")).toUInt(),
+                       results.value(QStringLiteral("height")).toUInt(),
+                       results.value(QStringLiteral("stride")).toUInt(),
+                       QImage::Format(results.value(QStringLiteral("format")).toUInt()));
+    return image.copy();
+}
+
+void ScreenShotTest::testCaptureAreaToPipe()
+{
+    // This test verifies that the image read back from the GPU ends up in the pipe in the
+    // right orientation and with the right channel order.
+    QVERIFY(createWindow());
+
+    int pipeFds[2];
+    QVERIFY(pipe2(pipeFds, O_CLOEXEC) == 0);
+    const QVariantMap results = captureArea(s_windowGeometry, pipeFds[1]);
+    close(pipeFds[1]);
+    QVERIFY(!results.isEmpty());
+    QCOMPARE(results.value(QStringLiteral("type")).toString(), QStringLiteral("raw"));
+    QVERIFY(results.contains(QStringLiteral("latency")));
+
+    QFile file;
+    QVERIFY(file.open(pipeFds[0], QIODevice::ReadOnly, QFileDevice::AutoCloseHandle));
+    const QByteArray data = file.readAll();
+    const qint64 size = qint64(results.value(QStringLiteral("stride")).toUInt()) * results.value(QStringLiteral("height")).toUInt();
+    QCOMPARE(qint64(data.size()), size);
+    QVERIFY(verifyImage(imageFromResults(results, reinterpret_cast<const uchar *>(data.constData()))));
+}
+
+void ScreenShotTest::testCaptureAreaToMemoryFile()
+{
+    // This test verifies that a memfd gets the image written at its start, and grown to fit it,
+    // by the time the reply arrives.
+    QVERIFY(createWindow());
+
+    const int fd = memfd_create("screenshot", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    QVERIFY(fd != -1);
+    auto closeFd = qScopeGuard([fd]() {
+        close(fd);
+    });
+    const QVariantMap results = captureArea(s_windowGeometry, fd);
+    QVERIFY(!results.isEmpty());
+
+    const qint64 size = qint64(results.value(QStringLiteral("stride")).toUInt()) * results.value(QStringLiteral("height")).toUInt();
+    struct stat status;
+    QCOMPARE(fstat(fd, &status), 0);
+    QVERIFY(status.st_size >= size);
+
+    void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    QVERIFY(data != MAP_FAILED);
+    const QImage image = imageFromResults(results, static_cast<const uchar *>(data));
+    munmap(data, size);
+    QVERIFY(verifyImage(image));
+}
+
+void ScreenShotTest::testCaptureAreaToRegularFile()
+{
+    // This test verifies that a regular file is written sequentially like a pipe, from its
+    // current offset, rather than being mapped.
+    QVERIFY(createWindow());
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    const QByteArray header = QByteArrayLiteral("header");
+    QCOMPARE(file.write(header), qint64(header.size()));
+    QVERIFY(file.flush());
+
+    const QVariantMap results = captureArea(s_windowGeometry, file.handle());
+    QVERIFY(!results.isEmpty());
+
+    const qint64 size = qint64(results.value(QStringLiteral("stride")).toUInt()) * results.value(QStringLiteral("height")).toUInt();
+    QTRY_COMPARE(QFileInfo(file.fileName()).size(), header.size() + size);
+
+    QFile contents(file.fileName());
+    QVERIFY(contents.open(QIODevice::ReadOnly));
+    QCOMPARE(contents.read(header.size()), header);
+    const QByteArray data = contents.readAll();
+    QVERIFY(verifyImage(imageFromResults(results, reinterpret_cast<const uchar *>(data.constData()))));
+}
+
+void ScreenShotTest::testCaptureWindowToMemoryFile()
+{
+    // This test verifies that a window screenshot, which is read back through a pixel buffer
+    // object, ends up in the memfd in the right orientation and channel order.
+    Window *window = createWindow();
+    QVERIFY(window);
+
+    const int fd = memfd_create("screenshot", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    QVERIFY(fd != -1);
+    auto closeFd = qScopeGuard([fd]() {
+        close(fd);
+    });
+    const QVariantMap results = capture(QStringLiteral("CaptureWindow"), {window->internalId().toString()}, fd);
+    QVERIFY(!results.isEmpty());
+    QCOMPARE(results.value(QStringLiteral("windowId")).toString(), window->internalId().toString());
+
+    const qint64 size = qint64(results.value(QStringLiteral("stride")).toUInt()) * results.value(QStringLiteral("height")).toUInt();
+    void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    QVERIFY(data != MAP_FAILED);
+    const QImage image = imageFromResults(results, static_cast<const uchar *>(data));
+    munmap(data, size);
+    QVERIFY(verifyImage(image));
+}
+
+WAYLANDTEST_MAIN(ScreenShotTest)
+#include "screenshot_test.moc"
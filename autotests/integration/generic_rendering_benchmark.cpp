@@ -0,0 +1,577 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "generic_rendering_benchmark.h"
+
+#include "composite.h"
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "core/renderloop.h"
+#include "cursor.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "internalwindow.h"
+#include "scene/renderprofiler.h"
+#include "wayland/compositor_interface.h"
+#include "wayland/surface_interface.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KConfigGroup>
+#include <KWayland/Client/surface.h>
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QRasterWindow>
+
+#include <algorithm>
+#include <numeric>
+
+#include <linux/input.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_rendering_benchmark-0");
+static const QSize s_outputSize(1280, 1024);
+
+// An internal window that asks for blur and background contrast behind it, as a Plasma panel does.
+class TranslucentPanel : public QRasterWindow
+{
+public:
+    TranslucentPanel()
+    {
+        setFlags(Qt::FramelessWindowHint);
+        // An empty region covers the whole window.
+        setProperty("kwin_blur", QRegion());
+        setProperty("kwin_background_region", QRegion());
+        setProperty("kwin_background_contrast", 0.45);
+        setProperty("kwin_background_intensity", 1.6);
+        setProperty("kwin_background_saturation", 1.7);
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        QPainter painter(this);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(event->rect(), QColor(239, 240, 241, 96));
+    }
+};
+
+static std::chrono::nanoseconds currentTime()
+{
+    return std::chrono::steady_clock::now().time_since_epoch();
+}
+
+static std::chrono::nanoseconds cpuTime(clockid_t clock)
+{
+    timespec time;
+    if (clock_gettime(clock, &time) != 0) {
+        return std::chrono::nanoseconds::zero();
+    }
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+/**
+ * Returns the resident set size of the process in KiB, or 0 if it can't be read.
+ */
+static qint64 residentMemory()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2) {
+        return 0;
+    }
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static double toMilliseconds(std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/**
+ * Summarizes a set of durations, in milliseconds.
+ */
+static QJsonObject summarize(std::vector<std::chrono::nanoseconds> samples)
+{
+    QJsonObject summary{
+        {QStringLiteral("count"), int(samples.size())},
+    };
+    if (samples.empty()) {
+        return summary;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](int percent) {
+        return toMilliseconds(samples[(samples.size() - 1) * percent / 100]);
+    };
+    const std::chrono::nanoseconds total = std::accumulate(samples.cbegin(), samples.cend(), std::chrono::nanoseconds::zero());
+
+    summary[QStringLiteral("average")] = toMilliseconds(total / samples.size());
+    summary[QStringLiteral("p50")] = percentile(50);
+    summary[QStringLiteral("p95")] = percentile(95);
+    summary[QStringLiteral("maximum")] = toMilliseconds(samples.back());
+    return summary;
+}
+
+FrameRecorder::FrameRecorder(RenderLoop *renderLoop)
+    : m_renderLoop(renderLoop)
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    // The scenario may have been aborted by a failed check.
+    if (m_recording) {
+        stop();
+    }
+}
+
+void FrameRecorder::start()
+{
+    connect(m_renderLoop, &RenderLoop::frameRequested, this, &FrameRecorder::handleFrameRequested);
+    connect(m_renderLoop, &RenderLoop::framePresented, this, &FrameRecorder::handleFramePresented);
+    connect(Compositor::self()->renderProfiler(), &RenderProfiler::frameFinished, this, &FrameRecorder::handleFrameFinished);
+
+    connect(waylandServer()->compositor(), &KWaylandServer::CompositorInterface::surfaceCreated, this, &FrameRecorder::watchSurface);
+    const auto windows = workspace()->allClientList();
+    for (Window *window : windows) {
+        if (window->surface()) {
+            watchSurface(window->surface());
+        }
+    }
+
+    Compositor::self()->renderProfiler()->setEnabled(true);
+    m_recording = true;
+    m_startMemory = residentMemory();
+    m_peakMemory = m_startMemory;
+    m_processCpuTime = cpuTime(CLOCK_PROCESS_CPUTIME_ID);
+    m_threadCpuTime = cpuTime(CLOCK_THREAD_CPUTIME_ID);
+    m_startTime = currentTime();
+}
+
+void FrameRecorder::stop()
+{
+    m_processCpuTime = cpuTime(CLOCK_PROCESS_CPUTIME_ID) - m_processCpuTime;
+    m_threadCpuTime = cpuTime(CLOCK_THREAD_CPUTIME_ID) - m_threadCpuTime;
+    m_duration = currentTime() - m_startTime;
+    m_endMemory = residentMemory();
+    m_peakMemory = std::max(m_peakMemory, m_endMemory);
+    Compositor::self()->renderProfiler()->setEnabled(false);
+    m_recording = false;
+
+    disconnect(m_renderLoop, nullptr, this, nullptr);
+    disconnect(Compositor::self()->renderProfiler(), nullptr, this, nullptr);
+    disconnect(waylandServer()->compositor(), nullptr, this, nullptr);
+    for (const QMetaObject::Connection &connection : std::as_const(m_surfaceConnections)) {
+        disconnect(connection);
+    }
+    m_surfaceConnections.clear();
+}
+
+void FrameRecorder::markInput()
+{
+    m_pendingInputs.push_back(currentTime());
+}
+
+std::chrono::nanoseconds FrameRecorder::averageFrameTime() const
+{
+    if (m_frameTimes.empty()) {
+        return std::chrono::nanoseconds::zero();
+    }
+    return std::accumulate(m_frameTimes.cbegin(), m_frameTimes.cend(), std::chrono::nanoseconds::zero()) / m_frameTimes.size();
+}
+
+QJsonObject FrameRecorder::results() const
+{
+    const int frames = std::max(m_presentedFrames, 1);
+    return QJsonObject{
+        {QStringLiteral("frames"), m_presentedFrames},
+        {QStringLiteral("duration"), toMilliseconds(m_duration)},
+        {QStringLiteral("frameTime"), summarize(m_frameTimes)},
+        {QStringLiteral("cpuTimePerFrame"), QJsonObject{
+                                                {QStringLiteral("mainThread"), toMilliseconds(m_threadCpuTime / frames)},
+                                                {QStringLiteral("process"), toMilliseconds(m_processCpuTime / frames)},
+                                            }},
+        // The resident memory of this scenario in KiB, sampled at the start, on every
+        // presented frame and at the end.
+        {QStringLiteral("residentMemory"), QJsonObject{
+                                               {QStringLiteral("start"), m_startMemory},
+                                               {QStringLiteral("peak"), m_peakMemory},
+                                               {QStringLiteral("end"), m_endMemory},
+                                           }},
+        {QStringLiteral("commitLatency"), summarize(m_commitLatencies)},
+        {QStringLiteral("inputLatency"), summarize(m_inputLatencies)},
+    };
+}
+
+void FrameRecorder::watchSurface(KWaylandServer::SurfaceInterface *surface)
+{
+    m_surfaceConnections.push_back(connect(surface, &KWaylandServer::SurfaceInterface::committed, this, [this]() {
+        m_pendingCommits.push_back(currentTime());
+    }));
+}
+
+void FrameRecorder::handleFrameRequested()
+{
+    // Whatever arrived until now is painted in this frame.
+    m_inflightCommits.insert(m_inflightCommits.end(), m_pendingCommits.cbegin(), m_pendingCommits.cend());
+    m_pendingCommits.clear();
+    m_inflightInputs.insert(m_inflightInputs.end(), m_pendingInputs.cbegin(), m_pendingInputs.cend());
+    m_pendingInputs.clear();
+}
+
+void FrameRecorder::handleFramePresented(RenderLoop *renderLoop, std::chrono::nanoseconds timestamp)
+{
+    Q_UNUSED(renderLoop)
+    ++m_presentedFrames;
+    m_peakMemory = std::max(m_peakMemory, residentMemory());
+    for (const std::chrono::nanoseconds &commit : std::as_const(m_inflightCommits)) {
+        m_commitLatencies.push_back(std::max(timestamp - commit, std::chrono::nanoseconds::zero()));
+    }
+    m_inflightCommits.clear();
+    for (const std::chrono::nanoseconds &input : std::as_const(m_inflightInputs)) {
+        m_inputLatencies.push_back(std::max(timestamp - input, std::chrono::nanoseconds::zero()));
+    }
+    m_inflightInputs.clear();
+}
+
+void FrameRecorder::handleFrameFinished(std::chrono::nanoseconds duration)
+{
+    m_frameTimes.push_back(duration);
+}
+
+void writeBenchmarkReport(const QJsonObject &report)
+{
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    const QString fileName = qEnvironmentVariable("KWIN_BENCHMARK_REPORT");
+    if (fileName.isEmpty()) {
+        fprintf(stdout, "%s", json.constData());
+        return;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to write the benchmark report to" << fileName;
+        return;
+    }
+    file.write(json);
+}
+
+}
+
+using namespace KWin;
+
+GenericRenderingBenchmark::GenericRenderingBenchmark(const QByteArray &envVariable)
+    : QObject()
+    , m_envVariable(envVariable)
+{
+}
+
+GenericRenderingBenchmark::~GenericRenderingBenchmark()
+{
+}
+
+void GenericRenderingBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    qRegisterMetaType<KWin::InternalWindow *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(QPoint(0, 0), s_outputSize)));
+
+    // Only the effects a scenario asks for are loaded.
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("XCURSOR_THEME", QByteArrayLiteral("DMZ-White"));
+    qputenv("XCURSOR_SIZE", QByteArrayLiteral("24"));
+    qputenv("KWIN_COMPOSE", m_envVariable);
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+
+    const CompositingType expectedType = m_envVariable == QByteArrayLiteral("Q") ? QPainterCompositing : OpenGLCompositing;
+    if (Compositor::self()->backend()->compositingType() != expectedType) {
+        QSKIP("The requested compositing type is not available");
+    }
+
+    const int frameCount = qEnvironmentVariableIntValue("KWIN_BENCHMARK_FRAMES");
+    if (frameCount > 0) {
+        m_frameCount = frameCount;
+    }
+}
+
+void GenericRenderingBenchmark::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    workspace()->setActiveOutput(QPoint(640, 512));
+    KWin::Cursors::self()->mouse()->setPos(QPoint(640, 512));
+}
+
+void GenericRenderingBenchmark::cleanup()
+{
+    // Stops the recording, and with it the render profiler, if the scenario has been aborted.
+    m_recorder.reset();
+    m_shellSurfaces.clear();
+    m_surfaces.clear();
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    effectsImpl->unloadAllEffects();
+
+    Test::destroyWaylandConnection();
+    QTRY_VERIFY(workspace()->allClientList().isEmpty());
+
+    if (workspace()->outputs().constFirst()->geometry().size() != s_outputSize) {
+        setOutputSize(s_outputSize);
+    }
+}
+
+void GenericRenderingBenchmark::cleanupTestCase()
+{
+    const QJsonObject report{
+        {QStringLiteral("backend"), QStringLiteral("virtual")},
+        {QStringLiteral("compositing"), QString::fromLatin1(m_envVariable)},
+        {QStringLiteral("frameCount"), m_frameCount},
+        {QStringLiteral("scenarios"), m_scenarios},
+    };
+    writeBenchmarkReport(report);
+}
+
+Window *GenericRenderingBenchmark::createWindow(const QSize &size, const QColor &color)
+{
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), size, color);
+    m_surfaces.push_back(std::move(surface));
+    m_shellSurfaces.push_back(std::move(shellSurface));
+    return window;
+}
+
+bool GenericRenderingBenchmark::waitForFrame()
+{
+    RenderLoop *renderLoop = workspace()->outputs().constFirst()->renderLoop();
+    QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+    return framePresentedSpy.wait();
+}
+
+void GenericRenderingBenchmark::setOutputSize(const QSize &size)
+{
+    // Process pending wl_output bind requests before destroying all outputs.
+    QTest::qWait(1);
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(QPoint(0, 0), size)));
+    workspace()->setActiveOutput(QPoint(size.width() / 2, size.height() / 2));
+}
+
+void GenericRenderingBenchmark::startRecording()
+{
+    m_recorder = std::make_unique<FrameRecorder>(workspace()->outputs().constFirst()->renderLoop());
+    m_recorder->start();
+}
+
+void GenericRenderingBenchmark::stopRecording(const QString &scenario)
+{
+    m_recorder->stop();
+
+    QJsonObject results = m_recorder->results();
+    results[QStringLiteral("name")] = scenario;
+    m_scenarios.append(results);
+
+    QTest::setBenchmarkResult(toMilliseconds(m_recorder->averageFrameTime()), QTest::WalltimeMilliseconds);
+    m_recorder.reset();
+}
+
+void GenericRenderingBenchmark::benchmarkStaticWindows_data()
+{
+    QTest::addColumn<int>("windowCount");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("50") << 50;
+    QTest::newRow("200") << 200;
+}
+
+void GenericRenderingBenchmark::benchmarkStaticWindows()
+{
+    // Repaints the whole screen while nothing changes, which is the cost of the scene itself.
+    QFETCH(int, windowCount);
+    for (int i = 0; i < windowCount; ++i) {
+        QVERIFY(createWindow(QSize(200 + i % 7 * 40, 150 + i % 5 * 30), QColor::fromHsv(i * 37 % 360, 200, 220)));
+    }
+
+    startRecording();
+    for (int i = 0; i < m_frameCount; ++i) {
+        effects->addRepaintFull();
+        QVERIFY(waitForFrame());
+    }
+    stopRecording(QStringLiteral("staticWindows/%1").arg(windowCount));
+}
+
+void GenericRenderingBenchmark::benchmarkAnimatingWindow()
+{
+    // One window updates every frame on top of a few static ones.
+    for (int i = 0; i < 10; ++i) {
+        QVERIFY(createWindow(QSize(300, 200), QColor::fromHsv(i * 37, 200, 220)));
+    }
+    QVERIFY(createWindow(QSize(400, 300), Qt::white));
+    KWayland::Client::Surface *surface = m_surfaces.back().get();
+
+    startRecording();
+    for (int i = 0; i < m_frameCount; ++i) {
+        Test::render(surface, QSize(400, 300), QColor::fromHsv(i * 7 % 360, 255, 255));
+        QVERIFY(waitForFrame());
+    }
+    stopRecording(QStringLiteral("animatingWindow"));
+}
+
+void GenericRenderingBenchmark::benchmarkOverview()
+{
+    // Renders the overview effect with a desktop full of windows.
+    for (int i = 0; i < 20; ++i) {
+        QVERIFY(createWindow(QSize(300, 200), QColor::fromHsv(i * 17, 200, 220)));
+    }
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    if (!effectsImpl->loadEffect(QStringLiteral("overview"))) {
+        QSKIP("The overview effect is not available");
+    }
+    Effect *overview = effectsImpl->findEffect(QStringLiteral("overview"));
+    QVERIFY(overview);
+    QVERIFY(QMetaObject::invokeMethod(overview, "activate"));
+    QTRY_VERIFY(overview->isActive());
+
+    startRecording();
+    for (int i = 0; i < m_frameCount; ++i) {
+        effects->addRepaintFull();
+        QVERIFY(waitForFrame());
+    }
+    stopRecording(QStringLiteral("overview"));
+
+    QVERIFY(QMetaObject::invokeMethod(overview, "deactivate"));
+}
+
+void GenericRenderingBenchmark::benchmarkWindowDrag()
+{
+    // Drags a window around with the pointer, which measures the input latency.
+    for (int i = 0; i < 10; ++i) {
+        QVERIFY(createWindow(QSize(300, 200), QColor::fromHsv(i * 37, 200, 220)));
+    }
+    Window *window = createWindow(QSize(400, 300), Qt::white);
+    QVERIFY(window);
+    QCOMPARE(workspace()->activeWindow(), window);
+
+    quint32 timestamp = 1;
+    const QPointF origin = window->frameGeometry().center();
+    Test::pointerMotion(origin, timestamp++);
+    workspace()->slotWindowMove();
+    QCOMPARE(workspace()->moveResizeWindow(), window);
+
+    startRecording();
+    for (int i = 0; i < m_frameCount; ++i) {
+        // Move back and forth so every step changes the geometry.
+        const int step = i % 80 < 40 ? i % 40 : 40 - i % 40;
+        m_recorder->markInput();
+        Test::pointerMotion(origin + QPointF(step * 8 + 1, step * 4 + 1), timestamp++);
+        QVERIFY(waitForFrame());
+    }
+    stopRecording(QStringLiteral("windowDrag"));
+
+    Test::pointerButtonPressed(BTN_LEFT, timestamp++);
+    Test::pointerButtonReleased(BTN_LEFT, timestamp++);
+    QVERIFY(!workspace()->moveResizeWindow());
+}
+
+void GenericRenderingBenchmark::benchmarkFullscreenVideo()
+{
+    // A fullscreen window attaches a new full size buffer every frame, as a video player does.
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get(), Test::CreationSetup::CreateOnly));
+    shellSurface->set_fullscreen(nullptr);
+    QSignalSpy toplevelConfigureRequestedSpy(shellSurface.get(), &Test::XdgToplevel::configureRequested);
+    QSignalSpy surfaceConfigureRequestedSpy(shellSurface->xdgSurface(), &Test::XdgSurface::configureRequested);
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(surfaceConfigureRequestedSpy.wait());
+
+    const QSize size = toplevelConfigureRequestedSpy.last().at(0).toSize();
+    shellSurface->xdgSurface()->ack_configure(surfaceConfigureRequestedSpy.last().at(0).toUInt());
+    Window *window = Test::renderAndWaitForShown(surface.get(), size, Qt::black);
+    QVERIFY(window);
+    QVERIFY(window->isFullScreen());
+
+    startRecording();
+    for (int i = 0; i < m_frameCount; ++i) {
+        Test::render(surface.get(), size, QColor::fromHsv(i * 7 % 360, 255, 255), QImage::Format_RGB32);
+        QVERIFY(waitForFrame());
+    }
+    stopRecording(QStringLiteral("fullscreenVideo"));
+
+    m_surfaces.push_back(std::move(surface));
+    m_shellSurfaces.push_back(std::move(shellSurface));
+}
+
+void GenericRenderingBenchmark::benchmarkBlurBehindPanel_data()
+{
+    QTest::addColumn<QSize>("outputSize");
+
+    QTest::newRow("1080p") << QSize(1920, 1080);
+    QTest::newRow("4K") << QSize(3840, 2160);
+}
+
+void GenericRenderingBenchmark::benchmarkBlurBehindPanel()
+{
+    // A window updates every frame behind a translucent panel, so the blur and the contrast
+    // behind the panel have to be computed again in every frame.
+    QFETCH(QSize, outputSize);
+    setOutputSize(outputSize);
+    QCOMPARE(workspace()->outputs().constFirst()->geometry().size(), outputSize);
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(effectsImpl->loadEffect(QStringLiteral("blur")));
+    QVERIFY(effectsImpl->loadEffect(QStringLiteral("contrast")));
+
+    const QSize windowSize(outputSize.width(), outputSize.height() / 2);
+    Window *window = createWindow(windowSize, Qt::white);
+    QVERIFY(window);
+    window->move(QPoint(0, outputSize.height() - windowSize.height()));
+    KWayland::Client::Surface *surface = m_surfaces.back().get();
+
+    TranslucentPanel panel;
+    const int panelHeight = outputSize.height() / 24;
+    panel.setGeometry(0, outputSize.height() - panelHeight, outputSize.width(), panelHeight);
+    QSignalSpy internalWindowAddedSpy(workspace(), &Workspace::internalWindowAdded);
+    panel.show();
+    QVERIFY(internalWindowAddedSpy.wait());
+    InternalWindow *panelWindow = internalWindowAddedSpy.last().first().value<InternalWindow *>();
+    QVERIFY(panelWindow->effectWindow()->data(WindowBlurBehindRole).isValid());
+    QVERIFY(window->frameGeometry().contains(panelWindow->frameGeometry()));
+
+    startRecording();
+    for (int i = 0; i < m_frameCount; ++i) {
+        Test::render(surface, windowSize, QColor::fromHsv(i * 7 % 360, 255, 255));
+        QVERIFY(waitForFrame());
+    }
+    stopRecording(QStringLiteral("blurBehindPanel/%1x%2").arg(outputSize.width()).arg(outputSize.height()));
+}
@@ -0,0 +1,133 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+#include "kwin_wayland_test.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QObject>
+
+#include <chrono>
+#include <vector>
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+}
+
+namespace KWin
+{
+class RenderLoop;
+
+/**
+ * Collects the measurements of one scenario.
+ *
+ * A surface commit or an input event is considered presented by the first frame that starts
+ * after it, which is how long a user has to wait to see it.
+ */
+class FrameRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FrameRecorder(RenderLoop *renderLoop);
+    ~FrameRecorder() override;
+
+    void start();
+    void stop();
+
+    /**
+     * Notes that an input event is about to be sent.
+     */
+    void markInput();
+
+    std::chrono::nanoseconds averageFrameTime() const;
+    QJsonObject results() const;
+
+private:
+    void watchSurface(KWaylandServer::SurfaceInterface *surface);
+    void handleFrameRequested();
+    void handleFramePresented(RenderLoop *renderLoop, std::chrono::nanoseconds timestamp);
+    void handleFrameFinished(std::chrono::nanoseconds duration);
+
+    RenderLoop *m_renderLoop;
+    bool m_recording = false;
+    int m_presentedFrames = 0;
+    qint64 m_startMemory = 0;
+    qint64 m_peakMemory = 0;
+    qint64 m_endMemory = 0;
+    std::chrono::nanoseconds m_startTime = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds m_duration = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds m_processCpuTime = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds m_threadCpuTime = std::chrono::nanoseconds::zero();
+    std::vector<QMetaObject::Connection> m_surfaceConnections;
+    std::vector<std::chrono::nanoseconds> m_pendingCommits;
+    std::vector<std::chrono::nanoseconds> m_inflightCommits;
+    std::vector<std::chrono::nanoseconds> m_pendingInputs;
+    std::vector<std::chrono::nanoseconds> m_inflightInputs;
+    std::vector<std::chrono::nanoseconds> m_frameTimes;
+    std::vector<std::chrono::nanoseconds> m_commitLatencies;
+    std::vector<std::chrono::nanoseconds> m_inputLatencies;
+};
+
+/**
+ * Writes the @p report as JSON to the file named by the KWIN_BENCHMARK_REPORT environment
+ * variable, or to the standard output if it's not set.
+ */
+void writeBenchmarkReport(const QJsonObject &report);
+}
+
+/**
+ * Renders a set of typical scenes with the virtual backend and synthetic SHM clients, and
+ * reports the frame times, the CPU time, the memory usage, the latency from a surface commit
+ * to the frame that shows it, and the latency from an input event to the frame that shows its
+ * effect.
+ *
+ * The results of every scenario are written as JSON to the file named by the
+ * KWIN_BENCHMARK_REPORT environment variable, or to the standard output if it's not set.
+ * KWIN_BENCHMARK_FRAMES sets how many frames are measured per scenario.
+ */
+class GenericRenderingBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    ~GenericRenderingBenchmark() override;
+
+protected:
+    GenericRenderingBenchmark(const QByteArray &envVariable);
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void cleanupTestCase();
+
+    void benchmarkStaticWindows_data();
+    void benchmarkStaticWindows();
+    void benchmarkAnimatingWindow();
+    void benchmarkOverview();
+    void benchmarkWindowDrag();
+    void benchmarkFullscreenVideo();
+    void benchmarkBlurBehindPanel_data();
+    void benchmarkBlurBehindPanel();
+
+private:
+    KWin::Window *createWindow(const QSize &size, const QColor &color);
+    bool waitForFrame();
+    void setOutputSize(const QSize &size);
+    void startRecording();
+    void stopRecording(const QString &scenario);
+
+    QByteArray m_envVariable;
+    int m_frameCount = 60;
+    std::unique_ptr<KWin::FrameRecorder> m_recorder;
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> m_surfaces;
+    std::vector<std::unique_ptr<Test::XdgToplevel>> m_shellSurfaces;
+    QJsonArray m_scenarios;
+};
@@ -0,0 +1,258 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "core/renderloop.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "scene/latencytracker.h"
+#include "wayland/surface_interface.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+#include <QElapsedTimer>
+
+#include <numeric>
+#include <unistd.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_latency_tracker-0");
+
+class SlowEffect : public Effect
+{
+    Q_OBJECT
+
+public:
+    explicit SlowEffect(std::chrono::milliseconds duration)
+        : m_duration(duration)
+    {
+    }
+
+    bool isActive() const override
+    {
+        return true;
+    }
+    PaintHooks paintHooks() const override
+    {
+        return PaintScreenHook;
+    }
+
+    void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < m_duration.count()) {
+        }
+        effects->paintScreen(mask, region, data);
+    }
+
+private:
+    const std::chrono::milliseconds m_duration;
+};
+
+class LatencyTrackerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testDisabledByDefault();
+    void testCommitToPresent();
+    void testMissingVblanks();
+    void testDisableDiscardsStatistics();
+
+private:
+    bool commitFrame(KWayland::Client::Surface *surface, Window *window, const QColor &color);
+    std::optional<LatencyTracker::ClientStatistics> ownStatistics() const;
+};
+
+void LatencyTrackerTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    qRegisterMetaType<KWin::Effect *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+}
+
+void LatencyTrackerTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void LatencyTrackerTest::cleanup()
+{
+    Compositor::self()->latencyTracker()->setEnabled(false);
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    effectsImpl->unloadAllEffects();
+
+    Test::destroyWaylandConnection();
+}
+
+bool LatencyTrackerTest::commitFrame(KWayland::Client::Surface *surface, Window *window, const QColor &color)
+{
+    // Wait until the commit has been applied, then until the frame that shows it is on screen.
+    QSignalSpy damagedSpy(window->surface(), &KWaylandServer::SurfaceInterface::damaged);
+    Test::render(surface, QSize(100, 50), color);
+    if (!damagedSpy.wait()) {
+        return false;
+    }
+    QSignalSpy framePresentedSpy(workspace()->outputs().constFirst()->renderLoop(), &RenderLoop::framePresented);
+    return framePresentedSpy.wait();
+}
+
+std::optional<LatencyTracker::ClientStatistics> LatencyTrackerTest::ownStatistics() const
+{
+    // The test clients run in the same process as the compositor.
+    const auto statistics = Compositor::self()->latencyTracker()->clientStatistics();
+    for (const LatencyTracker::ClientStatistics &clientStatistics : statistics) {
+        if (clientStatistics.pid == getpid() && !clientStatistics.surfaces.isEmpty()) {
+            return clientStatistics;
+        }
+    }
+    return std::nullopt;
+}
+
+void LatencyTrackerTest::testDisabledByDefault()
+{
+    // This test verifies that nothing is measured unless tracking has been enabled.
+    LatencyTracker *tracker = Compositor::self()->latencyTracker();
+    QVERIFY(!tracker->isEnabled());
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+
+    QVERIFY(commitFrame(surface.get(), window, Qt::red));
+    QVERIFY(tracker->clientStatistics().isEmpty());
+}
+
+void LatencyTrackerTest::testCommitToPresent()
+{
+    // This test verifies that every presented commit is accounted to the client and the surface
+    // that made it, and that the surface is forgotten once it's gone.
+    LatencyTracker *tracker = Compositor::self()->latencyTracker();
+    tracker->setEnabled(true);
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+
+    const int frames = 10;
+    for (int i = 0; i < frames; ++i) {
+        QVERIFY(commitFrame(surface.get(), window, i % 2 ? Qt::red : Qt::green));
+    }
+
+    std::optional<LatencyTracker::ClientStatistics> client = ownStatistics();
+    QVERIFY(client.has_value());
+    QCOMPARE(client->surfaces.count(), 1);
+    const LatencyTracker::SurfaceStatistics &statistics = client->surfaces.constFirst();
+    QCOMPARE(statistics.caption, window->caption());
+    QVERIFY(statistics.latency.frames >= frames);
+    QVERIFY(statistics.latency.average > std::chrono::nanoseconds::zero());
+    QVERIFY(statistics.latency.maximum >= statistics.latency.average);
+    QVERIFY(statistics.paintDelay <= statistics.latency.average);
+    QCOMPARE(statistics.latency.histogram.count(), LatencyTracker::bucketBounds().count() + 1);
+    QCOMPARE(std::accumulate(statistics.latency.histogram.cbegin(), statistics.latency.histogram.cend(), 0), statistics.latency.frames);
+    QCOMPARE(client->latency.frames, statistics.latency.frames);
+
+    shellSurface.reset();
+    surface.reset();
+    QVERIFY(Test::waitForWindowDestroyed(window));
+    QTRY_VERIFY(!ownStatistics().has_value());
+}
+
+void LatencyTrackerTest::testMissingVblanks()
+{
+    // This test verifies that a surface gets flagged if its commits keep taking longer than one
+    // refresh cycle to reach the screen, here because compositing is slow.
+    LatencyTracker *tracker = Compositor::self()->latencyTracker();
+    tracker->setEnabled(true);
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+
+    const std::chrono::nanoseconds vblankInterval(1'000'000'000'000 / workspace()->outputs().constFirst()->refreshRate());
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    const auto children = effects->children();
+    for (QObject *child : children) {
+        if (qstrcmp(child->metaObject()->className(), "KWin::EffectLoader") == 0) {
+            QMetaObject::invokeMethod(child, "effectLoaded", Q_ARG(KWin::Effect *, new SlowEffect(std::chrono::duration_cast<std::chrono::milliseconds>(2 * vblankInterval))), Q_ARG(QString, QStringLiteral("slow")));
+            break;
+        }
+    }
+    QVERIFY(effectsImpl->isEffectLoaded(QStringLiteral("slow")));
+
+    for (int i = 0; i < 12; ++i) {
+        QVERIFY(commitFrame(surface.get(), window, i % 2 ? Qt::red : Qt::green));
+    }
+
+    std::optional<LatencyTracker::ClientStatistics> client = ownStatistics();
+    QVERIFY(client.has_value());
+    const LatencyTracker::SurfaceStatistics &statistics = client->surfaces.constFirst();
+    QVERIFY(statistics.latency.missedVblanks >= 10);
+    QVERIFY(statistics.latency.average > vblankInterval);
+    QVERIFY(statistics.missingVblanks);
+}
+
+void LatencyTrackerTest::testDisableDiscardsStatistics()
+{
+    // This test verifies that the statistics are discarded when tracking gets disabled.
+    LatencyTracker *tracker = Compositor::self()->latencyTracker();
+    tracker->setEnabled(true);
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+    QVERIFY(commitFrame(surface.get(), window, Qt::red));
+    QVERIFY(ownStatistics().has_value());
+
+    QSignalSpy enabledChangedSpy(tracker, &LatencyTracker::enabledChanged);
+    tracker->setEnabled(false);
+    QCOMPARE(enabledChangedSpy.count(), 1);
+    QVERIFY(tracker->clientStatistics().isEmpty());
+
+    QVERIFY(commitFrame(surface.get(), window, Qt::green));
+    QVERIFY(tracker->clientStatistics().isEmpty());
+}
+
+WAYLANDTEST_MAIN(LatencyTrackerTest)
+#include "latency_tracker_test.moc"
@@ -0,0 +1,288 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "core/renderloop.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+#include "scene/renderprofiler.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+#include <QElapsedTimer>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_render_profiler-0");
+
+static void busyWait(std::chrono::milliseconds duration)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < duration.count()) {
+    }
+}
+
+class BusyEffect : public Effect
+{
+    Q_OBJECT
+
+public:
+    BusyEffect(std::chrono::milliseconds duration, int position = 50)
+        : m_duration(duration)
+        , m_position(position)
+    {
+    }
+
+    bool isActive() const override
+    {
+        return true;
+    }
+    PaintHooks paintHooks() const override
+    {
+        return PaintScreenHook;
+    }
+    int requestedEffectChainPosition() const override
+    {
+        return m_position;
+    }
+
+    void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override
+    {
+        busyWait(m_duration);
+        effects->paintScreen(mask, region, data);
+    }
+
+private:
+    const std::chrono::milliseconds m_duration;
+    const int m_position;
+};
+
+class RenderProfilerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testDisabledByDefault();
+    void testWindowStatistics();
+    void testEffectStatistics();
+    void testDisableDiscardsStatistics();
+
+private:
+    void addEffect(const QString &name, Effect *effect);
+    bool renderFrame();
+    std::optional<RenderProfiler::WindowStatistics> windowStatistics(Window *window) const;
+    std::optional<RenderProfiler::EffectStatistics> effectStatistics(const QString &name) const;
+};
+
+void RenderProfilerTest::initTestCase()
+{
+    qputenv("XDG_DATA_DIRS", QCoreApplication::applicationDirPath().toUtf8());
+
+    qRegisterMetaType<KWin::Window *>();
+    qRegisterMetaType<KWin::Effect *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void RenderProfilerTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void RenderProfilerTest::cleanup()
+{
+    Compositor::self()->renderProfiler()->setEnabled(false);
+
+    auto effectsImpl = qobject_cast<EffectsHandlerImpl *>(effects);
+    effectsImpl->unloadAllEffects();
+
+    Test::destroyWaylandConnection();
+}
+
+void RenderProfilerTest::addEffect(const QString &name, Effect *effect)
+{
+    const auto children = effects->children();
+    for (QObject *child : children) {
+        if (qstrcmp(child->metaObject()->className(), "KWin::EffectLoader") == 0) {
+            QMetaObject::invokeMethod(child, "effectLoaded", Q_ARG(KWin::Effect *, effect), Q_ARG(QString, name));
+            break;
+        }
+    }
+}
+
+bool RenderProfilerTest::renderFrame()
+{
+    RenderLoop *renderLoop = workspace()->outputs().constFirst()->renderLoop();
+    QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+    effects->addRepaintFull();
+    return framePresentedSpy.wait();
+}
+
+std::optional<RenderProfiler::WindowStatistics> RenderProfilerTest::windowStatistics(Window *window) const
+{
+    const auto statistics = Compositor::self()->renderProfiler()->windowStatistics();
+    for (const RenderProfiler::WindowStatistics &windowStatistics : statistics) {
+        if (windowStatistics.id == window->internalId()) {
+            return windowStatistics;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<RenderProfiler::EffectStatistics> RenderProfilerTest::effectStatistics(const QString &name) const
+{
+    const auto statistics = Compositor::self()->renderProfiler()->effectStatistics();
+    for (const RenderProfiler::EffectStatistics &effectStatistics : statistics) {
+        if (effectStatistics.name == name) {
+            return effectStatistics;
+        }
+    }
+    return std::nullopt;
+}
+
+void RenderProfilerTest::testDisabledByDefault()
+{
+    // This test verifies that nothing is measured unless profiling has been enabled.
+    RenderProfiler *profiler = Compositor::self()->renderProfiler();
+    QVERIFY(!profiler->isEnabled());
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    QVERIFY(Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue));
+    addEffect(QStringLiteral("busy"), new BusyEffect(std::chrono::milliseconds(1)));
+
+    QVERIFY(renderFrame());
+    QVERIFY(profiler->windowStatistics().isEmpty());
+    QVERIFY(profiler->effectStatistics().isEmpty());
+}
+
+void RenderProfilerTest::testWindowStatistics()
+{
+    // This test verifies that the time spent preparing and rendering a window is accounted to
+    // that window, and that the window is forgotten once it's gone.
+    RenderProfiler *profiler = Compositor::self()->renderProfiler();
+    profiler->setEnabled(true);
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+
+    for (int i = 0; i < 5; ++i) {
+        QVERIFY(renderFrame());
+    }
+    std::optional<RenderProfiler::WindowStatistics> statistics = windowStatistics(window);
+    QVERIFY(statistics.has_value());
+    QCOMPARE(statistics->caption, window->caption());
+    QVERIFY(statistics->prepare.frames >= 5);
+    QVERIFY(statistics->prepare.average > std::chrono::nanoseconds::zero());
+    QVERIFY(statistics->prepare.maximum >= statistics->prepare.average);
+
+    // The GPU times arrive a few frames later, if the driver supports timer queries.
+    if (!GLPlatform::instance()->isGLES() && (hasGLVersion(3, 3) || hasGLExtension(QByteArrayLiteral("GL_ARB_timer_query")))) {
+        for (int i = 0; i < 5 && windowStatistics(window)->render.frames == 0; ++i) {
+            QVERIFY(renderFrame());
+        }
+        QVERIFY(windowStatistics(window)->render.frames > 0);
+    }
+
+    const QUuid id = window->internalId();
+    shellSurface.reset();
+    surface.reset();
+    QVERIFY(Test::waitForWindowDestroyed(window));
+    auto isProfiled = [profiler, id]() {
+        const auto statistics = profiler->windowStatistics();
+        return std::any_of(statistics.cbegin(), statistics.cend(), [id](const RenderProfiler::WindowStatistics &statistics) {
+            return statistics.id == id;
+        });
+    };
+    QTRY_VERIFY(!isProfiled());
+}
+
+void RenderProfilerTest::testEffectStatistics()
+{
+    // This test verifies that an effect is only accounted for the time spent in its own hooks,
+    // not for the time spent in the effects it calls into.
+    RenderProfiler *profiler = Compositor::self()->renderProfiler();
+    profiler->setEnabled(true);
+
+    addEffect(QStringLiteral("outer"), new BusyEffect(std::chrono::milliseconds(2), 10));
+    addEffect(QStringLiteral("inner"), new BusyEffect(std::chrono::milliseconds(10), 20));
+
+    for (int i = 0; i < 3; ++i) {
+        QVERIFY(renderFrame());
+    }
+    const std::optional<RenderProfiler::EffectStatistics> outer = effectStatistics(QStringLiteral("outer"));
+    const std::optional<RenderProfiler::EffectStatistics> inner = effectStatistics(QStringLiteral("inner"));
+    QVERIFY(outer.has_value());
+    QVERIFY(inner.has_value());
+    QVERIFY(outer->time.frames >= 3);
+    QVERIFY(outer->time.average >= std::chrono::milliseconds(2));
+    QVERIFY(inner->time.average >= std::chrono::milliseconds(10));
+    QVERIFY(outer->time.average < std::chrono::milliseconds(10));
+}
+
+void RenderProfilerTest::testDisableDiscardsStatistics()
+{
+    // This test verifies that the statistics are discarded when profiling gets disabled.
+    RenderProfiler *profiler = Compositor::self()->renderProfiler();
+    profiler->setEnabled(true);
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    QVERIFY(Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue));
+    addEffect(QStringLiteral("busy"), new BusyEffect(std::chrono::milliseconds(1)));
+    QVERIFY(renderFrame());
+    QVERIFY(!profiler->windowStatistics().isEmpty());
+    QVERIFY(!profiler->effectStatistics().isEmpty());
+
+    QSignalSpy enabledChangedSpy(profiler, &RenderProfiler::enabledChanged);
+    profiler->setEnabled(false);
+    QCOMPARE(enabledChangedSpy.count(), 1);
+    QVERIFY(profiler->windowStatistics().isEmpty());
+    QVERIFY(profiler->effectStatistics().isEmpty());
+
+    QVERIFY(renderFrame());
+    QVERIFY(profiler->windowStatistics().isEmpty());
+}
+
+WAYLANDTEST_MAIN(RenderProfilerTest)
+#include "render_profiler_test.moc"
@@ -0,0 +1,24 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "generic_rendering_benchmark.h"
+
+class RenderingBenchmarkOpenGL : public GenericRenderingBenchmark
+{
+    Q_OBJECT
+public:
+    RenderingBenchmarkOpenGL()
+        : GenericRenderingBenchmark(QByteArrayLiteral("O2"))
+    {
+        // Use the software rasterizer so the results don't depend on the GPU of the machine.
+        qputenv("LIBGL_ALWAYS_SOFTWARE", QByteArrayLiteral("1"));
+    }
+};
+
+WAYLANDTEST_MAIN(RenderingBenchmarkOpenGL)
+#include "rendering_benchmark_opengl.moc"
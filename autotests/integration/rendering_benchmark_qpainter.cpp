@@ -0,0 +1,22 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "generic_rendering_benchmark.h"
+
+class RenderingBenchmarkQPainter : public GenericRenderingBenchmark
+{
+    Q_OBJECT
+public:
+    RenderingBenchmarkQPainter()
+        : GenericRenderingBenchmark(QByteArrayLiteral("Q"))
+    {
+    }
+};
+
+WAYLANDTEST_MAIN(RenderingBenchmarkQPainter)
+#include "rendering_benchmark_qpainter.moc"
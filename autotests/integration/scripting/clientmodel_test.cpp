@@ -0,0 +1,230 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "scripting/scripting.h"
+#include "scripting/v2/clientmodel.h"
+#include "scripting/v3/clientmodel.h"
+#include "scripting/windowindex.h"
+#include "virtualdesktops.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_scripting_clientmodel-0");
+
+class ScriptingClientModelTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testWindowIndexBuckets();
+    void testModelByScreenAndDesktop();
+    void testDesktopSwitchRefreshesExclusions();
+    void benchmarkDesktopSwitch_data();
+    void benchmarkDesktopSwitch();
+
+private:
+    void createWindows(int count);
+
+    struct TestWindow
+    {
+        std::unique_ptr<KWayland::Client::Surface> surface;
+        std::unique_ptr<Test::XdgToplevel> shellSurface;
+        Window *window = nullptr;
+    };
+    std::vector<TestWindow> m_windows;
+};
+
+void ScriptingClientModelTest::initTestCase()
+{
+    qRegisterMetaType<Window *>();
+
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024) << QRect(1280, 0, 1280, 1024)));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QCOMPARE(workspace()->outputs().count(), 2);
+}
+
+void ScriptingClientModelTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    VirtualDesktopManager::self()->setCount(4);
+    VirtualDesktopManager::self()->setCurrent(1);
+}
+
+void ScriptingClientModelTest::cleanup()
+{
+    for (TestWindow &testWindow : m_windows) {
+        Window *window = testWindow.window;
+        testWindow.shellSurface.reset();
+        QVERIFY(Test::waitForWindowDestroyed(window));
+    }
+    m_windows.clear();
+    Test::destroyWaylandConnection();
+    VirtualDesktopManager::self()->setCount(1);
+}
+
+void ScriptingClientModelTest::createWindows(int count)
+{
+    const QList<Output *> outputs = workspace()->outputs();
+    const uint desktopCount = VirtualDesktopManager::self()->count();
+    for (int i = 0; i < count; ++i) {
+        TestWindow testWindow;
+        testWindow.surface = Test::createSurface();
+        testWindow.shellSurface.reset(Test::createXdgToplevelSurface(testWindow.surface.get()));
+        testWindow.window = Test::renderAndWaitForShown(testWindow.surface.get(), QSize(100, 50), Qt::blue);
+        QVERIFY(testWindow.window);
+
+        // Spread the windows evenly across all desktops and outputs.
+        testWindow.window->setDesktop(1 + i % desktopCount);
+        workspace()->sendWindowToOutput(testWindow.window, outputs[(i / desktopCount) % outputs.count()]);
+        m_windows.push_back(std::move(testWindow));
+    }
+}
+
+void ScriptingClientModelTest::testWindowIndexBuckets()
+{
+    // This test verifies that the window index buckets follow desktop and output changes.
+    ScriptingModels::WindowIndex *index = Scripting::self()->windowIndex();
+    QVERIFY(index);
+
+    createWindows(8);
+    QCOMPARE(index->count(), 8);
+
+    const QList<Output *> outputs = workspace()->outputs();
+    VirtualDesktop *desktop1 = VirtualDesktopManager::self()->desktopForX11Id(1);
+    VirtualDesktop *desktop2 = VirtualDesktopManager::self()->desktopForX11Id(2);
+    QCOMPARE(index->windows(desktop1, nullptr, QString()).count(), 2);
+    QCOMPARE(index->windows(nullptr, outputs[0], QString()).count(), 4);
+    QCOMPARE(index->windows(desktop1, outputs[0], QString()).count(), 1);
+
+    Window *window = m_windows.front().window;
+    window->setDesktop(2);
+    QVERIFY(!index->windows(desktop1, nullptr, QString()).contains(window));
+    QVERIFY(index->windows(desktop2, nullptr, QString()).contains(window));
+
+    window->setOnAllDesktops(true);
+    QVERIFY(index->windows(desktop1, nullptr, QString()).contains(window));
+    QVERIFY(index->windows(desktop2, nullptr, QString()).contains(window));
+
+    workspace()->sendWindowToOutput(window, outputs[1]);
+    QVERIFY(!index->windows(nullptr, outputs[0], QString()).contains(window));
+    QVERIFY(index->windows(nullptr, outputs[1], QString()).contains(window));
+}
+
+void ScriptingClientModelTest::testModelByScreenAndDesktop()
+{
+    // This test verifies that the v2 model built on top of the window index puts every
+    // window into the right screen and desktop branch.
+    createWindows(16);
+
+    ScriptingModels::V2::ClientModelByScreenAndDesktop model;
+    QCOMPARE(model.rowCount(), 2);
+    for (int screen = 0; screen < 2; ++screen) {
+        const QModelIndex screenIndex = model.index(screen, 0);
+        QCOMPARE(model.rowCount(screenIndex), 4);
+        for (int desktop = 0; desktop < 4; ++desktop) {
+            const QModelIndex desktopIndex = model.index(desktop, 0, screenIndex);
+            QCOMPARE(model.rowCount(desktopIndex), 2);
+        }
+    }
+
+    Window *window = m_windows.front().window;
+    const QModelIndex desktop1 = model.index(0, 0, model.index(window->screen(), 0));
+    const QModelIndex desktop2 = model.index(1, 0, model.index(window->screen(), 0));
+    window->setDesktop(2);
+    QCOMPARE(model.rowCount(desktop1), 1);
+    QCOMPARE(model.rowCount(desktop2), 3);
+
+    ScriptingModels::V3::ClientModel flatModel;
+    QCOMPARE(flatModel.rowCount(), 16);
+}
+
+void ScriptingClientModelTest::testDesktopSwitchRefreshesExclusions()
+{
+    // This test verifies that a desktop switch re-evaluates the exclusions that don't depend on
+    // the current desktop, like the models did before they used the window index.
+    createWindows(4);
+
+    ScriptingModels::V2::SimpleClientModel model;
+    model.setExclusions(ScriptingModels::V2::ClientModel::SkipTaskbarExclusion);
+    QCOMPARE(model.rowCount(), 4);
+
+    m_windows.front().window->setSkipTaskbar(true);
+    VirtualDesktopManager *manager = VirtualDesktopManager::self();
+    manager->setCurrent(manager->current() % manager->count() + 1);
+    QCOMPARE(model.rowCount(), 3);
+}
+
+void ScriptingClientModelTest::benchmarkDesktopSwitch_data()
+{
+    QTest::addColumn<int>("windowCount");
+    QTest::addColumn<bool>("excludeOtherDesktops");
+
+    QTest::newRow("100 windows") << 100 << false;
+    QTest::newRow("100 windows, other desktops excluded") << 100 << true;
+    QTest::newRow("400 windows") << 400 << false;
+    QTest::newRow("400 windows, other desktops excluded") << 400 << true;
+}
+
+void ScriptingClientModelTest::benchmarkDesktopSwitch()
+{
+    // This benchmark measures the cost of a virtual desktop switch with several scripting
+    // models alive, like a tiling script and a task switcher would have.
+    QFETCH(int, windowCount);
+    QFETCH(bool, excludeOtherDesktops);
+
+    createWindows(windowCount);
+
+    ScriptingModels::V2::ClientModelByScreenAndDesktop byScreenAndDesktop;
+    ScriptingModels::V2::SimpleClientModel simple;
+    if (excludeOtherDesktops) {
+        byScreenAndDesktop.setExclusions(ScriptingModels::V2::ClientModel::OtherDesktopsExclusion);
+        simple.setExclusions(ScriptingModels::V2::ClientModel::OtherDesktopsExclusion);
+    }
+    ScriptingModels::V3::ClientModel flat;
+    ScriptingModels::V3::ClientFilterModel filter;
+    filter.setClientModel(&flat);
+
+    VirtualDesktopManager *manager = VirtualDesktopManager::self();
+    uint desktop = 1;
+    QBENCHMARK {
+        desktop = desktop % manager->count() + 1;
+        manager->setCurrent(desktop);
+        filter.setDesktop(manager->currentDesktop());
+    }
+
+    if (excludeOtherDesktops) {
+        QCOMPARE(simple.rowCount(), windowCount / int(manager->count()));
+    } else {
+        QCOMPARE(simple.rowCount(), windowCount);
+    }
+    QCOMPARE(filter.rowCount(), windowCount / int(manager->count()));
+}
+
+} // namespace KWin
+
+WAYLANDTEST_MAIN(KWin::ScriptingClientModelTest)
+#include "clientmodel_test.moc"
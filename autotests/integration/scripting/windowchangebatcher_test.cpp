@@ -0,0 +1,360 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/outputbackend.h"
+#include "scripting/scripting.h"
+#include "scripting/windowchangebatcher.h"
+#include "scripting/workspace_wrapper.h"
+#include "virtualdesktops.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+namespace KWin
+{
+
+using ScriptingModels::WindowChangeBatcher;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_scripting_windowchangebatcher-0");
+
+class WindowChangeBatcherTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testInactiveWithoutSubscribers();
+    void testCoalesceMoves();
+    void testMultipleWindows();
+    void testWorkspaceSignal();
+    void testRemovedWindow();
+    void testFlushBeforeComposite();
+    void testFlushOnCompositingToggled();
+    void testCallbacksPerFrame_data();
+    void testCallbacksPerFrame();
+};
+
+void WindowChangeBatcherTest::initTestCase()
+{
+    qRegisterMetaType<Window *>();
+    qRegisterMetaType<QVector<WindowChangeBatcher::WindowChange>>();
+
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024)));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+}
+
+void WindowChangeBatcherTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    Scripting::self()->windowChangeBatcher()->resetStatistics();
+}
+
+void WindowChangeBatcherTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+void WindowChangeBatcherTest::testInactiveWithoutSubscribers()
+{
+    // This test verifies that nothing is tracked as long as nobody subscribed.
+    WindowChangeBatcher *batcher = Scripting::self()->windowChangeBatcher();
+    QVERIFY(!batcher->isActive());
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+
+    window->move(QPointF(10, 10));
+    window->move(QPointF(20, 20));
+    QCOMPARE(int(batcher->statistics().notifications), 0);
+}
+
+void WindowChangeBatcherTest::testCoalesceMoves()
+{
+    // This test verifies that many moves of a window within one frame are delivered as a single
+    // batch with a single entry that remembers the geometry from before the first move.
+    WindowChangeBatcher *batcher = Scripting::self()->windowChangeBatcher();
+    batcher->subscribe();
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+    batcher->flush();
+    batcher->resetStatistics();
+
+    QSignalSpy batchSpy(batcher, &WindowChangeBatcher::batchReady);
+    const QRectF originalGeometry = window->frameGeometry();
+    for (int i = 1; i <= 100; ++i) {
+        window->move(QPointF(i, i));
+    }
+    QVERIFY(batchSpy.wait());
+    QCOMPARE(batchSpy.count(), 1);
+
+    const auto batch = batchSpy.first().first().value<QVector<WindowChangeBatcher::WindowChange>>();
+    QCOMPARE(batch.count(), 1);
+    QCOMPARE(batch.first().window.data(), window);
+    QCOMPARE(batch.first().changes, WindowChangeBatcher::FrameGeometryChange);
+    QCOMPARE(batch.first().previousFrameGeometry, originalGeometry);
+    QCOMPARE(int(batcher->statistics().notifications), 100);
+    QCOMPARE(int(batcher->statistics().batches), 1);
+
+    batcher->unsubscribe();
+    QVERIFY(!batcher->isActive());
+}
+
+void WindowChangeBatcherTest::testMultipleWindows()
+{
+    // This test verifies that changes of different kinds and windows end up in one batch.
+    VirtualDesktopManager::self()->setCount(2);
+    WindowChangeBatcher *batcher = Scripting::self()->windowChangeBatcher();
+    batcher->subscribe();
+
+    std::unique_ptr<KWayland::Client::Surface> surface1(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface1(Test::createXdgToplevelSurface(surface1.get()));
+    Window *window1 = Test::renderAndWaitForShown(surface1.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window1);
+    std::unique_ptr<KWayland::Client::Surface> surface2(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface2(Test::createXdgToplevelSurface(surface2.get()));
+    Window *window2 = Test::renderAndWaitForShown(surface2.get(), QSize(100, 50), Qt::red);
+    QVERIFY(window2);
+    batcher->flush();
+
+    QSignalSpy batchSpy(batcher, &WindowChangeBatcher::batchReady);
+    window1->move(QPointF(50, 50));
+    window2->setDesktop(2);
+    window1->move(QPointF(60, 60));
+    window1->setMinimized(true);
+    QVERIFY(batchSpy.wait());
+    QCOMPARE(batchSpy.count(), 1);
+
+    const auto batch = batchSpy.first().first().value<QVector<WindowChangeBatcher::WindowChange>>();
+    QCOMPARE(batch.count(), 2);
+    QCOMPARE(batch[0].window.data(), window1);
+    QCOMPARE(batch[0].changes, WindowChangeBatcher::FrameGeometryChange | WindowChangeBatcher::MinimizedChange);
+    QCOMPARE(batch[1].window.data(), window2);
+    QCOMPARE(batch[1].changes, WindowChangeBatcher::DesktopChange);
+
+    batcher->unsubscribe();
+    VirtualDesktopManager::self()->setCount(1);
+}
+
+void WindowChangeBatcherTest::testWorkspaceSignal()
+{
+    // This test verifies that connecting to the batched workspace signal opts in to the tracking.
+    WindowChangeBatcher *batcher = Scripting::self()->windowChangeBatcher();
+    QtScriptWorkspaceWrapper *wrapper = Scripting::self()->workspaceWrapper();
+    QVERIFY(!batcher->isActive());
+
+    std::unique_ptr<QSignalSpy> changesSpy = std::make_unique<QSignalSpy>(wrapper, &WorkspaceWrapper::windowChangesBatched);
+    QVERIFY(batcher->isActive());
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+    batcher->flush();
+    changesSpy->clear();
+
+    window->move(QPointF(30, 30));
+    window->move(QPointF(40, 40));
+    QVERIFY(changesSpy->wait());
+    QCOMPARE(changesSpy->count(), 1);
+    const QVariantList changes = changesSpy->first().first().toList();
+    QCOMPARE(changes.count(), 1);
+    const QVariantMap change = changes.first().toMap();
+    QCOMPARE(change.value(QStringLiteral("window")).value<Window *>(), window);
+    QCOMPARE(change.value(QStringLiteral("changes")).toInt(), int(WorkspaceWrapper::FrameGeometryChange));
+}
+
+void WindowChangeBatcherTest::testRemovedWindow()
+{
+    // This test verifies that a window is left out of the batches delivered once it has been
+    // removed, even though the window object is still alive while the removal is announced.
+    WindowChangeBatcher *batcher = Scripting::self()->windowChangeBatcher();
+    batcher->subscribe();
+
+    std::unique_ptr<KWayland::Client::Surface> surface1(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface1(Test::createXdgToplevelSurface(surface1.get()));
+    Window *window1 = Test::renderAndWaitForShown(surface1.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window1);
+    std::unique_ptr<KWayland::Client::Surface> surface2(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface2(Test::createXdgToplevelSurface(surface2.get()));
+    Window *window2 = Test::renderAndWaitForShown(surface2.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window2);
+    batcher->flush();
+
+    // Deliver the pending changes while the removal is being announced.
+    bool removed = false;
+    QVector<WindowChangeBatcher::WindowChange> delivered;
+    connect(workspace(), &Workspace::windowRemoved, this, [batcher, window1, &removed](Window *window) {
+        if (window == window1) {
+            removed = true;
+            batcher->flush();
+        }
+    });
+    connect(batcher, &WindowChangeBatcher::batchReady, this, [&removed, &delivered](const QVector<WindowChangeBatcher::WindowChange> &batch) {
+        if (removed) {
+            delivered += batch;
+        }
+    });
+
+    QSignalSpy windowRemovedSpy(workspace(), &Workspace::windowRemoved);
+    window1->move(QPointF(10, 10));
+    window2->move(QPointF(20, 20));
+    shellSurface1.reset();
+    surface1.reset();
+    QVERIFY(windowRemovedSpy.wait());
+    window2->move(QPointF(30, 30));
+    batcher->flush();
+
+    QVERIFY(!delivered.isEmpty());
+    for (const WindowChangeBatcher::WindowChange &change : std::as_const(delivered)) {
+        QCOMPARE(change.window.data(), window2);
+    }
+
+    disconnect(workspace(), &Workspace::windowRemoved, this, nullptr);
+    disconnect(batcher, &WindowChangeBatcher::batchReady, this, nullptr);
+    batcher->unsubscribe();
+}
+
+void WindowChangeBatcherTest::testFlushBeforeComposite()
+{
+    // This test verifies that the changes are delivered before the frame they belong to is
+    // painted, not with the next one.
+    WindowChangeBatcher *batcher = Scripting::self()->windowChangeBatcher();
+    batcher->subscribe();
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+    batcher->flush();
+
+    QSignalSpy batchSpy(batcher, &WindowChangeBatcher::batchReady);
+    QSignalSpy aboutToCompositeSpy(Compositor::self(), &Compositor::aboutToComposite);
+    int batchesBeforeComposite = -1;
+    connect(Compositor::self(), &Compositor::aboutToComposite, this, [&batchSpy, &batchesBeforeComposite]() {
+        if (batchesBeforeComposite == -1) {
+            batchesBeforeComposite = batchSpy.count();
+        }
+    });
+
+    window->move(QPointF(10, 10));
+    QVERIFY(aboutToCompositeSpy.wait());
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(batchesBeforeComposite, 1);
+
+    disconnect(Compositor::self(), &Compositor::aboutToComposite, this, nullptr);
+    batcher->unsubscribe();
+}
+
+void WindowChangeBatcherTest::testFlushOnCompositingToggled()
+{
+    // This test verifies that the pending changes are delivered when compositing is toggled,
+    // without waiting for a frame or the fallback timeout.
+    WindowChangeBatcher *batcher = Scripting::self()->windowChangeBatcher();
+    batcher->subscribe();
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+    batcher->flush();
+
+    QSignalSpy batchSpy(batcher, &WindowChangeBatcher::batchReady);
+    window->move(QPointF(10, 10));
+    QCOMPARE(batchSpy.count(), 0);
+
+    Q_EMIT Compositor::self()->compositingToggled(true);
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(batchSpy.last().at(0).value<QVector<WindowChangeBatcher::WindowChange>>().count(), 1);
+
+    batcher->unsubscribe();
+}
+
+void WindowChangeBatcherTest::testCallbacksPerFrame_data()
+{
+    QTest::addColumn<int>("windowCount");
+    QTest::addColumn<int>("stepsPerFrame");
+
+    QTest::newRow("1 window, 8 steps") << 1 << 8;
+    QTest::newRow("4 windows, 8 steps") << 4 << 8;
+    QTest::newRow("4 windows, 32 steps") << 4 << 32;
+}
+
+void WindowChangeBatcherTest::testCallbacksPerFrame()
+{
+    // This test measures how many callbacks a consumer of the batches gets compared to a
+    // consumer connected to the frameGeometryChanged signal of every window.
+    QFETCH(int, windowCount);
+    QFETCH(int, stepsPerFrame);
+
+    WindowChangeBatcher *batcher = Scripting::self()->windowChangeBatcher();
+    batcher->subscribe();
+
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> surfaces;
+    std::vector<std::unique_ptr<Test::XdgToplevel>> shellSurfaces;
+    QList<Window *> windows;
+    for (int i = 0; i < windowCount; ++i) {
+        surfaces.push_back(Test::createSurface());
+        shellSurfaces.emplace_back(Test::createXdgToplevelSurface(surfaces.back().get()));
+        Window *window = Test::renderAndWaitForShown(surfaces.back().get(), QSize(100, 50), Qt::blue);
+        QVERIFY(window);
+        windows.append(window);
+    }
+    batcher->flush();
+    batcher->resetStatistics();
+
+    int directCallbacks = 0;
+    for (Window *window : std::as_const(windows)) {
+        connect(window, &Window::frameGeometryChanged, this, [&directCallbacks]() {
+            ++directCallbacks;
+        });
+    }
+
+    const int frames = 10;
+    QSignalSpy batchSpy(batcher, &WindowChangeBatcher::batchReady);
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int step = 0; step < stepsPerFrame; ++step) {
+            for (Window *window : std::as_const(windows)) {
+                window->move(window->pos() + QPointF(1, 0));
+            }
+        }
+        QVERIFY(batchSpy.wait());
+    }
+
+    const WindowChangeBatcher::Statistics statistics = batcher->statistics();
+    QCOMPARE(int(statistics.batches), frames);
+    QCOMPARE(int(statistics.entries), frames * windowCount);
+    QCOMPARE(directCallbacks, frames * windowCount * stepsPerFrame);
+
+    for (Window *window : std::as_const(windows)) {
+        disconnect(window, &Window::frameGeometryChanged, this, nullptr);
+    }
+    batcher->unsubscribe();
+}
+
+} // namespace KWin
+
+WAYLANDTEST_MAIN(KWin::WindowChangeBatcherTest)
+#include "windowchangebatcher_test.moc"
@@ -0,0 +1,257 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwin_wayland_test.h"
+
+#include "composite.h"
+#include "core/outputbackend.h"
+#include "core/renderbackend.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "libkwineffects/kwinglshadercache_p.h"
+#include "libkwineffects/kwinglutils.h"
+#include "wayland_server.h"
+
+#include <KConfigGroup>
+
+#include <QDateTime>
+#include <QDir>
+
+#include <limits>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_shader_cache-0");
+
+class ShaderCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testColdWarm();
+    void testCorruptedFiles();
+    void testKeepOtherDrivers();
+    void testPrune();
+    void benchmarkGenerateShaders_data();
+    void benchmarkGenerateShaders();
+
+private:
+    void generateShaders();
+};
+
+static QVector<ShaderTraits> allTraits()
+{
+    QVector<ShaderTraits> traits;
+    for (const ShaderTraits base : {ShaderTraits(), ShaderTraits(ShaderTrait::MapTexture), ShaderTraits(ShaderTrait::UniformColor)}) {
+        traits << base
+               << (base | ShaderTrait::Modulate)
+               << (base | ShaderTrait::AdjustSaturation)
+               << (base | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
+    }
+    return traits;
+}
+
+void ShaderCacheTest::initTestCase()
+{
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+
+    QCOMPARE(Compositor::self()->backend()->compositingType(), KWin::OpenGLCompositing);
+}
+
+void ShaderCacheTest::init()
+{
+    QVERIFY(effects->makeOpenGLContextCurrent());
+    GLShaderCache *cache = ShaderManager::instance()->cache();
+    if (!cache->isEnabled()) {
+        QSKIP("The OpenGL driver doesn't support program binaries");
+    }
+    cache->clear();
+}
+
+void ShaderCacheTest::generateShaders()
+{
+    const QVector<ShaderTraits> traits = allTraits();
+    for (const ShaderTraits &shaderTraits : traits) {
+        std::unique_ptr<GLShader> shader = ShaderManager::instance()->generateCustomShader(shaderTraits);
+        QVERIFY(shader);
+        QVERIFY(shader->isValid());
+    }
+}
+
+void ShaderCacheTest::testColdWarm()
+{
+    // This test verifies that linked programs are written to the cache and loaded from it the
+    // next time the same shader is requested.
+    GLShaderCache *cache = ShaderManager::instance()->cache();
+    const int shaderCount = allTraits().count();
+
+    const GLShaderCache::Statistics before = cache->statistics();
+    generateShaders();
+    const GLShaderCache::Statistics cold = cache->statistics();
+    QCOMPARE(cold.hits, before.hits);
+    QCOMPARE(cold.misses, before.misses + shaderCount);
+    QCOMPARE(cold.stores, before.stores + shaderCount);
+    QCOMPARE(QDir(cache->directory()).entryList(QDir::Files).count(), shaderCount);
+
+    generateShaders();
+    const GLShaderCache::Statistics warm = cache->statistics();
+    QCOMPARE(warm.hits, cold.hits + shaderCount);
+    QCOMPARE(warm.misses, cold.misses);
+    QCOMPARE(warm.stores, cold.stores);
+    QCOMPARE(warm.rejected, cold.rejected);
+}
+
+void ShaderCacheTest::testCorruptedFiles()
+{
+    // This test verifies that broken cache files don't break the shaders, but are replaced.
+    GLShaderCache *cache = ShaderManager::instance()->cache();
+    const int shaderCount = allTraits().count();
+    generateShaders();
+
+    QDir directory(cache->directory());
+    const QStringList entries = directory.entryList(QDir::Files);
+    QCOMPARE(entries.count(), shaderCount);
+    for (int i = 0; i < entries.count(); ++i) {
+        QFile file(directory.filePath(entries[i]));
+        if (i % 2) {
+            // Truncated file.
+            QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+            file.write("KW");
+        } else {
+            // Valid header, garbage binary.
+            QVERIFY(file.open(QIODevice::ReadWrite));
+            QDataStream stream(&file);
+            quint32 magic, version, format;
+            QByteArray binary;
+            stream >> magic >> version >> format >> binary;
+            binary.fill('x');
+            file.seek(0);
+            stream << magic << version << format << binary;
+        }
+    }
+
+    const GLShaderCache::Statistics before = cache->statistics();
+    generateShaders();
+    const GLShaderCache::Statistics after = cache->statistics();
+    QCOMPARE(after.hits, before.hits);
+    QCOMPARE((after.misses - before.misses) + (after.rejected - before.rejected), shaderCount);
+    QCOMPARE(after.stores, before.stores + shaderCount);
+
+    // The broken files have been replaced.
+    generateShaders();
+    QCOMPARE(cache->statistics().hits, after.hits + shaderCount);
+}
+
+void ShaderCacheTest::testKeepOtherDrivers()
+{
+    // This test verifies that the programs of other drivers survive the creation of a cache and
+    // are only removed once they haven't been used for a long time.
+    GLShaderCache *cache = ShaderManager::instance()->cache();
+    const int shaderCount = allTraits().count();
+    generateShaders();
+
+    QDir root(cache->directory());
+    QVERIFY(root.cdUp());
+    QVERIFY(root.mkpath(QStringLiteral("other")));
+    QFile otherFile(root.filePath(QStringLiteral("other/program")));
+    QVERIFY(otherFile.open(QIODevice::WriteOnly));
+    otherFile.write("program");
+    otherFile.close();
+
+    GLShaderCache otherCache(root.absolutePath());
+    QVERIFY(otherCache.isEnabled());
+    QCOMPARE(otherCache.directory(), cache->directory());
+    QVERIFY(root.exists(QStringLiteral("other/program")));
+    QCOMPARE(QDir(cache->directory()).entryList(QDir::Files).count(), shaderCount);
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    otherCache.prune(std::numeric_limits<qint64>::max(), now.addDays(-30));
+    QVERIFY(root.exists(QStringLiteral("other/program")));
+
+    QVERIFY(otherFile.open(QIODevice::ReadOnly));
+    QVERIFY(otherFile.setFileTime(now.addDays(-31), QFileDevice::FileModificationTime));
+    otherFile.close();
+    otherCache.prune(std::numeric_limits<qint64>::max(), now.addDays(-30));
+    QVERIFY(!root.exists(QStringLiteral("other")));
+    QCOMPARE(QDir(cache->directory()).entryList(QDir::Files).count(), shaderCount);
+}
+
+void ShaderCacheTest::testPrune()
+{
+    // This test verifies that pruning removes the least recently used programs first.
+    GLShaderCache *cache = ShaderManager::instance()->cache();
+    generateShaders();
+
+    QDir directory(cache->directory());
+    const QFileInfoList entries = directory.entryInfoList(QDir::Files, QDir::Time);
+    QVERIFY(entries.count() > 1);
+    const QFileInfo oldest = entries.constLast();
+    QFile file(oldest.absoluteFilePath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTimeUtc().addDays(-1), QFileDevice::FileModificationTime));
+    file.close();
+
+    qint64 size = 0;
+    for (const QFileInfo &entry : entries) {
+        size += entry.size();
+    }
+    cache->prune(size - 1);
+    QCOMPARE(directory.entryList(QDir::Files).count(), entries.count() - 1);
+    QVERIFY(!directory.exists(oldest.fileName()));
+
+    cache->prune(0);
+    QVERIFY(directory.entryList(QDir::Files).isEmpty());
+}
+
+void ShaderCacheTest::benchmarkGenerateShaders_data()
+{
+    QTest::addColumn<bool>("warm");
+
+    QTest::newRow("cold") << false;
+    QTest::newRow("warm") << true;
+}
+
+void ShaderCacheTest::benchmarkGenerateShaders()
+{
+    // This benchmark compiles all shader trait combinations, either with an empty cache or with
+    // all programs already cached.
+    QFETCH(bool, warm);
+    GLShaderCache *cache = ShaderManager::instance()->cache();
+    generateShaders();
+
+    QBENCHMARK {
+        if (!warm) {
+            cache->clear();
+        }
+        generateShaders();
+        glFinish();
+    }
+}
+
+WAYLANDTEST_MAIN(ShaderCacheTest)
+#include "shader_cache_test.moc"
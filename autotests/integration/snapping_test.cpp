@@ -0,0 +1,206 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+
+#include "core/outputbackend.h"
+#include "options.h"
+#include "virtualdesktops.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+
+#include <QRandomGenerator>
+
+#include <algorithm>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_snapping-0");
+
+class SnappingTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testSnapToWindow();
+    void testIndexFollowsWindow();
+    void testSnapResize();
+    void benchmarkDrag_data();
+    void benchmarkDrag();
+
+private:
+    Window *createWindow(const QSize &size, const QPointF &position);
+
+    std::vector<std::unique_ptr<KWayland::Client::Surface>> m_surfaces;
+    std::vector<std::unique_ptr<Test::XdgToplevel>> m_shellSurfaces;
+};
+
+void SnappingTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024)));
+
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+}
+
+void SnappingTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+
+    // Only snap to windows, so the screen borders don't get in the way.
+    options->setWindowSnapZone(10);
+    options->setBorderSnapZone(0);
+    options->setCenterSnapZone(0);
+    options->setSnapOnlyWhenOverlapping(false);
+}
+
+void SnappingTest::cleanup()
+{
+    m_shellSurfaces.clear();
+    m_surfaces.clear();
+    Test::destroyWaylandConnection();
+    VirtualDesktopManager::self()->setCount(1);
+}
+
+Window *SnappingTest::createWindow(const QSize &size, const QPointF &position)
+{
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), size, Qt::blue);
+    if (!window) {
+        return nullptr;
+    }
+    window->move(position);
+    m_surfaces.push_back(std::move(surface));
+    m_shellSurfaces.push_back(std::move(shellSurface));
+    return window;
+}
+
+void SnappingTest::testSnapToWindow()
+{
+    // This test verifies that a moved window snaps to the nearest edges of other windows.
+    Window *target = createWindow(QSize(100, 50), QPointF(500, 500));
+    QVERIFY(target);
+    Window *window = createWindow(QSize(100, 50), QPointF(0, 0));
+    QVERIFY(window);
+
+    // Next to the right edge of the target, the top edges are aligned as well.
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(605, 505), false), QPointF(600, 500));
+    // Below the target.
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(530, 556), false), QPointF(530, 550));
+    // Too far away.
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(615, 505), false), QPointF(615, 505));
+    // Close to an edge, but not next to the target.
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(605, 700), false), QPointF(605, 700));
+}
+
+void SnappingTest::testIndexFollowsWindow()
+{
+    // This test verifies that windows are snapped to where they are now, and only while they are
+    // visible on the current desktop.
+    Window *target = createWindow(QSize(100, 50), QPointF(500, 500));
+    QVERIFY(target);
+    Window *window = createWindow(QSize(100, 50), QPointF(0, 0));
+    QVERIFY(window);
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(605, 505), false), QPointF(600, 500));
+
+    target->move(QPointF(300, 300));
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(605, 505), false), QPointF(605, 505));
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(405, 305), false), QPointF(400, 300));
+
+    target->setMinimized(true);
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(405, 305), false), QPointF(405, 305));
+    target->setMinimized(false);
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(405, 305), false), QPointF(400, 300));
+
+    VirtualDesktopManager::self()->setCount(2);
+    target->enterDesktop(VirtualDesktopManager::self()->desktopForX11Id(2));
+    target->leaveDesktop(VirtualDesktopManager::self()->desktopForX11Id(1));
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(405, 305), false), QPointF(405, 305));
+
+    target->setOnAllDesktops(true);
+    QCOMPARE(workspace()->adjustWindowPosition(window, QPointF(405, 305), false), QPointF(400, 300));
+}
+
+void SnappingTest::testSnapResize()
+{
+    // This test verifies that a resized window snaps to the edges of other windows, including
+    // windows that are only close to the edge after it has been snapped to another window.
+    Window *first = createWindow(QSize(100, 50), QPointF(500, 500));
+    QVERIFY(first);
+    Window *second = createWindow(QSize(100, 80), QPointF(505, 540));
+    QVERIFY(second);
+    Window *window = createWindow(QSize(100, 50), QPointF(300, 520));
+    QVERIFY(window);
+
+    // The right edge snaps to the first window, and from there to the second one.
+    QCOMPARE(workspace()->adjustWindowSize(window, QRectF(QPointF(300, 520), QPointF(493, 570)), Gravity::Right),
+             QRectF(QPointF(300, 520), QPointF(505, 570)));
+    // Too far away from both windows.
+    QCOMPARE(workspace()->adjustWindowSize(window, QRectF(QPointF(300, 520), QPointF(480, 570)), Gravity::Right),
+             QRectF(QPointF(300, 520), QPointF(480, 570)));
+    // Only the first window is within the height of the window.
+    QCOMPARE(workspace()->adjustWindowSize(window, QRectF(QPointF(300, 500), QPointF(493, 530)), Gravity::Right),
+             QRectF(QPointF(300, 500), QPointF(500, 530)));
+}
+
+void SnappingTest::benchmarkDrag_data()
+{
+    QTest::addColumn<int>("windowCount");
+
+    QTest::newRow("50") << 50;
+    QTest::newRow("200") << 200;
+    QTest::newRow("500") << 500;
+}
+
+void SnappingTest::benchmarkDrag()
+{
+    // Drags a window across a desktop crowded with windows, one snap query per motion event.
+    QFETCH(int, windowCount);
+
+    QRandomGenerator random(windowCount);
+    for (int i = 0; i < windowCount; ++i) {
+        const QSize size(100 + random.bounded(400), 100 + random.bounded(300));
+        const QPointF position(random.bounded(1280 - size.width()), random.bounded(1024 - size.height()));
+        QVERIFY(createWindow(size, position));
+    }
+    Window *window = createWindow(QSize(300, 200), QPointF(0, 0));
+    QVERIFY(window);
+
+    QVector<QPointF> path;
+    for (int i = 0; i < 1000; ++i) {
+        path.append(QPointF(i * 0.95, 400 + 300 * std::sin(i / 100.0)));
+    }
+
+    // The drag has to snap now and then, otherwise only the lookup would be measured.
+    const bool snaps = std::any_of(path.cbegin(), path.cend(), [window](const QPointF &position) {
+        return workspace()->adjustWindowPosition(window, position, false) != position;
+    });
+    QVERIFY(snaps);
+
+    QBENCHMARK {
+        for (const QPointF &position : std::as_const(path)) {
+            workspace()->adjustWindowPosition(window, position, false);
+        }
+    }
+}
+
+WAYLANDTEST_MAIN(SnappingTest)
+#include "snapping_test.moc"
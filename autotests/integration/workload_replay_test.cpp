@@ -0,0 +1,588 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "generic_rendering_benchmark.h"
+
+#include "composite.h"
+#include "core/output.h"
+#include "core/outputbackend.h"
+#include "core/renderloop.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "utils/workloadtrace.h"
+#include "wayland/surface_interface.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workloadrecorder.h"
+#include "workspace.h"
+
+#include <KWayland/Client/buffer.h>
+#include <KWayland/Client/shm_pool.h>
+#include <KWayland/Client/surface.h>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPointer>
+#include <QSet>
+#include <QTemporaryDir>
+
+#include <linux/input.h>
+
+namespace KWin
+{
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_workload_replay-0");
+
+static QVector<WorkloadEvent> readTrace(const QString &fileName)
+{
+    QVector<WorkloadEvent> events;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return events;
+    }
+    WorkloadTraceReader reader(&file);
+    while (const std::optional<WorkloadEvent> event = reader.read()) {
+        events.append(*event);
+    }
+    return events;
+}
+
+/**
+ * Replays a recorded workload with synthetic clients, one recorded frame at a time, so the
+ * compositor gets the same work to do in every frame no matter how fast it is.
+ *
+ * The windows are replayed as toplevels that commit buffers of the recorded sizes with the
+ * recorded damage, and are moved and restacked as recorded. The pointer events are injected,
+ * the key events are not as which keys were pressed is not recorded.
+ */
+class WorkloadPlayer
+{
+public:
+    bool replay(const QVector<WorkloadEvent> &events);
+
+    int frameCount() const
+    {
+        return m_frameCount;
+    }
+    int skippedCommits() const
+    {
+        return m_skippedCommits;
+    }
+    Window *window(quint32 surface) const
+    {
+        auto it = m_clients.find(surface);
+        return it != m_clients.end() ? it->second.window.data() : nullptr;
+    }
+
+private:
+    struct Client
+    {
+        std::unique_ptr<KWayland::Client::Surface> surface;
+        std::unique_ptr<Test::XdgToplevel> shellSurface;
+        QPointer<Window> window;
+        QRect geometry;
+        int color = 0;
+    };
+
+    bool commit(const WorkloadEvent &event);
+    bool destroy(quint32 surface);
+    void restack(const QVector<quint32> &stacking);
+    void setEffectActive(const QString &name, bool active);
+    bool waitForCommits();
+    bool renderFrame();
+
+    QObject m_context;
+    std::map<quint32, Client> m_clients;
+    QSet<quint32> m_windowSurfaces;
+    int m_frameCount = 0;
+    int m_skippedCommits = 0;
+    int m_pendingCommits = 0;
+    quint32 m_timestamp = 0;
+};
+
+bool WorkloadPlayer::replay(const QVector<WorkloadEvent> &events)
+{
+    // Only the surfaces of windows are replayed, the cursor and sub-surfaces are not.
+    for (const WorkloadEvent &event : events) {
+        if (event.type == WorkloadEvent::Type::WindowAdded) {
+            m_windowSurfaces.insert(event.surface);
+        }
+    }
+
+    for (const WorkloadEvent &event : events) {
+        switch (event.type) {
+        case WorkloadEvent::Type::Output:
+            break;
+        case WorkloadEvent::Type::Frame:
+            if (!waitForCommits() || !renderFrame()) {
+                return false;
+            }
+            break;
+        case WorkloadEvent::Type::SurfaceCommit:
+            if (!commit(event)) {
+                return false;
+            }
+            break;
+        case WorkloadEvent::Type::SurfaceDestroyed:
+        case WorkloadEvent::Type::WindowRemoved:
+            if (!destroy(event.surface)) {
+                return false;
+            }
+            break;
+        case WorkloadEvent::Type::WindowAdded:
+        case WorkloadEvent::Type::WindowGeometry: {
+            Client &client = m_clients[event.surface];
+            client.geometry = event.rect;
+            if (client.window) {
+                client.window->move(event.rect.topLeft());
+            }
+            break;
+        }
+        case WorkloadEvent::Type::StackingOrder:
+            restack(event.stacking);
+            break;
+        case WorkloadEvent::Type::PointerMotion:
+            Test::pointerMotion(event.position, ++m_timestamp);
+            break;
+        case WorkloadEvent::Type::PointerButton:
+            if (event.pressed) {
+                Test::pointerButtonPressed(event.button, ++m_timestamp);
+            } else {
+                Test::pointerButtonReleased(event.button, ++m_timestamp);
+            }
+            break;
+        case WorkloadEvent::Type::PointerAxis:
+            if (event.button == 1) {
+                Test::pointerAxisHorizontal(event.position.x(), ++m_timestamp);
+            } else {
+                Test::pointerAxisVertical(event.position.x(), ++m_timestamp);
+            }
+            break;
+        case WorkloadEvent::Type::Key:
+            break;
+        case WorkloadEvent::Type::Effect:
+            setEffectActive(event.name, event.pressed);
+            break;
+        }
+    }
+    return waitForCommits();
+}
+
+bool WorkloadPlayer::commit(const WorkloadEvent &event)
+{
+    if (!m_windowSurfaces.contains(event.surface)) {
+        ++m_skippedCommits;
+        return true;
+    }
+
+    Client &client = m_clients[event.surface];
+    const QSize bufferSize = event.rect.size();
+    if (!client.window) {
+        // The first commit with a buffer maps the window, the commits before it only set it up.
+        if (bufferSize.isEmpty()) {
+            return true;
+        }
+        client.surface = Test::createSurface();
+        client.shellSurface.reset(Test::createXdgToplevelSurface(client.surface.get()));
+        client.window = Test::renderAndWaitForShown(client.surface.get(), bufferSize, Qt::white);
+        if (!client.window) {
+            return false;
+        }
+        if (client.geometry.isValid()) {
+            client.window->move(client.geometry.topLeft());
+        }
+        QObject::connect(client.window->surface(), &KWaylandServer::SurfaceInterface::committed, &m_context, [this]() {
+            --m_pendingCommits;
+        });
+        return true;
+    }
+
+    if (bufferSize.isEmpty()) {
+        client.surface->attachBuffer(static_cast<wl_buffer *>(nullptr));
+    } else if (!event.damage.isEmpty() || bufferSize != client.window->surface()->bufferSize()) {
+        QImage image(bufferSize, QImage::Format_ARGB32_Premultiplied);
+        image.fill(QColor::fromHsv(++client.color * 23 % 360, 200, 220));
+        client.surface->attachBuffer(Test::waylandShmPool()->createBuffer(image));
+        client.surface->damage(event.damage.isEmpty() ? QRegion(QRect(QPoint(0, 0), bufferSize)) : event.damage);
+    }
+    client.surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    ++m_pendingCommits;
+    return true;
+}
+
+bool WorkloadPlayer::destroy(quint32 surface)
+{
+    auto it = m_clients.find(surface);
+    if (it == m_clients.end()) {
+        return true;
+    }
+    Window *window = it->second.window;
+    m_clients.erase(it);
+    if (!window) {
+        return true;
+    }
+    return Test::waitForWindowDestroyed(window);
+}
+
+void WorkloadPlayer::restack(const QVector<quint32> &stacking)
+{
+    for (quint32 surface : stacking) {
+        if (Window *window = this->window(surface)) {
+            workspace()->raiseWindow(window);
+        }
+    }
+}
+
+void WorkloadPlayer::setEffectActive(const QString &name, bool active)
+{
+    auto effectsImpl = static_cast<EffectsHandlerImpl *>(effects);
+    if (active && !effectsImpl->isEffectLoaded(name) && !effectsImpl->loadEffect(name)) {
+        qWarning() << "Failed to load" << name << "to replay its activation";
+        return;
+    }
+    if (Effect *effect = effectsImpl->findEffect(name)) {
+        QMetaObject::invokeMethod(effect, active ? "activate" : "deactivate");
+    }
+}
+
+bool WorkloadPlayer::waitForCommits()
+{
+    // The commits have to reach the compositor before the frame they were recorded in.
+    Test::flushWaylandConnection();
+    return QTest::qWaitFor([this]() {
+        return m_pendingCommits <= 0;
+    });
+}
+
+bool WorkloadPlayer::renderFrame()
+{
+    RenderLoop *renderLoop = workspace()->outputs().constFirst()->renderLoop();
+    QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+    renderLoop->scheduleRepaint();
+    if (!framePresentedSpy.wait()) {
+        return false;
+    }
+    ++m_frameCount;
+    return true;
+}
+
+class WorkloadReplayTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testRecord();
+    void testRecordToFileDescriptor();
+    void testRecordOutputAdded();
+    void testReplay();
+    void benchmarkReplayTrace();
+
+private:
+    QString recordSession();
+
+    QTemporaryDir m_directory;
+};
+
+void WorkloadReplayTest::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+
+    qRegisterMetaType<KWin::Window *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(waylandServer()->init(s_socketName));
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>() << QRect(0, 0, 1280, 1024)));
+
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    const auto builtinNames = EffectLoader().listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(workspace()->workloadRecorder());
+}
+
+void WorkloadReplayTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    workspace()->setActiveOutput(QPoint(640, 512));
+    Test::pointerMotion(QPointF(640, 512), 1);
+}
+
+void WorkloadReplayTest::cleanup()
+{
+    workspace()->workloadRecorder()->stop();
+    Test::destroyWaylandConnection();
+    QTRY_VERIFY(workspace()->allClientList().isEmpty());
+}
+
+QString WorkloadReplayTest::recordSession()
+{
+    const QString fileName = m_directory.filePath(QStringLiteral("session.trace"));
+    if (!workspace()->workloadRecorder()->start(fileName)) {
+        return QString();
+    }
+
+    std::unique_ptr<KWayland::Client::Surface> surface1(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface1(Test::createXdgToplevelSurface(surface1.get()));
+    Window *window1 = Test::renderAndWaitForShown(surface1.get(), QSize(100, 50), Qt::blue);
+    std::unique_ptr<KWayland::Client::Surface> surface2(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface2(Test::createXdgToplevelSurface(surface2.get()));
+    Window *window2 = Test::renderAndWaitForShown(surface2.get(), QSize(200, 100), Qt::red);
+    if (!window1 || !window2) {
+        return QString();
+    }
+
+    RenderLoop *renderLoop = workspace()->outputs().constFirst()->renderLoop();
+    for (int i = 0; i < 10; ++i) {
+        QImage image(QSize(100, 50), QImage::Format_ARGB32_Premultiplied);
+        image.fill(QColor::fromHsv(i * 30, 255, 255));
+        surface1->attachBuffer(Test::waylandShmPool()->createBuffer(image));
+        surface1->damage(QRect(i * 10, 0, 10, 10));
+        surface1->commit(KWayland::Client::Surface::CommitFlag::None);
+
+        window2->move(QPoint(300 + i * 10, 200));
+        Test::pointerMotion(QPointF(600 + i * 5, 500), i + 2);
+
+        QSignalSpy framePresentedSpy(renderLoop, &RenderLoop::framePresented);
+        if (!framePresentedSpy.wait()) {
+            return QString();
+        }
+    }
+    workspace()->raiseWindow(window1);
+
+    workspace()->workloadRecorder()->stop();
+    return fileName;
+}
+
+void WorkloadReplayTest::testRecord()
+{
+    // This test verifies that the commits, the input events and the window changes end up in
+    // the trace.
+    WorkloadRecorder *recorder = workspace()->workloadRecorder();
+    const QString fileName = m_directory.filePath(QStringLiteral("record.trace"));
+    QSignalSpy recordingChangedSpy(recorder, &WorkloadRecorder::recordingChanged);
+    QVERIFY(recorder->start(fileName));
+    QVERIFY(recorder->isRecording());
+    QCOMPARE(recordingChangedSpy.count(), 1);
+    QVERIFY(!recorder->start(fileName));
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+
+    QImage image(QSize(100, 50), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    QSignalSpy committedSpy(window->surface(), &KWaylandServer::SurfaceInterface::committed);
+    surface->attachBuffer(Test::waylandShmPool()->createBuffer(image));
+    surface->damage(QRect(10, 10, 20, 20));
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+
+    Test::pointerMotion(QPointF(500, 400), 2);
+    Test::pointerButtonPressed(BTN_LEFT, 3);
+    Test::pointerButtonReleased(BTN_LEFT, 4);
+    window->move(QPoint(200, 100));
+
+    recorder->stop();
+    QVERIFY(!recorder->isRecording());
+    QCOMPARE(recordingChangedSpy.count(), 2);
+
+    const QVector<WorkloadEvent> events = readTrace(fileName);
+    QVERIFY(!events.isEmpty());
+    QCOMPARE(events.first().type, WorkloadEvent::Type::Output);
+    QCOMPARE(events.first().rect, QRect(0, 0, 1280, 1024));
+
+    auto find = [&events](auto predicate) {
+        return std::find_if(events.cbegin(), events.cend(), predicate);
+    };
+    const auto windowAdded = find([](const WorkloadEvent &event) {
+        return event.type == WorkloadEvent::Type::WindowAdded;
+    });
+    QVERIFY(windowAdded != events.cend());
+    const quint32 id = windowAdded->surface;
+    QCOMPARE(windowAdded->rect.size(), QSize(100, 50));
+
+    const auto partialCommit = find([id](const WorkloadEvent &event) {
+        return event.type == WorkloadEvent::Type::SurfaceCommit && event.surface == id && event.damage == QRegion(10, 10, 20, 20);
+    });
+    QVERIFY(partialCommit != events.cend());
+    QCOMPARE(partialCommit->rect.size(), QSize(100, 50));
+
+    QVERIFY(find([](const WorkloadEvent &event) {
+                return event.type == WorkloadEvent::Type::PointerMotion && event.position == QPointF(500, 400);
+            })
+            != events.cend());
+    QVERIFY(find([](const WorkloadEvent &event) {
+                return event.type == WorkloadEvent::Type::PointerButton && event.button == BTN_LEFT && event.pressed;
+            })
+            != events.cend());
+    QVERIFY(find([](const WorkloadEvent &event) {
+                return event.type == WorkloadEvent::Type::PointerButton && event.button == BTN_LEFT && !event.pressed;
+            })
+            != events.cend());
+    QVERIFY(find([id](const WorkloadEvent &event) {
+                return event.type == WorkloadEvent::Type::WindowGeometry && event.surface == id && event.rect.topLeft() == QPoint(200, 100);
+            })
+            != events.cend());
+    QVERIFY(find([](const WorkloadEvent &event) {
+                return event.type == WorkloadEvent::Type::Frame;
+            })
+            != events.cend());
+    QVERIFY(std::is_sorted(events.cbegin(), events.cend(), [](const WorkloadEvent &left, const WorkloadEvent &right) {
+        return left.timestamp < right.timestamp;
+    }));
+}
+
+void WorkloadReplayTest::testRecordToFileDescriptor()
+{
+    // This test verifies that a recording can be started with a file descriptor, which is how
+    // it's started over D-Bus.
+    WorkloadRecorder *recorder = workspace()->workloadRecorder();
+    QFile file(m_directory.filePath(QStringLiteral("descriptor.trace")));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QVERIFY(!recorder->start(QDBusUnixFileDescriptor()));
+    QVERIFY(!recorder->isRecording());
+
+    QVERIFY(recorder->start(QDBusUnixFileDescriptor(file.handle())));
+    QVERIFY(recorder->isRecording());
+    file.close();
+
+    std::unique_ptr<KWayland::Client::Surface> surface(Test::createSurface());
+    std::unique_ptr<Test::XdgToplevel> shellSurface(Test::createXdgToplevelSurface(surface.get()));
+    Window *window = Test::renderAndWaitForShown(surface.get(), QSize(100, 50), Qt::blue);
+    QVERIFY(window);
+    recorder->stop();
+
+    const QVector<WorkloadEvent> events = readTrace(file.fileName());
+    QVERIFY(!events.isEmpty());
+    QVERIFY(std::any_of(events.cbegin(), events.cend(), [](const WorkloadEvent &event) {
+        return event.type == WorkloadEvent::Type::WindowAdded && event.rect.size() == QSize(100, 50);
+    }));
+}
+
+void WorkloadReplayTest::testRecordOutputAdded()
+{
+    // This test verifies that outputs added during the recording are written to the trace and
+    // that their frames are recorded too.
+    WorkloadRecorder *recorder = workspace()->workloadRecorder();
+    const QString fileName = m_directory.filePath(QStringLiteral("outputs.trace"));
+    QVERIFY(recorder->start(fileName));
+
+    const QVector<QRect> geometries{QRect(0, 0, 1280, 1024), QRect(1280, 0, 1280, 1024)};
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, geometries));
+    QCOMPARE(workspace()->outputs().count(), 2);
+
+    // The virtual backend replaces all outputs, so the outputs that were there when the
+    // recording started are gone.
+    Output *output = workspace()->outputs().constLast();
+    QSignalSpy framePresentedSpy(output->renderLoop(), &RenderLoop::framePresented);
+    output->renderLoop()->scheduleRepaint();
+    QVERIFY(framePresentedSpy.wait());
+    recorder->stop();
+
+    QMetaObject::invokeMethod(kwinApp()->outputBackend(), "setVirtualOutputs", Qt::DirectConnection, Q_ARG(QVector<QRect>, QVector<QRect>{geometries.constFirst()}));
+    QCOMPARE(workspace()->outputs().count(), 1);
+
+    const QVector<WorkloadEvent> events = readTrace(fileName);
+    const auto outputAdded = std::find_if(events.cbegin(), events.cend(), [](const WorkloadEvent &event) {
+        return event.type == WorkloadEvent::Type::Output && event.rect == QRect(1280, 0, 1280, 1024);
+    });
+    QVERIFY(outputAdded != events.cend());
+    QVERIFY(std::any_of(outputAdded, events.cend(), [](const WorkloadEvent &event) {
+        return event.type == WorkloadEvent::Type::Frame;
+    }));
+}
+
+void WorkloadReplayTest::testReplay()
+{
+    // This test verifies that a recorded session is replayed frame by frame with windows of the
+    // recorded sizes, positions and stacking order.
+    const QString fileName = recordSession();
+    QVERIFY(!fileName.isEmpty());
+    Test::destroyWaylandConnection();
+    QTRY_VERIFY(workspace()->allClientList().isEmpty());
+    QVERIFY(Test::setupWaylandConnection());
+
+    const QVector<WorkloadEvent> events = readTrace(fileName);
+    const int recordedFrames = std::count_if(events.cbegin(), events.cend(), [](const WorkloadEvent &event) {
+        return event.type == WorkloadEvent::Type::Frame;
+    });
+    QVERIFY(recordedFrames >= 10);
+
+    QHash<quint32, QRect> geometries;
+    QVector<quint32> stacking;
+    for (const WorkloadEvent &event : events) {
+        if (event.type == WorkloadEvent::Type::WindowAdded || event.type == WorkloadEvent::Type::WindowGeometry) {
+            geometries[event.surface] = event.rect;
+        } else if (event.type == WorkloadEvent::Type::StackingOrder) {
+            stacking = event.stacking;
+        }
+    }
+    QCOMPARE(geometries.count(), 2);
+
+    FrameRecorder recorder(workspace()->outputs().constFirst()->renderLoop());
+    recorder.start();
+    WorkloadPlayer player;
+    QVERIFY(player.replay(events));
+    recorder.stop();
+    QCOMPARE(player.frameCount(), recordedFrames);
+    QVERIFY(recorder.results()[QStringLiteral("frames")].toInt() >= recordedFrames);
+
+    for (auto it = geometries.cbegin(); it != geometries.cend(); ++it) {
+        Window *window = player.window(it.key());
+        QVERIFY(window);
+        QCOMPARE(window->frameGeometry().toRect(), it.value());
+    }
+    QCOMPARE(workspace()->stackingOrder().constLast(), player.window(stacking.constLast()));
+}
+
+void WorkloadReplayTest::benchmarkReplayTrace()
+{
+    // Replays the trace named by KWIN_WORKLOAD_TRACE and reports the measurements like the
+    // rendering benchmarks do, see writeBenchmarkReport().
+    const QString fileName = qEnvironmentVariable("KWIN_WORKLOAD_TRACE");
+    if (fileName.isEmpty()) {
+        QSKIP("Set KWIN_WORKLOAD_TRACE to replay a recorded workload");
+    }
+    const QVector<WorkloadEvent> events = readTrace(fileName);
+    QVERIFY(!events.isEmpty());
+
+    FrameRecorder recorder(workspace()->outputs().constFirst()->renderLoop());
+    recorder.start();
+    WorkloadPlayer player;
+    QVERIFY(player.replay(events));
+    recorder.stop();
+
+    QJsonObject results = recorder.results();
+    results[QStringLiteral("name")] = fileName;
+    results[QStringLiteral("replayedFrames")] = player.frameCount();
+    results[QStringLiteral("skippedCommits")] = player.skippedCommits();
+    QTest::setBenchmarkResult(std::chrono::duration<double, std::milli>(recorder.averageFrameTime()).count(), QTest::WalltimeMilliseconds);
+
+    writeBenchmarkReport(QJsonObject{
+        {QStringLiteral("backend"), QStringLiteral("virtual")},
+        {QStringLiteral("scenarios"), QJsonArray{results}},
+    });
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::WorkloadReplayTest)
+#include "workload_replay_test.moc"
@@ -0,0 +1,335 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include <QTest>
+#include <QTransform>
+#include <kwineffects.h>
+#include <kwinwindowmesh.h>
+
+#include <array>
+
+using namespace KWin;
+
+class WindowMeshTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testRoundTrip();
+    void testMakeGrid_data();
+    void testMakeGrid();
+    void testMakeRegularGrid();
+    void testTransform();
+    void testBezierPatch();
+    void testTriangulate();
+
+    void benchmarkWobbly_data();
+    void benchmarkWobbly();
+    void benchmarkMagicLamp_data();
+    void benchmarkMagicLamp();
+
+private:
+    static WindowQuad makeQuad(const QRectF &rect);
+    static std::array<QPointF, 16> makeControlPoints(const QSizeF &size);
+    static QPointF bezierPoint(const std::array<QPointF, 16> &controlPoints, const QPointF &point);
+    static void verifyMesh(const WindowMesh &mesh, const WindowQuadList &quads);
+};
+
+WindowQuad WindowMeshTest::makeQuad(const QRectF &r)
+{
+    WindowQuad quad;
+    quad[0] = WindowVertex(r.x(), r.y(), r.x() / 100, r.y() / 100);
+    quad[1] = WindowVertex(r.x() + r.width(), r.y(), (r.x() + r.width()) / 100, r.y() / 100);
+    quad[2] = WindowVertex(r.x() + r.width(), r.y() + r.height(), (r.x() + r.width()) / 100, (r.y() + r.height()) / 100);
+    quad[3] = WindowVertex(r.x(), r.y() + r.height(), r.x() / 100, (r.y() + r.height()) / 100);
+    return quad;
+}
+
+std::array<QPointF, 16> WindowMeshTest::makeControlPoints(const QSizeF &size)
+{
+    // A regular grid over the window with some of the points pulled around, like a wobbly window.
+    std::array<QPointF, 16> controlPoints;
+    for (int j = 0; j < 4; ++j) {
+        for (int i = 0; i < 4; ++i) {
+            controlPoints[i + j * 4] = QPointF(size.width() * i / 3 + (i * j % 3) * 7, size.height() * j / 3 - (i + j) % 2 * 11);
+        }
+    }
+    return controlPoints;
+}
+
+QPointF WindowMeshTest::bezierPoint(const std::array<QPointF, 16> &controlPoints, const QPointF &point)
+{
+    const qreal tx = point.x();
+    const qreal ty = point.y();
+    const qreal px[4] = {(1 - tx) * (1 - tx) * (1 - tx), 3 * (1 - tx) * (1 - tx) * tx, 3 * (1 - tx) * tx * tx, tx * tx * tx};
+    const qreal py[4] = {(1 - ty) * (1 - ty) * (1 - ty), 3 * (1 - ty) * (1 - ty) * ty, 3 * (1 - ty) * ty * ty, ty * ty * ty};
+
+    QPointF result;
+    for (int j = 0; j < 4; ++j) {
+        for (int i = 0; i < 4; ++i) {
+            result += px[i] * py[j] * controlPoints[i + j * 4];
+        }
+    }
+    return result;
+}
+
+void WindowMeshTest::verifyMesh(const WindowMesh &mesh, const WindowQuadList &quads)
+{
+    QCOMPARE(mesh.quadCount(), quads.count());
+    for (int i = 0; i < quads.count(); ++i) {
+        for (int j = 0; j < 4; ++j) {
+            const WindowVertex &vertex = quads[i][j];
+            QVERIFY(qAbs(mesh.x()[i * 4 + j] - vertex.x()) < 1e-3);
+            QVERIFY(qAbs(mesh.y()[i * 4 + j] - vertex.y()) < 1e-3);
+            QVERIFY(qAbs(mesh.u()[i * 4 + j] - vertex.u()) < 1e-5);
+            QVERIFY(qAbs(mesh.v()[i * 4 + j] - vertex.v()) < 1e-5);
+        }
+    }
+}
+
+void WindowMeshTest::testRoundTrip()
+{
+    WindowQuadList quads;
+    quads.append(makeQuad(QRectF(0, 0, 10, 20)));
+    quads.append(makeQuad(QRectF(10, 0, 30, 20)));
+
+    const WindowMesh mesh(quads);
+    QCOMPARE(mesh.quadCount(), 2);
+    QCOMPARE(mesh.vertexCount(), 8);
+    QCOMPARE(mesh.bounds(), QRectF(0, 0, 40, 20));
+    verifyMesh(mesh, quads);
+    verifyMesh(WindowMesh(mesh.toQuadList()), quads);
+
+    WindowMesh rectMesh;
+    rectMesh.appendQuad(QRectF(0, 0, 10, 20), QRectF(0, 0, 0.1, 0.2));
+    WindowQuadList rectQuads;
+    rectQuads.append(makeQuad(QRectF(0, 0, 10, 20)));
+    verifyMesh(rectMesh, rectQuads);
+}
+
+void WindowMeshTest::testMakeGrid_data()
+{
+    QTest::addColumn<QList<QRectF>>("rects");
+    QTest::addColumn<int>("quadSize");
+
+    QTest::newRow("empty") << QList<QRectF>() << 10;
+    QTest::newRow("quadSizeTooLarge") << QList<QRectF>{QRectF(0, 0, 10, 10)} << 10;
+    QTest::newRow("regularGrid") << QList<QRectF>{QRectF(0, 0, 10, 10)} << 5;
+    QTest::newRow("irregularGrid") << QList<QRectF>{QRectF(0, 0, 10, 10)} << 4;
+    QTest::newRow("multipleQuads") << QList<QRectF>{QRectF(0, 0, 10, 5), QRectF(0, 5, 10, 5)} << 4;
+    QTest::newRow("degenerate") << QList<QRectF>{QRectF(0, 0, 0, 10), QRectF(0, 0, 10, 10)} << 3;
+}
+
+void WindowMeshTest::testMakeGrid()
+{
+    QFETCH(QList<QRectF>, rects);
+    QFETCH(int, quadSize);
+
+    WindowQuadList quads;
+    for (const QRectF &rect : rects) {
+        quads.append(makeQuad(rect));
+    }
+
+    verifyMesh(WindowMesh(quads).makeGrid(quadSize), quads.makeGrid(quadSize));
+}
+
+void WindowMeshTest::testMakeRegularGrid()
+{
+    WindowQuadList quads;
+    quads.append(makeQuad(QRectF(0, 0, 100, 30)));
+    quads.append(makeQuad(QRectF(0, 30, 100, 70)));
+
+    verifyMesh(WindowMesh(quads).makeRegularGrid(20, 20), quads.makeRegularGrid(20, 20));
+    verifyMesh(WindowMesh(quads).makeRegularGrid(3, 7), quads.makeRegularGrid(3, 7));
+}
+
+void WindowMeshTest::testTransform()
+{
+    WindowQuadList quads;
+    quads.append(makeQuad(QRectF(0, 0, 100, 100)));
+    // More than one SIMD register worth of vertices plus a remainder.
+    const WindowMesh original = WindowMesh(quads).makeGrid(30);
+
+    QTransform transform;
+    transform.translate(10, -20);
+    transform.rotate(30);
+    transform.scale(1.5, 0.5);
+
+    WindowMesh mesh = original;
+    mesh.transform(transform);
+    for (int i = 0; i < mesh.vertexCount(); ++i) {
+        const QPointF expected = transform.map(QPointF(original.x()[i], original.y()[i]));
+        QVERIFY(qAbs(mesh.x()[i] - expected.x()) < 1e-3);
+        QVERIFY(qAbs(mesh.y()[i] - expected.y()) < 1e-3);
+        QCOMPARE(mesh.u()[i], original.u()[i]);
+        QCOMPARE(mesh.v()[i], original.v()[i]);
+    }
+
+    mesh = original;
+    mesh.translate(5, 7);
+    for (int i = 0; i < mesh.vertexCount(); ++i) {
+        QCOMPARE(mesh.x()[i], original.x()[i] + 5);
+        QCOMPARE(mesh.y()[i], original.y()[i] + 7);
+    }
+}
+
+void WindowMeshTest::testBezierPatch()
+{
+    const QSizeF size(300, 200);
+    const std::array<QPointF, 16> controlPoints = makeControlPoints(size);
+
+    WindowMesh original;
+    original.appendQuad(QRectF(QPointF(0, 0), size), QRectF(0, 0, 1, 1));
+    original = original.makeRegularGrid(7, 5);
+
+    WindowMesh mesh = original;
+    mesh.applyBezierPatch(size, controlPoints);
+    for (int i = 0; i < mesh.vertexCount(); ++i) {
+        const QPointF uv(original.x()[i] / size.width(), original.y()[i] / size.height());
+        const QPointF expected = bezierPoint(controlPoints, uv);
+        QVERIFY(qAbs(mesh.x()[i] - expected.x()) < 1e-2);
+        QVERIFY(qAbs(mesh.y()[i] - expected.y()) < 1e-2);
+    }
+
+    // The corners of the patch are the corner control points.
+    QCOMPARE(QPointF(mesh.x()[0], mesh.y()[0]), controlPoints[0]);
+}
+
+void WindowMeshTest::testTriangulate()
+{
+    WindowMesh mesh;
+    mesh.appendQuad(QRectF(0.4, 0.6, 10, 20), QRectF(0, 0, 1, 1));
+
+    std::array<GLVertex2D, 6> vertices;
+    mesh.triangulate(vertices, 2.0);
+
+    // The quad is split like RenderGeometry::appendWindowQuad() does it.
+    RenderGeometry geometry;
+    geometry.appendWindowQuad(mesh.toQuadList().first(), 2.0);
+    QCOMPARE(geometry.count(), 6);
+    for (int i = 0; i < 6; ++i) {
+        QCOMPARE(vertices[i].position, geometry[i].position);
+        QCOMPARE(vertices[i].texcoord, geometry[i].texcoord);
+    }
+
+    QMatrix4x4 textureMatrix;
+    textureMatrix.scale(1, -1);
+    textureMatrix.translate(0, -1);
+    mesh.triangulate(vertices, 1.0, RenderGeometry::VertexSnappingMode::None, textureMatrix);
+    QCOMPARE(vertices[0].position, QVector2D(0.4, 0.6));
+    QCOMPARE(vertices[0].texcoord, QVector2D(0, 1));
+    QCOMPARE(vertices[1].texcoord, QVector2D(0, 0));
+}
+
+void WindowMeshTest::benchmarkWobbly_data()
+{
+    QTest::addColumn<bool>("mesh");
+
+    QTest::newRow("WindowQuadList") << false;
+    QTest::newRow("WindowMesh") << true;
+}
+
+void WindowMeshTest::benchmarkWobbly()
+{
+    // The wobbly windows effect splits the window into a 20x20 grid and maps it onto a Bezier patch.
+    QFETCH(bool, mesh);
+
+    const QSizeF size(1280, 800);
+    const std::array<QPointF, 16> controlPoints = makeControlPoints(size);
+    WindowQuadList quads;
+    quads.append(makeQuad(QRectF(QPointF(0, 0), size)));
+
+    if (mesh) {
+        QBENCHMARK {
+            WindowMesh grid = WindowMesh(quads).makeRegularGrid(20, 20);
+            grid.applyBezierPatch(size, controlPoints);
+
+            std::vector<GLVertex2D> vertices(grid.quadCount() * 6);
+            grid.triangulate(vertices, 1.0);
+        }
+    } else {
+        QBENCHMARK {
+            WindowQuadList grid = quads.makeRegularGrid(20, 20);
+            for (WindowQuad &quad : grid) {
+                for (int j = 0; j < 4; ++j) {
+                    WindowVertex &vertex = quad[j];
+                    const QPointF position = bezierPoint(controlPoints, QPointF(vertex.x() / size.width(), vertex.y() / size.height()));
+                    vertex.move(position.x(), position.y());
+                }
+            }
+
+            RenderGeometry geometry;
+            for (const WindowQuad &quad : std::as_const(grid)) {
+                geometry.appendWindowQuad(quad, 1.0);
+            }
+        }
+    }
+}
+
+void WindowMeshTest::benchmarkMagicLamp_data()
+{
+    QTest::addColumn<bool>("mesh");
+
+    QTest::newRow("WindowQuadList") << false;
+    QTest::newRow("WindowMesh") << true;
+}
+
+void WindowMeshTest::benchmarkMagicLamp()
+{
+    // The magic lamp effect splits the window into 40px cells and moves every vertex
+    // towards an icon below the window, by a distance that depends on its row.
+    QFETCH(bool, mesh);
+
+    const QRectF geo(100, 100, 1280, 800);
+    const QRectF icon(600, 1040, 48, 40);
+    const float progress = 0.5;
+    const float height_cube = geo.height() * geo.height() * geo.height();
+    const float maxY = icon.y() - geo.y();
+
+    WindowQuadList quads;
+    quads.append(makeQuad(QRectF(QPointF(0, 0), geo.size())));
+
+    auto warp = [&](float x, float y) {
+        const float quadFactor = y + (geo.height() - y) * progress;
+        const float offset = (icon.y() + y - geo.y()) * progress * ((quadFactor * quadFactor * quadFactor) / height_cube);
+        const float p_progress = std::abs(std::min<float>(offset / (icon.y() - geo.y() - y), 1.0f));
+        return QPointF((icon.x() + icon.width() * (x / geo.width()) - (x + geo.x())) * p_progress + x, std::min(maxY, y + offset));
+    };
+
+    if (mesh) {
+        QBENCHMARK {
+            WindowMesh grid = WindowMesh(quads).makeGrid(40);
+            grid.warp([&](float &x, float &y) {
+                const QPointF position = warp(x, y);
+                x = position.x();
+                y = position.y();
+            });
+
+            std::vector<GLVertex2D> vertices(grid.quadCount() * 6);
+            grid.triangulate(vertices, 1.0);
+        }
+    } else {
+        QBENCHMARK {
+            WindowQuadList grid = quads.makeGrid(40);
+            for (WindowQuad &quad : grid) {
+                for (int j = 0; j < 4; ++j) {
+                    const QPointF position = warp(quad[j].x(), quad[j].y());
+                    quad[j].setX(position.x());
+                    quad[j].setY(position.y());
+                }
+            }
+
+            RenderGeometry geometry;
+            for (const WindowQuad &quad : std::as_const(grid)) {
+                geometry.appendWindowQuad(quad, 1.0);
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(WindowMeshTest)
+#include "windowmeshtest.moc"
@@ -0,0 +1,234 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "colors/colortransformationcache.h"
+#include "core/colorlut.h"
+#include "core/colortransformation.h"
+
+#include <QtTest>
+
+using namespace KWin;
+
+// Gamma ramp size of a typical atomic DRM crtc.
+static const size_t s_rampSize = 4096;
+// Temperature change per update during a night color transition.
+static const uint s_temperatureStep = 50;
+
+class TestColorTransformationCache : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testRampMatchesPipeline_data();
+    void testRampMatchesPipeline();
+    void testBlendedTemperature_data();
+    void testBlendedTemperature();
+    void testSharedBetweenDevices();
+    void testCapacity();
+    void testEvictLeastRecentlyUsed();
+    void benchmarkLookup();
+    void benchmarkSunrise_data();
+    void benchmarkSunrise();
+};
+
+static QVector<uint16_t> evaluatePerEntry(const ColorTransformation &transformation, size_t size)
+{
+    QVector<uint16_t> ramp(3 * size);
+    for (size_t i = 0; i < size; ++i) {
+        const uint16_t index = (i * 0xFFFF) / size;
+        std::tie(ramp[i], ramp[size + i], ramp[2 * size + i]) = transformation.transform(index, index, index);
+    }
+    return ramp;
+}
+
+void TestColorTransformationCache::testRampMatchesPipeline_data()
+{
+    QTest::addColumn<uint>("temperature");
+    QTest::addColumn<uint>("brightness");
+
+    QTest::newRow("identity") << 6500u << 100u;
+    QTest::newRow("warm") << 3000u << 100u;
+    QTest::newRow("dimmed") << 6500u << 60u;
+    QTest::newRow("warm and dimmed") << 1000u << 30u;
+}
+
+void TestColorTransformationCache::testRampMatchesPipeline()
+{
+    // This test verifies that evaluating the whole ramp at once gives the same result as
+    // pushing every entry through the lcms pipeline.
+    QFETCH(uint, temperature);
+    QFETCH(uint, brightness);
+
+    ColorTransformationCache cache;
+    const auto transformation = cache.build(QString(), temperature, brightness);
+    QVERIFY(transformation);
+    QVERIFY(transformation->valid());
+    QCOMPARE(transformation->ramp(s_rampSize), evaluatePerEntry(*transformation, s_rampSize));
+    QCOMPARE(transformation->ramp(256), evaluatePerEntry(*transformation, 256));
+}
+
+void TestColorTransformationCache::testBlendedTemperature_data()
+{
+    QTest::addColumn<uint>("temperature");
+    QTest::addColumn<uint>("brightness");
+
+    QTest::newRow("4550K") << 4550u << 100u;
+    QTest::newRow("1050K") << 1050u << 100u;
+    QTest::newRow("6450K, dimmed") << 6450u << 70u;
+    QTest::newRow("2730K, dimmed") << 2730u << 45u;
+}
+
+void TestColorTransformationCache::testBlendedTemperature()
+{
+    // This test verifies that temperatures between two entries of the black body table are
+    // blended from the neighbouring transformations with at most one step of rounding error.
+    QFETCH(uint, temperature);
+    QFETCH(uint, brightness);
+
+    ColorTransformationCache cache;
+    const auto blended = cache.transformation(QString(), temperature, brightness);
+    QVERIFY(blended);
+    QCOMPARE(int(cache.statistics().blends), 1);
+    QCOMPARE(cache.count(), 3);
+
+    const auto direct = cache.build(QString(), temperature, brightness);
+    const QVector<uint16_t> expected = evaluatePerEntry(*direct, s_rampSize);
+    const QVector<uint16_t> actual = blended->ramp(s_rampSize);
+    QCOMPARE(actual.size(), expected.size());
+    for (int i = 0; i < expected.size(); ++i) {
+        QVERIFY2(std::abs(int(actual[i]) - int(expected[i])) <= 1, qPrintable(QStringLiteral("entry %1: %2 != %3").arg(i).arg(actual[i]).arg(expected[i])));
+    }
+
+    const auto [r, g, b] = blended->transform(0x8000, 0x8000, 0x8000);
+    const auto [expectedR, expectedG, expectedB] = direct->transform(0x8000, 0x8000, 0x8000);
+    QVERIFY(std::abs(int(r) - int(expectedR)) <= 1);
+    QVERIFY(std::abs(int(g) - int(expectedG)) <= 1);
+    QVERIFY(std::abs(int(b) - int(expectedB)) <= 1);
+}
+
+void TestColorTransformationCache::testSharedBetweenDevices()
+{
+    // This test verifies that devices with the same settings share the transformation and
+    // the evaluated ramp.
+    ColorTransformationCache cache;
+    const auto first = cache.transformation(QString(), 4000, 100);
+    const auto second = cache.transformation(QString(), 4000, 100);
+    QCOMPARE(first, second);
+    QCOMPARE(int(cache.statistics().hits), 1);
+    QCOMPARE(int(cache.statistics().misses), 1);
+
+    const ColorLUT firstLut(first, s_rampSize);
+    const ColorLUT secondLut(second, s_rampSize);
+    QCOMPARE(firstLut.red(), secondLut.red());
+
+    QVERIFY(cache.transformation(QString(), 4000, 50) != first);
+}
+
+void TestColorTransformationCache::testCapacity()
+{
+    ColorTransformationCache cache(4);
+    for (uint temperature = 1000; temperature < 2000; temperature += 100) {
+        QVERIFY(cache.transformation(QString(), temperature, 100));
+    }
+    QCOMPARE(cache.count(), 4);
+
+    cache.clear();
+    QCOMPARE(cache.count(), 0);
+}
+
+void TestColorTransformationCache::testEvictLeastRecentlyUsed()
+{
+    // This test verifies that a transformation that has just been used is kept over one that
+    // was inserted later but not used since.
+    ColorTransformationCache cache(2);
+    const auto first = cache.transformation(QString(), 6500, 100);
+    cache.transformation(QString(), 6500, 90);
+    QCOMPARE(cache.transformation(QString(), 6500, 100), first);
+    cache.transformation(QString(), 6500, 80);
+    QCOMPARE(cache.count(), 2);
+
+    const ColorTransformationCache::Statistics before = cache.statistics();
+    QCOMPARE(cache.transformation(QString(), 6500, 100), first);
+    QCOMPARE(cache.statistics().hits, before.hits + 1);
+    cache.transformation(QString(), 6500, 90);
+    QCOMPARE(cache.statistics().misses, before.misses + 1);
+}
+
+void TestColorTransformationCache::benchmarkLookup()
+{
+    // This benchmark looks up every transformation of a full cache, starting with the least
+    // recently used one, which is the worst case for moving a hit to the front.
+    ColorTransformationCache cache;
+    QVector<std::pair<uint, uint>> keys;
+    for (uint brightness = 91; brightness <= 100; ++brightness) {
+        for (uint temperature = 1000; temperature <= 6500; temperature += 100) {
+            keys.append({temperature, brightness});
+        }
+    }
+    for (const auto &[temperature, brightness] : std::as_const(keys)) {
+        QVERIFY(cache.transformation(QString(), temperature, brightness));
+    }
+    QCOMPARE(cache.count(), 512);
+    keys.remove(0, keys.count() - 512);
+
+    const ColorTransformationCache::Statistics before = cache.statistics();
+    QBENCHMARK {
+        for (const auto &[temperature, brightness] : std::as_const(keys)) {
+            cache.transformation(QString(), temperature, brightness);
+        }
+    }
+    QCOMPARE(cache.statistics().misses, before.misses);
+    QVERIFY(cache.statistics().hits > before.hits);
+}
+
+void TestColorTransformationCache::benchmarkSunrise_data()
+{
+    QTest::addColumn<QString>("mode");
+
+    QTest::newRow("per entry") << QStringLiteral("perEntry");
+    QTest::newRow("batched") << QStringLiteral("batched");
+    QTest::newRow("cached, first transition") << QStringLiteral("cold");
+    QTest::newRow("cached, repeated transition") << QStringLiteral("warm");
+}
+
+void TestColorTransformationCache::benchmarkSunrise()
+{
+    // This benchmark measures the gamma ramps needed for a full transition from the night to
+    // the day temperature on four outputs. "per entry" matches how the ramps used to be
+    // computed, every output built its own pipeline and evaluated it entry by entry.
+    QFETCH(QString, mode);
+    const int outputCount = 4;
+
+    ColorTransformationCache cache;
+    if (mode == QLatin1String("warm")) {
+        for (uint temperature = 1000; temperature <= 6500; temperature += s_temperatureStep) {
+            ColorLUT(cache.transformation(QString(), temperature, 100), s_rampSize);
+        }
+    }
+
+    QBENCHMARK {
+        if (mode == QLatin1String("cold")) {
+            cache.clear();
+        }
+        for (uint temperature = 1000; temperature <= 6500; temperature += s_temperatureStep) {
+            for (int output = 0; output < outputCount; ++output) {
+                if (mode == QLatin1String("perEntry")) {
+                    const auto transformation = cache.build(QString(), temperature, 100);
+                    evaluatePerEntry(*transformation, s_rampSize);
+                } else if (mode == QLatin1String("batched")) {
+                    const ColorLUT lut(cache.build(QString(), temperature, 100), s_rampSize);
+                } else {
+                    const ColorLUT lut(cache.transformation(QString(), temperature, 100), s_rampSize);
+                }
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestColorTransformationCache)
+#include "test_colortransformationcache.moc"
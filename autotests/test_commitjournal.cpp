@@ -0,0 +1,90 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QTest>
+
+#include "core/commitjournal.h"
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+class TestCommitJournal : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void learn();
+    void irregular();
+    void forgetAfterMisses();
+    void latchResetsMisses();
+};
+
+static void addCommits(CommitJournal &journal, int count, std::chrono::nanoseconds offset, std::chrono::nanoseconds jitter = 0ns)
+{
+    for (int i = 0; i < count; ++i) {
+        journal.addCommit(offset + (i % 2 ? jitter : 0ns));
+    }
+}
+
+void TestCommitJournal::learn()
+{
+    // Nothing is predicted until the surface has committed for a while, then the latest
+    // offset at which it commits is expected.
+    CommitJournal journal;
+    QVERIFY(!journal.predict(1ms).has_value());
+
+    addCommits(journal, 14, 8ms, 200us);
+    QVERIFY(!journal.predict(1ms).has_value());
+
+    journal.addCommit(8ms);
+    QCOMPARE(journal.predict(1ms), std::optional<std::chrono::nanoseconds>(8200us));
+}
+
+void TestCommitJournal::irregular()
+{
+    // Commits that are spread too far apart can't be predicted.
+    CommitJournal journal;
+    addCommits(journal, 15, 4ms, 3ms);
+    QVERIFY(!journal.predict(1ms).has_value());
+    QVERIFY(journal.predict(3ms).has_value());
+
+    // Once the surface settles down, the old commits fall out of the journal.
+    addCommits(journal, 15, 10ms);
+    QCOMPARE(journal.predict(1ms), std::optional<std::chrono::nanoseconds>(10ms));
+}
+
+void TestCommitJournal::forgetAfterMisses()
+{
+    CommitJournal journal;
+    addCommits(journal, 15, 8ms);
+    journal.notifyMissed();
+    journal.notifyMissed();
+    QVERIFY(journal.predict(1ms).has_value());
+
+    journal.notifyMissed();
+    QVERIFY(!journal.predict(1ms).has_value());
+
+    addCommits(journal, 15, 5ms);
+    QCOMPARE(journal.predict(1ms), std::optional<std::chrono::nanoseconds>(5ms));
+}
+
+void TestCommitJournal::latchResetsMisses()
+{
+    CommitJournal journal;
+    addCommits(journal, 15, 8ms);
+    journal.notifyMissed();
+    journal.notifyMissed();
+    journal.notifyLatched();
+    journal.notifyMissed();
+    journal.notifyMissed();
+    QVERIFY(journal.predict(1ms).has_value());
+}
+
+QTEST_GUILESS_MAIN(TestCommitJournal)
+#include "test_commitjournal.moc"
@@ -0,0 +1,198 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "utils/coveragemap.h"
+
+#include <QRandomGenerator>
+#include <QTest>
+
+using namespace KWin;
+
+struct WeightedRect
+{
+    QRect rect;
+    int weight;
+};
+
+// This is how smart placement computed the overlap with other windows before it used a
+// CoverageMap, one window at a time.
+static qint64 referenceCoverage(const QVector<WeightedRect> &rects, const QRect &rect)
+{
+    const int cxl = rect.x();
+    const int cxr = rect.x() + rect.width();
+    const int cyt = rect.y();
+    const int cyb = rect.y() + rect.height();
+
+    qint64 overlap = 0;
+    for (const WeightedRect &other : rects) {
+        int xl = other.rect.x();
+        int yt = other.rect.y();
+        int xr = xl + other.rect.width();
+        int yb = yt + other.rect.height();
+        if ((cxl < xr) && (cxr > xl) && (cyt < yb) && (cyb > yt)) {
+            xl = std::max(cxl, xl);
+            xr = std::min(cxr, xr);
+            yt = std::max(cyt, yt);
+            yb = std::min(cyb, yb);
+            overlap += qint64(other.weight) * (xr - xl) * (yb - yt);
+        }
+    }
+    return overlap;
+}
+
+static QVector<WeightedRect> randomWindows(QRandomGenerator &random, int count, const QSize &screenSize)
+{
+    static const int weights[] = {0, 1, 1, 1, 16};
+
+    QVector<WeightedRect> windows;
+    for (int i = 0; i < count; ++i) {
+        const QSize size(50 + random.bounded(screenSize.width() / 2), 50 + random.bounded(screenSize.height() / 2));
+        const QPoint position(random.bounded(-100, screenSize.width() - size.width() + 100), random.bounded(-100, screenSize.height() - size.height() + 100));
+        windows.append(WeightedRect{QRect(position, size), weights[random.bounded(5)]});
+    }
+    return windows;
+}
+
+class CoverageMapTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testEmpty();
+    void testCoverage_data();
+    void testCoverage();
+    void testRandom();
+    void benchmarkPlacementCandidates_data();
+    void benchmarkPlacementCandidates();
+};
+
+void CoverageMapTest::testEmpty()
+{
+    CoverageMap map;
+    map.build();
+    QCOMPARE(map.coverage(QRect(0, 0, 100, 100)), qint64(0));
+
+    map.add(QRect(10, 10, 0, 50));
+    map.add(QRect(10, 10, 50, 50), 0);
+    map.build();
+    QCOMPARE(map.coverage(QRect(0, 0, 100, 100)), qint64(0));
+}
+
+void CoverageMapTest::testCoverage_data()
+{
+    QTest::addColumn<QRect>("rect");
+    QTest::addColumn<qint64>("coverage");
+
+    QTest::addRow("everything") << QRect(-1000, -1000, 3000, 3000) << qint64(100 * 100 + 16 * 50 * 50 + 200 * 20);
+    QTest::addRow("nothing") << QRect(300, 300, 100, 100) << qint64(0);
+    QTest::addRow("touching") << QRect(100, 0, 10, 10) << qint64(0);
+    QTest::addRow("inside") << QRect(10, 10, 20, 20) << qint64(20 * 20);
+    QTest::addRow("partially") << QRect(-50, -50, 60, 70) << qint64(10 * 20);
+    QTest::addRow("weighted") << QRect(50, 50, 100, 100) << qint64(50 * 50 + 16 * 50 * 50 + 100 * 20);
+    QTest::addRow("stacked") << QRect(0, 90, 120, 10) << qint64(100 * 10 + 16 * 45 * 10 + 120 * 10);
+    QTest::addRow("empty") << QRect(50, 50, 0, 10) << qint64(0);
+}
+
+void CoverageMapTest::testCoverage()
+{
+    CoverageMap map;
+    map.add(QRect(0, 0, 100, 100));
+    map.add(QRect(75, 75, 50, 50), 16);
+    map.add(QRect(-50, 90, 200, 20));
+    map.build();
+
+    QFETCH(QRect, rect);
+    QTEST(map.coverage(rect), "coverage");
+}
+
+void CoverageMapTest::testRandom()
+{
+    // The coverage has to be the same as if the overlap was computed for every window.
+    QRandomGenerator random(42);
+    for (int layout = 0; layout < 20; ++layout) {
+        const QVector<WeightedRect> windows = randomWindows(random, random.bounded(1, 40), QSize(1920, 1080));
+        CoverageMap map;
+        for (const WeightedRect &window : windows) {
+            map.add(window.rect, window.weight);
+        }
+        map.build();
+
+        for (int i = 0; i < 200; ++i) {
+            const QRect rect(random.bounded(-200, 2000), random.bounded(-200, 1200), random.bounded(1000), random.bounded(800));
+            QCOMPARE(map.coverage(rect), referenceCoverage(windows, rect));
+        }
+    }
+}
+
+void CoverageMapTest::benchmarkPlacementCandidates_data()
+{
+    QTest::addColumn<int>("windowCount");
+    QTest::addColumn<bool>("reference");
+
+    for (int windowCount : {10, 50, 200}) {
+        QTest::addRow("%d windows, reference", windowCount) << windowCount << true;
+        QTest::addRow("%d windows, coverage map", windowCount) << windowCount << false;
+    }
+}
+
+void CoverageMapTest::benchmarkPlacementCandidates()
+{
+    // Evaluates the positions smart placement would look at for a window on a crowded screen,
+    // that is, next to the edges of the other windows. Building the map is part of the cost.
+    QFETCH(int, windowCount);
+    QFETCH(bool, reference);
+
+    QRandomGenerator random(windowCount);
+    const QSize screenSize(1920, 1080);
+    const QSize windowSize(640, 480);
+    const QVector<WeightedRect> windows = randomWindows(random, windowCount, screenSize);
+
+    QVector<QRect> candidates;
+    for (const WeightedRect &row : windows) {
+        for (const WeightedRect &column : windows) {
+            const QRect candidate(QPoint(column.rect.x() + column.rect.width(), row.rect.y() + row.rect.height()), windowSize);
+            if (QRect(QPoint(0, 0), screenSize).contains(candidate)) {
+                candidates.append(candidate);
+            }
+        }
+    }
+
+    QVERIFY(!candidates.isEmpty());
+
+    qint64 total = 0;
+    QBENCHMARK {
+        total = 0;
+        if (reference) {
+            for (const QRect &candidate : std::as_const(candidates)) {
+                total += referenceCoverage(windows, candidate);
+            }
+        } else {
+            CoverageMap map;
+            for (const WeightedRect &window : windows) {
+                map.add(window.rect, window.weight);
+            }
+            map.build();
+            for (const QRect &candidate : std::as_const(candidates)) {
+                total += map.coverage(candidate);
+            }
+        }
+    }
+
+    // The coverage map has to add up to the same overlap as the reference it is timed against.
+    if (!reference) {
+        qint64 expected = 0;
+        for (const QRect &candidate : std::as_const(candidates)) {
+            expected += referenceCoverage(windows, candidate);
+        }
+        QCOMPARE(total, expected);
+    }
+}
+
+QTEST_GUILESS_MAIN(CoverageMapTest)
+#include "test_coveragemap.moc"
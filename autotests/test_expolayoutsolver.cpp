@@ -0,0 +1,168 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "effects/private/expolayoutsolver.h"
+
+#include <QRandomGenerator>
+#include <QtTest>
+
+class TestExpoLayoutSolver : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testEmpty();
+    void testNoOverlaps_data();
+    void testNoOverlaps();
+    void testStable();
+    void testIterationCap();
+    void benchmarkSolve_data();
+    void benchmarkSolve();
+};
+
+static const QRect s_area(0, 0, 1920, 1080);
+
+// Windows of typical sizes, scattered over a full HD screen like a busy desktop.
+static ExpoLayoutSolver::Input randomInput(int count, bool fillGaps)
+{
+    QRandomGenerator generator(42);
+
+    ExpoLayoutSolver::Input input;
+    input.area = s_area;
+    input.fillGaps = fillGaps;
+    for (int i = 0; i < count; ++i) {
+        const int width = generator.bounded(300, 1400);
+        const int height = generator.bounded(200, 900);
+        input.cells.push_back(ExpoLayoutSolver::Cell{
+            .naturalRect = QRect(generator.bounded(0, s_area.width() - width),
+                                 generator.bounded(0, s_area.height() - height),
+                                 width,
+                                 height),
+            .margins = QMargins(0, 0, 0, 20),
+        });
+    }
+    return input;
+}
+
+void TestExpoLayoutSolver::testEmpty()
+{
+    ExpoLayoutSolver::Input input;
+    input.area = s_area;
+
+    const ExpoLayoutSolver::Result result = ExpoLayoutSolver::solve(input);
+    QVERIFY(result.rects.empty());
+    QVERIFY(result.converged);
+    QCOMPARE(result.iterations, 0);
+}
+
+void TestExpoLayoutSolver::testNoOverlaps_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("fillGaps");
+
+    QTest::newRow("1") << 1 << false;
+    QTest::newRow("10") << 10 << false;
+    QTest::newRow("10, fill gaps") << 10 << true;
+    QTest::newRow("50") << 50 << false;
+    QTest::newRow("50, fill gaps") << 50 << true;
+}
+
+void TestExpoLayoutSolver::testNoOverlaps()
+{
+    // The cells must fit into the area without overlapping each other.
+    QFETCH(int, count);
+    QFETCH(bool, fillGaps);
+    const ExpoLayoutSolver::Input input = randomInput(count, fillGaps);
+
+    const ExpoLayoutSolver::Result result = ExpoLayoutSolver::solve(input);
+    QVERIFY(result.converged);
+    QCOMPARE(result.overlaps, 0);
+    QCOMPARE(result.rects.size(), size_t(count));
+    QVERIFY(result.scale > 0 && result.scale <= 1.0);
+    QVERIFY(result.coverage > 0 && result.coverage <= 1.0);
+
+    for (int i = 0; i < count; ++i) {
+        // Allow for rounding errors when the cells are scaled down.
+        const QRect rect = result.rects[i].adjusted(1, 1, -1, -1);
+        QVERIFY(!rect.isEmpty());
+        QVERIFY(s_area.adjusted(-1, -1, 1, 1).contains(result.rects[i]));
+        for (int j = i + 1; j < count; ++j) {
+            QVERIFY(!rect.intersects(result.rects[j].adjusted(1, 1, -1, -1)));
+        }
+    }
+}
+
+void TestExpoLayoutSolver::testStable()
+{
+    // The same input must always produce the same layout, so the windows don't jump around
+    // when the filter brings back a set of windows that has been laid out before.
+    const ExpoLayoutSolver::Input input = randomInput(30, true);
+
+    const ExpoLayoutSolver::Result first = ExpoLayoutSolver::solve(input);
+    const ExpoLayoutSolver::Result second = ExpoLayoutSolver::solve(input);
+    QCOMPARE(first.rects, second.rects);
+    QCOMPARE(first.iterations, second.iterations);
+}
+
+void TestExpoLayoutSolver::testIterationCap()
+{
+    // Windows that are stacked on top of each other can't be separated in a single pass.
+    ExpoLayoutSolver::Input input;
+    input.area = s_area;
+    input.maxIterations = 1;
+    for (int i = 0; i < 20; ++i) {
+        input.cells.push_back(ExpoLayoutSolver::Cell{
+            .naturalRect = QRect(100, 100, 800, 600),
+        });
+    }
+
+    const ExpoLayoutSolver::Result capped = ExpoLayoutSolver::solve(input);
+    QVERIFY(!capped.converged);
+    QCOMPARE(capped.iterations, 1);
+    QVERIFY(capped.overlaps > 0);
+    QCOMPARE(capped.rects.size(), input.cells.size());
+
+    input.maxIterations = 10000;
+    const ExpoLayoutSolver::Result solved = ExpoLayoutSolver::solve(input);
+    QVERIFY(solved.converged);
+    QVERIFY(solved.iterations > 1);
+    QCOMPARE(solved.overlaps, 0);
+}
+
+void TestExpoLayoutSolver::benchmarkSolve_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("fillGaps");
+
+    for (int count : {10, 50, 100, 250, 500}) {
+        QTest::addRow("%d", count) << count << false;
+        QTest::addRow("%d, fill gaps", count) << count << true;
+    }
+}
+
+void TestExpoLayoutSolver::benchmarkSolve()
+{
+    QFETCH(int, count);
+    QFETCH(bool, fillGaps);
+    const ExpoLayoutSolver::Input input = randomInput(count, fillGaps);
+
+    ExpoLayoutSolver::Result result;
+    QBENCHMARK {
+        result = ExpoLayoutSolver::solve(input);
+    }
+
+    QCOMPARE(int(result.rects.size()), count);
+    if (result.converged) {
+        QCOMPARE(result.overlaps, 0);
+    }
+    QVERIFY(result.scale > 0);
+    QVERIFY(result.coverage > 0);
+}
+
+QTEST_GUILESS_MAIN(TestExpoLayoutSolver)
+#include "test_expolayoutsolver.moc"
@@ -7,9 +7,13 @@
     SPDX-License-Identifier: LGPL-2.0-or-later
 */
 
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QObject>
 #include <QTemporaryFile>
 #include <QTest>
+#include <QThread>
 
 #include "ftrace.h"
 
@@ -21,7 +25,15 @@ public:
 private Q_SLOTS:
     void benchmarkTraceOff();
     void benchmarkTraceDurationOff();
+    void benchmarkTraceScopeOff();
     void enable();
+    void traceScope();
+    void chromeTrace();
+    void bufferOverflow();
+    void threadExit();
+    void benchmarkTraceScopeOn();
+    void format();
+    void disableInScope();
 
 private:
     QTemporaryFile m_tempFile;
@@ -50,6 +62,13 @@ void TestFTrace::benchmarkTraceDurationOff()
     }
 }
 
+void TestFTrace::benchmarkTraceScopeOff()
+{
+    QBENCHMARK {
+        fTraceScope("bench", "BENCH");
+    }
+}
+
 void TestFTrace::enable()
 {
     KWin::FTraceLogger::self()->setEnabled(true);
@@ -67,6 +86,198 @@ void TestFTrace::enable()
     QCOMPARE(m_tempFile.readLine(), "TEST_DURATIONboo end_ctx=1\n");
 }
 
+void TestFTrace::traceScope()
+{
+    QVERIFY(KWin::FTraceLogger::self()->isEnabled());
+    KWin::FTraceLogger::self()->takeChromeTrace();
+
+    {
+        fTraceScope("test", "TEST_SCOPE");
+        fTraceCounter("test", "TEST_COUNTER", 42);
+    }
+
+    QCOMPARE(m_tempFile.readLine(), "TEST_SCOPE begin_ctx=2\n");
+    QCOMPARE(m_tempFile.readLine(), "TEST_COUNTER value=42\n");
+    QCOMPARE(m_tempFile.readLine(), "TEST_SCOPE end_ctx=2\n");
+}
+
+void TestFTrace::chromeTrace()
+{
+    // This test verifies that the recorded events of all threads are exported in the
+    // Chrome/Perfetto JSON trace format.
+    QVERIFY(KWin::FTraceLogger::self()->isEnabled());
+    KWin::FTraceLogger::self()->takeChromeTrace();
+
+    {
+        fTraceScope("test", "Outer");
+        fTraceInstant("test", "Instant");
+        fTraceFlowBegin("test", "Flow", 7);
+    }
+
+    QThread *thread = QThread::create([]() {
+        fTraceFlowEnd("test", "Flow", 7);
+        fTraceCounter("test", "Counter", 3);
+    });
+    thread->setObjectName(QStringLiteral("worker"));
+    thread->start();
+    QVERIFY(thread->wait());
+    delete thread;
+
+    const QJsonDocument document = QJsonDocument::fromJson(KWin::FTraceLogger::self()->takeChromeTrace());
+    QVERIFY(document.isObject());
+    const QJsonArray events = document.object().value(QStringLiteral("traceEvents")).toArray();
+
+    QStringList phases;
+    QStringList threadNames;
+    int outerTid = -1;
+    for (const QJsonValue &value : events) {
+        const QJsonObject event = value.toObject();
+        const QString phase = event.value(QStringLiteral("ph")).toString();
+        if (phase == QLatin1String("M")) {
+            threadNames.append(event.value(QStringLiteral("args")).toObject().value(QStringLiteral("name")).toString());
+            continue;
+        }
+        phases.append(phase + event.value(QStringLiteral("name")).toString());
+        if (event.value(QStringLiteral("name")).toString() == QLatin1String("Outer")) {
+            outerTid = event.value(QStringLiteral("tid")).toInt();
+        }
+        if (phase == QLatin1String("C")) {
+            QCOMPARE(event.value(QStringLiteral("args")).toObject().value(QStringLiteral("value")).toInt(), 3);
+            QVERIFY(event.value(QStringLiteral("tid")).toInt() != outerTid);
+        }
+        if (phase == QLatin1String("s") || phase == QLatin1String("f")) {
+            QCOMPARE(event.value(QStringLiteral("id")).toInt(), 7);
+        }
+        QCOMPARE(event.value(QStringLiteral("cat")).toString(), QStringLiteral("test"));
+        QVERIFY(event.value(QStringLiteral("ts")).toDouble() > 0);
+    }
+
+    QCOMPARE(phases, (QStringList{QStringLiteral("BOuter"), QStringLiteral("iInstant"), QStringLiteral("sFlow"), QStringLiteral("EOuter"), QStringLiteral("fFlow"), QStringLiteral("CCounter")}));
+    QVERIFY(threadNames.contains(QStringLiteral("main")));
+    QVERIFY(threadNames.contains(QStringLiteral("worker")));
+
+    // The events have been taken out of the buffers, and the buffer of the finished thread has
+    // been released.
+    const QJsonDocument empty = QJsonDocument::fromJson(KWin::FTraceLogger::self()->takeChromeTrace());
+    for (const QJsonValue &value : empty.object().value(QStringLiteral("traceEvents")).toArray()) {
+        QCOMPARE(value.toObject().value(QStringLiteral("ph")).toString(), QStringLiteral("M"));
+        QVERIFY(value.toObject().value(QStringLiteral("args")).toObject().value(QStringLiteral("name")).toString() != QLatin1String("worker"));
+    }
+}
+
+void TestFTrace::bufferOverflow()
+{
+    // This test verifies that a full ring buffer overwrites the oldest events rather than
+    // dropping the new ones.
+    KWin::TraceBuffer buffer(5, 1, QByteArrayLiteral("test"));
+    QCOMPARE(buffer.capacity(), 8);
+
+    KWin::TraceEvent event{};
+    event.category = "test";
+    for (int i = 0; i < 10; ++i) {
+        event.value = i;
+        buffer.push(event);
+    }
+    QCOMPARE(buffer.droppedCount(), quint64(2));
+
+    std::vector<KWin::TraceEvent> events;
+    buffer.take(events);
+    QCOMPARE(events.size(), size_t(8));
+    QCOMPARE(events.front().value, qint64(2));
+    QCOMPARE(events.back().value, qint64(9));
+    QCOMPARE(buffer.droppedCount(), quint64(2));
+
+    event.value = 10;
+    buffer.push(event);
+    events.clear();
+    buffer.take(events);
+    QCOMPARE(events.size(), size_t(1));
+    QCOMPARE(events.front().value, qint64(10));
+    QCOMPARE(buffer.droppedCount(), quint64(2));
+}
+
+void TestFTrace::threadExit()
+{
+    // This test verifies that the buffers of finished threads are released once their events
+    // have been exported, and that only a few of them are kept until then.
+    QVERIFY(KWin::FTraceLogger::self()->isEnabled());
+    KWin::FTraceLogger::self()->takeChromeTrace();
+
+    for (int i = 0; i < 10; ++i) {
+        QThread *thread = QThread::create([]() {
+            fTraceInstant("test", "Exit");
+        });
+        thread->setObjectName(QStringLiteral("exit %1").arg(i));
+        thread->start();
+        QVERIFY(thread->wait());
+        delete thread;
+    }
+
+    auto threadNames = []() {
+        QStringList names;
+        const QJsonDocument document = QJsonDocument::fromJson(KWin::FTraceLogger::self()->takeChromeTrace());
+        for (const QJsonValue &value : document.object().value(QStringLiteral("traceEvents")).toArray()) {
+            const QJsonObject event = value.toObject();
+            if (event.value(QStringLiteral("ph")).toString() == QLatin1String("M")) {
+                names.append(event.value(QStringLiteral("args")).toObject().value(QStringLiteral("name")).toString());
+            }
+        }
+        return names;
+    };
+
+    const QStringList exported = threadNames();
+    QVERIFY(!exported.contains(QStringLiteral("exit 5")));
+    QVERIFY(exported.contains(QStringLiteral("exit 6")));
+    QVERIFY(exported.contains(QStringLiteral("exit 9")));
+    QVERIFY(KWin::FTraceLogger::self()->droppedEventCount() >= 6);
+
+    const QStringList released = threadNames();
+    QVERIFY(!released.contains(QStringLiteral("exit 9")));
+}
+
+void TestFTrace::benchmarkTraceScopeOn()
+{
+    QVERIFY(KWin::FTraceLogger::self()->isEnabled());
+    KWin::FTraceLogger::self()->takeChromeTrace();
+    QBENCHMARK {
+        fTraceScope("bench", "BENCH");
+    }
+}
+
+void TestFTrace::format()
+{
+    QCOMPARE(KWin::FTraceLogger::format("a", 1, QStringLiteral("b"), 2.5, 'c', -3, 4u), QByteArrayLiteral("a1b2.5c-34"));
+}
+
+void TestFTrace::disableInScope()
+{
+    // This test verifies that a scope started while tracing was enabled gets its end event, and
+    // that no markers are written once tracing has been disabled.
+    QVERIFY(KWin::FTraceLogger::self()->isEnabled());
+    KWin::FTraceLogger::self()->takeChromeTrace();
+    m_tempFile.readAll();
+
+    {
+        fTraceScope("test", "TEST_DISABLE");
+        KWin::FTraceLogger::self()->setEnabled(false);
+        fTraceInstant("test", "TEST_IGNORED");
+    }
+    QVERIFY(!KWin::FTraceLogger::self()->isEnabled());
+
+    QVERIFY(m_tempFile.readLine().startsWith("TEST_DISABLE begin_ctx="));
+    QVERIFY(m_tempFile.readAll().isEmpty());
+
+    QStringList phases;
+    const QJsonDocument document = QJsonDocument::fromJson(KWin::FTraceLogger::self()->takeChromeTrace());
+    for (const QJsonValue &value : document.object().value(QStringLiteral("traceEvents")).toArray()) {
+        const QJsonObject event = value.toObject();
+        if (event.value(QStringLiteral("ph")).toString() != QLatin1String("M")) {
+            phases.append(event.value(QStringLiteral("ph")).toString() + event.value(QStringLiteral("name")).toString());
+        }
+    }
+    QCOMPARE(phases, (QStringList{QStringLiteral("BTEST_DISABLE"), QStringLiteral("ETEST_DISABLE")}));
+}
+
 QTEST_MAIN(TestFTrace)
 
 #include "test_ftrace.moc"
@@ -0,0 +1,131 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "colors/colortransformationcache.h"
+#include "core/colortransformation.h"
+#include "platformsupport/scenes/qpainter/qpaintercolortransform.h"
+
+#include <QRandomGenerator>
+#include <QtTest>
+
+using namespace KWin;
+
+class TestQPainterColorTransform : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testIdentity();
+    void testMatchesTransformation();
+    void testOnlyRegion();
+    void benchmarkApply_data();
+    void benchmarkApply();
+};
+
+static QImage randomImage(const QSize &size)
+{
+    QImage image(size, QImage::Format_RGB32);
+    QRandomGenerator generator(42);
+    for (int y = 0; y < size.height(); ++y) {
+        uint32_t *row = reinterpret_cast<uint32_t *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            row[x] = 0xFF000000 | (generator.generate() & 0x00FFFFFF);
+        }
+    }
+    return image;
+}
+
+void TestQPainterColorTransform::testIdentity()
+{
+    QPainterColorTransform transform;
+    QVERIFY(transform.isIdentity());
+
+    ColorTransformationCache cache;
+    transform.setTransformation(cache.transformation(QString(), 6500, 100));
+    QVERIFY(transform.isIdentity());
+
+    transform.setTransformation(cache.transformation(QString(), 3000, 100));
+    QVERIFY(!transform.isIdentity());
+
+    transform.setTransformation(nullptr);
+    QVERIFY(transform.isIdentity());
+}
+
+void TestQPainterColorTransform::testMatchesTransformation()
+{
+    // This test verifies that every pixel gets the transformed value of its channels, no
+    // matter whether it was handled by the vectorized or the scalar part of a row.
+    ColorTransformationCache cache;
+    const auto transformation = cache.transformation(QString(), 2500, 80);
+    QPainterColorTransform transform;
+    transform.setTransformation(transformation);
+
+    const QImage source = randomImage(QSize(67, 13));
+    QImage target(source.size(), source.format());
+    transform.apply(source, &target, source.rect());
+
+    for (int y = 0; y < source.height(); ++y) {
+        for (int x = 0; x < source.width(); ++x) {
+            const QRgb in = source.pixel(x, y);
+            const auto [r, g, b] = transformation->transform(qRed(in) * 0x101, qGreen(in) * 0x101, qBlue(in) * 0x101);
+            const QRgb out = target.pixel(x, y);
+            QCOMPARE(qRed(out), int((r * 255u + 0x7FFF) / 0xFFFF));
+            QCOMPARE(qGreen(out), int((g * 255u + 0x7FFF) / 0xFFFF));
+            QCOMPARE(qBlue(out), int((b * 255u + 0x7FFF) / 0xFFFF));
+        }
+    }
+}
+
+void TestQPainterColorTransform::testOnlyRegion()
+{
+    // This test verifies that pixels outside of the region are left alone.
+    ColorTransformationCache cache;
+    QPainterColorTransform transform;
+    transform.setTransformation(cache.transformation(QString(), 1000, 100));
+
+    QImage image(QSize(64, 64), QImage::Format_RGB32);
+    image.fill(Qt::white);
+    transform.apply(image, &image, QRegion(10, 10, 20, 20));
+
+    QCOMPARE(image.pixel(5, 5), qRgb(255, 255, 255));
+    QCOMPARE(image.pixel(40, 40), qRgb(255, 255, 255));
+    QVERIFY(image.pixel(15, 15) != qRgb(255, 255, 255));
+    QCOMPARE(qRed(image.pixel(15, 15)), 255);
+}
+
+void TestQPainterColorTransform::benchmarkApply_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<qreal>("damagedFraction");
+
+    QTest::newRow("1080p, full frame") << QSize(1920, 1080) << 1.0;
+    QTest::newRow("4K, full frame") << QSize(3840, 2160) << 1.0;
+    QTest::newRow("4K, 10% damaged") << QSize(3840, 2160) << 0.1;
+    QTest::newRow("4K, 1% damaged") << QSize(3840, 2160) << 0.01;
+}
+
+void TestQPainterColorTransform::benchmarkApply()
+{
+    QFETCH(QSize, size);
+    QFETCH(qreal, damagedFraction);
+
+    ColorTransformationCache cache;
+    QPainterColorTransform transform;
+    transform.setTransformation(cache.transformation(QString(), 3400, 90));
+
+    const QImage source = randomImage(size);
+    QImage target(size, source.format());
+    const QRect damage(QPoint(0, 0), QSize(size.width(), std::max(1, int(size.height() * damagedFraction))));
+
+    QBENCHMARK {
+        transform.apply(source, &target, damage);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestQPainterColorTransform)
+#include "test_qpaintercolortransform.moc"
@@ -0,0 +1,143 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "effects/blur/softwareblur.h"
+
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QtTest>
+
+using namespace KWin;
+
+class TestSoftwareBlur : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testUniformColor();
+    void testOnlyRegionChanged();
+    void testNoSamplingOutside();
+    void testOpacity();
+    void benchmarkBlur_data();
+    void benchmarkBlur();
+};
+
+static QImage randomImage(const QSize &size)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    QRandomGenerator generator(42);
+    for (int y = 0; y < size.height(); ++y) {
+        uint32_t *row = reinterpret_cast<uint32_t *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            row[x] = 0xFF000000 | (generator.generate() & 0x00FFFFFF);
+        }
+    }
+    return image;
+}
+
+void TestSoftwareBlur::testUniformColor()
+{
+    // Blurring a single color must not change it, including at the edges of the image.
+    QImage image(QSize(100, 80), QImage::Format_ARGB32_Premultiplied);
+    image.fill(qRgb(10, 120, 250));
+
+    SoftwareBlur blur;
+    blur.setRadius(7);
+    blur.blur(&image, image.rect(), 1.0, true);
+
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            QCOMPARE(image.pixel(x, y), qRgb(10, 120, 250));
+        }
+    }
+}
+
+void TestSoftwareBlur::testOnlyRegionChanged()
+{
+    // This test verifies that only the pixels inside of the region are written.
+    const QImage original = randomImage(QSize(200, 200));
+    QImage image = original;
+
+    SoftwareBlur blur;
+    blur.setRadius(4);
+    const QRegion region = QRegion(20, 20, 50, 50) + QRegion(120, 130, 30, 10);
+    blur.blur(&image, region, 1.0, true);
+
+    int changed = 0;
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            if (image.pixel(x, y) != original.pixel(x, y)) {
+                QVERIFY(region.contains(QPoint(x, y)));
+                ++changed;
+            }
+        }
+    }
+    QVERIFY(changed > 0);
+}
+
+void TestSoftwareBlur::testNoSamplingOutside()
+{
+    // This test verifies that pixels outside of the region don't bleed in if sampling outside
+    // is disabled, which is used for panels.
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(qRgb(255, 0, 0));
+    const QRect panel(0, 80, 100, 20);
+    QPainter(&image).fillRect(panel, qRgb(0, 0, 255));
+
+    SoftwareBlur blur;
+    blur.setRadius(10);
+    blur.blur(&image, panel, 1.0, false);
+    QCOMPARE(image.pixel(50, 80), qRgb(0, 0, 255));
+
+    blur.blur(&image, panel, 1.0, true);
+    QVERIFY(qRed(image.pixel(50, 80)) > 0);
+}
+
+void TestSoftwareBlur::testOpacity()
+{
+    const QImage original = randomImage(QSize(64, 64));
+    QImage image = original;
+
+    SoftwareBlur blur;
+    blur.setRadius(3);
+    blur.blur(&image, image.rect(), 0.0, true);
+    QCOMPARE(image, original);
+}
+
+void TestSoftwareBlur::benchmarkBlur_data()
+{
+    QTest::addColumn<QSize>("outputSize");
+    QTest::addColumn<QRect>("blurRect");
+    QTest::addColumn<bool>("sampleOutside");
+
+    // The default blur strength on a scale 1 output, see BlurEffect::softwareBlurRadius().
+    QTest::newRow("1080p, panel") << QSize(1920, 1080) << QRect(0, 1036, 1920, 44) << false;
+    QTest::newRow("1080p, window") << QSize(1920, 1080) << QRect(460, 240, 1000, 600) << true;
+    QTest::newRow("1080p, full screen") << QSize(1920, 1080) << QRect(0, 0, 1920, 1080) << true;
+    QTest::newRow("4K, panel") << QSize(3840, 2160) << QRect(0, 2072, 3840, 88) << false;
+    QTest::newRow("4K, window") << QSize(3840, 2160) << QRect(920, 480, 2000, 1200) << true;
+    QTest::newRow("4K, full screen") << QSize(3840, 2160) << QRect(0, 0, 3840, 2160) << true;
+}
+
+void TestSoftwareBlur::benchmarkBlur()
+{
+    QFETCH(QSize, outputSize);
+    QFETCH(QRect, blurRect);
+    QFETCH(bool, sampleOutside);
+
+    QImage image = randomImage(outputSize);
+    SoftwareBlur blur;
+    blur.setRadius(outputSize.width() > 1920 ? 16 : 8);
+
+    QBENCHMARK {
+        blur.blur(&image, blurRect, 1.0, sampleOutside);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestSoftwareBlur)
+#include "test_softwareblur.moc"
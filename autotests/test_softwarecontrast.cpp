@@ -0,0 +1,149 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "effects/backgroundcontrast/softwarecontrast.h"
+
+#include <QRandomGenerator>
+#include <QVector4D>
+#include <QtTest>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace KWin;
+
+class TestSoftwareContrast : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testIdentity();
+    void testMatchesShader_data();
+    void testMatchesShader();
+    void testOnlyRegionChanged();
+};
+
+static QImage randomImage(const QSize &size, bool opaque)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    QRandomGenerator generator(42);
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            const int alpha = opaque ? 255 : generator.bounded(256);
+            image.setPixel(x, y, qPremultiply(qRgba(generator.bounded(256), generator.bounded(256), generator.bounded(256), alpha)));
+        }
+    }
+    return image;
+}
+
+// Builds the color matrix like ContrastEffect::colorMatrix() does, at full intensity.
+static QMatrix4x4 contrastMatrix(qreal contrast, qreal saturation)
+{
+    const qreal rval = (1.0 - saturation) * .2126;
+    const qreal gval = (1.0 - saturation) * .7152;
+    const qreal bval = (1.0 - saturation) * .0722;
+    const QMatrix4x4 satMatrix(rval + saturation, rval, rval, 0.0,
+                               gval, gval + saturation, gval, 0.0,
+                               bval, bval, bval + saturation, 0.0,
+                               0, 0, 0, 1.0);
+
+    const float transl = (1.0 - contrast) / 2.0;
+    const QMatrix4x4 contMatrix(contrast, 0, 0, 0.0,
+                                0, contrast, 0, 0.0,
+                                0, 0, contrast, 0.0,
+                                transl, transl, transl, 1.0);
+    return contMatrix * satMatrix;
+}
+
+void TestSoftwareContrast::testIdentity()
+{
+    // The identity matrix must not change any pixel.
+    const QImage original = randomImage(QSize(64, 48), false);
+    QImage image = original;
+
+    SoftwareContrast contrast;
+    contrast.setColorMatrix(QMatrix4x4(), 1.0);
+    contrast.apply(&image, image.rect());
+    QCOMPARE(image, original);
+}
+
+void TestSoftwareContrast::testMatchesShader_data()
+{
+    QTest::addColumn<qreal>("contrast");
+    QTest::addColumn<qreal>("saturation");
+    QTest::addColumn<qreal>("opacity");
+    QTest::addColumn<bool>("opaque");
+
+    QTest::newRow("opaque") << 0.45 << 1.7 << 1.0 << true;
+    QTest::newRow("translucent") << 0.45 << 1.7 << 1.0 << false;
+    QTest::newRow("high contrast") << 1.8 << 0.5 << 1.0 << false;
+    QTest::newRow("half opacity") << 0.45 << 1.7 << 0.5 << false;
+}
+
+void TestSoftwareContrast::testMatchesShader()
+{
+    // This test verifies that the pixels are transformed like the shader does it, as row
+    // vectors multiplied with the color matrix, and stay premultiplied.
+    QFETCH(qreal, contrast);
+    QFETCH(qreal, saturation);
+    QFETCH(qreal, opacity);
+    QFETCH(bool, opaque);
+
+    const QMatrix4x4 matrix = contrastMatrix(contrast, saturation);
+    const QMatrix4x4 blended = opacity >= 1.0 ? matrix : matrix * opacity + QMatrix4x4() * (1.0 - opacity);
+
+    const QImage original = randomImage(QSize(64, 48), opaque);
+    QImage image = opaque ? original.convertToFormat(QImage::Format_RGB32) : original;
+    SoftwareContrast softwareContrast;
+    softwareContrast.setColorMatrix(matrix, opacity);
+    softwareContrast.apply(&image, image.rect());
+
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            const QRgb pixel = original.pixel(x, y);
+            const QVector4D tex(qRed(pixel), qGreen(pixel), qBlue(pixel), qAlpha(pixel));
+            const QVector4D expected = tex * blended;
+            const int alpha = std::clamp(int(std::round(expected.w())), 0, 255);
+
+            const QRgb actual = image.pixel(x, y);
+            QVERIFY(qAbs(qAlpha(actual) - alpha) <= 1);
+            QVERIFY(qAbs(qRed(actual) - std::clamp(int(std::round(expected.x())), 0, alpha)) <= 1);
+            QVERIFY(qAbs(qGreen(actual) - std::clamp(int(std::round(expected.y())), 0, alpha)) <= 1);
+            QVERIFY(qAbs(qBlue(actual) - std::clamp(int(std::round(expected.z())), 0, alpha)) <= 1);
+            QVERIFY(qRed(actual) <= qAlpha(actual));
+            QVERIFY(qGreen(actual) <= qAlpha(actual));
+            QVERIFY(qBlue(actual) <= qAlpha(actual));
+        }
+    }
+}
+
+void TestSoftwareContrast::testOnlyRegionChanged()
+{
+    // This test verifies that only the pixels inside of the region are written.
+    const QImage original = randomImage(QSize(200, 200), true);
+    QImage image = original;
+
+    SoftwareContrast contrast;
+    contrast.setColorMatrix(contrastMatrix(0.45, 1.7), 1.0);
+    const QRegion region = QRegion(20, 20, 50, 50) + QRegion(120, 130, 30, 10) + QRegion(190, 190, 40, 40);
+    contrast.apply(&image, region);
+
+    int changed = 0;
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            if (image.pixel(x, y) != original.pixel(x, y)) {
+                QVERIFY(region.contains(QPoint(x, y)));
+                ++changed;
+            }
+        }
+    }
+    QVERIFY(changed > 0);
+}
+
+QTEST_MAIN(TestSoftwareContrast)
+#include "test_softwarecontrast.moc"
@@ -0,0 +1,131 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QBuffer>
+#include <QTest>
+
+#include "utils/workloadtrace.h"
+
+using namespace KWin;
+
+class TestWorkloadTrace : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void roundTrip();
+    void compact();
+    void invalidHeader();
+    void truncated();
+};
+
+static QVector<WorkloadEvent> readAll(QIODevice *device)
+{
+    QVector<WorkloadEvent> events;
+    WorkloadTraceReader reader(device);
+    while (const std::optional<WorkloadEvent> event = reader.read()) {
+        events.append(*event);
+    }
+    return events;
+}
+
+void TestWorkloadTrace::roundTrip()
+{
+    const QVector<WorkloadEvent> events{
+        {.type = WorkloadEvent::Type::Output, .timestamp = std::chrono::microseconds(0), .rect = QRect(-1280, 0, 1280, 1024)},
+        {.type = WorkloadEvent::Type::WindowAdded, .timestamp = std::chrono::microseconds(10), .surface = 3, .rect = QRect(-20, 40, 300, 200)},
+        {.type = WorkloadEvent::Type::SurfaceCommit, .timestamp = std::chrono::microseconds(15), .surface = 3, .rect = QRect(0, 0, 600, 400), .damage = QRegion(QRect(0, 0, 10, 10)) + QRect(50, 60, 70, 80)},
+        {.type = WorkloadEvent::Type::SurfaceCommit, .timestamp = std::chrono::microseconds(16), .surface = 3, .rect = QRect(0, 0, 600, 400)},
+        {.type = WorkloadEvent::Type::Frame, .timestamp = std::chrono::microseconds(16683)},
+        {.type = WorkloadEvent::Type::WindowGeometry, .timestamp = std::chrono::microseconds(20000), .surface = 3, .rect = QRect(0, 0, 320, 240)},
+        {.type = WorkloadEvent::Type::StackingOrder, .timestamp = std::chrono::microseconds(20000), .stacking = {7, 3, 1000000}},
+        {.type = WorkloadEvent::Type::PointerMotion, .timestamp = std::chrono::microseconds(20001), .position = QPointF(-10.5, 1023.25)},
+        {.type = WorkloadEvent::Type::PointerButton, .timestamp = std::chrono::microseconds(20002), .button = 0x110, .pressed = true},
+        {.type = WorkloadEvent::Type::PointerAxis, .timestamp = std::chrono::microseconds(20003), .position = QPointF(-15, 0), .button = 1},
+        {.type = WorkloadEvent::Type::Key, .timestamp = std::chrono::microseconds(20004), .pressed = false},
+        {.type = WorkloadEvent::Type::Effect, .timestamp = std::chrono::microseconds(3000000000), .pressed = true, .name = QStringLiteral("overview")},
+        {.type = WorkloadEvent::Type::WindowRemoved, .timestamp = std::chrono::microseconds(3000000001), .surface = 3},
+        {.type = WorkloadEvent::Type::SurfaceDestroyed, .timestamp = std::chrono::microseconds(3000000001), .surface = 3},
+    };
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    WorkloadTraceWriter writer(&buffer);
+    for (const WorkloadEvent &event : events) {
+        QVERIFY(writer.write(event));
+    }
+    buffer.close();
+
+    buffer.open(QIODevice::ReadOnly);
+    const QVector<WorkloadEvent> read = readAll(&buffer);
+    QCOMPARE(read.count(), events.count());
+    for (int i = 0; i < events.count(); ++i) {
+        QCOMPARE(read[i].type, events[i].type);
+        QCOMPARE(read[i].timestamp, events[i].timestamp);
+        QCOMPARE(read[i].surface, events[i].surface);
+        QCOMPARE(read[i].rect, events[i].rect);
+        QCOMPARE(read[i].damage, events[i].damage);
+        QCOMPARE(read[i].position, events[i].position);
+        QCOMPARE(read[i].button, events[i].button);
+        QCOMPARE(read[i].pressed, events[i].pressed);
+        QCOMPARE(read[i].stacking, events[i].stacking);
+        QCOMPARE(read[i].name, events[i].name);
+    }
+}
+
+void TestWorkloadTrace::compact()
+{
+    // A commit of a small damaged area should take a handful of bytes.
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    WorkloadTraceWriter writer(&buffer);
+    const qint64 headerSize = buffer.size();
+    QVERIFY(writer.write(WorkloadEvent{
+        .type = WorkloadEvent::Type::SurfaceCommit,
+        .timestamp = std::chrono::microseconds(1000),
+        .surface = 12,
+        .rect = QRect(0, 0, 1920, 1080),
+        .damage = QRect(10, 20, 30, 40),
+    }));
+    QVERIFY(buffer.size() - headerSize <= 16);
+}
+
+void TestWorkloadTrace::invalidHeader()
+{
+    QByteArray data = QByteArrayLiteral("NOTATRACE");
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    WorkloadTraceReader reader(&buffer);
+    QVERIFY(!reader.isValid());
+    QVERIFY(!reader.read().has_value());
+}
+
+void TestWorkloadTrace::truncated()
+{
+    // An event that is cut off ends the trace, the events before it can still be read.
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    WorkloadTraceWriter writer(&buffer);
+    QVERIFY(writer.write(WorkloadEvent{.type = WorkloadEvent::Type::Frame, .timestamp = std::chrono::microseconds(1)}));
+    QVERIFY(writer.write(WorkloadEvent{.type = WorkloadEvent::Type::StackingOrder, .timestamp = std::chrono::microseconds(2), .stacking = {1, 2, 3}}));
+    buffer.close();
+
+    QByteArray data = buffer.data();
+    data.chop(1);
+    QBuffer truncatedBuffer(&data);
+    truncatedBuffer.open(QIODevice::ReadOnly);
+    WorkloadTraceReader reader(&truncatedBuffer);
+    QVERIFY(reader.isValid());
+    QVERIFY(reader.read().has_value());
+    QVERIFY(!reader.read().has_value());
+    QVERIFY(!reader.isValid());
+}
+
+QTEST_GUILESS_MAIN(TestWorkloadTrace)
+#include "test_workloadtrace.moc"
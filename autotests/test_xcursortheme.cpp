@@ -0,0 +1,444 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "utils/xcursortheme.h"
+
+#include <QtEndian>
+#include <QtTest>
+
+#include <limits>
+
+using namespace KWin;
+
+// A large animated theme, like Breeze with animated busy cursors or the popular animated
+// themes that ship every cursor as an animation.
+static const int s_largeThemeShapeCount = 100;
+static const int s_largeThemeFrameCount = 16;
+static const QList<int> s_largeThemeSizes{24, 48};
+
+class TestXcursorTheme : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testLazyLoading();
+    void testInherits();
+    void testSymlinksShareSprites();
+    void testSharedBetweenThemes();
+    void testScale_data();
+    void testScale();
+    void testLimit();
+    void testIndexReloaded();
+    void testBrokenCursorFallsBack();
+    void testModifiedCursorReloaded();
+    void benchmarkLoadTheme();
+    void benchmarkStartup();
+    void benchmarkDecodeShape();
+
+private:
+    QTemporaryDir m_iconsDir;
+};
+
+static void appendUInt(QByteArray &data, quint32 value)
+{
+    value = qToLittleEndian(value);
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/**
+ * Writes an Xcursor file with @p frameCount frames for every nominal size in @p sizes.
+ */
+static bool writeCursor(const QString &filePath, const QList<int> &sizes, int frameCount)
+{
+    const quint32 fileHeaderLength = 16;
+    const quint32 tocEntryLength = 12;
+    const quint32 imageHeaderLength = 36;
+    const quint32 imageType = 0xfffd0002;
+
+    QByteArray data;
+    appendUInt(data, 0x72756358); // "Xcur"
+    appendUInt(data, fileHeaderLength);
+    appendUInt(data, 0x10000);
+    appendUInt(data, sizes.count() * frameCount);
+
+    quint32 position = fileHeaderLength + tocEntryLength * sizes.count() * frameCount;
+    for (int size : sizes) {
+        for (int frame = 0; frame < frameCount; ++frame) {
+            appendUInt(data, imageType);
+            appendUInt(data, size);
+            appendUInt(data, position);
+            position += imageHeaderLength + size * size * 4;
+        }
+    }
+
+    for (int size : sizes) {
+        for (int frame = 0; frame < frameCount; ++frame) {
+            appendUInt(data, imageHeaderLength);
+            appendUInt(data, imageType);
+            appendUInt(data, size);
+            appendUInt(data, 1);
+            appendUInt(data, size);
+            appendUInt(data, size);
+            appendUInt(data, size / 4);
+            appendUInt(data, size / 8);
+            appendUInt(data, 50);
+            const quint32 pixel = 0xff000000 | (frame * 16) << 16 | size;
+            for (int i = 0; i < size * size; ++i) {
+                appendUInt(data, pixel);
+            }
+        }
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return file.write(data) == data.size();
+}
+
+static bool writeTheme(const QString &themePath, const QStringList &inherits)
+{
+    if (!QDir().mkpath(themePath + QStringLiteral("/cursors"))) {
+        return false;
+    }
+    QFile index(themePath + QStringLiteral("/index.theme"));
+    if (!index.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    index.write("[Icon Theme]\n");
+    if (!inherits.isEmpty()) {
+        index.write("Inherits=" + inherits.join(QLatin1Char(',')).toUtf8() + "\n");
+    }
+    return true;
+}
+
+void TestXcursorTheme::initTestCase()
+{
+    QVERIFY(m_iconsDir.isValid());
+    qputenv("XCURSOR_PATH", QFile::encodeName(m_iconsDir.path()));
+
+    // "base" provides the fallback cursors.
+    const QString base = m_iconsDir.filePath(QStringLiteral("base"));
+    QVERIFY(writeTheme(base, {}));
+    QVERIFY(writeCursor(base + QStringLiteral("/cursors/left_ptr"), {24, 48}, 1));
+    QVERIFY(writeCursor(base + QStringLiteral("/cursors/text"), {24, 48}, 1));
+
+    // "derived" overrides one cursor and adds an animated one with an alias.
+    const QString derived = m_iconsDir.filePath(QStringLiteral("derived"));
+    QVERIFY(writeTheme(derived, {QStringLiteral("base")}));
+    QVERIFY(writeCursor(derived + QStringLiteral("/cursors/left_ptr"), {24, 48}, 1));
+    QVERIFY(writeCursor(derived + QStringLiteral("/cursors/wait"), {24, 48}, 8));
+    QVERIFY(QFile::link(QStringLiteral("wait"), derived + QStringLiteral("/cursors/watch")));
+
+    const QString large = m_iconsDir.filePath(QStringLiteral("large"));
+    QVERIFY(writeTheme(large, {}));
+    for (int i = 0; i < s_largeThemeShapeCount; ++i) {
+        QVERIFY(writeCursor(large + QStringLiteral("/cursors/shape%1").arg(i), s_largeThemeSizes, s_largeThemeFrameCount));
+    }
+}
+
+void TestXcursorTheme::init()
+{
+    KXcursorSpriteCache::self()->clear();
+    KXcursorSpriteCache::self()->setLimit(KXcursorSpriteCache().limit());
+}
+
+void TestXcursorTheme::testLazyLoading()
+{
+    // This test verifies that loading a theme doesn't decode any cursor, and that every cursor
+    // is decoded once, when it is used for the first time.
+    KXcursorSpriteCache *cache = KXcursorSpriteCache::self();
+    const auto before = cache->statistics();
+
+    const KXcursorTheme theme(QStringLiteral("large"), 24, 1);
+    QVERIFY(!theme.isEmpty());
+    QCOMPARE(cache->count(), 0);
+    QCOMPARE(cache->statistics().misses, before.misses);
+
+    const QVector<KXcursorSprite> sprites = theme.shape(QByteArrayLiteral("shape0"));
+    QCOMPARE(sprites.count(), s_largeThemeFrameCount);
+    QCOMPARE(sprites.first().data().size(), QSize(24, 24));
+    QCOMPARE(sprites.first().hotspot(), QPoint(6, 3));
+    QCOMPARE(sprites.first().delay(), std::chrono::milliseconds(50));
+    QCOMPARE(cache->count(), 1);
+    QCOMPARE(cache->statistics().misses, before.misses + 1);
+
+    QCOMPARE(theme.shape(QByteArrayLiteral("shape0")).count(), s_largeThemeFrameCount);
+    QCOMPARE(cache->count(), 1);
+    QCOMPARE(cache->statistics().misses, before.misses + 1);
+    QCOMPARE(cache->statistics().hits, before.hits + 1);
+
+    QVERIFY(theme.shape(QByteArrayLiteral("does_not_exist")).isEmpty());
+    QCOMPARE(cache->count(), 1);
+
+    QVERIFY(KXcursorTheme(QStringLiteral("does_not_exist"), 24, 1).isEmpty());
+}
+
+void TestXcursorTheme::testInherits()
+{
+    // This test verifies that cursors of a theme take precedence over the cursors of the
+    // themes it inherits from.
+    const KXcursorTheme theme(QStringLiteral("derived"), 24, 1);
+    const KXcursorTheme base(QStringLiteral("base"), 24, 1);
+
+    const QVector<KXcursorSprite> leftPtr = theme.shape(QByteArrayLiteral("left_ptr"));
+    const QVector<KXcursorSprite> baseLeftPtr = base.shape(QByteArrayLiteral("left_ptr"));
+    QCOMPARE(leftPtr.count(), 1);
+    QCOMPARE(baseLeftPtr.count(), 1);
+    QVERIFY(leftPtr.first().data().cacheKey() != baseLeftPtr.first().data().cacheKey());
+
+    const QVector<KXcursorSprite> text = theme.shape(QByteArrayLiteral("text"));
+    QCOMPARE(text.count(), 1);
+    QCOMPARE(text.first().data().cacheKey(), base.shape(QByteArrayLiteral("text")).first().data().cacheKey());
+
+    QCOMPARE(theme.shape(QByteArrayLiteral("wait")).count(), 8);
+    QVERIFY(base.shape(QByteArrayLiteral("wait")).isEmpty());
+}
+
+void TestXcursorTheme::testSymlinksShareSprites()
+{
+    // This test verifies that a cursor and its aliases are decoded only once.
+    KXcursorSpriteCache *cache = KXcursorSpriteCache::self();
+    const KXcursorTheme theme(QStringLiteral("derived"), 24, 1);
+
+    const QVector<KXcursorSprite> wait = theme.shape(QByteArrayLiteral("wait"));
+    const QVector<KXcursorSprite> watch = theme.shape(QByteArrayLiteral("watch"));
+    QCOMPARE(wait.count(), 8);
+    QCOMPARE(watch.count(), 8);
+    QCOMPARE(cache->count(), 1);
+    for (int i = 0; i < wait.count(); ++i) {
+        QCOMPARE(wait[i].data().cacheKey(), watch[i].data().cacheKey());
+    }
+}
+
+void TestXcursorTheme::testSharedBetweenThemes()
+{
+    // This test verifies that themes loaded again, e.g. after an output has been added, reuse
+    // the sprites decoded for the previous theme.
+    KXcursorSpriteCache *cache = KXcursorSpriteCache::self();
+
+    qint64 imageKey;
+    {
+        const KXcursorTheme theme(QStringLiteral("large"), 24, 1);
+        imageKey = theme.shape(QByteArrayLiteral("shape1")).first().data().cacheKey();
+    }
+
+    const auto before = cache->statistics();
+    const KXcursorTheme theme(QStringLiteral("large"), 24, 1);
+    QCOMPARE(theme.shape(QByteArrayLiteral("shape1")).first().data().cacheKey(), imageKey);
+    QCOMPARE(cache->statistics().misses, before.misses);
+
+    // Another scale factor needs other sprites, but both stay in the cache.
+    const KXcursorTheme hidpiTheme(QStringLiteral("large"), 24, 2);
+    QVERIFY(hidpiTheme.shape(QByteArrayLiteral("shape1")).first().data().cacheKey() != imageKey);
+    QCOMPARE(cache->count(), 2);
+}
+
+void TestXcursorTheme::testScale_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<qreal>("devicePixelRatio");
+    QTest::addColumn<QSize>("expectedSize");
+    QTest::addColumn<qreal>("expectedDevicePixelRatio");
+
+    QTest::newRow("24@1") << 24 << qreal(1) << QSize(24, 24) << qreal(1);
+    QTest::newRow("24@2") << 24 << qreal(2) << QSize(48, 48) << qreal(2);
+    QTest::newRow("48@1") << 48 << qreal(1) << QSize(48, 48) << qreal(1);
+    QTest::newRow("24@1.75") << 24 << qreal(1.75) << QSize(48, 48) << qreal(2);
+}
+
+void TestXcursorTheme::testScale()
+{
+    // This test verifies that the sprites that best match the scaled size are picked.
+    QFETCH(int, size);
+    QFETCH(qreal, devicePixelRatio);
+
+    const KXcursorTheme theme(QStringLiteral("derived"), size, devicePixelRatio);
+    const QVector<KXcursorSprite> sprites = theme.shape(QByteArrayLiteral("left_ptr"));
+    QCOMPARE(sprites.count(), 1);
+    QTEST(sprites.first().data().size(), "expectedSize");
+    QTEST(sprites.first().data().devicePixelRatio(), "expectedDevicePixelRatio");
+}
+
+void TestXcursorTheme::testLimit()
+{
+    // This test verifies that the least recently used sprites are dropped once the cache is full.
+    KXcursorSpriteCache *cache = KXcursorSpriteCache::self();
+    const qint64 shapeSize = qint64(48) * 48 * 4 * s_largeThemeFrameCount;
+    cache->setLimit(10 * shapeSize);
+
+    const KXcursorTheme theme(QStringLiteral("large"), 24, 2);
+    for (int i = 0; i < 20; ++i) {
+        QCOMPARE(theme.shape(QByteArrayLiteral("shape") + QByteArray::number(i)).count(), s_largeThemeFrameCount);
+        QVERIFY(cache->statistics().size <= cache->limit());
+    }
+    QCOMPARE(cache->count(), 10);
+    QCOMPARE(cache->statistics().size, 10 * shapeSize);
+
+    // shape19 is the most recent one, shape0 was evicted first.
+    auto before = cache->statistics();
+    theme.shape(QByteArrayLiteral("shape19"));
+    QCOMPARE(cache->statistics().hits, before.hits + 1);
+
+    before = cache->statistics();
+    theme.shape(QByteArrayLiteral("shape0"));
+    QCOMPARE(cache->statistics().misses, before.misses + 1);
+    QCOMPARE(cache->statistics().evictions, before.evictions + 1);
+
+    cache->setLimit(2 * shapeSize);
+    QCOMPARE(cache->count(), 2);
+}
+
+void TestXcursorTheme::testIndexReloaded()
+{
+    // This test verifies that cursors added to a theme are found once the theme is loaded again.
+    const QString filePath = m_iconsDir.filePath(QStringLiteral("base/cursors/pointer"));
+    {
+        const KXcursorTheme theme(QStringLiteral("base"), 24, 1);
+        QVERIFY(theme.shape(QByteArrayLiteral("pointer")).isEmpty());
+    }
+
+    QVERIFY(writeCursor(filePath, {24}, 1));
+    const KXcursorTheme theme(QStringLiteral("base"), 24, 1);
+    QCOMPARE(theme.shape(QByteArrayLiteral("pointer")).count(), 1);
+    QVERIFY(QFile::remove(filePath));
+}
+
+void TestXcursorTheme::testBrokenCursorFallsBack()
+{
+    // This test verifies that a cursor that fails to decode doesn't shadow the cursor with the
+    // same name in an inherited theme.
+    const QString filePath = m_iconsDir.filePath(QStringLiteral("derived/cursors/text"));
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QVERIFY(file.write("not a cursor") > 0);
+    file.close();
+
+    const KXcursorTheme theme(QStringLiteral("derived"), 24, 1);
+    const KXcursorTheme base(QStringLiteral("base"), 24, 1);
+    const QVector<KXcursorSprite> text = theme.shape(QByteArrayLiteral("text"));
+    QCOMPARE(text.count(), 1);
+    QCOMPARE(text.first().data().cacheKey(), base.shape(QByteArrayLiteral("text")).first().data().cacheKey());
+
+    // The broken file is not cached, it decodes once it has been fixed.
+    KXcursorSpriteCache *cache = KXcursorSpriteCache::self();
+    QCOMPARE(cache->count(), 1);
+    QVERIFY(writeCursor(filePath, {24}, 2));
+    QCOMPARE(theme.shape(QByteArrayLiteral("text")).count(), 2);
+    QCOMPARE(cache->count(), 2);
+    QVERIFY(QFile::remove(filePath));
+}
+
+void TestXcursorTheme::testModifiedCursorReloaded()
+{
+    // This test verifies that cached sprites are dropped if their file has been modified or
+    // replaced, e.g. by an update of the theme.
+    const QString filePath = m_iconsDir.filePath(QStringLiteral("base/cursors/crosshair"));
+    QVERIFY(writeCursor(filePath, {24}, 1));
+
+    KXcursorSpriteCache *cache = KXcursorSpriteCache::self();
+    const auto before = cache->statistics();
+    const KXcursorTheme theme(QStringLiteral("base"), 24, 1);
+    QCOMPARE(theme.shape(QByteArrayLiteral("crosshair")).count(), 1);
+    QCOMPARE(theme.shape(QByteArrayLiteral("crosshair")).count(), 1);
+    QCOMPARE(cache->statistics().misses, before.misses + 1);
+
+    // Modified in place.
+    QVERIFY(writeCursor(filePath, {24}, 3));
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(10), QFileDevice::FileModificationTime));
+    file.close();
+    QCOMPARE(theme.shape(QByteArrayLiteral("crosshair")).count(), 3);
+    QCOMPARE(cache->count(), 1);
+
+    // Replaced by another file.
+    const QString replacement = filePath + QStringLiteral(".new");
+    QVERIFY(writeCursor(replacement, {24}, 2));
+    QVERIFY(QFile::remove(filePath));
+    QVERIFY(QFile::rename(replacement, filePath));
+    QCOMPARE(theme.shape(QByteArrayLiteral("crosshair")).count(), 2);
+    QCOMPARE(cache->count(), 1);
+    QCOMPARE(cache->statistics().size, qint64(24) * 24 * 4 * 2);
+
+    // Removed.
+    QVERIFY(QFile::remove(filePath));
+    QVERIFY(theme.shape(QByteArrayLiteral("crosshair")).isEmpty());
+    QCOMPARE(cache->count(), 0);
+    QCOMPARE(cache->statistics().size, 0);
+}
+
+void TestXcursorTheme::benchmarkLoadTheme()
+{
+    // Loading a theme only lists its cursor files. Decoding all of them up front used to be
+    // the cost of every theme change and every output scale change.
+    QBENCHMARK {
+        const KXcursorTheme theme(QStringLiteral("large"), 24, 2);
+    }
+
+    // Nothing has been decoded, eagerly loading the theme would have decoded every shape.
+    KXcursorSpriteCache *cache = KXcursorSpriteCache::self();
+    QCOMPARE(cache->count(), 0);
+    const KXcursorTheme theme(QStringLiteral("large"), 24, 2);
+    cache->setLimit(std::numeric_limits<qint64>::max());
+    for (int i = 0; i < s_largeThemeShapeCount; ++i) {
+        theme.shape(QByteArrayLiteral("shape") + QByteArray::number(i));
+    }
+    QCOMPARE(cache->statistics().size, qint64(48) * 48 * 4 * s_largeThemeFrameCount * s_largeThemeShapeCount);
+}
+
+void TestXcursorTheme::benchmarkStartup()
+{
+    // Startup loads the theme and decodes the default cursor. Eagerly loading the theme, as it
+    // used to be done, decoded every cursor of the theme at that point.
+    KXcursorSpriteCache *cache = KXcursorSpriteCache::self();
+    cache->setLimit(std::numeric_limits<qint64>::max());
+    const qint64 shapeSize = qint64(48) * 48 * 4 * s_largeThemeFrameCount;
+
+    QElapsedTimer timer;
+    timer.start();
+    {
+        const KXcursorTheme theme(QStringLiteral("large"), 24, 2);
+        QCOMPARE(theme.shape(QByteArrayLiteral("shape0")).count(), s_largeThemeFrameCount);
+    }
+    const qint64 lazyTime = timer.nsecsElapsed();
+    const qint64 lazySize = cache->statistics().size;
+
+    cache->clear();
+    timer.restart();
+    {
+        const KXcursorTheme theme(QStringLiteral("large"), 24, 2);
+        for (int i = 0; i < s_largeThemeShapeCount; ++i) {
+            QCOMPARE(theme.shape(QByteArrayLiteral("shape") + QByteArray::number(i)).count(), s_largeThemeFrameCount);
+        }
+    }
+    const qint64 eagerTime = timer.nsecsElapsed();
+    const qint64 eagerSize = cache->statistics().size;
+
+    QCOMPARE(lazySize, shapeSize);
+    QCOMPARE(eagerSize, shapeSize * s_largeThemeShapeCount);
+    QVERIFY2(lazyTime < eagerTime, qPrintable(QStringLiteral("lazy: %1 ns, eager: %2 ns").arg(lazyTime).arg(eagerTime)));
+    QTest::setBenchmarkResult(lazyTime / 1000000.0, QTest::WalltimeMilliseconds);
+}
+
+void TestXcursorTheme::benchmarkDecodeShape()
+{
+    const KXcursorTheme theme(QStringLiteral("large"), 24, 2);
+    KXcursorSpriteCache *cache = KXcursorSpriteCache::self();
+
+    QBENCHMARK {
+        cache->clear();
+        theme.shape(QByteArrayLiteral("shape0"));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestXcursorTheme)
+#include "test_xcursortheme.moc"
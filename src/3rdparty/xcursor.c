@@ -592,3 +592,79 @@ XcursorFileLoadImages (const char *file, int size)
 
     return images;
 }
+
+typedef struct _XcursorMemoryFile {
+    const unsigned char	*data;
+    long		length;
+    long		position;
+} XcursorMemoryFile;
+
+static int
+_XcursorMemoryFileRead (XcursorFile *file, unsigned char *buf, int len)
+{
+    XcursorMemoryFile	*m = file->closure;
+    long		available = m->length - m->position;
+
+    if (len > available)
+	len = available;
+    if (len <= 0)
+	return 0;
+    memcpy (buf, m->data + m->position, len);
+    m->position += len;
+    return len;
+}
+
+static int
+_XcursorMemoryFileWrite (XcursorFile *file, unsigned char *buf, int len)
+{
+    (void) file;
+    (void) buf;
+    (void) len;
+    return EOF;
+}
+
+static int
+_XcursorMemoryFileSeek (XcursorFile *file, long offset, int whence)
+{
+    XcursorMemoryFile	*m = file->closure;
+    long		position;
+
+    switch (whence) {
+    case SEEK_SET:
+	position = offset;
+	break;
+    case SEEK_CUR:
+	position = m->position + offset;
+	break;
+    case SEEK_END:
+	position = m->length + offset;
+	break;
+    default:
+	return EOF;
+    }
+    if (position < 0 || position > m->length)
+	return EOF;
+    m->position = position;
+    return 0;
+}
+
+XcursorImages *
+XcursorMemoryLoadImages (const unsigned char *data, long length, int size)
+{
+    XcursorMemoryFile	m;
+    XcursorFile		f;
+
+    if (!data || length <= 0)
+	return NULL;
+
+    m.data = data;
+    m.length = length;
+    m.position = 0;
+
+    f.closure = &m;
+    f.read = _XcursorMemoryFileRead;
+    f.write = _XcursorMemoryFileWrite;
+    f.seek = _XcursorMemoryFileSeek;
+
+    return XcursorXcFileLoadImages (&f, size);
+}
@@ -60,6 +60,13 @@ typedef struct _XcursorImages {
 XcursorImages *
 XcursorFileLoadImages (const char *file, int size);
 
+/*
+ * Loads the images of the given nominal size from an Xcursor file that has
+ * already been read or mapped into memory.
+ */
+XcursorImages *
+XcursorMemoryLoadImages (const unsigned char *data, long length, int size);
+
 void
 XcursorImagesDestroy (XcursorImages *images);
 
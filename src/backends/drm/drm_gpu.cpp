@@ -23,6 +23,7 @@
 #include "drm_pipeline.h"
 #include "drm_plane.h"
 #include "drm_virtual_output.h"
+#include "ftrace.h"
 #include "gbm_dmabuf.h"
 // system
 #include <algorithm>
@@ -561,6 +562,8 @@ void DrmGpu::pageFlipHandler(int fd, unsigned int sequence, unsigned int sec, un
     if (it == pipelines.end()) {
         qCWarning(KWIN_DRM, "received invalid page flip event for crtc %u", crtc_id);
     } else {
+        fTraceFlowEnd("drm", "pageFlip", crtc_id);
+        fTraceScope("drm", "pageFlipped");
         (*it)->pageFlipped(timestamp);
     }
 }
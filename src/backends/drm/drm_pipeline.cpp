@@ -12,6 +12,7 @@
 #include <errno.h>
 
 #include "core/session.h"
+#include "ftrace.h"
 #include "drm_backend.h"
 #include "drm_buffer.h"
 #include "drm_buffer_gbm.h"
@@ -86,6 +87,7 @@ bool DrmPipeline::maybeModeset()
 
 DrmPipeline::Error DrmPipeline::commitPipelines(const QVector<DrmPipeline *> &pipelines, CommitMode mode, const QVector<DrmObject *> &unusedObjects)
 {
+    fTraceScope("drm", "commitPipelines");
     Q_ASSERT(!pipelines.isEmpty());
     if (pipelines[0]->gpu()->atomicModeSetting()) {
         return commitPipelinesAtomic(pipelines, mode, unusedObjects);
@@ -211,6 +213,11 @@ DrmPipeline::Error DrmPipeline::commitPipelinesAtomic(const QVector<DrmPipeline
             failed();
             return errnoToError();
         }
+        for (const auto &pipeline : pipelines) {
+            if (pipeline->m_pending.crtc) {
+                fTraceFlowBegin("drm", "pageFlip", pipeline->m_pending.crtc->id());
+            }
+        }
         std::for_each(pipelines.begin(), pipelines.end(), std::mem_fn(&DrmPipeline::atomicCommitSuccessful));
         Q_ASSERT(unusedObjects.isEmpty());
         return Error::None;
@@ -14,6 +14,7 @@
 #include "drm_layer.h"
 #include "drm_logging.h"
 #include "drm_pipeline.h"
+#include "ftrace.h"
 
 #include <errno.h>
 #include <gbm.h>
@@ -39,6 +40,7 @@ DrmPipeline::Error DrmPipeline::presentLegacy()
         return errnoToError();
     }
     m_pageflipPending = true;
+    fTraceFlowBegin("drm", "pageFlip", m_pending.crtc->id());
     m_pending.crtc->setNext(buffer);
     return Error::None;
 }
@@ -44,6 +44,29 @@ SoftwareVsyncMonitor *VirtualOutput::vsyncMonitor() const
     return m_vsyncMonitor.get();
 }
 
+bool VirtualOutput::setGammaRamp(const std::shared_ptr<ColorTransformation> &transformation)
+{
+    if (!m_softwareColorTransformation) {
+        return false;
+    }
+    m_colorTransformation = transformation;
+    m_renderLoop->scheduleRepaint();
+    return true;
+}
+
+std::shared_ptr<ColorTransformation> VirtualOutput::colorTransformation() const
+{
+    return m_colorTransformation;
+}
+
+void VirtualOutput::setSoftwareColorTransformation(bool supported)
+{
+    m_softwareColorTransformation = supported;
+    if (!supported) {
+        m_colorTransformation.reset();
+    }
+}
+
 void VirtualOutput::init(const QPoint &logicalPosition, const QSize &pixelSize, qreal scale)
 {
     const int refreshRate = 60000; // TODO: Make the refresh rate configurable.
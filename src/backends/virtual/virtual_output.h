@@ -30,6 +30,17 @@ public:
     RenderLoop *renderLoop() const override;
     SoftwareVsyncMonitor *vsyncMonitor() const;
 
+    /**
+     * Accepts the @a transformation only if the render backend applies it in software, which
+     * only the QPainter backend does.
+     */
+    bool setGammaRamp(const std::shared_ptr<ColorTransformation> &transformation) override;
+    /**
+     * Returns the color transformation the render backend should apply in software.
+     */
+    std::shared_ptr<ColorTransformation> colorTransformation() const;
+    void setSoftwareColorTransformation(bool supported);
+
     void init(const QPoint &logicalPosition, const QSize &pixelSize, qreal scale);
     void updateEnabled(bool enabled);
 
@@ -42,6 +53,8 @@ private:
     VirtualBackend *m_backend;
     std::unique_ptr<RenderLoop> m_renderLoop;
     std::unique_ptr<SoftwareVsyncMonitor> m_vsyncMonitor;
+    std::shared_ptr<ColorTransformation> m_colorTransformation;
+    bool m_softwareColorTransformation = false;
     int m_gammaSize = 200;
     bool m_gammaResult = true;
     int m_identifier;
@@ -21,6 +21,12 @@ VirtualQPainterLayer::VirtualQPainterLayer(Output *output)
     , m_image(output->pixelSize(), QImage::Format_RGB32)
 {
     m_image.fill(Qt::black);
+    static_cast<VirtualOutput *>(m_output)->setSoftwareColorTransformation(true);
+}
+
+VirtualQPainterLayer::~VirtualQPainterLayer()
+{
+    static_cast<VirtualOutput *>(m_output)->setSoftwareColorTransformation(false);
 }
 
 std::optional<OutputLayerBeginFrameInfo> VirtualQPainterLayer::beginFrame()
@@ -33,12 +39,44 @@ std::optional<OutputLayerBeginFrameInfo> VirtualQPainterLayer::beginFrame()
 
 bool VirtualQPainterLayer::endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
+    applyColorTransformation(damagedRegion);
     return true;
 }
 
+void VirtualQPainterLayer::applyColorTransformation(const QRegion &damagedRegion)
+{
+    const auto transformation = static_cast<VirtualOutput *>(m_output)->colorTransformation();
+    bool fullUpdate = false;
+    if (m_colorTransform.transformation() != transformation) {
+        m_colorTransform.setTransformation(transformation);
+        fullUpdate = true;
+    }
+    if (m_colorTransform.isIdentity()) {
+        m_colorTransformedImage = QImage();
+        return;
+    }
+    if (m_colorTransformedImage.size() != m_image.size()) {
+        m_colorTransformedImage = QImage(m_image.size(), m_image.format());
+        fullUpdate = true;
+    }
+
+    // The rendered image is kept untransformed, so only the pixels that actually changed
+    // need to go through the lookup tables again.
+    QRegion deviceRegion;
+    if (fullUpdate) {
+        deviceRegion = m_image.rect();
+    } else {
+        const qreal scale = m_output->scale();
+        for (const QRect &rect : damagedRegion) {
+            deviceRegion += QRectF(QPointF(rect.topLeft()) * scale, QSizeF(rect.size()) * scale).toAlignedRect();
+        }
+    }
+    m_colorTransform.apply(m_image, &m_colorTransformedImage, deviceRegion);
+}
+
 QImage *VirtualQPainterLayer::image()
 {
-    return &m_image;
+    return m_colorTransformedImage.isNull() ? &m_image : &m_colorTransformedImage;
 }
 
 VirtualQPainterBackend::VirtualQPainterBackend(VirtualBackend *backend)
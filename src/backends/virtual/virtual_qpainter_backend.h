@@ -10,6 +10,7 @@
 
 #include "core/outputlayer.h"
 #include "qpainterbackend.h"
+#include "qpaintercolortransform.h"
 
 #include <QMap>
 #include <QObject>
@@ -25,14 +26,23 @@ class VirtualQPainterLayer : public OutputLayer
 {
 public:
     VirtualQPainterLayer(Output *output);
+    ~VirtualQPainterLayer() override;
 
     std::optional<OutputLayerBeginFrameInfo> beginFrame() override;
     bool endFrame(const QRegion &renderedRegion, const QRegion &damagedRegion) override;
+    /**
+     * Returns the image as it would be presented, with the color transformation of the output
+     * applied to it.
+     */
     QImage *image();
 
 private:
+    void applyColorTransformation(const QRegion &damagedRegion);
+
     Output *const m_output;
     QImage m_image;
+    QImage m_colorTransformedImage;
+    QPainterColorTransform m_colorTransform;
 };
 
 class VirtualQPainterBackend : public QPainterBackend
@@ -16,6 +16,7 @@ namespace KWin
 
 class Output;
 class ColorDevicePrivate;
+class ColorTransformationCache;
 
 /**
  * The ColorDevice class represents a color managed device.
@@ -25,7 +26,11 @@ class KWIN_EXPORT ColorDevice : public QObject
     Q_OBJECT
 
 public:
-    explicit ColorDevice(Output *output, QObject *parent = nullptr);
+    /**
+     * Creates a color device for @a output. The color transformations are taken from @a cache,
+     * which must outlive the device.
+     */
+    ColorDevice(Output *output, ColorTransformationCache *cache, QObject *parent = nullptr);
     ~ColorDevice() override;
 
     /**
@@ -6,6 +6,7 @@
 
 #include "colormanager.h"
 #include "colordevice.h"
+#include "colortransformationcache.h"
 #include "core/output.h"
 #include "core/session.h"
 #include "main.h"
@@ -18,6 +19,7 @@ namespace KWin
 class ColorManagerPrivate
 {
 public:
+    ColorTransformationCache transformationCache;
     QVector<ColorDevice *> devices;
 };
 
@@ -41,6 +43,11 @@ QVector<ColorDevice *> ColorManager::devices() const
     return d->devices;
 }
 
+ColorTransformationCache *ColorManager::transformationCache() const
+{
+    return &d->transformationCache;
+}
+
 ColorDevice *ColorManager::findDevice(Output *output) const
 {
     auto it = std::find_if(d->devices.begin(), d->devices.end(), [&output](ColorDevice *device) {
@@ -54,7 +61,7 @@ ColorDevice *ColorManager::findDevice(Output *output) const
 
 void ColorManager::handleOutputAdded(Output *output)
 {
-    ColorDevice *device = new ColorDevice(output, this);
+    ColorDevice *device = new ColorDevice(output, &d->transformationCache, this);
     d->devices.append(device);
     Q_EMIT deviceAdded(device);
 }
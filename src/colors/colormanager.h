@@ -16,6 +16,7 @@ namespace KWin
 
 class Output;
 class ColorDevice;
+class ColorTransformationCache;
 class ColorManagerPrivate;
 
 /**
@@ -40,6 +41,11 @@ public:
      */
     QVector<ColorDevice *> devices() const;
 
+    /**
+     * Returns the cache of color transformations shared by all color devices.
+     */
+    ColorTransformationCache *transformationCache() const;
+
 Q_SIGNALS:
     /**
      * This signal is emitted when a new color device @a device has been added.
@@ -0,0 +1,224 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "colortransformationcache.h"
+#include "core/colorpipelinestage.h"
+#include "core/colortransformation.h"
+#include "utils/common.h"
+
+#include "3rdparty/colortemperature.h"
+
+#include <lcms2.h>
+
+namespace KWin
+{
+
+struct CmsDeleter
+{
+    void operator()(cmsToneCurve *toneCurve)
+    {
+        if (toneCurve) {
+            cmsFreeToneCurve(toneCurve);
+        }
+    }
+};
+using UniqueToneCurvePtr = std::unique_ptr<cmsToneCurve, CmsDeleter>;
+
+static qreal interpolate(qreal a, qreal b, qreal blendFactor)
+{
+    return (1 - blendFactor) * a + blendFactor * b;
+}
+
+static std::unique_ptr<ColorPipelineStage> createScaleStage(const QVector3D &factors)
+{
+    const double redCurveParams[] = {1.0, factors.x(), 0.0};
+    const double greenCurveParams[] = {1.0, factors.y(), 0.0};
+    const double blueCurveParams[] = {1.0, factors.z(), 0.0};
+
+    UniqueToneCurvePtr redCurve(cmsBuildParametricToneCurve(nullptr, 2, redCurveParams));
+    if (!redCurve) {
+        qCWarning(KWIN_CORE) << "Failed to build the tone curve for the red channel";
+        return nullptr;
+    }
+    UniqueToneCurvePtr greenCurve(cmsBuildParametricToneCurve(nullptr, 2, greenCurveParams));
+    if (!greenCurve) {
+        qCWarning(KWIN_CORE) << "Failed to build the tone curve for the green channel";
+        return nullptr;
+    }
+    UniqueToneCurvePtr blueCurve(cmsBuildParametricToneCurve(nullptr, 2, blueCurveParams));
+    if (!blueCurve) {
+        qCWarning(KWIN_CORE) << "Failed to build the tone curve for the blue channel";
+        return nullptr;
+    }
+
+    // The ownership of the tone curves will be moved to the pipeline stage.
+    return std::make_unique<ColorPipelineStage>(std::vector<cmsToneCurve *>{redCurve.release(), greenCurve.release(), blueCurve.release()});
+}
+
+ColorTransformationCache::ColorTransformationCache(int capacity)
+    : m_capacity(capacity)
+{
+}
+
+ColorTransformationCache::~ColorTransformationCache() = default;
+
+QVector3D ColorTransformationCache::temperatureFactors(uint temperature)
+{
+    if (temperature >= 6500) {
+        return QVector3D(1, 1, 1);
+    }
+
+    // Note that cmsWhitePointFromTemp() returns a slightly green-ish white point.
+    const int blackBodyColorIndex = ((temperature - 1000) / 100) * 3;
+    const qreal blendFactor = (temperature % 100) / 100.0;
+
+    const qreal xWhitePoint = interpolate(blackbodyColor[blackBodyColorIndex + 0],
+                                          blackbodyColor[blackBodyColorIndex + 3],
+                                          blendFactor);
+    const qreal yWhitePoint = interpolate(blackbodyColor[blackBodyColorIndex + 1],
+                                          blackbodyColor[blackBodyColorIndex + 4],
+                                          blendFactor);
+    const qreal zWhitePoint = interpolate(blackbodyColor[blackBodyColorIndex + 2],
+                                          blackbodyColor[blackBodyColorIndex + 5],
+                                          blendFactor);
+
+    return QVector3D(xWhitePoint, yWhitePoint, zWhitePoint);
+}
+
+std::shared_ptr<ColorTransformation> ColorTransformationCache::transformation(const QString &profile, uint temperature, uint brightness)
+{
+    const Key key{
+        .profile = profile,
+        .temperature = temperature,
+        .brightness = brightness,
+    };
+    if (auto transformation = lookup(key)) {
+        ++m_statistics.hits;
+        return transformation;
+    }
+    ++m_statistics.misses;
+
+    std::shared_ptr<ColorTransformation> transformation;
+    const uint remainder = temperature % 100;
+    if (remainder != 0 && temperature < 6500) {
+        const auto from = this->transformation(profile, temperature - remainder, brightness);
+        const auto to = this->transformation(profile, temperature - remainder + 100, brightness);
+        if (!from || !to) {
+            return nullptr;
+        }
+        transformation = std::make_shared<ColorTransformation>(from, to, remainder / 100.0f);
+        ++m_statistics.blends;
+    } else {
+        transformation = build(profile, temperature, brightness);
+    }
+
+    if (!transformation || !transformation->valid()) {
+        return nullptr;
+    }
+    insert(key, transformation);
+    return transformation;
+}
+
+std::shared_ptr<ColorTransformation> ColorTransformationCache::build(const QString &profile, uint temperature, uint brightness)
+{
+    std::vector<std::unique_ptr<ColorPipelineStage>> stages;
+    if (!profile.isNull()) {
+        if (auto stage = calibrationStage(profile)) {
+            stages.push_back(std::move(stage));
+        }
+    }
+    if (brightness != 100) {
+        const qreal factor = brightness / 100.0;
+        auto stage = createScaleStage(QVector3D(factor, factor, factor));
+        if (!stage) {
+            qCWarning(KWIN_CORE) << "Failed to create the color brightness pipeline stage";
+            return nullptr;
+        }
+        stages.push_back(std::move(stage));
+    }
+    if (temperature != 6500) {
+        auto stage = createScaleStage(temperatureFactors(temperature));
+        if (!stage) {
+            qCWarning(KWIN_CORE) << "Failed to create the color temperature pipeline stage";
+            return nullptr;
+        }
+        stages.push_back(std::move(stage));
+    }
+
+    return std::make_shared<ColorTransformation>(std::move(stages));
+}
+
+std::unique_ptr<ColorPipelineStage> ColorTransformationCache::calibrationStage(const QString &profile)
+{
+    auto it = m_calibrationStages.constFind(profile);
+    if (it == m_calibrationStages.constEnd()) {
+        std::shared_ptr<ColorPipelineStage> stage;
+
+        cmsHPROFILE handle = cmsOpenProfileFromFile(profile.toUtf8(), "r");
+        if (!handle) {
+            qCWarning(KWIN_CORE) << "Failed to open color profile file:" << profile;
+        } else {
+            cmsToneCurve **vcgt = static_cast<cmsToneCurve **>(cmsReadTag(handle, cmsSigVcgtTag));
+            if (!vcgt || !vcgt[0]) {
+                qCWarning(KWIN_CORE) << "Profile" << profile << "has no VCGT tag";
+            } else {
+                // Need to duplicate the VCGT tone curves as they are owned by the profile.
+                stage = std::make_shared<ColorPipelineStage>(std::vector<cmsToneCurve *>{
+                    cmsDupToneCurve(vcgt[0]),
+                    cmsDupToneCurve(vcgt[1]),
+                    cmsDupToneCurve(vcgt[2]),
+                });
+            }
+            cmsCloseProfile(handle);
+        }
+
+        it = m_calibrationStages.insert(profile, stage);
+    }
+
+    if (!*it) {
+        return nullptr;
+    }
+    return (*it)->dup();
+}
+
+std::shared_ptr<ColorTransformation> ColorTransformationCache::lookup(const Key &key)
+{
+    auto it = m_transformations.find(key);
+    if (it == m_transformations.end()) {
+        return nullptr;
+    }
+    m_recentlyUsed.splice(m_recentlyUsed.begin(), m_recentlyUsed, it->position);
+    return it->transformation;
+}
+
+void ColorTransformationCache::insert(const Key &key, const std::shared_ptr<ColorTransformation> &transformation)
+{
+    while (!m_recentlyUsed.empty() && int(m_recentlyUsed.size()) >= m_capacity) {
+        m_transformations.remove(m_recentlyUsed.back());
+        m_recentlyUsed.pop_back();
+    }
+    m_recentlyUsed.push_front(key);
+    m_transformations.insert(key, Entry{transformation, m_recentlyUsed.begin()});
+}
+
+void ColorTransformationCache::clear()
+{
+    m_transformations.clear();
+    m_recentlyUsed.clear();
+    m_calibrationStages.clear();
+}
+
+int ColorTransformationCache::count() const
+{
+    return m_transformations.count();
+}
+
+ColorTransformationCache::Statistics ColorTransformationCache::statistics() const
+{
+    return m_statistics;
+}
+
+} // namespace KWin
@@ -0,0 +1,107 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QHash>
+#include <QString>
+#include <QVector3D>
+#include <list>
+#include <memory>
+
+namespace KWin
+{
+
+class ColorPipelineStage;
+class ColorTransformation;
+
+/**
+ * The ColorTransformationCache class shares color transformations between color devices.
+ *
+ * Transformations are keyed by the calibration profile, the color temperature and the
+ * brightness. Outputs that use the same settings share one transformation, and with it the
+ * gamma ramps computed from it, and a night color transition that passes the same temperatures
+ * again doesn't rebuild anything.
+ *
+ * Only temperatures that are multiples of 100 K, the resolution of the black body table, are
+ * built from tone curves. The temperature and brightness stages only scale the channels, so the
+ * transformation for a temperature in between is the linear blend of its two neighbours, which
+ * are usually already cached during a transition.
+ *
+ * Once the capacity is reached, the least recently used transformation is evicted.
+ */
+class KWIN_EXPORT ColorTransformationCache
+{
+public:
+    struct Statistics
+    {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        /**
+         * The number of misses that were served by blending two cached transformations.
+         */
+        quint64 blends = 0;
+    };
+
+    explicit ColorTransformationCache(int capacity = 512);
+    ~ColorTransformationCache();
+
+    /**
+     * Returns the transformation for the given calibration @a profile, @a temperature in Kelvins
+     * and @a brightness in percent, or @c null if it could not be built.
+     */
+    std::shared_ptr<ColorTransformation> transformation(const QString &profile, uint temperature, uint brightness);
+
+    /**
+     * Builds a transformation for the given settings without looking into the cache.
+     */
+    std::shared_ptr<ColorTransformation> build(const QString &profile, uint temperature, uint brightness);
+
+    /**
+     * Returns the per-channel factors of the color temperature @a temperature.
+     */
+    static QVector3D temperatureFactors(uint temperature);
+
+    void clear();
+    int count() const;
+    Statistics statistics() const;
+
+private:
+    struct Key
+    {
+        QString profile;
+        uint temperature;
+        uint brightness;
+
+        bool operator==(const Key &other) const = default;
+
+        friend size_t qHash(const Key &key, size_t seed)
+        {
+            return qHash(key.profile, seed) ^ key.temperature ^ (size_t(key.brightness) << 16);
+        }
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<ColorTransformation> transformation;
+        std::list<Key>::iterator position;
+    };
+
+    std::shared_ptr<ColorTransformation> lookup(const Key &key);
+    void insert(const Key &key, const std::shared_ptr<ColorTransformation> &transformation);
+    std::unique_ptr<ColorPipelineStage> calibrationStage(const QString &profile);
+
+    const int m_capacity;
+    QHash<Key, Entry> m_transformations;
+    // The most recently used key comes first.
+    std::list<Key> m_recentlyUsed;
+    QHash<QString, std::shared_ptr<ColorPipelineStage>> m_calibrationStages;
+    Statistics m_statistics;
+};
+
+} // namespace KWin
@@ -29,6 +29,8 @@
 #include "scene/cursorscene.h"
 #include "scene/itemrenderer_opengl.h"
 #include "scene/itemrenderer_qpainter.h"
+#include "scene/latencytracker.h"
+#include "scene/renderprofiler.h"
 #include "scene/surfaceitem_x11.h"
 #include "scene/workspacescene_opengl.h"
 #include "scene/workspacescene_qpainter.h"
@@ -122,6 +124,8 @@ private:
 
 Compositor::Compositor(QObject *workspace)
     : QObject(workspace)
+    , m_renderProfiler(std::make_unique<RenderProfiler>())
+    , m_latencyTracker(std::make_unique<LatencyTracker>())
 {
     connect(options, &Options::configChanged, this, &Compositor::configChanged);
     connect(options, &Options::animationSpeedChanged, this, &Compositor::configChanged);
@@ -649,11 +653,15 @@ void Compositor::composite(RenderLoop *renderLoop)
         return;
     }
 
+    Q_EMIT aboutToComposite(renderLoop);
+
     Output *output = findOutput(renderLoop);
     OutputLayer *primaryLayer = m_backend->primaryLayer(output);
     fTraceDuration("Paint (", output->name(), ")");
 
     RenderLayer *superLayer = m_superlayers[renderLoop];
+    m_renderProfiler->beginFrame();
+    m_latencyTracker->beginFrame(renderLoop);
     prePaintPass(superLayer);
     superLayer->setOutputLayer(primaryLayer);
 
@@ -692,8 +700,13 @@ void Compositor::composite(RenderLoop *renderLoop)
 
     postPaintPass(superLayer);
     renderLoop->endFrame();
+    m_latencyTracker->endFrame();
+    m_renderProfiler->endFrame();
 
-    m_backend->present(output);
+    {
+        fTraceScope("compositor", "present");
+        m_backend->present(output);
+    }
 
     // TODO: Put it inside the cursor layer once the cursor layer can be backed by a real output layer.
     if (waylandServer()) {
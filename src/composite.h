@@ -23,9 +23,11 @@ class Output;
 class CompositorSelectionOwner;
 class CursorScene;
 class CursorView;
+class LatencyTracker;
 class RenderBackend;
 class RenderLayer;
 class RenderLoop;
+class RenderProfiler;
 class RenderTarget;
 class WorkspaceScene;
 class Window;
@@ -82,6 +84,14 @@ public:
     {
         return m_backend.get();
     }
+    RenderProfiler *renderProfiler() const
+    {
+        return m_renderProfiler.get();
+    }
+    LatencyTracker *latencyTracker() const
+    {
+        return m_latencyTracker.get();
+    }
 
     /**
      * @brief Static check to test whether the Compositor is available and active.
@@ -144,6 +154,11 @@ Q_SIGNALS:
     void aboutToDestroy();
     void aboutToToggleCompositing();
     void sceneCreated();
+    /**
+     * Emitted when the compositor is about to paint a frame for the given @p renderLoop,
+     * before the scene is prepared.
+     */
+    void aboutToComposite(RenderLoop *renderLoop);
 
 protected:
     explicit Compositor(QObject *parent = nullptr);
@@ -203,6 +218,8 @@ private:
     std::unique_ptr<WorkspaceScene> m_scene;
     std::unique_ptr<CursorScene> m_cursorScene;
     std::unique_ptr<RenderBackend> m_backend;
+    std::unique_ptr<RenderProfiler> m_renderProfiler;
+    std::unique_ptr<LatencyTracker> m_latencyTracker;
     QHash<RenderLoop *, RenderLayer *> m_superlayers;
     CompositingType m_selectedCompositor = NoCompositing;
 };
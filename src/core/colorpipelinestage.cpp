@@ -20,15 +20,37 @@ ColorPipelineStage::ColorPipelineStage(cmsStage *stage)
 {
 }
 
+ColorPipelineStage::ColorPipelineStage(std::vector<cmsToneCurve *> &&toneCurves)
+    : m_stage(cmsStageAllocToneCurves(nullptr, toneCurves.size(), toneCurves.data()))
+    , m_toneCurves(std::move(toneCurves))
+{
+}
+
 ColorPipelineStage::~ColorPipelineStage()
 {
     if (m_stage) {
         cmsStageFree(m_stage);
     }
+    for (cmsToneCurve *toneCurve : m_toneCurves) {
+        cmsFreeToneCurve(toneCurve);
+    }
 }
 
 std::unique_ptr<ColorPipelineStage> ColorPipelineStage::dup() const
 {
+    if (!m_toneCurves.empty()) {
+        std::vector<cmsToneCurve *> toneCurves;
+        toneCurves.reserve(m_toneCurves.size());
+        for (const cmsToneCurve *toneCurve : m_toneCurves) {
+            toneCurves.push_back(cmsDupToneCurve(toneCurve));
+        }
+        auto dup = std::make_unique<ColorPipelineStage>(std::move(toneCurves));
+        if (dup->stage()) {
+            return dup;
+        }
+        qCWarning(KWIN_CORE) << "Failed to duplicate cmsStage!";
+        return nullptr;
+    }
     if (m_stage) {
         auto dup = cmsStageDup(m_stage);
         if (dup) {
@@ -45,4 +67,9 @@ cmsStage *ColorPipelineStage::stage() const
     return m_stage;
 }
 
+const std::vector<cmsToneCurve *> &ColorPipelineStage::toneCurves() const
+{
+    return m_toneCurves;
+}
+
 }
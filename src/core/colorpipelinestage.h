@@ -11,8 +11,10 @@
 #include "kwin_export.h"
 
 #include <memory>
+#include <vector>
 
 typedef struct _cmsStage_struct cmsStage;
+typedef struct _cms_curve_struct cmsToneCurve;
 
 namespace KWin
 {
@@ -21,13 +23,25 @@ class KWIN_EXPORT ColorPipelineStage
 {
 public:
     ColorPipelineStage(cmsStage *stage);
+    /**
+     * Creates a stage that applies one of the @p toneCurves to every channel. The stage takes
+     * ownership of the tone curves.
+     */
+    explicit ColorPipelineStage(std::vector<cmsToneCurve *> &&toneCurves);
     ~ColorPipelineStage();
 
     std::unique_ptr<ColorPipelineStage> dup() const;
     cmsStage *stage() const;
 
+    /**
+     * Returns the per-channel tone curves of the stage, or an empty list if the stage was not
+     * created from tone curves. lcms has no public API to get them back from the stage.
+     */
+    const std::vector<cmsToneCurve *> &toneCurves() const;
+
 private:
     cmsStage *const m_stage;
+    const std::vector<cmsToneCurve *> m_toneCurves;
 };
 
 }
@@ -13,6 +13,9 @@
 
 #include "utils/common.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace KWin
 {
 
@@ -34,6 +37,15 @@ ColorTransformation::ColorTransformation(std::vector<std::unique_ptr<ColorPipeli
     }
 }
 
+ColorTransformation::ColorTransformation(const std::shared_ptr<ColorTransformation> &from, const std::shared_ptr<ColorTransformation> &to, float factor)
+    : m_pipeline(nullptr)
+    , m_from(from)
+    , m_to(to)
+    , m_factor(std::clamp(factor, 0.0f, 1.0f))
+    , m_valid(from && to && from->valid() && to->valid())
+{
+}
+
 ColorTransformation::~ColorTransformation()
 {
     if (m_pipeline) {
@@ -50,12 +62,133 @@ bool ColorTransformation::valid() const
     return m_valid;
 }
 
+static uint16_t blend(uint16_t a, uint16_t b, float factor)
+{
+    return uint16_t(std::lround((1 - factor) * a + factor * b));
+}
+
 std::tuple<uint16_t, uint16_t, uint16_t> ColorTransformation::transform(uint16_t r, uint16_t g, uint16_t b) const
 {
+    if (!m_pipeline) {
+        const auto [fromR, fromG, fromB] = m_from->transform(r, g, b);
+        const auto [toR, toG, toB] = m_to->transform(r, g, b);
+        return {blend(fromR, toR, m_factor), blend(fromG, toG, m_factor), blend(fromB, toB, m_factor)};
+    }
     const uint16_t in[3] = {r, g, b};
     uint16_t out[3] = {0, 0, 0};
     cmsPipelineEval16(in, out, m_pipeline);
     return {out[0], out[1], out[2]};
 }
 
+QVector<uint16_t> ColorTransformation::ramp(size_t size) const
+{
+    auto it = m_ramps.constFind(size);
+    if (it != m_ramps.constEnd()) {
+        return *it;
+    }
+    QVector<uint16_t> ramp = m_pipeline ? evaluateRamp(size) : blendRamp(size);
+    m_ramps.insert(size, ramp);
+    return ramp;
+}
+
+static uint16_t rampIndex(size_t i, size_t size)
+{
+    return (uint64_t(i) * 0xFFFF) / size;
+}
+
+// Same rounding as lcms uses when converting the floating point pipeline output to 16 bit.
+static uint16_t quantize(float value)
+{
+    const float scaled = value * 65535.0f + 0.5f;
+    if (scaled <= 0) {
+        return 0;
+    }
+    if (scaled >= 65535.0f) {
+        return 0xFFFF;
+    }
+    return uint16_t(scaled);
+}
+
+// Returns whether @a curve is a pure multiplication, i.e. y = a * x, as built for the
+// brightness and color temperature stages, and stores the factor in @a scale.
+static bool isScaleCurve(const cmsToneCurve *curve, float *scale)
+{
+    if (cmsGetToneCurveParametricType(curve) != 2) {
+        return false;
+    }
+    const cmsFloat64Number *params = cmsGetToneCurveParams(curve);
+    if (params[0] != 1.0 || params[2] != 0.0 || params[1] <= 0.0) {
+        return false;
+    }
+    *scale = params[1];
+    return true;
+}
+
+QVector<uint16_t> ColorTransformation::evaluateRamp(size_t size) const
+{
+    // All stages we build are per-channel tone curves. Instead of pushing every ramp entry
+    // through the whole lcms pipeline, evaluate the ramp one stage and one channel at a time,
+    // and turn pure multiplications into a plain loop over the channel plane.
+    for (const auto &stage : m_stages) {
+        if (stage->toneCurves().size() != 3) {
+            return evaluateRampPerEntry(size);
+        }
+    }
+
+    std::vector<float> planes(3 * size);
+    for (size_t i = 0; i < size; ++i) {
+        planes[i] = rampIndex(i, size) / 65535.0f;
+    }
+    std::copy_n(planes.begin(), size, planes.begin() + size);
+    std::copy_n(planes.begin(), size, planes.begin() + 2 * size);
+
+    for (const auto &stage : m_stages) {
+        for (int channel = 0; channel < 3; ++channel) {
+            const cmsToneCurve *curve = stage->toneCurves()[channel];
+            float *plane = planes.data() + channel * size;
+            float scale;
+            if (isScaleCurve(curve, &scale)) {
+                for (size_t i = 0; i < size; ++i) {
+                    plane[i] *= scale;
+                }
+            } else {
+                for (size_t i = 0; i < size; ++i) {
+                    plane[i] = cmsEvalToneCurveFloat(curve, plane[i]);
+                }
+            }
+        }
+    }
+
+    QVector<uint16_t> ramp(3 * size);
+    for (size_t i = 0; i < 3 * size; ++i) {
+        ramp[i] = quantize(planes[i]);
+    }
+    return ramp;
+}
+
+QVector<uint16_t> ColorTransformation::evaluateRampPerEntry(size_t size) const
+{
+    QVector<uint16_t> ramp(3 * size);
+    for (size_t i = 0; i < size; ++i) {
+        const uint16_t index = rampIndex(i, size);
+        std::tie(ramp[i], ramp[size + i], ramp[2 * size + i]) = transform(index, index, index);
+    }
+    return ramp;
+}
+
+QVector<uint16_t> ColorTransformation::blendRamp(size_t size) const
+{
+    const QVector<uint16_t> from = m_from->ramp(size);
+    const QVector<uint16_t> to = m_to->ramp(size);
+    const uint16_t *a = from.constData();
+    const uint16_t *b = to.constData();
+
+    QVector<uint16_t> ramp(3 * size);
+    uint16_t *out = ramp.data();
+    for (size_t i = 0; i < 3 * size; ++i) {
+        out[i] = uint16_t((1 - m_factor) * a[i] + m_factor * b[i] + 0.5f);
+    }
+    return ramp;
+}
+
 }
@@ -8,6 +8,8 @@
 */
 #pragma once
 
+#include <QHash>
+#include <QVector>
 #include <memory>
 #include <stdint.h>
 #include <tuple>
@@ -26,16 +28,36 @@ class KWIN_EXPORT ColorTransformation
 {
 public:
     ColorTransformation(std::vector<std::unique_ptr<ColorPipelineStage>> &&stages);
+    /**
+     * Creates a transformation that linearly blends the results of @a from and @a to, with
+     * @a factor going from 0 (only @a from) to 1 (only @a to).
+     */
+    ColorTransformation(const std::shared_ptr<ColorTransformation> &from, const std::shared_ptr<ColorTransformation> &to, float factor);
     ~ColorTransformation();
 
     bool valid() const;
 
     std::tuple<uint16_t, uint16_t, uint16_t> transform(uint16_t r, uint16_t g, uint16_t b) const;
 
+    /**
+     * Returns the transformation applied to an identity ramp of @a size entries, as consecutive
+     * red, green and blue planes of @a size entries each. The ramp is evaluated for all entries
+     * at once and kept around, so every further request for the same size is free.
+     */
+    QVector<uint16_t> ramp(size_t size) const;
+
 private:
+    QVector<uint16_t> evaluateRamp(size_t size) const;
+    QVector<uint16_t> evaluateRampPerEntry(size_t size) const;
+    QVector<uint16_t> blendRamp(size_t size) const;
+
     cmsPipeline *const m_pipeline;
     const std::vector<std::unique_ptr<ColorPipelineStage>> m_stages;
+    const std::shared_ptr<ColorTransformation> m_from;
+    const std::shared_ptr<ColorTransformation> m_to;
+    const float m_factor = 0;
     bool m_valid = true;
+    mutable QHash<size_t, QVector<uint16_t>> m_ramps;
 };
 
 }
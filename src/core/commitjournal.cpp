@@ -0,0 +1,54 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "commitjournal.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+// The number of predicted commits in a row that may fail to arrive before starting over.
+static const int s_maximumMisses = 3;
+
+void CommitJournal::addCommit(std::chrono::nanoseconds offset)
+{
+    if (m_log.count() >= m_size) {
+        m_log.dequeue();
+    }
+    m_log.enqueue(offset);
+}
+
+void CommitJournal::notifyLatched()
+{
+    m_misses = 0;
+}
+
+void CommitJournal::notifyMissed()
+{
+    m_misses++;
+    if (m_misses >= s_maximumMisses) {
+        m_log.clear();
+        m_misses = 0;
+    }
+}
+
+std::optional<std::chrono::nanoseconds> CommitJournal::predict(std::chrono::nanoseconds tolerance) const
+{
+    if (m_log.count() < m_size) {
+        return std::nullopt;
+    }
+    const auto [minimum, maximum] = std::minmax_element(m_log.constBegin(), m_log.constEnd());
+    if (*maximum - *minimum > tolerance) {
+        return std::nullopt;
+    }
+    return *maximum;
+}
+
+} // namespace KWin
@@ -0,0 +1,61 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwinglobals.h"
+
+#include <QQueue>
+
+#include <chrono>
+#include <optional>
+
+namespace KWin
+{
+
+/**
+ * The CommitJournal class records when a surface commits relative to the vblank and predicts
+ * when it will commit in the next refresh cycle.
+ *
+ * A prediction is only made once the surface has committed at about the same time in the
+ * last refresh cycles. If the predicted commits fail to arrive several times in a row, the
+ * journal forgets what it has learned and starts over.
+ */
+class KWIN_EXPORT CommitJournal
+{
+public:
+    /**
+     * Records a commit that happened @a offset after the start of its refresh cycle.
+     */
+    void addCommit(std::chrono::nanoseconds offset);
+
+    /**
+     * Records that a predicted commit has arrived in time.
+     */
+    void notifyLatched();
+
+    /**
+     * Records that a predicted commit hasn't arrived in time.
+     */
+    void notifyMissed();
+
+    /**
+     * Returns the offset from the start of the refresh cycle by which the next commit is
+     * expected, or an empty value if the commits are not regular enough. The recent commits
+     * must not be spread further apart than @a tolerance.
+     */
+    std::optional<std::chrono::nanoseconds> predict(std::chrono::nanoseconds tolerance) const;
+
+private:
+    QQueue<std::chrono::nanoseconds> m_log;
+    int m_size = 15;
+    int m_misses = 0;
+};
+
+} // namespace KWin
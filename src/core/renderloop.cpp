@@ -6,6 +6,7 @@
 
 #include "renderloop.h"
 #include "renderloop_p.h"
+#include "ftrace.h"
 #include "scene/surfaceitem.h"
 #include "scene/surfaceitem_wayland.h"
 #include "utils/common.h"
@@ -30,8 +31,19 @@ RenderLoopPrivate::RenderLoopPrivate(RenderLoop *q)
 {
     compositeTimer.setSingleShot(true);
     QObject::connect(&compositeTimer, &QTimer::timeout, q, [this]() {
+        if (waitingForCommit) {
+            // The predicted commit hasn't arrived, don't wait for it any longer.
+            fTraceInstant("renderloop", "commitMissed");
+            waitingForCommit = false;
+            ++missedCommits;
+            if (latchSurface) {
+                commitJournals[latchSurface].notifyMissed();
+            }
+        }
         dispatch();
     });
+
+    commitLatching = qEnvironmentVariableIntValue("KWIN_DISABLE_COMMIT_LATCHING") == 0;
 }
 
 void RenderLoopPrivate::scheduleRepaint()
@@ -89,12 +101,28 @@ void RenderLoopPrivate::scheduleRepaint()
     }
 
     std::chrono::nanoseconds nextRenderTimestamp = nextPresentationTimestamp - renderTime - safetyMargin;
+    fTraceCounter("renderloop", "renderTimeEstimateUs", std::chrono::duration_cast<std::chrono::microseconds>(renderTime).count());
 
     // If we can't render the frame before the deadline, start compositing immediately.
     if (nextRenderTimestamp < currentTime) {
         nextRenderTimestamp = currentTime;
     }
 
+    // If the focused surface is about to commit and the frame can still be rendered in time
+    // afterwards, wait for the commit so it doesn't have to wait for the next frame.
+    waitingForCommit = false;
+    if (presentMode == SyncMode::Fixed) {
+        if (const auto commitTimestamp = predictCommit(vblankInterval, currentTime)) {
+            const std::chrono::nanoseconds latchDeadline = nextPresentationTimestamp - renderJournal.maximum() - safetyMargin;
+            if (*commitTimestamp > nextRenderTimestamp && *commitTimestamp <= latchDeadline) {
+                waitingForCommit = true;
+                latchRenderTimestamp = nextRenderTimestamp;
+                nextRenderTimestamp = std::min(*commitTimestamp + std::chrono::milliseconds(1), latchDeadline);
+                fTraceCounter("renderloop", "commitWaitUs", std::chrono::duration_cast<std::chrono::microseconds>(nextRenderTimestamp - latchRenderTimestamp).count());
+            }
+        }
+    }
+
     if (presentMode == SyncMode::Async || presentMode == SyncMode::AdaptiveAsync) {
         compositeTimer.start(0);
     } else {
@@ -103,6 +131,72 @@ void RenderLoopPrivate::scheduleRepaint()
     }
 }
 
+std::optional<std::chrono::nanoseconds> RenderLoopPrivate::predictCommit(std::chrono::nanoseconds vblankInterval, std::chrono::nanoseconds currentTime) const
+{
+    if (!commitLatching || !latchSurface || lastPresentationTimestamp == std::chrono::nanoseconds::zero()) {
+        return std::nullopt;
+    }
+
+    // If the surface has already committed in this refresh cycle, there's nothing to wait for.
+    const std::chrono::nanoseconds cycleStart = nextPresentationTimestamp - vblankInterval;
+    if (lastCommitTimestamp >= cycleStart) {
+        return std::nullopt;
+    }
+
+    const std::optional<std::chrono::nanoseconds> offset = commitJournals.value(latchSurface).predict(vblankInterval / 10);
+    if (!offset || cycleStart + *offset < currentTime) {
+        return std::nullopt;
+    }
+    return cycleStart + *offset;
+}
+
+void RenderLoopPrivate::notifyCommitted()
+{
+    const std::chrono::nanoseconds currentTime(std::chrono::steady_clock::now().time_since_epoch());
+    lastCommitTimestamp = currentTime;
+
+    CommitJournal &journal = commitJournals[latchSurface];
+    if (lastPresentationTimestamp != std::chrono::nanoseconds::zero() && currentTime >= lastPresentationTimestamp) {
+        const std::chrono::nanoseconds vblankInterval(1'000'000'000'000ull / refreshRate);
+        journal.addCommit((currentTime - lastPresentationTimestamp) % vblankInterval);
+    }
+
+    if (waitingForCommit) {
+        fTraceInstant("renderloop", "commitLatched");
+        waitingForCommit = false;
+        ++latchedCommits;
+        journal.notifyLatched();
+        const std::chrono::nanoseconds waitInterval = std::max(latchRenderTimestamp - currentTime, std::chrono::nanoseconds::zero());
+        compositeTimer.start(std::chrono::duration_cast<std::chrono::milliseconds>(waitInterval));
+    }
+}
+
+void RenderLoopPrivate::setLatchSurface(KWaylandServer::SurfaceInterface *surface)
+{
+    if (latchSurface == surface) {
+        return;
+    }
+
+    QObject::disconnect(latchConnection);
+    latchSurface = surface;
+    lastCommitTimestamp = std::chrono::nanoseconds::zero();
+    waitingForCommit = false;
+    if (!surface) {
+        return;
+    }
+
+    // The commit timing of a surface is remembered while it isn't fullscreen for a moment.
+    if (!commitJournals.contains(surface)) {
+        commitJournals.insert(surface, CommitJournal());
+        QObject::connect(surface, &KWaylandServer::SurfaceInterface::aboutToBeDestroyed, q, [this, surface]() {
+            commitJournals.remove(surface);
+        });
+    }
+    latchConnection = QObject::connect(surface, &KWaylandServer::SurfaceInterface::committed, q, [this]() {
+        notifyCommitted();
+    });
+}
+
 void RenderLoopPrivate::delayScheduleRepaint()
 {
     pendingReschedule = true;
@@ -118,6 +212,7 @@ void RenderLoopPrivate::maybeScheduleRepaint()
 
 void RenderLoopPrivate::notifyFrameFailed()
 {
+    fTraceInstant("renderloop", "frameFailed");
     Q_ASSERT(pendingFrameCount > 0);
     pendingFrameCount--;
 
@@ -128,6 +223,7 @@ void RenderLoopPrivate::notifyFrameFailed()
 
 void RenderLoopPrivate::notifyFrameCompleted(std::chrono::nanoseconds timestamp)
 {
+    fTraceInstant("renderloop", "framePresented");
     Q_ASSERT(pendingFrameCount > 0);
     pendingFrameCount--;
 
@@ -154,6 +250,7 @@ void RenderLoopPrivate::dispatch()
     // the Compositor starts repainting.
     pendingRepaint = true;
 
+    fTraceScope("renderloop", "dispatch");
     Q_EMIT q->frameRequested(q);
 
     // The Compositor may decide to not repaint when the frameRequested() signal is
@@ -164,6 +261,7 @@ void RenderLoopPrivate::dispatch()
 void RenderLoopPrivate::invalidate()
 {
     pendingReschedule = false;
+    waitingForCommit = false;
     pendingFrameCount = 0;
     compositeTimer.stop();
 }
@@ -183,6 +281,7 @@ void RenderLoop::inhibit()
 
     if (d->inhibitCount == 1) {
         d->compositeTimer.stop();
+        d->waitingForCommit = false;
     }
 }
 
@@ -264,8 +363,10 @@ void RenderLoop::setFullscreenSurface(Item *surfaceItem)
     d->fullscreenItem = surfaceItem;
     if (SurfaceItemWayland *wayland = qobject_cast<SurfaceItemWayland *>(surfaceItem)) {
         d->allowTearing = d->canDoTearing && options->allowTearing() && wayland->surface()->presentationHint() == KWaylandServer::PresentationHint::Async;
+        d->setLatchSurface(wayland->surface());
     } else {
         d->allowTearing = false;
+        d->setLatchSurface(nullptr);
     }
 }
 
@@ -90,6 +90,13 @@ public:
     /**
      * Sets the surface that currently gets scanned out,
      * so that this RenderLoop can adjust its timing behavior to that surface
+     *
+     * The RenderLoop also learns when that surface commits and may start compositing slightly
+     * later so that its commits make it into the next frame. Only the fullscreen surface is
+     * waited for, since it is the only content of the frame, the other windows on the output
+     * would pay for the wait without benefitting from it.
+     *
+     * Set the KWIN_DISABLE_COMMIT_LATCHING environment variable to turn this off.
      */
     void setFullscreenSurface(Item *surface);
 
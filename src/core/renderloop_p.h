@@ -6,13 +6,21 @@
 
 #pragma once
 
+#include "commitjournal.h"
 #include "renderjournal.h"
 #include "renderloop.h"
 
+#include <QHash>
+#include <QPointer>
 #include <QTimer>
 
 #include <optional>
 
+namespace KWaylandServer
+{
+class SurfaceInterface;
+}
+
 namespace KWin
 {
 
@@ -31,6 +39,9 @@ public:
 
     void notifyFrameFailed();
     void notifyFrameCompleted(std::chrono::nanoseconds timestamp);
+    void notifyCommitted();
+    void setLatchSurface(KWaylandServer::SurfaceInterface *surface);
+    std::optional<std::chrono::nanoseconds> predictCommit(std::chrono::nanoseconds vblankInterval, std::chrono::nanoseconds currentTime) const;
 
     RenderLoop *q;
     std::chrono::nanoseconds lastPresentationTimestamp = std::chrono::nanoseconds::zero();
@@ -47,6 +58,28 @@ public:
     Item *fullscreenItem = nullptr;
     bool allowTearing = false;
 
+    /**
+     * The fullscreen surface, compositing may be delayed a bit to include its upcoming commit.
+     */
+    QPointer<KWaylandServer::SurfaceInterface> latchSurface;
+    QMetaObject::Connection latchConnection;
+    QHash<KWaylandServer::SurfaceInterface *, CommitJournal> commitJournals;
+    std::chrono::nanoseconds lastCommitTimestamp = std::chrono::nanoseconds::zero();
+    /**
+     * The time when compositing would have started if it wasn't waiting for a commit.
+     */
+    std::chrono::nanoseconds latchRenderTimestamp = std::chrono::nanoseconds::zero();
+    bool waitingForCommit = false;
+    bool commitLatching = true;
+    /**
+     * The number of predicted commits that compositing waited for and that arrived in time.
+     */
+    quint64 latchedCommits = 0;
+    /**
+     * The number of predicted commits that compositing waited for in vain.
+     */
+    quint64 missedCommits = 0;
+
     enum class SyncMode {
         Fixed,
         Adaptive,
@@ -23,6 +23,8 @@
 #include "main.h"
 #include "placement.h"
 #include "pluginmanager.h"
+#include "scene/latencytracker.h"
+#include "scene/renderprofiler.h"
 #include "unmanaged.h"
 #include "virtualdesktops.h"
 #include "window.h"
@@ -317,6 +319,120 @@ bool CompositorDBusInterface::platformRequiresCompositing() const
     return kwinApp()->operationMode() != Application::OperationModeX11; // TODO: Remove this property?
 }
 
+bool CompositorDBusInterface::isRenderProfilingEnabled() const
+{
+    return m_compositor->renderProfiler()->isEnabled();
+}
+
+void CompositorDBusInterface::setRenderProfilingEnabled(bool enabled)
+{
+    m_compositor->renderProfiler()->setEnabled(enabled);
+}
+
+QVariantMap CompositorDBusInterface::renderStatistics() const
+{
+    const RenderProfiler *profiler = m_compositor->renderProfiler();
+
+    QVariantList windows;
+    const auto windowStatistics = profiler->windowStatistics();
+    for (const RenderProfiler::WindowStatistics &statistics : windowStatistics) {
+        windows.append(QVariantMap{
+            {QStringLiteral("id"), statistics.id.toString()},
+            {QStringLiteral("caption"), statistics.caption},
+            {QStringLiteral("resourceClass"), statistics.resourceClass},
+            {QStringLiteral("prepareAverage"), qlonglong(statistics.prepare.average.count())},
+            {QStringLiteral("prepareMaximum"), qlonglong(statistics.prepare.maximum.count())},
+            {QStringLiteral("prepareFrames"), statistics.prepare.frames},
+            {QStringLiteral("renderAverage"), qlonglong(statistics.render.average.count())},
+            {QStringLiteral("renderMaximum"), qlonglong(statistics.render.maximum.count())},
+            {QStringLiteral("renderFrames"), statistics.render.frames},
+        });
+    }
+
+    QVariantList effects;
+    const auto effectStatistics = profiler->effectStatistics();
+    for (const RenderProfiler::EffectStatistics &statistics : effectStatistics) {
+        effects.append(QVariantMap{
+            {QStringLiteral("name"), statistics.name},
+            {QStringLiteral("average"), qlonglong(statistics.time.average.count())},
+            {QStringLiteral("maximum"), qlonglong(statistics.time.maximum.count())},
+            {QStringLiteral("frames"), statistics.time.frames},
+        });
+    }
+
+    const RenderProfiler::Statistics frameStatistics = profiler->frameStatistics();
+    const QVariantMap frames{
+        {QStringLiteral("average"), qlonglong(frameStatistics.average.count())},
+        {QStringLiteral("maximum"), qlonglong(frameStatistics.maximum.count())},
+        {QStringLiteral("frames"), frameStatistics.frames},
+    };
+
+    return QVariantMap{
+        {QStringLiteral("frame"), frames},
+        {QStringLiteral("windows"), windows},
+        {QStringLiteral("effects"), effects},
+    };
+}
+
+bool CompositorDBusInterface::isLatencyTrackingEnabled() const
+{
+    return m_compositor->latencyTracker()->isEnabled();
+}
+
+void CompositorDBusInterface::setLatencyTrackingEnabled(bool enabled)
+{
+    m_compositor->latencyTracker()->setEnabled(enabled);
+}
+
+static QVariantMap latencyToVariant(const LatencyTracker::Statistics &statistics)
+{
+    QVariantList histogram;
+    for (int frames : statistics.histogram) {
+        histogram.append(frames);
+    }
+    return QVariantMap{
+        {QStringLiteral("average"), qlonglong(statistics.average.count())},
+        {QStringLiteral("maximum"), qlonglong(statistics.maximum.count())},
+        {QStringLiteral("frames"), statistics.frames},
+        {QStringLiteral("missedVblanks"), statistics.missedVblanks},
+        {QStringLiteral("histogram"), histogram},
+    };
+}
+
+QVariantMap CompositorDBusInterface::presentationLatencies() const
+{
+    QVariantList bounds;
+    const auto bucketBounds = LatencyTracker::bucketBounds();
+    for (const std::chrono::milliseconds &bound : bucketBounds) {
+        bounds.append(qlonglong(bound.count()));
+    }
+
+    QVariantList clients;
+    const auto clientStatistics = m_compositor->latencyTracker()->clientStatistics();
+    for (const LatencyTracker::ClientStatistics &statistics : clientStatistics) {
+        QVariantList surfaces;
+        for (const LatencyTracker::SurfaceStatistics &surface : statistics.surfaces) {
+            QVariantMap map = latencyToVariant(surface.latency);
+            map.insert(QStringLiteral("caption"), surface.caption);
+            map.insert(QStringLiteral("resourceClass"), surface.resourceClass);
+            map.insert(QStringLiteral("paintDelay"), qlonglong(surface.paintDelay.count()));
+            map.insert(QStringLiteral("missingVblanks"), surface.missingVblanks);
+            surfaces.append(map);
+        }
+
+        QVariantMap client = latencyToVariant(statistics.latency);
+        client.insert(QStringLiteral("pid"), statistics.pid);
+        client.insert(QStringLiteral("executable"), statistics.executable);
+        client.insert(QStringLiteral("surfaces"), surfaces);
+        clients.append(client);
+    }
+
+    return QVariantMap{
+        {QStringLiteral("bucketBounds"), bounds},
+        {QStringLiteral("clients"), clients},
+    };
+}
+
 void CompositorDBusInterface::resume()
 {
     if (kwinApp()->operationMode() == Application::OperationModeX11) {
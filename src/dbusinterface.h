@@ -149,6 +149,22 @@ class CompositorDBusInterface : public QObject
     Q_PROPERTY(QStringList supportedOpenGLPlatformInterfaces READ supportedOpenGLPlatformInterfaces)
 
     Q_PROPERTY(bool platformRequiresCompositing READ platformRequiresCompositing)
+
+    /**
+     * @brief Whether the time spent rendering every window and running every effect is measured.
+     *
+     * Disabled by default. The collected statistics are discarded when it gets disabled.
+     * @see renderStatistics
+     */
+    Q_PROPERTY(bool renderProfilingEnabled READ isRenderProfilingEnabled WRITE setRenderProfilingEnabled)
+
+    /**
+     * @brief Whether the time from client commits until their contents are presented is measured.
+     *
+     * Disabled by default. The collected statistics are discarded when it gets disabled.
+     * @see presentationLatencies
+     */
+    Q_PROPERTY(bool latencyTrackingEnabled READ isLatencyTrackingEnabled WRITE setLatencyTrackingEnabled)
 public:
     explicit CompositorDBusInterface(Compositor *parent);
     ~CompositorDBusInterface() override = default;
@@ -160,6 +176,10 @@ public:
     QString compositingType() const;
     QStringList supportedOpenGLPlatformInterfaces() const;
     bool platformRequiresCompositing() const;
+    bool isRenderProfilingEnabled() const;
+    void setRenderProfilingEnabled(bool enabled);
+    bool isLatencyTrackingEnabled() const;
+    void setLatencyTrackingEnabled(bool enabled);
 
 public Q_SLOTS:
     /**
@@ -200,6 +220,34 @@ public Q_SLOTS:
      */
     void reinitialize();
 
+    /**
+     * @brief The render times collected while renderProfilingEnabled is set, over the last frames.
+     *
+     * The map contains a list of maps for the @c windows, with the keys @c id, @c caption,
+     * @c resourceClass, @c prepareAverage, @c prepareMaximum, @c prepareFrames, @c renderAverage,
+     * @c renderMaximum and @c renderFrames, and a list of maps for the @c effects, with the keys
+     * @c name, @c average, @c maximum and @c frames. The map for the whole @c frame has the
+     * keys @c average, @c maximum and @c frames. All times are in nanoseconds per frame.
+     *
+     * @return QVariantMap
+     * @see renderProfilingEnabled
+     */
+    QVariantMap renderStatistics() const;
+
+    /**
+     * @brief The commit-to-present latencies collected while latencyTrackingEnabled is set.
+     *
+     * The map contains the upper @c bucketBounds of the histograms in milliseconds and a list of
+     * maps for the @c clients, with the keys @c pid, @c executable and @c surfaces. The
+     * @c surfaces are a list of maps with the keys @c caption, @c resourceClass, @c paintDelay
+     * and @c missingVblanks. Both clients and surfaces have the keys @c average, @c maximum,
+     * @c frames, @c missedVblanks and @c histogram. All times are in nanoseconds.
+     *
+     * @return QVariantMap
+     * @see latencyTrackingEnabled
+     */
+    QVariantMap presentationLatencies() const;
+
 Q_SIGNALS:
     void compositingToggled(bool active);
 
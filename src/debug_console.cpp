@@ -42,12 +42,14 @@
 #include <KLocalizedString>
 #include <NETWM>
 // Qt
+#include <QColor>
 #include <QFutureWatcher>
 #include <QMetaProperty>
 #include <QMetaType>
 #include <QMouseEvent>
 #include <QScopeGuard>
 #include <QSortFilterProxyModel>
+#include <QTimer>
 #include <QtConcurrentRun>
 
 #include <wayland-server-core.h>
@@ -657,10 +659,79 @@ DebugConsole::DebugConsole()
     });
 
     initGLTab();
+    initRenderTimesTab();
+    initLatencyTab();
 }
 
 DebugConsole::~DebugConsole() = default;
 
+void DebugConsole::initRenderTimesTab()
+{
+    Compositor *compositor = Compositor::self();
+    if (!compositor) {
+        m_ui->tabWidget->setTabEnabled(m_ui->tabWidget->indexOf(m_ui->renderTimes), false);
+        return;
+    }
+    RenderProfiler *profiler = compositor->renderProfiler();
+
+    auto model = new RenderProfilerModel(this);
+    QSortFilterProxyModel *proxyModel = new QSortFilterProxyModel(this);
+    proxyModel->setSourceModel(model);
+    proxyModel->setSortRole(Qt::UserRole);
+    m_ui->renderTimesView->setModel(proxyModel);
+    m_ui->renderTimesView->setSortingEnabled(true);
+    m_ui->renderTimesView->sortByColumn(2, Qt::DescendingOrder);
+
+    initStatisticsTab(m_ui->renderTimes, m_ui->renderProfilingCheckBox, profiler, [model, profiler]() {
+        model->update(profiler);
+    });
+}
+
+void DebugConsole::initLatencyTab()
+{
+    Compositor *compositor = Compositor::self();
+    if (!compositor) {
+        m_ui->tabWidget->setTabEnabled(m_ui->tabWidget->indexOf(m_ui->latency), false);
+        return;
+    }
+    LatencyTracker *tracker = compositor->latencyTracker();
+
+    auto model = new LatencyModel(this);
+    QSortFilterProxyModel *proxyModel = new QSortFilterProxyModel(this);
+    proxyModel->setSourceModel(model);
+    proxyModel->setSortRole(Qt::UserRole);
+    m_ui->latencyView->setModel(proxyModel);
+    m_ui->latencyView->setSortingEnabled(true);
+    m_ui->latencyView->sortByColumn(3, Qt::DescendingOrder);
+    connect(proxyModel, &QAbstractItemModel::modelReset, m_ui->latencyView, &QTreeView::expandAll);
+
+    initStatisticsTab(m_ui->latency, m_ui->latencyTrackingCheckBox, tracker, [model, tracker]() {
+        model->update(tracker);
+    });
+}
+
+void DebugConsole::initStatisticsTab(QWidget *tab, QCheckBox *checkBox, StatisticsCollector *collector, const std::function<void()> &refresh)
+{
+    checkBox->setChecked(collector->isEnabled());
+    connect(checkBox, &QCheckBox::toggled, collector, &StatisticsCollector::setEnabled);
+    connect(collector, &StatisticsCollector::enabledChanged, checkBox, [checkBox, collector]() {
+        checkBox->setChecked(collector->isEnabled());
+    });
+
+    // The statistics keep changing, so refresh them while they are shown.
+    QTimer *refreshTimer = new QTimer(this);
+    refreshTimer->setInterval(1000);
+    connect(refreshTimer, &QTimer::timeout, collector, refresh);
+    connect(m_ui->tabWidget, &QTabWidget::currentChanged, collector, [this, tab, refresh, refreshTimer](int index) {
+        if (index == m_ui->tabWidget->indexOf(tab)) {
+            refresh();
+            refreshTimer->start();
+        } else {
+            refreshTimer->stop();
+        }
+    });
+}
+
 void DebugConsole::initGLTab()
 {
     if (!effects || !effects->isOpenGLCompositing()) {
@@ -1710,4 +1781,280 @@ void DataSourceModel::setSource(KWaylandServer::AbstractDataSource *source)
     }
     endResetModel();
 }
+
+QModelIndex RenderProfilerModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || column >= 6 || row >= m_rows.count()) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, nullptr);
+}
+
+QModelIndex RenderProfilerModel::parent(const QModelIndex &child) const
+{
+    return QModelIndex();
+}
+
+int RenderProfilerModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return m_rows.count();
+    }
+    return 0;
+}
+
+QVariant RenderProfilerModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QVariant();
+    }
+    switch (section) {
+    case 0:
+        return i18n("Name");
+    case 1:
+        return i18n("Type");
+    case 2:
+        return i18n("CPU average");
+    case 3:
+        return i18n("CPU maximum");
+    case 4:
+        return i18n("Render average");
+    case 5:
+        return i18n("Render maximum");
+    default:
+        return QVariant();
+    }
+}
+
+QVariant RenderProfilerModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::ParentIsInvalid | CheckIndexOption::IndexIsValid)) {
+        return QVariant();
+    }
+    if (role != Qt::DisplayRole && role != Qt::UserRole) {
+        return QVariant();
+    }
+
+    const Row &row = m_rows.at(index.row());
+    if (index.column() == 0) {
+        return row.name;
+    } else if (index.column() == 1) {
+        return row.type;
+    }
+
+    const RenderProfiler::Statistics &statistics = index.column() < 4 ? row.cpu : row.render;
+    const std::chrono::nanoseconds time = index.column() % 2 == 0 ? statistics.average : statistics.maximum;
+    if (role == Qt::UserRole) {
+        return qlonglong(time.count());
+    }
+    if (statistics.frames == 0) {
+        return QVariant();
+    }
+    return i18nc("time in milliseconds", "%1 ms", QString::number(time.count() / 1000000.0, 'f', 3));
+}
+
+void RenderProfilerModel::update(const RenderProfiler *profiler)
+{
+    QVector<Row> rows;
+    const auto windowStatistics = profiler->windowStatistics();
+    for (const RenderProfiler::WindowStatistics &statistics : windowStatistics) {
+        rows.append(Row{
+            .name = statistics.caption.isEmpty() ? statistics.resourceClass : statistics.caption,
+            .type = i18n("Window"),
+            .cpu = statistics.prepare,
+            .render = statistics.render,
+        });
+    }
+    const auto effectStatistics = profiler->effectStatistics();
+    for (const RenderProfiler::EffectStatistics &statistics : effectStatistics) {
+        rows.append(Row{
+            .name = statistics.name,
+            .type = i18n("Effect"),
+            .cpu = statistics.time,
+        });
+    }
+
+    const bool sameRows = std::equal(rows.cbegin(), rows.cend(), m_rows.cbegin(), m_rows.cend(), [](const Row &a, const Row &b) {
+        return a.name == b.name && a.type == b.type;
+    });
+    if (sameRows) {
+        m_rows = rows;
+        if (!m_rows.isEmpty()) {
+            Q_EMIT dataChanged(index(0, 2), index(m_rows.count() - 1, 5));
+        }
+    } else {
+        beginResetModel();
+        m_rows = rows;
+        endResetModel();
+    }
+}
+
+int LatencyModel::columnCount(const QModelIndex &parent) const
+{
+    // Name, frames, missed vblanks, average, maximum, paint delay and the histogram buckets.
+    return 6 + m_bucketBounds.count() + 1;
+}
+
+QModelIndex LatencyModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (column < 0 || column >= columnCount(parent) || row < 0) {
+        return QModelIndex();
+    }
+    if (!parent.isValid()) {
+        if (row >= m_clients.count()) {
+            return QModelIndex();
+        }
+        return createIndex(row, column, quintptr(0));
+    }
+    if (parent.internalId() != 0 || parent.column() != 0 || row >= m_clients.at(parent.row()).surfaces.count()) {
+        return QModelIndex();
+    }
+    // The surfaces store the row of their client, offset by one to tell them apart from the clients.
+    return createIndex(row, column, quintptr(parent.row() + 1));
+}
+
+QModelIndex LatencyModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid() || child.internalId() == 0) {
+        return QModelIndex();
+    }
+    return createIndex(child.internalId() - 1, 0, quintptr(0));
+}
+
+int LatencyModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return m_clients.count();
+    }
+    if (parent.internalId() == 0 && parent.column() == 0) {
+        return m_clients.at(parent.row()).surfaces.count();
+    }
+    return 0;
+}
+
+QVariant LatencyModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QVariant();
+    }
+    switch (section) {
+    case 0:
+        return i18n("Name");
+    case 1:
+        return i18n("Frames");
+    case 2:
+        return i18n("Missed vblanks");
+    case 3:
+        return i18n("Average");
+    case 4:
+        return i18n("Maximum");
+    case 5:
+        return i18n("Paint delay");
+    default:
+        break;
+    }
+    const int bucket = section - 6;
+    if (bucket < 0 || bucket > m_bucketBounds.count()) {
+        return QVariant();
+    }
+    if (bucket == m_bucketBounds.count()) {
+        return i18nc("latency of at least", "≥ %1 ms", m_bucketBounds.last().count());
+    }
+    return i18nc("latency below", "< %1 ms", m_bucketBounds.at(bucket).count());
+}
+
+const LatencyTracker::Statistics &LatencyModel::statistics(const QModelIndex &index) const
+{
+    if (index.internalId() == 0) {
+        return m_clients.at(index.row()).latency;
+    }
+    return m_clients.at(index.internalId() - 1).surfaces.at(index.row()).latency;
+}
+
+QVariant LatencyModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid)) {
+        return QVariant();
+    }
+
+    const bool isClient = index.internalId() == 0;
+    const LatencyTracker::SurfaceStatistics *surface = isClient ? nullptr : &m_clients.at(index.internalId() - 1).surfaces.at(index.row());
+    if (role == Qt::ForegroundRole) {
+        if (surface && surface->missingVblanks) {
+            return QColor(Qt::red);
+        }
+        return QVariant();
+    }
+    if (role == Qt::ToolTipRole) {
+        if (surface && surface->missingVblanks) {
+            return i18n("Most of the recent frames of this surface missed a vblank");
+        }
+        return QVariant();
+    }
+    if (role != Qt::DisplayRole && role != Qt::UserRole) {
+        return QVariant();
+    }
+
+    const LatencyTracker::Statistics &latency = statistics(index);
+    auto formatTime = [role](std::chrono::nanoseconds time) -> QVariant {
+        if (role == Qt::UserRole) {
+            return qlonglong(time.count());
+        }
+        return i18nc("time in milliseconds", "%1 ms", QString::number(time.count() / 1000000.0, 'f', 3));
+    };
+
+    switch (index.column()) {
+    case 0:
+        if (isClient) {
+            const LatencyTracker::ClientStatistics &client = m_clients.at(index.row());
+            if (role == Qt::UserRole) {
+                return client.pid;
+            }
+            return i18nc("executable (pid)", "%1 (%2)", client.executable, client.pid);
+        }
+        return surface->caption.isEmpty() ? surface->resourceClass : surface->caption;
+    case 1:
+        return latency.frames;
+    case 2:
+        return latency.missedVblanks;
+    case 3:
+        return formatTime(latency.average);
+    case 4:
+        return formatTime(latency.maximum);
+    case 5:
+        if (isClient) {
+            return QVariant();
+        }
+        return formatTime(surface->paintDelay);
+    default:
+        return latency.histogram.value(index.column() - 6);
+    }
+}
+
+void LatencyModel::update(const LatencyTracker *tracker)
+{
+    const QVector<LatencyTracker::ClientStatistics> clients = tracker->clientStatistics();
+
+    const bool sameRows = std::equal(clients.cbegin(), clients.cend(), m_clients.cbegin(), m_clients.cend(), [](const LatencyTracker::ClientStatistics &a, const LatencyTracker::ClientStatistics &b) {
+        return a.pid == b.pid && a.executable == b.executable
+            && std::equal(a.surfaces.cbegin(), a.surfaces.cend(), b.surfaces.cbegin(), b.surfaces.cend(), [](const LatencyTracker::SurfaceStatistics &first, const LatencyTracker::SurfaceStatistics &second) {
+                   return first.caption == second.caption && first.resourceClass == second.resourceClass;
+               });
+    });
+    if (sameRows) {
+        m_clients = clients;
+        const int lastColumn = columnCount(QModelIndex()) - 1;
+        for (int i = 0; i < m_clients.count(); ++i) {
+            const QModelIndex client = index(i, 0);
+            Q_EMIT dataChanged(index(i, 1), index(i, lastColumn));
+            if (!m_clients.at(i).surfaces.isEmpty()) {
+                Q_EMIT dataChanged(index(0, 0, client), index(m_clients.at(i).surfaces.count() - 1, lastColumn, client));
+            }
+        }
+    } else {
+        beginResetModel();
+        m_clients = clients;
+        endResetModel();
+    }
+}
 }
@@ -10,6 +10,8 @@
 
 #include "input.h"
 #include "input_event_spy.h"
+#include "scene/latencytracker.h"
+#include "scene/renderprofiler.h"
 #include <config-kwin.h>
 #include <kwin_export.h>
 
@@ -19,6 +21,7 @@
 #include <functional>
 #include <memory>
 
+class QCheckBox;
 class QTextEdit;
 
 namespace KWaylandServer
@@ -106,6 +109,9 @@ protected:
 
 private:
     void initGLTab();
+    void initRenderTimesTab();
+    void initLatencyTab();
+    void initStatisticsTab(QWidget *tab, QCheckBox *checkBox, StatisticsCollector *collector, const std::function<void()> &refresh);
     void updateKeyboardTab();
 
     std::unique_ptr<Ui::DebugConsole> m_ui;
@@ -203,4 +209,62 @@ private:
     KWaylandServer::AbstractDataSource *m_source = nullptr;
     QVector<QByteArray> m_data;
 };
+
+class RenderProfilerModel : public QAbstractItemModel
+{
+public:
+    using QAbstractItemModel::QAbstractItemModel;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent) const override;
+    int columnCount(const QModelIndex &parent) const override
+    {
+        return parent.isValid() ? 0 : 6;
+    }
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    /**
+     * Takes a snapshot of the statistics collected by @a profiler.
+     */
+    void update(const RenderProfiler *profiler);
+
+private:
+    struct Row
+    {
+        QString name;
+        QString type;
+        RenderProfiler::Statistics cpu;
+        RenderProfiler::Statistics render;
+    };
+    QVector<Row> m_rows;
+};
+
+/**
+ * Shows the commit-to-present latencies of the clients, with their surfaces as children.
+ */
+class LatencyModel : public QAbstractItemModel
+{
+public:
+    using QAbstractItemModel::QAbstractItemModel;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent) const override;
+    int columnCount(const QModelIndex &parent) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    /**
+     * Takes a snapshot of the statistics collected by @a tracker.
+     */
+    void update(const LatencyTracker *tracker);
+
+private:
+    const LatencyTracker::Statistics &statistics(const QModelIndex &index) const;
+
+    QVector<std::chrono::milliseconds> m_bucketBounds = LatencyTracker::bucketBounds();
+    QVector<LatencyTracker::ClientStatistics> m_clients;
+};
 }
@@ -21,7 +21,10 @@
 #include <KPackage/PackageLoader>
 // Qt
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFutureWatcher>
+#include <QJsonObject>
 #include <QStaticPlugin>
 #include <QStringList>
 #include <QtConcurrentRun>
@@ -63,13 +66,45 @@ LoadEffectFlags AbstractEffectLoader::readConfig(const QString &effectName, bool
     return LoadEffectFlags();
 }
 
+EffectLoadPriority AbstractEffectLoader::loadPriority(const KPluginMetaData &metaData)
+{
+    if (metaData.value(QStringLiteral("X-KWin-Load-Deferred"), false)) {
+        return EffectLoadPriority::Deferred;
+    }
+    const QJsonObject effectData = metaData.rawData().value(QStringLiteral("org.kde.kwin.effect")).toObject();
+    if (effectData.value(QStringLiteral("loadDeferred")).toBool()) {
+        return EffectLoadPriority::Deferred;
+    }
+    return EffectLoadPriority::Startup;
+}
+
+bool AbstractEffectLoader::isDeferredLoadingAllowed() const
+{
+    return m_deferredLoadingAllowed;
+}
+
+void AbstractEffectLoader::setDeferredLoadingAllowed(bool allowed)
+{
+    m_deferredLoadingAllowed = allowed;
+}
+
+QHash<QString, std::chrono::microseconds> AbstractEffectLoader::loadTimes() const
+{
+    return m_loadTimes;
+}
+
+void AbstractEffectLoader::recordLoadTime(const QString &effectName, std::chrono::microseconds duration)
+{
+    m_loadTimes[effectName] = duration;
+}
+
 static const QString s_nameProperty = QStringLiteral("X-KDE-PluginInfo-Name");
 static const QString s_jsConstraint = QStringLiteral("[X-Plasma-API] == 'javascript'");
 static const QString s_serviceType = QStringLiteral("KWin/Effect");
 
 ScriptedEffectLoader::ScriptedEffectLoader(QObject *parent)
     : AbstractEffectLoader(parent)
-    , m_queue(new EffectLoadQueue<ScriptedEffectLoader, KPluginMetaData>(this))
+    , m_queue(new EffectLoadQueue<ScriptedEffectLoader, Package>(this))
 {
 }
 
@@ -112,6 +147,12 @@ bool ScriptedEffectLoader::loadEffect(const QString &name)
 
 bool ScriptedEffectLoader::loadEffect(const KPluginMetaData &effect, LoadEffectFlags flags)
 {
+    return loadEffect(Package{.metaData = effect}, flags);
+}
+
+bool ScriptedEffectLoader::loadEffect(const Package &package, LoadEffectFlags flags)
+{
+    const KPluginMetaData &effect = package.metaData;
     const QString name = effect.pluginId();
     if (!flags.testFlag(LoadEffectFlag::Load)) {
         qCDebug(KWIN_CORE) << "Loading flags disable effect: " << name;
@@ -127,7 +168,14 @@ bool ScriptedEffectLoader::loadEffect(const KPluginMetaData &effect, LoadEffectF
         return false;
     }
 
-    ScriptedEffect *e = ScriptedEffect::create(effect);
+    QElapsedTimer timer;
+    timer.start();
+    ScriptedEffect *e;
+    if (package.script.isEmpty()) {
+        e = ScriptedEffect::create(effect);
+    } else {
+        e = ScriptedEffect::create(effect, package.scriptFile, package.script);
+    }
     if (!e) {
         qCDebug(KWIN_CORE) << "Could not initialize scripted effect: " << name;
         return false;
@@ -135,8 +183,10 @@ bool ScriptedEffectLoader::loadEffect(const KPluginMetaData &effect, LoadEffectF
     connect(e, &ScriptedEffect::destroyed, this, [this, name]() {
         m_loadedEffects.removeAll(name);
     });
+    const auto loadTime = std::chrono::microseconds(timer.nsecsElapsed() / 1000);
+    recordLoadTime(name, loadTime);
 
-    qCDebug(KWIN_CORE) << "Successfully loaded scripted effect: " << name;
+    qCDebug(KWIN_CORE) << "Successfully loaded scripted effect: " << name << "in" << loadTime.count() << "us";
     Q_EMIT effectLoaded(e, name);
     m_loadedEffects << name;
     return true;
@@ -147,15 +197,15 @@ void ScriptedEffectLoader::queryAndLoadAll()
     if (m_queryConnection) {
         return;
     }
-    // perform querying for the services in a thread
-    QFutureWatcher<QList<KPluginMetaData>> *watcher = new QFutureWatcher<QList<KPluginMetaData>>(this);
+    // perform querying for the services and reading the scripts in a thread
+    QFutureWatcher<QList<Package>> *watcher = new QFutureWatcher<QList<Package>>(this);
     m_queryConnection = connect(
-        watcher, &QFutureWatcher<QList<KPluginMetaData>>::finished, this, [this, watcher]() {
-            const auto effects = watcher->result();
-            for (const auto &effect : effects) {
-                const LoadEffectFlags flags = readConfig(effect.pluginId(), effect.isEnabledByDefault());
+        watcher, &QFutureWatcher<QList<Package>>::finished, this, [this, watcher]() {
+            const auto packages = watcher->result();
+            for (const auto &package : packages) {
+                const LoadEffectFlags flags = readConfig(package.metaData.pluginId(), package.metaData.isEnabledByDefault());
                 if (flags.testFlag(LoadEffectFlag::Load)) {
-                    m_queue->enqueue(qMakePair(effect, flags));
+                    m_queue->enqueue(qMakePair(package, flags), loadPriority(package.metaData));
                 }
             }
             watcher->deleteLater();
@@ -163,17 +213,43 @@ void ScriptedEffectLoader::queryAndLoadAll()
         },
         Qt::QueuedConnection);
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    watcher->setFuture(QtConcurrent::run(this, &ScriptedEffectLoader::findAllEffects));
+    watcher->setFuture(QtConcurrent::run(this, &ScriptedEffectLoader::readAllEffects));
 #else
-    watcher->setFuture(QtConcurrent::run(&ScriptedEffectLoader::findAllEffects, this));
+    watcher->setFuture(QtConcurrent::run(&ScriptedEffectLoader::readAllEffects, this));
 #endif
 }
 
+void ScriptedEffectLoader::setDeferredLoadingAllowed(bool allowed)
+{
+    AbstractEffectLoader::setDeferredLoadingAllowed(allowed);
+    m_queue->setDeferredLoadingAllowed(allowed);
+}
+
 QList<KPluginMetaData> ScriptedEffectLoader::findAllEffects() const
 {
     return KPackage::PackageLoader::self()->listPackages(s_serviceType, QStringLiteral("kwin/effects"));
 }
 
+QList<ScriptedEffectLoader::Package> ScriptedEffectLoader::readAllEffects() const
+{
+    const QList<KPluginMetaData> effects = findAllEffects();
+
+    QList<Package> packages;
+    packages.reserve(effects.count());
+    for (const KPluginMetaData &effect : effects) {
+        Package package{.metaData = effect};
+        package.scriptFile = ScriptedEffect::locateScript(effect);
+        if (!package.scriptFile.isEmpty()) {
+            QFile file(package.scriptFile);
+            if (file.open(QIODevice::ReadOnly)) {
+                package.script = file.readAll();
+            }
+        }
+        packages.append(package);
+    }
+    return packages;
+}
+
 KPluginMetaData ScriptedEffectLoader::findEffect(const QString &name) const
 {
     const auto plugins = KPackage::PackageLoader::self()->findPackages(s_serviceType, QStringLiteral("kwin/effects"),
@@ -196,6 +272,7 @@ void ScriptedEffectLoader::clear()
 PluginEffectLoader::PluginEffectLoader(QObject *parent)
     : AbstractEffectLoader(parent)
     , m_pluginSubDirectory(QStringLiteral("kwin/effects/plugins"))
+    , m_queue(new EffectLoadQueue<PluginEffectLoader, KPluginMetaData>(this))
 {
 }
 
@@ -290,6 +367,8 @@ bool PluginEffectLoader::loadEffect(const KPluginMetaData &info, LoadEffectFlags
         qCDebug(KWIN_CORE) << name << " already loaded";
         return false;
     }
+    QElapsedTimer timer;
+    timer.start();
     EffectPluginFactory *effectFactory = factory(info);
     if (!effectFactory) {
         qCDebug(KWIN_CORE) << "Couldn't get an EffectPluginFactory for: " << name;
@@ -320,7 +399,9 @@ bool PluginEffectLoader::loadEffect(const KPluginMetaData &info, LoadEffectFlags
     connect(e, &Effect::destroyed, this, [this, name]() {
         m_loadedEffects.removeAll(name);
     });
-    qCDebug(KWIN_CORE) << "Successfully loaded plugin effect: " << name;
+    const auto loadTime = std::chrono::microseconds(timer.nsecsElapsed() / 1000);
+    recordLoadTime(name, loadTime);
+    qCDebug(KWIN_CORE) << "Successfully loaded plugin effect: " << name << "in" << loadTime.count() << "us";
     Q_EMIT effectLoaded(e, name);
     return true;
 }
@@ -330,12 +411,23 @@ void PluginEffectLoader::queryAndLoadAll()
     const auto effects = findAllEffects();
     for (const auto &effect : effects) {
         const LoadEffectFlags flags = readConfig(effect.pluginId(), effect.isEnabledByDefault());
-        if (flags.testFlag(LoadEffectFlag::Load)) {
+        if (!flags.testFlag(LoadEffectFlag::Load)) {
+            continue;
+        }
+        if (loadPriority(effect) == EffectLoadPriority::Deferred) {
+            m_queue->enqueue(qMakePair(effect, flags), EffectLoadPriority::Deferred);
+        } else {
             loadEffect(effect, flags);
         }
     }
 }
 
+void PluginEffectLoader::setDeferredLoadingAllowed(bool allowed)
+{
+    AbstractEffectLoader::setDeferredLoadingAllowed(allowed);
+    m_queue->setDeferredLoadingAllowed(allowed);
+}
+
 QVector<KPluginMetaData> PluginEffectLoader::findAllEffects() const
 {
     return KPluginMetaData::findPlugins(m_pluginSubDirectory);
@@ -348,6 +440,7 @@ void PluginEffectLoader::setPluginSubDirectory(const QString &directory)
 
 void PluginEffectLoader::clear()
 {
+    m_queue->clear();
 }
 
 EffectLoader::EffectLoader(QObject *parent)
@@ -419,4 +512,21 @@ void EffectLoader::clear()
     }
 }
 
+void EffectLoader::setDeferredLoadingAllowed(bool allowed)
+{
+    AbstractEffectLoader::setDeferredLoadingAllowed(allowed);
+    for (auto it = m_loaders.constBegin(); it != m_loaders.constEnd(); ++it) {
+        (*it)->setDeferredLoadingAllowed(allowed);
+    }
+}
+
+QHash<QString, std::chrono::microseconds> EffectLoader::loadTimes() const
+{
+    QHash<QString, std::chrono::microseconds> result;
+    for (auto it = m_loaders.constBegin(); it != m_loaders.constEnd(); ++it) {
+        result.insert((*it)->loadTimes());
+    }
+    return result;
+}
+
 } // namespace KWin
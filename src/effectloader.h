@@ -12,13 +12,17 @@
 #include <KPluginMetaData>
 #include <KSharedConfig>
 // Qt
+#include <QAbstractEventDispatcher>
 #include <QFlags>
+#include <QHash>
 #include <QMap>
 #include <QObject>
 #include <QPair>
 #include <QQueue>
 #include <QStaticPlugin>
 
+#include <chrono>
+
 namespace KWin
 {
 class Effect;
@@ -38,6 +42,18 @@ enum class LoadEffectFlag {
 };
 Q_DECLARE_FLAGS(LoadEffectFlags, LoadEffectFlag)
 
+/**
+ * @brief When queryAndLoadAll() loads an Effect.
+ *
+ * Effects declare that they can be loaded later with the "X-KWin-Load-Deferred" key in the
+ * metadata of scripted effects, or the "loadDeferred" key in the "org.kde.kwin.effect" object
+ * of binary effects. These are effects that do nothing until the user invokes them.
+ */
+enum class EffectLoadPriority {
+    Startup, ///< The Effect is loaded before the first frame
+    Deferred ///< The Effect is loaded when the event loop is idle, after the first frame
+};
+
 /**
  * @brief Interface to describe how an effect loader has to function.
  *
@@ -156,6 +172,25 @@ public:
      */
     virtual void clear() = 0;
 
+    /**
+     * @brief Whether queryAndLoadAll() may load Effects with a deferred load priority.
+     *
+     * While this is @c false, the deferred Effects are only queued. Once it is set to @c true,
+     * they are loaded one by one whenever the event loop is idle. By default it is @c true.
+     *
+     * @see EffectLoadPriority
+     */
+    bool isDeferredLoadingAllowed() const;
+    virtual void setDeferredLoadingAllowed(bool allowed);
+
+    /**
+     * @brief The time it took to load each of the Effects loaded by this loader.
+     *
+     * The time covers loading the plugin or script and creating the Effect, including the
+     * compilation of shaders in its constructor.
+     */
+    virtual QHash<QString, std::chrono::microseconds> loadTimes() const;
+
 Q_SIGNALS:
     /**
      * @brief The loader emits this signal when it successfully loaded an effect.
@@ -182,8 +217,17 @@ protected:
      */
     LoadEffectFlags readConfig(const QString &effectName, bool defaultValue) const;
 
+    /**
+     * @brief Reads the EffectLoadPriority from the metadata of an Effect.
+     */
+    static EffectLoadPriority loadPriority(const KPluginMetaData &metaData);
+
+    void recordLoadTime(const QString &effectName, std::chrono::microseconds duration);
+
 private:
     KSharedConfig::Ptr m_config;
+    QHash<QString, std::chrono::microseconds> m_loadTimes;
+    bool m_deferredLoadingAllowed = true;
 };
 
 template<typename Loader, typename QueueType>
@@ -197,6 +241,11 @@ class EffectLoadQueue;
  * can ensure that events are processed between the loading of two Effects and thus the compositor
  * doesn't block.
  *
+ * Effects with the Startup priority are loaded first. Effects with the Deferred priority are held
+ * back until deferred loading is allowed, and are then loaded once no Startup effect is waiting,
+ * each time the event loop has processed all pending events and is about to wait for new ones.
+ * Either way only one Effect is loaded per event cycle.
+ *
  * As it needs to be a slot, the queue must subclass QObject, but it also needs to be templated as
  * the information to load an Effect is specific to the Effect Loader. Thus there is the
  * AbstractEffectLoadQueue providing the slots as pure virtual functions and the templated
@@ -219,6 +268,30 @@ protected Q_SLOTS:
 private:
     template<typename Loader, typename QueueType>
     friend class EffectLoadQueue;
+
+    /**
+     * Invokes dequeue() once the event loop is idle, that is when it has processed all pending
+     * events, including the ones of the render loops, and is about to wait for new ones.
+     */
+    void dequeueWhenIdle()
+    {
+        QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance();
+        if (!dispatcher) {
+            QMetaObject::invokeMethod(this, &AbstractEffectLoadQueue::dequeue, Qt::QueuedConnection);
+            return;
+        }
+        m_idleConnection = connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, [this]() {
+            disconnect(m_idleConnection);
+            // Don't load from within the dispatcher, it's about to wait for events.
+            QMetaObject::invokeMethod(this, &AbstractEffectLoadQueue::dequeue, Qt::QueuedConnection);
+        });
+    }
+    void cancelDequeueWhenIdle()
+    {
+        disconnect(m_idleConnection);
+    }
+
+    QMetaObject::Connection m_idleConnection;
 };
 
 template<typename Loader, typename QueueType>
@@ -231,41 +304,61 @@ public:
         , m_dequeueScheduled(false)
     {
     }
-    void enqueue(const QPair<QueueType, LoadEffectFlags> value)
+    void enqueue(const QPair<QueueType, LoadEffectFlags> value, EffectLoadPriority priority = EffectLoadPriority::Startup)
     {
-        m_queue.enqueue(value);
+        if (priority == EffectLoadPriority::Startup) {
+            m_queue.enqueue(value);
+        } else {
+            m_deferredQueue.enqueue(value);
+        }
         scheduleDequeue();
     }
     void clear()
     {
         m_queue.clear();
+        m_deferredQueue.clear();
         m_dequeueScheduled = false;
+        cancelDequeueWhenIdle();
+    }
+    void setDeferredLoadingAllowed(bool allowed)
+    {
+        m_deferredLoadingAllowed = allowed;
+        scheduleDequeue();
     }
 
 protected:
     void dequeue() override
     {
-        if (m_queue.isEmpty()) {
-            return;
-        }
         m_dequeueScheduled = false;
-        const auto pair = m_queue.dequeue();
-        m_effectLoader->loadEffect(pair.first, pair.second);
+        if (!m_queue.isEmpty()) {
+            const auto pair = m_queue.dequeue();
+            m_effectLoader->loadEffect(pair.first, pair.second);
+        } else if (m_deferredLoadingAllowed && !m_deferredQueue.isEmpty()) {
+            const auto pair = m_deferredQueue.dequeue();
+            m_effectLoader->loadEffect(pair.first, pair.second);
+        }
         scheduleDequeue();
     }
 
 private:
     void scheduleDequeue()
     {
-        if (m_queue.isEmpty() || m_dequeueScheduled) {
+        if (m_dequeueScheduled) {
             return;
         }
-        m_dequeueScheduled = true;
-        QMetaObject::invokeMethod(this, &AbstractEffectLoadQueue::dequeue, Qt::QueuedConnection);
+        if (!m_queue.isEmpty()) {
+            m_dequeueScheduled = true;
+            QMetaObject::invokeMethod(this, &AbstractEffectLoadQueue::dequeue, Qt::QueuedConnection);
+        } else if (m_deferredLoadingAllowed && !m_deferredQueue.isEmpty()) {
+            m_dequeueScheduled = true;
+            dequeueWhenIdle();
+        }
     }
     Loader *m_effectLoader;
     bool m_dequeueScheduled;
+    bool m_deferredLoadingAllowed = true;
     QQueue<QPair<QueueType, LoadEffectFlags>> m_queue;
+    QQueue<QPair<QueueType, LoadEffectFlags>> m_deferredQueue;
 };
 
 /**
@@ -275,6 +368,16 @@ class KWIN_EXPORT ScriptedEffectLoader : public AbstractEffectLoader
 {
     Q_OBJECT
 public:
+    /**
+     * @brief A scripted Effect together with its script, which is read in a worker thread.
+     */
+    struct Package
+    {
+        KPluginMetaData metaData;
+        QString scriptFile;
+        QByteArray script;
+    };
+
     explicit ScriptedEffectLoader(QObject *parent = nullptr);
     ~ScriptedEffectLoader() override;
 
@@ -284,14 +387,17 @@ public:
 
     void clear() override;
     void queryAndLoadAll() override;
+    void setDeferredLoadingAllowed(bool allowed) override;
     bool loadEffect(const QString &name) override;
     bool loadEffect(const KPluginMetaData &effect, LoadEffectFlags flags);
+    bool loadEffect(const Package &package, LoadEffectFlags flags);
 
 private:
     QList<KPluginMetaData> findAllEffects() const;
+    QList<Package> readAllEffects() const;
     KPluginMetaData findEffect(const QString &name) const;
     QStringList m_loadedEffects;
-    EffectLoadQueue<ScriptedEffectLoader, KPluginMetaData> *m_queue;
+    EffectLoadQueue<ScriptedEffectLoader, Package> *m_queue;
     QMetaObject::Connection m_queryConnection;
 };
 
@@ -308,6 +414,7 @@ public:
 
     void clear() override;
     void queryAndLoadAll() override;
+    void setDeferredLoadingAllowed(bool allowed) override;
     bool loadEffect(const QString &name) override;
     bool loadEffect(const KPluginMetaData &info, LoadEffectFlags flags);
 
@@ -319,6 +426,7 @@ private:
     EffectPluginFactory *factory(const KPluginMetaData &info) const;
     QStringList m_loadedEffects;
     QString m_pluginSubDirectory;
+    EffectLoadQueue<PluginEffectLoader, KPluginMetaData> *m_queue;
 };
 
 class KWIN_EXPORT EffectLoader : public AbstractEffectLoader
@@ -334,6 +442,8 @@ public:
     void queryAndLoadAll() override;
     void setConfig(KSharedConfig::Ptr config) override;
     void clear() override;
+    void setDeferredLoadingAllowed(bool allowed) override;
+    QHash<QString, std::chrono::microseconds> loadTimes() const override;
 
 private:
     QList<AbstractEffectLoader *> m_loaders;
@@ -20,6 +20,7 @@
 #endif
 #include "core/renderbackend.h"
 #include "core/renderlayer.h"
+#include "core/renderloop.h"
 #include "cursor.h"
 #include "deleted.h"
 #include "group.h"
@@ -28,6 +29,7 @@
 #include "osd.h"
 #include "pointer_input.h"
 #include "scene/itemrenderer.h"
+#include "scene/renderprofiler.h"
 #include "unmanaged.h"
 #include "x11window.h"
 #if KWIN_BUILD_TABBOX
@@ -61,6 +63,7 @@
 #include <QQuickItem>
 #include <QQuickWindow>
 #include <QStandardPaths>
+#include <QTimer>
 #include <QWheelEvent>
 
 namespace KWin
@@ -68,6 +71,9 @@ namespace KWin
 //---------------------
 // Static
 
+// The time after which deferred effects are loaded if no frame has been presented.
+static const std::chrono::milliseconds s_deferredLoadingTimeout(2000);
+
 static QByteArray readWindowProperty(xcb_window_t win, xcb_atom_t atom, xcb_atom_t type, int format)
 {
     if (win == XCB_WINDOW_NONE) {
@@ -127,11 +133,16 @@ EffectsHandlerImpl::EffectsHandlerImpl(Compositor *compositor, WorkspaceScene *s
     , m_effectLoader(new EffectLoader(this))
     , m_trackingCursorChanges(0)
 {
+    resetEffectChains();
+
     qRegisterMetaType<QVector<KWin::EffectWindow *>>();
     qRegisterMetaType<KWin::SessionState>();
     connect(m_effectLoader, &AbstractEffectLoader::effectLoaded, this, [this](Effect *effect, const QString &name) {
         effect_order.insert(effect->requestedEffectChainPosition(), EffectPair(name, effect));
         loaded_effects << EffectPair(name, effect);
+        connect(effect, &Effect::activeChanged, this, [this]() {
+            m_effectChainsDirty = true;
+        });
         effectsChanged();
     });
     m_effectLoader->setConfig(kwinApp()->config());
@@ -269,7 +280,20 @@ EffectsHandlerImpl::EffectsHandlerImpl(Compositor *compositor, WorkspaceScene *s
         connect(inputMethod, &InputMethod::panelChanged, this, &EffectsHandlerImpl::inputPanelChanged);
     }
 
+    // Only load the effects that are needed for the first frame right away. The others are
+    // loaded in idle time once a frame has been presented, or after a timeout otherwise.
+    m_effectLoader->setDeferredLoadingAllowed(false);
     reconfigure();
+
+    QObject *firstFrameGuard = new QObject(this);
+    const auto allowDeferredLoading = [this, firstFrameGuard]() {
+        m_effectLoader->setDeferredLoadingAllowed(true);
+        firstFrameGuard->deleteLater();
+    };
+    for (Output *output : outputs) {
+        connect(output->renderLoop(), &RenderLoop::framePresented, firstFrameGuard, allowDeferredLoading);
+    }
+    QTimer::singleShot(s_deferredLoadingTimeout, firstFrameGuard, allowDeferredLoading);
 }
 
 EffectsHandlerImpl::~EffectsHandlerImpl()
@@ -380,59 +404,126 @@ void EffectsHandlerImpl::reconfigure()
     m_effectLoader->queryAndLoadAll();
 }
 
+template<typename Hook>
+void EffectsHandlerImpl::callEffect(const EffectChain::Entry &entry, Hook &&hook)
+{
+    RenderProfiler *profiler = m_compositor->renderProfiler();
+    if (Q_LIKELY(!profiler->isEnabled())) {
+        hook(entry.effect);
+        return;
+    }
+    profiler->beginScope();
+    hook(entry.effect);
+    profiler->addEffectTime(entry.name, profiler->endScope());
+}
+
+template<typename Function>
+void EffectsHandlerImpl::callScene(Function &&function)
+{
+    // The time spent in the scene is not accounted to the effects that have called it.
+    RenderProfiler *profiler = m_compositor->renderProfiler();
+    if (Q_LIKELY(!profiler->isEnabled())) {
+        function();
+        return;
+    }
+    profiler->beginScope();
+    function();
+    profiler->endScope();
+}
+
 // the idea is that effects call this function again which calls the next one
 void EffectsHandlerImpl::prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseconds presentTime)
 {
-    if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->prePaintScreen(data, presentTime);
-        --m_currentPaintScreenIterator;
+    EffectChain &chain = m_prePaintScreenChain;
+    if (chain.current != chain.entries.cend()) {
+        callEffect(*(chain.current++), [&](Effect *effect) {
+            effect->prePaintScreen(data, presentTime);
+        });
+        --chain.current;
     }
     // no special final code
 }
 
 void EffectsHandlerImpl::paintScreen(int mask, const QRegion &region, ScreenPaintData &data)
 {
-    if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->paintScreen(mask, region, data);
-        --m_currentPaintScreenIterator;
+    EffectChain &chain = m_paintScreenChain;
+    if (chain.current != chain.entries.cend()) {
+        callEffect(*(chain.current++), [&](Effect *effect) {
+            effect->paintScreen(mask, region, data);
+        });
+        --chain.current;
     } else {
-        m_scene->finalPaintScreen(mask, region, data);
+        callScene([&]() {
+            m_scene->finalPaintScreen(mask, region, data);
+        });
     }
 }
 
 void EffectsHandlerImpl::postPaintScreen()
 {
-    if (m_currentPaintScreenIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintScreenIterator++)->postPaintScreen();
-        --m_currentPaintScreenIterator;
+    EffectChain &chain = m_postPaintScreenChain;
+    if (chain.current != chain.entries.cend()) {
+        callEffect(*(chain.current++), [](Effect *effect) {
+            effect->postPaintScreen();
+        });
+        --chain.current;
     }
     // no special final code
 }
 
+EffectsHandlerImpl::EffectChain::Iterator EffectsHandlerImpl::EffectChain::next(const EffectWindow *window) const
+{
+    Iterator it = current;
+    while (it != entries.cend() && it->filterWindows && !window->hasEffectInterest(it->effect)) {
+        ++it;
+    }
+    return it;
+}
+
 void EffectsHandlerImpl::prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::chrono::milliseconds presentTime)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->prePaintWindow(w, data, presentTime);
-        --m_currentPaintWindowIterator;
+    EffectChain &chain = m_prePaintWindowChain;
+    const EffectChain::Iterator current = chain.current;
+    const EffectChain::Iterator next = chain.next(w);
+    if (next != chain.entries.cend()) {
+        chain.current = next + 1;
+        callEffect(*next, [&](Effect *effect) {
+            effect->prePaintWindow(w, data, presentTime);
+        });
+        chain.current = current;
     }
     // no special final code
 }
 
 void EffectsHandlerImpl::paintWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->paintWindow(w, mask, region, data);
-        --m_currentPaintWindowIterator;
+    EffectChain &chain = m_paintWindowChain;
+    const EffectChain::Iterator current = chain.current;
+    const EffectChain::Iterator next = chain.next(w);
+    if (next != chain.entries.cend()) {
+        chain.current = next + 1;
+        callEffect(*next, [&](Effect *effect) {
+            effect->paintWindow(w, mask, region, data);
+        });
+        chain.current = current;
     } else {
-        m_scene->finalPaintWindow(static_cast<EffectWindowImpl *>(w), mask, region, data);
+        callScene([&]() {
+            m_scene->finalPaintWindow(static_cast<EffectWindowImpl *>(w), mask, region, data);
+        });
     }
 }
 
 void EffectsHandlerImpl::postPaintWindow(EffectWindow *w)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->postPaintWindow(w);
-        --m_currentPaintWindowIterator;
+    EffectChain &chain = m_postPaintWindowChain;
+    const EffectChain::Iterator current = chain.current;
+    const EffectChain::Iterator next = chain.next(w);
+    if (next != chain.entries.cend()) {
+        chain.current = next + 1;
+        callEffect(*next, [&](Effect *effect) {
+            effect->postPaintWindow(w);
+        });
+        chain.current = current;
     }
     // no special final code
 }
@@ -449,17 +540,27 @@ Effect *EffectsHandlerImpl::provides(Effect::Feature ef)
 
 void EffectsHandlerImpl::drawWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data)
 {
-    if (m_currentDrawWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentDrawWindowIterator++)->drawWindow(w, mask, region, data);
-        --m_currentDrawWindowIterator;
+    EffectChain &chain = m_drawWindowChain;
+    const EffectChain::Iterator current = chain.current;
+    const EffectChain::Iterator next = chain.next(w);
+    if (next != chain.entries.cend()) {
+        chain.current = next + 1;
+        callEffect(*next, [&](Effect *effect) {
+            effect->drawWindow(w, mask, region, data);
+        });
+        chain.current = current;
     } else {
-        m_scene->finalDrawWindow(static_cast<EffectWindowImpl *>(w), mask, region, data);
+        callScene([&]() {
+            m_scene->finalDrawWindow(static_cast<EffectWindowImpl *>(w), mask, region, data);
+        });
     }
 }
 
 void EffectsHandlerImpl::renderWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data)
 {
-    m_scene->finalDrawWindow(static_cast<EffectWindowImpl *>(w), mask, region, data);
+    callScene([&]() {
+        m_scene->finalDrawWindow(static_cast<EffectWindowImpl *>(w), mask, region, data);
+    });
 }
 
 bool EffectsHandlerImpl::hasDecorationShadows() const
@@ -475,16 +576,92 @@ bool EffectsHandlerImpl::decorationsHaveAlpha() const
 // start another painting pass
 void EffectsHandlerImpl::startPaint()
 {
+    if (m_effectChainsDirty || activeEffectsChanged()) {
+        rebuildEffectChains();
+    }
+    resetEffectChains();
+}
+
+bool EffectsHandlerImpl::activeEffectsChanged() const
+{
+    // Only the effects that don't emit activeChanged() have to be asked every frame.
+    return std::any_of(m_polledEffects.cbegin(), m_polledEffects.cend(), [](const auto &polled) {
+        return polled.first->isActive() != polled.second;
+    });
+}
+
+std::array<std::pair<EffectsHandlerImpl::EffectChain *, Effect::PaintHook>, 7> EffectsHandlerImpl::effectChains()
+{
+    return {{
+        {&m_prePaintScreenChain, Effect::PrePaintScreenHook},
+        {&m_paintScreenChain, Effect::PaintScreenHook},
+        {&m_postPaintScreenChain, Effect::PostPaintScreenHook},
+        {&m_prePaintWindowChain, Effect::PrePaintWindowHook},
+        {&m_paintWindowChain, Effect::PaintWindowHook},
+        {&m_postPaintWindowChain, Effect::PostPaintWindowHook},
+        {&m_drawWindowChain, Effect::DrawWindowHook},
+    }};
+}
+
+void EffectsHandlerImpl::rebuildEffectChains()
+{
+    const auto chains = effectChains();
+    for (const auto &[chain, hook] : chains) {
+        chain->entries.clear();
+    }
+
+    constexpr Effect::PaintHooks windowHooks = Effect::PrePaintWindowHook | Effect::PaintWindowHook | Effect::PostPaintWindowHook | Effect::DrawWindowHook;
+
     m_activeEffects.clear();
-    m_activeEffects.reserve(loaded_effects.count());
-    for (QVector<KWin::EffectPair>::const_iterator it = loaded_effects.constBegin(); it != loaded_effects.constEnd(); ++it) {
-        if (it->second->isActive()) {
-            m_activeEffects << it->second;
+    m_polledEffects.clear();
+    m_paintChainStatistics.windowEffects = 0;
+    m_paintChainStatistics.filteringEffects = 0;
+    for (const EffectPair &pair : std::as_const(loaded_effects)) {
+        Effect *effect = pair.second;
+        const Effect::PaintHooks hooks = effect->paintHooks();
+        const bool active = effect->isActive();
+        if (!hooks.testFlag(Effect::NotifiesActiveChanged)) {
+            m_polledEffects.emplace_back(effect, active);
+        }
+        if (!active) {
+            continue;
+        }
+        m_activeEffects.append(effect);
+
+        const bool filterWindows = hooks.testFlag(Effect::FilterWindows);
+        for (const auto &[chain, hook] : chains) {
+            if (hooks.testFlag(hook)) {
+                chain->entries.push_back(EffectChain::Entry{
+                    .effect = effect,
+                    .filterWindows = filterWindows,
+                    .name = pair.first,
+                });
+            }
+        }
+        if (hooks & windowHooks) {
+            ++m_paintChainStatistics.windowEffects;
+            if (filterWindows) {
+                ++m_paintChainStatistics.filteringEffects;
+            }
         }
     }
-    m_currentDrawWindowIterator = m_activeEffects.constBegin();
-    m_currentPaintWindowIterator = m_activeEffects.constBegin();
-    m_currentPaintScreenIterator = m_activeEffects.constBegin();
+
+    m_paintChainStatistics.activeEffects = m_activeEffects.count();
+    m_paintChainStatistics.polledEffects = m_polledEffects.size();
+    ++m_paintChainStatistics.rebuilds;
+    m_effectChainsDirty = false;
+}
+
+void EffectsHandlerImpl::resetEffectChains()
+{
+    for (const auto &[chain, hook] : effectChains()) {
+        chain->current = chain->entries.cbegin();
+    }
+}
+
+EffectsHandlerImpl::PaintChainStatistics EffectsHandlerImpl::paintChainStatistics() const
+{
+    return m_paintChainStatistics;
 }
 
 void EffectsHandlerImpl::slotClientMaximized(Window *window, MaximizeMode maxMode)
@@ -1559,16 +1736,17 @@ void EffectsHandlerImpl::effectsChanged()
 {
     loaded_effects.clear();
     m_activeEffects.clear(); // it's possible to have a reconfigure and a quad rebuild between two paint cycles - bug #308201
+    m_polledEffects.clear();
+    for (const auto &[chain, hook] : effectChains()) {
+        chain->entries.clear();
+    }
+    m_effectChainsDirty = true;
 
     loaded_effects.reserve(effect_order.count());
     std::copy(effect_order.constBegin(), effect_order.constEnd(),
               std::back_inserter(loaded_effects));
 
-    m_activeEffects.reserve(loaded_effects.count());
-
-    m_currentPaintScreenIterator = m_activeEffects.constBegin();
-    m_currentPaintWindowIterator = m_activeEffects.constBegin();
-    m_currentDrawWindowIterator = m_activeEffects.constBegin();
+    resetEffectChains();
 }
 
 QStringList EffectsHandlerImpl::activeEffects() const
@@ -1640,10 +1818,24 @@ QString EffectsHandlerImpl::supportInformation(const QString &name) const
         }
         support += QString::fromUtf8(property.name()) + QLatin1String(": ") + (*it).second->property(property.name()).toString() + QLatin1Char('\n');
     }
+    const qint64 loadTime = effectLoadTime(name);
+    if (loadTime >= 0) {
+        support += QStringLiteral("Load time: %1 ms\n").arg(loadTime / 1000.0, 0, 'f', 2);
+    }
 
     return support;
 }
 
+qint64 EffectsHandlerImpl::effectLoadTime(const QString &name) const
+{
+    const auto loadTimes = m_effectLoader->loadTimes();
+    const auto it = loadTimes.constFind(name);
+    if (it == loadTimes.constEnd()) {
+        return -1;
+    }
+    return it->count();
+}
+
 bool EffectsHandlerImpl::isScreenLocked() const
 {
 #if KWIN_BUILD_SCREENLOCKER
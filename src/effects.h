@@ -18,7 +18,9 @@
 #include <QFont>
 #include <QHash>
 
+#include <array>
 #include <memory>
+#include <vector>
 
 class QMouseEvent;
 class QWheelEvent;
@@ -196,6 +198,33 @@ public:
      */
     bool blocksDirectScanout() const;
 
+    struct PaintChainStatistics
+    {
+        /**
+         * The number of times the paint chains have been rebuilt because the set of
+         * active effects changed.
+         */
+        quint64 rebuilds = 0;
+        /**
+         * The number of active effects.
+         */
+        int activeEffects = 0;
+        /**
+         * The number of active effects that take part in at least one window paint hook.
+         */
+        int windowEffects = 0;
+        /**
+         * The number of active effects that only paint the windows they have marked.
+         */
+        int filteringEffects = 0;
+        /**
+         * The number of loaded effects that are asked whether they are active every frame,
+         * because they don't notify about it, see Effect::NotifiesActiveChanged.
+         */
+        int polledEffects = 0;
+    };
+    PaintChainStatistics paintChainStatistics() const;
+
     KWaylandServer::Display *waylandDisplay() const override;
 
     bool animationsSupported() const override;
@@ -276,6 +305,11 @@ public Q_SLOTS:
     Q_SCRIPTABLE bool isEffectSupported(const QString &name);
     Q_SCRIPTABLE QList<bool> areEffectsSupported(const QStringList &names);
     Q_SCRIPTABLE QString supportInformation(const QString &name) const;
+    /**
+     * Returns the time it took to load the effect with the given @p name in microseconds,
+     * or -1 if the effect has not been loaded.
+     */
+    Q_SCRIPTABLE qint64 effectLoadTime(const QString &name) const;
     Q_SCRIPTABLE QString debug(const QString &name, const QString &parameter = QString()) const;
 
 protected Q_SLOTS:
@@ -332,12 +366,46 @@ private:
     void registerPropertyType(long atom, bool reg);
     void destroyEffect(Effect *effect);
 
-    typedef QVector<Effect *> EffectsList;
-    typedef EffectsList::const_iterator EffectsIterator;
-    EffectsList m_activeEffects;
-    EffectsIterator m_currentDrawWindowIterator;
-    EffectsIterator m_currentPaintWindowIterator;
-    EffectsIterator m_currentPaintScreenIterator;
+    /**
+     * The active effects that take part in one paint hook, in chain order. The chains are
+     * only rebuilt when an effect emits Effect::activeChanged(), or when one of the effects
+     * that don't notify about it changes its mind, not every frame.
+     */
+    struct EffectChain
+    {
+        struct Entry
+        {
+            Effect *effect;
+            bool filterWindows;
+            QString name;
+        };
+        using Iterator = std::vector<Entry>::const_iterator;
+
+        Iterator next(const EffectWindow *window) const;
+
+        std::vector<Entry> entries;
+        Iterator current;
+    };
+    std::array<std::pair<EffectChain *, Effect::PaintHook>, 7> effectChains();
+    bool activeEffectsChanged() const;
+    void rebuildEffectChains();
+    void resetEffectChains();
+    template<typename Hook>
+    void callEffect(const EffectChain::Entry &entry, Hook &&hook);
+    template<typename Function>
+    void callScene(Function &&function);
+
+    QVector<Effect *> m_activeEffects;
+    std::vector<std::pair<Effect *, bool>> m_polledEffects;
+    EffectChain m_prePaintScreenChain;
+    EffectChain m_paintScreenChain;
+    EffectChain m_postPaintScreenChain;
+    EffectChain m_prePaintWindowChain;
+    EffectChain m_paintWindowChain;
+    EffectChain m_postPaintWindowChain;
+    EffectChain m_drawWindowChain;
+    bool m_effectChainsDirty = true;
+    PaintChainStatistics m_paintChainStatistics;
     typedef QHash<QByteArray, QList<Effect *>> PropertyEffectMap;
     PropertyEffectMap m_propertiesForEffects;
     QHash<QByteArray, qulonglong> m_managedProperties;
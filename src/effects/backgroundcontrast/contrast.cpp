@@ -8,6 +8,7 @@
 
 #include "contrast.h"
 #include "contrastshader.h"
+#include "softwarecontrast.h"
 // KConfigSkeleton
 
 #include "utils/xcbutils.h"
@@ -17,6 +18,7 @@
 
 #include <QCoreApplication>
 #include <QMatrix4x4>
+#include <QPainter>
 #include <QTimer>
 #include <QWindow>
 #include <cmath> // for ceil()
@@ -31,12 +33,16 @@ QTimer *ContrastEffect::s_contrastManagerRemoveTimer = nullptr;
 
 ContrastEffect::ContrastEffect()
 {
-    m_shader = std::make_unique<ContrastShader>();
-    m_shader->init();
+    if (effects->compositingType() == QPainterCompositing) {
+        m_softwareContrast = std::make_unique<SoftwareContrast>();
+    } else {
+        m_shader = std::make_unique<ContrastShader>();
+        m_shader->init();
+    }
 
     // ### Hackish way to announce support.
     //     Should be included in _NET_SUPPORTED instead.
-    if (m_shader && m_shader->isValid()) {
+    if (canContrast()) {
         if (effects->xcbConnection()) {
             m_net_wm_contrast_region = effects->announceSupportProperty(s_contrastAtomName, this);
         }
@@ -61,7 +67,7 @@ ContrastEffect::ContrastEffect()
     connect(effects, &EffectsHandler::propertyNotify, this, &ContrastEffect::slotPropertyNotify);
     connect(effects, &EffectsHandler::virtualScreenGeometryChanged, this, &ContrastEffect::slotScreenGeometryChanged);
     connect(effects, &EffectsHandler::xcbConnectionChanged, this, [this]() {
-        if (m_shader && m_shader->isValid()) {
+        if (canContrast()) {
             m_net_wm_contrast_region = effects->announceSupportProperty(s_contrastAtomName, this);
         }
     });
@@ -83,10 +89,12 @@ ContrastEffect::~ContrastEffect()
 
 void ContrastEffect::slotScreenGeometryChanged()
 {
-    effects->makeOpenGLContextCurrent();
-    if (!supported()) {
-        effects->reloadEffect(this);
-        return;
+    if (!m_softwareContrast) {
+        effects->makeOpenGLContextCurrent();
+        if (!supported()) {
+            effects->reloadEffect(this);
+            return;
+        }
     }
 
     const EffectWindowList windowList = effects->stackingOrder();
@@ -277,6 +285,10 @@ bool ContrastEffect::enabledByDefault()
 
 bool ContrastEffect::supported()
 {
+    if (effects->compositingType() == QPainterCompositing) {
+        return true;
+    }
+
     bool supported = effects->isOpenGLCompositing() && GLFramebuffer::supported();
 
     if (supported) {
@@ -291,6 +303,14 @@ bool ContrastEffect::supported()
     return supported;
 }
 
+bool ContrastEffect::canContrast() const
+{
+    if (m_softwareContrast) {
+        return true;
+    }
+    return m_shader && m_shader->isValid();
+}
+
 QRegion ContrastEffect::contrastRegion(const EffectWindow *w) const
 {
     QRegion region;
@@ -354,7 +374,7 @@ bool ContrastEffect::uploadGeometry(GLVertexBuffer *vbo, const QRegion &region,
 
 bool ContrastEffect::shouldContrast(const EffectWindow *w, int mask, const WindowPaintData &data) const
 {
-    if (!m_shader || !m_shader->isValid()) {
+    if (!canContrast()) {
         return false;
     }
 
@@ -410,7 +430,11 @@ void ContrastEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region
         }
 
         if (!shape.isEmpty()) {
-            doContrast(w, shape, screen, data.opacity(), data.projectionMatrix());
+            if (m_softwareContrast) {
+                doSoftwareContrast(w, shape, data.opacity());
+            } else {
+                doContrast(w, shape, screen, data.opacity(), data.projectionMatrix());
+            }
         }
     }
 
@@ -471,6 +495,25 @@ void ContrastEffect::doContrast(EffectWindow *w, const QRegion &shape, const QRe
     m_shader->unbind();
 }
 
+void ContrastEffect::doSoftwareContrast(EffectWindow *w, const QRegion &shape, const float opacity)
+{
+    QPainter *painter = effects->scenePainter();
+    QImage *image = painter ? dynamic_cast<QImage *>(painter->device()) : nullptr;
+    if (!image || !SoftwareContrast::isFormatSupported(image->format())) {
+        return;
+    }
+
+    // The scene painter maps the logical coordinates of the output to the pixels of the image.
+    const QTransform transform = painter->combinedTransform();
+    QRegion deviceShape;
+    for (const QRect &rect : shape) {
+        deviceShape += transform.mapRect(QRectF(rect)).toAlignedRect();
+    }
+
+    m_softwareContrast->setColorMatrix(m_windowData.value(w).colorMatrix, opacity);
+    m_softwareContrast->apply(image, deviceShape);
+}
+
 bool ContrastEffect::isActive() const
 {
     return !effects->isScreenLocked();
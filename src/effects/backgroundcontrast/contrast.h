@@ -23,6 +23,7 @@ namespace KWin
 {
 
 class ContrastShader;
+class SoftwareContrast;
 
 class ContrastEffect : public KWin::Effect
 {
@@ -39,6 +40,10 @@ public:
 
     bool provides(Feature feature) override;
     bool isActive() const override;
+    PaintHooks paintHooks() const override
+    {
+        return DrawWindowHook;
+    }
 
     int requestedEffectChainPosition() const override
     {
@@ -56,15 +61,19 @@ public Q_SLOTS:
     void slotScreenGeometryChanged();
 
 private:
+    bool canContrast() const;
     QRegion contrastRegion(const EffectWindow *w) const;
     bool shouldContrast(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateContrastRegion(EffectWindow *w);
     void doContrast(EffectWindow *w, const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection);
+    void doSoftwareContrast(EffectWindow *w, const QRegion &shape, const float opacity);
     void uploadRegion(QVector2D *&map, const QRegion &region, qreal scale);
     Q_REQUIRED_RESULT bool uploadGeometry(GLVertexBuffer *vbo, const QRegion &region, qreal scale);
 
 private:
     std::unique_ptr<ContrastShader> m_shader;
+    // used instead of the shader with QPainter compositing
+    std::unique_ptr<SoftwareContrast> m_softwareContrast;
     long m_net_wm_contrast_region = 0;
     QHash<const EffectWindow *, QMetaObject::Connection> m_contrastChangedConnections; // used only in Wayland to keep track of effect changed
     struct Data
@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "softwarecontrast.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace KWin
+{
+
+using Channels = SoftwareContrast::Channels;
+
+// The color matrix indices of the blue, green, red and alpha bytes of a 32-bit pixel.
+static const int s_channelIndices[4] = {2, 1, 0, 3};
+
+void SoftwareContrast::setColorMatrix(const QMatrix4x4 &matrix, qreal opacity)
+{
+    const QMatrix4x4 blended = opacity >= 1.0 ? matrix : matrix * opacity + QMatrix4x4() * (1.0 - opacity);
+
+    // The shader computes tex * colorMatrix, so an input channel contributes a row of the matrix.
+    for (int input = 0; input < 4; ++input) {
+        for (int output = 0; output < 4; ++output) {
+            const float coefficient = blended(s_channelIndices[input], s_channelIndices[output]);
+            m_rows[input][output] = std::lround(coefficient * (1 << 16));
+        }
+    }
+}
+
+bool SoftwareContrast::isFormatSupported(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void SoftwareContrast::apply(QImage *image, const QRegion &region) const
+{
+    Q_ASSERT(isFormatSupported(image->format()));
+
+    const bool opaque = image->format() == QImage::Format_RGB32;
+    const QRegion clipped = region & image->rect();
+    for (const QRect &rect : clipped) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            uint32_t *row = reinterpret_cast<uint32_t *>(image->scanLine(y)) + rect.x();
+            for (int x = 0; x < rect.width(); ++x) {
+                const uint32_t pixel = row[x];
+                const int32_t alpha = opaque ? 0xFF : pixel >> 24;
+                Channels value = m_rows[0] * int32_t(pixel & 0xFF)
+                    + m_rows[1] * int32_t((pixel >> 8) & 0xFF)
+                    + m_rows[2] * int32_t((pixel >> 16) & 0xFF)
+                    + m_rows[3] * alpha;
+                value = (value + (1 << 15)) >> 16;
+
+                // Keep the result premultiplied, the color channels can't exceed the alpha.
+                const int32_t a = opaque ? 0xFF : std::clamp(value[3], 0, 0xFF);
+                const int32_t b = std::clamp(value[0], 0, a);
+                const int32_t g = std::clamp(value[1], 0, a);
+                const int32_t r = std::clamp(value[2], 0, a);
+                row[x] = uint32_t(b) | (uint32_t(g) << 8) | (uint32_t(r) << 16) | (uint32_t(a) << 24);
+            }
+        }
+    }
+}
+
+} // namespace KWin
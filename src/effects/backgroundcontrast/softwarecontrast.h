@@ -0,0 +1,53 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QImage>
+#include <QMatrix4x4>
+#include <QRegion>
+
+namespace KWin
+{
+
+/**
+ * The SoftwareContrast class applies the color matrix of the background contrast effect to parts
+ * of a raster image on the CPU, for the QPainter compositor.
+ *
+ * Pixels are transformed like the contrast shader does it, as premultiplied row vectors that are
+ * multiplied with the color matrix. The matrix is converted to fixed point once, and the four
+ * channels of a pixel are computed together as one vector.
+ */
+class SoftwareContrast
+{
+public:
+    // The four channels of a pixel, in the order of the bytes of a 32-bit pixel.
+    typedef int32_t Channels __attribute__((vector_size(16)));
+
+    /**
+     * Sets the color matrix, and the @a opacity with which it is blended with the identity
+     * matrix, as the shader does it.
+     */
+    void setColorMatrix(const QMatrix4x4 &matrix, qreal opacity);
+
+    /**
+     * Transforms the pixels of @a region of @a image, in device pixels.
+     */
+    void apply(QImage *image, const QRegion &region) const;
+
+    static bool isFormatSupported(QImage::Format format);
+
+private:
+    // The rows of the color matrix in 16.16 fixed point, one per input channel.
+    Channels m_rows[4] = {
+        Channels{1 << 16, 0, 0, 0},
+        Channels{0, 1 << 16, 0, 0},
+        Channels{0, 0, 1 << 16, 0},
+        Channels{0, 0, 0, 1 << 16},
+    };
+};
+
+} // namespace KWin
@@ -8,6 +8,7 @@
 
 #include "blur.h"
 #include "blurshader.h"
+#include "softwareblur.h"
 // KConfigSkeleton
 #include "blurconfig.h"
 
@@ -18,10 +19,12 @@
 
 #include <QGuiApplication>
 #include <QMatrix4x4>
+#include <QPainter>
 #include <QScreen>
 #include <QTime>
 #include <QTimer>
 #include <QWindow>
+#include <algorithm>
 #include <cmath> // for ceil()
 #include <cstdlib>
 
@@ -41,14 +44,18 @@ QTimer *BlurEffect::s_blurManagerRemoveTimer = nullptr;
 BlurEffect::BlurEffect()
 {
     initConfig<BlurConfig>();
-    m_shader = new BlurShader(this);
+    if (effects->compositingType() == QPainterCompositing) {
+        m_softwareBlur = std::make_unique<SoftwareBlur>();
+    } else {
+        m_shader = new BlurShader(this);
+    }
 
     initBlurStrengthValues();
     reconfigure(ReconfigureAll);
 
     // ### Hackish way to announce support.
     //     Should be included in _NET_SUPPORTED instead.
-    if (m_shader && m_shader->isValid() && m_renderTargetsValid) {
+    if (canBlur()) {
         if (effects->xcbConnection()) {
             net_wm_blur_region = effects->announceSupportProperty(s_blurAtomName, this);
         }
@@ -73,8 +80,9 @@ BlurEffect::BlurEffect()
     connect(effects, &EffectsHandler::windowDecorationChanged, this, &BlurEffect::setupDecorationConnections);
     connect(effects, &EffectsHandler::propertyNotify, this, &BlurEffect::slotPropertyNotify);
     connect(effects, &EffectsHandler::virtualScreenGeometryChanged, this, &BlurEffect::slotScreenGeometryChanged);
+    connect(effects, &EffectsHandler::screenRemoved, this, &BlurEffect::slotScreenRemoved);
     connect(effects, &EffectsHandler::xcbConnectionChanged, this, [this]() {
-        if (m_shader && m_shader->isValid() && m_renderTargetsValid) {
+        if (canBlur()) {
             net_wm_blur_region = effects->announceSupportProperty(s_blurAtomName, this);
         }
     });
@@ -97,45 +105,90 @@ BlurEffect::~BlurEffect()
 
 void BlurEffect::slotScreenGeometryChanged()
 {
-    effects->makeOpenGLContextCurrent();
-    updateTexture();
+    if (!m_softwareBlur) {
+        // The render targets are recreated with the new size of the outputs when they are painted.
+        effects->makeOpenGLContextCurrent();
+        deleteFBOs();
+        effects->doneOpenGLContextCurrent();
+    }
 
     // Fetch the blur regions for all windows
     const auto stackingOrder = effects->stackingOrder();
     for (EffectWindow *window : stackingOrder) {
         updateBlurRegion(window);
     }
+}
+
+void BlurEffect::slotScreenRemoved(EffectScreen *screen)
+{
+    auto it = m_renderTargetPools.find(screen);
+    if (it == m_renderTargetPools.end()) {
+        return;
+    }
+    if (m_renderTargets == it->second.get()) {
+        m_renderTargets = nullptr;
+    }
+    if (m_currentScreen == screen) {
+        m_currentScreen = nullptr;
+    }
+    effects->makeOpenGLContextCurrent();
+    m_renderTargetPools.erase(it);
     effects->doneOpenGLContextCurrent();
 }
 
-bool BlurEffect::renderTargetsValid() const
+bool BlurEffect::canBlur() const
 {
-    return !m_renderTargets.isEmpty() && std::find_if(m_renderTargets.cbegin(), m_renderTargets.cend(), [](const GLFramebuffer *target) {
-                                             return !target->valid();
-                                         })
-        == m_renderTargets.cend();
+    if (m_softwareBlur) {
+        return true;
+    }
+    return m_shader && m_shader->isValid() && m_renderTargetsValid;
 }
 
-void BlurEffect::deleteFBOs()
+bool BlurRenderTargets::isValid() const
 {
-    qDeleteAll(m_renderTargets);
-    qDeleteAll(m_renderTextures);
+    return !renderTargets.empty() && std::all_of(renderTargets.cbegin(), renderTargets.cend(), [](const auto &target) {
+        return target->valid();
+    });
+}
 
-    m_renderTargets.clear();
-    m_renderTextures.clear();
+static qint64 textureMemory(const GLTexture *texture)
+{
+    // All render targets use formats with four bytes per pixel.
+    return qint64(texture->width()) * texture->height() * 4;
 }
 
-void BlurEffect::updateTexture()
+qint64 BlurRenderTargets::memoryUsage() const
 {
-    deleteFBOs();
+    qint64 bytes = 0;
+    for (const auto &texture : renderTextures) {
+        bytes += textureMemory(texture.get());
+    }
+    for (const auto &[window, cachedBlur] : cache) {
+        bytes += textureMemory(cachedBlur.texture.get());
+    }
+    return bytes;
+}
+
+void BlurEffect::deleteFBOs()
+{
+    m_renderTargets = nullptr;
+    m_renderTargetPools.clear();
+    m_staticBackground.clear();
+}
+
+std::unique_ptr<BlurRenderTargets> BlurEffect::createRenderTargets(const QSize &size, qreal scale) const
+{
+    auto targets = std::make_unique<BlurRenderTargets>();
+    targets->size = size;
+    targets->scale = scale;
 
     /* Reserve memory for:
      *  - The original sized texture (1)
      *  - The downsized textures (m_downSampleIterations)
      *  - The helper texture (1)
      */
-    m_renderTargets.reserve(m_downSampleIterations + 2);
-    m_renderTextures.reserve(m_downSampleIterations + 2);
+    targets->renderTargets.reserve(m_downSampleIterations + 2);
+    targets->renderTextures.reserve(m_downSampleIterations + 2);
 
     GLenum textureFormat = GL_RGBA8;
 
@@ -166,43 +219,76 @@ void BlurEffect::updateTexture()
     // coordinates - this means that when using high DPI screens the underlying
     // texture will be low DPI. This isn't really visible since we're blurring
     // anyway.
-    const auto screenSize = effects->virtualScreenSize();
     for (int i = 0; i <= m_downSampleIterations; i++) {
-        m_renderTextures.append(new GLTexture(textureFormat, screenSize / (1 << i)));
-        m_renderTextures.constLast()->setFilter(GL_LINEAR);
-        m_renderTextures.constLast()->setWrapMode(GL_CLAMP_TO_EDGE);
+        auto texture = std::make_unique<GLTexture>(textureFormat, size / (1 << i));
+        texture->setFilter(GL_LINEAR);
+        texture->setWrapMode(GL_CLAMP_TO_EDGE);
 
-        m_renderTargets.append(new GLFramebuffer(m_renderTextures.constLast()));
+        targets->renderTargets.push_back(std::make_unique<GLFramebuffer>(texture.get()));
+        targets->renderTextures.push_back(std::move(texture));
     }
 
     // This last set is used as a temporary helper texture
-    m_renderTextures.append(new GLTexture(textureFormat, screenSize));
-    m_renderTextures.constLast()->setFilter(GL_LINEAR);
-    m_renderTextures.constLast()->setWrapMode(GL_CLAMP_TO_EDGE);
-
-    m_renderTargets.append(new GLFramebuffer(m_renderTextures.constLast()));
+    auto helperTexture = std::make_unique<GLTexture>(textureFormat, size);
+    helperTexture->setFilter(GL_LINEAR);
+    helperTexture->setWrapMode(GL_CLAMP_TO_EDGE);
 
-    m_renderTargetsValid = renderTargetsValid();
+    targets->renderTargets.push_back(std::make_unique<GLFramebuffer>(helperTexture.get()));
+    targets->renderTextures.push_back(std::move(helperTexture));
 
     // Prepare the stack for the rendering
-    m_renderTargetStack.clear();
-    m_renderTargetStack.reserve(m_downSampleIterations * 2);
+    targets->renderTargetStack.reserve(m_downSampleIterations * 2);
 
     // Upsample
     for (int i = 1; i < m_downSampleIterations; i++) {
-        m_renderTargetStack.push(m_renderTargets[i]);
+        targets->renderTargetStack.push(targets->renderTargets[i].get());
     }
 
     // Downsample
     for (int i = m_downSampleIterations; i > 0; i--) {
-        m_renderTargetStack.push(m_renderTargets[i]);
+        targets->renderTargetStack.push(targets->renderTargets[i].get());
     }
 
     // Copysample
-    m_renderTargetStack.push(m_renderTargets[0]);
+    targets->renderTargetStack.push(targets->renderTargets[0].get());
+
+    return targets;
+}
+
+BlurRenderTargets *BlurEffect::renderTargetsForScreen(EffectScreen *screen)
+{
+    // The render target covers one output on Wayland, and all of them on X11.
+    const QSize size = effects->renderTargetRect().size();
+    const qreal scale = effects->renderTargetScale();
+
+    std::unique_ptr<BlurRenderTargets> &targets = m_renderTargetPools[screen];
+    if (!targets || targets->size != size || targets->scale != scale) {
+        if (m_renderTargets == targets.get()) {
+            m_renderTargets = nullptr;
+        }
+        targets = createRenderTargets(size, scale);
+        m_renderTargetsValid = targets->isValid();
+    }
+    return targets.get();
+}
 
-    // Invalidate noise texture
-    m_noiseTexture.reset();
+int BlurEffect::renderTargetPoolCount() const
+{
+    return m_renderTargetPools.size();
+}
+
+qint64 BlurEffect::renderTargetMemory() const
+{
+    qint64 bytes = 0;
+    for (const auto &[screen, targets] : m_renderTargetPools) {
+        bytes += targets->memoryUsage();
+    }
+    return bytes;
+}
+
+qint64 BlurEffect::cachedBlurHits() const
+{
+    return m_cachedBlurHits;
 }
 
 void BlurEffect::initBlurStrengthValues()
@@ -275,7 +361,11 @@ void BlurEffect::reconfigure(ReconfigureFlags flags)
 
     m_scalingFactor = std::max(1.0, QGuiApplication::primaryScreen()->logicalDotsPerInch() / 96.0);
 
-    updateTexture();
+    if (!m_softwareBlur) {
+        deleteFBOs();
+        m_renderTargetsValid = true;
+        m_noiseTexture.reset();
+    }
 
     // Update all windows for the blur to take effect
     effects->addRepaintFull();
@@ -348,6 +438,21 @@ void BlurEffect::slotWindowAdded(EffectWindow *w)
 
 void BlurEffect::slotWindowDeleted(EffectWindow *w)
 {
+    m_staticBackground.remove(w);
+    bool contextCurrent = false;
+    for (auto &[screen, targets] : m_renderTargetPools) {
+        if (targets->cache.count(w)) {
+            if (!contextCurrent) {
+                effects->makeOpenGLContextCurrent();
+                contextCurrent = true;
+            }
+            targets->cache.erase(w);
+        }
+    }
+    if (contextCurrent) {
+        effects->doneOpenGLContextCurrent();
+    }
+
     auto it = windowBlurChangedConnections.find(w);
     if (it == windowBlurChangedConnections.end()) {
         return;
@@ -411,15 +516,30 @@ bool BlurEffect::enabledByDefault()
 
 bool BlurEffect::supported()
 {
+    if (effects->compositingType() == QPainterCompositing) {
+        return true;
+    }
+
     bool supported = effects->isOpenGLCompositing() && GLFramebuffer::supported() && GLFramebuffer::blitSupported();
 
     if (supported) {
         int maxTexSize;
         glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexSize);
 
-        const QSize screenSize = effects->virtualScreenSize();
-        if (screenSize.width() > maxTexSize || screenSize.height() > maxTexSize) {
-            supported = false;
+        // The render targets are as big as the outputs on Wayland, and as the whole screen on X11.
+        QList<QSize> sizes;
+        if (effects->waylandDisplay()) {
+            const auto screens = effects->screens();
+            for (const EffectScreen *screen : screens) {
+                sizes.append(screen->geometry().size());
+            }
+        } else {
+            sizes.append(effects->virtualScreenSize());
+        }
+        for (const QSize &size : std::as_const(sizes)) {
+            if (size.width() > maxTexSize || size.height() > maxTexSize) {
+                supported = false;
+            }
         }
     }
     return supported;
@@ -537,8 +657,41 @@ void BlurEffect::prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseco
 {
     m_paintedArea = QRegion();
     m_currentBlur = QRegion();
+    m_windowDamage = QRegion();
+    m_animatedArea = QRegion();
+    m_unknownDamage = QRegion();
+    m_staticBackground.clear();
 
     effects->prePaintScreen(data, presentTime);
+
+    // The render targets of an output are only allocated once something is blurred on it.
+    m_currentScreen = data.screen;
+    m_renderTargets = nullptr;
+    if (auto pool = m_renderTargetPools.find(data.screen); pool != m_renderTargetPools.end()) {
+        m_renderTargets = pool->second.get();
+
+        // Forget the blurred backgrounds of windows that are not going to be painted for a while.
+        for (auto it = m_renderTargets->cache.begin(); it != m_renderTargets->cache.end();) {
+            const EffectWindow *window = it->first;
+            if (window->isMinimized() || !window->isOnCurrentDesktop()) {
+                it = m_renderTargets->cache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // Blurred backgrounds can't be reused if the windows are painted with transformations.
+    m_blurCacheAllowed = !(data.mask & (PAINT_SCREEN_TRANSFORMED | PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS));
+}
+
+void BlurEffect::paintScreen(int mask, const QRegion &region, ScreenPaintData &data)
+{
+    // Areas can be repainted without a window asking for it, for example when a window
+    // beneath a blurred window is closed or an effect repaints part of the screen.
+    m_unknownDamage = region - m_windowDamage;
+
+    effects->paintScreen(mask, region, data);
 }
 
 void BlurEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::chrono::milliseconds presentTime)
@@ -547,7 +700,7 @@ void BlurEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::
 
     effects->prePaintWindow(w, data, presentTime);
 
-    if (!m_shader || !m_shader->isValid()) {
+    if (!m_softwareBlur && (!m_shader || !m_shader->isValid())) {
         return;
     }
 
@@ -575,6 +728,12 @@ void BlurEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::
     const QRegion blurArea = blurRegion(w).translated(w->pos().toPoint()) & screen;
     const QRegion expandedBlur = (w->isDock() ? blurArea : expand(blurArea)) & screen;
 
+    // if nothing underneath the blurred area is painted again, the blurred background
+    // from the last frame can be reused
+    if (m_blurCacheAllowed && !expandedBlur.isEmpty() && !m_paintedArea.intersects(expandedBlur) && !m_animatedArea.intersects(expandedBlur)) {
+        m_staticBackground.insert(w);
+    }
+
     // if this window or a window underneath the blurred area is painted again we have to
     // blur everything
     if (m_paintedArea.intersects(expandedBlur) || data.paint.intersects(blurArea)) {
@@ -590,11 +749,19 @@ void BlurEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::
 
     m_paintedArea -= data.opaque;
     m_paintedArea |= data.paint;
+
+    m_windowDamage |= data.paint;
+    // windows that are transformed or faded by effects can look different without being damaged
+    if (data.mask & PAINT_WINDOW_TRANSFORMED) {
+        m_animatedArea = infiniteRegion();
+    } else if (data.mask & PAINT_WINDOW_TRANSLUCENT) {
+        m_animatedArea |= w->expandedGeometry().toAlignedRect();
+    }
 }
 
 bool BlurEffect::shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const
 {
-    if (!m_renderTargetsValid || !m_shader || !m_shader->isValid()) {
+    if (!canBlur()) {
         return false;
     }
 
@@ -652,6 +819,7 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
         EffectWindow *modal = w->transientFor();
         const bool transientForIsDock = (modal ? modal->isDock() : false);
 
+        const QRegion completeShape = shape;
         shape &= region;
 
         // Note that we render blurring in logical coordinates since the
@@ -662,7 +830,12 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
         projectionMatrix.ortho(screen);
 
         if (!shape.isEmpty()) {
-            doBlur(shape, screen, data.opacity(), projectionMatrix, w->isDock() || transientForIsDock, w->frameGeometry().toRect());
+            if (m_softwareBlur) {
+                doSoftwareBlur(shape, data.opacity(), w->isDock() || transientForIsDock);
+            } else if (BlurRenderTargets *targets = m_currentScreen ? renderTargetsForScreen(m_currentScreen) : nullptr; targets && targets->isValid()) {
+                m_renderTargets = targets;
+                doBlur(w, shape, shape == completeShape, screen, data.opacity(), projectionMatrix, w->isDock() || transientForIsDock, w->frameGeometry().toRect());
+            }
         }
     }
 
@@ -697,16 +870,61 @@ void BlurEffect::generateNoiseTexture()
     m_noiseTexture->setWrapMode(GL_REPEAT);
 }
 
-void BlurEffect::doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect)
+bool BlurEffect::isBackgroundStatic(const EffectWindow *w, const QRegion &expandedBlurRegion) const
+{
+    return m_staticBackground.contains(w) && !m_unknownDamage.intersects(expandedBlurRegion);
+}
+
+QRect BlurEffect::cachedBlurRect(const QRegion &expandedBlurRegion) const
+{
+    // The blurred background ends up in the first downsampled texture, the same
+    // rounding as in uploadRegion() is used to find the area that it covers.
+    const QRect bounds = expandedBlurRegion.boundingRect();
+    const QRect rect(QPoint(bounds.x() / 2, bounds.y() / 2),
+                     QPoint((bounds.x() + bounds.width()) / 2 - 1, (bounds.y() + bounds.height()) / 2 - 1));
+    return rect & QRect(QPoint(0, 0), m_renderTargets->renderTextures[1]->size());
+}
+
+void BlurEffect::storeCachedBlur(const EffectWindow *w, const QRegion &shape, const QRect &sourceRect, bool isDock)
+{
+    if (sourceRect.isEmpty()) {
+        m_renderTargets->cache.erase(w);
+        return;
+    }
+
+    BlurRenderTargets::CachedBlur &cachedBlur = m_renderTargets->cache[w];
+    if (!cachedBlur.texture || cachedBlur.texture->size() != sourceRect.size()) {
+        const GLTexture *source = m_renderTargets->renderTextures[1].get();
+        cachedBlur.texture = std::make_unique<GLTexture>(source->internalFormat(), sourceRect.size());
+        cachedBlur.texture->setFilter(GL_LINEAR);
+        cachedBlur.texture->setWrapMode(GL_CLAMP_TO_EDGE);
+        cachedBlur.framebuffer = std::make_unique<GLFramebuffer>(cachedBlur.texture.get());
+    }
+    if (!cachedBlur.framebuffer->valid()) {
+        m_renderTargets->cache.erase(w);
+        return;
+    }
+
+    GLFramebuffer::pushFramebuffer(m_renderTargets->renderTargets[1].get());
+    cachedBlur.framebuffer->blitFromFramebuffer(sourceRect, QRect());
+    GLFramebuffer::popFramebuffer();
+
+    cachedBlur.shape = shape;
+    cachedBlur.sourceRect = sourceRect;
+    cachedBlur.isDock = isDock;
+}
+
+void BlurEffect::doBlur(const EffectWindow *w, const QRegion &shape, bool completeShape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect)
 {
     // Blur would not render correctly on a secondary monitor because of wrong coordinates
     // BUG: 393723
+    const QSize targetSize = m_renderTargets->size;
     const int xTranslate = -screen.x();
-    const int yTranslate = effects->virtualScreenSize().height() - screen.height() - screen.y();
+    const int yTranslate = targetSize.height() - screen.height() - screen.y();
 
     const QRegion expandedBlurRegion = expand(shape) & expand(screen);
 
-    const bool useSRGB = m_renderTextures.constFirst()->internalFormat() == GL_SRGB8_ALPHA8;
+    const bool useSRGB = m_renderTargets->renderTextures.front()->internalFormat() == GL_SRGB8_ALPHA8;
 
     // Upload geometry for the down and upsample iterations
     GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
@@ -722,47 +940,74 @@ void BlurEffect::doBlur(const QRegion &shape, const QRect &screen, const float o
     const QRect destRect = logicalSourceRect.translated(0, yTranslate + screen.y());
     int blurRectCount = expandedBlurRegion.rectCount() * 6;
 
-    /*
-     * If the window is a dock or panel we avoid the "extended blur" effect.
-     * Extended blur is when windows that are not under the blurred area affect
-     * the final blur result.
-     * We want to avoid this on panels, because it looks really weird and ugly
-     * when maximized windows or windows near the panel affect the dock blur.
-     */
-    if (isDock) {
-        // This assumes the source frame buffer is in device coordinates, while
-        // our target framebuffer is in logical coordinates. It's a bit ugly but
-        // to fix it properly we probably need to do blits in normalized
-        // coordinates.
-        m_renderTargets.last()->blitFromFramebuffer(deviceSourceRect, destRect);
-        GLFramebuffer::pushFramebuffers(m_renderTargetStack);
+    // If nothing behind the window has been repainted, the background that was blurred
+    // in a previous frame is still valid and only needs to be copied back.
+    bool reuseCachedBlur = false;
+    auto cachedBlur = m_renderTargets->cache.find(w);
+    if (cachedBlur != m_renderTargets->cache.end()) {
+        const BlurRenderTargets::CachedBlur &cache = cachedBlur->second;
+        reuseCachedBlur = cache.isDock == isDock && (shape - cache.shape).isEmpty() && isBackgroundStatic(w, expandedBlurRegion);
+        if (reuseCachedBlur) {
+            GLFramebuffer::pushFramebuffer(cache.framebuffer.get());
+            m_renderTargets->renderTargets[1]->blitFromFramebuffer(QRect(QPoint(0, 0), cache.sourceRect.size()), cache.sourceRect);
+            GLFramebuffer::popFramebuffer();
+            m_cachedBlurHits++;
+        } else if (!completeShape) {
+            // Only part of the background is blurred again, the cached one is outdated.
+            m_renderTargets->cache.erase(cachedBlur);
+        }
+    }
 
+    if (reuseCachedBlur) {
         if (useSRGB) {
             glEnable(GL_FRAMEBUFFER_SRGB);
         }
-
-        const QRectF screenRect = effects->virtualScreenGeometry();
-        QMatrix4x4 mvp;
-        mvp.ortho(0, screenRect.width(), screenRect.height(), 0, 0, 65535);
-        copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), mvp);
     } else {
-        // This assumes the source frame buffer is in device coordinates, while
-        // our target framebuffer is in logical coordinates. It's a bit ugly but
-        // to fix it properly we probably need to do blits in normalized
-        // coordinates.
-        m_renderTargets.first()->blitFromFramebuffer(deviceSourceRect, destRect);
-        GLFramebuffer::pushFramebuffers(m_renderTargetStack);
+        /*
+         * If the window is a dock or panel we avoid the "extended blur" effect.
+         * Extended blur is when windows that are not under the blurred area affect
+         * the final blur result.
+         * We want to avoid this on panels, because it looks really weird and ugly
+         * when maximized windows or windows near the panel affect the dock blur.
+         */
+        if (isDock) {
+            // This assumes the source frame buffer is in device coordinates, while
+            // our target framebuffer is in logical coordinates. It's a bit ugly but
+            // to fix it properly we probably need to do blits in normalized
+            // coordinates.
+            m_renderTargets->renderTargets.back()->blitFromFramebuffer(deviceSourceRect, destRect);
+            GLFramebuffer::pushFramebuffers(m_renderTargets->renderTargetStack);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
 
-        if (useSRGB) {
-            glEnable(GL_FRAMEBUFFER_SRGB);
+            QMatrix4x4 mvp;
+            mvp.ortho(0, targetSize.width(), targetSize.height(), 0, 0, 65535);
+            copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), mvp);
+        } else {
+            // This assumes the source frame buffer is in device coordinates, while
+            // our target framebuffer is in logical coordinates. It's a bit ugly but
+            // to fix it properly we probably need to do blits in normalized
+            // coordinates.
+            m_renderTargets->renderTargets.front()->blitFromFramebuffer(deviceSourceRect, destRect);
+            GLFramebuffer::pushFramebuffers(m_renderTargets->renderTargetStack);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
+
+            // Remove the m_renderTargets[0] from the top of the stack that we will not use
+            GLFramebuffer::popFramebuffer();
         }
 
-        // Remove the m_renderTargets[0] from the top of the stack that we will not use
-        GLFramebuffer::popFramebuffer();
-    }
+        downSampleTexture(vbo, blurRectCount);
+        upSampleTexture(vbo, blurRectCount);
 
-    downSampleTexture(vbo, blurRectCount);
-    upSampleTexture(vbo, blurRectCount);
+        if (completeShape && m_blurCacheAllowed) {
+            storeCachedBlur(w, shape, cachedBlurRect(expandedBlurRegion.translated(xTranslate, yTranslate)), isDock);
+        }
+    }
 
     // Modulate the blurred texture with the window opacity if the window isn't opaque
     if (opacity < 1.0) {
@@ -812,12 +1057,45 @@ void BlurEffect::doBlur(const QRegion &shape, const QRect &screen, const float o
     vbo->unbindArrays();
 }
 
+int BlurEffect::softwareBlurRadius() const
+{
+    // Roughly the spread of the dual kawase blur with the same strength, limited so that the
+    // filter doesn't reach further than the area that prePaintWindow() repaints around a window.
+    const int radius = m_offset * (1 << m_downSampleIterations) / 2;
+    return std::clamp(radius, 1, std::max(1, m_expandSize / SoftwareBlur::passCount));
+}
+
+void BlurEffect::doSoftwareBlur(const QRegion &shape, const float opacity, bool isDock)
+{
+    QPainter *painter = effects->scenePainter();
+    QImage *image = painter ? dynamic_cast<QImage *>(painter->device()) : nullptr;
+    if (!image || !SoftwareBlur::isFormatSupported(image->format())) {
+        return;
+    }
+
+    // The scene painter maps the logical coordinates of the output to the pixels of the image.
+    const QTransform transform = painter->combinedTransform();
+    QRegion deviceShape;
+    for (const QRect &rect : shape) {
+        deviceShape += transform.mapRect(QRectF(rect)).toAlignedRect();
+    }
+
+    const qreal scale = effects->renderTargetScale();
+    m_softwareBlur->setRadius(std::round(softwareBlurRadius() * scale));
+
+    // Same opacity curve as for the shader based blur.
+    float o = 1.0f - opacity;
+    o = 1.0f - o * o;
+
+    m_softwareBlur->blur(image, deviceShape, o, !isDock);
+}
+
 void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition)
 {
-    m_renderTextures[1]->bind();
+    m_renderTargets->renderTextures[1]->bind();
 
     m_shader->bind(BlurShader::UpSampleType);
-    m_shader->setTargetTextureSize(m_renderTextures[0]->size() * effects->renderTargetScale());
+    m_shader->setTargetTextureSize(m_renderTargets->renderTextures[0]->size() * effects->renderTargetScale());
 
     m_shader->setOffset(m_offset);
     m_shader->setModelViewProjectionMatrix(screenProjection);
@@ -834,7 +1112,7 @@ void BlurEffect::applyNoise(GLVertexBuffer *vbo, int vboStart, int blurRectCount
     }
 
     m_shader->bind(BlurShader::NoiseSampleType);
-    m_shader->setTargetTextureSize(m_renderTextures[0]->size());
+    m_shader->setTargetTextureSize(m_renderTargets->renderTextures[0]->size());
     m_shader->setNoiseTextureSize(m_noiseTexture->size());
     m_shader->setTexturePosition(windowPosition);
 
@@ -856,13 +1134,13 @@ void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
 
     for (int i = 1; i <= m_downSampleIterations; i++) {
         modelViewProjectionMatrix.setToIdentity();
-        modelViewProjectionMatrix.ortho(0, m_renderTextures[i]->width(), m_renderTextures[i]->height(), 0, 0, 65535);
+        modelViewProjectionMatrix.ortho(0, m_renderTargets->renderTextures[i]->width(), m_renderTargets->renderTextures[i]->height(), 0, 0, 65535);
 
         m_shader->setModelViewProjectionMatrix(modelViewProjectionMatrix);
-        m_shader->setTargetTextureSize(m_renderTextures[i]->size());
+        m_shader->setTargetTextureSize(m_renderTargets->renderTextures[i]->size());
 
         // Copy the image from this texture
-        m_renderTextures[i - 1]->bind();
+        m_renderTargets->renderTextures[i - 1]->bind();
 
         vbo->draw(GL_TRIANGLES, blurRectCount * i, blurRectCount);
         GLFramebuffer::popFramebuffer();
@@ -880,13 +1158,13 @@ void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
 
     for (int i = m_downSampleIterations - 1; i >= 1; i--) {
         modelViewProjectionMatrix.setToIdentity();
-        modelViewProjectionMatrix.ortho(0, m_renderTextures[i]->width(), m_renderTextures[i]->height(), 0, 0, 65535);
+        modelViewProjectionMatrix.ortho(0, m_renderTargets->renderTextures[i]->width(), m_renderTargets->renderTextures[i]->height(), 0, 0, 65535);
 
         m_shader->setModelViewProjectionMatrix(modelViewProjectionMatrix);
-        m_shader->setTargetTextureSize(m_renderTextures[i]->size());
+        m_shader->setTargetTextureSize(m_renderTargets->renderTextures[i]->size());
 
         // Copy the image from this texture
-        m_renderTextures[i + 1]->bind();
+        m_renderTargets->renderTextures[i + 1]->bind();
 
         vbo->draw(GL_TRIANGLES, blurRectCount * i, blurRectCount);
         GLFramebuffer::popFramebuffer();
@@ -900,14 +1178,14 @@ void BlurEffect::copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount,
     m_shader->bind(BlurShader::CopySampleType);
 
     m_shader->setModelViewProjectionMatrix(screenProjection);
-    m_shader->setTargetTextureSize(effects->virtualScreenSize());
+    m_shader->setTargetTextureSize(m_renderTargets->size);
 
     /*
      * This '1' sized adjustment is necessary do avoid windows affecting the blur that are
      * right next to this window.
      */
-    m_shader->setBlurRect(blurShape.boundingRect().adjusted(1, 1, -1, -1), effects->virtualScreenSize());
-    m_renderTextures.last()->bind();
+    m_shader->setBlurRect(blurShape.boundingRect().adjusted(1, 1, -1, -1), m_renderTargets->size);
+    m_renderTargets->renderTextures.back()->bind();
 
     vbo->draw(GL_TRIANGLES, 0, blurRectCount);
     GLFramebuffer::popFramebuffer();
@@ -11,10 +11,15 @@
 #include <kwinglplatform.h>
 #include <kwinglutils.h>
 
+#include <QSet>
 #include <QStack>
 #include <QVector2D>
 #include <QVector>
 
+#include <map>
+#include <memory>
+#include <unordered_map>
+
 namespace KWaylandServer
 {
 class BlurManagerInterface;
@@ -26,10 +31,44 @@ namespace KWin
 static const int borderSize = 5;
 
 class BlurShader;
+class SoftwareBlur;
+
+/**
+ * The render targets used to blur the contents of one output, sized to the output. The pool
+ * also keeps the blurred backgrounds of the windows on that output, so they can be reused as
+ * long as nothing behind the windows is repainted.
+ */
+struct BlurRenderTargets
+{
+    struct CachedBlur
+    {
+        std::unique_ptr<GLTexture> texture;
+        std::unique_ptr<GLFramebuffer> framebuffer;
+        QRegion shape;
+        QRect sourceRect;
+        bool isDock = false;
+    };
+
+    bool isValid() const;
+    /**
+     * Returns the number of bytes of video memory used by the render targets and the cache.
+     */
+    qint64 memoryUsage() const;
+
+    QSize size;
+    qreal scale = 1;
+    std::vector<std::unique_ptr<GLTexture>> renderTextures;
+    std::vector<std::unique_ptr<GLFramebuffer>> renderTargets;
+    QStack<GLFramebuffer *> renderTargetStack;
+    std::unordered_map<const EffectWindow *, CachedBlur> cache;
+};
 
 class BlurEffect : public KWin::Effect
 {
     Q_OBJECT
+    Q_PROPERTY(int renderTargetPoolCount READ renderTargetPoolCount)
+    Q_PROPERTY(qint64 renderTargetMemory READ renderTargetMemory)
+    Q_PROPERTY(qint64 cachedBlurHits READ cachedBlurHits)
 
 public:
     BlurEffect();
@@ -40,11 +79,16 @@ public:
 
     void reconfigure(ReconfigureFlags flags) override;
     void prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseconds presentTime) override;
+    void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
     void prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::chrono::milliseconds presentTime) override;
     void drawWindow(EffectWindow *w, int mask, const QRegion &region, WindowPaintData &data) override;
 
     bool provides(Feature feature) override;
     bool isActive() const override;
+    PaintHooks paintHooks() const override
+    {
+        return PrePaintScreenHook | PaintScreenHook | PrePaintWindowHook | DrawWindowHook;
+    }
 
     int requestedEffectChainPosition() const override
     {
@@ -55,29 +99,51 @@ public:
 
     bool blocksDirectScanout() const override;
 
+    /**
+     * Returns the number of outputs that currently have render targets allocated.
+     */
+    int renderTargetPoolCount() const;
+    /**
+     * Returns the number of bytes of video memory used by the render targets of all outputs,
+     * including the cached blurred backgrounds.
+     */
+    qint64 renderTargetMemory() const;
+    /**
+     * Returns how many times a cached blurred background has been reused instead of blurring
+     * the contents of the screen again.
+     */
+    qint64 cachedBlurHits() const;
+
 public Q_SLOTS:
     void slotWindowAdded(KWin::EffectWindow *w);
     void slotWindowDeleted(KWin::EffectWindow *w);
     void slotPropertyNotify(KWin::EffectWindow *w, long atom);
     void slotScreenGeometryChanged();
+    void slotScreenRemoved(KWin::EffectScreen *screen);
     void setupDecorationConnections(EffectWindow *w);
 
 private:
+    bool canBlur() const;
     QRect expand(const QRect &rect) const;
     QRegion expand(const QRegion &region) const;
-    bool renderTargetsValid() const;
     void deleteFBOs();
     void initBlurStrengthValues();
-    void updateTexture();
+    std::unique_ptr<BlurRenderTargets> createRenderTargets(const QSize &size, qreal scale) const;
+    BlurRenderTargets *renderTargetsForScreen(EffectScreen *screen);
     QRegion blurRegion(const EffectWindow *w) const;
     QRegion decorationBlurRegion(const EffectWindow *w) const;
     bool decorationSupportsBlurBehind(const EffectWindow *w) const;
     bool shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateBlurRegion(EffectWindow *w) const;
-    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect);
+    void doBlur(const EffectWindow *w, const QRegion &shape, bool completeShape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect);
+    bool isBackgroundStatic(const EffectWindow *w, const QRegion &expandedBlurRegion) const;
+    QRect cachedBlurRect(const QRegion &expandedBlurRegion) const;
+    void storeCachedBlur(const EffectWindow *w, const QRegion &shape, const QRect &sourceRect, bool isDock);
     void uploadRegion(QVector2D *&map, const QRegion &region, const int downSampleIterations);
     Q_REQUIRED_RESULT bool uploadGeometry(GLVertexBuffer *vbo, const QRegion &blurRegion, const QRegion &windowRegion);
     void generateNoiseTexture();
+    void doSoftwareBlur(const QRegion &shape, const float opacity, bool isDock);
+    int softwareBlurRadius() const;
 
     void upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition);
     void applyNoise(GLVertexBuffer *vbo, int vboStart, int blurRectCount, const QMatrix4x4 &screenProjection, QPoint windowPosition);
@@ -86,17 +152,25 @@ private:
     void copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, const QMatrix4x4 &screenProjection);
 
 private:
-    BlurShader *m_shader;
-    QVector<GLFramebuffer *> m_renderTargets;
-    QVector<GLTexture *> m_renderTextures;
-    QStack<GLFramebuffer *> m_renderTargetStack;
+    BlurShader *m_shader = nullptr;
+    // used instead of the shaders with QPainter compositing
+    std::unique_ptr<SoftwareBlur> m_softwareBlur;
+    std::map<EffectScreen *, std::unique_ptr<BlurRenderTargets>> m_renderTargetPools;
+    BlurRenderTargets *m_renderTargets = nullptr; // the render targets of the output being painted
+    EffectScreen *m_currentScreen = nullptr;
 
     std::unique_ptr<GLTexture> m_noiseTexture;
 
-    bool m_renderTargetsValid;
+    bool m_renderTargetsValid = false;
     long net_wm_blur_region = 0;
     QRegion m_paintedArea; // keeps track of all painted areas (from bottom to top)
     QRegion m_currentBlur; // keeps track of the currently blured area of the windows(from bottom to top)
+    QRegion m_windowDamage; // all areas that windows requested to repaint in the current frame
+    QRegion m_animatedArea; // areas covered by windows that effects paint differently (from bottom to top)
+    QRegion m_unknownDamage; // repainted areas that no window requested, e.g. after a window closed
+    QSet<const EffectWindow *> m_staticBackground; // windows behind which nothing is repainted
+    bool m_blurCacheAllowed = false;
+    qint64 m_cachedBlurHits = 0;
 
     int m_downSampleIterations; // number of times the texture will be downsized to half size
     int m_offset;
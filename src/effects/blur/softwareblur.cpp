@@ -0,0 +1,180 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "softwareblur.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace KWin
+{
+
+using PixelSum = SoftwareBlur::PixelSum;
+
+static inline PixelSum unpack(uint32_t pixel)
+{
+    return PixelSum{pixel & 0xFF, (pixel >> 8) & 0xFF, (pixel >> 16) & 0xFF, pixel >> 24};
+}
+
+// Divides by the window size with a fixed point multiplication, the sums are at most 255 times
+// the window size so the product fits in 32 bits.
+static inline uint32_t pack(PixelSum sum, uint32_t multiplier)
+{
+    const PixelSum value = (sum * multiplier + (1u << 15)) >> 16;
+    return value[0] | (value[1] << 8) | (value[2] << 16) | (value[3] << 24);
+}
+
+void SoftwareBlur::setRadius(int radius)
+{
+    m_radius = std::max(1, radius);
+}
+
+int SoftwareBlur::radius() const
+{
+    return m_radius;
+}
+
+int SoftwareBlur::reach() const
+{
+    return m_radius * passCount;
+}
+
+bool SoftwareBlur::isFormatSupported(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void SoftwareBlur::blur(QImage *image, const QRegion &region, qreal opacity, bool sampleOutside)
+{
+    Q_ASSERT(isFormatSupported(image->format()));
+
+    const QRegion clipped = region & image->rect();
+    if (clipped.isEmpty()) {
+        return;
+    }
+
+    if (!sampleOutside) {
+        blurArea(image, clipped.boundingRect(), clipped, opacity);
+        return;
+    }
+
+    // Blurring every rectangle on its own reads the pixels around the rectangles several times
+    // if they are close to each other, blurring the bounding rectangle reads pixels that are
+    // not needed if they are far apart. Pick whatever touches fewer pixels.
+    const int reach = this->reach();
+    const QRect bounds = image->rect();
+    qint64 separateArea = 0;
+    for (const QRect &rect : clipped) {
+        const QRect area = rect.adjusted(-reach, -reach, reach, reach) & bounds;
+        separateArea += qint64(area.width()) * area.height();
+    }
+    const QRect boundingArea = clipped.boundingRect().adjusted(-reach, -reach, reach, reach) & bounds;
+    if (qint64(boundingArea.width()) * boundingArea.height() <= separateArea) {
+        blurArea(image, boundingArea, clipped, opacity);
+    } else {
+        for (const QRect &rect : clipped) {
+            blurArea(image, rect.adjusted(-reach, -reach, reach, reach) & bounds, rect, opacity);
+        }
+    }
+}
+
+void SoftwareBlur::blurArea(QImage *image, const QRect &area, const QRegion &region, qreal opacity)
+{
+    const int width = area.width();
+    const int height = area.height();
+    m_buffer.resize(size_t(width) * height);
+    m_scratch.resize(size_t(width) * height);
+
+    for (int y = 0; y < height; ++y) {
+        const uint32_t *row = reinterpret_cast<const uint32_t *>(image->constScanLine(area.y() + y)) + area.x();
+        std::memcpy(m_buffer.data() + size_t(y) * width, row, width * sizeof(uint32_t));
+    }
+
+    for (int pass = 0; pass < passCount; ++pass) {
+        boxBlurHorizontal(m_buffer.data(), m_scratch.data(), width, height);
+        boxBlurVertical(m_scratch.data(), m_buffer.data(), width, height);
+    }
+
+    const uint32_t alpha = std::clamp(int(opacity * 256), 0, 256);
+    for (const QRect &rect : region) {
+        const QRect target = rect & area;
+        for (int y = target.top(); y <= target.bottom(); ++y) {
+            const uint32_t *blurred = m_buffer.data() + size_t(y - area.y()) * width + (target.x() - area.x());
+            uint32_t *row = reinterpret_cast<uint32_t *>(image->scanLine(y)) + target.x();
+            if (alpha == 256) {
+                std::memcpy(row, blurred, target.width() * sizeof(uint32_t));
+                continue;
+            }
+            for (int x = 0; x < target.width(); ++x) {
+                const PixelSum mixed = unpack(blurred[x]) * alpha + unpack(row[x]) * (256 - alpha);
+                const PixelSum value = mixed >> 8;
+                row[x] = value[0] | (value[1] << 8) | (value[2] << 16) | (value[3] << 24);
+            }
+        }
+    }
+}
+
+void SoftwareBlur::boxBlurHorizontal(const uint32_t *source, uint32_t *target, int width, int height) const
+{
+    const int radius = m_radius;
+    const uint32_t multiplier = (1u << 16) / (2 * radius + 1);
+
+    for (int y = 0; y < height; ++y) {
+        const uint32_t *in = source + size_t(y) * width;
+        uint32_t *out = target + size_t(y) * width;
+
+        // Pixels outside of the row are replaced by the pixel at the edge.
+        PixelSum sum = unpack(in[0]) * uint32_t(radius + 1);
+        for (int x = 1; x <= radius; ++x) {
+            sum += unpack(in[std::min(x, width - 1)]);
+        }
+        for (int x = 0; x < width; ++x) {
+            out[x] = pack(sum, multiplier);
+            sum += unpack(in[std::min(x + radius + 1, width - 1)]);
+            sum -= unpack(in[std::max(x - radius, 0)]);
+        }
+    }
+}
+
+void SoftwareBlur::boxBlurVertical(const uint32_t *source, uint32_t *target, int width, int height)
+{
+    const int radius = m_radius;
+    const uint32_t multiplier = (1u << 16) / (2 * radius + 1);
+
+    // Slide the window down all columns at once, so the inner loops run over contiguous rows.
+    m_columnSums.assign(width, PixelSum{0, 0, 0, 0});
+    PixelSum *sums = m_columnSums.data();
+
+    auto row = [source, width, height](int y) {
+        return source + size_t(std::clamp(y, 0, height - 1)) * width;
+    };
+
+    for (int y = -radius; y <= radius; ++y) {
+        const uint32_t *in = row(y);
+        for (int x = 0; x < width; ++x) {
+            sums[x] += unpack(in[x]);
+        }
+    }
+
+    for (int y = 0; y < height; ++y) {
+        uint32_t *out = target + size_t(y) * width;
+        const uint32_t *entering = row(y + radius + 1);
+        const uint32_t *leaving = row(y - radius);
+        for (int x = 0; x < width; ++x) {
+            out[x] = pack(sums[x], multiplier);
+            sums[x] += unpack(entering[x]) - unpack(leaving[x]);
+        }
+    }
+}
+
+} // namespace KWin
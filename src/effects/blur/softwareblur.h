@@ -0,0 +1,67 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QImage>
+#include <QRegion>
+
+#include <vector>
+
+namespace KWin
+{
+
+/**
+ * The SoftwareBlur class blurs parts of a raster image on the CPU, for the QPainter compositor.
+ *
+ * The blur runs three passes of a separable box filter, which is close to a gaussian blur and
+ * costs the same per pixel no matter how large the radius is. The four channels of a pixel are
+ * processed together as one vector. Only the given region is written, and only the region
+ * plus the reach of the filter around it is read.
+ */
+class SoftwareBlur
+{
+public:
+    // The four channels of a pixel, widened so that sums over the filter window don't overflow.
+    typedef uint32_t PixelSum __attribute__((vector_size(16)));
+
+    /**
+     * The number of box filter passes.
+     */
+    static constexpr int passCount = 3;
+
+    /**
+     * Sets the radius of a single box filter pass, in device pixels.
+     */
+    void setRadius(int radius);
+    int radius() const;
+
+    /**
+     * Returns how far outside of a blurred region pixels contribute to the result.
+     */
+    int reach() const;
+
+    /**
+     * Blurs @a region of @a image, in device pixels, and blends the result over the original
+     * pixels with @a opacity. If @a sampleOutside is @c false, pixels outside of the bounding
+     * rectangle of @a region don't contribute to the result.
+     */
+    void blur(QImage *image, const QRegion &region, qreal opacity, bool sampleOutside);
+
+    static bool isFormatSupported(QImage::Format format);
+
+private:
+    void blurArea(QImage *image, const QRect &area, const QRegion &region, qreal opacity);
+    void boxBlurHorizontal(const uint32_t *source, uint32_t *target, int width, int height) const;
+    void boxBlurVertical(const uint32_t *source, uint32_t *target, int width, int height);
+
+    int m_radius = 8;
+    std::vector<uint32_t> m_buffer;
+    std::vector<uint32_t> m_scratch;
+    std::vector<PixelSum> m_columnSums;
+};
+
+} // namespace KWin
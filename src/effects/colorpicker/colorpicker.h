@@ -27,6 +27,10 @@ public:
     ~ColorPickerEffect() override;
     void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
     bool isActive() const override;
+    PaintHooks paintHooks() const override
+    {
+        return PaintScreenHook;
+    }
 
     int requestedEffectChainPosition() const override
     {
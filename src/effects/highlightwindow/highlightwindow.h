@@ -26,6 +26,10 @@ public:
     {
         return 70;
     }
+    PaintHooks paintHooks() const override
+    {
+        return PrePaintScreenHook | PostPaintScreenHook | PrePaintWindowHook | PaintWindowHook | DrawWindowHook | FilterWindows | NotifiesActiveChanged;
+    }
 
     bool provides(Feature feature) override;
     bool perform(Feature feature, const QVariantList &arguments) override;
@@ -13,6 +13,8 @@
 // KConfigSkeleton
 #include "magiclampconfig.h"
 
+#include <kwinwindowmesh.h>
+
 namespace KWin
 {
 
@@ -71,7 +73,7 @@ void MagicLampEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &data,
     effects->prePaintWindow(w, data, presentTime);
 }
 
-void MagicLampEffect::apply(EffectWindow *w, int mask, WindowPaintData &data, WindowQuadList &quads)
+void MagicLampEffect::deform(EffectWindow *w, int mask, WindowPaintData &data, WindowMesh &mesh)
 {
     auto animationIt = m_animations.constFind(w);
     if (animationIt != m_animations.constEnd()) {
@@ -202,152 +204,69 @@ void MagicLampEffect::apply(EffectWindow *w, int mask, WindowPaintData &data, Wi
             }
         }
 
-        quads = quads.makeGrid(40);
-        float quadFactor; // defines how fast a quad is vertically moved: y coordinates near to window top are slowed down
-                          // it is used as quadFactor^3/windowHeight^3
-                          // quadFactor is the y position of the quad but is changed towards becomming the window height
-                          // by that the factor becomes 1 and has no influence any more
-        float offset[2] = {0, 0}; // how far has a quad to be moved? Distance between icon and window multiplied by the progress and by the quadFactor
-        float p_progress[2] = {0, 0}; // the factor which defines how far the x values have to be changed
-                                      // factor is the current moved y value diveded by the distance between icon and window
-        WindowQuad lastQuad;
-        lastQuad[0].setX(-1);
-        lastQuad[0].setY(-1);
-        lastQuad[1].setX(-1);
-        lastQuad[1].setY(-1);
-        lastQuad[2].setX(-1);
-        lastQuad[2].setY(-1);
+        mesh = mesh.makeGrid(40);
+
+        // Every vertex is moved towards the icon by a distance that only depends on its own
+        // distance from the edge of the window that faces the icon. The quadFactor defines how
+        // fast a vertex is moved: vertices far from that edge are slowed down, it is used as
+        // quadFactor^3/windowSize^3 and is changed towards the window size by the progress, so
+        // the factor becomes 1 and has no influence any more. The vertices are also moved
+        // towards the center of the icon along the other axis, by the distance they moved
+        // divided by the distance between icon and window.
+        const float p = progress;
+        const float geoX = geo.x();
+        const float geoY = geo.y();
+        const float geoWidth = geo.width();
+        const float geoHeight = geo.height();
+        const float iconX = icon.x();
+        const float iconY = icon.y();
+        const float iconWidth = icon.width();
+        const float iconHeight = icon.height();
 
         if (position == Bottom) {
-            const float height_cube = float(geo.height()) * float(geo.height()) * float(geo.height());
-            const float maxY = icon.y() - geo.y();
-
-            for (WindowQuad &quad : quads) {
-
-                if (quad[0].y() != lastQuad[0].y() || quad[2].y() != lastQuad[2].y()) {
-                    quadFactor = quad[0].y() + (geo.height() - quad[0].y()) * progress;
-                    offset[0] = (icon.y() + quad[0].y() - geo.y()) * progress * ((quadFactor * quadFactor * quadFactor) / height_cube);
-                    quadFactor = quad[2].y() + (geo.height() - quad[2].y()) * progress;
-                    offset[1] = (icon.y() + quad[2].y() - geo.y()) * progress * ((quadFactor * quadFactor * quadFactor) / height_cube);
-                    p_progress[1] = std::min(offset[1] / (icon.y() - geo.y() - float(quad[2].y())), 1.0f);
-                    p_progress[0] = std::min(offset[0] / (icon.y() - geo.y() - float(quad[0].y())), 1.0f);
-                } else {
-                    lastQuad = quad;
-                }
-
-                p_progress[0] = std::abs(p_progress[0]);
-                p_progress[1] = std::abs(p_progress[1]);
-
-                // x values are moved towards the center of the icon
-                quad[0].setX((icon.x() + icon.width() * (quad[0].x() / geo.width()) - (quad[0].x() + geo.x())) * p_progress[0] + quad[0].x());
-                quad[1].setX((icon.x() + icon.width() * (quad[1].x() / geo.width()) - (quad[1].x() + geo.x())) * p_progress[0] + quad[1].x());
-                quad[2].setX((icon.x() + icon.width() * (quad[2].x() / geo.width()) - (quad[2].x() + geo.x())) * p_progress[1] + quad[2].x());
-                quad[3].setX((icon.x() + icon.width() * (quad[3].x() / geo.width()) - (quad[3].x() + geo.x())) * p_progress[1] + quad[3].x());
-
-                quad[0].setY(std::min(maxY, float(quad[0].y()) + offset[0]));
-                quad[1].setY(std::min(maxY, float(quad[1].y()) + offset[0]));
-                quad[2].setY(std::min(maxY, float(quad[2].y()) + offset[1]));
-                quad[3].setY(std::min(maxY, float(quad[3].y()) + offset[1]));
-            }
+            const float height_cube = geoHeight * geoHeight * geoHeight;
+            const float maxY = iconY - geoY;
+
+            mesh.warp([=](float &x, float &y) {
+                const float quadFactor = y + (geoHeight - y) * p;
+                const float offset = (iconY + y - geoY) * p * ((quadFactor * quadFactor * quadFactor) / height_cube);
+                const float p_progress = std::abs(std::min(offset / (iconY - geoY - y), 1.0f));
+                x = (iconX + iconWidth * (x / geoWidth) - (x + geoX)) * p_progress + x;
+                y = std::min(maxY, y + offset);
+            });
         } else if (position == Top) {
-            const float height_cube = float(geo.height()) * float(geo.height()) * float(geo.height());
-            const float minY = icon.y() + icon.height() - geo.y();
-
-            for (WindowQuad &quad : quads) {
-
-                if (quad[0].y() != lastQuad[0].y() || quad[2].y() != lastQuad[2].y()) {
-                    quadFactor = geo.height() - quad[0].y() + (quad[0].y()) * progress;
-                    offset[0] = (geo.y() - icon.height() + geo.height() + quad[0].y() - icon.y()) * progress * ((quadFactor * quadFactor * quadFactor) / height_cube);
-                    quadFactor = geo.height() - quad[2].y() + (quad[2].y()) * progress;
-                    offset[1] = (geo.y() - icon.height() + geo.height() + quad[2].y() - icon.y()) * progress * ((quadFactor * quadFactor * quadFactor) / height_cube);
-                    p_progress[0] = std::min(offset[0] / (geo.y() - icon.height() + geo.height() - icon.y() - float(geo.height() - quad[0].y())), 1.0f);
-                    p_progress[1] = std::min(offset[1] / (geo.y() - icon.height() + geo.height() - icon.y() - float(geo.height() - quad[2].y())), 1.0f);
-                } else {
-                    lastQuad = quad;
-                }
-
-                offset[0] = -offset[0];
-                offset[1] = -offset[1];
-
-                p_progress[0] = std::abs(p_progress[0]);
-                p_progress[1] = std::abs(p_progress[1]);
-
-                // x values are moved towards the center of the icon
-                quad[0].setX((icon.x() + icon.width() * (quad[0].x() / geo.width()) - (quad[0].x() + geo.x())) * p_progress[0] + quad[0].x());
-                quad[1].setX((icon.x() + icon.width() * (quad[1].x() / geo.width()) - (quad[1].x() + geo.x())) * p_progress[0] + quad[1].x());
-                quad[2].setX((icon.x() + icon.width() * (quad[2].x() / geo.width()) - (quad[2].x() + geo.x())) * p_progress[1] + quad[2].x());
-                quad[3].setX((icon.x() + icon.width() * (quad[3].x() / geo.width()) - (quad[3].x() + geo.x())) * p_progress[1] + quad[3].x());
-
-                quad[0].setY(std::max(minY, float(quad[0].y()) + offset[0]));
-                quad[1].setY(std::max(minY, float(quad[1].y()) + offset[0]));
-                quad[2].setY(std::max(minY, float(quad[2].y()) + offset[1]));
-                quad[3].setY(std::max(minY, float(quad[3].y()) + offset[1]));
-            }
+            const float height_cube = geoHeight * geoHeight * geoHeight;
+            const float minY = iconY + iconHeight - geoY;
+
+            mesh.warp([=](float &x, float &y) {
+                const float quadFactor = geoHeight - y + y * p;
+                const float offset = (geoY - iconHeight + geoHeight + y - iconY) * p * ((quadFactor * quadFactor * quadFactor) / height_cube);
+                const float p_progress = std::abs(std::min(offset / (geoY - iconHeight + geoHeight - iconY - (geoHeight - y)), 1.0f));
+                x = (iconX + iconWidth * (x / geoWidth) - (x + geoX)) * p_progress + x;
+                y = std::max(minY, y - offset);
+            });
         } else if (position == Left) {
-            const float width_cube = float(geo.width()) * float(geo.width()) * float(geo.width());
-            const float minX = icon.x() + icon.width() - geo.x();
-
-            for (WindowQuad &quad : quads) {
-
-                if (quad[0].x() != lastQuad[0].x() || quad[1].x() != lastQuad[1].x()) {
-                    quadFactor = geo.width() - quad[0].x() + (quad[0].x()) * progress;
-                    offset[0] = (geo.x() - icon.width() + geo.width() + quad[0].x() - icon.x()) * progress * ((quadFactor * quadFactor * quadFactor) / width_cube);
-                    quadFactor = geo.width() - quad[1].x() + (quad[1].x()) * progress;
-                    offset[1] = (geo.x() - icon.width() + geo.width() + quad[1].x() - icon.x()) * progress * ((quadFactor * quadFactor * quadFactor) / width_cube);
-                    p_progress[0] = std::min(offset[0] / (geo.x() - icon.width() + geo.width() - icon.x() - float(geo.width() - quad[0].x())), 1.0f);
-                    p_progress[1] = std::min(offset[1] / (geo.x() - icon.width() + geo.width() - icon.x() - float(geo.width() - quad[1].x())), 1.0f);
-                } else {
-                    lastQuad = quad;
-                }
-
-                offset[0] = -offset[0];
-                offset[1] = -offset[1];
-
-                p_progress[0] = std::abs(p_progress[0]);
-                p_progress[1] = std::abs(p_progress[1]);
-
-                // y values are moved towards the center of the icon
-                quad[0].setY((icon.y() + icon.height() * (quad[0].y() / geo.height()) - (quad[0].y() + geo.y())) * p_progress[0] + quad[0].y());
-                quad[1].setY((icon.y() + icon.height() * (quad[1].y() / geo.height()) - (quad[1].y() + geo.y())) * p_progress[1] + quad[1].y());
-                quad[2].setY((icon.y() + icon.height() * (quad[2].y() / geo.height()) - (quad[2].y() + geo.y())) * p_progress[1] + quad[2].y());
-                quad[3].setY((icon.y() + icon.height() * (quad[3].y() / geo.height()) - (quad[3].y() + geo.y())) * p_progress[0] + quad[3].y());
-
-                quad[0].setX(std::max(minX, float(quad[0].x()) + offset[0]));
-                quad[1].setX(std::max(minX, float(quad[1].x()) + offset[1]));
-                quad[2].setX(std::max(minX, float(quad[2].x()) + offset[1]));
-                quad[3].setX(std::max(minX, float(quad[3].x()) + offset[0]));
-            }
+            const float width_cube = geoWidth * geoWidth * geoWidth;
+            const float minX = iconX + iconWidth - geoX;
+
+            mesh.warp([=](float &x, float &y) {
+                const float quadFactor = geoWidth - x + x * p;
+                const float offset = (geoX - iconWidth + geoWidth + x - iconX) * p * ((quadFactor * quadFactor * quadFactor) / width_cube);
+                const float p_progress = std::abs(std::min(offset / (geoX - iconWidth + geoWidth - iconX - (geoWidth - x)), 1.0f));
+                y = (iconY + iconHeight * (y / geoHeight) - (y + geoY)) * p_progress + y;
+                x = std::max(minX, x - offset);
+            });
         } else if (position == Right) {
-            const float width_cube = float(geo.width()) * float(geo.width()) * float(geo.width());
-            const float maxX = icon.x() - geo.x();
-
-            for (WindowQuad &quad : quads) {
-
-                if (quad[0].x() != lastQuad[0].x() || quad[1].x() != lastQuad[1].x()) {
-                    quadFactor = quad[0].x() + (geo.width() - quad[0].x()) * progress;
-                    offset[0] = (icon.x() + quad[0].x() - geo.x()) * progress * ((quadFactor * quadFactor * quadFactor) / width_cube);
-                    quadFactor = quad[1].x() + (geo.width() - quad[1].x()) * progress;
-                    offset[1] = (icon.x() + quad[1].x() - geo.x()) * progress * ((quadFactor * quadFactor * quadFactor) / width_cube);
-                    p_progress[0] = std::min(offset[0] / (icon.x() - geo.x() - float(quad[0].x())), 1.0f);
-                    p_progress[1] = std::min(offset[1] / (icon.x() - geo.x() - float(quad[1].x())), 1.0f);
-                } else {
-                    lastQuad = quad;
-                }
-
-                p_progress[0] = std::abs(p_progress[0]);
-                p_progress[1] = std::abs(p_progress[1]);
-
-                // y values are moved towards the center of the icon
-                quad[0].setY((icon.y() + icon.height() * (quad[0].y() / geo.height()) - (quad[0].y() + geo.y())) * p_progress[0] + quad[0].y());
-                quad[1].setY((icon.y() + icon.height() * (quad[1].y() / geo.height()) - (quad[1].y() + geo.y())) * p_progress[1] + quad[1].y());
-                quad[2].setY((icon.y() + icon.height() * (quad[2].y() / geo.height()) - (quad[2].y() + geo.y())) * p_progress[1] + quad[2].y());
-                quad[3].setY((icon.y() + icon.height() * (quad[3].y() / geo.height()) - (quad[3].y() + geo.y())) * p_progress[0] + quad[3].y());
-
-                quad[0].setX(std::min(maxX, float(quad[0].x()) + offset[0]));
-                quad[1].setX(std::min(maxX, float(quad[1].x()) + offset[1]));
-                quad[2].setX(std::min(maxX, float(quad[2].x()) + offset[1]));
-                quad[3].setX(std::min(maxX, float(quad[3].x()) + offset[0]));
-            }
+            const float width_cube = geoWidth * geoWidth * geoWidth;
+            const float maxX = iconX - geoX;
+
+            mesh.warp([=](float &x, float &y) {
+                const float quadFactor = x + (geoWidth - x) * p;
+                const float offset = (iconX + x - geoX) * p * ((quadFactor * quadFactor * quadFactor) / width_cube);
+                const float p_progress = std::abs(std::min(offset / (iconX - geoX - x), 1.0f));
+                y = (iconY + iconHeight * (y / geoHeight) - (y + geoY)) * p_progress + y;
+                x = std::min(maxX, x + offset);
+            });
         }
     }
 }
@@ -41,7 +41,11 @@ public:
     static bool supported();
 
 protected:
-    void apply(EffectWindow *window, int mask, WindowPaintData &data, WindowQuadList &quads) override;
+    void deform(EffectWindow *window, int mask, WindowPaintData &data, WindowMesh &mesh) override;
+    bool hasDeform() const override
+    {
+        return true;
+    }
 
 public Q_SLOTS:
     void slotWindowDeleted(KWin::EffectWindow *w);
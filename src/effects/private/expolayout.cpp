@@ -10,8 +10,13 @@
 
 #include "expolayout.h"
 
+#include <QtConcurrent>
+
+#include <algorithm>
 #include <cmath>
 
+static const size_t s_cacheSize = 8;
+
 ExpoCell::ExpoCell(QObject *parent)
     : QObject(parent)
 {
@@ -189,6 +194,11 @@ void ExpoCell::setHeight(int height)
     }
 }
 
+bool ExpoCell::hasGeometry() const
+{
+    return m_x && m_y && m_width && m_height;
+}
+
 QString ExpoCell::persistentKey() const
 {
     return m_persistentKey;
@@ -220,6 +230,11 @@ void ExpoCell::setBottomMargin(int margin)
 ExpoLayout::ExpoLayout(QQuickItem *parent)
     : QQuickItem(parent)
 {
+    connect(&m_watcher, &QFutureWatcher<ExpoLayoutSolver::Result>::finished, this, [this]() {
+        cacheLayout(*m_pendingInput, m_watcher.result());
+        m_pendingInput.reset();
+        polish();
+    });
 }
 
 ExpoLayout::LayoutMode ExpoLayout::mode() const
@@ -264,6 +279,19 @@ void ExpoLayout::setSpacing(int spacing)
     }
 }
 
+bool ExpoLayout::isAsynchronous() const
+{
+    return m_asynchronous;
+}
+
+void ExpoLayout::setAsynchronous(bool asynchronous)
+{
+    if (m_asynchronous != asynchronous) {
+        m_asynchronous = asynchronous;
+        Q_EMIT asynchronousChanged();
+    }
+}
+
 bool ExpoLayout::isReady() const
 {
     return m_ready;
@@ -279,10 +307,15 @@ void ExpoLayout::setReady()
 
 void ExpoLayout::forceLayout()
 {
-    updatePolish();
+    updateLayout(false);
 }
 
 void ExpoLayout::updatePolish()
+{
+    updateLayout(m_asynchronous && m_ready);
+}
+
+void ExpoLayout::updateLayout(bool asynchronous)
 {
     if (!m_cells.isEmpty()) {
         switch (m_mode) {
@@ -290,7 +323,7 @@ void ExpoLayout::updatePolish()
             calculateWindowTransformationsClosest();
             break;
         case LayoutNatural:
-            calculateWindowTransformationsNatural();
+            calculateWindowTransformationsNatural(asynchronous);
             break;
         case LayoutNone:
             resetTransformations();
@@ -337,17 +370,6 @@ static int distance(const QPoint &a, const QPoint &b)
     return int(std::sqrt(qreal(xdiff * xdiff + ydiff * ydiff)));
 }
 
-static QRect centered(ExpoCell *cell, const QRect &bounds)
-{
-    const QSize scaled = QSize(cell->naturalWidth(), cell->naturalHeight())
-                             .scaled(bounds.size(), Qt::KeepAspectRatio);
-
-    return QRect(bounds.center().x() - scaled.width() / 2,
-                 bounds.center().y() - scaled.height() / 2,
-                 scaled.width(),
-                 scaled.height());
-}
-
 void ExpoLayout::calculateWindowTransformationsClosest()
 {
     QRect area = QRect(0, 0, width(), height());
@@ -439,264 +461,61 @@ void ExpoLayout::calculateWindowTransformationsClosest()
     }
 }
 
-static inline int heightForWidth(ExpoCell *cell, int width)
+void ExpoLayout::calculateWindowTransformationsNatural(bool asynchronous)
 {
-    return int((width / qreal(cell->naturalWidth())) * cell->naturalHeight());
-}
-
-static bool isOverlappingAny(ExpoCell *w, const QHash<ExpoCell *, QRect> &targets, const QRegion &border, int spacing)
-{
-    QHash<ExpoCell *, QRect>::const_iterator winTarget = targets.find(w);
-    if (winTarget == targets.constEnd()) {
-        return false;
-    }
-    if (border.intersects(*winTarget)) {
-        return true;
-    }
-    const QMargins halfSpacing(spacing / 2, spacing / 2, spacing / 2, spacing / 2);
-
-    // Is there a better way to do this?
-    QHash<ExpoCell *, QRect>::const_iterator target;
-    for (target = targets.constBegin(); target != targets.constEnd(); ++target) {
-        if (target == winTarget) {
-            continue;
-        }
-        if (winTarget->marginsAdded(halfSpacing).intersects(target->marginsAdded(halfSpacing))) {
-            return true;
-        }
-    }
-    return false;
-}
-
-void ExpoLayout::calculateWindowTransformationsNatural()
-{
-    const QRect area = QRect(0, 0, width(), height());
-
     // As we are using pseudo-random movement (See "slot") we need to make sure the list
     // is always sorted the same way no matter which window is currently active.
     std::sort(m_cells.begin(), m_cells.end(), [](const ExpoCell *a, const ExpoCell *b) {
         return a->persistentKey() < b->persistentKey();
     });
 
-    QRect bounds;
-    int direction = 0;
-    QHash<ExpoCell *, QRect> targets;
-    QHash<ExpoCell *, int> directions;
-
-    for (ExpoCell *cell : std::as_const(m_cells)) {
-        const QRect cellRect(cell->naturalX(), cell->naturalY(), cell->naturalWidth(), cell->naturalHeight());
-        targets[cell] = cellRect;
-        // Reuse the unused "slot" as a preferred direction attribute. This is used when the window
-        // is on the edge of the screen to try to use as much screen real estate as possible.
-        directions[cell] = direction;
-        bounds = bounds.united(cellRect);
-        direction++;
-        if (direction == 4) {
-            direction = 0;
-        }
+    ExpoLayoutSolver::Input input;
+    input.area = QRect(0, 0, width(), height());
+    input.spacing = m_spacing;
+    input.accuracy = m_accuracy;
+    input.fillGaps = m_fillGaps;
+    input.cells.reserve(m_cells.count());
+    for (const ExpoCell *cell : std::as_const(m_cells)) {
+        input.cells.push_back(ExpoLayoutSolver::Cell{
+            .naturalRect = cell->naturalRect(),
+            .margins = cell->margins(),
+        });
+    }
+
+    if (const ExpoLayoutSolver::Result *result = cachedLayout(input)) {
+        applyLayout(*result);
+        return;
     }
 
-    // Iterate over all windows, if two overlap push them apart _slightly_ as we try to
-    // brute-force the most optimal positions over many iterations.
-    const int halfSpacing = m_spacing / 2;
-    bool overlap;
-    do {
-        overlap = false;
-        for (ExpoCell *cell : std::as_const(m_cells)) {
-            QRect *target_w = &targets[cell];
-            for (ExpoCell *e : std::as_const(m_cells)) {
-                if (cell == e) {
-                    continue;
-                }
+    if (!asynchronous) {
+        const ExpoLayoutSolver::Result result = ExpoLayoutSolver::solve(input);
+        cacheLayout(input, result);
+        applyLayout(result);
+        return;
+    }
 
-                QRect *target_e = &targets[e];
-                if (target_w->adjusted(-halfSpacing, -halfSpacing, halfSpacing, halfSpacing)
-                        .intersects(target_e->adjusted(-halfSpacing, -halfSpacing, halfSpacing, halfSpacing))) {
-                    overlap = true;
-
-                    // Determine pushing direction
-                    QPoint diff(target_e->center() - target_w->center());
-                    // Prevent dividing by zero and non-movement
-                    if (diff.x() == 0 && diff.y() == 0) {
-                        diff.setX(1);
-                    }
-                    // Try to keep screen aspect ratio
-                    // if (bounds.height() / bounds.width() > area.height() / area.width())
-                    //    diff.setY(diff.y() / 2);
-                    // else
-                    //    diff.setX(diff.x() / 2);
-                    // Approximate a vector of between 10px and 20px in magnitude in the same direction
-                    diff *= m_accuracy / qreal(diff.manhattanLength());
-                    // Move both windows apart
-                    target_w->translate(-diff);
-                    target_e->translate(diff);
-
-                    // Try to keep the bounding rect the same aspect as the screen so that more
-                    // screen real estate is utilised. We do this by splitting the screen into nine
-                    // equal sections, if the window center is in any of the corner sections pull the
-                    // window towards the outer corner. If it is in any of the other edge sections
-                    // alternate between each corner on that edge. We don't want to determine it
-                    // randomly as it will not produce consistant locations when using the filter.
-                    // Only move one window so we don't cause large amounts of unnecessary zooming
-                    // in some situations. We need to do this even when expanding later just in case
-                    // all windows are the same size.
-                    // (We are using an old bounding rect for this, hopefully it doesn't matter)
-                    int xSection = (target_w->x() - bounds.x()) / (bounds.width() / 3);
-                    int ySection = (target_w->y() - bounds.y()) / (bounds.height() / 3);
-                    diff = QPoint(0, 0);
-                    if (xSection != 1 || ySection != 1) { // Remove this if you want the center to pull as well
-                        if (xSection == 1) {
-                            xSection = (directions[cell] / 2 ? 2 : 0);
-                        }
-                        if (ySection == 1) {
-                            ySection = (directions[cell] % 2 ? 2 : 0);
-                        }
-                    }
-                    if (xSection == 0 && ySection == 0) {
-                        diff = QPoint(bounds.topLeft() - target_w->center());
-                    }
-                    if (xSection == 2 && ySection == 0) {
-                        diff = QPoint(bounds.topRight() - target_w->center());
-                    }
-                    if (xSection == 2 && ySection == 2) {
-                        diff = QPoint(bounds.bottomRight() - target_w->center());
-                    }
-                    if (xSection == 0 && ySection == 2) {
-                        diff = QPoint(bounds.bottomLeft() - target_w->center());
-                    }
-                    if (diff.x() != 0 || diff.y() != 0) {
-                        diff *= m_accuracy / qreal(diff.manhattanLength());
-                        target_w->translate(diff);
-                    }
-
-                    // Update bounding rect
-                    bounds = bounds.united(*target_w);
-                    bounds = bounds.united(*target_e);
-                }
-            }
+    // The cells that have never been laid out need a geometry until the layout is available.
+    for (ExpoCell *cell : std::as_const(m_cells)) {
+        if (!cell->hasGeometry()) {
+            placeProvisionally(cell);
         }
-    } while (overlap);
-
-    // Compute the scale factor so the bounding rect fits the target area.
-    qreal scale;
-    if (bounds.width() <= area.width() && bounds.height() <= area.height()) {
-        scale = 1.0;
-    } else if (area.width() / qreal(bounds.width()) < area.height() / qreal(bounds.height())) {
-        scale = area.width() / qreal(bounds.width());
-    } else {
-        scale = area.height() / qreal(bounds.height());
-    }
-    // Make bounding rect fill the screen size for later steps
-    bounds = QRect(bounds.x() - (area.width() / scale - bounds.width()) / 2,
-                   bounds.y() - (area.height() / scale - bounds.height()) / 2,
-                   area.width() / scale,
-                   area.height() / scale);
-
-    // Move all windows back onto the screen and set their scale
-    QHash<ExpoCell *, QRect>::iterator target = targets.begin();
-    while (target != targets.end()) {
-        target->setRect((target->x() - bounds.x()) * scale + area.x(),
-                        (target->y() - bounds.y()) * scale + area.y(),
-                        target->width() * scale,
-                        target->height() * scale);
-        ++target;
-    }
-
-    // Try to fill the gaps by enlarging windows if they have the space
-    if (m_fillGaps) {
-        // Don't expand onto or over the border
-        QRegion borderRegion(area.adjusted(-200, -200, 200, 200));
-        borderRegion ^= area;
-
-        bool moved;
-        do {
-            moved = false;
-            for (ExpoCell *cell : std::as_const(m_cells)) {
-                QRect oldRect;
-                QRect *target = &targets[cell];
-                // This may cause some slight distortion if the windows are enlarged a large amount
-                int widthDiff = m_accuracy;
-                int heightDiff = heightForWidth(cell, target->width() + widthDiff) - target->height();
-                int xDiff = widthDiff / 2; // Also move a bit in the direction of the enlarge, allows the
-                int yDiff = heightDiff / 2; // center windows to be enlarged if there is gaps on the side.
-
-                // heightDiff (and yDiff) will be re-computed after each successful enlargement attempt
-                // so that the error introduced in the window's aspect ratio is minimized
-
-                // Attempt enlarging to the top-right
-                oldRect = *target;
-                target->setRect(target->x() + xDiff,
-                                target->y() - yDiff - heightDiff,
-                                target->width() + widthDiff,
-                                target->height() + heightDiff);
-                if (isOverlappingAny(cell, targets, borderRegion, m_spacing)) {
-                    *target = oldRect;
-                } else {
-                    moved = true;
-                    heightDiff = heightForWidth(cell, target->width() + widthDiff) - target->height();
-                    yDiff = heightDiff / 2;
-                }
-
-                // Attempt enlarging to the bottom-right
-                oldRect = *target;
-                target->setRect(target->x() + xDiff,
-                                target->y() + yDiff,
-                                target->width() + widthDiff,
-                                target->height() + heightDiff);
-                if (isOverlappingAny(cell, targets, borderRegion, m_spacing)) {
-                    *target = oldRect;
-                } else {
-                    moved = true;
-                    heightDiff = heightForWidth(cell, target->width() + widthDiff) - target->height();
-                    yDiff = heightDiff / 2;
-                }
-
-                // Attempt enlarging to the bottom-left
-                oldRect = *target;
-                target->setRect(target->x() - xDiff - widthDiff,
-                                target->y() + yDiff,
-                                target->width() + widthDiff,
-                                target->height() + heightDiff);
-                if (isOverlappingAny(cell, targets, borderRegion, m_spacing)) {
-                    *target = oldRect;
-                } else {
-                    moved = true;
-                    heightDiff = heightForWidth(cell, target->width() + widthDiff) - target->height();
-                    yDiff = heightDiff / 2;
-                }
+    }
 
-                // Attempt enlarging to the top-left
-                oldRect = *target;
-                target->setRect(target->x() - xDiff - widthDiff,
-                                target->y() - yDiff - heightDiff,
-                                target->width() + widthDiff,
-                                target->height() + heightDiff);
-                if (isOverlappingAny(cell, targets, borderRegion, m_spacing)) {
-                    *target = oldRect;
-                } else {
-                    moved = true;
-                }
-            }
-        } while (moved);
-
-        // The expanding code above can actually enlarge windows over 1.0/2.0 scale, we don't like this
-        // We can't add this to the loop above as it would cause a never-ending loop so we have to make
-        // do with the less-than-optimal space usage with using this method.
-        for (ExpoCell *cell : std::as_const(m_cells)) {
-            QRect *target = &targets[cell];
-            qreal scale = target->width() / qreal(cell->naturalWidth());
-            if (scale > 2.0 || (scale > 1.0 && (cell->naturalWidth() > 300 || cell->naturalHeight() > 300))) {
-                scale = (cell->naturalWidth() > 300 || cell->naturalHeight() > 300) ? 1.0 : 2.0;
-                target->setRect(target->center().x() - int(cell->naturalWidth() * scale) / 2,
-                                target->center().y() - int(cell->naturalHeight() * scale) / 2,
-                                cell->naturalWidth() * scale,
-                                cell->naturalHeight() * scale);
-            }
-        }
+    // The layout is polished again when the running computation finishes.
+    if (m_pendingInput) {
+        return;
     }
 
-    for (ExpoCell *cell : std::as_const(m_cells)) {
-        const QRect rect = centered(cell, targets.value(cell).marginsRemoved(cell->margins()));
+    m_pendingInput = input;
+    m_watcher.setFuture(QtConcurrent::run(&ExpoLayoutSolver::solve, std::move(input)));
+}
+
+void ExpoLayout::applyLayout(const ExpoLayoutSolver::Result &result)
+{
+    Q_ASSERT(int(result.rects.size()) == m_cells.count());
+    for (int i = 0; i < m_cells.count(); ++i) {
+        ExpoCell *cell = m_cells[i];
+        const QRect &rect = result.rects[i];
 
         cell->setX(rect.x());
         cell->setY(rect.y());
@@ -705,6 +524,53 @@ void ExpoLayout::calculateWindowTransformationsNatural()
     }
 }
 
+const ExpoLayoutSolver::Result *ExpoLayout::cachedLayout(const ExpoLayoutSolver::Input &input)
+{
+    auto it = std::find_if(m_cache.begin(), m_cache.end(), [&input](const CachedLayout &layout) {
+        return layout.input == input;
+    });
+    if (it == m_cache.end()) {
+        return nullptr;
+    }
+    std::rotate(it, it + 1, m_cache.end());
+    return &m_cache.back().result;
+}
+
+void ExpoLayout::cacheLayout(const ExpoLayoutSolver::Input &input, const ExpoLayoutSolver::Result &result)
+{
+    if (cachedLayout(input)) {
+        return;
+    }
+    if (m_cache.size() == s_cacheSize) {
+        m_cache.erase(m_cache.begin());
+    }
+    m_cache.push_back(CachedLayout{
+        .input = input,
+        .result = result,
+    });
+}
+
+void ExpoLayout::placeProvisionally(ExpoCell *cell)
+{
+    // Keep the cell where its window is, scaled down and moved inside the layout if needed.
+    const QRect area = QRect(0, 0, width(), height()).marginsRemoved(cell->margins());
+    const QRect natural = cell->naturalRect();
+    qreal scale = 1.0;
+    if (!natural.isEmpty()) {
+        scale = std::clamp(std::min(area.width() / qreal(natural.width()), area.height() / qreal(natural.height())), 0.0, 1.0);
+    }
+
+    QRect target(0, 0, int(natural.width() * scale), int(natural.height() * scale));
+    target.moveCenter(natural.center());
+    target.moveLeft(qBound(area.left(), target.left(), area.right() - target.width() + 1));
+    target.moveTop(qBound(area.top(), target.top(), area.bottom() - target.height() + 1));
+
+    cell->setX(target.x());
+    cell->setY(target.y());
+    cell->setWidth(target.width());
+    cell->setHeight(target.height());
+}
+
 void ExpoLayout::resetTransformations()
 {
     for (ExpoCell *cell : std::as_const(m_cells)) {
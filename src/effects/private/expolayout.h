@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include "expolayoutsolver.h"
+
+#include <QFutureWatcher>
 #include <QObject>
 #include <QQuickItem>
 #include <QRect>
@@ -20,6 +23,7 @@ class ExpoLayout : public QQuickItem
     Q_PROPERTY(LayoutMode mode READ mode WRITE setMode NOTIFY modeChanged)
     Q_PROPERTY(bool fillGaps READ fillGaps WRITE setFillGaps NOTIFY fillGapsChanged)
     Q_PROPERTY(int spacing READ spacing WRITE setSpacing NOTIFY spacingChanged)
+    Q_PROPERTY(bool asynchronous READ isAsynchronous WRITE setAsynchronous NOTIFY asynchronousChanged)
     Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged)
 
 public:
@@ -41,6 +45,14 @@ public:
     int spacing() const;
     void setSpacing(int spacing);
 
+    /**
+     * Whether the natural layout is computed in a worker thread once the layout is ready. The
+     * cells keep their geometry until the new layout is available. The initial layout and
+     * forceLayout() are always computed synchronously.
+     */
+    bool isAsynchronous() const;
+    void setAsynchronous(bool asynchronous);
+
     void addCell(ExpoCell *cell);
     void removeCell(ExpoCell *cell);
 
@@ -61,12 +73,24 @@ Q_SIGNALS:
     void modeChanged();
     void fillGapsChanged();
     void spacingChanged();
+    void asynchronousChanged();
     void readyChanged();
 
 private:
+    struct CachedLayout
+    {
+        ExpoLayoutSolver::Input input;
+        ExpoLayoutSolver::Result result;
+    };
+
+    void updateLayout(bool asynchronous);
     void calculateWindowTransformationsClosest();
-    void calculateWindowTransformationsNatural();
+    void calculateWindowTransformationsNatural(bool asynchronous);
     void resetTransformations();
+    void placeProvisionally(ExpoCell *cell);
+    void applyLayout(const ExpoLayoutSolver::Result &result);
+    const ExpoLayoutSolver::Result *cachedLayout(const ExpoLayoutSolver::Input &input);
+    void cacheLayout(const ExpoLayoutSolver::Input &input, const ExpoLayoutSolver::Result &result);
 
     QList<ExpoCell *> m_cells;
     LayoutMode m_mode = LayoutNatural;
@@ -74,6 +98,13 @@ private:
     int m_spacing = 10;
     bool m_ready = false;
     bool m_fillGaps = false;
+    bool m_asynchronous = false;
+
+    // Recently computed layouts, the most recently used one is at the end. Typing in the
+    // filter toggles the same sets of cells back and forth, e.g. when removing a character.
+    std::vector<CachedLayout> m_cache;
+    QFutureWatcher<ExpoLayoutSolver::Result> m_watcher;
+    std::optional<ExpoLayoutSolver::Input> m_pendingInput;
 };
 
 class ExpoCell : public QObject
@@ -129,6 +160,11 @@ public:
     int height() const;
     void setHeight(int height);
 
+    /**
+     * Whether the cell has been given a geometry by the layout.
+     */
+    bool hasGeometry() const;
+
     QString persistentKey() const;
     void setPersistentKey(const QString &key);
 
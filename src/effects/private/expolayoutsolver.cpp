@@ -0,0 +1,446 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    // The layouting code is taken from the present windows effect.
+    SPDX-FileCopyrightText: 2007 Rivo Laks <rivolaks@hot.ee>
+    SPDX-FileCopyrightText: 2008 Lucas Murray <lmurray@undefinedfire.com>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "expolayoutsolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+/**
+ * A uniform grid of buckets with the indices of the cells that touch them. A cell can be
+ * inserted again after it has changed, the stale entries only produce false candidates.
+ */
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(int count)
+        : m_stamps(count, 0)
+    {
+    }
+
+    void reset(const QRect &bounds, const std::vector<QRect> &rects)
+    {
+        // Make the buckets about as large as an average cell, but don't use more than a few
+        // buckets per cell if the cells are spread out far.
+        qint64 extent = 0;
+        for (const QRect &rect : rects) {
+            extent += std::max(rect.width(), rect.height());
+        }
+        extent /= std::max<qint64>(1, rects.size());
+        const qint64 spread = std::ceil(std::sqrt(qreal(bounds.width()) * bounds.height() / (4.0 * std::max<size_t>(1, rects.size()))));
+
+        m_origin = bounds.topLeft();
+        m_bucketSize = std::max<qint64>(1, std::max(extent, spread));
+        m_columns = std::max<qint64>(1, bounds.width() / m_bucketSize + 1);
+        m_rows = std::max<qint64>(1, bounds.height() / m_bucketSize + 1);
+
+        m_buckets.resize(m_columns * m_rows);
+        for (std::vector<int> &bucket : m_buckets) {
+            bucket.clear();
+        }
+    }
+
+    void insert(int index, const QRect &rect)
+    {
+        const Range range = rangeOf(rect);
+        for (int y = range.top; y <= range.bottom; ++y) {
+            for (int x = range.left; x <= range.right; ++x) {
+                m_buckets[y * m_columns + x].push_back(index);
+            }
+        }
+    }
+
+    /**
+     * Collects the cells in the buckets touched by @p rect, except @p exclude, in ascending
+     * order.
+     */
+    void collect(const QRect &rect, int exclude, std::vector<int> &candidates)
+    {
+        candidates.clear();
+        ++m_stamp;
+
+        const Range range = rangeOf(rect);
+        for (int y = range.top; y <= range.bottom; ++y) {
+            for (int x = range.left; x <= range.right; ++x) {
+                for (int index : m_buckets[y * m_columns + x]) {
+                    if (index != exclude && m_stamps[index] != m_stamp) {
+                        m_stamps[index] = m_stamp;
+                        candidates.push_back(index);
+                    }
+                }
+            }
+        }
+
+        // Keep the order of the cells, the layout must not depend on the order of the buckets.
+        std::sort(candidates.begin(), candidates.end());
+    }
+
+private:
+    struct Range
+    {
+        int left;
+        int top;
+        int right;
+        int bottom;
+    };
+
+    Range rangeOf(const QRect &rect) const
+    {
+        // Cells that moved out of the grid are kept in the buckets on its edges.
+        return Range{
+            .left = int(std::clamp<qint64>((qint64(rect.left()) - m_origin.x()) / m_bucketSize, 0, m_columns - 1)),
+            .top = int(std::clamp<qint64>((qint64(rect.top()) - m_origin.y()) / m_bucketSize, 0, m_rows - 1)),
+            .right = int(std::clamp<qint64>((qint64(rect.right()) - m_origin.x()) / m_bucketSize, 0, m_columns - 1)),
+            .bottom = int(std::clamp<qint64>((qint64(rect.bottom()) - m_origin.y()) / m_bucketSize, 0, m_rows - 1)),
+        };
+    }
+
+    std::vector<std::vector<int>> m_buckets;
+    std::vector<quint32> m_stamps;
+    quint32 m_stamp = 0;
+    QPoint m_origin;
+    qint64 m_bucketSize = 1;
+    qint64 m_columns = 1;
+    qint64 m_rows = 1;
+};
+
+} // namespace
+
+static inline int heightForWidth(const ExpoLayoutSolver::Cell &cell, int width)
+{
+    return int((width / qreal(cell.naturalRect.width())) * cell.naturalRect.height());
+}
+
+static QRect centered(const ExpoLayoutSolver::Cell &cell, const QRect &bounds)
+{
+    const QSize scaled = cell.naturalRect.size().scaled(bounds.size(), Qt::KeepAspectRatio);
+
+    return QRect(bounds.center().x() - scaled.width() / 2,
+                 bounds.center().y() - scaled.height() / 2,
+                 scaled.width(),
+                 scaled.height());
+}
+
+static std::vector<QRect> inflated(const std::vector<QRect> &rects, const QMargins &margins)
+{
+    std::vector<QRect> result;
+    result.reserve(rects.size());
+    for (const QRect &rect : rects) {
+        result.push_back(rect.marginsAdded(margins));
+    }
+    return result;
+}
+
+static int countOverlaps(const std::vector<QRect> &targets, const QMargins &halfSpacing, const QRect &bounds)
+{
+    const std::vector<QRect> rects = inflated(targets, halfSpacing);
+
+    SpatialGrid grid(rects.size());
+    grid.reset(bounds.marginsAdded(halfSpacing), rects);
+    for (size_t i = 0; i < rects.size(); ++i) {
+        grid.insert(i, rects[i]);
+    }
+
+    int overlaps = 0;
+    std::vector<int> candidates;
+    for (size_t i = 0; i < rects.size(); ++i) {
+        grid.collect(rects[i], i, candidates);
+        for (int j : candidates) {
+            if (size_t(j) > i && rects[i].intersects(rects[j])) {
+                ++overlaps;
+            }
+        }
+    }
+    return overlaps;
+}
+
+ExpoLayoutSolver::Result ExpoLayoutSolver::solve(const Input &input)
+{
+    const int count = input.cells.size();
+    const QRect &area = input.area;
+
+    Result result;
+    if (!count) {
+        return result;
+    }
+
+    QRect bounds;
+    std::vector<QRect> targets;
+    std::vector<int> directions;
+    targets.reserve(count);
+    directions.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        const QRect &cellRect = input.cells[i].naturalRect;
+        targets.push_back(cellRect);
+        // Use the position in the list as a preferred direction. This is used when the window
+        // is on the edge of the screen to try to use as much screen real estate as possible.
+        directions.push_back(i % 4);
+        bounds = bounds.united(cellRect);
+    }
+
+    // Iterate over all windows, if two overlap push them apart _slightly_ as we try to
+    // brute-force the most optimal positions over many iterations.
+    const int halfSpacing = input.spacing / 2;
+    const QMargins halfSpacingMargins(halfSpacing, halfSpacing, halfSpacing, halfSpacing);
+    SpatialGrid grid(count);
+    std::vector<int> candidates;
+    bool overlap;
+    do {
+        if (result.iterations == input.maxIterations) {
+            result.converged = false;
+            break;
+        }
+        ++result.iterations;
+        overlap = false;
+
+        // The grid is only exact at the start of the pass. Overlaps with windows that moved
+        // during the pass are caught in the next pass, the last pass moves nothing.
+        grid.reset(bounds.marginsAdded(halfSpacingMargins), targets);
+        for (int i = 0; i < count; ++i) {
+            grid.insert(i, targets[i].marginsAdded(halfSpacingMargins));
+        }
+
+        for (int i = 0; i < count; ++i) {
+            QRect &target_w = targets[i];
+            grid.collect(target_w.marginsAdded(halfSpacingMargins), i, candidates);
+
+            for (int j : candidates) {
+                QRect &target_e = targets[j];
+                if (!target_w.marginsAdded(halfSpacingMargins).intersects(target_e.marginsAdded(halfSpacingMargins))) {
+                    continue;
+                }
+                overlap = true;
+
+                // Determine pushing direction
+                QPoint diff(target_e.center() - target_w.center());
+                // Prevent dividing by zero and non-movement
+                if (diff.x() == 0 && diff.y() == 0) {
+                    diff.setX(1);
+                }
+                // Approximate a vector of between 10px and 20px in magnitude in the same direction
+                diff *= input.accuracy / qreal(diff.manhattanLength());
+                // Move both windows apart
+                target_w.translate(-diff);
+                target_e.translate(diff);
+
+                // Try to keep the bounding rect the same aspect as the screen so that more
+                // screen real estate is utilised. We do this by splitting the screen into nine
+                // equal sections, if the window center is in any of the corner sections pull the
+                // window towards the outer corner. If it is in any of the other edge sections
+                // alternate between each corner on that edge. We don't want to determine it
+                // randomly as it will not produce consistant locations when using the filter.
+                // Only move one window so we don't cause large amounts of unnecessary zooming
+                // in some situations. We need to do this even when expanding later just in case
+                // all windows are the same size.
+                // (We are using an old bounding rect for this, hopefully it doesn't matter)
+                int xSection = (target_w.x() - bounds.x()) / std::max(1, bounds.width() / 3);
+                int ySection = (target_w.y() - bounds.y()) / std::max(1, bounds.height() / 3);
+                diff = QPoint(0, 0);
+                if (xSection != 1 || ySection != 1) { // Remove this if you want the center to pull as well
+                    if (xSection == 1) {
+                        xSection = (directions[i] / 2 ? 2 : 0);
+                    }
+                    if (ySection == 1) {
+                        ySection = (directions[i] % 2 ? 2 : 0);
+                    }
+                }
+                if (xSection == 0 && ySection == 0) {
+                    diff = QPoint(bounds.topLeft() - target_w.center());
+                }
+                if (xSection == 2 && ySection == 0) {
+                    diff = QPoint(bounds.topRight() - target_w.center());
+                }
+                if (xSection == 2 && ySection == 2) {
+                    diff = QPoint(bounds.bottomRight() - target_w.center());
+                }
+                if (xSection == 0 && ySection == 2) {
+                    diff = QPoint(bounds.bottomLeft() - target_w.center());
+                }
+                if (diff.x() != 0 || diff.y() != 0) {
+                    diff *= input.accuracy / qreal(diff.manhattanLength());
+                    target_w.translate(diff);
+                }
+
+                // Update bounding rect
+                bounds = bounds.united(target_w);
+                bounds = bounds.united(target_e);
+            }
+        }
+    } while (overlap);
+
+    if (!result.converged) {
+        result.overlaps = countOverlaps(targets, halfSpacingMargins, bounds);
+    }
+
+    // Compute the scale factor so the bounding rect fits the target area.
+    qreal scale;
+    if (bounds.width() <= area.width() && bounds.height() <= area.height()) {
+        scale = 1.0;
+    } else if (area.width() / qreal(bounds.width()) < area.height() / qreal(bounds.height())) {
+        scale = area.width() / qreal(bounds.width());
+    } else {
+        scale = area.height() / qreal(bounds.height());
+    }
+    result.scale = scale;
+    // Make bounding rect fill the screen size for later steps
+    bounds = QRect(bounds.x() - (area.width() / scale - bounds.width()) / 2,
+                   bounds.y() - (area.height() / scale - bounds.height()) / 2,
+                   area.width() / scale,
+                   area.height() / scale);
+
+    // Move all windows back onto the screen and set their scale
+    for (QRect &target : targets) {
+        target.setRect((target.x() - bounds.x()) * scale + area.x(),
+                       (target.y() - bounds.y()) * scale + area.y(),
+                       target.width() * scale,
+                       target.height() * scale);
+    }
+
+    // Try to fill the gaps by enlarging windows if they have the space
+    if (input.fillGaps) {
+        grid.reset(area.marginsAdded(halfSpacingMargins), targets);
+        for (int i = 0; i < count; ++i) {
+            grid.insert(i, targets[i].marginsAdded(halfSpacingMargins));
+        }
+
+        // Don't expand onto or over the border, and not over any other window.
+        const auto isOverlappingAny = [&](int index) {
+            const QRect &target = targets[index];
+            if (!area.contains(target)) {
+                return true;
+            }
+            const QRect inflatedTarget = target.marginsAdded(halfSpacingMargins);
+            grid.collect(inflatedTarget, index, candidates);
+            for (int j : candidates) {
+                if (inflatedTarget.intersects(targets[j].marginsAdded(halfSpacingMargins))) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        bool moved;
+        do {
+            if (result.fillIterations == input.maxIterations) {
+                break;
+            }
+            ++result.fillIterations;
+            moved = false;
+
+            for (int i = 0; i < count; ++i) {
+                const Cell &cell = input.cells[i];
+                QRect &target = targets[i];
+                const QRect initialRect = target;
+                QRect oldRect;
+                // This may cause some slight distortion if the windows are enlarged a large amount
+                int widthDiff = input.accuracy;
+                int heightDiff = heightForWidth(cell, target.width() + widthDiff) - target.height();
+                int xDiff = widthDiff / 2; // Also move a bit in the direction of the enlarge, allows the
+                int yDiff = heightDiff / 2; // center windows to be enlarged if there is gaps on the side.
+
+                // heightDiff (and yDiff) will be re-computed after each successful enlargement attempt
+                // so that the error introduced in the window's aspect ratio is minimized
+
+                // Attempt enlarging to the top-right
+                oldRect = target;
+                target.setRect(target.x() + xDiff,
+                               target.y() - yDiff - heightDiff,
+                               target.width() + widthDiff,
+                               target.height() + heightDiff);
+                if (isOverlappingAny(i)) {
+                    target = oldRect;
+                } else {
+                    moved = true;
+                    heightDiff = heightForWidth(cell, target.width() + widthDiff) - target.height();
+                    yDiff = heightDiff / 2;
+                }
+
+                // Attempt enlarging to the bottom-right
+                oldRect = target;
+                target.setRect(target.x() + xDiff,
+                               target.y() + yDiff,
+                               target.width() + widthDiff,
+                               target.height() + heightDiff);
+                if (isOverlappingAny(i)) {
+                    target = oldRect;
+                } else {
+                    moved = true;
+                    heightDiff = heightForWidth(cell, target.width() + widthDiff) - target.height();
+                    yDiff = heightDiff / 2;
+                }
+
+                // Attempt enlarging to the bottom-left
+                oldRect = target;
+                target.setRect(target.x() - xDiff - widthDiff,
+                               target.y() + yDiff,
+                               target.width() + widthDiff,
+                               target.height() + heightDiff);
+                if (isOverlappingAny(i)) {
+                    target = oldRect;
+                } else {
+                    moved = true;
+                    heightDiff = heightForWidth(cell, target.width() + widthDiff) - target.height();
+                    yDiff = heightDiff / 2;
+                }
+
+                // Attempt enlarging to the top-left
+                oldRect = target;
+                target.setRect(target.x() - xDiff - widthDiff,
+                               target.y() - yDiff - heightDiff,
+                               target.width() + widthDiff,
+                               target.height() + heightDiff);
+                if (isOverlappingAny(i)) {
+                    target = oldRect;
+                } else {
+                    moved = true;
+                }
+
+                // Let the other windows see the new geometry.
+                if (target != initialRect) {
+                    grid.insert(i, target.marginsAdded(halfSpacingMargins));
+                }
+            }
+        } while (moved);
+
+        // The expanding code above can actually enlarge windows over 1.0/2.0 scale, we don't like this
+        // We can't add this to the loop above as it would cause a never-ending loop so we have to make
+        // do with the less-than-optimal space usage with using this method.
+        for (int i = 0; i < count; ++i) {
+            const QRect &naturalRect = input.cells[i].naturalRect;
+            QRect &target = targets[i];
+            qreal scale = target.width() / qreal(naturalRect.width());
+            if (scale > 2.0 || (scale > 1.0 && (naturalRect.width() > 300 || naturalRect.height() > 300))) {
+                scale = (naturalRect.width() > 300 || naturalRect.height() > 300) ? 1.0 : 2.0;
+                target.setRect(target.center().x() - int(naturalRect.width() * scale) / 2,
+                               target.center().y() - int(naturalRect.height() * scale) / 2,
+                               naturalRect.width() * scale,
+                               naturalRect.height() * scale);
+            }
+        }
+    }
+
+    qint64 coveredArea = 0;
+    result.rects.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const Cell &cell = input.cells[i];
+        const QRect rect = centered(cell, targets[i].marginsRemoved(cell.margins));
+        coveredArea += qint64(rect.width()) * rect.height();
+        result.rects.push_back(rect);
+    }
+    if (!area.isEmpty()) {
+        result.coverage = coveredArea / (qreal(area.width()) * area.height());
+    }
+
+    return result;
+}
@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QMargins>
+#include <QRect>
+
+#include <vector>
+
+/**
+ * The ExpoLayoutSolver computes the natural layout of an ExpoLayout.
+ *
+ * Overlapping cells are pushed apart in small steps until no two cells overlap. Candidates
+ * for an overlap are looked up in a uniform grid that is rebuilt at the start of every pass,
+ * so a pass costs roughly linear time in the number of cells rather than quadratic time.
+ *
+ * The solver only works on plain values, so it can run in a worker thread.
+ */
+class ExpoLayoutSolver
+{
+public:
+    struct Cell
+    {
+        QRect naturalRect;
+        QMargins margins;
+
+        bool operator==(const Cell &other) const = default;
+    };
+
+    struct Input
+    {
+        /**
+         * The cells to lay out. The order of the cells determines the direction in which
+         * they are pulled when they end up on the edge of the layout, so it must be stable.
+         */
+        std::vector<Cell> cells;
+        QRect area;
+        int spacing = 10;
+        /**
+         * The distance in pixels by which overlapping cells are pushed apart in every step.
+         */
+        int accuracy = 20;
+        bool fillGaps = false;
+        /**
+         * The maximum number of passes of each stage of the solver. If the cells still
+         * overlap after that many passes, the layout is used as is.
+         */
+        int maxIterations = 1000;
+
+        bool operator==(const Input &other) const = default;
+    };
+
+    struct Result
+    {
+        /**
+         * The geometry of every cell, in the same order as in the input.
+         */
+        std::vector<QRect> rects;
+        /**
+         * The number of passes needed to separate the cells.
+         */
+        int iterations = 0;
+        /**
+         * The number of passes needed to fill the gaps between the cells.
+         */
+        int fillIterations = 0;
+        /**
+         * Whether all overlaps have been resolved within the iteration cap.
+         */
+        bool converged = true;
+        /**
+         * The number of pairs of cells that still overlap.
+         */
+        int overlaps = 0;
+        /**
+         * The factor by which the cells are scaled down to fit into the area.
+         */
+        qreal scale = 1.0;
+        /**
+         * The fraction of the area that is covered by the cells.
+         */
+        qreal coverage = 0.0;
+    };
+
+    static Result solve(const Input &input);
+};
@@ -128,6 +128,7 @@ FocusScope {
 
         anchors.fill: parent
         anchors.margins: heap.padding
+        asynchronous: true
         fillGaps: true
         spacing: PlasmaCore.Units.smallSpacing * 5
 
@@ -29,6 +29,10 @@ public:
     void prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseconds presentTime) override;
     void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
     bool isActive() const override;
+    PaintHooks paintHooks() const override
+    {
+        return PrePaintScreenHook | PaintScreenHook;
+    }
 
     int requestedEffectChainPosition() const override
     {
@@ -3,7 +3,6 @@
     This file is part of the KDE project.
 
     SPDX-FileCopyrightText: 2010 Martin Gräßlin <mgraesslin@kde.org>
-    SPDX-FileCopyrightText: 2010 Nokia Corporation and /or its subsidiary(-ies)
     SPDX-FileCopyrightText: 2021 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
 
     SPDX-License-Identifier: GPL-2.0-or-later
@@ -11,10 +10,12 @@
 #include "screenshot.h"
 #include "screenshotdbusinterface1.h"
 #include "screenshotdbusinterface2.h"
+#include "screenshotlogging.h"
 
 #include <kwinglplatform.h>
 #include <kwinglutils.h>
 
+#include <QElapsedTimer>
 #include <QPainter>
 
 namespace KWin
@@ -24,7 +25,9 @@ struct ScreenShotWindowData
 {
     QFutureInterface<QImage> promise;
     ScreenShotFlags flags;
+    ScreenShotAllocator allocator;
     EffectWindow *window = nullptr;
+    QElapsedTimer latency;
 };
 
 struct ScreenShotAreaData
@@ -34,43 +37,110 @@ struct ScreenShotAreaData
     QRect area;
     QImage result;
     QList<EffectScreen *> screens;
+    int pendingReadbacks = 0;
+    QElapsedTimer latency;
 };
 
 struct ScreenShotScreenData
 {
     QFutureInterface<QImage> promise;
     ScreenShotFlags flags;
+    ScreenShotAllocator allocator;
     EffectScreen *screen = nullptr;
+    QElapsedTimer latency;
 };
 
-static void convertFromGLImage(QImage &img, int w, int h)
-{
-    // from QtOpenGL/qgl.cpp
-    // SPDX-FileCopyrightText: 2010 Nokia Corporation and /or its subsidiary(-ies)
-    // see https://github.com/qt/qtbase/blob/dev/src/opengl/qgl.cpp
-    if (QSysInfo::ByteOrder == QSysInfo::BigEndian) {
-        // OpenGL gives RGBA; Qt wants ARGB
-        uint *p = reinterpret_cast<uint *>(img.bits());
-        uint *end = p + w * h;
-        while (p < end) {
-            uint a = *p << 24;
-            *p = (*p >> 8) | a;
-            p++;
+/**
+ * A pending copy of framebuffer pixels into a pixel buffer object.
+ */
+struct ScreenShotReadback
+{
+    ~ScreenShotReadback()
+    {
+        if (fence) {
+            glDeleteSync(fence);
         }
-    } else {
-        // OpenGL gives ABGR (i.e. RGBA backwards); Qt wants ARGB
-        for (int y = 0; y < h; y++) {
-            uint *q = reinterpret_cast<uint *>(img.scanLine(y));
-            for (int x = 0; x < w; ++x) {
-                const uint pixel = *q;
-                *q = ((pixel << 16) & 0xff0000) | ((pixel >> 16) & 0xff)
-                    | (pixel & 0xff00ff00);
-
-                q++;
-            }
+        if (buffer) {
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+
+    GLuint buffer = 0;
+    GLsync fence = nullptr;
+    QSize size;
+    qreal devicePixelRatio = 1.0;
+    QImage::Format format;
+    ScreenShotAllocator allocator;
+    std::function<void(QImage image)> callback;
+    QElapsedTimer elapsed;
+};
+
+struct ReadbackFormat
+{
+    GLenum format;
+    GLenum type;
+    QImage::Format imageFormat;
+};
+
+/**
+ * Returns the pixel format to read back in, so the pixels don't have to be swizzled by the CPU.
+ */
+static ReadbackFormat readbackFormat()
+{
+    if (!GLPlatform::instance()->isGLES()) {
+        // Matches the native-endian 0xAARRGGBB layout of QImage::Format_ARGB32.
+        return {GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, QImage::Format_ARGB32};
+    }
+    if (QSysInfo::ByteOrder == QSysInfo::LittleEndian && hasGLExtension(QByteArrayLiteral("GL_EXT_read_format_bgra"))) {
+        return {GL_BGRA_EXT, GL_UNSIGNED_BYTE, QImage::Format_ARGB32};
+    }
+    return {GL_RGBA, GL_UNSIGNED_BYTE, QImage::Format_RGBA8888};
+}
+
+// The pending readbacks are polled with a growing interval if no frame is painted, so the
+// OpenGL context isn't made current too often while the GPU is busy.
+static const std::chrono::milliseconds s_minimumReadbackPollInterval(2);
+static const std::chrono::milliseconds s_maximumReadbackPollInterval(32);
+
+static bool supportsAsyncReadback()
+{
+    static const bool supported = [] {
+        if (qEnvironmentVariableIsSet("KWIN_SCREENSHOT_ASYNC_READBACK") && !qEnvironmentVariableIntValue("KWIN_SCREENSHOT_ASYNC_READBACK")) {
+            return false;
+        }
+        if (GLPlatform::instance()->isGLES()) {
+            return hasGLVersion(3, 0);
+        }
+        return hasGLVersion(3, 2)
+            || (hasGLVersion(2, 1) && hasGLExtension(QByteArrayLiteral("GL_ARB_sync")) && hasGLExtension(QByteArrayLiteral("GL_ARB_map_buffer_range")));
+    }();
+    return supported;
+}
+
+/**
+ * Keeps the image compatible with the consumers that expect QImage::Format_ARGB32.
+ */
+static QImage finalizeImage(QImage image)
+{
+    if (image.format() != QImage::Format_ARGB32) {
+        image.convertTo(QImage::Format_ARGB32);
+    }
+    return image;
+}
+
+/**
+ * Creates the image that the pixels are read into. The @p allocator is only used if the pixels
+ * don't have to be converted afterwards.
+ */
+static QImage allocateImage(const QSize &size, QImage::Format format, const ScreenShotAllocator &allocator)
+{
+    if (allocator && format == QImage::Format_ARGB32) {
+        QImage image = allocator(size, format);
+        if (image.size() == size && image.format() == format) {
+            return image;
         }
     }
-    img = img.mirrored();
+    return QImage(size, format);
 }
 
 bool ScreenShotEffect::supported()
@@ -85,16 +155,31 @@ ScreenShotEffect::ScreenShotEffect()
     connect(effects, &EffectsHandler::screenAdded, this, &ScreenShotEffect::handleScreenAdded);
     connect(effects, &EffectsHandler::screenRemoved, this, &ScreenShotEffect::handleScreenRemoved);
     connect(effects, &EffectsHandler::windowClosed, this, &ScreenShotEffect::handleWindowClosed);
+
+    // Pending readbacks are polled while painting, the timer only completes them if no frame
+    // is painted soon.
+    m_readbackTimer.setSingleShot(true);
+    connect(&m_readbackTimer, &QTimer::timeout, this, [this]() {
+        if (effects->makeOpenGLContextCurrent()) {
+            pollReadbacks();
+            effects->doneOpenGLContextCurrent();
+        }
+        if (!m_readbacks.empty()) {
+            m_readbackTimer.setInterval(std::min(m_readbackTimer.intervalAsDuration() * 2, s_maximumReadbackPollInterval));
+            m_readbackTimer.start();
+        }
+    });
 }
 
 ScreenShotEffect::~ScreenShotEffect()
 {
+    cancelReadbacks();
     cancelWindowScreenShots();
     cancelAreaScreenShots();
     cancelScreenScreenShots();
 }
 
-QFuture<QImage> ScreenShotEffect::scheduleScreenShot(EffectScreen *screen, ScreenShotFlags flags)
+QFuture<QImage> ScreenShotEffect::scheduleScreenShot(EffectScreen *screen, ScreenShotFlags flags, ScreenShotAllocator allocator)
 {
     for (ScreenShotScreenData &data : m_screenScreenShots) {
         if (data.screen == screen && data.flags == flags) {
@@ -105,6 +190,8 @@ QFuture<QImage> ScreenShotEffect::scheduleScreenShot(EffectScreen *screen, Scree
     ScreenShotScreenData data;
     data.screen = screen;
     data.flags = flags;
+    data.allocator = std::move(allocator);
+    data.latency.start();
 
     m_screenScreenShots.append(data);
     effects->addRepaint(screen->geometry());
@@ -113,10 +200,10 @@ QFuture<QImage> ScreenShotEffect::scheduleScreenShot(EffectScreen *screen, Scree
     return data.promise.future();
 }
 
-QFuture<QImage> ScreenShotEffect::scheduleScreenShot(const QRect &area, ScreenShotFlags flags)
+QFuture<QImage> ScreenShotEffect::scheduleScreenShot(const QRect &area, ScreenShotFlags flags, ScreenShotAllocator allocator)
 {
     for (ScreenShotAreaData &data : m_areaScreenShots) {
-        if (data.area == area && data.flags == flags) {
+        if (data.area == area && data.flags == flags && !data.screens.isEmpty()) {
             return data.promise.future();
         }
     }
@@ -124,6 +211,7 @@ QFuture<QImage> ScreenShotEffect::scheduleScreenShot(const QRect &area, ScreenSh
     ScreenShotAreaData data;
     data.area = area;
     data.flags = flags;
+    data.latency.start();
 
     const QList<EffectScreen *> screens = effects->screens();
     for (EffectScreen *screen : screens) {
@@ -141,7 +229,15 @@ QFuture<QImage> ScreenShotEffect::scheduleScreenShot(const QRect &area, ScreenSh
         }
     }
 
-    data.result = QImage(area.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    // The readbacks of the screens are composited into the result, so it can be placed in the
+    // memory of the requester right away.
+    const QSize nativeSize = area.size() * devicePixelRatio;
+    if (allocator) {
+        data.result = allocator(nativeSize, QImage::Format_ARGB32_Premultiplied);
+    }
+    if (data.result.size() != nativeSize || data.result.format() != QImage::Format_ARGB32_Premultiplied) {
+        data.result = QImage(nativeSize, QImage::Format_ARGB32_Premultiplied);
+    }
     data.result.fill(Qt::transparent);
     data.result.setDevicePixelRatio(devicePixelRatio);
 
@@ -152,7 +248,7 @@ QFuture<QImage> ScreenShotEffect::scheduleScreenShot(const QRect &area, ScreenSh
     return data.promise.future();
 }
 
-QFuture<QImage> ScreenShotEffect::scheduleScreenShot(EffectWindow *window, ScreenShotFlags flags)
+QFuture<QImage> ScreenShotEffect::scheduleScreenShot(EffectWindow *window, ScreenShotFlags flags, ScreenShotAllocator allocator)
 {
     for (ScreenShotWindowData &data : m_windowScreenShots) {
         if (data.window == window && data.flags == flags) {
@@ -163,6 +259,8 @@ QFuture<QImage> ScreenShotEffect::scheduleScreenShot(EffectWindow *window, Scree
     ScreenShotWindowData data;
     data.window = window;
     data.flags = flags;
+    data.allocator = std::move(allocator);
+    data.latency.start();
 
     m_windowScreenShots.append(data);
     window->addRepaintFull();
@@ -197,6 +295,9 @@ void ScreenShotEffect::cancelScreenScreenShots()
 
 void ScreenShotEffect::paintScreen(int mask, const QRegion &region, ScreenPaintData &data)
 {
+    // Complete the screenshots whose pixels have been copied in the meantime.
+    pollReadbacks();
+
     m_paintedScreen = data.screen();
     effects->paintScreen(mask, region, data);
 
@@ -206,16 +307,27 @@ void ScreenShotEffect::paintScreen(int mask, const QRegion &region, ScreenPaintD
     }
 
     for (int i = m_areaScreenShots.count() - 1; i >= 0; --i) {
-        if (takeScreenShot(&m_areaScreenShots[i])) {
-            m_areaScreenShots.removeAt(i);
-        }
+        takeScreenShot(&m_areaScreenShots[i]);
     }
+    finishAreaScreenShots();
 
     for (int i = m_screenScreenShots.count() - 1; i >= 0; --i) {
         if (takeScreenShot(&m_screenScreenShots[i])) {
             m_screenScreenShots.removeAt(i);
         }
     }
+
+    if (!m_readbacks.empty()) {
+        scheduleReadbackPoll();
+    }
+}
+
+void ScreenShotEffect::scheduleReadbackPoll()
+{
+    if (!m_readbackTimer.isActive()) {
+        m_readbackTimer.setInterval(s_minimumReadbackPollInterval);
+        m_readbackTimer.start();
+    }
 }
 
 void ScreenShotEffect::takeScreenShot(ScreenShotWindowData *screenshot)
@@ -250,52 +362,82 @@ void ScreenShotEffect::takeScreenShot(ScreenShotWindowData *screenshot)
 
         // render window into offscreen texture
         int mask = PAINT_WINDOW_TRANSFORMED | PAINT_WINDOW_TRANSLUCENT;
-        QImage img;
         if (effects->isOpenGLCompositing()) {
+            ReadbackCallback callback = [this, promise = screenshot->promise, flags = screenshot->flags,
+                                         latency = screenshot->latency, geometry](QImage image) mutable {
+                if (image.isNull()) {
+                    promise.reportCanceled();
+                    return;
+                }
+                if (flags & ScreenShotIncludeCursor) {
+                    grabPointerImage(image, geometry.x(), geometry.y());
+                }
+                qCDebug(KWIN_SCREENSHOT) << "Window screenshot taken in" << latency.nsecsElapsed() / 1000 << "us";
+                promise.reportResult(image);
+                promise.reportFinished();
+            };
+
             GLFramebuffer::pushFramebuffer(target.get());
             glClearColor(0.0, 0.0, 0.0, 0.0);
             glClear(GL_COLOR_BUFFER_BIT);
             glClearColor(0.0, 0.0, 0.0, 1.0);
 
+            // Render the window upside down, so the rows are read back top to bottom.
             QMatrix4x4 projection;
-            projection.ortho(QRect(0, 0, geometry.width() * devicePixelRatio, geometry.height() * devicePixelRatio));
+            projection.ortho(0, geometry.width() * devicePixelRatio, 0, geometry.height() * devicePixelRatio, -1, 1);
             d.setProjectionMatrix(projection);
 
             effects->drawWindow(window, mask, infiniteRegion(), d);
 
-            // copy content from framebuffer into image
-            img = QImage(offscreenTexture->size(), QImage::Format_ARGB32);
-            img.setDevicePixelRatio(devicePixelRatio);
-            glReadnPixels(0, 0, img.width(), img.height(), GL_RGBA, GL_UNSIGNED_BYTE, img.sizeInBytes(),
-                          static_cast<GLvoid *>(img.bits()));
+            readFramebuffer(offscreenTexture->size(), devicePixelRatio, screenshot->allocator, std::move(callback));
             GLFramebuffer::popFramebuffer();
-            convertFromGLImage(img, img.width(), img.height());
-        }
-
-        if (screenshot->flags & ScreenShotIncludeCursor) {
-            grabPointerImage(img, geometry.x(), geometry.y());
+        } else {
+            // Windows can't be painted into an image with the QPainter compositor, the requester
+            // gets an empty image as before.
+            screenshot->promise.reportResult(QImage());
+            screenshot->promise.reportFinished();
         }
-
-        screenshot->promise.reportResult(img);
-        screenshot->promise.reportFinished();
     } else {
         screenshot->promise.reportCanceled();
     }
 }
 
-bool ScreenShotEffect::takeScreenShot(ScreenShotAreaData *screenshot)
+void ScreenShotEffect::takeScreenShot(ScreenShotAreaData *screenshot)
 {
+    // The callbacks look the screenshot up again, it may have been cancelled in the meantime.
+    auto composite = [this, promise = screenshot->promise](const QRect &sourceRect, const QImage &snapshot) {
+        auto it = std::find_if(m_areaScreenShots.begin(), m_areaScreenShots.end(), [&promise](const ScreenShotAreaData &data) {
+            return data.promise == promise;
+        });
+        if (it == m_areaScreenShots.end()) {
+            return;
+        }
+        it->pendingReadbacks--;
+        if (snapshot.isNull()) {
+            it->promise.reportCanceled();
+            return;
+        }
+
+        const QRect nativeArea(it->area.topLeft(), it->area.size() * it->result.devicePixelRatio());
+        QPainter painter(&it->result);
+        painter.setWindow(nativeArea);
+        painter.drawImage(sourceRect, snapshot);
+        painter.end();
+    };
+
     if (!effects->waylandDisplay()) {
         // On X11, all screens are painted simultaneously and there is no native HiDPI support.
-        QImage snapshot = blitScreenshot(screenshot->area);
-        if (screenshot->flags & ScreenShotIncludeCursor) {
-            grabPointerImage(snapshot, screenshot->area.x(), screenshot->area.y());
+        if (screenshot->screens.isEmpty()) {
+            return;
         }
-        screenshot->promise.reportResult(snapshot);
-        screenshot->promise.reportFinished();
+        screenshot->screens.clear();
+        screenshot->pendingReadbacks++;
+        blitScreenshot(screenshot->area, 1.0, ScreenShotAllocator(), [composite, area = screenshot->area](QImage image) {
+            composite(area, image);
+        });
     } else {
         if (!screenshot->screens.contains(m_paintedScreen)) {
-            return false;
+            return;
         }
         screenshot->screens.removeOne(m_paintedScreen);
 
@@ -305,25 +447,33 @@ bool ScreenShotEffect::takeScreenShot(ScreenShotAreaData *screenshot)
             sourceDevicePixelRatio = m_paintedScreen->devicePixelRatio();
         }
 
-        const QImage snapshot = blitScreenshot(sourceRect, sourceDevicePixelRatio);
-        const QRect nativeArea(screenshot->area.topLeft(),
-                               screenshot->area.size() * screenshot->result.devicePixelRatio());
+        screenshot->pendingReadbacks++;
+        blitScreenshot(sourceRect, sourceDevicePixelRatio, ScreenShotAllocator(), [composite, sourceRect](QImage image) {
+            composite(sourceRect, image);
+        });
+    }
+}
 
-        QPainter painter(&screenshot->result);
-        painter.setWindow(nativeArea);
-        painter.drawImage(sourceRect, snapshot);
-        painter.end();
+void ScreenShotEffect::finishAreaScreenShots()
+{
+    for (int i = m_areaScreenShots.count() - 1; i >= 0; --i) {
+        ScreenShotAreaData &screenshot = m_areaScreenShots[i];
+        if (screenshot.promise.isCanceled()) {
+            m_areaScreenShots.removeAt(i);
+            continue;
+        }
+        if (!screenshot.screens.isEmpty() || screenshot.pendingReadbacks) {
+            continue;
+        }
 
-        if (screenshot->screens.isEmpty()) {
-            if (screenshot->flags & ScreenShotIncludeCursor) {
-                grabPointerImage(screenshot->result, screenshot->area.x(), screenshot->area.y());
-            }
-            screenshot->promise.reportResult(screenshot->result);
-            screenshot->promise.reportFinished();
+        if (screenshot.flags & ScreenShotIncludeCursor) {
+            grabPointerImage(screenshot.result, screenshot.area.x(), screenshot.area.y());
         }
+        qCDebug(KWIN_SCREENSHOT) << "Area screenshot taken in" << screenshot.latency.nsecsElapsed() / 1000 << "us";
+        screenshot.promise.reportResult(screenshot.result);
+        screenshot.promise.reportFinished();
+        m_areaScreenShots.removeAt(i);
     }
-
-    return screenshot->promise.isFinished();
 }
 
 bool ScreenShotEffect::takeScreenShot(ScreenShotScreenData *screenshot)
@@ -334,47 +484,149 @@ bool ScreenShotEffect::takeScreenShot(ScreenShotScreenData *screenshot)
             devicePixelRatio = screenshot->screen->devicePixelRatio();
         }
 
-        QImage snapshot = blitScreenshot(screenshot->screen->geometry(), devicePixelRatio);
-        if (screenshot->flags & ScreenShotIncludeCursor) {
-            const int xOffset = screenshot->screen->geometry().x();
-            const int yOffset = screenshot->screen->geometry().y();
-            grabPointerImage(snapshot, xOffset, yOffset);
-        }
+        const QRect geometry = screenshot->screen->geometry();
+        blitScreenshot(geometry, devicePixelRatio, screenshot->allocator, [this, promise = screenshot->promise, flags = screenshot->flags, latency = screenshot->latency, geometry](QImage image) mutable {
+            if (image.isNull()) {
+                promise.reportCanceled();
+                return;
+            }
+            if (flags & ScreenShotIncludeCursor) {
+                grabPointerImage(image, geometry.x(), geometry.y());
+            }
+            qCDebug(KWIN_SCREENSHOT) << "Screen screenshot taken in" << latency.nsecsElapsed() / 1000 << "us";
+            promise.reportResult(image);
+            promise.reportFinished();
+        });
+        return true;
+    }
+
+    return false;
+}
 
-        screenshot->promise.reportResult(snapshot);
-        screenshot->promise.reportFinished();
+void ScreenShotEffect::blitScreenshot(const QRect &geometry, qreal devicePixelRatio, const ScreenShotAllocator &allocator, ReadbackCallback callback)
+{
+    if (!effects->isOpenGLCompositing()) {
+        callback(QImage());
+        return;
     }
 
-    return screenshot->promise.isFinished();
+    const QSize nativeSize = geometry.size() * devicePixelRatio;
+
+    if (GLFramebuffer::blitSupported()) {
+        GLTexture texture(GL_RGBA8, nativeSize.width(), nativeSize.height());
+        GLFramebuffer target(&texture);
+
+        // Copy the pixels upside down, so the rows are read back top to bottom.
+        const GLFramebuffer *source = GLFramebuffer::currentFramebuffer();
+        const QRect sourceRect = effects->mapToRenderTarget(QRectF(geometry)).toRect();
+        GLFramebuffer::pushFramebuffer(&target);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, source->handle());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.handle());
+        glBlitFramebuffer(sourceRect.x(), source->size().height() - (sourceRect.y() + sourceRect.height()),
+                          sourceRect.x() + sourceRect.width(), source->size().height() - sourceRect.y(),
+                          0, nativeSize.height(), nativeSize.width(), 0,
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.handle());
+
+        readFramebuffer(nativeSize, devicePixelRatio, allocator, std::move(callback));
+        GLFramebuffer::popFramebuffer();
+    } else {
+        const ReadbackFormat format = readbackFormat();
+        QImage image(nativeSize, format.imageFormat);
+        glReadnPixels(0, 0, nativeSize.width(), nativeSize.height(), format.format, format.type,
+                      image.sizeInBytes(), static_cast<GLvoid *>(image.bits()));
+        image = finalizeImage(std::move(image).mirrored());
+        image.setDevicePixelRatio(devicePixelRatio);
+        callback(std::move(image));
+    }
 }
 
-QImage ScreenShotEffect::blitScreenshot(const QRect &geometry, qreal devicePixelRatio) const
+void ScreenShotEffect::readFramebuffer(const QSize &size, qreal devicePixelRatio, const ScreenShotAllocator &allocator, ReadbackCallback callback)
 {
-    QImage image;
+    const ReadbackFormat format = readbackFormat();
+
+    if (!supportsAsyncReadback()) {
+        QImage image = allocateImage(size, format.imageFormat, allocator);
+        glReadnPixels(0, 0, size.width(), size.height(), format.format, format.type,
+                      image.sizeInBytes(), static_cast<GLvoid *>(image.bits()));
+        image = finalizeImage(std::move(image));
+        image.setDevicePixelRatio(devicePixelRatio);
+        callback(std::move(image));
+        return;
+    }
 
-    if (effects->isOpenGLCompositing()) {
-        const QSize nativeSize = geometry.size() * devicePixelRatio;
-
-        if (GLFramebuffer::blitSupported() && !GLPlatform::instance()->isGLES()) {
-            image = QImage(nativeSize.width(), nativeSize.height(), QImage::Format_ARGB32);
-            GLTexture texture(GL_RGBA8, nativeSize.width(), nativeSize.height());
-            GLFramebuffer target(&texture);
-            target.blitFromFramebuffer(effects->mapToRenderTarget(QRectF(geometry)).toRect());
-            // copy content from framebuffer into image
-            texture.bind();
-            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                          static_cast<GLvoid *>(image.bits()));
-            texture.unbind();
+    auto readback = std::make_unique<ScreenShotReadback>();
+    readback->size = size;
+    readback->devicePixelRatio = devicePixelRatio;
+    readback->format = format.imageFormat;
+    readback->allocator = allocator;
+    readback->callback = std::move(callback);
+    readback->elapsed.start();
+
+    glGenBuffers(1, &readback->buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size.width() * size.height() * 4, nullptr, GL_STREAM_READ);
+    glReadPixels(0, 0, size.width(), size.height(), format.format, format.type, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_readbacks.push_back(std::move(readback));
+}
+
+void ScreenShotEffect::pollReadbacks()
+{
+    std::vector<std::unique_ptr<ScreenShotReadback>> finished;
+    for (auto it = m_readbacks.begin(); it != m_readbacks.end();) {
+        const GLenum status = glClientWaitSync((*it)->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            ++it;
         } else {
-            image = QImage(nativeSize.width(), nativeSize.height(), QImage::Format_ARGB32);
-            glReadPixels(0, 0, nativeSize.width(), nativeSize.height(), GL_RGBA,
-                         GL_UNSIGNED_BYTE, static_cast<GLvoid *>(image.bits()));
+            finished.push_back(std::move(*it));
+            it = m_readbacks.erase(it);
         }
-        convertFromGLImage(image, nativeSize.width(), nativeSize.height());
+    }
+    if (m_readbacks.empty()) {
+        m_readbackTimer.stop();
     }
 
-    image.setDevicePixelRatio(devicePixelRatio);
-    return image;
+    for (const auto &readback : finished) {
+        QImage image = allocateImage(readback->size, readback->format, readback->allocator);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+        const void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, image.sizeInBytes(), GL_MAP_READ_BIT);
+        if (data) {
+            memcpy(image.bits(), data, image.sizeInBytes());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            image = finalizeImage(std::move(image));
+            image.setDevicePixelRatio(readback->devicePixelRatio);
+        } else {
+            qCWarning(KWIN_SCREENSHOT) << "Failed to map the screenshot pixel buffer";
+            image = QImage();
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        qCDebug(KWIN_SCREENSHOT) << "Read back" << readback->size << "in" << readback->elapsed.nsecsElapsed() / 1000 << "us";
+        readback->callback(std::move(image));
+    }
+
+    if (!finished.empty()) {
+        finishAreaScreenShots();
+    }
+}
+
+void ScreenShotEffect::cancelReadbacks()
+{
+    m_readbackTimer.stop();
+    if (m_readbacks.empty()) {
+        return;
+    }
+
+    effects->makeOpenGLContextCurrent();
+    std::vector<std::unique_ptr<ScreenShotReadback>> readbacks = std::move(m_readbacks);
+    for (const auto &readback : readbacks) {
+        readback->callback(QImage());
+    }
+    readbacks.clear();
+    effects->doneOpenGLContextCurrent();
 }
 
 void ScreenShotEffect::grabPointerImage(QImage &snapshot, int xOffset, int yOffset) const
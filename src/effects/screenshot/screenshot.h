@@ -16,6 +16,11 @@
 #include <QFutureInterface>
 #include <QImage>
 #include <QObject>
+#include <QTimer>
+
+#include <functional>
+#include <memory>
+#include <vector>
 
 namespace KWin
 {
@@ -30,11 +35,18 @@ enum ScreenShotFlag {
 };
 Q_DECLARE_FLAGS(ScreenShotFlags, ScreenShotFlag)
 
+/**
+ * Creates the image that the pixels of a screenshot are read into, with the given size and
+ * format. It can be used to place the pixels directly in memory shared with the requester.
+ */
+using ScreenShotAllocator = std::function<QImage(const QSize &size, QImage::Format format)>;
+
 class ScreenShotDBusInterface1;
 class ScreenShotDBusInterface2;
 struct ScreenShotWindowData;
 struct ScreenShotAreaData;
 struct ScreenShotScreenData;
+struct ScreenShotReadback;
 
 /**
  * The ScreenShotEffect provides a convenient way to capture the contents of a given window,
@@ -43,6 +55,13 @@ struct ScreenShotScreenData;
  * Use the QFutureWatcher class to get notified when the requested screenshot is ready. Note
  * that the screenshot QFuture object can get cancelled if the captured window or the screen is
  * removed.
+ *
+ * If the driver supports pixel buffer objects and fences, the pixels are copied into a buffer
+ * object while the frame is painted and the screenshot is completed once the GPU has finished
+ * the copy, typically while the next frame is painted. This avoids stalling the compositor.
+ *
+ * An optional ScreenShotAllocator provides the image the pixels end up in. It's not used if
+ * an identical screenshot is already pending, the requesters share that screenshot then.
  */
 class ScreenShotEffect : public Effect
 {
@@ -57,23 +76,27 @@ public:
      * the image data. If the screen is removed before the screenshot is taken, the future will
      * be cancelled.
      */
-    QFuture<QImage> scheduleScreenShot(EffectScreen *screen, ScreenShotFlags flags = {});
+    QFuture<QImage> scheduleScreenShot(EffectScreen *screen, ScreenShotFlags flags = {}, ScreenShotAllocator allocator = {});
 
     /**
      * Schedules a screenshot of the given @a area. The returned QFuture can be used to query the
      * image data.
      */
-    QFuture<QImage> scheduleScreenShot(const QRect &area, ScreenShotFlags flags = {});
+    QFuture<QImage> scheduleScreenShot(const QRect &area, ScreenShotFlags flags = {}, ScreenShotAllocator allocator = {});
 
     /**
      * Schedules a screenshot of the given @a window. The returned QFuture can be used to query
      * the image data. If the window is removed before the screenshot is taken, the future will
      * be cancelled.
      */
-    QFuture<QImage> scheduleScreenShot(EffectWindow *window, ScreenShotFlags flags = {});
+    QFuture<QImage> scheduleScreenShot(EffectWindow *window, ScreenShotFlags flags = {}, ScreenShotAllocator allocator = {});
 
     void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
     bool isActive() const override;
+    PaintHooks paintHooks() const override
+    {
+        return PaintScreenHook;
+    }
     int requestedEffectChainPosition() const override;
 
     static bool supported();
@@ -85,15 +108,25 @@ private Q_SLOTS:
 
 private:
     void takeScreenShot(ScreenShotWindowData *screenshot);
-    bool takeScreenShot(ScreenShotAreaData *screenshot);
+    void takeScreenShot(ScreenShotAreaData *screenshot);
     bool takeScreenShot(ScreenShotScreenData *screenshot);
 
     void cancelWindowScreenShots();
     void cancelAreaScreenShots();
     void cancelScreenScreenShots();
 
+    /**
+     * Called with the captured image, or with a null image if the pixels couldn't be read.
+     */
+    using ReadbackCallback = std::function<void(QImage image)>;
+
     void grabPointerImage(QImage &snapshot, int xOffset, int yOffset) const;
-    QImage blitScreenshot(const QRect &geometry, qreal devicePixelRatio = 1.0) const;
+    void blitScreenshot(const QRect &geometry, qreal devicePixelRatio, const ScreenShotAllocator &allocator, ReadbackCallback callback);
+    void readFramebuffer(const QSize &size, qreal devicePixelRatio, const ScreenShotAllocator &allocator, ReadbackCallback callback);
+    void finishAreaScreenShots();
+    void pollReadbacks();
+    void scheduleReadbackPoll();
+    void cancelReadbacks();
 
     QVector<ScreenShotWindowData> m_windowScreenShots;
     QVector<ScreenShotAreaData> m_areaScreenShots;
@@ -102,6 +135,9 @@ private:
     std::unique_ptr<ScreenShotDBusInterface1> m_dbusInterface1;
     std::unique_ptr<ScreenShotDBusInterface2> m_dbusInterface2;
     EffectScreen *m_paintedScreen = nullptr;
+
+    std::vector<std::unique_ptr<ScreenShotReadback>> m_readbacks;
+    QTimer m_readbackTimer;
 };
 
 } // namespace KWin
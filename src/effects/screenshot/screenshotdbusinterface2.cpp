@@ -15,12 +15,16 @@
 
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
+#include <QElapsedTimer>
+#include <QPointer>
 #include <QtConcurrent>
 
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 namespace KWin
@@ -93,6 +97,69 @@ static void writeBufferToPipe(int fileDescriptor, const QByteArray &buffer)
     }
 }
 
+static bool isMemoryFile(int fileDescriptor)
+{
+    // Only memfds support seals, regular files keep being written like pipes.
+    return fcntl(fileDescriptor, F_GET_SEALS) != -1;
+}
+
+/**
+ * Maps the first @p size bytes of a memory file (memfd) provided by the caller, the file is
+ * grown if needed. Returns @c nullptr on failure.
+ */
+static void *mapMemoryFile(int fileDescriptor, qint64 size)
+{
+    struct stat status;
+    if (fstat(fileDescriptor, &status) == -1) {
+        qCWarning(KWIN_SCREENSHOT) << Q_FUNC_INFO << "fstat() failed:" << strerror(errno);
+        return nullptr;
+    }
+    if (status.st_size < size && ftruncate(fileDescriptor, size) == -1) {
+        qCWarning(KWIN_SCREENSHOT) << Q_FUNC_INFO << "ftruncate() failed:" << strerror(errno);
+        return nullptr;
+    }
+
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (data == MAP_FAILED) {
+        qCWarning(KWIN_SCREENSHOT) << Q_FUNC_INFO << "mmap() failed:" << strerror(errno);
+        return nullptr;
+    }
+    return data;
+}
+
+/**
+ * Writes the image to a memory file (memfd) provided by the caller. Unlike with a pipe, the
+ * caller doesn't need to read the data, it can map the file once the reply arrives.
+ */
+static void writeImageToMemoryFile(int fileDescriptor, const QImage &image)
+{
+    const qint64 size = image.sizeInBytes();
+    if (size == 0) {
+        close(fileDescriptor);
+        return;
+    }
+
+    void *data = mapMemoryFile(fileDescriptor, size);
+    if (data) {
+        memcpy(data, image.constBits(), size);
+        munmap(data, size);
+    }
+    close(fileDescriptor);
+}
+
+struct MemoryFileMapping
+{
+    void *data;
+    qint64 size;
+};
+
+static void unmapMemoryFile(void *info)
+{
+    auto mapping = static_cast<MemoryFileMapping *>(info);
+    munmap(mapping->data, mapping->size);
+    delete mapping;
+}
+
 static const QString s_dbusServiceName = QStringLiteral("org.kde.KWin.ScreenShot2");
 static const QString s_dbusInterface = QStringLiteral("org.kde.KWin.ScreenShot2");
 static const QString s_dbusObjectPath = QStringLiteral("/org/kde/KWin/ScreenShot2");
@@ -130,6 +197,7 @@ Q_SIGNALS:
 private:
     QFuture<QImage> m_future;
     QFutureWatcher<QImage> *m_watcher;
+    QElapsedTimer m_latency;
 };
 
 class ScreenShotSourceScreen2 : public ScreenShotSource2
@@ -137,7 +205,7 @@ class ScreenShotSourceScreen2 : public ScreenShotSource2
     Q_OBJECT
 
 public:
-    ScreenShotSourceScreen2(ScreenShotEffect *effect, EffectScreen *screen, ScreenShotFlags flags);
+    ScreenShotSourceScreen2(ScreenShotEffect *effect, EffectScreen *screen, ScreenShotFlags flags, ScreenShotAllocator allocator);
 
     QVariantMap attributes() const override;
 
@@ -150,7 +218,7 @@ class ScreenShotSourceArea2 : public ScreenShotSource2
     Q_OBJECT
 
 public:
-    ScreenShotSourceArea2(ScreenShotEffect *effect, const QRect &area, ScreenShotFlags flags);
+    ScreenShotSourceArea2(ScreenShotEffect *effect, const QRect &area, ScreenShotFlags flags, ScreenShotAllocator allocator);
 };
 
 class ScreenShotSourceWindow2 : public ScreenShotSource2
@@ -158,7 +226,7 @@ class ScreenShotSourceWindow2 : public ScreenShotSource2
     Q_OBJECT
 
 public:
-    ScreenShotSourceWindow2(ScreenShotEffect *effect, EffectWindow *window, ScreenShotFlags flags);
+    ScreenShotSourceWindow2(ScreenShotEffect *effect, EffectWindow *window, ScreenShotFlags flags, ScreenShotAllocator allocator);
 
     QVariantMap attributes() const override;
 
@@ -177,14 +245,25 @@ public:
     void cancel();
     void flush(const QImage &image, const QVariantMap &attributes);
 
+    /**
+     * Returns an allocator that places the screenshot directly in the memory file of the
+     * caller, if it has provided one, so the pixels don't have to be copied again.
+     */
+    ScreenShotAllocator allocator();
+
 private:
+    QImage allocate(const QSize &size, QImage::Format format);
+
     QDBusMessage m_replyMessage;
     int m_fileDescriptor;
+    bool m_memoryFile;
+    const uchar *m_mapping = nullptr;
 };
 
 ScreenShotSource2::ScreenShotSource2(const QFuture<QImage> &future)
     : m_future(future)
 {
+    m_latency.start();
     m_watcher = new QFutureWatcher<QImage>(this);
     connect(m_watcher, &QFutureWatcher<QImage>::finished, this, &ScreenShotSource2::completed);
     connect(m_watcher, &QFutureWatcher<QImage>::canceled, this, &ScreenShotSource2::cancelled);
@@ -208,13 +287,16 @@ QVariantMap ScreenShotSource2::attributes() const
 
 void ScreenShotSource2::marshal(ScreenShotSinkPipe2 *sink)
 {
-    sink->flush(m_future.result(), attributes());
+    QVariantMap results = attributes();
+    results.insert(QStringLiteral("latency"), quint64(m_latency.nsecsElapsed() / 1000));
+    sink->flush(m_future.result(), results);
 }
 
 ScreenShotSourceScreen2::ScreenShotSourceScreen2(ScreenShotEffect *effect,
                                                  EffectScreen *screen,
-                                                 ScreenShotFlags flags)
-    : ScreenShotSource2(effect->scheduleScreenShot(screen, flags))
+                                                 ScreenShotFlags flags,
+                                                 ScreenShotAllocator allocator)
+    : ScreenShotSource2(effect->scheduleScreenShot(screen, flags, std::move(allocator)))
     , m_screen(screen)
 {
 }
@@ -228,15 +310,17 @@ QVariantMap ScreenShotSourceScreen2::attributes() const
 
 ScreenShotSourceArea2::ScreenShotSourceArea2(ScreenShotEffect *effect,
                                              const QRect &area,
-                                             ScreenShotFlags flags)
-    : ScreenShotSource2(effect->scheduleScreenShot(area, flags))
+                                             ScreenShotFlags flags,
+                                             ScreenShotAllocator allocator)
+    : ScreenShotSource2(effect->scheduleScreenShot(area, flags, std::move(allocator)))
 {
 }
 
 ScreenShotSourceWindow2::ScreenShotSourceWindow2(ScreenShotEffect *effect,
                                                  EffectWindow *window,
-                                                 ScreenShotFlags flags)
-    : ScreenShotSource2(effect->scheduleScreenShot(window, flags))
+                                                 ScreenShotFlags flags,
+                                                 ScreenShotAllocator allocator)
+    : ScreenShotSource2(effect->scheduleScreenShot(window, flags, std::move(allocator)))
     , m_window(window)
 {
 }
@@ -251,6 +335,7 @@ QVariantMap ScreenShotSourceWindow2::attributes() const
 ScreenShotSinkPipe2::ScreenShotSinkPipe2(int fileDescriptor, QDBusMessage replyMessage)
     : m_replyMessage(replyMessage)
     , m_fileDescriptor(fileDescriptor)
+    , m_memoryFile(isMemoryFile(fileDescriptor))
 {
 }
 
@@ -281,19 +366,63 @@ void ScreenShotSinkPipe2::flush(const QImage &image, const QVariantMap &attribut
     results.insert(QStringLiteral("height"), quint32(image.height()));
     results.insert(QStringLiteral("stride"), quint32(image.bytesPerLine()));
     results.insert(QStringLiteral("scale"), double(image.devicePixelRatio()));
-    QDBusConnection::sessionBus().send(m_replyMessage.createReply(results));
 
-    QtConcurrent::run([](int fileDescriptor, const QImage &image) {
-        const QByteArray buffer(reinterpret_cast<const char *>(image.constBits()),
-                                image.sizeInBytes());
-        writeBufferToPipe(fileDescriptor, buffer);
-    },
-                      m_fileDescriptor, image);
+    if (m_memoryFile && m_mapping && image.constBits() == m_mapping) {
+        // The pixels have been read straight into the file.
+        close(m_fileDescriptor);
+        QDBusConnection::sessionBus().send(m_replyMessage.createReply(results));
+    } else if (m_memoryFile) {
+        // The image must be in the file by the time the caller gets the reply.
+        QtConcurrent::run([](int fileDescriptor, const QImage &image, const QDBusMessage &reply) {
+            writeImageToMemoryFile(fileDescriptor, image);
+            QDBusConnection::sessionBus().send(reply);
+        },
+                          m_fileDescriptor, image, m_replyMessage.createReply(results));
+    } else {
+        QDBusConnection::sessionBus().send(m_replyMessage.createReply(results));
+
+        QtConcurrent::run([](int fileDescriptor, const QImage &image) {
+            // The image is kept alive by the lambda, no need to copy the pixels.
+            const QByteArray buffer = QByteArray::fromRawData(reinterpret_cast<const char *>(image.constBits()),
+                                                              image.sizeInBytes());
+            writeBufferToPipe(fileDescriptor, buffer);
+        },
+                          m_fileDescriptor, image);
+    }
 
     // The ownership of the pipe file descriptor has been moved to the worker thread.
     m_fileDescriptor = -1;
 }
 
+ScreenShotAllocator ScreenShotSinkPipe2::allocator()
+{
+    if (!m_memoryFile) {
+        return ScreenShotAllocator();
+    }
+    // The screenshot can outlive the sink if it gets cancelled.
+    return [sink = QPointer<ScreenShotSinkPipe2>(this)](const QSize &size, QImage::Format format) {
+        return sink ? sink->allocate(size, format) : QImage();
+    };
+}
+
+QImage ScreenShotSinkPipe2::allocate(const QSize &size, QImage::Format format)
+{
+    if (m_fileDescriptor == -1 || m_mapping || size.isEmpty() || QImage::toPixelFormat(format).bitsPerPixel() != 32) {
+        return QImage();
+    }
+
+    const qint64 bytesPerLine = qint64(size.width()) * 4;
+    const qint64 byteCount = bytesPerLine * size.height();
+    void *data = mapMemoryFile(m_fileDescriptor, byteCount);
+    if (!data) {
+        return QImage();
+    }
+
+    m_mapping = static_cast<const uchar *>(data);
+    return QImage(static_cast<uchar *>(data), size.width(), size.height(), bytesPerLine, format,
+                  unmapMemoryFile, new MemoryFileMapping{data, byteCount});
+}
+
 ScreenShotDBusInterface2::ScreenShotDBusInterface2(ScreenShotEffect *effect)
     : QObject(effect)
     , m_effect(effect)
@@ -312,7 +441,7 @@ ScreenShotDBusInterface2::~ScreenShotDBusInterface2()
 
 int ScreenShotDBusInterface2::version() const
 {
-    return 4;
+    return 5;
 }
 
 bool ScreenShotDBusInterface2::checkPermissions() const
@@ -575,19 +704,19 @@ void ScreenShotDBusInterface2::bind(ScreenShotSinkPipe2 *sink, ScreenShotSource2
 void ScreenShotDBusInterface2::takeScreenShot(EffectScreen *screen, ScreenShotFlags flags,
                                               ScreenShotSinkPipe2 *sink)
 {
-    bind(sink, new ScreenShotSourceScreen2(m_effect, screen, flags));
+    bind(sink, new ScreenShotSourceScreen2(m_effect, screen, flags, sink->allocator()));
 }
 
 void ScreenShotDBusInterface2::takeScreenShot(const QRect &area, ScreenShotFlags flags,
                                               ScreenShotSinkPipe2 *sink)
 {
-    bind(sink, new ScreenShotSourceArea2(m_effect, area, flags));
+    bind(sink, new ScreenShotSourceArea2(m_effect, area, flags, sink->allocator()));
 }
 
 void ScreenShotDBusInterface2::takeScreenShot(EffectWindow *window, ScreenShotFlags flags,
                                               ScreenShotSinkPipe2 *sink)
 {
-    bind(sink, new ScreenShotSourceWindow2(m_effect, window, flags));
+    bind(sink, new ScreenShotSourceWindow2(m_effect, window, flags, sink->allocator()));
 }
 
 } // namespace KWin
@@ -36,6 +36,10 @@ public:
     void postPaintWindow(EffectWindow *w) override;
     void reconfigure(ReconfigureFlags flags) override;
     bool isActive() const override;
+    PaintHooks paintHooks() const override
+    {
+        return PrePaintWindowHook | PaintWindowHook | PostPaintWindowHook;
+    }
 
     int requestedEffectChainPosition() const override
     {
@@ -34,6 +34,10 @@ public:
     void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
     void postPaintScreen() override;
     bool isActive() const override;
+    PaintHooks paintHooks() const override
+    {
+        return PrePaintScreenHook | PaintScreenHook | PostPaintScreenHook;
+    }
 
     int requestedEffectChainPosition() const override
     {
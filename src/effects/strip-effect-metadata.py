@@ -19,6 +19,10 @@ def main():
         original_json = json.load(src)
         stripped_json["KPlugin"]["Id"] = original_json["KPlugin"]["Id"]
         stripped_json["KPlugin"]["EnabledByDefault"] = original_json["KPlugin"]["EnabledByDefault"]
+        # The effect loader needs to know which effects can be loaded after the first frame.
+        effect_json = original_json.get("org.kde.kwin.effect", dict())
+        if "loadDeferred" in effect_json:
+            stripped_json["org.kde.kwin.effect"] = dict(loadDeferred=effect_json["loadDeferred"])
 
     with open(args.output, "w") as dst:
         json.dump(stripped_json, dst)
@@ -10,6 +10,9 @@
 #include "wobblywindows.h"
 #include "wobblywindowsconfig.h"
 
+#include <kwinwindowmesh.h>
+
+#include <array>
 #include <cmath>
 
 //#define COMPUTE_STATS
@@ -264,32 +267,30 @@ void WobblyWindowsEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &da
     effects->prePaintWindow(w, data, presentTime);
 }
 
-void WobblyWindowsEffect::apply(EffectWindow *w, int mask, WindowPaintData &data, WindowQuadList &quads)
+void WobblyWindowsEffect::deform(EffectWindow *w, int mask, WindowPaintData &data, WindowMesh &mesh)
 {
     if (!(mask & PAINT_SCREEN_TRANSFORMED) && windows.contains(w)) {
-        quads = quads.makeRegularGrid(m_xTesselation, m_yTesselation);
-
-        WindowWobblyInfos &wwi = windows[w];
-        int tx = w->frameGeometry().x();
-        int ty = w->frameGeometry().y();
-        int width = w->frameGeometry().width();
-        int height = w->frameGeometry().height();
-        double left = 0.0;
-        double top = 0.0;
-        double right = w->width();
-        double bottom = w->height();
-        for (int i = 0; i < quads.count(); ++i) {
-            for (int j = 0; j < 4; ++j) {
-                WindowVertex &v = quads[i][j];
-                Pair uv = {v.x() / width, v.y() / height};
-                Pair newPos = computeBezierPoint(wwi, uv);
-                v.move(newPos.x - tx, newPos.y - ty);
+        mesh = mesh.makeRegularGrid(m_xTesselation, m_yTesselation);
+
+        const WindowWobblyInfos &wwi = windows[w];
+        const int tx = w->frameGeometry().x();
+        const int ty = w->frameGeometry().y();
+
+        // this assume the grid is 4*4
+        std::array<QPointF, 16> controlPoints;
+        for (unsigned int j = 0; j < 4; ++j) {
+            for (unsigned int i = 0; i < 4; ++i) {
+                const Pair &position = wwi.position[i + j * wwi.width];
+                controlPoints[i + j * 4] = QPointF(position.x - tx, position.y - ty);
             }
-            left = std::min(left, quads[i].left());
-            top = std::min(top, quads[i].top());
-            right = std::max(right, quads[i].right());
-            bottom = std::max(bottom, quads[i].bottom());
         }
+        mesh.applyBezierPatch(w->frameGeometry().size(), controlPoints);
+
+        const QRectF bounds = mesh.bounds();
+        const double left = std::min(0.0, bounds.left());
+        const double top = std::min(0.0, bounds.top());
+        const double right = std::max(w->width(), bounds.right());
+        const double bottom = std::max(w->height(), bounds.bottom());
         QRectF dirtyRect(
             left * data.xScale() + w->x() + data.xTranslation(),
             top * data.yScale() + w->y() + data.yTranslation(),
@@ -520,38 +521,6 @@ void WobblyWindowsEffect::initWobblyInfo(WindowWobblyInfos &wwi, QRectF geometry
     }
 }
 
-WobblyWindowsEffect::Pair WobblyWindowsEffect::computeBezierPoint(const WindowWobblyInfos &wwi, Pair point) const
-{
-    const qreal tx = point.x;
-    const qreal ty = point.y;
-
-    // compute polynomial coeff
-
-    qreal px[4];
-    px[0] = (1 - tx) * (1 - tx) * (1 - tx);
-    px[1] = 3 * (1 - tx) * (1 - tx) * tx;
-    px[2] = 3 * (1 - tx) * tx * tx;
-    px[3] = tx * tx * tx;
-
-    qreal py[4];
-    py[0] = (1 - ty) * (1 - ty) * (1 - ty);
-    py[1] = 3 * (1 - ty) * (1 - ty) * ty;
-    py[2] = 3 * (1 - ty) * ty * ty;
-    py[3] = ty * ty * ty;
-
-    Pair res = {0.0, 0.0};
-
-    for (unsigned int j = 0; j < 4; ++j) {
-        for (unsigned int i = 0; i < 4; ++i) {
-            // this assume the grid is 4*4
-            res.x += px[i] * py[j] * wwi.position[i + j * wwi.width].x;
-            res.y += px[i] * py[j] * wwi.position[i + j * wwi.width].y;
-        }
-    }
-
-    return res;
-}
-
 namespace
 {
 
@@ -89,7 +89,11 @@ public:
     bool isResizeWobble() const;
 
 protected:
-    void apply(EffectWindow *w, int mask, WindowPaintData &data, WindowQuadList &quads) override;
+    void deform(EffectWindow *w, int mask, WindowPaintData &data, WindowMesh &mesh) override;
+    bool hasDeform() const override
+    {
+        return true;
+    }
 
 public Q_SLOTS:
     void slotWindowStartUserMovedResized(KWin::EffectWindow *w);
@@ -158,8 +162,6 @@ private:
 
     void initWobblyInfo(WindowWobblyInfos &wwi, QRectF geometry) const;
 
-    WobblyWindowsEffect::Pair computeBezierPoint(const WindowWobblyInfos &wwi, Pair point) const;
-
     static void heightRingLinearMean(QVector<Pair> &data, WindowWobblyInfos &wwi);
 
     void setParameterSet(const ParameterSet &pset);
@@ -10,18 +10,94 @@
 
 #include "ftrace.h"
 
+#include <QCoreApplication>
 #include <QDBusConnection>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QMutex>
+#include <QSaveFile>
 #include <QScopeGuard>
 #include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
 
 namespace KWin
 {
 KWIN_SINGLETON_FACTORY(KWin::FTraceLogger)
 
+std::atomic<bool> FTraceLogger::s_tracing = false;
+
+// Large enough for a few seconds of a busy compositor, 1MiB per thread.
+static const int s_traceBufferCapacity = 16384;
+// The buffers of threads that have finished are kept until their events have been exported,
+// but at most this many of them.
+static const size_t s_maximumRetiredBuffers = 4;
+
+/**
+ * The ring buffers of all threads that have recorded events. The buffer of a thread that has
+ * finished is retired, it's released once its events have been exported.
+ */
+struct TraceBufferRegistry
+{
+    QMutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::vector<std::unique_ptr<TraceBuffer>> retiredBuffers;
+    quint64 droppedCount = 0;
+    int lastThreadId = 0;
+};
+
+static TraceBufferRegistry &traceBufferRegistry()
+{
+    // Never destroyed, threads can finish after the static objects have been destroyed.
+    static TraceBufferRegistry *registry = new TraceBufferRegistry;
+    return *registry;
+}
+
+/**
+ * Retires the buffer of a thread when it finishes.
+ */
+struct ThreadTraceBuffer
+{
+    ~ThreadTraceBuffer()
+    {
+        if (!buffer) {
+            return;
+        }
+        TraceBufferRegistry &registry = traceBufferRegistry();
+        QMutexLocker lock(&registry.mutex);
+        auto it = std::find_if(registry.buffers.begin(), registry.buffers.end(), [this](const auto &candidate) {
+            return candidate.get() == buffer;
+        });
+        Q_ASSERT(it != registry.buffers.end());
+        registry.retiredBuffers.push_back(std::move(*it));
+        registry.buffers.erase(it);
+        if (registry.retiredBuffers.size() > s_maximumRetiredBuffers) {
+            std::vector<TraceEvent> events;
+            registry.retiredBuffers.front()->take(events);
+            registry.droppedCount += events.size() + registry.retiredBuffers.front()->droppedCount();
+            registry.retiredBuffers.erase(registry.retiredBuffers.begin());
+        }
+    }
+
+    TraceBuffer *buffer = nullptr;
+};
+
+static thread_local ThreadTraceBuffer t_traceBuffer;
+
+static qint64 monotonicTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
 FTraceLogger::FTraceLogger(QObject *parent)
     : QObject(parent)
 {
@@ -34,20 +110,21 @@ FTraceLogger::FTraceLogger(QObject *parent)
 
 bool FTraceLogger::isEnabled() const
 {
-    return m_file.isOpen();
+    return isTracing();
 }
 
 void FTraceLogger::setEnabled(bool enabled)
 {
-    QMutexLocker lock(&m_mutex);
     if (enabled == isEnabled()) {
         return;
     }
 
     if (enabled) {
         open();
-    } else {
-        m_file.close();
+    }
+    s_tracing.store(enabled, std::memory_order_relaxed);
+    if (!enabled) {
+        close();
     }
     Q_EMIT enabledChanged();
 }
@@ -59,9 +136,272 @@ bool FTraceLogger::open()
         return false;
     }
 
-    m_file.setFileName(path);
-    if (!m_file.open(QIODevice::WriteOnly)) {
+    const int fd = ::open(QFile::encodeName(path).constData(), O_WRONLY | O_CLOEXEC);
+    if (fd == -1) {
         qWarning() << "No access to trace marker file at:" << path;
+        return false;
+    }
+    m_markerFile.store(fd);
+    return true;
+}
+
+void FTraceLogger::close()
+{
+    const int fd = m_markerFile.exchange(-1);
+    if (fd == -1) {
+        return;
+    }
+    // A thread that picked up the file descriptor before it got reset may still be writing.
+    while (m_markerWriters.load() != 0) {
+        QThread::yieldCurrentThread();
+    }
+    ::close(fd);
+}
+
+void FTraceLogger::writeMarker(const char *data, qsizetype size)
+{
+    m_markerWriters.fetch_add(1);
+    const int fd = m_markerFile.load();
+    if (fd != -1) {
+        // Writes to the marker file are atomic, no need to lock.
+        [[maybe_unused]] const ssize_t written = ::write(fd, data, size);
+    }
+    m_markerWriters.fetch_sub(1);
+}
+
+TraceBuffer *FTraceLogger::threadBuffer()
+{
+    if (Q_UNLIKELY(!t_traceBuffer.buffer)) {
+        TraceBufferRegistry &registry = traceBufferRegistry();
+        QMutexLocker lock(&registry.mutex);
+
+        const int threadId = ++registry.lastThreadId;
+        QByteArray threadName = QThread::currentThread()->objectName().toUtf8();
+        if (threadName.isEmpty()) {
+            threadName = QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread() ? QByteArrayLiteral("main") : QByteArrayLiteral("thread ") + QByteArray::number(threadId);
+        }
+        registry.buffers.push_back(std::make_unique<TraceBuffer>(s_traceBufferCapacity, threadId, threadName));
+        t_traceBuffer.buffer = registry.buffers.back().get();
+    }
+    return t_traceBuffer.buffer;
+}
+
+quint32 FTraceLogger::nextContext()
+{
+    static std::atomic<quint32> s_context = 0;
+    return ++s_context;
+}
+
+void FTraceLogger::record(TraceEvent::Type type, const char *category, const char *name, qsizetype nameLength, qint64 value)
+{
+    TraceEvent event;
+    event.timestamp = monotonicTime();
+    event.value = value;
+    event.category = category;
+    event.type = type;
+    event.setName(name, nameLength);
+    threadBuffer()->push(event);
+}
+
+void FTraceLogger::record(TraceEvent::Type type, const char *category, const char *name, qint64 value)
+{
+    record(type, category, name, strlen(name), value);
+
+    if (m_markerFile.load(std::memory_order_relaxed) == -1) {
+        return;
+    }
+
+    // Uses the begin_ctx and end_ctx format understood by GPUVis, same as FTraceDuration.
+    char marker[128];
+    int length = 0;
+    switch (type) {
+    case TraceEvent::Type::Begin:
+        length = snprintf(marker, sizeof(marker), "%s begin_ctx=%lld\n", name, static_cast<long long>(value));
+        break;
+    case TraceEvent::Type::End:
+        length = snprintf(marker, sizeof(marker), "%s end_ctx=%lld\n", name, static_cast<long long>(value));
+        break;
+    case TraceEvent::Type::Instant:
+        length = snprintf(marker, sizeof(marker), "%s\n", name);
+        break;
+    case TraceEvent::Type::Counter:
+        length = snprintf(marker, sizeof(marker), "%s value=%lld\n", name, static_cast<long long>(value));
+        break;
+    case TraceEvent::Type::FlowBegin:
+        length = snprintf(marker, sizeof(marker), "%s flow_begin=%lld\n", name, static_cast<long long>(value));
+        break;
+    case TraceEvent::Type::FlowEnd:
+        length = snprintf(marker, sizeof(marker), "%s flow_end=%lld\n", name, static_cast<long long>(value));
+        break;
+    }
+    if (length > 0) {
+        writeMarker(marker, std::min<int>(length, sizeof(marker) - 1));
+    }
+}
+
+void FTraceLogger::writeMarker(const QByteArray &message)
+{
+    if (m_markerFile.load(std::memory_order_relaxed) == -1) {
+        return;
+    }
+    const QByteArray line = message + '\n';
+    writeMarker(line.constData(), line.size());
+}
+
+static void appendJsonString(QByteArray &json, const char *text)
+{
+    json += '"';
+    for (const char *c = text; *c; ++c) {
+        switch (*c) {
+        case '"':
+            json += "\\\"";
+            break;
+        case '\\':
+            json += "\\\\";
+            break;
+        default:
+            if (static_cast<unsigned char>(*c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                json += escaped;
+            } else {
+                json += *c;
+            }
+            break;
+        }
+    }
+    json += '"';
+}
+
+static const char *chromePhase(TraceEvent::Type type)
+{
+    switch (type) {
+    case TraceEvent::Type::Begin:
+        return "B";
+    case TraceEvent::Type::End:
+        return "E";
+    case TraceEvent::Type::Instant:
+        return "i";
+    case TraceEvent::Type::Counter:
+        return "C";
+    case TraceEvent::Type::FlowBegin:
+        return "s";
+    case TraceEvent::Type::FlowEnd:
+        return "f";
+    }
+    Q_UNREACHABLE();
+}
+
+QByteArray FTraceLogger::takeChromeTrace()
+{
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+
+    QByteArray json;
+    json += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    auto separate = [&json, &first]() {
+        if (!first) {
+            json += ",\n";
+        }
+        first = false;
+    };
+
+    TraceBufferRegistry &registry = traceBufferRegistry();
+    QMutexLocker lock(&registry.mutex);
+
+    std::vector<TraceBuffer *> buffers;
+    for (const auto &buffer : registry.buffers) {
+        buffers.push_back(buffer.get());
+    }
+    for (const auto &buffer : registry.retiredBuffers) {
+        buffers.push_back(buffer.get());
+    }
+
+    std::vector<TraceEvent> events;
+    for (TraceBuffer *buffer : buffers) {
+        const QByteArray tid = QByteArray::number(buffer->threadId());
+
+        separate();
+        json += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"args\":{\"name\":";
+        appendJsonString(json, buffer->threadName().constData());
+        json += "}}";
+
+        events.clear();
+        buffer->take(events);
+        for (const TraceEvent &event : events) {
+            char timestamp[32];
+            snprintf(timestamp, sizeof(timestamp), "%lld.%03lld", static_cast<long long>(event.timestamp / 1000), static_cast<long long>(event.timestamp % 1000));
+
+            separate();
+            json += "{\"ph\":\"";
+            json += chromePhase(event.type);
+            json += "\",\"name\":";
+            appendJsonString(json, event.name);
+            json += ",\"cat\":";
+            appendJsonString(json, event.category);
+            json += ",\"ts\":";
+            json += timestamp;
+            json += ",\"pid\":" + pid + ",\"tid\":" + tid;
+
+            switch (event.type) {
+            case TraceEvent::Type::Begin:
+            case TraceEvent::Type::End:
+                break;
+            case TraceEvent::Type::Instant:
+                json += ",\"s\":\"t\"";
+                break;
+            case TraceEvent::Type::Counter:
+                json += ",\"args\":{\"value\":" + QByteArray::number(event.value) + "}";
+                break;
+            case TraceEvent::Type::FlowBegin:
+                json += ",\"id\":" + QByteArray::number(event.value);
+                break;
+            case TraceEvent::Type::FlowEnd:
+                json += ",\"id\":" + QByteArray::number(event.value) + ",\"bp\":\"e\"";
+                break;
+            }
+            json += '}';
+        }
+    }
+
+    for (const auto &buffer : registry.retiredBuffers) {
+        registry.droppedCount += buffer->droppedCount();
+    }
+    registry.retiredBuffers.clear();
+
+    json += "]}\n";
+    return json;
+}
+
+quint64 FTraceLogger::droppedEventCount() const
+{
+    TraceBufferRegistry &registry = traceBufferRegistry();
+    QMutexLocker lock(&registry.mutex);
+
+    quint64 count = registry.droppedCount;
+    for (const auto &buffer : registry.buffers) {
+        count += buffer->droppedCount();
+    }
+    for (const auto &buffer : registry.retiredBuffers) {
+        count += buffer->droppedCount();
+    }
+    return count;
+}
+
+bool FTraceLogger::exportTrace(const QString &fileName)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open" << fileName << "for writing:" << file.errorString();
+        return false;
+    }
+    file.write(takeChromeTrace());
+    if (!file.commit()) {
+        qWarning() << "Failed to write the trace to" << fileName << ":" << file.errorString();
+        return false;
+    }
+    if (const quint64 dropped = droppedEventCount()) {
+        qWarning() << dropped << "trace events have been dropped";
     }
     return true;
 }
@@ -115,7 +455,8 @@ QString FTraceLogger::filePath()
 
 FTraceDuration::~FTraceDuration()
 {
-    FTraceLogger::self()->trace(m_message, " end_ctx=", m_context);
+    FTraceLogger::self()->record(TraceEvent::Type::End, "kwin", m_message.constData(), m_message.size(), m_context);
+    FTraceLogger::self()->writeMarker(m_message + " end_ctx=" + QByteArray::number(m_context));
 }
 
 }
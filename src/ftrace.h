@@ -11,21 +11,27 @@
 
 #include <kwinglobals.h>
 
-#include <QFile>
-#include <QMutex>
-#include <QMutexLocker>
+#include "utils/tracebuffer.h"
+
 #include <QObject>
-#include <QTextStream>
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
 
 namespace KWin
 {
 /**
- * FTraceLogger is a singleton utility for writing log messages using ftrace
+ * FTraceLogger is a singleton utility for tracing the compositor
  *
  * Usage: Either:
  *  Set the KWIN_PERF_FTRACE environment variable before starting the application
  *  Calling on DBus /FTrace org.kde.kwin.FTrace.setEnabled true
- * After having created the ftrace mount
+ *
+ * While enabled, trace events are recorded in a binary ring buffer per thread, which keeps the
+ * most recent events like a flight recorder. They can be
+ * written as a Chrome/Perfetto JSON trace with org.kde.kwin.FTrace.exportTrace. If the ftrace
+ * mount has been created, every event is also written as an ftrace marker.
  */
 class KWIN_EXPORT FTraceLogger : public QObject
 {
@@ -39,33 +45,122 @@ public:
      */
     bool isEnabled() const;
 
+    /**
+     * Same as isEnabled(), but cheap enough to be checked in hot paths without a logger
+     * instance.
+     */
+    static bool isTracing()
+    {
+        return s_tracing.load(std::memory_order_relaxed);
+    }
+
     /**
      * Main log function
-     * Takes any number of arguments that can be written into QTextStream
+     * Takes any number of strings and numbers, which are concatenated
      */
     template<typename... Args>
     void trace(Args... args)
     {
         Q_ASSERT(isEnabled());
-        QMutexLocker lock(&m_mutex);
-        if (!m_file.isOpen()) {
-            return;
-        }
-        QTextStream stream(&m_file);
-        (stream << ... << args) << Qt::endl;
+        const QByteArray message = format(args...);
+        record(TraceEvent::Type::Instant, "kwin", message.constData(), message.size(), 0);
+        writeMarker(message);
     }
 
+    /**
+     * Concatenates the given strings and numbers into a message.
+     */
+    template<typename... Args>
+    static QByteArray format(Args... args)
+    {
+        QByteArray message;
+        (appendArgument(message, args), ...);
+        return message;
+    }
+
+    /**
+     * Records a binary trace event with the given @p name, the @p category must be a string
+     * literal. Also writes an ftrace marker if the marker file is available.
+     */
+    void record(TraceEvent::Type type, const char *category, const char *name, qint64 value = 0);
+
+    /**
+     * Records a binary trace event without writing an ftrace marker.
+     */
+    void record(TraceEvent::Type type, const char *category, const char *name, qsizetype nameLength, qint64 value);
+
+    /**
+     * Writes the @p message as an ftrace marker.
+     */
+    void writeMarker(const QByteArray &message);
+
+    /**
+     * Returns a context id to tie begin and end events together.
+     */
+    static quint32 nextContext();
+
+    /**
+     * Moves the events recorded so far out of the ring buffers and returns them in the
+     * Chrome/Perfetto JSON trace format.
+     */
+    QByteArray takeChromeTrace();
+
+    /**
+     * Returns the number of events that have been overwritten in a full ring buffer before
+     * they were exported.
+     */
+    quint64 droppedEventCount() const;
+
 Q_SIGNALS:
     void enabledChanged();
 
 public Q_SLOTS:
     Q_SCRIPTABLE void setEnabled(bool enabled);
+    /**
+     * Writes the events recorded since the last export to @p fileName in the Chrome/Perfetto
+     * JSON trace format, which can be opened in ui.perfetto.dev or chrome://tracing.
+     */
+    Q_SCRIPTABLE bool exportTrace(const QString &fileName);
 
 private:
+    static void appendArgument(QByteArray &message, const char *text)
+    {
+        message += text;
+    }
+    static void appendArgument(QByteArray &message, const QByteArray &text)
+    {
+        message += text;
+    }
+    static void appendArgument(QByteArray &message, const QString &text)
+    {
+        message += text.toUtf8();
+    }
+    template<typename T>
+    static void appendArgument(QByteArray &message, T value)
+    {
+        static_assert(std::is_arithmetic_v<T>, "Only strings and numbers can be traced");
+        if constexpr (std::is_same_v<T, char>) {
+            message += value;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            message += QByteArray::number(double(value));
+        } else if constexpr (std::is_signed_v<T>) {
+            message += QByteArray::number(qlonglong(value));
+        } else {
+            message += QByteArray::number(qulonglong(value));
+        }
+    }
+
     static QString filePath();
     bool open();
-    QFile m_file;
-    QMutex m_mutex;
+    void close();
+    void writeMarker(const char *data, qsizetype size);
+    TraceBuffer *threadBuffer();
+
+    std::atomic<int> m_markerFile = -1;
+    // The number of threads that are writing a marker, the marker file is not closed until
+    // they are done.
+    std::atomic<int> m_markerWriters = 0;
+    static std::atomic<bool> s_tracing;
     KWIN_SINGLETON(FTraceLogger)
 };
 
@@ -74,13 +169,11 @@ class KWIN_EXPORT FTraceDuration
 public:
     template<typename... Args>
     FTraceDuration(Args... args)
+        : m_message(FTraceLogger::format(args...))
     {
-        static QAtomicInteger<quint32> s_context = 0;
-        QTextStream stream(&m_message);
-        (stream << ... << args);
-        stream.flush();
-        m_context = ++s_context;
-        FTraceLogger::self()->trace(m_message, " begin_ctx=", m_context);
+        m_context = FTraceLogger::nextContext();
+        FTraceLogger::self()->record(TraceEvent::Type::Begin, "kwin", m_message.constData(), m_message.size(), m_context);
+        FTraceLogger::self()->writeMarker(m_message + " begin_ctx=" + QByteArray::number(m_context));
     }
 
     ~FTraceDuration();
@@ -90,13 +183,48 @@ private:
     quint32 m_context;
 };
 
+/**
+ * Records a begin event when created and an end event when destroyed. Unlike FTraceDuration,
+ * no text is formatted, so it can be used in hot paths.
+ */
+class FTraceScope
+{
+public:
+    FTraceScope(const char *category, const char *name)
+    {
+        if (FTraceLogger::isTracing()) {
+            m_category = category;
+            m_name = name;
+            m_context = FTraceLogger::nextContext();
+            FTraceLogger::self()->record(TraceEvent::Type::Begin, m_category, m_name, m_context);
+        }
+    }
+
+    ~FTraceScope()
+    {
+        // The end event is recorded even if tracing has been disabled in the meantime, so
+        // the begin event isn't left unbalanced.
+        if (m_name) {
+            FTraceLogger::self()->record(TraceEvent::Type::End, m_category, m_name, m_context);
+        }
+    }
+
+    FTraceScope(const FTraceScope &) = delete;
+    FTraceScope &operator=(const FTraceScope &) = delete;
+
+private:
+    const char *m_category = nullptr;
+    const char *m_name = nullptr;
+    quint32 m_context = 0;
+};
+
 } // namespace KWin
 
 /**
  * Optimised macro, arguments are only copied if tracing is enabled
  */
-#define fTrace(...)                              \
-    if (KWin::FTraceLogger::self()->isEnabled()) \
+#define fTrace(...)                     \
+    if (KWin::FTraceLogger::isTracing()) \
         KWin::FTraceLogger::self()->trace(__VA_ARGS__);
 
 /**
@@ -104,4 +232,41 @@ private:
  * In GPUVis this will appear as a timed block with begin_ctx and end_ctx markers
  */
 #define fTraceDuration(...) \
-    std::unique_ptr<KWin::FTraceDuration> _duration(KWin::FTraceLogger::self()->isEnabled() ? new KWin::FTraceDuration(__VA_ARGS__) : nullptr);
+    std::unique_ptr<KWin::FTraceDuration> _duration(KWin::FTraceLogger::isTracing() ? new KWin::FTraceDuration(__VA_ARGS__) : nullptr);
+
+#define KWIN_FTRACE_CONCAT_IMPL(a, b) a##b
+#define KWIN_FTRACE_CONCAT(a, b) KWIN_FTRACE_CONCAT_IMPL(a, b)
+
+/**
+ * Traces the rest of the enclosing block. The @p category and the @p name must be string
+ * literals.
+ */
+#define fTraceScope(category, name) \
+    KWin::FTraceScope KWIN_FTRACE_CONCAT(_traceScope, __LINE__)(category, name)
+
+/**
+ * Records the @p value of a counter.
+ */
+#define fTraceCounter(category, name, value) \
+    if (KWin::FTraceLogger::isTracing())       \
+        KWin::FTraceLogger::self()->record(KWin::TraceEvent::Type::Counter, category, name, value);
+
+/**
+ * Records a point in time.
+ */
+#define fTraceInstant(category, name)   \
+    if (KWin::FTraceLogger::isTracing()) \
+        KWin::FTraceLogger::self()->record(KWin::TraceEvent::Type::Instant, category, name);
+
+/**
+ * Records the start of a flow, which ties events on different threads or in different frames
+ * together, e.g. a commit and the page flip that presents it. The flow is ended by the
+ * fTraceFlowEnd with the same @p id.
+ */
+#define fTraceFlowBegin(category, name, id) \
+    if (KWin::FTraceLogger::isTracing())      \
+        KWin::FTraceLogger::self()->record(KWin::TraceEvent::Type::FlowBegin, category, name, id);
+
+#define fTraceFlowEnd(category, name, id) \
+    if (KWin::FTraceLogger::isTracing())    \
+        KWin::FTraceLogger::self()->record(KWin::TraceEvent::Type::FlowEnd, category, name, id);
@@ -16,6 +16,7 @@
 #include "core/inputbackend.h"
 #include "core/session.h"
 #include "effects.h"
+#include "ftrace.h"
 #include "gestures.h"
 #include "globalshortcuts.h"
 #include "hide_cursor_spy.h"
@@ -2589,6 +2590,22 @@ private:
     QTimer m_raiseTimer;
 };
 
+InputDispatchTrace::InputDispatchTrace(const char *name)
+{
+    if (FTraceLogger::isTracing()) {
+        m_name = name;
+        m_context = FTraceLogger::nextContext();
+        FTraceLogger::self()->record(TraceEvent::Type::Begin, "input", m_name, m_context);
+    }
+}
+
+InputDispatchTrace::~InputDispatchTrace()
+{
+    if (m_name) {
+        FTraceLogger::self()->record(TraceEvent::Type::End, "input", m_name, m_context);
+    }
+}
+
 KWIN_SINGLETON_FACTORY(InputRedirection)
 
 static const QString s_touchpadComponent = QStringLiteral("kcm_touchpad");
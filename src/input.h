@@ -57,6 +57,21 @@ class DecoratedClientImpl;
 class InputBackend;
 class InputDevice;
 
+/**
+ * Traces the dispatch of an input event to the filters or the spies. It's implemented in
+ * input.cpp, so this header doesn't have to pull in the trace logger.
+ */
+class KWIN_EXPORT InputDispatchTrace
+{
+public:
+    explicit InputDispatchTrace(const char *name);
+    ~InputDispatchTrace();
+
+private:
+    const char *m_name = nullptr;
+    quint32 m_context = 0;
+};
+
 /**
  * @brief This class is responsible for redirecting incoming input to the surface which currently
  * has input or send enter/leave events.
@@ -190,6 +205,7 @@ public:
     template<class UnaryPredicate>
     void processFilters(UnaryPredicate function)
     {
+        InputDispatchTrace trace("processFilters");
         std::any_of(m_filters.constBegin(), m_filters.constEnd(), function);
     }
 
@@ -209,6 +225,7 @@ public:
     template<class UnaryFunction>
     void processSpies(UnaryFunction function)
     {
+        InputDispatchTrace trace("processSpies");
         std::for_each(m_spies.constBegin(), m_spies.constEnd(), function);
     }
 
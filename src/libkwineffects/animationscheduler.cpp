@@ -0,0 +1,130 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "animationscheduler_p.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+AnimationScheduler *AnimationScheduler::self()
+{
+    static AnimationScheduler scheduler;
+    return &scheduler;
+}
+
+AnimationScheduler::AnimationScheduler()
+{
+    m_clock.start();
+}
+
+void AnimationScheduler::registerEffect(AnimationEffect *effect, std::vector<AnimatedWindow> *windows)
+{
+    m_effects.push_back(Registration{
+        .effect = effect,
+        .windows = windows,
+    });
+}
+
+void AnimationScheduler::unregisterEffect(AnimationEffect *effect)
+{
+    auto it = std::find_if(m_effects.begin(), m_effects.end(), [effect](const Registration &registration) {
+        return registration.effect == effect;
+    });
+    if (it != m_effects.end()) {
+        m_effects.erase(it);
+    }
+}
+
+qint64 AnimationScheduler::clock() const
+{
+    if (m_frameClock >= 0) {
+        return m_frameClock;
+    }
+    return m_clock.elapsed();
+}
+
+std::chrono::milliseconds AnimationScheduler::presentTime() const
+{
+    return m_framePresentTime;
+}
+
+void AnimationScheduler::beginFrame(AnimationEffect *effect, std::chrono::milliseconds presentTime)
+{
+    // A different presentation timestamp means that a new frame has started, even if an effect
+    // of the previous frame has not been unwound, e.g. because it got unloaded while painting.
+    if (m_frameDepth == 0 || m_framePresentTime != presentTime) {
+        m_frameClock = m_clock.elapsed();
+        m_framePresentTime = presentTime;
+        m_frameDepth = 0;
+        ++m_frames;
+    }
+    ++m_frameDepth;
+
+    auto it = std::find_if(m_effects.begin(), m_effects.end(), [effect](const Registration &registration) {
+        return registration.effect == effect;
+    });
+    if (it != m_effects.end() && it->frame != m_frames) {
+        advance(*it);
+    }
+}
+
+void AnimationScheduler::advance(Registration &registration)
+{
+    registration.frame = m_frames;
+    if (registration.windows->empty()) {
+        return;
+    }
+    ++m_advancedEffects;
+    for (AnimatedWindow &window : *registration.windows) {
+        for (AniData &anim : window.animations) {
+            if (anim.startTime <= m_frameClock && anim.frozenTime < 0) {
+                anim.timeLine.advance(m_framePresentTime);
+            }
+        }
+    }
+}
+
+void AnimationScheduler::endFrame()
+{
+    if (m_frameDepth > 0 && --m_frameDepth == 0) {
+        m_frameClock = -1;
+    }
+}
+
+AnimationScheduler::Statistics AnimationScheduler::statistics() const
+{
+    Statistics statistics;
+    statistics.effects = m_effects.size();
+    statistics.frames = m_frames;
+    statistics.advancedEffects = m_advancedEffects;
+    for (const Registration &registration : m_effects) {
+        if (registration.windows->empty()) {
+            continue;
+        }
+        ++statistics.animatingEffects;
+        statistics.windows += registration.windows->size();
+        for (const AnimatedWindow &window : *registration.windows) {
+            statistics.animations += window.animations.count();
+        }
+    }
+    return statistics;
+}
+
+void AnimationScheduler::resetStatistics()
+{
+    m_frames = 0;
+    m_advancedEffects = 0;
+    for (Registration &registration : m_effects) {
+        registration.frame = 0;
+    }
+}
+
+} // namespace KWin
@@ -0,0 +1,137 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "anidata_p.h"
+
+#include <QElapsedTimer>
+
+#include <chrono>
+#include <vector>
+
+namespace KWin
+{
+
+/**
+ * The animations of a single window in an AnimationEffect.
+ */
+struct AnimatedWindow
+{
+    EffectWindow *window = nullptr;
+    QList<AniData> animations;
+    /**
+     * The area that can be touched by the animations, in global coordinates. A null rect
+     * means that it has to be recomputed.
+     */
+    QRect damage;
+    /**
+     * The area painted in the last frame, or a null rect if the animations can't be bounded.
+     */
+    QRect paintedRect;
+};
+
+/**
+ * The AnimationScheduler is shared by all AnimationEffect instances in the process.
+ *
+ * It owns the animation clock. While a frame is being painted, the clock is sampled only
+ * once, so every effect decides whether delayed animations have started using the same
+ * point in time. Outside of painting, the clock is live.
+ *
+ * Every AnimationEffect registers the flat array with its animated windows. The timelines
+ * of an effect are advanced once per frame, when the effect is painted in that frame. The
+ * animations of effects that are not painted, e.g. because they are not part of the effect
+ * chain of the output, are left alone.
+ */
+class KWINEFFECTS_EXPORT AnimationScheduler
+{
+public:
+    struct Statistics
+    {
+        /**
+         * The number of registered effects.
+         */
+        int effects = 0;
+        /**
+         * The number of registered effects with at least one animation.
+         */
+        int animatingEffects = 0;
+        /**
+         * The number of animated windows, summed up over all effects.
+         */
+        int windows = 0;
+        /**
+         * The number of animations, summed up over all effects.
+         */
+        int animations = 0;
+        /**
+         * The number of frames in which animation effects were painted.
+         */
+        quint64 frames = 0;
+        /**
+         * The number of times the animations of an effect were advanced.
+         */
+        quint64 advancedEffects = 0;
+    };
+
+    static AnimationScheduler *self();
+
+    void registerEffect(AnimationEffect *effect, std::vector<AnimatedWindow> *windows);
+    void unregisterEffect(AnimationEffect *effect);
+
+    /**
+     * Returns the time of the animation clock in milliseconds.
+     */
+    qint64 clock() const;
+
+    /**
+     * Returns the presentation timestamp of the last frame.
+     */
+    std::chrono::milliseconds presentTime() const;
+
+    /**
+     * Called by every animation effect in prePaintScreen(). The first call in a frame samples
+     * the clock. The animations of @a effect are advanced if that has not happened in this
+     * frame yet.
+     */
+    void beginFrame(AnimationEffect *effect, std::chrono::milliseconds presentTime);
+    /**
+     * Called by every animation effect in postPaintScreen(). The clock is live again after
+     * the last call in a frame.
+     */
+    void endFrame();
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+private:
+    AnimationScheduler();
+
+    struct Registration
+    {
+        AnimationEffect *effect;
+        std::vector<AnimatedWindow> *windows;
+        /**
+         * The frame in which the animations were advanced last.
+         */
+        quint64 frame = 0;
+    };
+
+    void advance(Registration &registration);
+
+    std::vector<Registration> m_effects;
+    QElapsedTimer m_clock;
+    qint64 m_frameClock = -1;
+    std::chrono::milliseconds m_framePresentTime = std::chrono::milliseconds::zero();
+    int m_frameDepth = 0;
+    quint64 m_frames = 0;
+    quint64 m_advancedEffects = 0;
+};
+
+} // namespace KWin
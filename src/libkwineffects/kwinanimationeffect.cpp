@@ -11,12 +11,16 @@
 #include "kwinanimationeffect.h"
 #include "kwinglutils.h"
 #include "anidata_p.h"
+#include "animationscheduler_p.h"
 
 #include <QDateTime>
+#include <QLineF>
 #include <QTimer>
 #include <QVector3D>
 #include <QtDebug>
 
+#include <optional>
+
 namespace KWin
 {
 
@@ -26,8 +30,6 @@ QDebug operator<<(QDebug dbg, const KWin::FPx2 &fpx2)
     return dbg.space();
 }
 
-QElapsedTimer AnimationEffect::s_clock;
-
 class AnimationEffectPrivate
 {
 public:
@@ -36,28 +38,56 @@ public:
         m_animationsTouched = m_isInitialized = false;
         m_justEndedAnimation = 0;
     }
-    AnimationEffect::AniMap m_animations;
+    AnimatedWindow *find(EffectWindow *w);
+    const AnimatedWindow *find(EffectWindow *w) const;
+
+    std::vector<AnimatedWindow> m_animations;
     static quint64 m_animCounter;
     quint64 m_justEndedAnimation; // protect against cancel
     QWeakPointer<FullScreenEffectLock> m_fullScreenEffectLock;
     bool m_needSceneRepaint, m_animationsTouched, m_isInitialized;
+    bool m_active = false;
 };
 
 quint64 AnimationEffectPrivate::m_animCounter = 0;
 
+AnimatedWindow *AnimationEffectPrivate::find(EffectWindow *w)
+{
+    auto it = std::find_if(m_animations.begin(), m_animations.end(), [w](const AnimatedWindow &entry) {
+        return entry.window == w;
+    });
+    return it != m_animations.end() ? &(*it) : nullptr;
+}
+
+const AnimatedWindow *AnimationEffectPrivate::find(EffectWindow *w) const
+{
+    return const_cast<AnimationEffectPrivate *>(this)->find(w);
+}
+
 AnimationEffect::AnimationEffect()
     : CrossFadeEffect()
     , d_ptr(std::make_unique<AnimationEffectPrivate>())
 {
-    if (!s_clock.isValid()) {
-        s_clock.start();
-    }
+    AnimationScheduler::self()->registerEffect(this, &d_ptr->m_animations);
+    connect(effects, &EffectsHandler::screenLockingChanged, this, &AnimationEffect::updateActive);
     /* this is the same as the QTimer::singleShot(0, SLOT(init())) kludge
      * defering the init and esp. the connection to the windowClosed slot */
     QMetaObject::invokeMethod(this, &AnimationEffect::init, Qt::QueuedConnection);
 }
 
-AnimationEffect::~AnimationEffect() = default;
+AnimationEffect::~AnimationEffect()
+{
+    Q_D(AnimationEffect);
+    for (const AnimatedWindow &entry : d->m_animations) {
+        entry.window->setEffectInterest(this, false);
+    }
+    AnimationScheduler::self()->unregisterEffect(this);
+}
+
+qint64 AnimationEffect::clock()
+{
+    return AnimationScheduler::self()->clock();
+}
 
 void AnimationEffect::init()
 {
@@ -77,7 +107,22 @@ void AnimationEffect::init()
 bool AnimationEffect::isActive() const
 {
     Q_D(const AnimationEffect);
-    return !d->m_animations.isEmpty() && !effects->isScreenLocked();
+    return !d->m_animations.empty() && !effects->isScreenLocked();
+}
+
+Effect::PaintHooks AnimationEffect::paintHooks() const
+{
+    return AllPaintHooks | NotifiesActiveChanged;
+}
+
+void AnimationEffect::updateActive()
+{
+    Q_D(AnimationEffect);
+    const bool active = isActive();
+    if (d->m_active != active) {
+        d->m_active = active;
+        Q_EMIT activeChanged();
+    }
 }
 
 #define RELATIVE_XY(_FIELD_) const bool relative[2] = {static_cast<bool>(metaData(Relative##_FIELD_##X, meta)), \
@@ -213,13 +258,16 @@ quint64 AnimationEffect::p_animate(EffectWindow *w, Attribute a, uint meta, int
     if (!d->m_isInitialized) {
         init(); // needs to ensure the window gets removed if deleted in the same event cycle
     }
-    if (d->m_animations.isEmpty()) {
+    if (d->m_animations.empty()) {
         connect(effects, &EffectsHandler::windowExpandedGeometryChanged,
                 this, &AnimationEffect::_windowExpandedGeometryChanged);
     }
-    AniMap::iterator it = d->m_animations.find(w);
-    if (it == d->m_animations.end()) {
-        it = d->m_animations.insert(w, QPair<QList<AniData>, QRect>(QList<AniData>(), QRect()));
+    AnimatedWindow *entry = d->find(w);
+    if (!entry) {
+        entry = &d->m_animations.emplace_back();
+        entry->window = w;
+        w->setEffectInterest(this, true);
+        updateActive();
     }
 
     FullScreenEffectLockPtr fullscreen;
@@ -237,7 +285,7 @@ quint64 AnimationEffect::p_animate(EffectWindow *w, Attribute a, uint meta, int
         CrossFadeEffect::redirect(w);
     }
 
-    it->first.append(AniData(
+    entry->animations.append(AniData(
         a, // Attribute
         meta, // Metadata
         to, // Target
@@ -251,7 +299,7 @@ quint64 AnimationEffect::p_animate(EffectWindow *w, Attribute a, uint meta, int
         ));
 
     const quint64 ret_id = ++d->m_animCounter;
-    AniData &animation = it->first.last();
+    AniData &animation = entry->animations.last();
     animation.id = ret_id;
 
     animation.visibleRef = EffectWindowVisibleRef(w, EffectWindow::PAINT_DISABLED_BY_MINIMIZE | EffectWindow::PAINT_DISABLED_BY_DESKTOP | EffectWindow::PAINT_DISABLED_BY_DELETE);
@@ -266,7 +314,7 @@ quint64 AnimationEffect::p_animate(EffectWindow *w, Attribute a, uint meta, int
         animation.terminationFlags |= TerminateAtTarget;
     }
 
-    it->second = QRect();
+    entry->damage = QRect();
 
     d->m_animationsTouched = true;
 
@@ -291,23 +339,19 @@ bool AnimationEffect::retarget(quint64 animationId, FPx2 newTarget, int newRemai
     if (animationId == d->m_justEndedAnimation) {
         return false; // this is just ending, do not try to retarget it
     }
-    for (AniMap::iterator entry = d->m_animations.begin(),
-                          mapEnd = d->m_animations.end();
-         entry != mapEnd; ++entry) {
-        for (QList<AniData>::iterator anim = entry->first.begin(),
-                                      animEnd = entry->first.end();
-             anim != animEnd; ++anim) {
-            if (anim->id == animationId) {
-                anim->from.set(interpolated(*anim, 0), interpolated(*anim, 1));
-                validate(anim->attribute, anim->meta, nullptr, &newTarget, entry.key());
-                anim->to.set(newTarget[0], newTarget[1]);
-
-                anim->timeLine.setDirection(TimeLine::Forward);
-                anim->timeLine.setDuration(std::chrono::milliseconds(newRemainingTime));
-                anim->timeLine.reset();
-
-                if (anim->attribute == CrossFadePrevious) {
-                    CrossFadeEffect::redirect(entry.key());
+    for (AnimatedWindow &entry : d->m_animations) {
+        for (AniData &anim : entry.animations) {
+            if (anim.id == animationId) {
+                anim.from.set(interpolated(anim, 0), interpolated(anim, 1));
+                validate(anim.attribute, anim.meta, nullptr, &newTarget, entry.window);
+                anim.to.set(newTarget[0], newTarget[1]);
+
+                anim.timeLine.setDirection(TimeLine::Forward);
+                anim.timeLine.setDuration(std::chrono::milliseconds(newRemainingTime));
+                anim.timeLine.reset();
+
+                if (anim.attribute == CrossFadePrevious) {
+                    CrossFadeEffect::redirect(entry.window);
                 }
                 return true;
             }
@@ -323,17 +367,13 @@ bool AnimationEffect::freezeInTime(quint64 animationId, qint64 frozenTime)
     if (animationId == d->m_justEndedAnimation) {
         return false; // this is just ending, do not try to retarget it
     }
-    for (AniMap::iterator entry = d->m_animations.begin(),
-                          mapEnd = d->m_animations.end();
-         entry != mapEnd; ++entry) {
-        for (QList<AniData>::iterator anim = entry->first.begin(),
-                                      animEnd = entry->first.end();
-             anim != animEnd; ++anim) {
-            if (anim->id == animationId) {
+    for (AnimatedWindow &entry : d->m_animations) {
+        for (AniData &anim : entry.animations) {
+            if (anim.id == animationId) {
                 if (frozenTime >= 0) {
-                    anim->timeLine.setElapsed(std::chrono::milliseconds(frozenTime));
+                    anim.timeLine.setElapsed(std::chrono::milliseconds(frozenTime));
                 }
-                anim->frozenTime = frozenTime;
+                anim.frozenTime = frozenTime;
                 return true;
             }
         }
@@ -348,12 +388,12 @@ bool AnimationEffect::redirect(quint64 animationId, Direction direction, Termina
         return false;
     }
 
-    for (auto entryIt = d->m_animations.begin(); entryIt != d->m_animations.end(); ++entryIt) {
-        auto animIt = std::find_if(entryIt->first.begin(), entryIt->first.end(),
+    for (AnimatedWindow &entry : d->m_animations) {
+        auto animIt = std::find_if(entry.animations.begin(), entry.animations.end(),
                                    [animationId](AniData &anim) {
                                        return anim.id == animationId;
                                    });
-        if (animIt == entryIt->first.end()) {
+        if (animIt == entry.animations.end()) {
             continue;
         }
 
@@ -383,17 +423,17 @@ bool AnimationEffect::complete(quint64 animationId)
         return false;
     }
 
-    for (auto entryIt = d->m_animations.begin(); entryIt != d->m_animations.end(); ++entryIt) {
-        auto animIt = std::find_if(entryIt->first.begin(), entryIt->first.end(),
+    for (AnimatedWindow &entry : d->m_animations) {
+        auto animIt = std::find_if(entry.animations.begin(), entry.animations.end(),
                                    [animationId](AniData &anim) {
                                        return anim.id == animationId;
                                    });
-        if (animIt == entryIt->first.end()) {
+        if (animIt == entry.animations.end()) {
             continue;
         }
 
         animIt->timeLine.setElapsed(animIt->timeLine.duration());
-        unredirect(entryIt.key());
+        unredirect(entry.window);
 
         return true;
     }
@@ -407,18 +447,20 @@ bool AnimationEffect::cancel(quint64 animationId)
     if (animationId == d->m_justEndedAnimation) {
         return true; // this is just ending, do not try to cancel it but fake success
     }
-    for (AniMap::iterator entry = d->m_animations.begin(), mapEnd = d->m_animations.end(); entry != mapEnd; ++entry) {
-        for (QList<AniData>::iterator anim = entry->first.begin(), animEnd = entry->first.end(); anim != animEnd; ++anim) {
+    for (auto entry = d->m_animations.begin(); entry != d->m_animations.end(); ++entry) {
+        for (auto anim = entry->animations.begin(); anim != entry->animations.end(); ++anim) {
             if (anim->id == animationId) {
-                if (anim->shader && std::none_of(entry->first.begin(), entry->first.end(), [animationId] (const auto &anim) { return anim.id != animationId && anim.shader; })) {
-                    unredirect(entry.key());
+                if (anim->shader && std::none_of(entry->animations.cbegin(), entry->animations.cend(), [animationId] (const auto &anim) { return anim.id != animationId && anim.shader; })) {
+                    unredirect(entry->window);
                 }
-                entry->first.erase(anim); // remove the animation
-                if (entry->first.isEmpty()) { // no other animations on the window, release it.
+                entry->animations.erase(anim); // remove the animation
+                if (entry->animations.isEmpty()) { // no other animations on the window, release it.
+                    entry->window->setEffectInterest(this, false);
                     d->m_animations.erase(entry);
                 }
-                if (d->m_animations.isEmpty()) {
+                if (d->m_animations.empty()) {
                     disconnectGeometryChanges();
+                    updateActive();
                 }
                 d->m_animationsTouched = true; // could be called from animationEnded
                 return true;
@@ -438,21 +480,8 @@ void AnimationEffect::genericAnimation(EffectWindow *w, WindowPaintData &data, f
 
 void AnimationEffect::prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseconds presentTime)
 {
-    Q_D(AnimationEffect);
-    if (d->m_animations.isEmpty()) {
-        effects->prePaintScreen(data, presentTime);
-        return;
-    }
-
-    for (auto entry = d->m_animations.begin(); entry != d->m_animations.end(); ++entry) {
-        for (auto anim = entry->first.begin(); anim != entry->first.end(); ++anim) {
-            if (anim->startTime <= clock()) {
-                if (anim->frozenTime < 0) {
-                    anim->timeLine.advance(presentTime);
-                }
-            }
-        }
-    }
+    // Only the animations of effects that are painted in this frame are advanced.
+    AnimationScheduler::self()->beginFrame(this, presentTime);
 
     effects->prePaintScreen(data, presentTime);
 }
@@ -509,10 +538,10 @@ void AnimationEffect::disconnectGeometryChanges()
 void AnimationEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &data, std::chrono::milliseconds presentTime)
 {
     Q_D(AnimationEffect);
-    AniMap::const_iterator entry = d->m_animations.constFind(w);
-    if (entry != d->m_animations.constEnd()) {
-        for (QList<AniData>::const_iterator anim = entry->first.constBegin(); anim != entry->first.constEnd(); ++anim) {
-            if (anim->startTime > clock() && !anim->waitAtSource) {
+    if (const AnimatedWindow *entry = d->find(w)) {
+        const qint64 now = clock();
+        for (QList<AniData>::const_iterator anim = entry->animations.constBegin(); anim != entry->animations.constEnd(); ++anim) {
+            if (anim->startTime > now && !anim->waitAtSource) {
                 continue;
             }
 
@@ -522,6 +551,13 @@ void AnimationEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &data,
                 data.setTransformed();
             }
         }
+
+        // The area where the window was painted in the previous frame has been scheduled for
+        // repainting in postPaintScreen(), the area where it ends up in this frame is added here.
+        const QRect painted = paintedRect(w, entry->animations);
+        if (!painted.isNull()) {
+            data.paint += painted & effects->renderTargetRect();
+        }
     }
     effects->prePaintWindow(w, data, presentTime);
 }
@@ -540,13 +576,14 @@ static inline float geometryCompensation(int flags, float v)
 void AnimationEffect::paintWindow(EffectWindow *w, int mask, QRegion region, WindowPaintData &data)
 {
     Q_D(AnimationEffect);
-    AniMap::const_iterator entry = d->m_animations.constFind(w);
+    const AnimatedWindow *entry = d->find(w);
     auto finalRegion = region;
 
-    if (entry != d->m_animations.constEnd()) {
-        for (QList<AniData>::const_iterator anim = entry->first.constBegin(); anim != entry->first.constEnd(); ++anim) {
+    if (entry) {
+        const qint64 now = clock();
+        for (QList<AniData>::const_iterator anim = entry->animations.constBegin(); anim != entry->animations.constEnd(); ++anim) {
 
-            if (anim->startTime > clock() && !anim->waitAtSource) {
+            if (anim->startTime > now && !anim->waitAtSource) {
                 continue;
             }
 
@@ -560,81 +597,20 @@ void AnimationEffect::paintWindow(EffectWindow *w, int mask, QRegion region, Win
             case Saturation:
                 data.multiplySaturation(interpolated(*anim));
                 break;
-            case Scale: {
-                const QSizeF sz = w->frameGeometry().size();
-                float f1(1.0), f2(0.0);
-                if (anim->from[0] >= 0.0 && anim->to[0] >= 0.0) { // scale x
-                    f1 = interpolated(*anim, 0);
-                    f2 = geometryCompensation(anim->meta & AnimationEffect::Horizontal, f1);
-                    data.translate(f2 * sz.width());
-                    data.setXScale(data.xScale() * f1);
-                }
-                if (anim->from[1] >= 0.0 && anim->to[1] >= 0.0) { // scale y
-                    if (!anim->isOneDimensional()) {
-                        f1 = interpolated(*anim, 1);
-                        f2 = geometryCompensation(anim->meta & AnimationEffect::Vertical, f1);
-                    } else if (((anim->meta & AnimationEffect::Vertical) >> 1) != (anim->meta & AnimationEffect::Horizontal)) {
-                        f2 = geometryCompensation(anim->meta & AnimationEffect::Vertical, f1);
-                    }
-                    data.translate(0.0, f2 * sz.height());
-                    data.setYScale(data.yScale() * f1);
-                }
+            case Scale:
+            case Translation:
+            case Size:
+            case Position:
+                transformWindow(w, *anim, data);
                 break;
-            }
             case Clip:
                 finalRegion = clipRect(w->expandedGeometry().toAlignedRect(), *anim);
                 break;
-            case Translation:
-                data += QPointF(interpolated(*anim, 0), interpolated(*anim, 1));
-                break;
-            case Size: {
-                FPx2 dest = anim->from + progress(*anim) * (anim->to - anim->from);
-                const QSizeF sz = w->frameGeometry().size();
-                float f;
-                if (anim->from[0] >= 0.0 && anim->to[0] >= 0.0) { // resize x
-                    f = dest[0] / sz.width();
-                    data.translate(geometryCompensation(anim->meta & AnimationEffect::Horizontal, f) * sz.width());
-                    data.setXScale(data.xScale() * f);
-                }
-                if (anim->from[1] >= 0.0 && anim->to[1] >= 0.0) { // resize y
-                    f = dest[1] / sz.height();
-                    data.translate(0.0, geometryCompensation(anim->meta & AnimationEffect::Vertical, f) * sz.height());
-                    data.setYScale(data.yScale() * f);
-                }
-                break;
-            }
-            case Position: {
-                const QRectF geo = w->frameGeometry();
-                const float prgrs = progress(*anim);
-                if (anim->from[0] >= 0.0 && anim->to[0] >= 0.0) {
-                    float dest = interpolated(*anim, 0);
-                    const qreal x[2] = {xCoord(geo, metaData(SourceAnchor, anim->meta)),
-                                        xCoord(geo, metaData(TargetAnchor, anim->meta))};
-                    data.translate(dest - (x[0] + prgrs * (x[1] - x[0])));
-                }
-                if (anim->from[1] >= 0.0 && anim->to[1] >= 0.0) {
-                    float dest = interpolated(*anim, 1);
-                    const qreal y[2] = {yCoord(geo, metaData(SourceAnchor, anim->meta)),
-                                        yCoord(geo, metaData(TargetAnchor, anim->meta))};
-                    data.translate(0.0, dest - (y[0] + prgrs * (y[1] - y[0])));
-                }
-                break;
-            }
             case Rotation: {
                 data.setRotationAxis((Qt::Axis)metaData(Axis, anim->meta));
                 const float prgrs = progress(*anim);
                 data.setRotationAngle(anim->from[0] + prgrs * (anim->to[0] - anim->from[0]));
-
-                const QRect geo = w->rect().toRect();
-                const uint sAnchor = metaData(SourceAnchor, anim->meta),
-                           tAnchor = metaData(TargetAnchor, anim->meta);
-                QPointF pt(xCoord(geo, sAnchor), yCoord(geo, sAnchor));
-
-                if (tAnchor != sAnchor) {
-                    QPointF pt2(xCoord(geo, tAnchor), yCoord(geo, tAnchor));
-                    pt += static_cast<qreal>(prgrs) * (pt2 - pt);
-                }
-                data.setRotationOrigin(QVector3D(pt));
+                data.setRotationOrigin(QVector3D(rotationOrigin(w, *anim)));
                 break;
             }
             case Generic:
@@ -667,56 +643,232 @@ void AnimationEffect::paintWindow(EffectWindow *w, int mask, QRegion region, Win
     effects->paintWindow(w, mask, region, data);
 }
 
+void AnimationEffect::transformWindow(EffectWindow *w, const AniData &anim, WindowPaintData &data) const
+{
+    switch (anim.attribute) {
+    case Scale: {
+        const QSizeF sz = w->frameGeometry().size();
+        float f1(1.0), f2(0.0);
+        if (anim.from[0] >= 0.0 && anim.to[0] >= 0.0) { // scale x
+            f1 = interpolated(anim, 0);
+            f2 = geometryCompensation(anim.meta & AnimationEffect::Horizontal, f1);
+            data.translate(f2 * sz.width());
+            data.setXScale(data.xScale() * f1);
+        }
+        if (anim.from[1] >= 0.0 && anim.to[1] >= 0.0) { // scale y
+            if (!anim.isOneDimensional()) {
+                f1 = interpolated(anim, 1);
+                f2 = geometryCompensation(anim.meta & AnimationEffect::Vertical, f1);
+            } else if (((anim.meta & AnimationEffect::Vertical) >> 1) != (anim.meta & AnimationEffect::Horizontal)) {
+                f2 = geometryCompensation(anim.meta & AnimationEffect::Vertical, f1);
+            }
+            data.translate(0.0, f2 * sz.height());
+            data.setYScale(data.yScale() * f1);
+        }
+        break;
+    }
+    case Translation:
+        data += QPointF(interpolated(anim, 0), interpolated(anim, 1));
+        break;
+    case Size: {
+        FPx2 dest = anim.from + progress(anim) * (anim.to - anim.from);
+        const QSizeF sz = w->frameGeometry().size();
+        float f;
+        if (anim.from[0] >= 0.0 && anim.to[0] >= 0.0) { // resize x
+            f = dest[0] / sz.width();
+            data.translate(geometryCompensation(anim.meta & AnimationEffect::Horizontal, f) * sz.width());
+            data.setXScale(data.xScale() * f);
+        }
+        if (anim.from[1] >= 0.0 && anim.to[1] >= 0.0) { // resize y
+            f = dest[1] / sz.height();
+            data.translate(0.0, geometryCompensation(anim.meta & AnimationEffect::Vertical, f) * sz.height());
+            data.setYScale(data.yScale() * f);
+        }
+        break;
+    }
+    case Position: {
+        const QRectF geo = w->frameGeometry();
+        const float prgrs = progress(anim);
+        if (anim.from[0] >= 0.0 && anim.to[0] >= 0.0) {
+            float dest = interpolated(anim, 0);
+            const qreal x[2] = {xCoord(geo, metaData(SourceAnchor, anim.meta)),
+                                xCoord(geo, metaData(TargetAnchor, anim.meta))};
+            data.translate(dest - (x[0] + prgrs * (x[1] - x[0])));
+        }
+        if (anim.from[1] >= 0.0 && anim.to[1] >= 0.0) {
+            float dest = interpolated(anim, 1);
+            const qreal y[2] = {yCoord(geo, metaData(SourceAnchor, anim.meta)),
+                                yCoord(geo, metaData(TargetAnchor, anim.meta))};
+            data.translate(0.0, dest - (y[0] + prgrs * (y[1] - y[0])));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+QPointF AnimationEffect::rotationOrigin(EffectWindow *w, const AniData &anim) const
+{
+    const QRect geo = w->rect().toRect();
+    const uint sAnchor = metaData(SourceAnchor, anim.meta),
+               tAnchor = metaData(TargetAnchor, anim.meta);
+    QPointF pt(xCoord(geo, sAnchor), yCoord(geo, sAnchor));
+
+    if (tAnchor != sAnchor) {
+        QPointF pt2(xCoord(geo, tAnchor), yCoord(geo, tAnchor));
+        pt += static_cast<qreal>(progress(anim)) * (pt2 - pt);
+    }
+    return pt;
+}
+
+QRect AnimationEffect::paintedRect(EffectWindow *w, const QList<AniData> &animations) const
+{
+    const qint64 now = clock();
+    WindowPaintData data;
+    std::optional<QPointF> rotation;
+    for (const AniData &anim : animations) {
+        if (anim.startTime > now && !anim.waitAtSource) {
+            continue;
+        }
+        switch (anim.attribute) {
+        case Rotation:
+            // A rotation about the x or y axis is projected in perspective and can get larger
+            // than the window. The caller falls back to repainting the whole screen for it.
+            if (rotation || metaData(Axis, anim.meta) != Qt::ZAxis || effects->compositingType() == QPainterCompositing) {
+                return QRect();
+            }
+            rotation = rotationOrigin(w, anim);
+            break;
+        case Generic:
+            return QRect(); // the effect can paint anything anywhere, the scene gets repainted
+        case Scale:
+        case Translation:
+        case Size:
+        case Position:
+            transformWindow(w, anim, data);
+            break;
+        default:
+            break; // does not move any pixels, note that the clip is not applied while painting
+        }
+    }
+
+    QPointF origin;
+    if (effects->compositingType() != QPainterCompositing) {
+        origin = w->pos(); // the OpenGL renderer scales about the window position
+    }
+    QRectF geometry = w->expandedGeometry().translated(-origin);
+    if (rotation) {
+        // Whatever the angle, the window stays within the circle around the rotation origin
+        // that passes through its farthest corner.
+        qreal radius = 0;
+        for (const QPointF &corner : {geometry.topLeft(), geometry.topRight(), geometry.bottomLeft(), geometry.bottomRight()}) {
+            radius = std::max(radius, QLineF(*rotation, corner).length());
+        }
+        geometry = QRectF(rotation->x() - radius, rotation->y() - radius, 2 * radius, 2 * radius);
+    }
+    const QRectF painted(origin.x() + data.xTranslation() + geometry.x() * data.xScale(),
+                         origin.y() + data.yTranslation() + geometry.y() * data.yScale(),
+                         geometry.width() * data.xScale(),
+                         geometry.height() * data.yScale());
+    // pad by a pixel to account for rounding and linear filtering
+    return painted.normalized().toAlignedRect().adjusted(-1, -1, 1, 1);
+}
+
+/**
+ * Returns the area that has to be repainted in the next frame, given the area where the window
+ * was painted in the current frame. The next position is extrapolated from the last two frames
+ * so that outputs the window moves onto get a frame scheduled, the exact area is added in
+ * prePaintWindow().
+ */
+static QRect nextFrameDamage(AnimatedWindow &entry, const QRect &painted)
+{
+    if (painted.isNull()) {
+        entry.paintedRect = QRect();
+        return entry.damage;
+    }
+
+    QRect damage = painted;
+    if (!entry.paintedRect.isNull()) {
+        const QRect &previous = entry.paintedRect;
+        damage |= QRect(QPoint(2 * painted.left() - previous.left(), 2 * painted.top() - previous.top()),
+                        QPoint(2 * painted.right() - previous.right(), 2 * painted.bottom() - previous.bottom()))
+                      .normalized();
+    }
+    entry.paintedRect = painted;
+    return damage;
+}
+
 void AnimationEffect::postPaintScreen()
 {
     Q_D(AnimationEffect);
     d->m_animationsTouched = false;
     bool damageDirty = false;
-
-    for (auto entry = d->m_animations.begin(); entry != d->m_animations.end();) {
-        bool invalidateLayerRect = false;
-        int animCounter = 0;
-        for (auto anim = entry->first.begin(); anim != entry->first.end();) {
-            if (anim->isActive() || (anim->startTime > clock() && !anim->waitAtSource)) {
-                ++anim;
-                ++animCounter;
+    const qint64 now = clock();
+
+    for (size_t i = 0; i < d->m_animations.size();) {
+        EffectWindow *window = d->m_animations[i].window;
+        bool invalidateDamage = false;
+        bool windowGone = false;
+        for (int j = 0; j < d->m_animations[i].animations.count();) {
+            const QList<AniData> &animations = d->m_animations[i].animations;
+            const AniData &anim = animations.at(j);
+            if (anim.isActive() || (anim.startTime > now && !anim.waitAtSource)) {
+                ++j;
                 continue;
             }
-            EffectWindow *window = entry.key();
-            d->m_justEndedAnimation = anim->id;
-            if (anim->shader && std::none_of(entry->first.begin(), entry->first.end(), [anim] (const auto &other) { return anim->id != other.id && other.shader; })) {
+            const quint64 id = anim.id;
+            const Attribute attribute = anim.attribute;
+            const uint meta = anim.meta;
+            d->m_justEndedAnimation = id;
+            if (anim.shader && std::none_of(animations.begin(), animations.end(), [id](const auto &other) { return id != other.id && other.shader; })) {
                 unredirect(window);
             }
             unredirect(window);
-            animationEnded(window, anim->attribute, anim->meta);
+            animationEnded(window, attribute, meta);
             d->m_justEndedAnimation = 0;
-            // NOTICE animationEnded is an external call and might have called "::animate"
-            // as a result our iterators could now point random junk on the heap
-            // so we've to restore the former states, ie. find our window list and animation
+            invalidateDamage = damageDirty = true;
+            // NOTICE animationEnded is an external call and might have called "::animate" or
+            // "::cancel", which may have reallocated the flat array or removed entries from it,
+            // so we've to find our window and the ended animation again
             if (d->m_animationsTouched) {
                 d->m_animationsTouched = false;
-                entry = d->m_animations.begin();
-                while (entry.key() != window && entry != d->m_animations.end()) {
-                    ++entry;
+                auto entry = std::find_if(d->m_animations.begin(), d->m_animations.end(), [window](const AnimatedWindow &entry) {
+                    return entry.window == window;
+                });
+                if (entry == d->m_animations.end()) {
+                    windowGone = true;
+                    break;
                 }
-                Q_ASSERT(entry != d->m_animations.end()); // usercode should not delete animations from animationEnded (not even possible atm.)
-                anim = entry->first.begin();
-                Q_ASSERT(animCounter < entry->first.count());
-                for (int i = 0; i < animCounter; ++i) {
-                    ++anim;
+                i = entry - d->m_animations.begin();
+                auto ended = std::find_if(entry->animations.begin(), entry->animations.end(), [id](const AniData &other) {
+                    return other.id == id;
+                });
+                if (ended == entry->animations.end()) {
+                    // The animations still ahead may have moved, start over, the active ones are skipped.
+                    j = 0;
+                    continue;
                 }
+                j = ended - entry->animations.begin();
             }
-            anim = entry->first.erase(anim);
-            invalidateLayerRect = damageDirty = true;
+            d->m_animations[i].animations.removeAt(j);
         }
-        if (entry->first.isEmpty()) {
-            effects->addRepaint(entry->second);
-            entry = d->m_animations.erase(entry);
+        if (windowGone) {
+            // Entries before this one may have been removed as well, the remaining ones only
+            // hold animations that are still running or that are checked again.
+            i = 0;
+            continue;
+        }
+        AnimatedWindow &entry = d->m_animations[i];
+        if (entry.animations.isEmpty()) {
+            effects->addRepaint(entry.damage);
+            entry.window->setEffectInterest(this, false);
+            d->m_animations.erase(d->m_animations.begin() + i);
         } else {
-            if (invalidateLayerRect) {
-                *const_cast<QRect *>(&(entry->second)) = QRect(); // invalidate
+            if (invalidateDamage) {
+                entry.damage = QRect(); // invalidate
             }
-            ++entry;
+            ++i;
         }
     }
 
@@ -726,24 +878,23 @@ void AnimationEffect::postPaintScreen()
     if (d->m_needSceneRepaint) {
         effects->addRepaintFull();
     } else {
-        for (auto entry = d->m_animations.constBegin(); entry != d->m_animations.constEnd(); ++entry) {
-            for (auto anim = entry->first.constBegin(); anim != entry->first.constEnd(); ++anim) {
-                if (anim->startTime > clock()) {
-                    continue;
-                }
-                if (!anim->timeLine.done()) {
-                    entry.key()->addLayerRepaint(entry->second);
-                    break;
-                }
+        for (AnimatedWindow &entry : d->m_animations) {
+            const bool running = std::any_of(entry.animations.cbegin(), entry.animations.cend(), [now](const AniData &anim) {
+                return anim.startTime <= now && !anim.timeLine.done();
+            });
+            if (running) {
+                entry.window->addLayerRepaint(nextFrameDamage(entry, paintedRect(entry.window, entry.animations)));
             }
         }
     }
 
     // janitorial...
-    if (d->m_animations.isEmpty()) {
+    if (d->m_animations.empty()) {
         disconnectGeometryChanges();
+        updateActive();
     }
 
+    AnimationScheduler::self()->endFrame();
     effects->postPaintScreen();
 }
 
@@ -821,16 +972,16 @@ void AnimationEffect::setMetaData(MetaType type, uint value, uint &meta)
 void AnimationEffect::triggerRepaint()
 {
     Q_D(AnimationEffect);
-    for (AniMap::const_iterator entry = d->m_animations.constBegin(), mapEnd = d->m_animations.constEnd(); entry != mapEnd; ++entry) {
-        *const_cast<QRect *>(&(entry->second)) = QRect();
+    for (AnimatedWindow &entry : d->m_animations) {
+        entry.damage = QRect();
     }
     updateLayerRepaints();
     if (d->m_needSceneRepaint) {
         effects->addRepaintFull();
     } else {
-        AniMap::const_iterator it = d->m_animations.constBegin(), end = d->m_animations.constEnd();
-        for (; it != end; ++it) {
-            it.key()->addLayerRepaint(it->second);
+        for (AnimatedWindow &entry : d->m_animations) {
+            const QRect painted = paintedRect(entry.window, entry.animations);
+            entry.window->addLayerRepaint(painted.isNull() ? entry.damage : painted);
         }
     }
 }
@@ -857,17 +1008,18 @@ void AnimationEffect::updateLayerRepaints()
 {
     Q_D(AnimationEffect);
     d->m_needSceneRepaint = false;
-    for (AniMap::const_iterator entry = d->m_animations.constBegin(), mapEnd = d->m_animations.constEnd(); entry != mapEnd; ++entry) {
-        if (!entry->second.isNull()) {
+    const qint64 now = clock();
+    for (AnimatedWindow &entry : d->m_animations) {
+        if (!entry.damage.isNull()) {
             continue;
         }
         float f[2] = {1.0, 1.0};
         float t[2] = {0.0, 0.0};
         bool createRegion = false;
         QList<QRect> rects;
-        QRect *layerRect = const_cast<QRect *>(&(entry->second));
-        for (QList<AniData>::const_iterator anim = entry->first.constBegin(), animEnd = entry->first.constEnd(); anim != animEnd; ++anim) {
-            if (anim->startTime > clock()) {
+        QRect *layerRect = &entry.damage;
+        for (QList<AniData>::const_iterator anim = entry.animations.constBegin(), animEnd = entry.animations.constEnd(); anim != animEnd; ++anim) {
+            if (anim->startTime > now) {
                 continue;
             }
             switch (anim->attribute) {
@@ -889,7 +1041,7 @@ void AnimationEffect::updateLayerRepaints()
             case Translation:
             case Position: {
                 createRegion = true;
-                QRect r(entry.key()->frameGeometry().toRect());
+                QRect r(entry.window->frameGeometry().toRect());
                 int x[2] = {0, 0};
                 int y[2] = {0, 0};
                 if (anim->attribute == Translation) {
@@ -907,7 +1059,7 @@ void AnimationEffect::updateLayerRepaints()
                         y[1] = anim->to[1] - yCoord(r, metaData(TargetAnchor, anim->meta));
                     }
                 }
-                r = entry.key()->expandedGeometry().toRect();
+                r = entry.window->expandedGeometry().toRect();
                 rects << r.translated(x[0], y[0]) << r.translated(x[1], y[1]);
                 break;
             }
@@ -917,7 +1069,7 @@ void AnimationEffect::updateLayerRepaints()
             case Size:
             case Scale: {
                 createRegion = true;
-                const QSize sz = entry.key()->frameGeometry().size().toSize();
+                const QSize sz = entry.window->frameGeometry().size().toSize();
                 float fx = std::max(fixOvershoot(anim->from[0], *anim, 1), fixOvershoot(anim->to[0], *anim, 2));
                 //                     float fx = std::max(interpolated(*anim,0), anim->to[0]);
                 if (fx >= 0.0) {
@@ -947,7 +1099,7 @@ void AnimationEffect::updateLayerRepaints()
         }
     region_creation:
         if (createRegion) {
-            const QRect geo = entry.key()->expandedGeometry().toRect();
+            const QRect geo = entry.window->expandedGeometry().toRect();
             if (rects.isEmpty()) {
                 rects << geo;
             }
@@ -973,12 +1125,11 @@ void AnimationEffect::updateLayerRepaints()
 void AnimationEffect::_windowExpandedGeometryChanged(KWin::EffectWindow *w)
 {
     Q_D(AnimationEffect);
-    AniMap::const_iterator entry = d->m_animations.constFind(w);
-    if (entry != d->m_animations.constEnd()) {
-        *const_cast<QRect *>(&(entry->second)) = QRect();
+    if (AnimatedWindow *entry = d->find(w)) {
+        entry->damage = QRect();
         updateLayerRepaints();
-        if (!entry->second.isNull()) { // actually got updated, ie. is in use - ensure it get's a repaint
-            w->addLayerRepaint(entry->second);
+        if (!entry->damage.isNull()) { // actually got updated, ie. is in use - ensure it get's a repaint
+            w->addLayerRepaint(entry->damage);
         }
     }
 }
@@ -987,12 +1138,12 @@ void AnimationEffect::_windowClosed(EffectWindow *w)
 {
     Q_D(AnimationEffect);
 
-    auto it = d->m_animations.find(w);
-    if (it == d->m_animations.end()) {
+    AnimatedWindow *entry = d->find(w);
+    if (!entry) {
         return;
     }
 
-    QList<AniData> &animations = (*it).first;
+    QList<AniData> &animations = entry->animations;
     for (auto animationIt = animations.begin(); animationIt != animations.end(); ++animationIt) {
         if (animationIt->keepAlive) {
             animationIt->deletedRef = EffectWindowDeletedRef(w);
@@ -1003,24 +1154,30 @@ void AnimationEffect::_windowClosed(EffectWindow *w)
 void AnimationEffect::_windowDeleted(EffectWindow *w)
 {
     Q_D(AnimationEffect);
-    d->m_animations.remove(w);
+    auto it = std::find_if(d->m_animations.begin(), d->m_animations.end(), [w](const AnimatedWindow &entry) {
+        return entry.window == w;
+    });
+    if (it != d->m_animations.end()) {
+        w->setEffectInterest(this, false);
+        d->m_animations.erase(it);
+        updateActive();
+    }
 }
 
 QString AnimationEffect::debug(const QString & /*parameter*/) const
 {
     Q_D(const AnimationEffect);
     QString dbg;
-    if (d->m_animations.isEmpty()) {
+    if (d->m_animations.empty()) {
         dbg = QStringLiteral("No window is animated");
     } else {
-        AniMap::const_iterator entry = d->m_animations.constBegin(), mapEnd = d->m_animations.constEnd();
-        for (; entry != mapEnd; ++entry) {
-            QString caption = entry.key()->isDeleted() ? QStringLiteral("[Deleted]") : entry.key()->caption();
+        for (const AnimatedWindow &entry : d->m_animations) {
+            QString caption = entry.window->isDeleted() ? QStringLiteral("[Deleted]") : entry.window->caption();
             if (caption.isEmpty()) {
                 caption = QStringLiteral("[Untitled]");
             }
             dbg += QLatin1String("Animating window: ") + caption + QLatin1Char('\n');
-            QList<AniData>::const_iterator anim = entry->first.constBegin(), animEnd = entry->first.constEnd();
+            QList<AniData>::const_iterator anim = entry.animations.constBegin(), animEnd = entry.animations.constEnd();
             for (; anim != animEnd; ++anim) {
                 dbg += anim->debugInfo();
             }
@@ -1032,7 +1189,11 @@ QString AnimationEffect::debug(const QString & /*parameter*/) const
 AnimationEffect::AniMap AnimationEffect::state() const
 {
     Q_D(const AnimationEffect);
-    return d->m_animations;
+    AniMap state;
+    for (const AnimatedWindow &entry : d->m_animations) {
+        state.insert(entry.window, qMakePair(entry.animations, entry.damage));
+    }
+    return state;
 }
 
 } // namespace KWin
@@ -292,7 +292,13 @@ public:
     AnimationEffect();
     ~AnimationEffect() override;
 
+    /**
+     * Animation effects emit activeChanged() when the first animation starts and when the last
+     * one ends. Subclasses that reimplement isActive() must emit it as well, or leave out
+     * NotifiesActiveChanged.
+     */
     bool isActive() const override;
+    PaintHooks paintHooks() const override;
 
     /**
      * Gets stored metadata.
@@ -342,10 +348,7 @@ public:
     /**
      * @since 4.8
      */
-    static inline qint64 clock()
-    {
-        return s_clock.elapsed();
-    }
+    static qint64 clock();
 
 protected:
     /**
@@ -510,7 +513,11 @@ private:
     QRect clipRect(const QRect &windowRect, const AniData &) const;
     float interpolated(const AniData &, int i = 0) const;
     float progress(const AniData &) const;
+    void transformWindow(EffectWindow *w, const AniData &anim, WindowPaintData &data) const;
+    QPointF rotationOrigin(EffectWindow *w, const AniData &anim) const;
+    QRect paintedRect(EffectWindow *w, const QList<AniData> &animations) const;
     void disconnectGeometryChanges();
+    void updateActive();
     void updateLayerRepaints();
     void validate(Attribute a, uint &meta, FPx2 *from, FPx2 *to, const EffectWindow *w) const;
 
@@ -522,7 +529,6 @@ private Q_SLOTS:
     void _windowExpandedGeometryChanged(KWin::EffectWindow *w);
 
 private:
-    static QElapsedTimer s_clock;
     const std::unique_ptr<AnimationEffectPrivate> d_ptr;
     Q_DECLARE_PRIVATE(AnimationEffect)
     Q_DISABLE_COPY(AnimationEffect)
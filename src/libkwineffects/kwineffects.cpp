@@ -18,6 +18,7 @@
 #include <QPainter>
 #include <QPixmap>
 #include <QTimeLine>
+#include <QVarLengthArray>
 #include <QVariant>
 #include <QWindow>
 #include <QtMath>
@@ -25,6 +26,7 @@
 #include <kconfiggroup.h>
 #include <ksharedconfig.h>
 
+#include <algorithm>
 #include <optional>
 
 namespace KWin
@@ -529,6 +531,11 @@ bool Effect::isActive() const
     return true;
 }
 
+Effect::PaintHooks Effect::paintHooks() const
+{
+    return AllPaintHooks;
+}
+
 QString Effect::debug(const QString &) const
 {
     return QString();
@@ -736,6 +743,7 @@ public:
     Private(EffectWindow *q);
 
     EffectWindow *q;
+    QVarLengthArray<const Effect *, 4> interestedEffects;
 };
 
 EffectWindow::Private::Private(EffectWindow *q)
@@ -752,6 +760,23 @@ EffectWindow::~EffectWindow()
 {
 }
 
+void EffectWindow::setEffectInterest(const Effect *effect, bool interested)
+{
+    const auto it = std::find(d->interestedEffects.begin(), d->interestedEffects.end(), effect);
+    if (interested) {
+        if (it == d->interestedEffects.end()) {
+            d->interestedEffects.append(effect);
+        }
+    } else if (it != d->interestedEffects.end()) {
+        d->interestedEffects.erase(it);
+    }
+}
+
+bool EffectWindow::hasEffectInterest(const Effect *effect) const
+{
+    return std::find(d->interestedEffects.cbegin(), d->interestedEffects.cend(), effect) != d->interestedEffects.cend();
+}
+
 bool EffectWindow::isOnActivity(const QString &activity) const
 {
     const QStringList _activities = activities();
@@ -160,7 +160,7 @@ typedef QList<KWin::EffectWindow *> EffectWindowList;
 
 #define KWIN_EFFECT_API_MAKE_VERSION(major, minor) ((major) << 8 | (minor))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 236
+#define KWIN_EFFECT_API_VERSION_MINOR 237
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
     KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR)
 
@@ -485,7 +485,8 @@ public:
      * change a flag to indicate that this method returns @c true.
      *
      * As the method is called each frame, you should not perform complex calculations.
-     * Best use just a boolean flag.
+     * Best use just a boolean flag. Effects that return NotifiesActiveChanged from
+     * paintHooks() are only asked after they emitted activeChanged().
      *
      * The default implementation of this method returns @c true.
      * @since 4.8
@@ -519,6 +520,44 @@ public:
      */
     virtual int requestedEffectChainPosition() const;
 
+    /**
+     * The paint hooks an effect can take part in.
+     * @see paintHooks
+     */
+    enum PaintHook {
+        PrePaintScreenHook = 1 << 0,
+        PaintScreenHook = 1 << 1,
+        PostPaintScreenHook = 1 << 2,
+        PrePaintWindowHook = 1 << 3,
+        PaintWindowHook = 1 << 4,
+        PostPaintWindowHook = 1 << 5,
+        DrawWindowHook = 1 << 6,
+        AllPaintHooks = PrePaintScreenHook | PaintScreenHook | PostPaintScreenHook
+            | PrePaintWindowHook | PaintWindowHook | PostPaintWindowHook | DrawWindowHook,
+        /**
+         * The window hooks are only called for windows that have been marked with
+         * EffectWindow::setEffectInterest(). Windows that are not marked skip the effect.
+         */
+        FilterWindows = 1 << 16,
+        /**
+         * The effect emits activeChanged() whenever the value returned by isActive() changes,
+         * so isActive() does not have to be asked every frame.
+         */
+        NotifiesActiveChanged = 1 << 17,
+    };
+    Q_DECLARE_FLAGS(PaintHooks, PaintHook)
+
+    /**
+     * Reimplement this method to tell which of the paint hooks the effect reimplements.
+     *
+     * The hooks that are not returned are not called while the effect is active, the chain
+     * moves on to the next effect directly. The returned value is only queried when the set
+     * of active effects changes, so it must not change while the effect is loaded.
+     *
+     * The default implementation returns AllPaintHooks.
+     */
+    virtual PaintHooks paintHooks() const;
+
     /**
      * A touch point was pressed.
      *
@@ -684,6 +723,13 @@ public:
 public Q_SLOTS:
     virtual bool borderActivated(ElectricBorder border);
 
+Q_SIGNALS:
+    /**
+     * This signal is emitted when the value returned by isActive() changes, if the effect
+     * returns NotifiesActiveChanged from paintHooks().
+     */
+    void activeChanged();
+
 protected:
     xcb_connection_t *xcbConnection() const;
     xcb_window_t x11RootWindow() const;
@@ -2734,6 +2780,18 @@ public:
 
     virtual bool isHidden() const = 0;
 
+    /**
+     * Marks the window as being of interest to the given @p effect or clears the mark.
+     *
+     * If the effect filters windows, see Effect::FilterWindows, its window paint hooks
+     * are only called for the windows that have been marked.
+     */
+    void setEffectInterest(const Effect *effect, bool interested);
+    /**
+     * Returns @c true if the window has been marked with setEffectInterest() by the given @p effect.
+     */
+    bool hasEffectInterest(const Effect *effect) const;
+
 protected:
     friend EffectWindowVisibleRef;
     virtual void refVisible(const EffectWindowVisibleRef *holder) = 0;
@@ -4299,5 +4357,6 @@ Q_DECLARE_METATYPE(KWin::EffectWindow *)
 Q_DECLARE_METATYPE(KWin::EffectWindowList)
 Q_DECLARE_METATYPE(KWin::TimeLine)
 Q_DECLARE_METATYPE(KWin::TimeLine::Direction)
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWin::Effect::PaintHooks)
 
 /** @} */
@@ -0,0 +1,280 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwinglshadercache_p.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+#include "logging_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+// Bump whenever the layout of the cache files changes.
+static const quint32 s_cacheFileMagic = 0x4b575042; // "KWPB"
+static const quint32 s_cacheFileVersion = 1;
+
+// The programs of the least recently used shaders are removed once the cache grows past this.
+static const qint64 s_maximumCacheSize = 32 * 1024 * 1024;
+// Programs that haven't been used for this many days are removed, e.g. the ones of old drivers.
+static const int s_maximumAge = 30;
+// The cache is pruned at most once per this many hours.
+static const int s_pruneInterval = 24;
+
+static QString pruneMarker()
+{
+    return QStringLiteral("last-pruned");
+}
+
+static bool supportsProgramBinaries()
+{
+    GLPlatform *const gl = GLPlatform::instance();
+    if (gl->isGLES()) {
+        if (!hasGLVersion(3, 0) && !hasGLExtension(QByteArrayLiteral("GL_OES_get_program_binary"))) {
+            return false;
+        }
+    } else if (!hasGLVersion(4, 1) && !hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"))) {
+        return false;
+    }
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    return formatCount > 0;
+}
+
+GLShaderCache::GLShaderCache(const QString &directory)
+{
+    QString rootDirectory = directory;
+    if (rootDirectory.isEmpty()) {
+        rootDirectory = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/kwin/shaders");
+    }
+
+    // The binaries are only valid for the driver that produced them, so every driver gets its
+    // own directory. The directories of other drivers are kept for when the system switches back
+    // to them, e.g. with a second gpu or after a downgrade, and expire with age like any program.
+    GLPlatform *const gl = GLPlatform::instance();
+    m_driver = gl->glVendorString() + '\n' + gl->glRendererString() + '\n' + gl->glVersionString() + '\n' + gl->glShadingLanguageVersionString();
+    const QByteArray driverHash = QCryptographicHash::hash(m_driver, QCryptographicHash::Sha256).toHex().left(16);
+    const QString driverDirectory = QString::fromLatin1(driverHash) + QLatin1Char('-') + QString::number(s_cacheFileVersion);
+    m_rootDirectory = rootDirectory;
+    m_directory = rootDirectory + QLatin1Char('/') + driverDirectory;
+
+    if (qEnvironmentVariableIsSet("KWIN_GL_SHADER_CACHE") && !qEnvironmentVariableIntValue("KWIN_GL_SHADER_CACHE")) {
+        return;
+    }
+    if (!supportsProgramBinaries()) {
+        qCDebug(LIBKWINGLUTILS) << "Program binaries are not supported, disabling the shader cache";
+        return;
+    }
+    if (!QDir().mkpath(m_directory)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to create the shader cache directory" << m_directory;
+        return;
+    }
+
+    // Walking the cache is not free, so it's only done once in a while rather than on startup.
+    QFile marker(rootDirectory + QLatin1Char('/') + pruneMarker());
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const QDateTime lastPruned = QFileInfo(marker).lastModified();
+    if (!lastPruned.isValid() || lastPruned.addSecs(s_pruneInterval * 3600) < now || lastPruned > now) {
+        prune(s_maximumCacheSize, now.addDays(-s_maximumAge));
+        if (marker.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            marker.setFileTime(now, QFileDevice::FileModificationTime);
+        }
+    }
+    m_enabled = true;
+}
+
+bool GLShaderCache::isEnabled() const
+{
+    return m_enabled;
+}
+
+QString GLShaderCache::directory() const
+{
+    return m_directory;
+}
+
+QByteArray GLShaderCache::key(const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &bindings) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(m_driver);
+    hash.addData(QByteArrayLiteral("\0vertex\0"));
+    hash.addData(vertexSource);
+    hash.addData(QByteArrayLiteral("\0fragment\0"));
+    hash.addData(fragmentSource);
+    hash.addData(QByteArrayLiteral("\0bindings\0"));
+    hash.addData(bindings);
+    return hash.result().toHex();
+}
+
+QString GLShaderCache::filePath(const QByteArray &key) const
+{
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(key);
+}
+
+bool GLShaderCache::load(GLuint program, const QByteArray &key)
+{
+    if (!m_enabled) {
+        return false;
+    }
+
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        ++m_statistics.misses;
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 format = 0;
+    QByteArray binary;
+    stream >> magic >> version >> format >> binary;
+    // Loaded programs are kept the next time the cache gets pruned.
+    file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+    file.close();
+
+    if (stream.status() != QDataStream::Ok || magic != s_cacheFileMagic || version != s_cacheFileVersion || binary.isEmpty()) {
+        qCDebug(LIBKWINGLUTILS) << "Discarding malformed cached program" << file.fileName();
+        QFile::remove(file.fileName());
+        ++m_statistics.misses;
+        return false;
+    }
+
+    glProgramBinary(program, format, binary.constData(), binary.size());
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        qCDebug(LIBKWINGLUTILS) << "The driver rejected the cached program" << file.fileName();
+        QFile::remove(file.fileName());
+        ++m_statistics.rejected;
+        return false;
+    }
+
+    ++m_statistics.hits;
+    return true;
+}
+
+void GLShaderCache::prepare(GLuint program) const
+{
+    if (!m_enabled) {
+        return;
+    }
+    if (!GLPlatform::instance()->isGLES() || hasGLVersion(3, 0)) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void GLShaderCache::store(GLuint program, const QByteArray &key)
+{
+    if (!m_enabled) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    QByteArray binary(length, Qt::Uninitialized);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) {
+        return;
+    }
+    binary.truncate(written);
+
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to open" << file.fileName() << "for writing";
+        return;
+    }
+    QDataStream stream(&file);
+    stream << s_cacheFileMagic << s_cacheFileVersion << quint32(format) << binary;
+    if (!file.commit()) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to write" << file.fileName();
+        return;
+    }
+    ++m_statistics.stores;
+}
+
+void GLShaderCache::clear()
+{
+    QDir directory(m_directory);
+    const QStringList entries = directory.entryList(QDir::Files);
+    for (const QString &entry : entries) {
+        directory.remove(entry);
+    }
+}
+
+void GLShaderCache::prune(qint64 maximumSize, const QDateTime &expiry)
+{
+    QDir root(m_rootDirectory);
+    QFileInfoList entries;
+    QDirIterator it(m_rootDirectory, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo entry = it.fileInfo();
+        if (entry.dir() == root) {
+            // Files written by the versions that didn't have per driver directories.
+            if (entry.fileName() != pruneMarker()) {
+                root.remove(entry.fileName());
+            }
+            continue;
+        }
+        entries.append(entry);
+    }
+
+    // The programs of all drivers share the budget, the least recently used ones go first.
+    std::sort(entries.begin(), entries.end(), [](const QFileInfo &a, const QFileInfo &b) {
+        return a.lastModified() > b.lastModified();
+    });
+    qint64 size = 0;
+    for (const QFileInfo &entry : std::as_const(entries)) {
+        size += entry.size();
+    }
+    while (!entries.isEmpty()) {
+        const QFileInfo &entry = entries.constLast();
+        if (size <= maximumSize && (!expiry.isValid() || entry.lastModified() >= expiry)) {
+            break;
+        }
+        if (QFile::remove(entry.absoluteFilePath())) {
+            size -= entry.size();
+        }
+        entries.removeLast();
+    }
+
+    // Drop the directories of drivers whose programs have all expired.
+    const QStringList directories = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &directory : directories) {
+        if (root.filePath(directory) != m_directory) {
+            root.rmdir(directory);
+        }
+    }
+}
+
+GLShaderCache::Statistics GLShaderCache::statistics() const
+{
+    return m_statistics;
+}
+
+} // namespace KWin
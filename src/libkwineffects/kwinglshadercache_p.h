@@ -0,0 +1,119 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglutils_export.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <epoxy/gl.h>
+
+namespace KWin
+{
+
+/**
+ * The GLShaderCache stores linked program binaries on disk, so shaders don't have to be
+ * compiled again after a restart of the compositor.
+ *
+ * Binaries are looked up by a key computed from the shader sources, the attribute bindings and
+ * the OpenGL driver. A binary that the driver rejects, e.g. after an update of the driver that
+ * didn't change the version string, is removed and the caller compiles the shader again.
+ *
+ * Every driver gets its own subdirectory of the cache directory. The subdirectories of other
+ * drivers are kept, all binaries share one size budget. About once a day the binaries that
+ * haven't been loaded for a long time are removed, as are the least recently loaded ones of any
+ * driver if the cache has grown too large.
+ *
+ * The cache is disabled if the driver doesn't support any program binary format or if the
+ * KWIN_GL_SHADER_CACHE environment variable is set to 0.
+ */
+class KWINGLUTILS_EXPORT GLShaderCache
+{
+public:
+    struct Statistics
+    {
+        /**
+         * The number of programs that have been loaded from the cache.
+         */
+        int hits = 0;
+        /**
+         * The number of programs that were not in the cache.
+         */
+        int misses = 0;
+        /**
+         * The number of cached programs that were rejected by the driver.
+         */
+        int rejected = 0;
+        /**
+         * The number of programs that have been written to the cache.
+         */
+        int stores = 0;
+    };
+
+    /**
+     * Creates a cache in the given @p directory, or in the generic cache location if the
+     * @p directory is empty. A current OpenGL context is required.
+     */
+    explicit GLShaderCache(const QString &directory = QString());
+
+    bool isEnabled() const;
+
+    /**
+     * Returns the directory holding the binaries of the current driver.
+     */
+    QString directory() const;
+
+    /**
+     * Computes the key of a program. The @p bindings identify the attribute and fragment data
+     * locations, which are part of the program binary.
+     */
+    QByteArray key(const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &bindings) const;
+
+    /**
+     * Loads the cached binary with the given @p key into the @p program. Returns @c true if the
+     * program is linked successfully.
+     */
+    bool load(GLuint program, const QByteArray &key);
+
+    /**
+     * Must be called before linking a @p program that is going to be stored.
+     */
+    void prepare(GLuint program) const;
+
+    /**
+     * Stores the binary of the linked @p program under the given @p key.
+     */
+    void store(GLuint program, const QByteArray &key);
+
+    /**
+     * Removes all cached programs.
+     */
+    void clear();
+
+    /**
+     * Removes the programs of all drivers that were last used before @p expiry, and then the
+     * least recently used ones until the cache takes up at most @p maximumSize bytes.
+     */
+    void prune(qint64 maximumSize, const QDateTime &expiry = QDateTime());
+
+    Statistics statistics() const;
+
+private:
+    QString filePath(const QByteArray &key) const;
+
+    QString m_rootDirectory;
+    QString m_directory;
+    QByteArray m_driver;
+    bool m_enabled = false;
+    Statistics m_statistics;
+};
+
+} // namespace KWin
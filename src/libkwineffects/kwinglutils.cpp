@@ -15,8 +15,10 @@
 
 #include "kwineffects.h"
 #include "kwinglplatform.h"
+#include "kwinglshadercache_p.h"
 #include "logging_p.h"
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QHash>
 #include <QImage>
@@ -796,14 +798,20 @@ std::unique_ptr<GLShader> ShaderManager::generateCustomShader(ShaderTraits trait
     qCDebug(LIBKWINGLUTILS) << "**************";
 #endif
 
+    GLShaderCache *cache = this->cache();
+    const QByteArray key = cache->isEnabled() ? cache->key(vertex, fragment, QByteArrayLiteral("position,texcoord;fragColor")) : QByteArray();
+
     std::unique_ptr<GLShader> shader{new GLShader(GLShader::ExplicitLinking)};
+    if (loadCachedProgram(shader.get(), key)) {
+        return shader;
+    }
     shader->load(vertex, fragment);
 
     shader->bindAttributeLocation("position", VA_Position);
     shader->bindAttributeLocation("texcoord", VA_TexCoord);
     shader->bindFragDataLocation("fragColor", 0);
 
-    shader->link();
+    linkAndStore(shader.get(), key);
     return shader;
 }
 
@@ -924,14 +932,70 @@ void ShaderManager::bindAttributeLocations(GLShader *shader) const
 
 std::unique_ptr<GLShader> ShaderManager::loadShaderFromCode(const QByteArray &vertexSource, const QByteArray &fragmentSource)
 {
+    GLShaderCache *cache = this->cache();
+    const QByteArray key = cache->isEnabled() ? cache->key(vertexSource, fragmentSource, QByteArrayLiteral("vertex,texCoord;fragColor")) : QByteArray();
+
     std::unique_ptr<GLShader> shader{new GLShader(GLShader::ExplicitLinking)};
+    if (loadCachedProgram(shader.get(), key)) {
+        return shader;
+    }
     shader->load(vertexSource, fragmentSource);
     bindAttributeLocations(shader.get());
     bindFragDataLocations(shader.get());
-    shader->link();
+    linkAndStore(shader.get(), key);
     return shader;
 }
 
+GLShaderCache *ShaderManager::cache()
+{
+    if (!m_cache) {
+        m_cache = std::make_unique<GLShaderCache>();
+    }
+    return m_cache.get();
+}
+
+bool ShaderManager::loadCachedProgram(GLShader *shader, const QByteArray &key)
+{
+    if (key.isEmpty() || !m_cache->load(shader->mProgram, key)) {
+        return false;
+    }
+    shader->mValid = true;
+    return true;
+}
+
+void ShaderManager::linkAndStore(GLShader *shader, const QByteArray &key)
+{
+    if (!key.isEmpty()) {
+        m_cache->prepare(shader->mProgram);
+    }
+    if (shader->link() && !key.isEmpty()) {
+        m_cache->store(shader->mProgram, key);
+    }
+}
+
+void ShaderManager::warmUp()
+{
+    // The shaders used by the item renderer to draw windows.
+    static const ShaderTraits traits[] = {
+        ShaderTrait::MapTexture,
+        ShaderTrait::MapTexture | ShaderTrait::Modulate,
+        ShaderTrait::MapTexture | ShaderTrait::AdjustSaturation,
+        ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation,
+        ShaderTrait::UniformColor,
+        ShaderTrait::UniformColor | ShaderTrait::Modulate,
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    const GLShaderCache::Statistics before = cache()->statistics();
+    for (const ShaderTraits &shaderTraits : traits) {
+        shader(shaderTraits);
+    }
+    const GLShaderCache::Statistics after = cache()->statistics();
+    qCDebug(LIBKWINGLUTILS) << "Warmed up" << std::size(traits) << "shaders in" << timer.elapsed() << "ms,"
+                            << after.hits - before.hits << "loaded from the program binary cache";
+}
+
 /***  GLFramebuffer  ***/
 bool GLFramebuffer::sSupported = false;
 bool GLFramebuffer::s_blitSupported = false;
@@ -52,6 +52,8 @@ bool KWINGLUTILS_EXPORT checkGLError(const char *txt);
 
 QList<QByteArray> KWINGLUTILS_EXPORT openGLExtensions();
 
+class GLShaderCache;
+
 class KWINGLUTILS_EXPORT GLShader
 {
 public:
@@ -282,6 +284,21 @@ public:
      */
     std::unique_ptr<GLShader> generateShaderFromFile(ShaderTraits traits, const QString &vertexFile = QString(), const QString &fragmentFile = QString());
 
+    /**
+     * Creates the built-in shaders used by the compositing scene ahead of time, so the first
+     * frame doesn't have to wait for the driver to compile them. With a warm program binary
+     * cache this is cheap.
+     */
+    void warmUp();
+
+    /**
+     * Returns the on-disk cache of linked programs, which is used by all shaders created through
+     * the ShaderManager.
+     *
+     * @internal
+     */
+    GLShaderCache *cache();
+
     /**
      * @return a pointer to the ShaderManager instance
      */
@@ -301,9 +318,12 @@ private:
     QByteArray generateVertexSource(ShaderTraits traits) const;
     QByteArray generateFragmentSource(ShaderTraits traits) const;
     std::unique_ptr<GLShader> generateShader(ShaderTraits traits);
+    bool loadCachedProgram(GLShader *shader, const QByteArray &key);
+    void linkAndStore(GLShader *shader, const QByteArray &key);
 
     QStack<GLShader *> m_boundShaders;
     std::map<ShaderTraits, std::unique_ptr<GLShader>> m_shaderHash;
+    std::unique_ptr<GLShaderCache> m_cache;
     static std::unique_ptr<ShaderManager> s_shaderManager;
 };
 
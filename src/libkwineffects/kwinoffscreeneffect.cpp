@@ -7,6 +7,7 @@
 #include "kwinoffscreeneffect.h"
 #include "kwingltexture.h"
 #include "kwinglutils.h"
+#include "kwinwindowmesh.h"
 
 namespace KWin
 {
@@ -21,10 +22,15 @@ public:
 
     void paint(EffectWindow *window, const QRegion &region,
                const WindowPaintData &data, const WindowQuadList &quads);
+    void paint(EffectWindow *window, const QRegion &region,
+               const WindowPaintData &data, const WindowMesh &mesh);
 
     void maybeRender(EffectWindow *window);
 
 private:
+    void draw(EffectWindow *window, const QRegion &region, const WindowPaintData &data,
+              GLVertexBuffer *vbo, int vertexCount);
+
     std::unique_ptr<GLTexture> m_texture;
     std::unique_ptr<GLFramebuffer> m_fbo;
     bool m_isDirty = true;
@@ -146,9 +152,6 @@ void OffscreenData::setVertexSnappingMode(RenderGeometry::VertexSnappingMode mod
 void OffscreenData::paint(EffectWindow *window, const QRegion &region,
                           const WindowPaintData &data, const WindowQuadList &quads)
 {
-    GLShader *shader = m_shader ? m_shader : ShaderManager::instance()->shader(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
-    ShaderBinder binder(shader);
-
     const qreal scale = effects->renderTargetScale();
 
     GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
@@ -166,6 +169,34 @@ void OffscreenData::paint(EffectWindow *window, const QRegion &region,
     geometry.copy(std::span(map, geometry.count()));
     vbo->unmap();
 
+    draw(window, region, data, vbo, geometry.count());
+}
+
+void OffscreenData::paint(EffectWindow *window, const QRegion &region,
+                          const WindowPaintData &data, const WindowMesh &mesh)
+{
+    const qreal scale = effects->renderTargetScale();
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setAttribLayout(GLVertexBuffer::GLVertex2DLayout, 2, sizeof(GLVertex2D));
+
+    const int vertexCount = mesh.quadCount() * 6;
+    GLVertex2D *map = static_cast<GLVertex2D *>(vbo->map(vertexCount * sizeof(GLVertex2D)));
+    mesh.triangulate(std::span(map, vertexCount), scale, m_vertexSnappingMode, m_texture->matrix(NormalizedCoordinates));
+    vbo->unmap();
+
+    draw(window, region, data, vbo, vertexCount);
+}
+
+void OffscreenData::draw(EffectWindow *window, const QRegion &region, const WindowPaintData &data,
+                         GLVertexBuffer *vbo, int vertexCount)
+{
+    GLShader *shader = m_shader ? m_shader : ShaderManager::instance()->shader(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
+    ShaderBinder binder(shader);
+
+    const qreal scale = effects->renderTargetScale();
+
     vbo->bindArrays();
 
     const qreal rgb = data.brightness() * data.opacity();
@@ -191,7 +222,7 @@ void OffscreenData::paint(EffectWindow *window, const QRegion &region,
     glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     m_texture->bind();
-    vbo->draw(clipRegion, GL_TRIANGLES, 0, geometry.count(), clipping);
+    vbo->draw(clipRegion, GL_TRIANGLES, 0, vertexCount, clipping);
     m_texture->unbind();
 
     glDisable(GL_BLEND);
@@ -215,18 +246,41 @@ void OffscreenEffect::drawWindow(EffectWindow *window, int mask, const QRegion &
 
     QRectF visibleRect = expandedGeometry;
     visibleRect.moveTopLeft(expandedGeometry.topLeft() - frameGeometry.topLeft());
-    WindowQuad quad;
-    quad[0] = WindowVertex(visibleRect.topLeft(), QPointF(0, 0));
-    quad[1] = WindowVertex(visibleRect.topRight(), QPointF(1, 0));
-    quad[2] = WindowVertex(visibleRect.bottomRight(), QPointF(1, 1));
-    quad[3] = WindowVertex(visibleRect.bottomLeft(), QPointF(0, 1));
-
-    WindowQuadList quads;
-    quads.append(quad);
-    apply(window, mask, data, quads);
+
+    if (!hasDeform()) {
+        WindowQuad quad;
+        quad[0] = WindowVertex(visibleRect.topLeft(), QPointF(0, 0));
+        quad[1] = WindowVertex(visibleRect.topRight(), QPointF(1, 0));
+        quad[2] = WindowVertex(visibleRect.bottomRight(), QPointF(1, 1));
+        quad[3] = WindowVertex(visibleRect.bottomLeft(), QPointF(0, 1));
+
+        WindowQuadList quads;
+        quads.append(quad);
+        apply(window, mask, data, quads);
+
+        offscreenData->maybeRender(window);
+        offscreenData->paint(window, region, data, quads);
+        return;
+    }
+
+    WindowMesh mesh;
+    mesh.appendQuad(visibleRect, QRectF(0, 0, 1, 1));
+    deform(window, mask, data, mesh);
 
     offscreenData->maybeRender(window);
-    offscreenData->paint(window, region, data, quads);
+    offscreenData->paint(window, region, data, mesh);
+}
+
+void OffscreenEffect::deform(EffectWindow *window, int mask, WindowPaintData &data, WindowMesh &mesh)
+{
+    WindowQuadList quads = mesh.toQuadList();
+    apply(window, mask, data, quads);
+    mesh = WindowMesh(quads);
+}
+
+bool OffscreenEffect::hasDeform() const
+{
+    return false;
 }
 
 void OffscreenEffect::handleWindowDamaged(EffectWindow *window)
@@ -328,15 +382,9 @@ void CrossFadeEffect::drawWindow(EffectWindow *window, int mask, const QRegion &
 
     QRectF visibleRect = QRectF(QPointF(0, 0), frameGeometry.size()) - margins;
 
-    WindowQuad quad;
-    quad[0] = WindowVertex(visibleRect.topLeft(), QPointF(0, 0));
-    quad[1] = WindowVertex(visibleRect.topRight(), QPointF(1, 0));
-    quad[2] = WindowVertex(visibleRect.bottomRight(), QPointF(1, 1));
-    quad[3] = WindowVertex(visibleRect.bottomLeft(), QPointF(0, 1));
-
-    WindowQuadList quads;
-    quads.append(quad);
-    offscreenData->paint(window, region, previousWindowData, quads);
+    WindowMesh mesh;
+    mesh.appendQuad(visibleRect, QRectF(0, 0, 1, 1));
+    offscreenData->paint(window, region, previousWindowData, mesh);
 }
 
 void CrossFadeEffect::redirect(EffectWindow *window)
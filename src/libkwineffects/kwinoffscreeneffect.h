@@ -12,6 +12,7 @@ namespace KWin
 {
 
 class OffscreenEffectPrivate;
+class WindowMesh;
 class CrossFadeEffectPrivate;
 class ShaderEffectPrivate;
 
@@ -56,6 +57,20 @@ protected:
      * Override this function to transform the window.
      */
     virtual void apply(EffectWindow *window, int mask, WindowPaintData &data, WindowQuadList &quads);
+    /**
+     * Override this function to transform the window with the batch operations of WindowMesh.
+     * The mesh is written to the vertex buffer as is, without going through WindowQuad.
+     *
+     * This function is only called if hasDeform() returns @c true, otherwise apply() is called
+     * with a WindowQuadList. The default implementation calls apply().
+     */
+    virtual void deform(EffectWindow *window, int mask, WindowPaintData &data, WindowMesh &mesh);
+    /**
+     * Override this function to return @c true if the effect reimplements deform().
+     *
+     * The default implementation returns @c false.
+     */
+    virtual bool hasDeform() const;
 
     /**
      * Allows to specify a @p shader to draw the redirected texture for @p window.
@@ -52,6 +52,7 @@ public:
     std::map<EffectScreen *, std::unique_ptr<QuickSceneView>> views;
     QPointer<QuickSceneView> mouseImplicitGrab;
     bool running = false;
+    bool active = false;
     std::unique_ptr<QWindow> dummyWindow;
 };
 
@@ -134,6 +135,7 @@ QuickSceneEffect::QuickSceneEffect(QObject *parent)
     : Effect(parent)
     , d(new QuickSceneEffectPrivate)
 {
+    connect(effects, &EffectsHandler::screenLockingChanged, this, &QuickSceneEffect::updateActive);
 }
 
 QuickSceneEffect::~QuickSceneEffect()
@@ -344,6 +346,20 @@ bool QuickSceneEffect::isActive() const
     return !d->views.empty() && !effects->isScreenLocked();
 }
 
+Effect::PaintHooks QuickSceneEffect::paintHooks() const
+{
+    return AllPaintHooks | NotifiesActiveChanged;
+}
+
+void QuickSceneEffect::updateActive()
+{
+    const bool active = isActive();
+    if (d->active != active) {
+        d->active = active;
+        Q_EMIT activeChanged();
+    }
+}
+
 QVariantMap QuickSceneEffect::initialProperties(EffectScreen *screen)
 {
     return QVariantMap();
@@ -358,6 +374,7 @@ void QuickSceneEffect::handleScreenRemoved(EffectScreen *screen)
 {
     d->views.erase(screen);
     d->incubators.erase(screen);
+    updateActive();
 }
 
 void QuickSceneEffect::addScreen(EffectScreen *screen)
@@ -381,6 +398,7 @@ void QuickSceneEffect::addScreen(EffectScreen *screen)
             connect(view, &QuickSceneView::sceneChanged, view, &QuickSceneView::scheduleRepaint);
             view->scheduleRepaint();
             d->views[screen].reset(view);
+            updateActive();
         } else if (incubator->isError()) {
             qCWarning(LIBKWINEFFECTS) << "Could not create a view for QML file" << d->qmlComponent->url();
             qCWarning(LIBKWINEFFECTS) << incubator->errors();
@@ -458,6 +476,7 @@ void QuickSceneEffect::stopInternal()
     d->views.clear();
     d->dummyWindow.reset();
     d->running = false;
+    updateActive();
     qApp->removeEventFilter(this);
     effects->ungrabKeyboard();
     effects->stopMouseInterception(this);
@@ -126,6 +126,7 @@ public:
     void prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseconds presentTime) override;
     void paintScreen(int mask, const QRegion &region, ScreenPaintData &data) override;
     bool isActive() const override;
+    PaintHooks paintHooks() const override;
 
     void windowInputMouseEvent(QEvent *event) override;
     void grabbedKeyboardEvent(QKeyEvent *keyEvent) override;
@@ -158,6 +159,7 @@ private:
     void handleScreenRemoved(EffectScreen *screen);
 
     void addScreen(EffectScreen *screen);
+    void updateActive();
     void startInternal();
     void stopInternal();
 
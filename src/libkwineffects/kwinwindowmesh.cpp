@@ -0,0 +1,424 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwinwindowmesh.h"
+
+#include <QTransform>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KWIN_HAVE_AVX 1
+#endif
+
+namespace KWin
+{
+
+#if KWIN_HAVE_AVX
+static bool hasAvx()
+{
+    static const bool supported = __builtin_cpu_supports("avx");
+    return supported;
+}
+
+__attribute__((target("avx"))) static std::size_t transformAvx(float *x, float *y, std::size_t count,
+                                                                float m11, float m12, float m21, float m22, float dx, float dy)
+{
+    const __m256 a = _mm256_set1_ps(m11);
+    const __m256 b = _mm256_set1_ps(m12);
+    const __m256 c = _mm256_set1_ps(m21);
+    const __m256 d = _mm256_set1_ps(m22);
+    const __m256 tx = _mm256_set1_ps(dx);
+    const __m256 ty = _mm256_set1_ps(dy);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 px = _mm256_loadu_ps(x + i);
+        const __m256 py = _mm256_loadu_ps(y + i);
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, px), _mm256_mul_ps(c, py)), tx));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b, px), _mm256_mul_ps(d, py)), ty));
+    }
+    return i;
+}
+
+__attribute__((target("avx"))) static std::size_t bezierPatchAvx(float *x, float *y, std::size_t count,
+                                                                  float xScale, float yScale, const float *cx, const float *cy)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 three = _mm256_set1_ps(3.0f);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 tx = _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_set1_ps(xScale));
+        const __m256 ty = _mm256_mul_ps(_mm256_loadu_ps(y + i), _mm256_set1_ps(yScale));
+        const __m256 sx = _mm256_sub_ps(one, tx);
+        const __m256 sy = _mm256_sub_ps(one, ty);
+
+        const __m256 px[4] = {
+            _mm256_mul_ps(_mm256_mul_ps(sx, sx), sx),
+            _mm256_mul_ps(_mm256_mul_ps(three, _mm256_mul_ps(sx, sx)), tx),
+            _mm256_mul_ps(_mm256_mul_ps(three, sx), _mm256_mul_ps(tx, tx)),
+            _mm256_mul_ps(_mm256_mul_ps(tx, tx), tx),
+        };
+        const __m256 py[4] = {
+            _mm256_mul_ps(_mm256_mul_ps(sy, sy), sy),
+            _mm256_mul_ps(_mm256_mul_ps(three, _mm256_mul_ps(sy, sy)), ty),
+            _mm256_mul_ps(_mm256_mul_ps(three, sy), _mm256_mul_ps(ty, ty)),
+            _mm256_mul_ps(_mm256_mul_ps(ty, ty), ty),
+        };
+
+        __m256 rx = _mm256_setzero_ps();
+        __m256 ry = _mm256_setzero_ps();
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                const __m256 weight = _mm256_mul_ps(px[column], py[row]);
+                rx = _mm256_add_ps(rx, _mm256_mul_ps(weight, _mm256_set1_ps(cx[column + row * 4])));
+                ry = _mm256_add_ps(ry, _mm256_mul_ps(weight, _mm256_set1_ps(cy[column + row * 4])));
+            }
+        }
+        _mm256_storeu_ps(x + i, rx);
+        _mm256_storeu_ps(y + i, ry);
+    }
+    return i;
+}
+#endif
+
+WindowMesh::WindowMesh()
+{
+}
+
+WindowMesh::WindowMesh(const WindowQuadList &quads)
+{
+    reserve(quads.count());
+    for (const WindowQuad &quad : quads) {
+        appendQuad(quad);
+    }
+}
+
+WindowQuadList WindowMesh::toQuadList() const
+{
+    WindowQuadList quads;
+    quads.reserve(quadCount());
+    for (std::size_t i = 0; i < m_x.size(); i += 4) {
+        WindowQuad quad;
+        for (int j = 0; j < 4; ++j) {
+            quad[j] = WindowVertex(m_x[i + j], m_y[i + j], m_u[i + j], m_v[i + j]);
+        }
+        quads.append(quad);
+    }
+    return quads;
+}
+
+bool WindowMesh::isEmpty() const
+{
+    return m_x.empty();
+}
+
+int WindowMesh::quadCount() const
+{
+    return m_x.size() / 4;
+}
+
+int WindowMesh::vertexCount() const
+{
+    return m_x.size();
+}
+
+void WindowMesh::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_u.clear();
+    m_v.clear();
+}
+
+void WindowMesh::reserve(int quadCount)
+{
+    m_x.reserve(quadCount * 4);
+    m_y.reserve(quadCount * 4);
+    m_u.reserve(quadCount * 4);
+    m_v.reserve(quadCount * 4);
+}
+
+void WindowMesh::appendQuad(const WindowQuad &quad)
+{
+    for (int i = 0; i < 4; ++i) {
+        m_x.push_back(quad[i].x());
+        m_y.push_back(quad[i].y());
+        m_u.push_back(quad[i].u());
+        m_v.push_back(quad[i].v());
+    }
+}
+
+void WindowMesh::appendQuad(const QRectF &position, const QRectF &textureCoordinates)
+{
+    m_x.insert(m_x.end(), {float(position.left()), float(position.right()), float(position.right()), float(position.left())});
+    m_y.insert(m_y.end(), {float(position.top()), float(position.top()), float(position.bottom()), float(position.bottom())});
+    m_u.insert(m_u.end(), {float(textureCoordinates.left()), float(textureCoordinates.right()), float(textureCoordinates.right()), float(textureCoordinates.left())});
+    m_v.insert(m_v.end(), {float(textureCoordinates.top()), float(textureCoordinates.top()), float(textureCoordinates.bottom()), float(textureCoordinates.bottom())});
+}
+
+std::span<float> WindowMesh::x()
+{
+    return m_x;
+}
+
+std::span<const float> WindowMesh::x() const
+{
+    return m_x;
+}
+
+std::span<float> WindowMesh::y()
+{
+    return m_y;
+}
+
+std::span<const float> WindowMesh::y() const
+{
+    return m_y;
+}
+
+std::span<float> WindowMesh::u()
+{
+    return m_u;
+}
+
+std::span<const float> WindowMesh::u() const
+{
+    return m_u;
+}
+
+std::span<float> WindowMesh::v()
+{
+    return m_v;
+}
+
+std::span<const float> WindowMesh::v() const
+{
+    return m_v;
+}
+
+QRectF WindowMesh::bounds() const
+{
+    if (isEmpty()) {
+        return QRectF();
+    }
+    const auto [left, right] = std::minmax_element(m_x.cbegin(), m_x.cend());
+    const auto [top, bottom] = std::minmax_element(m_y.cbegin(), m_y.cend());
+    return QRectF(QPointF(*left, *top), QPointF(*right, *bottom));
+}
+
+void WindowMesh::appendSubQuad(const WindowMesh &source, int quad, double x0, double y0, double x1, double y1)
+{
+    const std::size_t first = quad * 4;
+    const double left = std::min({source.m_x[first], source.m_x[first + 1], source.m_x[first + 2], source.m_x[first + 3]});
+    const double right = std::max({source.m_x[first], source.m_x[first + 1], source.m_x[first + 2], source.m_x[first + 3]});
+    const double top = std::min({source.m_y[first], source.m_y[first + 1], source.m_y[first + 2], source.m_y[first + 3]});
+    const double bottom = std::max({source.m_y[first], source.m_y[first + 1], source.m_y[first + 2], source.m_y[first + 3]});
+
+    const double widthReciprocal = 1 / (right - left);
+    const double heightReciprocal = 1 / (bottom - top);
+
+    // Vertices are clockwise starting from the top-left corner.
+    const double xs[4] = {x0, x1, x1, x0};
+    const double ys[4] = {y0, y0, y1, y1};
+    for (int i = 0; i < 4; ++i) {
+        const double w1 = (xs[i] - left) * widthReciprocal;
+        const double w2 = (ys[i] - top) * heightReciprocal;
+
+        // Use bilinear interpolation to compute the texture coords.
+        m_x.push_back(xs[i]);
+        m_y.push_back(ys[i]);
+        m_u.push_back((1 - w1) * (1 - w2) * source.m_u[first] + w1 * (1 - w2) * source.m_u[first + 1]
+                      + w1 * w2 * source.m_u[first + 2] + (1 - w1) * w2 * source.m_u[first + 3]);
+        m_v.push_back((1 - w1) * (1 - w2) * source.m_v[first] + w1 * (1 - w2) * source.m_v[first + 1]
+                      + w1 * w2 * source.m_v[first + 2] + (1 - w1) * w2 * source.m_v[first + 3]);
+    }
+}
+
+WindowMesh WindowMesh::makeGrid(int maxQuadSize) const
+{
+    return subdivide(maxQuadSize, maxQuadSize);
+}
+
+WindowMesh WindowMesh::makeRegularGrid(int xSubdivisions, int ySubdivisions) const
+{
+    if (isEmpty()) {
+        return *this;
+    }
+    const QRectF bounds = this->bounds();
+    return subdivide(bounds.width() / xSubdivisions, bounds.height() / ySubdivisions);
+}
+
+WindowMesh WindowMesh::subdivide(double xIncrement, double yIncrement) const
+{
+    if (isEmpty()) {
+        return *this;
+    }
+
+    const QRectF bounds = this->bounds();
+    const double left = bounds.left();
+    const double top = bounds.top();
+
+    WindowMesh ret;
+    ret.reserve(std::max<double>(quadCount(), std::ceil(bounds.width() / xIncrement) * std::ceil(bounds.height() / yIncrement)));
+
+    for (int quad = 0; quad < quadCount(); ++quad) {
+        const std::size_t first = quad * 4;
+        const double quadLeft = std::min({m_x[first], m_x[first + 1], m_x[first + 2], m_x[first + 3]});
+        const double quadRight = std::max({m_x[first], m_x[first + 1], m_x[first + 2], m_x[first + 3]});
+        const double quadTop = std::min({m_y[first], m_y[first + 1], m_y[first + 2], m_y[first + 3]});
+        const double quadBottom = std::max({m_y[first], m_y[first + 1], m_y[first + 2], m_y[first + 3]});
+
+        // sanity check, see BUG 390953
+        if (quadLeft == quadRight || quadTop == quadBottom) {
+            for (std::size_t i = first; i < first + 4; ++i) {
+                ret.m_x.push_back(m_x[i]);
+                ret.m_y.push_back(m_y[i]);
+                ret.m_u.push_back(m_u[i]);
+                ret.m_v.push_back(m_v[i]);
+            }
+            continue;
+        }
+
+        // Compute the top-left corner of the first intersecting grid cell
+        const double xBegin = left + qFloor((quadLeft - left) / xIncrement) * xIncrement;
+        const double yBegin = top + qFloor((quadTop - top) / yIncrement) * yIncrement;
+
+        // Loop over all intersecting cells and add sub-quads
+        for (double y = yBegin; y < quadBottom; y += yIncrement) {
+            const double y0 = std::max(y, quadTop);
+            const double y1 = std::min(quadBottom, y + yIncrement);
+
+            for (double x = xBegin; x < quadRight; x += xIncrement) {
+                const double x0 = std::max(x, quadLeft);
+                const double x1 = std::min(quadRight, x + xIncrement);
+
+                ret.appendSubQuad(*this, quad, x0, y0, x1, y1);
+            }
+        }
+    }
+
+    return ret;
+}
+
+void WindowMesh::translate(float dx, float dy)
+{
+    for (float &x : m_x) {
+        x += dx;
+    }
+    for (float &y : m_y) {
+        y += dy;
+    }
+}
+
+void WindowMesh::transform(const QTransform &transform)
+{
+    const float m11 = transform.m11();
+    const float m12 = transform.m12();
+    const float m21 = transform.m21();
+    const float m22 = transform.m22();
+    const float dx = transform.dx();
+    const float dy = transform.dy();
+
+    float *x = m_x.data();
+    float *y = m_y.data();
+    const std::size_t count = m_x.size();
+
+    std::size_t i = 0;
+#if KWIN_HAVE_AVX
+    if (hasAvx()) {
+        i = transformAvx(x, y, count, m11, m12, m21, m22, dx, dy);
+    }
+#endif
+    for (; i < count; ++i) {
+        const float px = x[i];
+        const float py = y[i];
+        x[i] = m11 * px + m21 * py + dx;
+        y[i] = m12 * px + m22 * py + dy;
+    }
+}
+
+void WindowMesh::applyBezierPatch(const QSizeF &size, std::span<const QPointF, 16> controlPoints)
+{
+    float cx[16];
+    float cy[16];
+    for (int i = 0; i < 16; ++i) {
+        cx[i] = controlPoints[i].x();
+        cy[i] = controlPoints[i].y();
+    }
+    const float xScale = 1.0 / size.width();
+    const float yScale = 1.0 / size.height();
+
+    float *x = m_x.data();
+    float *y = m_y.data();
+    const std::size_t count = m_x.size();
+
+    std::size_t i = 0;
+#if KWIN_HAVE_AVX
+    if (hasAvx()) {
+        i = bezierPatchAvx(x, y, count, xScale, yScale, cx, cy);
+    }
+#endif
+    for (; i < count; ++i) {
+        const float tx = x[i] * xScale;
+        const float ty = y[i] * yScale;
+        const float sx = 1.0f - tx;
+        const float sy = 1.0f - ty;
+
+        const float px[4] = {sx * sx * sx, 3.0f * (sx * sx) * tx, 3.0f * sx * (tx * tx), tx * tx * tx};
+        const float py[4] = {sy * sy * sy, 3.0f * (sy * sy) * ty, 3.0f * sy * (ty * ty), ty * ty * ty};
+
+        float rx = 0.0f;
+        float ry = 0.0f;
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                const float weight = px[column] * py[row];
+                rx += weight * cx[column + row * 4];
+                ry += weight * cy[column + row * 4];
+            }
+        }
+        x[i] = rx;
+        y[i] = ry;
+    }
+}
+
+void WindowMesh::triangulate(std::span<GLVertex2D> destination, qreal deviceScale,
+                             RenderGeometry::VertexSnappingMode snappingMode, const QMatrix4x4 &textureMatrix) const
+{
+    Q_ASSERT(destination.size() >= m_x.size() / 4 * 6);
+
+    QVector2D textureScale(1, 1);
+    QVector2D textureOffset(0, 0);
+    if (!textureMatrix.isIdentity()) {
+        textureScale = QVector2D(textureMatrix(0, 0), textureMatrix(1, 1));
+        textureOffset = QVector2D(textureMatrix(0, 3), textureMatrix(1, 3));
+    }
+
+    // Every quad is split into two triangles, top-left, bottom-left, top-right followed
+    // by top-right, bottom-left, bottom-right, like RenderGeometry::appendWindowQuad() does.
+    static constexpr int order[6] = {0, 3, 1, 1, 3, 2};
+
+    const float scale = deviceScale;
+    GLVertex2D *out = destination.data();
+    for (std::size_t first = 0; first < m_x.size(); first += 4) {
+        for (int corner : order) {
+            const std::size_t i = first + corner;
+            QVector2D position(m_x[i] * scale, m_y[i] * scale);
+            if (snappingMode == RenderGeometry::VertexSnappingMode::Round) {
+                position = roundVector(position);
+            }
+            out->position = position;
+            out->texcoord = QVector2D(m_u[i], m_v[i]) * textureScale + textureOffset;
+            ++out;
+        }
+    }
+}
+
+} // namespace KWin
@@ -0,0 +1,129 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwineffects.h"
+
+#include <span>
+#include <vector>
+
+namespace KWin
+{
+
+/**
+ * @short Window geometry stored as a structure of arrays.
+ *
+ * A WindowMesh holds the same quads as a WindowQuadList, but the positions and the texture
+ * coordinates of all vertices are kept in separate float arrays. Every four consecutive vertices
+ * form one quad, in clockwise order starting from the top-left corner, like in WindowQuad.
+ *
+ * Effects that deform windows can transform all vertices in one go with the batch methods,
+ * which use SIMD instructions where the CPU supports them, and the mesh can be written into a
+ * vertex buffer without going through WindowQuad and RenderGeometry first.
+ *
+ * @see OffscreenEffect::deform
+ */
+class KWINEFFECTS_EXPORT WindowMesh
+{
+public:
+    WindowMesh();
+    explicit WindowMesh(const WindowQuadList &quads);
+
+    /**
+     * Converts the mesh back to a WindowQuadList, for code that still works with quads.
+     */
+    WindowQuadList toQuadList() const;
+
+    bool isEmpty() const;
+    int quadCount() const;
+    int vertexCount() const;
+    void clear();
+    void reserve(int quadCount);
+
+    void appendQuad(const WindowQuad &quad);
+    /**
+     * Appends an axis aligned quad covering @p position, with the texture coordinates
+     * @p textureCoordinates.
+     */
+    void appendQuad(const QRectF &position, const QRectF &textureCoordinates);
+
+    std::span<float> x();
+    std::span<const float> x() const;
+    std::span<float> y();
+    std::span<const float> y() const;
+    std::span<float> u();
+    std::span<const float> u() const;
+    std::span<float> v();
+    std::span<const float> v() const;
+
+    /**
+     * Returns the bounding rectangle of all vertices.
+     */
+    QRectF bounds() const;
+
+    /**
+     * Splits every quad into cells of at most @p maxQuadSize logical pixels, aligned to a
+     * grid over the bounds of the mesh. This matches WindowQuadList::makeGrid().
+     */
+    WindowMesh makeGrid(int maxQuadSize) const;
+    /**
+     * Splits the bounds of the mesh into @p xSubdivisions times @p ySubdivisions cells and every
+     * quad along them. This matches WindowQuadList::makeRegularGrid().
+     */
+    WindowMesh makeRegularGrid(int xSubdivisions, int ySubdivisions) const;
+
+    void translate(float dx, float dy);
+    /**
+     * Maps the position of every vertex through the affine part of @p transform.
+     */
+    void transform(const QTransform &transform);
+    /**
+     * Maps every vertex onto a bicubic Bezier patch. The position of a vertex is normalized by
+     * @p size, the result is the point of the patch at these parameters. The @p controlPoints
+     * are stored row by row, i.e. the control point in column i and row j is at index i + 4 * j.
+     */
+    void applyBezierPatch(const QSizeF &size, std::span<const QPointF, 16> controlPoints);
+    /**
+     * Calls @p function with references to the x and y coordinates of every vertex. The
+     * function is inlined into a tight loop over the arrays, so the compiler can vectorize it
+     * if the function has no branches that depend on the vertex.
+     */
+    template<typename Function>
+    void warp(Function function);
+
+    /**
+     * Writes the mesh as unindexed triangles to @p destination, which must have room for
+     * six vertices per quad. The positions are converted to device coordinates with
+     * @p deviceScale and snapped according to @p snappingMode, the texture coordinates are
+     * scaled and translated by @p textureMatrix.
+     */
+    void triangulate(std::span<GLVertex2D> destination, qreal deviceScale,
+                     RenderGeometry::VertexSnappingMode snappingMode = RenderGeometry::VertexSnappingMode::Round,
+                     const QMatrix4x4 &textureMatrix = QMatrix4x4()) const;
+
+private:
+    WindowMesh subdivide(double xIncrement, double yIncrement) const;
+    void appendSubQuad(const WindowMesh &source, int quad, double x0, double y0, double x1, double y1);
+
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_u;
+    std::vector<float> m_v;
+};
+
+template<typename Function>
+inline void WindowMesh::warp(Function function)
+{
+    float *x = m_x.data();
+    float *y = m_y.data();
+    const std::size_t count = m_x.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        function(x[i], y[i]);
+    }
+}
+
+} // namespace KWin
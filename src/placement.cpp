@@ -16,6 +16,7 @@
 #include "cursor.h"
 #include "options.h"
 #include "rules.h"
+#include "utils/coveragemap.h"
 #include "virtualdesktops.h"
 #include "workspace.h"
 #include "x11window.h"
@@ -24,6 +25,8 @@
 #include <QTextStream>
 #include <QTimer>
 
+#include <algorithm>
+
 namespace KWin
 {
 
@@ -153,10 +156,46 @@ static inline bool isIrrelevant(const Window *window, const Window *regarding, V
         || window->isDesktop();
 };
 
+Placement::Obstacle Placement::obstacle(Window *window)
+{
+    const int left = window->x();
+    const int top = window->y();
+    const int right = left + window->width();
+    const int bottom = top + window->height();
+
+    int weight;
+    if (window->keepAbove()) {
+        weight = 16;
+    } else if (window->keepBelow() && !window->isDock()) { // ignore KeepBelow windows
+        weight = 0; // for placement (see X11Window::belongsToLayer() for Dock)
+    } else {
+        weight = 1;
+    }
+
+    return Obstacle{window, left, top, right, bottom, weight};
+}
+
+QVector<Placement::Obstacle> Placement::collectObstacles(const Window *regarding, VirtualDesktop *desktop)
+{
+    QVector<Obstacle> obstacles;
+    for (Window *window : workspace()->stackingOrder()) {
+        if (!isIrrelevant(window, regarding, desktop)) {
+            obstacles.append(obstacle(window));
+        }
+    }
+    return obstacles;
+}
+
 /**
  * Place the client \a c according to a really smart placement algorithm :-)
  */
 void Placement::placeSmart(Window *window, const QRectF &area, PlacementPolicy /*next*/)
+{
+    VirtualDesktop *const desktop = window->isOnCurrentDesktop() ? VirtualDesktopManager::self()->currentDesktop() : window->desktops().front();
+    placeSmart(window, area, collectObstacles(window, desktop));
+}
+
+void Placement::placeSmart(Window *window, const QRectF &area, const QVector<Obstacle> &obstacles)
 {
     Q_ASSERT(area.isValid());
 
@@ -174,13 +213,10 @@ void Placement::placeSmart(Window *window, const QRectF &area, PlacementPolicy /
     }
 
     const int none = 0, h_wrong = -1, w_wrong = -2; // overlap types
-    long int overlap, min_overlap = 0;
+    qint64 overlap, min_overlap = 0;
     int x_optimal, y_optimal;
     int possible;
-    VirtualDesktop *const desktop = window->isOnCurrentDesktop() ? VirtualDesktopManager::self()->currentDesktop() : window->desktops().front();
 
-    int cxl, cxr, cyt, cyb; // temp coords
-    int xl, xr, yt, yb; // temp coords
     int basket; // temp holder
 
     // get the maximum allowed windows space
@@ -193,6 +229,20 @@ void Placement::placeSmart(Window *window, const QRectF &area, PlacementPolicy /
     int ch = window->height() - 1;
     int cw = window->width() - 1;
 
+    // The overlap with the other windows is looked up rather than computed for every position.
+    CoverageMap coverage;
+    for (const Obstacle &obstacle : obstacles) {
+        if (obstacle.window != window) {
+            coverage.add(QRect(obstacle.left, obstacle.top, obstacle.right - obstacle.left, obstacle.bottom - obstacle.top), obstacle.weight);
+        }
+    }
+    coverage.build();
+
+    // The positions next to the other windows in the current row, sorted.
+    QVector<int> rowPositions;
+    int rowPositionsY = y;
+    bool rowPositionsValid = false;
+
     bool first_pass = true; // CT lame flag. Don't like it. What else would do?
 
     // loop over possible positions
@@ -203,37 +253,7 @@ void Placement::placeSmart(Window *window, const QRectF &area, PlacementPolicy /
         } else if (x + cw > area.right()) {
             overlap = w_wrong;
         } else {
-            overlap = none; // initialize
-
-            cxl = x;
-            cxr = x + cw;
-            cyt = y;
-            cyb = y + ch;
-            for (auto l = workspace()->stackingOrder().constBegin(); l != workspace()->stackingOrder().constEnd(); ++l) {
-                auto client = *l;
-                if (isIrrelevant(client, window, desktop)) {
-                    continue;
-                }
-                xl = client->x();
-                yt = client->y();
-                xr = xl + client->width();
-                yb = yt + client->height();
-
-                // if windows overlap, calc the overall overlapping
-                if ((cxl < xr) && (cxr > xl) && (cyt < yb) && (cyb > yt)) {
-                    xl = std::max(cxl, xl);
-                    xr = std::min(cxr, xr);
-                    yt = std::max(cyt, yt);
-                    yb = std::min(cyb, yb);
-                    if (client->keepAbove()) {
-                        overlap += 16 * (xr - xl) * (yb - yt);
-                    } else if (client->keepBelow() && !client->isDock()) { // ignore KeepBelow windows
-                        overlap += 0; // for placement (see X11Window::belongsToLayer() for Dock)
-                    } else {
-                        overlap += (xr - xl) * (yb - yt);
-                    }
-                }
-            }
+            overlap = coverage.coverage(QRect(x, y, cw, ch));
         }
 
         // CT first time we get no overlap we stop.
@@ -263,30 +283,27 @@ void Placement::placeSmart(Window *window, const QRectF &area, PlacementPolicy /
             }
 
             // compare to the position of each client on the same desk
-            for (auto l = workspace()->stackingOrder().constBegin(); l != workspace()->stackingOrder().constEnd(); ++l) {
-                auto client = *l;
-                if (isIrrelevant(client, window, desktop)) {
-                    continue;
-                }
-
-                xl = client->x();
-                yt = client->y();
-                xr = xl + client->width();
-                yb = yt + client->height();
-
-                // if not enough room above or under the current tested client
-                // determine the first non-overlapped x position
-                if ((y < yb) && (yt < ch + y)) {
-
-                    if ((xr > x) && (possible > xr)) {
-                        possible = xr;
+            if (!rowPositionsValid || rowPositionsY != y) {
+                rowPositions.clear();
+                for (const Obstacle &obstacle : obstacles) {
+                    if (obstacle.window == window) {
+                        continue;
                     }
-
-                    basket = xl - cw;
-                    if ((basket > x) && (possible > basket)) {
-                        possible = basket;
+                    // if not enough room above or under the current tested client
+                    // determine the first non-overlapped x position
+                    if ((y < obstacle.bottom) && (obstacle.top < ch + y)) {
+                        rowPositions.append(obstacle.right);
+                        rowPositions.append(obstacle.left - cw);
                     }
                 }
+                std::sort(rowPositions.begin(), rowPositions.end());
+                rowPositionsY = y;
+                rowPositionsValid = true;
+            }
+
+            const auto next = std::upper_bound(rowPositions.constBegin(), rowPositions.constEnd(), x);
+            if (next != rowPositions.constEnd() && possible > *next) {
+                possible = *next;
             }
             x = possible;
         }
@@ -301,24 +318,18 @@ void Placement::placeSmart(Window *window, const QRectF &area, PlacementPolicy /
             }
 
             // test the position of each window on the desk
-            for (auto l = workspace()->stackingOrder().constBegin(); l != workspace()->stackingOrder().constEnd(); ++l) {
-                auto client = *l;
-                if (isIrrelevant(client, window, desktop)) {
+            for (const Obstacle &obstacle : obstacles) {
+                if (obstacle.window == window) {
                     continue;
                 }
 
-                xl = client->x();
-                yt = client->y();
-                xr = xl + client->width();
-                yb = yt + client->height();
-
                 // if not enough room to the left or right of the current tested client
                 // determine the first non-overlapped y position
-                if ((yb > y) && (possible > yb)) {
-                    possible = yb;
+                if ((obstacle.bottom > y) && (possible > obstacle.bottom)) {
+                    possible = obstacle.bottom;
                 }
 
-                basket = yt - ch;
+                basket = obstacle.top - ch;
                 if ((basket > y) && (possible > basket)) {
                     possible = basket;
                 }
@@ -596,23 +607,34 @@ void Placement::cascadeIfCovering(Window *window, const QRectF &area)
 
     VirtualDesktop *const desktop = window->isOnCurrentDesktop() ? VirtualDesktopManager::self()->currentDesktop() : window->desktops().front();
 
+    // the other windows, topmost first
+    QVector<QRectF> others;
+    for (auto l = workspace()->stackingOrder().crbegin(); l != workspace()->stackingOrder().crend(); ++l) {
+        if (!isIrrelevant(*l, window, desktop)) {
+            others.append((*l)->frameGeometry());
+        }
+    }
+
     QRectF possibleGeo = window->frameGeometry();
     bool noOverlap = false;
 
+    // only needed once the window has to be cascaded at all
+    CoverageMap coverage;
+    bool coverageBuilt = false;
+
     // cascade until confirmed no total overlap or not enough space to cascade
     while (!noOverlap) {
         noOverlap = true;
+        // nothing under the current position candidate, so nothing that can be covered completely
+        if (coverageBuilt && coverage.coverage(possibleGeo.toAlignedRect()) == 0) {
+            break;
+        }
         // check current position candidate for overlaps with other windows
-        for (auto l = workspace()->stackingOrder().crbegin(); l != workspace()->stackingOrder().crend(); ++l) {
-            auto other = *l;
-            if (isIrrelevant(other, window, desktop)) {
-                continue;
-            }
-
-            if (possibleGeo.contains(other->frameGeometry())) {
+        for (const QRectF &other : std::as_const(others)) {
+            if (possibleGeo.contains(other)) {
                 // placed window would completely overlap the other window: try to cascade it from the topleft of that other window
                 noOverlap = false;
-                possibleGeo.moveTopLeft(other->pos() + offset);
+                possibleGeo.moveTopLeft(other.topLeft() + offset);
                 if (possibleGeo.right() > area.right() || possibleGeo.bottom() > area.bottom()) {
                     // new cascaded geometry would be out of the bounds of the placement area: abort the cascading and keep the window in the original position
                     return;
@@ -620,6 +642,13 @@ void Placement::cascadeIfCovering(Window *window, const QRectF &area)
                 break;
             }
         }
+        if (!noOverlap && !coverageBuilt) {
+            for (const QRectF &other : std::as_const(others)) {
+                coverage.add(other.toAlignedRect());
+            }
+            coverage.build();
+            coverageBuilt = true;
+        }
     }
 
     window->move(possibleGeo.topLeft());
@@ -642,6 +671,9 @@ void Placement::cascadeDesktop()
 
 void Placement::unclutterDesktop()
 {
+    // all the windows are placed on the current desktop, so they have to avoid the same windows
+    QVector<Obstacle> windows = collectObstacles(nullptr, VirtualDesktopManager::self()->currentDesktop());
+
     const auto &clients = Workspace::self()->allClientList();
     for (int i = clients.size() - 1; i >= 0; i--) {
         auto client = clients.at(i);
@@ -649,7 +681,14 @@ void Placement::unclutterDesktop()
             continue;
         }
         const QRect placementArea = workspace()->clientArea(PlacementArea, client).toRect();
-        placeSmart(client, placementArea);
+        placeSmart(client, placementArea, windows);
+
+        auto it = std::find_if(windows.begin(), windows.end(), [client](const Obstacle &obstacle) {
+            return obstacle.window == client;
+        });
+        if (it != windows.end()) {
+            *it = obstacle(client);
+        }
     }
 }
 
@@ -16,12 +16,14 @@
 #include <QList>
 #include <QPoint>
 #include <QRect>
+#include <QVector>
 
 class QObject;
 
 namespace KWin
 {
 
+class VirtualDesktop;
 class Window;
 
 class KWIN_EXPORT Placement
@@ -63,6 +65,23 @@ private:
     void placeUtility(Window *c, const QRect &area, PlacementPolicy next = PlacementUnknown);
     void placeOnScreenDisplay(Window *c, const QRect &area);
 
+    /**
+     * A window that smart placement tries not to cover.
+     */
+    struct Obstacle
+    {
+        Window *window;
+        int left;
+        int top;
+        int right;
+        int bottom;
+        // How much covering a single pixel of the window costs.
+        int weight;
+    };
+    static Obstacle obstacle(Window *window);
+    static QVector<Obstacle> collectObstacles(const Window *regarding, VirtualDesktop *desktop);
+    void placeSmart(Window *window, const QRectF &area, const QVector<Obstacle> &obstacles);
+
     // CT needed for cascading+
     struct DesktopCascadingInfo
     {
@@ -0,0 +1,140 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "qpaintercolortransform.h"
+#include "core/colortransformation.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KWIN_HAVE_AVX2_GATHER 1
+#endif
+
+namespace KWin
+{
+
+QPainterColorTransform::QPainterColorTransform()
+{
+    setTransformation(nullptr);
+}
+
+std::shared_ptr<ColorTransformation> QPainterColorTransform::transformation() const
+{
+    return m_transformation;
+}
+
+void QPainterColorTransform::setTransformation(const std::shared_ptr<ColorTransformation> &transformation)
+{
+    m_transformation = transformation;
+    m_identity = true;
+
+    for (uint32_t value = 0; value < 256; ++value) {
+        uint32_t red = value;
+        uint32_t green = value;
+        uint32_t blue = value;
+        if (transformation && transformation->valid()) {
+            const uint16_t input = value * 0x101;
+            const auto [r, g, b] = transformation->transform(input, input, input);
+            // Round to the nearest 8 bit value.
+            red = (r * 255u + 0x7FFF) / 0xFFFF;
+            green = (g * 255u + 0x7FFF) / 0xFFFF;
+            blue = (b * 255u + 0x7FFF) / 0xFFFF;
+        }
+        m_identity = m_identity && red == value && green == value && blue == value;
+        m_red[value] = red << 16;
+        m_green[value] = green << 8;
+        m_blue[value] = blue;
+    }
+}
+
+bool QPainterColorTransform::isIdentity() const
+{
+    return m_identity;
+}
+
+bool QPainterColorTransform::isFormatSupported(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return true;
+    default:
+        return false;
+    }
+}
+
+#if KWIN_HAVE_AVX2_GATHER
+__attribute__((target("avx2"))) static int applyRowAvx2(const uint32_t *source, uint32_t *target, int count,
+                                                        const uint32_t *red, const uint32_t *green, const uint32_t *blue)
+{
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i alphaMask = _mm256_set1_epi32(0xFF000000);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i));
+        const __m256i r = _mm256_i32gather_epi32(reinterpret_cast<const int *>(red), _mm256_and_si256(_mm256_srli_epi32(pixels, 16), byteMask), 4);
+        const __m256i g = _mm256_i32gather_epi32(reinterpret_cast<const int *>(green), _mm256_and_si256(_mm256_srli_epi32(pixels, 8), byteMask), 4);
+        const __m256i b = _mm256_i32gather_epi32(reinterpret_cast<const int *>(blue), _mm256_and_si256(pixels, byteMask), 4);
+        const __m256i result = _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, _mm256_and_si256(pixels, alphaMask)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(target + i), result);
+    }
+    return i;
+}
+
+static bool hasAvx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+void QPainterColorTransform::applyRow(const uint32_t *source, uint32_t *target, int count) const
+{
+    int i = 0;
+#if KWIN_HAVE_AVX2_GATHER
+    if (hasAvx2()) {
+        i = applyRowAvx2(source, target, count, m_red.data(), m_green.data(), m_blue.data());
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint32_t pixel = source[i];
+        target[i] = (pixel & 0xFF000000)
+            | m_red[(pixel >> 16) & 0xFF]
+            | m_green[(pixel >> 8) & 0xFF]
+            | m_blue[pixel & 0xFF];
+    }
+}
+
+void QPainterColorTransform::apply(const QImage &source, QImage *target, const QRegion &region) const
+{
+    Q_ASSERT(source.size() == target->size());
+    Q_ASSERT(isFormatSupported(source.format()) && isFormatSupported(target->format()));
+
+    const QRect bounds = source.rect();
+    const bool inPlace = source.constBits() == target->constBits();
+    for (const QRect &rect : region) {
+        const QRect clipped = rect.intersected(bounds);
+        if (clipped.isEmpty()) {
+            continue;
+        }
+        for (int y = clipped.top(); y <= clipped.bottom(); ++y) {
+            const uint32_t *sourceRow = reinterpret_cast<const uint32_t *>(source.constScanLine(y)) + clipped.x();
+            uint32_t *targetRow = reinterpret_cast<uint32_t *>(target->scanLine(y)) + clipped.x();
+            if (m_identity) {
+                if (!inPlace) {
+                    std::copy_n(sourceRow, clipped.width(), targetRow);
+                }
+            } else {
+                applyRow(sourceRow, targetRow, clipped.width());
+            }
+        }
+    }
+}
+
+} // namespace KWin
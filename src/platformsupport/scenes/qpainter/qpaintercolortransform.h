@@ -0,0 +1,65 @@
+/*
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+#include <QImage>
+#include <QRegion>
+
+#include <array>
+#include <memory>
+
+namespace KWin
+{
+
+class ColorTransformation;
+
+/**
+ * The QPainterColorTransform class applies a color transformation to a rendered image on the
+ * CPU, for outputs without gamma ramps in hardware.
+ *
+ * The transformation is sampled once into a table per channel, applying it to an image is a
+ * table lookup per channel and pixel, done only for the given region. Images must be in one of
+ * the 32 bit xRGB formats, the alpha or padding byte is passed through unchanged.
+ */
+class KWIN_EXPORT QPainterColorTransform
+{
+public:
+    QPainterColorTransform();
+
+    /**
+     * Samples @a transformation. A @c null transformation resets to the identity.
+     */
+    void setTransformation(const std::shared_ptr<ColorTransformation> &transformation);
+    std::shared_ptr<ColorTransformation> transformation() const;
+
+    /**
+     * Returns @c true if applying the transformation would not change any pixel.
+     */
+    bool isIdentity() const;
+
+    /**
+     * Writes the pixels of @a source inside @a region, in device pixels, to @a target with the
+     * transformation applied. Both images must have the same size, and may be the same image.
+     */
+    void apply(const QImage &source, QImage *target, const QRegion &region) const;
+
+    static bool isFormatSupported(QImage::Format format);
+
+private:
+    void applyRow(const uint32_t *source, uint32_t *target, int count) const;
+
+    std::shared_ptr<ColorTransformation> m_transformation;
+    // The looked up values, already shifted to the position of their channel in the pixel.
+    std::array<uint32_t, 256> m_red;
+    std::array<uint32_t, 256> m_green;
+    std::array<uint32_t, 256> m_blue;
+    bool m_identity = true;
+};
+
+} // namespace KWin
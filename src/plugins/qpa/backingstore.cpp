@@ -28,35 +28,32 @@ BackingStore::~BackingStore() = default;
 
 QPaintDevice *BackingStore::paintDevice()
 {
-    return &m_backBuffer;
+    if (!m_backBuffer) {
+        m_backBuffer = acquireBuffer(QRegion());
+    }
+    return &m_backBuffer->image;
 }
 
 void BackingStore::resize(const QSize &size, const QRegion &staticContents)
 {
-    if (m_backBuffer.size() == size) {
-        return;
-    }
-
     const QPlatformWindow *platformWindow = static_cast<QPlatformWindow *>(window()->handle());
     const qreal devicePixelRatio = platformWindow->devicePixelRatio();
 
-    m_backBuffer = QImage(size * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
-    m_backBuffer.setDevicePixelRatio(devicePixelRatio);
+    if (m_size == size && m_devicePixelRatio == devicePixelRatio) {
+        return;
+    }
 
-    m_frontBuffer = QImage(size * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
-    m_frontBuffer.setDevicePixelRatio(devicePixelRatio);
-}
+    m_size = size;
+    m_devicePixelRatio = devicePixelRatio;
 
-void BackingStore::beginPaint(const QRegion &region)
-{
-    if (m_backBuffer.hasAlphaChannel()) {
-        QPainter p(paintDevice());
-        p.setCompositionMode(QPainter::CompositionMode_Source);
-        const QColor blank = Qt::transparent;
-        for (const QRect &rect : region) {
-            p.fillRect(rect, blank);
-        }
+    // The compositor keeps the buffers it still uses alive.
+    for (Buffer &buffer : m_buffers) {
+        buffer = Buffer();
     }
+    m_backBuffer = nullptr;
+    m_frontBuffer = nullptr;
+    m_backBufferDamage = QRegion();
+    m_damageJournal.clear();
 }
 
 static QRect scaledRect(const QRect &rect, qreal devicePixelRatio)
@@ -73,6 +70,62 @@ static void blitImage(const QImage &source, QImage &target, const QRegion &regio
     }
 }
 
+BackingStore::Buffer *BackingStore::acquireBuffer(const QRegion &paintRegion)
+{
+    // Prefer the buffer that needs the least repair among the ones the compositor doesn't use.
+    Buffer *buffer = nullptr;
+    for (Buffer &candidate : m_buffers) {
+        if (!candidate.image.isNull() && !candidate.image.isDetached()) {
+            continue;
+        }
+        if (!buffer || (candidate.age > 0 && (buffer->age == 0 || candidate.age < buffer->age))) {
+            buffer = &candidate;
+        }
+    }
+    // If every buffer is still in use, painting the oldest one is going to detach it.
+    if (!buffer) {
+        for (Buffer &candidate : m_buffers) {
+            if (!buffer || candidate.age > buffer->age) {
+                buffer = &candidate;
+            }
+        }
+    }
+
+    if (buffer->image.isNull()) {
+        buffer->image = QImage(m_size * m_devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+        buffer->image.setDevicePixelRatio(m_devicePixelRatio);
+        buffer->age = 0;
+    }
+
+    // Bring the buffer up to date with the last presented frame, except for what is about to
+    // be painted anyway.
+    if (m_frontBuffer && m_frontBuffer != buffer) {
+        const QRegion repair = m_damageJournal.accumulate(buffer->age, QRect(QPoint(0, 0), m_size)) - paintRegion;
+        if (!repair.isEmpty()) {
+            blitImage(m_frontBuffer->image, buffer->image, repair);
+        }
+    }
+
+    return buffer;
+}
+
+void BackingStore::beginPaint(const QRegion &region)
+{
+    if (!m_backBuffer) {
+        m_backBuffer = acquireBuffer(region);
+    }
+    m_backBufferDamage += region;
+
+    if (m_backBuffer->image.hasAlphaChannel()) {
+        QPainter p(paintDevice());
+        p.setCompositionMode(QPainter::CompositionMode_Source);
+        const QColor blank = Qt::transparent;
+        for (const QRect &rect : region) {
+            p.fillRect(rect, blank);
+        }
+    }
+}
+
 void BackingStore::flush(QWindow *window, const QRegion &region, const QPoint &offset)
 {
     Window *platformWindow = static_cast<Window *>(window->handle());
@@ -81,9 +134,26 @@ void BackingStore::flush(QWindow *window, const QRegion &region, const QPoint &o
         return;
     }
 
-    blitImage(m_backBuffer, m_frontBuffer, region);
+    const QRegion damage = region | m_backBufferDamage;
+    m_backBufferDamage = QRegion();
+
+    if (m_backBuffer) {
+        for (Buffer &buffer : m_buffers) {
+            if (buffer.age > 0) {
+                buffer.age++;
+            }
+        }
+        m_backBuffer->age = 1;
+        m_damageJournal.add(damage);
+
+        m_frontBuffer = m_backBuffer;
+        m_backBuffer = nullptr;
+    }
+    if (!m_frontBuffer) {
+        return;
+    }
 
-    internalWindow->present(m_frontBuffer, region);
+    internalWindow->present(m_frontBuffer->image, damage);
 }
 
 }
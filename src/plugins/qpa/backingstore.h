@@ -9,15 +9,27 @@
 */
 #pragma once
 
+#include "utils/damagejournal.h"
+
 #include <epoxy/egl.h>
 
 #include <qpa/qplatformbackingstore.h>
 
+#include <array>
+
 namespace KWin
 {
 namespace QPA
 {
 
+/**
+ * The BackingStore class provides the buffers raster windows are painted to.
+ *
+ * The buffers are handed over to the InternalWindow as they are, so there is no copy between
+ * painting and compositing. A buffer that is still used by the compositor is not painted to,
+ * another buffer is used instead, and only the parts that were painted since that buffer was
+ * presented last are copied to it.
+ */
 class BackingStore : public QPlatformBackingStore
 {
 public:
@@ -30,8 +42,22 @@ public:
     void beginPaint(const QRegion &region) override;
 
 private:
-    QImage m_backBuffer;
-    QImage m_frontBuffer;
+    struct Buffer
+    {
+        QImage image;
+        // The number of frames since the buffer was presented, or 0 if its contents are undefined.
+        int age = 0;
+    };
+
+    Buffer *acquireBuffer(const QRegion &paintRegion);
+
+    std::array<Buffer, 3> m_buffers;
+    Buffer *m_backBuffer = nullptr;
+    Buffer *m_frontBuffer = nullptr;
+    QRegion m_backBufferDamage;
+    DamageJournal m_damageJournal;
+    QSize m_size;
+    qreal m_devicePixelRatio = 1;
 };
 
 }
@@ -5,6 +5,9 @@
 */
 
 #include "scene/itemrenderer.h"
+#include "composite.h"
+#include "scene/renderprofiler.h"
+#include "scene/windowitem.h"
 
 #include <QRegion>
 
@@ -32,6 +35,24 @@ void ItemRenderer::endFrame()
 {
 }
 
+RenderProfiler *ItemRenderer::renderProfiler() const
+{
+    Compositor *compositor = Compositor::self();
+    return compositor ? compositor->renderProfiler() : nullptr;
+}
+
+Window *ItemRenderer::profiledWindow(Item *item) const
+{
+    RenderProfiler *profiler = renderProfiler();
+    if (!profiler || !profiler->isEnabled()) {
+        return nullptr;
+    }
+    if (auto windowItem = qobject_cast<WindowItem *>(item)) {
+        return windowItem->window();
+    }
+    return nullptr;
+}
+
 QMatrix4x4 ItemRenderer::renderTargetProjectionMatrix() const
 {
     return m_renderTargetProjectionMatrix;
@@ -17,8 +17,10 @@ namespace KWin
 
 class ImageItem;
 class Item;
+class RenderProfiler;
 class RenderTarget;
 class Scene;
+class Window;
 class WindowPaintData;
 
 class KWIN_EXPORT ItemRenderer
@@ -45,6 +47,13 @@ public:
     virtual ImageItem *createImageItem(Scene *scene, Item *parent = nullptr) = 0;
 
 protected:
+    RenderProfiler *renderProfiler() const;
+    /**
+     * Returns the window that @a item belongs to if render times are being profiled and
+     * @a item is a window item, otherwise @c null.
+     */
+    Window *profiledWindow(Item *item) const;
+
     QMatrix4x4 m_renderTargetProjectionMatrix;
     QRectF m_renderTargetRect;
     qreal m_renderTargetScale = 1;
@@ -5,18 +5,34 @@
 */
 
 #include "scene/itemrenderer_opengl.h"
+#include "kwinglplatform.h"
 #include "platformsupport/scenes/opengl/openglsurfacetexture.h"
 #include "scene/decorationitem.h"
 #include "scene/imageitem.h"
+#include "scene/renderprofiler.h"
 #include "scene/shadowitem.h"
 #include "scene/surfaceitem.h"
 #include "scene/workspacescene_opengl.h"
+#include "window.h"
+
+#include <QVarLengthArray>
 
 namespace KWin
 {
 
 ItemRendererOpenGL::ItemRendererOpenGL()
+    : m_timerQueriesSupported(!GLPlatform::instance()->isGLES() && (hasGLVersion(3, 3) || hasGLExtension(QByteArrayLiteral("GL_ARB_timer_query"))))
+{
+}
+
+ItemRendererOpenGL::~ItemRendererOpenGL()
 {
+    for (const TimerQuery &timerQuery : m_timerQueries) {
+        m_freeTimerQueries.push_back(timerQuery.query);
+    }
+    if (!m_freeTimerQueries.empty()) {
+        glDeleteQueries(m_freeTimerQueries.size(), m_freeTimerQueries.data());
+    }
 }
 
 ImageItem *ItemRendererOpenGL::createImageItem(Scene *scene, Item *parent)
@@ -30,6 +46,53 @@ void ItemRendererOpenGL::beginFrame(RenderTarget *renderTarget)
     GLFramebuffer::pushFramebuffer(fbo);
 
     GLVertexBuffer::streamingBuffer()->beginFrame();
+
+    ++m_frame;
+    if (!m_timerQueries.empty()) {
+        collectTimerQueries();
+    }
+}
+
+void ItemRendererOpenGL::collectTimerQueries()
+{
+    // The queries finish in the order they have been issued. The GPU times of a frame are
+    // reported once all queries of that frame have finished, so they can be added up per window.
+    while (!m_timerQueries.empty()) {
+        const quint64 frame = m_timerQueries.front().frame;
+        const auto frameEnd = std::find_if(m_timerQueries.begin(), m_timerQueries.end(), [frame](const TimerQuery &timerQuery) {
+            return timerQuery.frame != frame;
+        });
+
+        GLint available = 0;
+        glGetQueryObjectiv(std::prev(frameEnd)->query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+
+        QVarLengthArray<std::pair<Window *, std::chrono::nanoseconds>, 16> times;
+        for (auto it = m_timerQueries.begin(); it != frameEnd; ++it) {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(it->query, GL_QUERY_RESULT, &elapsed);
+            m_freeTimerQueries.push_back(it->query);
+            if (!it->window) {
+                continue;
+            }
+            auto time = std::find_if(times.begin(), times.end(), [it](const auto &time) {
+                return time.first == it->window;
+            });
+            if (time != times.end()) {
+                time->second += std::chrono::nanoseconds(elapsed);
+            } else {
+                times.append(std::make_pair(it->window.data(), std::chrono::nanoseconds(elapsed)));
+            }
+        }
+        m_timerQueries.erase(m_timerQueries.begin(), frameEnd);
+
+        RenderProfiler *profiler = renderProfiler();
+        for (const auto &[window, time] : times) {
+            profiler->addWindowRenderTime(window, time);
+        }
+    }
 }
 
 void ItemRendererOpenGL::endFrame()
@@ -253,6 +316,39 @@ void ItemRendererOpenGL::renderItem(Item *item, int mask, const QRegion &region,
         return;
     }
 
+    // Measure how long it takes to build the quads, clip them and upload the contents on the
+    // CPU, and how long the GPU is busy with the window.
+    Window *window = profiledWindow(item);
+    std::chrono::steady_clock::time_point prepareStart;
+    GLuint timerQuery = 0;
+    if (window) {
+        prepareStart = std::chrono::steady_clock::now();
+        if (m_timerQueriesSupported) {
+            if (m_freeTimerQueries.empty()) {
+                glGenQueries(1, &timerQuery);
+            } else {
+                timerQuery = m_freeTimerQueries.back();
+                m_freeTimerQueries.pop_back();
+            }
+            glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+        }
+    }
+    auto finishPrepare = [&]() {
+        if (window) {
+            renderProfiler()->addWindowPrepareTime(window, std::chrono::steady_clock::now() - prepareStart);
+        }
+    };
+    auto finishRender = [&]() {
+        if (timerQuery) {
+            glEndQuery(GL_TIME_ELAPSED);
+            m_timerQueries.push_back(TimerQuery{
+                .query = timerQuery,
+                .window = window,
+                .frame = m_frame,
+            });
+        }
+    };
+
     RenderContext renderContext{
         .clip = region,
         .hardwareClipping = region != infiniteRegion() && ((mask & Scene::PAINT_WINDOW_TRANSFORMED) || (mask & Scene::PAINT_SCREEN_TRANSFORMED)),
@@ -271,6 +367,8 @@ void ItemRendererOpenGL::renderItem(Item *item, int mask, const QRegion &region,
         totalVertexCount += node.geometry.count();
     }
     if (totalVertexCount == 0) {
+        finishPrepare();
+        finishRender();
         return;
     }
 
@@ -311,6 +409,7 @@ void ItemRendererOpenGL::renderItem(Item *item, int mask, const QRegion &region,
     }
 
     vbo->unmap();
+    finishPrepare();
     vbo->bindArrays();
 
     GLShader *shader = data.shader;
@@ -371,6 +470,8 @@ void ItemRendererOpenGL::renderItem(Item *item, int mask, const QRegion &region,
     if (renderContext.hardwareClipping) {
         glDisable(GL_SCISSOR_TEST);
     }
+
+    finishRender();
 }
 
 } // namespace KWin
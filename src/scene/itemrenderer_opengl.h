@@ -10,6 +10,10 @@
 #include "kwinglutils.h"
 #include "scene/itemrenderer.h"
 
+#include <QPointer>
+
+#include <deque>
+
 namespace KWin
 {
 
@@ -40,6 +44,7 @@ public:
     };
 
     ItemRendererOpenGL();
+    ~ItemRendererOpenGL() override;
 
     void beginFrame(RenderTarget *renderTarget) override;
     void endFrame() override;
@@ -53,8 +58,20 @@ private:
     QVector4D modulate(float opacity, float brightness) const;
     void setBlendEnabled(bool enabled);
     void createRenderNode(Item *item, RenderContext *context);
+    void collectTimerQueries();
+
+    struct TimerQuery
+    {
+        GLuint query;
+        QPointer<Window> window;
+        quint64 frame;
+    };
 
     bool m_blendingEnabled = false;
+    const bool m_timerQueriesSupported;
+    std::deque<TimerQuery> m_timerQueries;
+    std::vector<GLuint> m_freeTimerQueries;
+    quint64 m_frame = 0;
 };
 
 } // namespace KWin
@@ -7,6 +7,7 @@
 #include "scene/itemrenderer_qpainter.h"
 #include "platformsupport/scenes/qpainter/qpaintersurfacetexture.h"
 #include "scene/imageitem.h"
+#include "scene/renderprofiler.h"
 #include "scene/workspacescene_qpainter.h"
 
 #include <QPainter>
@@ -43,6 +44,14 @@ void ItemRendererQPainter::beginFrame(RenderTarget *renderTarget)
 void ItemRendererQPainter::endFrame()
 {
     m_painter->end();
+
+    if (!m_renderTimes.isEmpty()) {
+        RenderProfiler *profiler = renderProfiler();
+        for (auto it = m_renderTimes.cbegin(); it != m_renderTimes.cend(); ++it) {
+            profiler->addWindowRenderTime(it.key(), it.value());
+        }
+        m_renderTimes.clear();
+    }
 }
 
 void ItemRendererQPainter::renderBackground(const QRegion &region)
@@ -67,6 +76,13 @@ void ItemRendererQPainter::renderItem(Item *item, int mask, const QRegion &_regi
         return;
     }
 
+    // Everything is done on the CPU, there is nothing to prepare separately.
+    Window *window = profiledWindow(item);
+    std::chrono::steady_clock::time_point renderStart;
+    if (window) {
+        renderStart = std::chrono::steady_clock::now();
+    }
+
     m_painter->save();
     m_painter->setClipRegion(region);
     m_painter->setClipping(true);
@@ -80,6 +96,10 @@ void ItemRendererQPainter::renderItem(Item *item, int mask, const QRegion &_regi
     renderItem(m_painter.get(), item);
 
     m_painter->restore();
+
+    if (window) {
+        m_renderTimes[window] += std::chrono::steady_clock::now() - renderStart;
+    }
 }
 
 void ItemRendererQPainter::renderItem(QPainter *painter, Item *item) const
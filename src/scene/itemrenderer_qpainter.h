@@ -8,6 +8,10 @@
 
 #include "scene/itemrenderer.h"
 
+#include <QHash>
+
+#include <chrono>
+
 class QPainter;
 
 namespace KWin
@@ -39,6 +43,7 @@ private:
     void renderItem(QPainter *painter, Item *item) const;
 
     std::unique_ptr<QPainter> m_painter;
+    QHash<Window *, std::chrono::nanoseconds> m_renderTimes;
 };
 
 } // namespace KWin
@@ -0,0 +1,275 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "scene/latencytracker.h"
+#include "core/renderloop.h"
+#include "scene/surfaceitem_wayland.h"
+#include "utils/common.h"
+#include "wayland/clientconnection.h"
+#include "wayland/subcompositor_interface.h"
+#include "wayland/surface_interface.h"
+#include "wayland_server.h"
+#include "window.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+// A surface is flagged once most of its last s_recentFrames frames missed a vblank, but not
+// before it has presented s_minimumRecentFrames frames.
+static const int s_recentFrames = 120;
+static const int s_minimumRecentFrames = 10;
+
+static std::chrono::nanoseconds now()
+{
+    // The presentation timestamps of the render loops use the monotonic clock as well.
+    return std::chrono::steady_clock::now().time_since_epoch();
+}
+
+QVector<std::chrono::milliseconds> LatencyTracker::bucketBounds()
+{
+    using namespace std::chrono_literals;
+    return {4ms, 8ms, 12ms, 16ms, 20ms, 25ms, 33ms, 50ms, 66ms, 100ms};
+}
+
+void LatencyTracker::Log::add(std::chrono::nanoseconds latency, bool missed)
+{
+    static const QVector<std::chrono::milliseconds> bounds = bucketBounds();
+    if (m_histogram.isEmpty()) {
+        m_histogram.fill(0, bounds.count() + 1);
+    }
+    const auto bucket = std::upper_bound(bounds.cbegin(), bounds.cend(), latency);
+    m_histogram[bucket - bounds.cbegin()]++;
+
+    m_total += latency;
+    m_maximum = std::max(m_maximum, latency);
+    m_frames++;
+    if (missed) {
+        m_missed++;
+    }
+}
+
+LatencyTracker::Statistics LatencyTracker::Log::statistics() const
+{
+    Statistics statistics;
+    statistics.histogram = m_histogram;
+    if (statistics.histogram.isEmpty()) {
+        statistics.histogram.fill(0, bucketBounds().count() + 1);
+    }
+    if (m_frames == 0) {
+        return statistics;
+    }
+    statistics.average = m_total / m_frames;
+    statistics.maximum = m_maximum;
+    statistics.frames = m_frames;
+    statistics.missedVblanks = m_missed;
+    return statistics;
+}
+
+LatencyTracker::LatencyTracker(QObject *parent)
+    : StatisticsCollector(parent)
+{
+}
+
+LatencyTracker::~LatencyTracker()
+{
+}
+
+void LatencyTracker::clear()
+{
+    for (auto it = m_surfaces.keyBegin(); it != m_surfaces.keyEnd(); ++it) {
+        disconnect(*it, nullptr, this, nullptr);
+    }
+    for (auto it = m_clients.keyBegin(); it != m_clients.keyEnd(); ++it) {
+        disconnect(*it, nullptr, this, nullptr);
+    }
+    for (auto it = m_presenting.keyBegin(); it != m_presenting.keyEnd(); ++it) {
+        disconnect(*it, nullptr, this, nullptr);
+    }
+    m_surfaces.clear();
+    m_clients.clear();
+    m_presenting.clear();
+    m_frameSurfaces.clear();
+    m_renderLoop = nullptr;
+}
+
+void LatencyTracker::beginFrame(RenderLoop *renderLoop)
+{
+    m_frameSurfaces.clear();
+    if (!isEnabled()) {
+        return;
+    }
+    m_renderLoop = renderLoop;
+    if (!m_presenting.contains(renderLoop)) {
+        m_presenting.insert(renderLoop, {});
+        connect(renderLoop, &RenderLoop::framePresented, this, &LatencyTracker::handleFramePresented);
+        connect(renderLoop, &QObject::destroyed, this, [this, renderLoop]() {
+            m_presenting.remove(renderLoop);
+        });
+    }
+}
+
+void LatencyTracker::endFrame()
+{
+    if (m_renderLoop) {
+        m_presenting[m_renderLoop].append(m_frameSurfaces);
+        m_renderLoop = nullptr;
+    }
+    m_frameSurfaces.clear();
+}
+
+LatencyTracker::SurfaceEntry *LatencyTracker::surfaceEntry(KWaylandServer::SurfaceInterface *surface)
+{
+    auto it = m_surfaces.find(surface);
+    if (it != m_surfaces.end()) {
+        return &*it;
+    }
+
+    KWaylandServer::ClientConnection *client = surface->client();
+    if (!client) {
+        return nullptr;
+    }
+
+    if (!m_clients.contains(client)) {
+        m_clients.insert(client, ClientEntry{
+                                     .pid = client->processId(),
+                                     .executable = client->executablePath(),
+                                 });
+        connect(client, &KWaylandServer::ClientConnection::aboutToBeDestroyed, this, [this, client]() {
+            m_clients.remove(client);
+            for (auto it = m_surfaces.begin(); it != m_surfaces.end();) {
+                if (it->client == client) {
+                    disconnect(it.key(), nullptr, this, nullptr);
+                    it = m_surfaces.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        });
+    }
+
+    // Subsurfaces are attributed to the window of their main surface.
+    Window *window = waylandServer()->findWindow(surface);
+    if (!window && surface->subSurface()) {
+        window = waylandServer()->findWindow(surface->subSurface()->mainSurface());
+    }
+
+    it = m_surfaces.insert(surface, SurfaceEntry{
+                                        .client = client,
+                                        .caption = window ? window->caption() : QString(),
+                                        .resourceClass = window ? window->resourceClass() : QString(),
+                                    });
+    connect(surface, &KWaylandServer::SurfaceInterface::aboutToBeDestroyed, this, [this, surface]() {
+        m_surfaces.remove(surface);
+    });
+    return &*it;
+}
+
+void LatencyTracker::surfaceCommitted(SurfaceItemWayland *item)
+{
+    if (!isEnabled() || !item->surface()) {
+        return;
+    }
+    if (SurfaceEntry *entry = surfaceEntry(item->surface())) {
+        entry->commitTime = now();
+    }
+}
+
+void LatencyTracker::surfacePainted(SurfaceItem *item)
+{
+    // Screencasts and offscreen textures leave the commit pending for the output frame.
+    if (!m_renderLoop) {
+        return;
+    }
+    auto waylandItem = qobject_cast<SurfaceItemWayland *>(item);
+    if (!waylandItem) {
+        return;
+    }
+    auto it = m_surfaces.find(waylandItem->surface());
+    if (it == m_surfaces.end() || !it->commitTime) {
+        return;
+    }
+    m_frameSurfaces.append(PaintedSurface{
+        .surface = it.key(),
+        .commitTime = *it->commitTime,
+        .paintTime = now(),
+    });
+    it->commitTime.reset();
+}
+
+void LatencyTracker::handleFramePresented(RenderLoop *renderLoop, std::chrono::nanoseconds timestamp)
+{
+    QVector<PaintedSurface> surfaces;
+    std::swap(surfaces, m_presenting[renderLoop]);
+    if (surfaces.isEmpty() || renderLoop->refreshRate() <= 0) {
+        return;
+    }
+
+    const std::chrono::nanoseconds vblankInterval(1'000'000'000'000 / renderLoop->refreshRate());
+    for (const PaintedSurface &painted : std::as_const(surfaces)) {
+        auto it = m_surfaces.find(painted.surface);
+        if (it == m_surfaces.end()) {
+            continue;
+        }
+        SurfaceEntry &entry = *it;
+
+        const std::chrono::nanoseconds latency = std::max(timestamp - painted.commitTime, std::chrono::nanoseconds::zero());
+        const bool missed = latency > vblankInterval;
+        entry.latency.add(latency, missed);
+        entry.paintDelay += painted.paintTime - painted.commitTime;
+        m_clients[entry.client].latency.add(latency, missed);
+
+        if (entry.recentMisses.count() >= s_recentFrames) {
+            entry.recentMissCount -= entry.recentMisses.dequeue();
+        }
+        entry.recentMisses.enqueue(missed);
+        entry.recentMissCount += missed;
+
+        const bool missingVblanks = entry.recentMisses.count() >= s_minimumRecentFrames
+            && entry.recentMissCount * 2 > entry.recentMisses.count();
+        if (entry.missingVblanks != missingVblanks) {
+            entry.missingVblanks = missingVblanks;
+            if (missingVblanks) {
+                qCDebug(KWIN_CORE) << "Surface of" << entry.caption << entry.resourceClass << "keeps missing vblanks";
+            } else {
+                qCDebug(KWIN_CORE) << "Surface of" << entry.caption << entry.resourceClass << "no longer misses vblanks";
+            }
+        }
+    }
+}
+
+QVector<LatencyTracker::ClientStatistics> LatencyTracker::clientStatistics() const
+{
+    QHash<KWaylandServer::ClientConnection *, int> indices;
+    QVector<ClientStatistics> statistics;
+    statistics.reserve(m_clients.count());
+    for (auto it = m_clients.constBegin(); it != m_clients.constEnd(); ++it) {
+        indices.insert(it.key(), statistics.count());
+        statistics.append(ClientStatistics{
+            .pid = it->pid,
+            .executable = it->executable,
+            .latency = it->latency.statistics(),
+        });
+    }
+
+    for (const SurfaceEntry &entry : m_surfaces) {
+        const Statistics latency = entry.latency.statistics();
+        statistics[indices.value(entry.client)].surfaces.append(SurfaceStatistics{
+            .caption = entry.caption,
+            .resourceClass = entry.resourceClass,
+            .latency = latency,
+            .paintDelay = latency.frames ? entry.paintDelay / latency.frames : std::chrono::nanoseconds::zero(),
+            .missingVblanks = entry.missingVblanks,
+        });
+    }
+    return statistics;
+}
+
+} // namespace KWin
@@ -0,0 +1,171 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "scene/statisticscollector.h"
+
+#include <QHash>
+#include <QQueue>
+#include <QVector>
+
+#include <chrono>
+#include <optional>
+
+namespace KWaylandServer
+{
+class ClientConnection;
+class SurfaceInterface;
+}
+
+namespace KWin
+{
+
+class RenderLoop;
+class SurfaceItem;
+class SurfaceItemWayland;
+
+/**
+ * The LatencyTracker class measures how long it takes until the contents committed by Wayland
+ * clients reach the screen.
+ *
+ * The latency of a commit is the time from the moment its state has been applied until the
+ * frame that painted its damage has been presented. If a surface commits several times before
+ * it gets painted, only the latest commit is measured, since that's the one that gets shown.
+ * Contents that are painted outside of an output frame, for example into a screencast, are
+ * not measured, and the commit stays pending until an output frame paints it. A surface that
+ * is shown several times, for example in a window thumbnail, is measured once.
+ *
+ * A frame misses a vblank if it is presented more than one refresh cycle after the commit.
+ * Surfaces that miss vblanks in most of their recent frames are flagged.
+ */
+class KWIN_EXPORT LatencyTracker : public StatisticsCollector
+{
+    Q_OBJECT
+
+public:
+    struct Statistics
+    {
+        std::chrono::nanoseconds average = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds maximum = std::chrono::nanoseconds::zero();
+        int frames = 0;
+        /**
+         * The number of frames that were presented later than one refresh cycle after the commit.
+         */
+        int missedVblanks = 0;
+        /**
+         * The number of frames per latency bucket, the buckets are given by bucketBounds().
+         */
+        QVector<int> histogram;
+    };
+
+    struct SurfaceStatistics
+    {
+        QString caption;
+        QString resourceClass;
+        Statistics latency;
+        /**
+         * The average time from the commit until the compositor painted it.
+         */
+        std::chrono::nanoseconds paintDelay = std::chrono::nanoseconds::zero();
+        /**
+         * Whether most of the recent frames of the surface missed a vblank.
+         */
+        bool missingVblanks = false;
+    };
+
+    struct ClientStatistics
+    {
+        qint64 pid = 0;
+        QString executable;
+        Statistics latency;
+        QVector<SurfaceStatistics> surfaces;
+    };
+
+    explicit LatencyTracker(QObject *parent = nullptr);
+    ~LatencyTracker() override;
+
+    /**
+     * Returns the upper bounds of the histogram buckets. There is one more bucket than bounds,
+     * it holds the frames with a latency of at least the last bound.
+     */
+    static QVector<std::chrono::milliseconds> bucketBounds();
+
+    /**
+     * These functions must be called before starting and after finishing rendering a frame
+     * for @a renderLoop. The surfaces painted in between are presented with that frame.
+     */
+    void beginFrame(RenderLoop *renderLoop);
+    void endFrame();
+
+    /**
+     * Records that the surface of @a item has committed new damage.
+     */
+    void surfaceCommitted(SurfaceItemWayland *item);
+    /**
+     * Records that the damage of @a item has been painted.
+     */
+    void surfacePainted(SurfaceItem *item);
+
+    QVector<ClientStatistics> clientStatistics() const;
+
+private:
+    class Log
+    {
+    public:
+        void add(std::chrono::nanoseconds latency, bool missed);
+        Statistics statistics() const;
+
+    private:
+        std::chrono::nanoseconds m_total = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds m_maximum = std::chrono::nanoseconds::zero();
+        int m_frames = 0;
+        int m_missed = 0;
+        QVector<int> m_histogram;
+    };
+
+    struct ClientEntry
+    {
+        qint64 pid = 0;
+        QString executable;
+        Log latency;
+    };
+
+    struct SurfaceEntry
+    {
+        KWaylandServer::ClientConnection *client = nullptr;
+        QString caption;
+        QString resourceClass;
+        Log latency;
+        std::chrono::nanoseconds paintDelay = std::chrono::nanoseconds::zero();
+        std::optional<std::chrono::nanoseconds> commitTime;
+        QQueue<bool> recentMisses;
+        int recentMissCount = 0;
+        bool missingVblanks = false;
+    };
+
+    struct PaintedSurface
+    {
+        KWaylandServer::SurfaceInterface *surface;
+        std::chrono::nanoseconds commitTime;
+        std::chrono::nanoseconds paintTime;
+    };
+
+    SurfaceEntry *surfaceEntry(KWaylandServer::SurfaceInterface *surface);
+    void handleFramePresented(RenderLoop *renderLoop, std::chrono::nanoseconds timestamp);
+    void clear() override;
+
+    RenderLoop *m_renderLoop = nullptr;
+    QVector<PaintedSurface> m_frameSurfaces;
+    QHash<RenderLoop *, QVector<PaintedSurface>> m_presenting;
+    QHash<KWaylandServer::SurfaceInterface *, SurfaceEntry> m_surfaces;
+    QHash<KWaylandServer::ClientConnection *, ClientEntry> m_clients;
+};
+
+} // namespace KWin
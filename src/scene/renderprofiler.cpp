@@ -0,0 +1,209 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "scene/renderprofiler.h"
+#include "window.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+// The statistics cover about two seconds at 60Hz.
+static const int s_logSize = 120;
+
+void RenderProfiler::Log::add(std::chrono::nanoseconds sample)
+{
+    if (m_samples.count() >= s_logSize) {
+        m_samples.dequeue();
+    }
+    m_samples.enqueue(sample);
+}
+
+RenderProfiler::Statistics RenderProfiler::Log::statistics() const
+{
+    Statistics statistics;
+    if (m_samples.isEmpty()) {
+        return statistics;
+    }
+
+    std::chrono::nanoseconds total = std::chrono::nanoseconds::zero();
+    for (const std::chrono::nanoseconds &sample : m_samples) {
+        total += sample;
+        statistics.maximum = std::max(statistics.maximum, sample);
+    }
+    statistics.average = total / m_samples.count();
+    statistics.frames = m_samples.count();
+    return statistics;
+}
+
+RenderProfiler::RenderProfiler(QObject *parent)
+    : StatisticsCollector(parent)
+{
+}
+
+RenderProfiler::~RenderProfiler()
+{
+}
+
+void RenderProfiler::clear()
+{
+    for (auto it = m_windows.keyBegin(); it != m_windows.keyEnd(); ++it) {
+        disconnect(*it, nullptr, this, nullptr);
+    }
+    m_windows.clear();
+    m_effects.clear();
+    m_frames = Log();
+    m_frameWindows.clear();
+    m_frameEffects.clear();
+    m_scopes.clear();
+}
+
+void RenderProfiler::beginFrame()
+{
+    if (isEnabled()) {
+        m_frameStart = std::chrono::steady_clock::now();
+    }
+    m_frameWindows.clear();
+    m_frameEffects.clear();
+}
+
+void RenderProfiler::endFrame()
+{
+    for (const Window *window : std::as_const(m_frameWindows)) {
+        auto it = m_windows.find(window);
+        if (it != m_windows.end()) {
+            it->prepare.add(it->framePrepare);
+            it->framePrepare = std::chrono::nanoseconds::zero();
+        }
+    }
+    m_frameWindows.clear();
+
+    for (const QString &effect : std::as_const(m_frameEffects)) {
+        EffectEntry &entry = m_effects[effect];
+        entry.time.add(entry.frameTime);
+        entry.frameTime = std::chrono::nanoseconds::zero();
+    }
+    m_frameEffects.clear();
+
+    if (isEnabled() && m_frameStart != std::chrono::steady_clock::time_point()) {
+        const std::chrono::nanoseconds duration = std::chrono::steady_clock::now() - m_frameStart;
+        m_frameStart = std::chrono::steady_clock::time_point();
+        m_frames.add(duration);
+        Q_EMIT frameFinished(duration);
+    }
+}
+
+RenderProfiler::Statistics RenderProfiler::frameStatistics() const
+{
+    return m_frames.statistics();
+}
+
+void RenderProfiler::beginScope()
+{
+    m_scopes.push_back(Scope{
+        .start = std::chrono::steady_clock::now(),
+    });
+}
+
+std::chrono::nanoseconds RenderProfiler::endScope()
+{
+    if (m_scopes.empty()) {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    const Scope scope = m_scopes.back();
+    m_scopes.pop_back();
+
+    const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - scope.start;
+    if (!m_scopes.empty()) {
+        m_scopes.back().nested += elapsed;
+    }
+    return elapsed - scope.nested;
+}
+
+void RenderProfiler::addEffectTime(const QString &effect, std::chrono::nanoseconds time)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    EffectEntry &entry = m_effects[effect];
+    if (entry.frameTime == std::chrono::nanoseconds::zero() && !m_frameEffects.contains(effect)) {
+        m_frameEffects.append(effect);
+    }
+    entry.frameTime += time;
+}
+
+RenderProfiler::WindowEntry &RenderProfiler::windowEntry(Window *window)
+{
+    auto it = m_windows.find(window);
+    if (it == m_windows.end()) {
+        it = m_windows.insert(window, WindowEntry{
+                                          .id = window->internalId(),
+                                          .caption = window->caption(),
+                                          .resourceClass = window->resourceClass(),
+                                      });
+        // Only the address is used after the window is gone.
+        connect(window, &QObject::destroyed, this, [this, window]() {
+            m_windows.remove(window);
+        });
+    }
+    return *it;
+}
+
+void RenderProfiler::addWindowPrepareTime(Window *window, std::chrono::nanoseconds time)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    WindowEntry &entry = windowEntry(window);
+    if (entry.framePrepare == std::chrono::nanoseconds::zero() && !m_frameWindows.contains(window)) {
+        m_frameWindows.append(window);
+    }
+    entry.framePrepare += time;
+}
+
+void RenderProfiler::addWindowRenderTime(Window *window, std::chrono::nanoseconds time)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    windowEntry(window).render.add(time);
+}
+
+QVector<RenderProfiler::WindowStatistics> RenderProfiler::windowStatistics() const
+{
+    QVector<WindowStatistics> statistics;
+    statistics.reserve(m_windows.count());
+    for (const WindowEntry &entry : m_windows) {
+        statistics.append(WindowStatistics{
+            .id = entry.id,
+            .caption = entry.caption,
+            .resourceClass = entry.resourceClass,
+            .prepare = entry.prepare.statistics(),
+            .render = entry.render.statistics(),
+        });
+    }
+    return statistics;
+}
+
+QVector<RenderProfiler::EffectStatistics> RenderProfiler::effectStatistics() const
+{
+    QVector<EffectStatistics> statistics;
+    statistics.reserve(m_effects.count());
+    for (auto it = m_effects.cbegin(); it != m_effects.cend(); ++it) {
+        statistics.append(EffectStatistics{
+            .name = it.key(),
+            .time = it->time.statistics(),
+        });
+    }
+    return statistics;
+}
+
+} // namespace KWin
@@ -0,0 +1,165 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "scene/statisticscollector.h"
+
+#include <QHash>
+#include <QQueue>
+#include <QUuid>
+#include <QVector>
+
+#include <chrono>
+#include <vector>
+
+namespace KWin
+{
+
+class Window;
+
+/**
+ * The RenderProfiler class accounts for the time spent rendering every window and running
+ * every effect, and keeps rolling statistics over the last frames.
+ *
+ * The renderers report how long it takes to prepare a window, that is to build its quads,
+ * to clip them and to upload its contents, and how long it takes to render it. The effects
+ * chain reports the time spent in the paint hooks of every effect, excluding the time spent
+ * in the effects further down the chain and in the scene.
+ *
+ * Nothing is measured while the profiler is disabled, the renderers don't even query the GPU
+ * timers then.
+ */
+class KWIN_EXPORT RenderProfiler : public StatisticsCollector
+{
+    Q_OBJECT
+
+public:
+    struct Statistics
+    {
+        std::chrono::nanoseconds average = std::chrono::nanoseconds::zero();
+        std::chrono::nanoseconds maximum = std::chrono::nanoseconds::zero();
+        /**
+         * The number of frames the statistics are computed from.
+         */
+        int frames = 0;
+    };
+
+    struct WindowStatistics
+    {
+        QUuid id;
+        QString caption;
+        QString resourceClass;
+        /**
+         * The CPU time spent building the quads, clipping them and uploading the contents.
+         */
+        Statistics prepare;
+        /**
+         * The GPU time if timer queries are available, or the CPU time spent painting with
+         * QPainter. Empty if neither can be measured.
+         */
+        Statistics render;
+    };
+
+    struct EffectStatistics
+    {
+        QString name;
+        Statistics time;
+    };
+
+    explicit RenderProfiler(QObject *parent = nullptr);
+    ~RenderProfiler() override;
+
+    /**
+     * These functions must be called before starting and after finishing rendering a frame.
+     * The times reported in between are added up and form one sample per window and effect.
+     */
+    void beginFrame();
+    void endFrame();
+
+    /**
+     * Returns the statistics of the time spent compositing whole frames, from the pre-paint
+     * pass to the post-paint pass.
+     */
+    Statistics frameStatistics() const;
+
+    /**
+     * Starts measuring a nested piece of work, for example an effect hook.
+     */
+    void beginScope();
+    /**
+     * Finishes measuring the piece of work started with the matching beginScope() and returns
+     * the time spent in it, excluding the time spent in the scopes nested in it.
+     */
+    std::chrono::nanoseconds endScope();
+
+    void addEffectTime(const QString &effect, std::chrono::nanoseconds time);
+    void addWindowPrepareTime(Window *window, std::chrono::nanoseconds time);
+    /**
+     * Records the time it took to render @a window in one frame. Unlike the other times, this
+     * one is not added up per frame because GPU timings arrive frames later, so the renderers
+     * have to report the total for the frame, and check that the window still exists.
+     */
+    void addWindowRenderTime(Window *window, std::chrono::nanoseconds time);
+
+    QVector<WindowStatistics> windowStatistics() const;
+    QVector<EffectStatistics> effectStatistics() const;
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when a frame has been composited, while profiling is enabled.
+     */
+    void frameFinished(std::chrono::nanoseconds duration);
+
+private:
+    class Log
+    {
+    public:
+        void add(std::chrono::nanoseconds sample);
+        Statistics statistics() const;
+
+    private:
+        QQueue<std::chrono::nanoseconds> m_samples;
+    };
+
+    struct WindowEntry
+    {
+        QUuid id;
+        QString caption;
+        QString resourceClass;
+        Log prepare;
+        Log render;
+        std::chrono::nanoseconds framePrepare = std::chrono::nanoseconds::zero();
+    };
+
+    struct EffectEntry
+    {
+        Log time;
+        std::chrono::nanoseconds frameTime = std::chrono::nanoseconds::zero();
+    };
+
+    struct Scope
+    {
+        std::chrono::steady_clock::time_point start;
+        std::chrono::nanoseconds nested = std::chrono::nanoseconds::zero();
+    };
+
+    WindowEntry &windowEntry(Window *window);
+    void clear() override;
+
+    std::chrono::steady_clock::time_point m_frameStart;
+    Log m_frames;
+    std::vector<Scope> m_scopes;
+    QHash<const Window *, WindowEntry> m_windows;
+    QHash<QString, EffectEntry> m_effects;
+    QVector<const Window *> m_frameWindows;
+    QVector<QString> m_frameEffects;
+};
+
+} // namespace KWin
@@ -0,0 +1,36 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "scene/statisticscollector.h"
+
+namespace KWin
+{
+
+StatisticsCollector::StatisticsCollector(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StatisticsCollector::~StatisticsCollector()
+{
+}
+
+void StatisticsCollector::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+    m_enabled = enabled;
+    if (!enabled) {
+        clear();
+    }
+    Q_EMIT enabledChanged();
+}
+
+} // namespace KWin
@@ -0,0 +1,53 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+#include <QObject>
+
+namespace KWin
+{
+
+/**
+ * The StatisticsCollector class is the base class for the debugging aids of the compositor
+ * that gather statistics about every frame, such as the RenderProfiler and the LatencyTracker.
+ *
+ * Collectors are disabled by default, because measuring every frame has a cost of its own.
+ * The collected statistics are discarded when a collector gets disabled.
+ */
+class KWIN_EXPORT StatisticsCollector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StatisticsCollector(QObject *parent = nullptr);
+    ~StatisticsCollector() override;
+
+    bool isEnabled() const
+    {
+        return m_enabled;
+    }
+    void setEnabled(bool enabled);
+
+Q_SIGNALS:
+    void enabledChanged();
+
+protected:
+    /**
+     * Discards the collected statistics and stops following the objects they refer to.
+     */
+    virtual void clear() = 0;
+
+private:
+    bool m_enabled = false;
+};
+
+} // namespace KWin
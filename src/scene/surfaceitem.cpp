@@ -5,6 +5,8 @@
 */
 
 #include "scene/surfaceitem.h"
+#include "composite.h"
+#include "scene/latencytracker.h"
 
 namespace KWin
 {
@@ -34,6 +36,11 @@ void SurfaceItem::addDamage(const QRegion &region)
 void SurfaceItem::resetDamage()
 {
     m_damage = QRegion();
+
+    Compositor *compositor = Compositor::self();
+    if (compositor && compositor->latencyTracker()->isEnabled()) {
+        compositor->latencyTracker()->surfacePainted(this);
+    }
 }
 
 QRegion SurfaceItem::damage() const
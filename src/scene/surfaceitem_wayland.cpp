@@ -8,6 +8,7 @@
 #include "composite.h"
 #include "core/renderbackend.h"
 #include "deleted.h"
+#include "scene/latencytracker.h"
 #include "wayland/clientbuffer.h"
 #include "wayland/subcompositor_interface.h"
 #include "wayland/surface_interface.h"
@@ -32,7 +33,7 @@ SurfaceItemWayland::SurfaceItemWayland(KWaylandServer::SurfaceInterface *surface
     connect(surface, &KWaylandServer::SurfaceInterface::committed,
             this, &SurfaceItemWayland::handleSurfaceCommitted);
     connect(surface, &KWaylandServer::SurfaceInterface::damaged,
-            this, &SurfaceItemWayland::addDamage);
+            this, &SurfaceItemWayland::handleSurfaceDamaged);
     connect(surface, &KWaylandServer::SurfaceInterface::childSubSurfaceRemoved,
             this, &SurfaceItemWayland::handleChildSubSurfaceRemoved);
 
@@ -71,6 +72,17 @@ KWaylandServer::SurfaceInterface *SurfaceItemWayland::surface() const
     return m_surface;
 }
 
+void SurfaceItemWayland::handleSurfaceDamaged(const QRegion &region)
+{
+    addDamage(region);
+
+    // The damage is announced while the committed state is applied.
+    Compositor *compositor = Compositor::self();
+    if (compositor && compositor->latencyTracker()->isEnabled()) {
+        compositor->latencyTracker()->surfaceCommitted(this);
+    }
+}
+
 void SurfaceItemWayland::handleSurfaceToBufferMatrixChanged()
 {
     setSurfaceToBufferMatrix(m_surface->surfaceToBufferMatrix());
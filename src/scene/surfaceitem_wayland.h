@@ -39,6 +39,7 @@ public:
 private Q_SLOTS:
     void handleSurfaceToBufferMatrixChanged();
     void handleSurfaceCommitted();
+    void handleSurfaceDamaged(const QRegion &region);
     void handleSurfaceSizeChanged();
 
     void handleChildSubSurfaceRemoved(KWaylandServer::SubSurfaceInterface *child);
@@ -59,6 +59,7 @@
 #include "core/renderloop.h"
 #include "deleted.h"
 #include "effects.h"
+#include "ftrace.h"
 #include "internalwindow.h"
 #include "scene/dndiconitem.h"
 #include "scene/itemrenderer.h"
@@ -183,6 +184,7 @@ SurfaceItem *WorkspaceScene::scanoutCandidate() const
 
 void WorkspaceScene::prePaint(SceneDelegate *delegate)
 {
+    fTraceScope("scene", "prePaint");
     createStackingOrder();
 
     painted_delegate = delegate;
@@ -220,7 +222,10 @@ void WorkspaceScene::prePaint(SceneDelegate *delegate)
     effects->makeOpenGLContextCurrent();
     Q_EMIT preFrameRender();
 
-    effects->prePaintScreen(prePaintData, m_expectedPresentTimestamp);
+    {
+        fTraceScope("effects", "prePaintScreen");
+        effects->prePaintScreen(prePaintData, m_expectedPresentTimestamp);
+    }
     m_paintContext.damage = prePaintData.paint;
     m_paintContext.mask = prePaintData.mask;
     m_paintContext.phase2Data.clear();
@@ -342,11 +347,15 @@ void WorkspaceScene::preparePaintSimpleScreen()
 
 void WorkspaceScene::postPaint()
 {
+    fTraceScope("scene", "postPaint");
     for (WindowItem *w : std::as_const(stacking_order)) {
         effects->postPaintWindow(w->window()->effectWindow());
     }
 
-    effects->postPaintScreen();
+    {
+        fTraceScope("effects", "postPaintScreen");
+        effects->postPaintScreen();
+    }
 
     if (waylandServer()) {
         const std::chrono::milliseconds frameTime =
@@ -375,7 +384,10 @@ void WorkspaceScene::paint(RenderTarget *renderTarget, const QRegion &region)
     m_renderer->beginFrame(renderTarget);
 
     ScreenPaintData data(m_renderer->renderTargetProjectionMatrix(), EffectScreenImpl::get(painted_screen));
-    effects->paintScreen(m_paintContext.mask, region, data);
+    {
+        fTraceScope("effects", "paintScreen");
+        effects->paintScreen(m_paintContext.mask, region, data);
+    }
     m_paintScreenCount = 0;
     Q_EMIT frameRendered();
 
@@ -385,6 +397,7 @@ void WorkspaceScene::paint(RenderTarget *renderTarget, const QRegion &region)
 // the function that'll be eventually called by paintScreen() above
 void WorkspaceScene::finalPaintScreen(int mask, const QRegion &region, ScreenPaintData &data)
 {
+    fTraceScope("scene", "finalPaintScreen");
     m_paintScreenCount++;
     if (mask & (PAINT_SCREEN_TRANSFORMED | PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS)) {
         paintGenericScreen(mask, data);
@@ -47,6 +47,12 @@ WorkspaceSceneOpenGL::WorkspaceSceneOpenGL(OpenGLBackend *backend)
         glGenVertexArrays(1, &vao);
         glBindVertexArray(vao);
     }
+
+    // Compile (or load from the program binary cache) the shaders needed to draw windows now
+    // rather than in the middle of the first frame.
+    if (!qEnvironmentVariableIsSet("KWIN_GL_SHADER_WARMUP") || qEnvironmentVariableIntValue("KWIN_GL_SHADER_WARMUP")) {
+        ShaderManager::instance()->warmUp();
+    }
 }
 
 WorkspaceSceneOpenGL::~WorkspaceSceneOpenGL()
@@ -9,12 +9,15 @@
 */
 
 #include "scriptedeffect.h"
+#include "scripting.h"
 #include "scripting_logging.h"
 #include "scriptingutils.h"
 #include "workspace_wrapper.h"
 
+#include "effects.h"
 #include "input.h"
 #include "screenedge.h"
+#include "window.h"
 #include "workspace.h"
 // KDE
 #include <KConfigGroup>
@@ -153,29 +156,41 @@ static KWin::FPx2 fpx2FromScriptValue(const QJSValue &value)
     return FPx2();
 }
 
-ScriptedEffect *ScriptedEffect::create(const KPluginMetaData &effect)
+QString ScriptedEffect::locateScript(const KPluginMetaData &effect)
 {
-    const QString name = effect.pluginId();
     const QString scriptName = effect.value(QStringLiteral("X-Plasma-MainScript"));
     if (scriptName.isEmpty()) {
+        return QString();
+    }
+    return QStandardPaths::locate(QStandardPaths::GenericDataLocation,
+                                  QLatin1String("kwin/effects/") + effect.pluginId() + QLatin1String("/contents/") + scriptName);
+}
+
+ScriptedEffect *ScriptedEffect::create(const KPluginMetaData &effect)
+{
+    if (effect.value(QStringLiteral("X-Plasma-MainScript")).isEmpty()) {
         qCDebug(KWIN_SCRIPTING) << "X-Plasma-MainScript not set";
         return nullptr;
     }
-    const QString scriptFile = QStandardPaths::locate(QStandardPaths::GenericDataLocation,
-                                                      QLatin1String("kwin/effects/") + name + QLatin1String("/contents/") + scriptName);
+    const QString scriptFile = locateScript(effect);
     if (scriptFile.isNull()) {
         qCDebug(KWIN_SCRIPTING) << "Could not locate the effect script";
         return nullptr;
     }
 
-    return ScriptedEffect::create(name, scriptFile, effect.value(QStringLiteral("X-KDE-Ordering")).toInt(), effect.value(QStringLiteral("X-KWin-Exclusive-Category")));
+    return ScriptedEffect::create(effect, scriptFile, QByteArray());
+}
+
+ScriptedEffect *ScriptedEffect::create(const KPluginMetaData &effect, const QString &pathToScript, const QByteArray &script)
+{
+    return ScriptedEffect::create(effect.pluginId(), pathToScript, effect.value(QStringLiteral("X-KDE-Ordering")).toInt(), effect.value(QStringLiteral("X-KWin-Exclusive-Category")), script);
 }
 
-ScriptedEffect *ScriptedEffect::create(const QString &effectName, const QString &pathToScript, int chainPosition, const QString &exclusiveCategory)
+ScriptedEffect *ScriptedEffect::create(const QString &effectName, const QString &pathToScript, int chainPosition, const QString &exclusiveCategory, const QByteArray &script)
 {
     ScriptedEffect *effect = new ScriptedEffect();
     effect->m_exclusiveCategory = exclusiveCategory;
-    if (!effect->init(effectName, pathToScript)) {
+    if (!effect->init(effectName, pathToScript, script)) {
         delete effect;
         return nullptr;
     }
@@ -209,17 +224,27 @@ ScriptedEffect::ScriptedEffect()
     });
 }
 
-ScriptedEffect::~ScriptedEffect() = default;
+ScriptedEffect::~ScriptedEffect()
+{
+    if (m_windowChangeBatcher) {
+        m_windowChangeBatcher->unsubscribe();
+    }
+}
 
-bool ScriptedEffect::init(const QString &effectName, const QString &pathToScript)
+bool ScriptedEffect::init(const QString &effectName, const QString &pathToScript, const QByteArray &script)
 {
     qRegisterMetaType<QJSValueList>();
     qRegisterMetaType<EffectWindowList>();
 
-    QFile scriptFile(pathToScript);
-    if (!scriptFile.open(QIODevice::ReadOnly)) {
-        qCDebug(KWIN_SCRIPTING) << "Could not open script file: " << pathToScript;
-        return false;
+    // The script may have been read in advance, e.g. in a worker thread.
+    QByteArray source = script;
+    if (source.isEmpty()) {
+        QFile scriptFile(pathToScript);
+        if (!scriptFile.open(QIODevice::ReadOnly)) {
+            qCDebug(KWIN_SCRIPTING) << "Could not open script file: " << pathToScript;
+            return false;
+        }
+        source = scriptFile.readAll();
     }
     m_effectName = effectName;
     m_scriptFile = pathToScript;
@@ -272,6 +297,7 @@ bool ScriptedEffect::init(const QString &effectName, const QString &pathToScript
         QStringLiteral("registerTouchScreenEdge"),
         QStringLiteral("unregisterScreenEdge"),
         QStringLiteral("unregisterTouchScreenEdge"),
+        QStringLiteral("registerWindowChangesCallback"),
 
         QStringLiteral("animate"),
         QStringLiteral("set"),
@@ -288,10 +314,10 @@ bool ScriptedEffect::init(const QString &effectName, const QString &pathToScript
         globalObject.setProperty(propertyName, selfObject.property(propertyName));
     }
 
-    const QJSValue result = m_engine->evaluate(QString::fromUtf8(scriptFile.readAll()));
+    const QJSValue result = m_engine->evaluate(QString::fromUtf8(source));
 
     if (result.isError()) {
-        qCWarning(KWIN_SCRIPTING, "%s:%d: error: %s", qPrintable(scriptFile.fileName()),
+        qCWarning(KWIN_SCRIPTING, "%s:%d: error: %s", qPrintable(pathToScript),
                   result.property(QStringLiteral("lineNumber")).toInt(),
                   qPrintable(result.property(QStringLiteral("message")).toString()));
         return false;
@@ -791,6 +817,49 @@ bool ScriptedEffect::unregisterTouchScreenEdge(int edge)
     return true;
 }
 
+bool ScriptedEffect::registerWindowChangesCallback(const QJSValue &callback)
+{
+    if (!callback.isCallable()) {
+        m_engine->throwError(QStringLiteral("Window changes handler must be callable"));
+        return false;
+    }
+    if (!m_windowChangeBatcher) {
+        m_windowChangeBatcher = Scripting::self()->windowChangeBatcher();
+        m_windowChangeBatcher->subscribe();
+        connect(m_windowChangeBatcher, &ScriptingModels::WindowChangeBatcher::batchReady, this, &ScriptedEffect::handleWindowChangeBatch);
+    }
+    m_windowChangesCallbacks.append(callback);
+    return true;
+}
+
+void ScriptedEffect::handleWindowChangeBatch(const QVector<ScriptingModels::WindowChangeBatcher::WindowChange> &batch)
+{
+    QJSValue changes = m_engine->newArray(batch.count());
+    quint32 count = 0;
+    for (const ScriptingModels::WindowChangeBatcher::WindowChange &change : batch) {
+        if (!change.window || !change.window->effectWindow()) {
+            continue;
+        }
+        QJSValue entry = m_engine->newObject();
+        entry.setProperty(QStringLiteral("window"), m_engine->toScriptValue(static_cast<EffectWindow *>(change.window->effectWindow())));
+        entry.setProperty(QStringLiteral("changes"), int(change.changes));
+        entry.setProperty(QStringLiteral("previousFrameGeometry"), m_engine->toScriptValue(change.previousFrameGeometry));
+        changes.setProperty(count++, entry);
+    }
+    if (!count) {
+        return;
+    }
+    changes.setProperty(QStringLiteral("length"), count);
+
+    for (const QJSValue &callback : std::as_const(m_windowChangesCallbacks)) {
+        const QJSValue result = QJSValue(callback).call({changes});
+        if (result.isError()) {
+            qCWarning(KWIN_SCRIPTING, "%s: error in window changes handler: %s", qPrintable(m_scriptFile),
+                      qPrintable(result.property(QStringLiteral("message")).toString()));
+        }
+    }
+}
+
 QJSEngine *ScriptedEffect::engine() const
 {
     return m_engine;
@@ -10,10 +10,13 @@
 
 #pragma once
 
+#include "scripting/windowchangebatcher.h"
+
 #include <kwinanimationeffect.h>
 
 #include <QJSEngine>
 #include <QJSValue>
+#include <QPointer>
 
 class KConfigLoader;
 class KPluginMetaData;
@@ -75,10 +78,25 @@ public:
     {
         return m_chainPosition;
     }
+    PaintHooks paintHooks() const override
+    {
+        // Scripted effects only paint the windows they animate.
+        return PrePaintScreenHook | PostPaintScreenHook | PrePaintWindowHook | PaintWindowHook | DrawWindowHook | FilterWindows | NotifiesActiveChanged;
+    }
     QString activeConfig() const;
     void setActiveConfig(const QString &name);
-    static ScriptedEffect *create(const QString &effectName, const QString &pathToScript, int chainPosition, const QString &exclusiveCategory);
+    static ScriptedEffect *create(const QString &effectName, const QString &pathToScript, int chainPosition, const QString &exclusiveCategory, const QByteArray &script = QByteArray());
     static ScriptedEffect *create(const KPluginMetaData &effect);
+    /**
+     * Creates the @p effect from the given @p script, which has been read from @p pathToScript
+     * in advance.
+     */
+    static ScriptedEffect *create(const KPluginMetaData &effect, const QString &pathToScript, const QByteArray &script);
+    /**
+     * Returns the path to the main script of the @p effect, or an empty string if there is no
+     * such script. This can be called from any thread.
+     */
+    static QString locateScript(const KPluginMetaData &effect);
     static bool supported();
     ~ScriptedEffect() override;
     /**
@@ -130,6 +148,16 @@ public:
     Q_SCRIPTABLE bool unregisterScreenEdge(int edge);
     Q_SCRIPTABLE bool registerTouchScreenEdge(int edge, const QJSValue &callback);
     Q_SCRIPTABLE bool unregisterTouchScreenEdge(int edge);
+    /**
+     * Registers a @p callback that is invoked at most once per compositor frame with an array of
+     * all windows whose geometry, desktops, output, activities, minimized or fullscreen state
+     * changed since the previous invocation. Each entry has the properties @c window, @c changes
+     * and @c previousFrameGeometry.
+     *
+     * This is cheaper than connecting to the change signals of every window, especially during
+     * interactive move and resize.
+     */
+    Q_SCRIPTABLE bool registerWindowChangesCallback(const QJSValue &callback);
 
     Q_SCRIPTABLE quint64 animate(KWin::EffectWindow *window, Attribute attribute, int ms,
                                  const QJSValue &to, const QJSValue &from = QJSValue(),
@@ -194,7 +222,7 @@ Q_SIGNALS:
 protected:
     ScriptedEffect();
     QJSEngine *engine() const;
-    bool init(const QString &effectName, const QString &pathToScript);
+    bool init(const QString &effectName, const QString &pathToScript, const QByteArray &script = QByteArray());
     void animationEnded(KWin::EffectWindow *w, Attribute a, uint meta) override;
 
 private:
@@ -204,6 +232,7 @@ private:
     };
 
     QJSValue animate_helper(const QJSValue &object, AnimationType animationType);
+    void handleWindowChangeBatch(const QVector<ScriptingModels::WindowChangeBatcher::WindowChange> &batch);
 
     GLShader *findShader(uint shaderId) const;
 
@@ -216,6 +245,8 @@ private:
     KConfigLoader *m_config;
     int m_chainPosition;
     QHash<int, QAction *> m_touchScreenEdgeCallbacks;
+    QJSValueList m_windowChangesCallbacks;
+    QPointer<ScriptingModels::WindowChangeBatcher> m_windowChangeBatcher;
     Effect *m_activeFullScreenEffect = nullptr;
     std::map<uint, std::unique_ptr<GLShader>> m_shaders;
     uint m_nextShaderId{1u};
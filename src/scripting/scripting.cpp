@@ -17,6 +17,8 @@
 #include "screenedgeitem.h"
 #include "scripting_logging.h"
 #include "scriptingutils.h"
+#include "windowchangebatcher.h"
+#include "windowindex.h"
 #include "windowthumbnailitem.h"
 #include "workspace_wrapper.h"
 
@@ -662,6 +664,8 @@ KWin::Scripting::Scripting(QObject *parent)
     , m_scriptsLock(new QRecursiveMutex)
     , m_qmlEngine(new QQmlEngine(this))
     , m_declarativeScriptSharedContext(new QQmlContext(m_qmlEngine, this))
+    , m_windowIndex(new ScriptingModels::WindowIndex(this))
+    , m_windowChangeBatcher(new ScriptingModels::WindowChangeBatcher(this))
     , m_workspaceWrapper(new QtScriptWorkspaceWrapper(this))
 {
     init();
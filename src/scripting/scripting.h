@@ -39,6 +39,12 @@ namespace KWin
 class Window;
 class QtScriptWorkspaceWrapper;
 
+namespace ScriptingModels
+{
+class WindowChangeBatcher;
+class WindowIndex;
+}
+
 class KWIN_EXPORT AbstractScript : public QObject
 {
     Q_OBJECT
@@ -345,6 +351,8 @@ public:
     QQmlContext *declarativeScriptSharedContext() const;
     QQmlContext *declarativeScriptSharedContext();
     QtScriptWorkspaceWrapper *workspaceWrapper() const;
+    ScriptingModels::WindowIndex *windowIndex() const;
+    ScriptingModels::WindowChangeBatcher *windowChangeBatcher() const;
 
     AbstractScript *findScript(const QString &pluginName) const;
 
@@ -364,6 +372,8 @@ private:
     static Scripting *s_self;
     QQmlEngine *m_qmlEngine;
     QQmlContext *m_declarativeScriptSharedContext;
+    ScriptingModels::WindowIndex *m_windowIndex;
+    ScriptingModels::WindowChangeBatcher *m_windowChangeBatcher;
     QtScriptWorkspaceWrapper *m_workspaceWrapper;
 };
 
@@ -392,6 +402,16 @@ inline QtScriptWorkspaceWrapper *Scripting::workspaceWrapper() const
     return m_workspaceWrapper;
 }
 
+inline ScriptingModels::WindowIndex *Scripting::windowIndex() const
+{
+    return m_windowIndex;
+}
+
+inline ScriptingModels::WindowChangeBatcher *Scripting::windowChangeBatcher() const
+{
+    return m_windowChangeBatcher;
+}
+
 inline Scripting *Scripting::self()
 {
     return s_self;
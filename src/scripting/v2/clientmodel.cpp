@@ -14,6 +14,8 @@
 #include "activities.h"
 #endif
 #include "core/output.h"
+#include "scripting/scripting.h"
+#include "scripting/windowindex.h"
 #include "virtualdesktops.h"
 #include "window.h"
 #include "workspace.h"
@@ -36,8 +38,10 @@ ClientLevel::ClientLevel(ClientModel *model, AbstractLevel *parent)
     }
 #endif
     connect(VirtualDesktopManager::self(), &VirtualDesktopManager::currentChanged, this, &ClientLevel::reInit);
-    connect(Workspace::self(), &Workspace::windowAdded, this, &ClientLevel::clientAdded);
-    connect(Workspace::self(), &Workspace::windowRemoved, this, &ClientLevel::clientRemoved);
+    WindowIndex *index = Scripting::self()->windowIndex();
+    connect(index, &WindowIndex::windowAdded, this, &ClientLevel::clientAdded);
+    connect(index, &WindowIndex::windowRemoved, this, &ClientLevel::clientRemoved);
+    connect(index, &WindowIndex::windowChanged, this, &ClientLevel::checkClient);
     connect(model, &ClientModel::exclusionsChanged, this, &ClientLevel::reInit);
 }
 
@@ -47,7 +51,6 @@ ClientLevel::~ClientLevel()
 
 void ClientLevel::clientAdded(Window *client)
 {
-    setupClientConnections(client);
     checkClient(client);
 }
 
@@ -56,16 +59,23 @@ void ClientLevel::clientRemoved(Window *client)
     removeClient(client);
 }
 
-void ClientLevel::setupClientConnections(Window *client)
+QList<Window *> ClientLevel::candidates() const
 {
-    auto check = [this, client] {
-        checkClient(client);
-    };
-    connect(client, &Window::desktopChanged, this, check);
-    connect(client, &Window::screenChanged, this, check);
-    connect(client, &Window::activitiesChanged, this, check);
-    connect(client, &Window::windowHidden, this, check);
-    connect(client, &Window::windowShown, this, check);
+    // The windows of this level are always a subset of the matching bucket of the window index,
+    // an unresolved desktop or screen simply widens the candidates to all windows.
+    VirtualDesktop *desktop = nullptr;
+    Output *output = nullptr;
+    QString activity;
+    if (restrictions() & ClientModel::VirtualDesktopRestriction) {
+        desktop = VirtualDesktopManager::self()->desktopForX11Id(virtualDesktop());
+    }
+    if (restrictions() & ClientModel::ScreenRestriction) {
+        output = workspace()->outputs().value(screen());
+    }
+    if (restrictions() & ClientModel::ActivityRestriction) {
+        activity = AbstractLevel::activity();
+    }
+    return Scripting::self()->windowIndex()->windows(desktop, output, activity);
 }
 
 void ClientLevel::checkClient(Window *client)
@@ -173,44 +183,45 @@ void ClientLevel::addClient(Window *client)
         return;
     }
     Q_EMIT beginInsert(m_clients.count(), m_clients.count(), id());
-    m_clients.insert(nextId(), client);
+    const quint32 clientId = nextId();
+    m_clients.insert(clientId, client);
+    m_clientIds.insert(client, clientId);
     Q_EMIT endInsert();
 }
 
 void ClientLevel::removeClient(Window *client)
 {
-    int index = 0;
-    auto it = m_clients.begin();
-    for (; it != m_clients.end(); ++it, ++index) {
-        if (it.value() == client) {
-            break;
-        }
-    }
-    if (it == m_clients.end()) {
+    const auto idIt = m_clientIds.constFind(client);
+    if (idIt == m_clientIds.constEnd()) {
         return;
     }
+    const auto it = m_clients.find(idIt.value());
+    const int index = std::distance(m_clients.begin(), it);
     Q_EMIT beginRemove(index, index, id());
     m_clients.erase(it);
+    m_clientIds.erase(idIt);
     Q_EMIT endRemove();
 }
 
 void ClientLevel::init()
 {
-    const QList<Window *> &clients = workspace()->allClientList();
-    for (auto it = clients.begin(); it != clients.end(); ++it) {
-        Window *client = *it;
-        setupClientConnections(client);
+    const QList<Window *> clients = candidates();
+    for (Window *client : clients) {
         if (!exclude(client) && shouldAdd(client)) {
-            m_clients.insert(nextId(), client);
+            const quint32 clientId = nextId();
+            m_clients.insert(clientId, client);
+            m_clientIds.insert(client, clientId);
         }
     }
 }
 
 void ClientLevel::reInit()
 {
-    const QList<Window *> &clients = workspace()->allClientList();
-    for (auto it = clients.begin(); it != clients.end(); ++it) {
-        checkClient((*it));
+    // Windows outside of the candidates can't be part of this level, so there is no need to
+    // look at any other window.
+    const QList<Window *> clients = candidates();
+    for (Window *client : clients) {
+        checkClient(client);
     }
 }
 
@@ -255,14 +266,7 @@ Window *ClientLevel::clientForId(quint32 child) const
 
 bool ClientLevel::containsClient(Window *client) const
 {
-    for (auto it = m_clients.constBegin();
-         it != m_clients.constEnd();
-         ++it) {
-        if (it.value() == client) {
-            return true;
-        }
-    }
-    return false;
+    return m_clientIds.contains(client);
 }
 
 const AbstractLevel *ClientLevel::levelForId(quint32 id) const
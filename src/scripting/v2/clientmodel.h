@@ -9,6 +9,7 @@
 #pragma once
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QList>
 #include <QSortFilterProxyModel>
 
@@ -226,18 +227,18 @@ public Q_SLOTS:
     void clientAdded(KWin::Window *client);
     void clientRemoved(KWin::Window *client);
 private Q_SLOTS:
-    // uses sender()
     void reInit();
 
 private:
     void checkClient(KWin::Window *client);
-    void setupClientConnections(Window *client);
     void addClient(Window *client);
     void removeClient(Window *client);
     bool shouldAdd(Window *client) const;
     bool exclude(Window *client) const;
     bool containsClient(Window *client) const;
+    QList<Window *> candidates() const;
     QMap<quint32, Window *> m_clients;
+    QHash<Window *, quint32> m_clientIds;
 };
 
 class SimpleClientModel : public ClientModel
@@ -7,6 +7,7 @@
 #include "clientmodel.h"
 #include "core/output.h"
 #include "core/outputbackend.h"
+#include "scripting/scripting.h"
 #include "virtualdesktops.h"
 #include "window.h"
 #include "workspace.h"
@@ -17,32 +18,35 @@ namespace KWin::ScriptingModels::V3
 ClientModel::ClientModel(QObject *parent)
     : QAbstractListModel(parent)
 {
-    connect(workspace(), &Workspace::windowAdded, this, &ClientModel::handleClientAdded);
-    connect(workspace(), &Workspace::windowRemoved, this, &ClientModel::handleClientRemoved);
+    WindowIndex *index = Scripting::self()->windowIndex();
+    connect(index, &WindowIndex::windowAdded, this, &ClientModel::handleClientAdded);
+    connect(index, &WindowIndex::windowRemoved, this, &ClientModel::handleClientRemoved);
+    connect(index, &WindowIndex::windowChanged, this, &ClientModel::handleClientChanged);
 
-    m_clients = workspace()->allClientList();
-    for (Window *client : std::as_const(m_clients)) {
-        setupClientConnections(client);
-    }
+    m_clients = index->windows();
 }
 
-void ClientModel::markRoleChanged(Window *client, int role)
+void ClientModel::markRoleChanged(Window *client, const QList<int> &roles)
 {
     const QModelIndex row = index(m_clients.indexOf(client), 0);
-    Q_EMIT dataChanged(row, row, {role});
+    Q_EMIT dataChanged(row, row, roles);
 }
 
-void ClientModel::setupClientConnections(Window *client)
+void ClientModel::handleClientChanged(Window *client, WindowIndex::Changes changes)
 {
-    connect(client, &Window::desktopChanged, this, [this, client]() {
-        markRoleChanged(client, DesktopRole);
-    });
-    connect(client, &Window::screenChanged, this, [this, client]() {
-        markRoleChanged(client, ScreenRole);
-    });
-    connect(client, &Window::activitiesChanged, this, [this, client]() {
-        markRoleChanged(client, ActivityRole);
-    });
+    QList<int> roles;
+    if (changes & WindowIndex::DesktopChange) {
+        roles.append(DesktopRole);
+    }
+    if (changes & WindowIndex::ScreenChange) {
+        roles.append(ScreenRole);
+    }
+    if (changes & WindowIndex::ActivityChange) {
+        roles.append(ActivityRole);
+    }
+    if (!roles.isEmpty()) {
+        markRoleChanged(client, roles);
+    }
 }
 
 void ClientModel::handleClientAdded(Window *client)
@@ -50,8 +54,6 @@ void ClientModel::handleClientAdded(Window *client)
     beginInsertRows(QModelIndex(), m_clients.count(), m_clients.count());
     m_clients.append(client);
     endInsertRows();
-
-    setupClientConnections(client);
 }
 
 void ClientModel::handleClientRemoved(Window *client)
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "scripting/windowindex.h"
 #include "virtualdesktops.h"
 
 #include <QAbstractListModel>
@@ -41,11 +42,11 @@ public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
 private:
-    void markRoleChanged(Window *client, int role);
+    void markRoleChanged(Window *client, const QList<int> &roles);
 
     void handleClientAdded(Window *client);
     void handleClientRemoved(Window *client);
-    void setupClientConnections(Window *client);
+    void handleClientChanged(Window *client, WindowIndex::Changes changes);
 
     QList<Window *> m_clients;
 };
@@ -0,0 +1,192 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "windowchangebatcher.h"
+#include "composite.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace KWin::ScriptingModels
+{
+
+// Upper bound for the delivery of a batch if no frame gets scheduled, e.g. without compositing.
+static const int s_fallbackInterval = 16;
+
+WindowChangeBatcher::WindowChangeBatcher(QObject *parent)
+    : QObject(parent)
+{
+    m_fallbackTimer.setSingleShot(true);
+    m_fallbackTimer.setInterval(s_fallbackInterval);
+    connect(&m_fallbackTimer, &QTimer::timeout, this, &WindowChangeBatcher::flush);
+}
+
+WindowChangeBatcher::~WindowChangeBatcher()
+{
+}
+
+void WindowChangeBatcher::subscribe()
+{
+    if (m_subscribers++ == 0) {
+        start();
+    }
+}
+
+void WindowChangeBatcher::unsubscribe()
+{
+    Q_ASSERT(m_subscribers > 0);
+    if (--m_subscribers == 0) {
+        stop();
+    }
+}
+
+bool WindowChangeBatcher::isActive() const
+{
+    return m_subscribers > 0;
+}
+
+WindowChangeBatcher::Statistics WindowChangeBatcher::statistics() const
+{
+    return m_statistics;
+}
+
+void WindowChangeBatcher::resetStatistics()
+{
+    m_statistics = Statistics();
+}
+
+void WindowChangeBatcher::start()
+{
+    connect(workspace(), &Workspace::windowAdded, this, &WindowChangeBatcher::track);
+    connect(workspace(), &Workspace::windowRemoved, this, &WindowChangeBatcher::untrack);
+    connectCompositor();
+
+    const QList<Window *> windows = workspace()->allClientList();
+    for (Window *window : windows) {
+        track(window);
+    }
+}
+
+void WindowChangeBatcher::stop()
+{
+    flush();
+
+    disconnect(workspace(), nullptr, this, nullptr);
+    if (m_compositor) {
+        disconnect(m_compositor, nullptr, this, nullptr);
+        m_compositor.clear();
+    }
+    const QList<Window *> windows = workspace()->allClientList();
+    for (Window *window : windows) {
+        disconnect(window, nullptr, this, nullptr);
+    }
+}
+
+void WindowChangeBatcher::connectCompositor()
+{
+    // The compositor may not exist yet when the first consumer subscribes, in which case this
+    // is tried again with the next recorded change.
+    Compositor *compositor = Compositor::self();
+    if (!compositor || compositor == m_compositor) {
+        return;
+    }
+    m_compositor = compositor;
+    connect(compositor, &Compositor::aboutToComposite, this, &WindowChangeBatcher::flush);
+    connect(compositor, &Compositor::compositingToggled, this, &WindowChangeBatcher::flush);
+}
+
+void WindowChangeBatcher::track(Window *window)
+{
+    connect(window, &Window::frameGeometryChanged, this, [this, window](Window *, const QRectF &oldGeometry) {
+        record(window, FrameGeometryChange, oldGeometry);
+    });
+    connect(window, &Window::desktopChanged, this, [this, window]() {
+        record(window, DesktopChange);
+    });
+    connect(window, &Window::screenChanged, this, [this, window]() {
+        record(window, OutputChange);
+    });
+    connect(window, &Window::activitiesChanged, this, [this, window]() {
+        record(window, ActivityChange);
+    });
+    connect(window, &Window::minimizedChanged, this, [this, window]() {
+        record(window, MinimizedChange);
+    });
+    connect(window, &Window::fullScreenChanged, this, [this, window]() {
+        record(window, FullScreenChange);
+    });
+}
+
+void WindowChangeBatcher::untrack(Window *window)
+{
+    disconnect(window, nullptr, this, nullptr);
+
+    // The pending entry is kept to avoid shifting the indices of the other entries, but the
+    // removed window must not be delivered, it's still alive at this point.
+    const auto it = m_pendingIndex.constFind(window);
+    if (it != m_pendingIndex.constEnd()) {
+        m_pending[it.value()].window.clear();
+        m_pendingIndex.erase(it);
+    }
+}
+
+void WindowChangeBatcher::record(Window *window, Change change, const QRectF &previousFrameGeometry)
+{
+    ++m_statistics.notifications;
+
+    auto it = m_pendingIndex.constFind(window);
+    if (it != m_pendingIndex.constEnd()) {
+        WindowChange &entry = m_pending[it.value()];
+        if (change == FrameGeometryChange && !(entry.changes & FrameGeometryChange)) {
+            entry.previousFrameGeometry = previousFrameGeometry;
+        }
+        entry.changes |= change;
+        return;
+    }
+
+    m_pendingIndex.insert(window, m_pending.count());
+    m_pending.append(WindowChange{
+        .window = window,
+        .changes = change,
+        .previousFrameGeometry = previousFrameGeometry,
+    });
+
+    if (!m_fallbackTimer.isActive()) {
+        connectCompositor();
+        m_fallbackTimer.start();
+    }
+}
+
+void WindowChangeBatcher::flush()
+{
+    m_fallbackTimer.stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    QVector<WindowChange> batch = std::exchange(m_pending, {});
+    m_pendingIndex.clear();
+
+    batch.erase(std::remove_if(batch.begin(), batch.end(), [](const WindowChange &change) {
+                    return !change.window;
+                }),
+                batch.end());
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    ++m_statistics.batches;
+    m_statistics.entries += batch.count();
+
+    Q_EMIT batchReady(batch);
+}
+
+} // namespace KWin::ScriptingModels
@@ -0,0 +1,129 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwin_export.h>
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QRectF>
+#include <QTimer>
+#include <QVector>
+
+namespace KWin
+{
+class Compositor;
+class Window;
+
+namespace ScriptingModels
+{
+
+/**
+ * @brief Coalesces per-window property change notifications into one batch per frame.
+ *
+ * During an interactive move or resize a window emits geometry change signals for every
+ * pointer motion event. Consumers that only care about the final state in a frame, such as
+ * scripts and scripted effects, can subscribe to the batcher instead and receive at most one
+ * batch per compositor frame, with one entry per changed window.
+ *
+ * The batcher is opt-in: it only tracks windows while there is at least one subscriber. A batch
+ * is delivered right before the compositor starts painting the next frame on any output, so
+ * that the consumers can still update the scene for that frame, or after a short timeout if
+ * nothing gets painted, e.g. when compositing is disabled. The pending changes are also delivered
+ * when compositing is toggled. Windows that are removed before the batch is delivered are left out.
+ */
+class KWIN_EXPORT WindowChangeBatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Change {
+        NoChange = 0,
+        FrameGeometryChange = 1 << 0,
+        DesktopChange = 1 << 1,
+        OutputChange = 1 << 2,
+        ActivityChange = 1 << 3,
+        MinimizedChange = 1 << 4,
+        FullScreenChange = 1 << 5,
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
+    Q_FLAG(Changes)
+
+    struct WindowChange
+    {
+        QPointer<Window> window;
+        Changes changes;
+        /**
+         * The frame geometry at the beginning of the batch, only valid if the batch contains
+         * a FrameGeometryChange.
+         */
+        QRectF previousFrameGeometry;
+    };
+
+    struct Statistics
+    {
+        /**
+         * The number of individual change notifications received from windows.
+         */
+        quint64 notifications = 0;
+        /**
+         * The number of delivered batches.
+         */
+        quint64 batches = 0;
+        /**
+         * The number of window entries in all delivered batches.
+         */
+        quint64 entries = 0;
+    };
+
+    explicit WindowChangeBatcher(QObject *parent = nullptr);
+    ~WindowChangeBatcher() override;
+
+    /**
+     * Registers a consumer of the batches. Windows are only tracked while there is at least
+     * one subscriber.
+     */
+    void subscribe();
+    void unsubscribe();
+    bool isActive() const;
+
+    /**
+     * Delivers the pending changes immediately.
+     */
+    void flush();
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+Q_SIGNALS:
+    void batchReady(const QVector<KWin::ScriptingModels::WindowChangeBatcher::WindowChange> &batch);
+
+private:
+    void start();
+    void stop();
+    void connectCompositor();
+    void track(Window *window);
+    void untrack(Window *window);
+    void record(Window *window, Change change, const QRectF &previousFrameGeometry = QRectF());
+
+    int m_subscribers = 0;
+    QVector<WindowChange> m_pending;
+    QHash<Window *, int> m_pendingIndex;
+    QTimer m_fallbackTimer;
+    QPointer<Compositor> m_compositor;
+    Statistics m_statistics;
+};
+
+} // namespace ScriptingModels
+} // namespace KWin
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWin::ScriptingModels::WindowChangeBatcher::Changes)
+Q_DECLARE_METATYPE(KWin::ScriptingModels::WindowChangeBatcher::WindowChange)
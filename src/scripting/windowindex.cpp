@@ -0,0 +1,239 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "windowindex.h"
+#include "window.h"
+#include "workspace.h"
+
+namespace KWin::ScriptingModels
+{
+
+WindowIndex::WindowIndex(QObject *parent)
+    : QObject(parent)
+{
+    connect(workspace(), &Workspace::windowAdded, this, &WindowIndex::handleWindowAdded);
+    connect(workspace(), &Workspace::windowRemoved, this, &WindowIndex::handleWindowRemoved);
+
+    const QList<Window *> clients = workspace()->allClientList();
+    for (Window *window : clients) {
+        handleWindowAdded(window);
+    }
+}
+
+WindowIndex::~WindowIndex()
+{
+}
+
+const QList<Window *> &WindowIndex::windows() const
+{
+    return m_windows;
+}
+
+QList<Window *> WindowIndex::windows(VirtualDesktop *desktop, Output *output, const QString &activity) const
+{
+    // Start from the smallest bucket of the restricted dimensions, and filter the remaining
+    // dimensions using the cached entries.
+    const QVector<Window *> *primary = nullptr;
+    const QVector<Window *> *everywhere = nullptr;
+    static const QVector<Window *> empty;
+
+    auto consider = [&primary, &everywhere](const QVector<Window *> *bucket, const QVector<Window *> *all) {
+        const qsizetype size = bucket->size() + (all ? all->size() : 0);
+        const qsizetype best = primary ? primary->size() + (everywhere ? everywhere->size() : 0) : -1;
+        if (best == -1 || size < best) {
+            primary = bucket;
+            everywhere = all;
+        }
+    };
+
+    if (desktop) {
+        auto it = m_desktopBuckets.constFind(desktop);
+        auto allIt = m_desktopBuckets.constFind(nullptr);
+        consider(it != m_desktopBuckets.constEnd() ? &it.value() : &empty,
+                 allIt != m_desktopBuckets.constEnd() ? &allIt.value() : nullptr);
+    }
+    if (output) {
+        auto it = m_outputBuckets.constFind(output);
+        consider(it != m_outputBuckets.constEnd() ? &it.value() : &empty, nullptr);
+    }
+    if (!activity.isEmpty()) {
+        auto it = m_activityBuckets.constFind(activity);
+        auto allIt = m_activityBuckets.constFind(QString());
+        consider(it != m_activityBuckets.constEnd() ? &it.value() : &empty,
+                 allIt != m_activityBuckets.constEnd() ? &allIt.value() : nullptr);
+    }
+
+    if (!primary) {
+        return m_windows;
+    }
+
+    QList<Window *> result;
+    result.reserve(primary->size() + (everywhere ? everywhere->size() : 0));
+    for (const QVector<Window *> *bucket : {primary, everywhere}) {
+        if (!bucket) {
+            continue;
+        }
+        for (Window *window : *bucket) {
+            if (matches(m_entries.value(window), desktop, output, activity)) {
+                result.append(window);
+            }
+        }
+    }
+    return result;
+}
+
+bool WindowIndex::contains(Window *window) const
+{
+    return m_entries.contains(window);
+}
+
+int WindowIndex::count() const
+{
+    return m_windows.count();
+}
+
+bool WindowIndex::matches(const Entry &entry, VirtualDesktop *desktop, Output *output, const QString &activity)
+{
+    if (desktop && !entry.desktops.isEmpty() && !entry.desktops.contains(desktop)) {
+        return false;
+    }
+    if (output && entry.output != output) {
+        return false;
+    }
+    if (!activity.isEmpty() && !entry.activities.isEmpty() && !entry.activities.contains(activity)) {
+        return false;
+    }
+    return true;
+}
+
+WindowIndex::Entry WindowIndex::makeEntry(Window *window)
+{
+    return Entry{
+        .desktops = window->desktops(),
+        .output = window->output(),
+        .activities = window->activities(),
+    };
+}
+
+void WindowIndex::insertIntoBuckets(Window *window, const Entry &entry)
+{
+    if (entry.desktops.isEmpty()) {
+        m_desktopBuckets[nullptr].append(window);
+    } else {
+        for (VirtualDesktop *desktop : entry.desktops) {
+            m_desktopBuckets[desktop].append(window);
+        }
+    }
+
+    m_outputBuckets[entry.output].append(window);
+
+    if (entry.activities.isEmpty()) {
+        m_activityBuckets[QString()].append(window);
+    } else {
+        for (const QString &activity : entry.activities) {
+            m_activityBuckets[activity].append(window);
+        }
+    }
+}
+
+void WindowIndex::removeFromBuckets(Window *window, const Entry &entry)
+{
+    auto take = [window](auto &buckets, const auto &key) {
+        auto it = buckets.find(key);
+        if (it == buckets.end()) {
+            return;
+        }
+        it->removeOne(window);
+        if (it->isEmpty()) {
+            buckets.erase(it);
+        }
+    };
+
+    if (entry.desktops.isEmpty()) {
+        take(m_desktopBuckets, nullptr);
+    } else {
+        for (VirtualDesktop *desktop : entry.desktops) {
+            take(m_desktopBuckets, desktop);
+        }
+    }
+
+    take(m_outputBuckets, entry.output);
+
+    if (entry.activities.isEmpty()) {
+        take(m_activityBuckets, QString());
+    } else {
+        for (const QString &activity : entry.activities) {
+            take(m_activityBuckets, activity);
+        }
+    }
+}
+
+void WindowIndex::handleWindowAdded(Window *window)
+{
+    if (m_entries.contains(window)) {
+        return;
+    }
+
+    const Entry entry = makeEntry(window);
+    m_entries.insert(window, entry);
+    m_windows.append(window);
+    insertIntoBuckets(window, entry);
+
+    connect(window, &Window::desktopChanged, this, [this, window]() {
+        handleWindowChanged(window, DesktopChange);
+    });
+    connect(window, &Window::screenChanged, this, [this, window]() {
+        handleWindowChanged(window, ScreenChange);
+    });
+    connect(window, &Window::activitiesChanged, this, [this, window]() {
+        handleWindowChanged(window, ActivityChange);
+    });
+    connect(window, &Window::windowHidden, this, [this, window]() {
+        handleWindowChanged(window, VisibilityChange);
+    });
+    connect(window, &Window::windowShown, this, [this, window]() {
+        handleWindowChanged(window, VisibilityChange);
+    });
+
+    Q_EMIT windowAdded(window);
+}
+
+void WindowIndex::handleWindowRemoved(Window *window)
+{
+    auto it = m_entries.find(window);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    disconnect(window, nullptr, this, nullptr);
+    removeFromBuckets(window, *it);
+    m_entries.erase(it);
+    m_windows.removeOne(window);
+
+    Q_EMIT windowRemoved(window);
+}
+
+void WindowIndex::handleWindowChanged(Window *window, Changes changes)
+{
+    auto it = m_entries.find(window);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    if (changes & (DesktopChange | ScreenChange | ActivityChange)) {
+        const Entry entry = makeEntry(window);
+        removeFromBuckets(window, *it);
+        insertIntoBuckets(window, entry);
+        *it = entry;
+    }
+
+    Q_EMIT windowChanged(window, changes);
+}
+
+} // namespace KWin::ScriptingModels
@@ -0,0 +1,105 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwin_export.h>
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+namespace KWin
+{
+class Output;
+class VirtualDesktop;
+class Window;
+
+namespace ScriptingModels
+{
+
+/**
+ * @brief Flat index of all client windows shared by the scripting window models.
+ *
+ * The index keeps exactly one set of connections per window and buckets every window by the
+ * virtual desktops, output and activities it is on. The buckets are updated incrementally when
+ * a window changes its placement, so the models never have to rescan the full window list to
+ * find the windows that belong to a desktop, screen or activity.
+ *
+ * Windows that are on all desktops or on all activities are kept in a separate bucket and are
+ * part of every query result for that dimension.
+ */
+class KWIN_EXPORT WindowIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Change {
+        NoChange = 0,
+        DesktopChange = 1 << 0,
+        ScreenChange = 1 << 1,
+        ActivityChange = 1 << 2,
+        VisibilityChange = 1 << 3,
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
+
+    explicit WindowIndex(QObject *parent = nullptr);
+    ~WindowIndex() override;
+
+    /**
+     * Returns all indexed windows in the order they were added.
+     */
+    const QList<Window *> &windows() const;
+
+    /**
+     * Returns the windows that are on the given @p desktop, @p output and @p activity. A
+     * @c null desktop or output, or an empty activity, matches every window.
+     */
+    QList<Window *> windows(VirtualDesktop *desktop, Output *output, const QString &activity) const;
+
+    bool contains(Window *window) const;
+    int count() const;
+
+Q_SIGNALS:
+    void windowAdded(KWin::Window *window);
+    void windowRemoved(KWin::Window *window);
+    /**
+     * Emitted once per change of the placement or the visibility of the @p window, after the
+     * buckets have been updated.
+     */
+    void windowChanged(KWin::Window *window, KWin::ScriptingModels::WindowIndex::Changes changes);
+
+private:
+    struct Entry
+    {
+        QVector<VirtualDesktop *> desktops;
+        Output *output = nullptr;
+        QStringList activities;
+    };
+
+    void handleWindowAdded(Window *window);
+    void handleWindowRemoved(Window *window);
+    void handleWindowChanged(Window *window, Changes changes);
+    void insertIntoBuckets(Window *window, const Entry &entry);
+    void removeFromBuckets(Window *window, const Entry &entry);
+    static Entry makeEntry(Window *window);
+    static bool matches(const Entry &entry, VirtualDesktop *desktop, Output *output, const QString &activity);
+
+    QList<Window *> m_windows;
+    QHash<Window *, Entry> m_entries;
+    // A nullptr desktop key and an empty activity key hold the windows on all desktops/activities.
+    QHash<VirtualDesktop *, QVector<Window *>> m_desktopBuckets;
+    QHash<Output *, QVector<Window *>> m_outputBuckets;
+    QHash<QString, QVector<Window *>> m_activityBuckets;
+};
+
+} // namespace ScriptingModels
+} // namespace KWin
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWin::ScriptingModels::WindowIndex::Changes)
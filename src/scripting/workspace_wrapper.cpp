@@ -13,6 +13,7 @@
 #include "core/outputbackend.h"
 #include "cursor.h"
 #include "outline.h"
+#include "scripting/scripting.h"
 #include "tiles/tilemanager.h"
 #include "virtualdesktops.h"
 #include "workspace.h"
@@ -72,6 +73,61 @@ WorkspaceWrapper::WorkspaceWrapper(QObject *parent)
     }
 }
 
+WorkspaceWrapper::~WorkspaceWrapper()
+{
+    if (m_windowChangeBatcher) {
+        for (; m_windowChangeBatchConnections > 0; --m_windowChangeBatchConnections) {
+            m_windowChangeBatcher->unsubscribe();
+        }
+    }
+}
+
+void WorkspaceWrapper::connectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&WorkspaceWrapper::windowChangesBatched)) {
+        if (!m_windowChangeBatchConnections) {
+            m_windowChangeBatcher = Scripting::self()->windowChangeBatcher();
+            connect(m_windowChangeBatcher, &ScriptingModels::WindowChangeBatcher::batchReady, this, &WorkspaceWrapper::handleWindowChangeBatch);
+        }
+        ++m_windowChangeBatchConnections;
+        m_windowChangeBatcher->subscribe();
+    }
+    QObject::connectNotify(signal);
+}
+
+void WorkspaceWrapper::disconnectNotify(const QMetaMethod &signal)
+{
+    if (signal == QMetaMethod::fromSignal(&WorkspaceWrapper::windowChangesBatched)) {
+        Q_ASSERT(m_windowChangeBatchConnections > 0);
+        if (m_windowChangeBatcher) {
+            m_windowChangeBatcher->unsubscribe();
+            if (!--m_windowChangeBatchConnections) {
+                disconnect(m_windowChangeBatcher, nullptr, this, nullptr);
+            }
+        }
+    }
+    QObject::disconnectNotify(signal);
+}
+
+void WorkspaceWrapper::handleWindowChangeBatch(const QVector<ScriptingModels::WindowChangeBatcher::WindowChange> &batch)
+{
+    QVariantList changes;
+    changes.reserve(batch.count());
+    for (const ScriptingModels::WindowChangeBatcher::WindowChange &change : batch) {
+        if (!change.window) {
+            continue;
+        }
+        changes.append(QVariantMap{
+            {QStringLiteral("window"), QVariant::fromValue(change.window.data())},
+            {QStringLiteral("changes"), int(change.changes)},
+            {QStringLiteral("previousFrameGeometry"), change.previousFrameGeometry},
+        });
+    }
+    if (!changes.isEmpty()) {
+        Q_EMIT windowChangesBatched(changes);
+    }
+}
+
 int WorkspaceWrapper::currentDesktop() const
 {
     return VirtualDesktopManager::self()->current();
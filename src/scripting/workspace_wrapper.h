@@ -10,7 +10,10 @@
 
 #pragma once
 
+#include "scripting/windowchangebatcher.h"
+
 #include <QObject>
+#include <QPointer>
 #include <QQmlListProperty>
 #include <QRect>
 #include <QSize>
@@ -175,6 +178,17 @@ Q_SIGNALS:
      * @see cursorPos()
      */
     void cursorPosChanged();
+    /**
+     * This signal is emitted at most once per compositor frame with all the windows whose
+     * geometry, desktops, output, activities, minimized or fullscreen state changed since the
+     * previous emission. Each entry of @p changes is an object with the properties @c window,
+     * @c changes (a combination of the WindowChange flags) and @c previousFrameGeometry.
+     *
+     * Connecting to this signal is cheaper than connecting to the change signals of every
+     * window, in particular during interactive move and resize. Change tracking only happens
+     * while something is connected to it.
+     */
+    void windowChangesBatched(const QVariantList &changes);
 
 public:
     //------------------------------------------------------------------
@@ -212,9 +226,22 @@ public:
         ElectricNone
     };
     Q_ENUM(ElectricBorder)
+    enum WindowChange {
+        FrameGeometryChange = 1 << 0,
+        DesktopChange = 1 << 1,
+        OutputChange = 1 << 2,
+        ActivityChange = 1 << 3,
+        MinimizedChange = 1 << 4,
+        FullScreenChange = 1 << 5,
+    };
+    Q_ENUM(WindowChange)
 
 protected:
     explicit WorkspaceWrapper(QObject *parent = nullptr);
+    ~WorkspaceWrapper() override;
+
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
 
 public:
 #define GETTERSETTERDEF(rettype, getter, setter) \
@@ -446,6 +473,12 @@ public Q_SLOTS:
 
 private Q_SLOTS:
     void setupClientConnections(Window *client);
+
+private:
+    void handleWindowChangeBatch(const QVector<ScriptingModels::WindowChangeBatcher::WindowChange> &batch);
+
+    QPointer<ScriptingModels::WindowChangeBatcher> m_windowChangeBatcher;
+    int m_windowChangeBatchConnections = 0;
 };
 
 class QtScriptWorkspaceWrapper : public WorkspaceWrapper
@@ -0,0 +1,160 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "snapedgeindex.h"
+#include "window.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+SnapEdgeIndex::SnapEdgeIndex(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void SnapEdgeIndex::add(Window *window)
+{
+    if (m_entries.contains(window)) {
+        return;
+    }
+    const Entry entry{
+        .serial = m_nextSerial++,
+        .geometry = window->frameGeometry(),
+        .desktops = window->desktops(),
+    };
+    m_entries.insert(window, entry);
+    insertEdges(window, entry);
+
+    connect(window, &Window::frameGeometryChanged, this, &SnapEdgeIndex::update);
+    connect(window, &Window::desktopChanged, this, [this, window]() {
+        update(window);
+    });
+}
+
+void SnapEdgeIndex::remove(Window *window)
+{
+    const auto it = m_entries.find(window);
+    if (it == m_entries.end()) {
+        return;
+    }
+    removeEdges(window, *it);
+    m_entries.erase(it);
+    disconnect(window, nullptr, this, nullptr);
+}
+
+void SnapEdgeIndex::update(Window *window)
+{
+    const auto it = m_entries.find(window);
+    if (it == m_entries.end()) {
+        return;
+    }
+    const QRectF geometry = window->frameGeometry();
+    const QVector<VirtualDesktop *> desktops = window->desktops();
+    if (it->geometry == geometry && it->desktops == desktops) {
+        return;
+    }
+    removeEdges(window, *it);
+    it->geometry = geometry;
+    it->desktops = desktops;
+    insertEdges(window, *it);
+}
+
+void SnapEdgeIndex::insertEdges(Window *window, const Entry &entry)
+{
+    const auto insert = [&](VirtualDesktop *desktop) {
+        Bucket &bucket = m_buckets[desktop];
+        bucket.verticalEdges.insert(Edge{entry.geometry.left(), entry.serial, window});
+        bucket.verticalEdges.insert(Edge{entry.geometry.right(), entry.serial, window});
+        bucket.horizontalEdges.insert(Edge{entry.geometry.top(), entry.serial, window});
+        bucket.horizontalEdges.insert(Edge{entry.geometry.bottom(), entry.serial, window});
+    };
+    if (entry.desktops.isEmpty()) {
+        insert(nullptr);
+    } else {
+        for (VirtualDesktop *desktop : entry.desktops) {
+            insert(desktop);
+        }
+    }
+}
+
+void SnapEdgeIndex::removeEdges(Window *window, const Entry &entry)
+{
+    const auto erase = [&](std::multiset<Edge> &edges, qreal position) {
+        auto [begin, end] = edges.equal_range(Edge{position, entry.serial, window});
+        if (begin != end) {
+            edges.erase(begin);
+        }
+    };
+    const auto remove = [&](VirtualDesktop *desktop) {
+        const auto it = m_buckets.find(desktop);
+        if (it == m_buckets.end()) {
+            return;
+        }
+        erase(it->verticalEdges, entry.geometry.left());
+        erase(it->verticalEdges, entry.geometry.right());
+        erase(it->horizontalEdges, entry.geometry.top());
+        erase(it->horizontalEdges, entry.geometry.bottom());
+        if (it->verticalEdges.empty()) {
+            m_buckets.erase(it);
+        }
+    };
+    if (entry.desktops.isEmpty()) {
+        remove(nullptr);
+    } else {
+        for (VirtualDesktop *desktop : entry.desktops) {
+            remove(desktop);
+        }
+    }
+}
+
+QVector<Window *> SnapEdgeIndex::windowsNear(VirtualDesktop *desktop, std::span<const qreal> xs, std::span<const qreal> ys, qreal distance) const
+{
+    std::vector<const Edge *> matches;
+
+    const auto collect = [&](const std::multiset<Edge> &edges, std::span<const qreal> positions) {
+        for (qreal position : positions) {
+            const auto begin = edges.lower_bound(Edge{position - distance, 0, nullptr});
+            for (auto it = begin; it != edges.end() && it->position <= position + distance; ++it) {
+                matches.push_back(&*it);
+            }
+        }
+    };
+    const auto collectBucket = [&](VirtualDesktop *desktop) {
+        const auto it = m_buckets.constFind(desktop);
+        if (it != m_buckets.constEnd()) {
+            collect(it->verticalEdges, xs);
+            collect(it->horizontalEdges, ys);
+        }
+    };
+    collectBucket(desktop);
+    if (desktop) {
+        collectBucket(nullptr);
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const Edge *a, const Edge *b) {
+        return a->serial < b->serial;
+    });
+
+    QVector<Window *> windows;
+    windows.reserve(matches.size());
+    for (const Edge *edge : matches) {
+        if (windows.isEmpty() || windows.constLast() != edge->window) {
+            windows.append(edge->window);
+        }
+    }
+    return windows;
+}
+
+int SnapEdgeIndex::count() const
+{
+    return m_entries.count();
+}
+
+} // namespace KWin
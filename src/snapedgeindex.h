@@ -0,0 +1,91 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <kwinglobals.h>
+
+#include <QHash>
+#include <QObject>
+#include <QRectF>
+#include <QVector>
+
+#include <set>
+#include <span>
+
+namespace KWin
+{
+
+class VirtualDesktop;
+class Window;
+
+/**
+ * The SnapEdgeIndex class keeps the edges of the managed windows sorted by position, per virtual
+ * desktop, so the windows that a moved or resized window can snap to are found without looking
+ * at every window.
+ *
+ * The index is updated when a window is moved, resized or sent to another virtual desktop. It
+ * doesn't know about minimized, hidden or special windows, snapping still has to filter those.
+ */
+class KWIN_EXPORT SnapEdgeIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SnapEdgeIndex(QObject *parent = nullptr);
+
+    void add(Window *window);
+    void remove(Window *window);
+
+    /**
+     * Returns the windows on @p desktop that have a left or right edge at most @p distance away
+     * from any of @p xs, or a top or bottom edge at most @p distance away from any of @p ys.
+     *
+     * Windows on all desktops are included. The windows are returned in the order they were
+     * added to the index.
+     */
+    QVector<Window *> windowsNear(VirtualDesktop *desktop, std::span<const qreal> xs, std::span<const qreal> ys, qreal distance) const;
+
+    int count() const;
+
+private:
+    struct Edge
+    {
+        qreal position;
+        quint64 serial;
+        Window *window;
+
+        bool operator<(const Edge &other) const
+        {
+            return position < other.position || (position == other.position && serial < other.serial);
+        }
+    };
+
+    struct Bucket
+    {
+        std::multiset<Edge> verticalEdges;
+        std::multiset<Edge> horizontalEdges;
+    };
+
+    struct Entry
+    {
+        quint64 serial;
+        QRectF geometry;
+        QVector<VirtualDesktop *> desktops;
+    };
+
+    void update(Window *window);
+    void insertEdges(Window *window, const Entry &entry);
+    void removeEdges(Window *window, const Entry &entry);
+
+    QHash<Window *, Entry> m_entries;
+    // Windows on all desktops are kept in the bucket for the null desktop.
+    QHash<VirtualDesktop *, Bucket> m_buckets;
+    quint64 m_nextSerial = 0;
+};
+
+} // namespace KWin
@@ -0,0 +1,149 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "utils/coveragemap.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+void CoverageMap::add(const QRect &rect, qint64 weight)
+{
+    m_items.append(Item{rect, weight});
+}
+
+void CoverageMap::clear()
+{
+    m_items.clear();
+    m_columns.clear();
+    m_rows.clear();
+    m_table.clear();
+}
+
+static void sortEdges(QVector<int> &edges)
+{
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+}
+
+static int edgeIndex(const QVector<int> &edges, int edge)
+{
+    return std::lower_bound(edges.constBegin(), edges.constEnd(), edge) - edges.constBegin();
+}
+
+void CoverageMap::build()
+{
+    m_columns.clear();
+    m_rows.clear();
+    m_table.clear();
+
+    for (const Item &item : std::as_const(m_items)) {
+        if (item.weight == 0 || item.rect.width() <= 0 || item.rect.height() <= 0) {
+            continue;
+        }
+        m_columns.append(item.rect.x());
+        m_columns.append(item.rect.x() + item.rect.width());
+        m_rows.append(item.rect.y());
+        m_rows.append(item.rect.y() + item.rect.height());
+    }
+    if (m_columns.isEmpty()) {
+        return;
+    }
+    sortEdges(m_columns);
+    sortEdges(m_rows);
+
+    const int columnCount = m_columns.size();
+    const int rowCount = m_rows.size();
+
+    // Mark the corners of every rectangle, the prefix sums of the marks are the weights of
+    // the grid cells.
+    QVector<qint64> cells(columnCount * rowCount, 0);
+    for (const Item &item : std::as_const(m_items)) {
+        if (item.weight == 0 || item.rect.width() <= 0 || item.rect.height() <= 0) {
+            continue;
+        }
+        const int left = edgeIndex(m_columns, item.rect.x());
+        const int right = edgeIndex(m_columns, item.rect.x() + item.rect.width());
+        const int top = edgeIndex(m_rows, item.rect.y());
+        const int bottom = edgeIndex(m_rows, item.rect.y() + item.rect.height());
+        cells[top * columnCount + left] += item.weight;
+        cells[top * columnCount + right] -= item.weight;
+        cells[bottom * columnCount + left] -= item.weight;
+        cells[bottom * columnCount + right] += item.weight;
+    }
+    for (int row = 0; row < rowCount; ++row) {
+        for (int column = 0; column < columnCount; ++column) {
+            qint64 &cell = cells[row * columnCount + column];
+            if (column > 0) {
+                cell += cells[row * columnCount + column - 1];
+            }
+            if (row > 0) {
+                cell += cells[(row - 1) * columnCount + column];
+            }
+            if (row > 0 && column > 0) {
+                cell -= cells[(row - 1) * columnCount + column - 1];
+            }
+        }
+    }
+
+    m_table.fill(0, columnCount * rowCount);
+    for (int row = 1; row < rowCount; ++row) {
+        const qint64 height = m_rows[row] - m_rows[row - 1];
+        for (int column = 1; column < columnCount; ++column) {
+            const qint64 width = m_columns[column] - m_columns[column - 1];
+            m_table[row * columnCount + column] = m_table[(row - 1) * columnCount + column]
+                + m_table[row * columnCount + column - 1]
+                - m_table[(row - 1) * columnCount + column - 1]
+                + cells[(row - 1) * columnCount + column - 1] * width * height;
+        }
+    }
+}
+
+qint64 CoverageMap::integral(int x, int y) const
+{
+    if (m_table.isEmpty() || x <= m_columns.constFirst() || y <= m_rows.constFirst()) {
+        return 0;
+    }
+
+    const int columnCount = m_columns.size();
+    const int rowCount = m_rows.size();
+    const int column = std::upper_bound(m_columns.constBegin(), m_columns.constEnd(), x) - m_columns.constBegin() - 1;
+    const int row = std::upper_bound(m_rows.constBegin(), m_rows.constEnd(), y) - m_rows.constBegin() - 1;
+
+    // Past the last edge nothing is covered anymore.
+    const int nextColumn = std::min(column + 1, columnCount - 1);
+    const int nextRow = std::min(row + 1, rowCount - 1);
+    const qint64 dx = nextColumn != column ? x - m_columns[column] : 0;
+    const qint64 dy = nextRow != row ? y - m_rows[row] : 0;
+    const qint64 width = nextColumn != column ? m_columns[nextColumn] - m_columns[column] : 1;
+    const qint64 height = nextRow != row ? m_rows[nextRow] - m_rows[row] : 1;
+
+    // The weight is constant within a grid cell, so the table can be interpolated bilinearly
+    // between the grid points without losing any precision.
+    const qint64 topLeft = m_table[row * columnCount + column];
+    const qint64 topRight = m_table[row * columnCount + nextColumn];
+    const qint64 bottomLeft = m_table[nextRow * columnCount + column];
+    const qint64 bottomRight = m_table[nextRow * columnCount + nextColumn];
+    return topLeft
+        + dx * ((topRight - topLeft) / width)
+        + dy * ((bottomLeft - topLeft) / height)
+        + dx * dy * ((bottomRight - topRight - bottomLeft + topLeft) / (width * height));
+}
+
+qint64 CoverageMap::coverage(const QRect &rect) const
+{
+    const int left = rect.x();
+    const int top = rect.y();
+    const int right = rect.x() + rect.width();
+    const int bottom = rect.y() + rect.height();
+    return integral(right, bottom) - integral(left, bottom) - integral(right, top) + integral(left, top);
+}
+
+} // namespace KWin
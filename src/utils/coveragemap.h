@@ -0,0 +1,71 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+#include <QRect>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * The CoverageMap class tells how much of a rectangle is covered by a set of weighted
+ * rectangles, for example how much a window placed somewhere would overlap other windows.
+ *
+ * The rectangles are rasterized into a grid made of their edges, and a summed-area table
+ * is built for that grid. Afterwards, the coverage of any rectangle can be looked up without
+ * looking at the individual rectangles again. The results are exact.
+ *
+ * Unlike QRect::right() and QRect::bottom(), a rectangle spans from x() to x() + width()
+ * and from y() to y() + height() here.
+ */
+class KWIN_EXPORT CoverageMap
+{
+public:
+    /**
+     * Adds @a rect with the given @a weight. The map has to be built again afterwards.
+     */
+    void add(const QRect &rect, qint64 weight = 1);
+
+    /**
+     * Removes all rectangles.
+     */
+    void clear();
+
+    /**
+     * Builds the summed-area table for the rectangles that have been added so far.
+     */
+    void build();
+
+    /**
+     * Returns the sum of the areas of all rectangles within @a rect, each multiplied by the
+     * weight of the rectangle.
+     */
+    qint64 coverage(const QRect &rect) const;
+
+private:
+    qint64 integral(int x, int y) const;
+
+    struct Item
+    {
+        QRect rect;
+        qint64 weight;
+    };
+
+    QVector<Item> m_items;
+    QVector<int> m_columns;
+    QVector<int> m_rows;
+    // The coverage from the top-left corner of the grid to each grid point, row by row.
+    QVector<qint64> m_table;
+};
+
+} // namespace KWin
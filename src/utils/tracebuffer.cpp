@@ -0,0 +1,104 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "tracebuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace KWin
+{
+
+void TraceEvent::setName(const char *text, qsizetype length)
+{
+    const qsizetype count = std::min<qsizetype>(length, sizeof(name) - 1);
+    memcpy(name, text, count);
+    name[count] = '\0';
+}
+
+static quint64 roundUpToPowerOfTwo(quint64 value)
+{
+    quint64 result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+TraceBuffer::TraceBuffer(int capacity, int threadId, const QByteArray &threadName)
+    : m_threadId(threadId)
+    , m_threadName(threadName)
+    , m_mask(roundUpToPowerOfTwo(std::max(capacity, 2)) - 1)
+    , m_events(new TraceEvent[m_mask + 1])
+{
+}
+
+int TraceBuffer::threadId() const
+{
+    return m_threadId;
+}
+
+QByteArray TraceBuffer::threadName() const
+{
+    return m_threadName;
+}
+
+int TraceBuffer::capacity() const
+{
+    return m_mask + 1;
+}
+
+void TraceBuffer::push(const TraceEvent &event)
+{
+    // Works like a seqlock, the consumer can tell which of the events it copied may have been
+    // overwritten in the meantime by the claimed index.
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    m_claimed.store(head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_events[head & m_mask] = event;
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+void TraceBuffer::take(std::vector<TraceEvent> &events)
+{
+    const quint64 capacity = m_mask + 1;
+    const quint64 tail = m_tail.load(std::memory_order_relaxed);
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    quint64 first = std::max(tail, head > capacity ? head - capacity : 0);
+
+    const size_t offset = events.size();
+    events.reserve(offset + (head - first));
+    for (quint64 i = first; i != head; ++i) {
+        events.push_back(m_events[i & m_mask]);
+    }
+
+    // Discard the events that the producer has started to overwrite while they were copied.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const quint64 claimed = m_claimed.load(std::memory_order_relaxed);
+    if (claimed > first + capacity) {
+        const quint64 overwritten = std::min(claimed - capacity, head) - first;
+        events.erase(events.begin() + offset, events.begin() + offset + overwritten);
+        first += overwritten;
+    }
+
+    m_dropped.fetch_add(first - tail, std::memory_order_relaxed);
+    m_tail.store(head, std::memory_order_relaxed);
+}
+
+quint64 TraceBuffer::droppedCount() const
+{
+    // Also count the events that have been overwritten since the last call to take().
+    const quint64 capacity = m_mask + 1;
+    const quint64 tail = m_tail.load(std::memory_order_relaxed);
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    const quint64 pending = head > tail + capacity ? head - capacity - tail : 0;
+    return m_dropped.load(std::memory_order_relaxed) + pending;
+}
+
+} // namespace KWin
@@ -0,0 +1,107 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+#include <QByteArray>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace KWin
+{
+
+/**
+ * A binary trace event, as recorded by the FTraceLogger.
+ */
+struct TraceEvent
+{
+    enum class Type : quint8 {
+        Begin,
+        End,
+        Instant,
+        Counter,
+        FlowBegin,
+        FlowEnd,
+    };
+
+    /**
+     * The CLOCK_MONOTONIC time of the event, in nanoseconds.
+     */
+    qint64 timestamp;
+    /**
+     * The value of a counter, the id of a flow or the context of a begin/end pair.
+     */
+    qint64 value;
+    /**
+     * The category must be a string literal, only the pointer is recorded.
+     */
+    const char *category;
+    Type type;
+    /**
+     * The name is copied and truncated if it doesn't fit.
+     */
+    char name[39];
+
+    void setName(const char *text, qsizetype length);
+};
+
+static_assert(sizeof(TraceEvent) == 64, "TraceEvent should fit in a cache line");
+
+/**
+ * The TraceBuffer is a fixed size ring buffer of trace events written by a single thread and
+ * read by a single consumer, without locks. It works like a flight recorder: if the buffer is
+ * full, the oldest events are overwritten, so it always holds the most recent events.
+ */
+class KWIN_EXPORT TraceBuffer
+{
+public:
+    /**
+     * Creates a buffer that can hold at least @p capacity events.
+     */
+    TraceBuffer(int capacity, int threadId, const QByteArray &threadName);
+
+    int threadId() const;
+    QByteArray threadName() const;
+    int capacity() const;
+
+    /**
+     * Appends the @p event, overwriting the oldest event if the buffer is full. Must only be
+     * called by the thread that owns the buffer.
+     */
+    void push(const TraceEvent &event);
+
+    /**
+     * Moves all events written so far that haven't been overwritten to @p events. Must not be
+     * called concurrently with another call to take().
+     */
+    void take(std::vector<TraceEvent> &events);
+
+    /**
+     * Returns the number of events that have been overwritten before they were taken.
+     */
+    quint64 droppedCount() const;
+
+private:
+    const int m_threadId;
+    const QByteArray m_threadName;
+    const quint64 m_mask;
+    std::unique_ptr<TraceEvent[]> m_events;
+    // The index of the event that is being written, and the index after the last written event.
+    alignas(64) std::atomic<quint64> m_claimed = 0;
+    std::atomic<quint64> m_head = 0;
+    // Only touched by the consumer.
+    alignas(64) std::atomic<quint64> m_tail = 0;
+    std::atomic<quint64> m_dropped = 0;
+};
+
+} // namespace KWin
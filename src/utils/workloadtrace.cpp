@@ -0,0 +1,296 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "utils/workloadtrace.h"
+
+#include <QIODevice>
+
+#include <cmath>
+
+namespace KWin
+{
+
+static const QByteArray s_magic = QByteArrayLiteral("KWINWLT");
+static const char s_version = 1;
+
+// Pointer positions and scroll deltas are stored with 1/256 pixel precision.
+static const qreal s_fixedPointScale = 256;
+
+static void writeUnsigned(QByteArray &buffer, quint64 value)
+{
+    while (value >= 0x80) {
+        buffer.append(char(value & 0x7f) | char(0x80));
+        value >>= 7;
+    }
+    buffer.append(char(value));
+}
+
+static void writeSigned(QByteArray &buffer, qint64 value)
+{
+    writeUnsigned(buffer, (quint64(value) << 1) ^ quint64(value >> 63));
+}
+
+static void writeReal(QByteArray &buffer, qreal value)
+{
+    writeSigned(buffer, std::lround(value * s_fixedPointScale));
+}
+
+static void writeRect(QByteArray &buffer, const QRect &rect)
+{
+    writeSigned(buffer, rect.x());
+    writeSigned(buffer, rect.y());
+    writeUnsigned(buffer, std::max(rect.width(), 0));
+    writeUnsigned(buffer, std::max(rect.height(), 0));
+}
+
+WorkloadTraceWriter::WorkloadTraceWriter(QIODevice *device)
+    : m_device(device)
+{
+    m_device->write(s_magic);
+    m_device->write(&s_version, 1);
+}
+
+bool WorkloadTraceWriter::write(const WorkloadEvent &event)
+{
+    m_buffer.clear();
+    m_buffer.append(char(event.type));
+    writeUnsigned(m_buffer, std::max(event.timestamp - m_timestamp, std::chrono::microseconds::zero()).count());
+    m_timestamp = std::max(event.timestamp, m_timestamp);
+
+    switch (event.type) {
+    case WorkloadEvent::Type::Output:
+        writeRect(m_buffer, event.rect);
+        break;
+    case WorkloadEvent::Type::Frame:
+        break;
+    case WorkloadEvent::Type::SurfaceCommit:
+        writeUnsigned(m_buffer, event.surface);
+        writeUnsigned(m_buffer, std::max(event.rect.width(), 0));
+        writeUnsigned(m_buffer, std::max(event.rect.height(), 0));
+        writeUnsigned(m_buffer, event.damage.rectCount());
+        for (const QRect &rect : event.damage) {
+            writeRect(m_buffer, rect);
+        }
+        break;
+    case WorkloadEvent::Type::SurfaceDestroyed:
+    case WorkloadEvent::Type::WindowRemoved:
+        writeUnsigned(m_buffer, event.surface);
+        break;
+    case WorkloadEvent::Type::WindowAdded:
+    case WorkloadEvent::Type::WindowGeometry:
+        writeUnsigned(m_buffer, event.surface);
+        writeRect(m_buffer, event.rect);
+        break;
+    case WorkloadEvent::Type::StackingOrder:
+        writeUnsigned(m_buffer, event.stacking.count());
+        for (quint32 surface : event.stacking) {
+            writeUnsigned(m_buffer, surface);
+        }
+        break;
+    case WorkloadEvent::Type::PointerMotion:
+        writeReal(m_buffer, event.position.x());
+        writeReal(m_buffer, event.position.y());
+        break;
+    case WorkloadEvent::Type::PointerButton:
+        writeUnsigned(m_buffer, event.button);
+        m_buffer.append(char(event.pressed));
+        break;
+    case WorkloadEvent::Type::PointerAxis:
+        writeUnsigned(m_buffer, event.button);
+        writeReal(m_buffer, event.position.x());
+        break;
+    case WorkloadEvent::Type::Key:
+        m_buffer.append(char(event.pressed));
+        break;
+    case WorkloadEvent::Type::Effect: {
+        const QByteArray name = event.name.toUtf8();
+        writeUnsigned(m_buffer, name.size());
+        m_buffer.append(name);
+        m_buffer.append(char(event.pressed));
+        break;
+    }
+    }
+
+    return m_device->write(m_buffer) == m_buffer.size();
+}
+
+/**
+ * Reads the values of one event, remembers whether any of them was missing or malformed.
+ */
+class WorkloadTraceDecoder
+{
+public:
+    explicit WorkloadTraceDecoder(QIODevice *device)
+        : m_device(device)
+    {
+    }
+
+    bool hasError() const
+    {
+        return m_error;
+    }
+
+    quint8 readByte()
+    {
+        char c = 0;
+        if (!m_device->getChar(&c)) {
+            m_error = true;
+        }
+        return quint8(c);
+    }
+
+    quint64 readUnsigned()
+    {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const quint8 byte = readByte();
+            if (m_error) {
+                return 0;
+            }
+            value |= quint64(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        m_error = true;
+        return 0;
+    }
+
+    qint64 readSigned()
+    {
+        const quint64 value = readUnsigned();
+        return qint64(value >> 1) ^ -qint64(value & 1);
+    }
+
+    qreal readReal()
+    {
+        return readSigned() / s_fixedPointScale;
+    }
+
+    QRect readRect()
+    {
+        const int x = readSigned();
+        const int y = readSigned();
+        const int width = readUnsigned();
+        const int height = readUnsigned();
+        return QRect(x, y, width, height);
+    }
+
+    QByteArray readBytes(quint64 size)
+    {
+        // Names are short, a larger size means that the trace is corrupted.
+        if (size > 1024) {
+            m_error = true;
+            return QByteArray();
+        }
+        const QByteArray bytes = m_device->read(size);
+        if (quint64(bytes.size()) != size) {
+            m_error = true;
+        }
+        return bytes;
+    }
+
+private:
+    QIODevice *m_device;
+    bool m_error = false;
+};
+
+WorkloadTraceReader::WorkloadTraceReader(QIODevice *device)
+    : m_device(device)
+{
+    const QByteArray header = m_device->read(s_magic.size() + 1);
+    m_valid = header.size() == s_magic.size() + 1 && header.startsWith(s_magic) && header.back() == s_version;
+}
+
+bool WorkloadTraceReader::isValid() const
+{
+    return m_valid;
+}
+
+std::optional<WorkloadEvent> WorkloadTraceReader::read()
+{
+    if (!m_valid || m_device->atEnd()) {
+        return std::nullopt;
+    }
+
+    WorkloadTraceDecoder decoder(m_device);
+    WorkloadEvent event;
+    const quint8 type = decoder.readByte();
+    if (type > quint8(WorkloadEvent::Type::Effect)) {
+        m_valid = false;
+        return std::nullopt;
+    }
+    event.type = WorkloadEvent::Type(type);
+    m_timestamp += std::chrono::microseconds(decoder.readUnsigned());
+    event.timestamp = m_timestamp;
+
+    switch (event.type) {
+    case WorkloadEvent::Type::Output:
+        event.rect = decoder.readRect();
+        break;
+    case WorkloadEvent::Type::Frame:
+        break;
+    case WorkloadEvent::Type::SurfaceCommit: {
+        event.surface = decoder.readUnsigned();
+        const int width = decoder.readUnsigned();
+        const int height = decoder.readUnsigned();
+        event.rect = QRect(0, 0, width, height);
+        const quint64 rectCount = decoder.readUnsigned();
+        for (quint64 i = 0; i < rectCount && !decoder.hasError(); ++i) {
+            event.damage += decoder.readRect();
+        }
+        break;
+    }
+    case WorkloadEvent::Type::SurfaceDestroyed:
+    case WorkloadEvent::Type::WindowRemoved:
+        event.surface = decoder.readUnsigned();
+        break;
+    case WorkloadEvent::Type::WindowAdded:
+    case WorkloadEvent::Type::WindowGeometry:
+        event.surface = decoder.readUnsigned();
+        event.rect = decoder.readRect();
+        break;
+    case WorkloadEvent::Type::StackingOrder: {
+        const quint64 count = decoder.readUnsigned();
+        for (quint64 i = 0; i < count && !decoder.hasError(); ++i) {
+            event.stacking.append(decoder.readUnsigned());
+        }
+        break;
+    }
+    case WorkloadEvent::Type::PointerMotion: {
+        const qreal x = decoder.readReal();
+        const qreal y = decoder.readReal();
+        event.position = QPointF(x, y);
+        break;
+    }
+    case WorkloadEvent::Type::PointerButton:
+        event.button = decoder.readUnsigned();
+        event.pressed = decoder.readByte();
+        break;
+    case WorkloadEvent::Type::PointerAxis:
+        event.button = decoder.readUnsigned();
+        event.position = QPointF(decoder.readReal(), 0);
+        break;
+    case WorkloadEvent::Type::Key:
+        event.pressed = decoder.readByte();
+        break;
+    case WorkloadEvent::Type::Effect:
+        event.name = QString::fromUtf8(decoder.readBytes(decoder.readUnsigned()));
+        event.pressed = decoder.readByte();
+        break;
+    }
+
+    if (decoder.hasError()) {
+        m_valid = false;
+        return std::nullopt;
+    }
+    return event;
+}
+
+} // namespace KWin
@@ -0,0 +1,143 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwin_export.h"
+
+#include <QPointF>
+#include <QRect>
+#include <QRegion>
+#include <QString>
+#include <QVector>
+
+#include <chrono>
+#include <optional>
+
+class QIODevice;
+
+namespace KWin
+{
+
+/**
+ * An event of a recorded workload, see WorkloadRecorder. Only the fields relevant for the
+ * type of the event are stored.
+ */
+struct WorkloadEvent
+{
+    enum class Type : quint8 {
+        /**
+         * An output, with its geometry in @c rect. Outputs are written at the start and when
+         * they are added.
+         */
+        Output,
+        /**
+         * The compositor starts a new frame. Everything recorded before it is painted in it.
+         */
+        Frame,
+        /**
+         * The @c surface has been committed with a buffer of the size of @c rect, or without
+         * a buffer if the size is empty, and @c damage in surface-local coordinates.
+         */
+        SurfaceCommit,
+        SurfaceDestroyed,
+        /**
+         * The window of the @c surface has been added, with the frame geometry in @c rect.
+         */
+        WindowAdded,
+        WindowRemoved,
+        WindowGeometry,
+        /**
+         * The surfaces of the windows in @c stacking, from bottom to top.
+         */
+        StackingOrder,
+        PointerMotion,
+        /**
+         * The @c button has been @c pressed or released.
+         */
+        PointerButton,
+        /**
+         * Scrolled by the x coordinate of @c position, with the orientation in @c button.
+         */
+        PointerAxis,
+        /**
+         * A key has been @c pressed or released. Which key is not recorded.
+         */
+        Key,
+        /**
+         * The fullscreen effect @c name has been activated or deactivated, as in @c pressed.
+         */
+        Effect,
+    };
+
+    Type type = Type::Frame;
+    /**
+     * The time since the start of the recording, with microsecond precision.
+     */
+    std::chrono::microseconds timestamp = std::chrono::microseconds::zero();
+    quint32 surface = 0;
+    QRect rect;
+    QRegion damage;
+    QPointF position;
+    quint32 button = 0;
+    bool pressed = false;
+    QVector<quint32> stacking;
+    QString name;
+};
+
+/**
+ * The WorkloadTraceWriter writes workload events in a compact binary format. Numbers are
+ * written as variable-length integers and timestamps as the difference to the previous event,
+ * so most events take only a few bytes.
+ */
+class KWIN_EXPORT WorkloadTraceWriter
+{
+public:
+    /**
+     * Writes the header of the trace to @p device, which must be open for writing.
+     */
+    explicit WorkloadTraceWriter(QIODevice *device);
+
+    bool write(const WorkloadEvent &event);
+
+private:
+    QIODevice *m_device;
+    std::chrono::microseconds m_timestamp = std::chrono::microseconds::zero();
+    QByteArray m_buffer;
+};
+
+/**
+ * The WorkloadTraceReader reads the events written by the WorkloadTraceWriter.
+ */
+class KWIN_EXPORT WorkloadTraceReader
+{
+public:
+    /**
+     * Reads the header of the trace from @p device, which must be open for reading.
+     */
+    explicit WorkloadTraceReader(QIODevice *device);
+
+    /**
+     * Returns @c false if the device doesn't contain a trace of a supported version.
+     */
+    bool isValid() const;
+
+    /**
+     * Returns the next event, or an empty optional at the end of the trace or if the trace is
+     * corrupted.
+     */
+    std::optional<WorkloadEvent> read();
+
+private:
+    QIODevice *m_device;
+    std::chrono::microseconds m_timestamp = std::chrono::microseconds::zero();
+    bool m_valid = false;
+};
+
+} // namespace KWin
@@ -17,6 +17,10 @@
 #include <QStack>
 #include <QStandardPaths>
 
+#include <memory>
+
+#include <sys/stat.h>
+
 namespace KWin
 {
 
@@ -28,13 +32,28 @@ public:
     std::chrono::milliseconds delay;
 };
 
+/**
+ * The cursor files of a theme and of the themes it inherits from, by shape name. The files of
+ * a shape are ordered by precedence, so a file that fails to decode falls back to the next one.
+ * The index doesn't depend on the cursor size, so it is shared by all themes with the same name.
+ */
+class KXcursorThemeIndex
+{
+public:
+    void load(const QString &themeName);
+    void loadCursors(const QString &packagePath);
+
+    QHash<QByteArray, QStringList> files;
+};
+
 class KXcursorThemePrivate : public QSharedData
 {
 public:
     void load(const QString &themeName, int size, qreal devicePixelRatio);
-    void loadCursors(const QString &packagePath, int size, qreal devicePixelRatio);
 
-    QHash<QByteArray, QVector<KXcursorSprite>> registry;
+    std::shared_ptr<const KXcursorThemeIndex> index;
+    int size = 0;
+    qreal devicePixelRatio = 1;
 };
 
 KXcursorSprite::KXcursorSprite()
@@ -83,12 +102,24 @@ std::chrono::milliseconds KXcursorSprite::delay() const
 
 static QVector<KXcursorSprite> loadCursor(const QString &filePath, int desiredSize, qreal devicePixelRatio)
 {
-    XcursorImages *images = XcursorFileLoadImages(QFile::encodeName(filePath), desiredSize * devicePixelRatio);
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    const qint64 length = file.size();
+    uchar *mapping = file.map(0, length);
+    if (!mapping) {
+        return {};
+    }
+
+    XcursorImages *images = XcursorMemoryLoadImages(mapping, length, desiredSize * devicePixelRatio);
+    file.unmap(mapping);
     if (!images) {
         return {};
     }
 
     QVector<KXcursorSprite> sprites;
+    sprites.reserve(images->nimage);
     for (int i = 0; i < images->nimage; ++i) {
         const XcursorImage *nativeCursorImage = images->images[i];
         const qreal scale = std::max(qreal(1), qreal(nativeCursorImage->size) / desiredSize);
@@ -106,32 +137,126 @@ static QVector<KXcursorSprite> loadCursor(const QString &filePath, int desiredSi
     return sprites;
 }
 
-void KXcursorThemePrivate::loadCursors(const QString &packagePath, int size, qreal devicePixelRatio)
+KXcursorSpriteCache::KXcursorSpriteCache(qint64 limit)
+    : m_limit(limit)
 {
-    const QDir dir(packagePath);
-    QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
-    std::partition(entries.begin(), entries.end(), [](const QFileInfo &fileInfo) {
-        return !fileInfo.isSymLink();
-    });
+}
 
-    for (const QFileInfo &entry : std::as_const(entries)) {
-        const QByteArray shape = QFile::encodeName(entry.fileName());
-        if (registry.contains(shape)) {
-            continue;
+KXcursorSpriteCache *KXcursorSpriteCache::self()
+{
+    static KXcursorSpriteCache cache;
+    return &cache;
+}
+
+QVector<KXcursorSprite> KXcursorSpriteCache::sprites(const QString &filePath, int size, qreal devicePixelRatio)
+{
+    const Key key{filePath, size, devicePixelRatio};
+    auto it = m_entries.find(key);
+
+    struct stat info;
+    if (stat(QFile::encodeName(filePath).constData(), &info) != 0) {
+        if (it != m_entries.end()) {
+            remove(it);
         }
-        if (entry.isSymLink()) {
-            const QFileInfo symLinkInfo(entry.symLinkTarget());
-            if (symLinkInfo.absolutePath() == entry.absolutePath()) {
-                const auto sprites = registry.value(QFile::encodeName(symLinkInfo.fileName()));
-                if (!sprites.isEmpty()) {
-                    registry.insert(shape, sprites);
-                    continue;
-                }
-            }
+        return {};
+    }
+    const FileStamp stamp{
+        .device = quint64(info.st_dev),
+        .inode = quint64(info.st_ino),
+        .modified = qint64(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec,
+        .size = qint64(info.st_size),
+    };
+
+    if (it != m_entries.end()) {
+        if (it->stamp == stamp) {
+            m_recentlyUsed.splice(m_recentlyUsed.begin(), m_recentlyUsed, it->position);
+            m_statistics.hits++;
+            return it->sprites;
         }
-        const QVector<KXcursorSprite> sprites = loadCursor(entry.absoluteFilePath(), size, devicePixelRatio);
-        if (!sprites.isEmpty()) {
-            registry.insert(shape, sprites);
+        remove(it);
+    }
+
+    m_statistics.misses++;
+    const QVector<KXcursorSprite> sprites = loadCursor(filePath, size, devicePixelRatio);
+    if (sprites.isEmpty()) {
+        return {};
+    }
+
+    qint64 cost = 0;
+    for (const KXcursorSprite &sprite : sprites) {
+        cost += sprite.data().sizeInBytes();
+    }
+
+    m_recentlyUsed.push_front(key);
+    m_entries.insert(key, Entry{sprites, stamp, cost, m_recentlyUsed.begin()});
+    m_statistics.size += cost;
+    evict();
+
+    return sprites;
+}
+
+void KXcursorSpriteCache::remove(QHash<Key, Entry>::iterator it)
+{
+    m_statistics.size -= it->cost;
+    m_recentlyUsed.erase(it->position);
+    m_entries.erase(it);
+}
+
+void KXcursorSpriteCache::evict()
+{
+    // The most recently used entry is kept even if it alone exceeds the limit.
+    while (m_statistics.size > m_limit && m_recentlyUsed.size() > 1) {
+        m_statistics.evictions++;
+        remove(m_entries.find(m_recentlyUsed.back()));
+    }
+}
+
+qint64 KXcursorSpriteCache::limit() const
+{
+    return m_limit;
+}
+
+void KXcursorSpriteCache::setLimit(qint64 limit)
+{
+    m_limit = limit;
+    evict();
+}
+
+void KXcursorSpriteCache::clear()
+{
+    m_entries.clear();
+    m_recentlyUsed.clear();
+    m_statistics.size = 0;
+}
+
+int KXcursorSpriteCache::count() const
+{
+    return m_entries.count();
+}
+
+KXcursorSpriteCache::Statistics KXcursorSpriteCache::statistics() const
+{
+    return m_statistics;
+}
+
+void KXcursorThemeIndex::loadCursors(const QString &packagePath)
+{
+    // Symbolic links are resolved against the canonical path of the directory, so aliases of
+    // the same cursor share their sprites in the cache.
+    const QDir dir(QDir(packagePath).canonicalPath());
+    if (dir.path().isEmpty()) {
+        return;
+    }
+
+    const QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+    for (const QFileInfo &entry : entries) {
+        const QByteArray shape = QFile::encodeName(entry.fileName());
+        const QString filePath = entry.isSymLink() ? entry.canonicalFilePath() : entry.absoluteFilePath();
+        if (!filePath.isEmpty()) {
+            QStringList &shapeFiles = files[shape];
+            if (!shapeFiles.contains(filePath)) {
+                shapeFiles.append(filePath);
+            }
         }
     }
 }
@@ -156,7 +281,7 @@ static QStringList searchPaths()
     return paths;
 }
 
-void KXcursorThemePrivate::load(const QString &themeName, int size, qreal devicePixelRatio)
+void KXcursorThemeIndex::load(const QString &themeName)
 {
     const QStringList paths = searchPaths();
 
@@ -178,7 +303,7 @@ void KXcursorThemePrivate::load(const QString &themeName, int size, qreal device
             if (!dir.exists()) {
                 continue;
             }
-            loadCursors(dir.filePath(QStringLiteral("cursors")), size, devicePixelRatio);
+            loadCursors(dir.filePath(QStringLiteral("cursors")));
             if (inherits.isEmpty()) {
                 const KConfig config(dir.filePath(QStringLiteral("index.theme")), KConfig::NoGlobals);
                 inherits << KConfigGroup(&config, "Icon Theme").readEntry("Inherits", QStringList());
@@ -192,6 +317,25 @@ void KXcursorThemePrivate::load(const QString &themeName, int size, qreal device
     }
 }
 
+void KXcursorThemePrivate::load(const QString &themeName, int size, qreal devicePixelRatio)
+{
+    // The index is shared as long as any theme with the same name is alive, e.g. when the theme
+    // is loaded again for another scale factor. It is rebuilt after the theme has been released,
+    // so themes that got installed or updated in the meantime are picked up.
+    static QHash<QString, std::weak_ptr<const KXcursorThemeIndex>> indices;
+
+    this->size = size;
+    this->devicePixelRatio = devicePixelRatio;
+
+    index = indices.value(themeName).lock();
+    if (!index) {
+        auto loadedIndex = std::make_shared<KXcursorThemeIndex>();
+        loadedIndex->load(themeName);
+        index = loadedIndex;
+        indices.insert(themeName, index);
+    }
+}
+
 KXcursorTheme::KXcursorTheme()
     : d(new KXcursorThemePrivate)
 {
@@ -230,12 +374,22 @@ bool KXcursorTheme::operator!=(const KXcursorTheme &other)
 
 bool KXcursorTheme::isEmpty() const
 {
-    return d->registry.isEmpty();
+    return !d->index || d->index->files.isEmpty();
 }
 
 QVector<KXcursorSprite> KXcursorTheme::shape(const QByteArray &name) const
 {
-    return d->registry.value(name);
+    if (!d->index) {
+        return {};
+    }
+    const QStringList filePaths = d->index->files.value(name);
+    for (const QString &filePath : filePaths) {
+        const QVector<KXcursorSprite> sprites = KXcursorSpriteCache::self()->sprites(filePath, d->size, d->devicePixelRatio);
+        if (!sprites.isEmpty()) {
+            return sprites;
+        }
+    }
+    return {};
 }
 
 } // namespace KWin
@@ -8,11 +8,13 @@
 
 #include <kwin_export.h>
 
+#include <QHash>
 #include <QImage>
 #include <QSharedDataPointer>
 #include <QVector>
 
 #include <chrono>
+#include <list>
 
 namespace KWin
 {
@@ -73,8 +75,100 @@ private:
     QSharedDataPointer<KXcursorSpritePrivate> d;
 };
 
+/**
+ * The KXcursorSpriteCache class keeps the decoded sprites of Xcursor files around.
+ *
+ * The cache is shared by all Xcursor themes in the process, so themes that are loaded for
+ * several scale factors, or loaded again after a theme change, don't decode the same files
+ * twice. Entries are keyed by the path of the cursor file, the nominal size and the scale factor.
+ * An entry is decoded again if the file has been replaced or modified since, e.g. because the
+ * theme got updated. Files that fail to decode are not cached. The least recently used entries
+ * are dropped once the sprites take more than limit() bytes.
+ *
+ * The cache must be used only from the main thread.
+ */
+class KWIN_EXPORT KXcursorSpriteCache
+{
+public:
+    struct Statistics
+    {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+        /**
+         * The number of bytes used by the pixels of all cached sprites.
+         */
+        qint64 size = 0;
+    };
+
+    explicit KXcursorSpriteCache(qint64 limit = 32 * 1024 * 1024);
+
+    static KXcursorSpriteCache *self();
+
+    /**
+     * Returns the sprites in the Xcursor file at @a filePath that best match the nominal
+     * @a size at the scale factor @a devicePixelRatio, decoding the file if it is not cached.
+     */
+    QVector<KXcursorSprite> sprites(const QString &filePath, int size, qreal devicePixelRatio);
+
+    qint64 limit() const;
+    void setLimit(qint64 limit);
+
+    void clear();
+    int count() const;
+    Statistics statistics() const;
+
+private:
+    struct Key
+    {
+        QString filePath;
+        int size;
+        qreal devicePixelRatio;
+
+        bool operator==(const Key &other) const = default;
+
+        friend size_t qHash(const Key &key, size_t seed)
+        {
+            return qHash(key.filePath, seed) ^ qHash(key.devicePixelRatio, seed) ^ (size_t(key.size) << 16);
+        }
+    };
+
+    /**
+     * Identifies the contents of a file, it changes when the file is modified or replaced.
+     */
+    struct FileStamp
+    {
+        quint64 device;
+        quint64 inode;
+        qint64 modified;
+        qint64 size;
+
+        bool operator==(const FileStamp &other) const = default;
+    };
+
+    struct Entry
+    {
+        QVector<KXcursorSprite> sprites;
+        FileStamp stamp;
+        qint64 cost;
+        std::list<Key>::iterator position;
+    };
+
+    void evict();
+    void remove(QHash<Key, Entry>::iterator it);
+
+    qint64 m_limit;
+    QHash<Key, Entry> m_entries;
+    std::list<Key> m_recentlyUsed;
+    Statistics m_statistics;
+};
+
 /**
  * The KXcursorTheme class represents an Xcursor theme.
+ *
+ * Constructing a theme only indexes the cursor files of the theme and the themes it inherits
+ * from. A cursor is decoded when shape() is called for it for the first time, and the sprites
+ * are kept in the KXcursorSpriteCache.
  */
 class KWIN_EXPORT KXcursorTheme
 {
@@ -110,7 +204,7 @@ public:
     bool operator!=(const KXcursorTheme &other);
 
     /**
-     * Returns @c true if the Xcursor theme is empty; otherwise returns @c false.
+     * Returns @c true if the Xcursor theme has no cursor files; otherwise returns @c false.
      */
     bool isEmpty() const;
 
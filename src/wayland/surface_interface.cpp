@@ -10,6 +10,7 @@
 #include "compositor_interface.h"
 #include "contenttype_v1_interface.h"
 #include "display.h"
+#include "ftrace.h"
 #include "fractionalscale_v1_interface_p.h"
 #include "idleinhibit_v1_interface_p.h"
 #include "linuxdmabufv1clientbuffer.h"
@@ -552,6 +553,7 @@ void SurfaceState::mergeInto(SurfaceState *target)
 
 void SurfaceInterfacePrivate::applyState(SurfaceState *next)
 {
+    fTraceScope("wayland", "applySurfaceState");
     const bool bufferChanged = next->bufferIsSet;
     const bool opaqueRegionChanged = next->opaqueIsSet;
     const bool scaleFactorChanged = next->bufferScaleIsSet && (current.bufferScale != next->bufferScale);
@@ -0,0 +1,428 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "workloadrecorder.h"
+#include "composite.h"
+#include "core/output.h"
+#include "core/renderloop.h"
+#include "effects.h"
+#include "input.h"
+#include "input_event.h"
+#include "mousebuttons.h"
+#include "utils/common.h"
+#include "utils/serviceutils.h"
+#include "wayland/compositor_interface.h"
+#include "wayland/surface_interface.h"
+#include "wayland_server.h"
+#include "window.h"
+#include "workspace.h"
+
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace KWin
+{
+
+static const QString s_dbusInterface = QStringLiteral("org.kde.kwin.WorkloadRecorder");
+static const QString s_errorNotAuthorized = QStringLiteral("org.kde.kwin.WorkloadRecorder.Error.NoAuthorized");
+static const QString s_errorNotAuthorizedMessage = QStringLiteral("The process is not authorized to record the workload");
+
+WorkloadRecorder::WorkloadRecorder(QObject *parent)
+    : QObject(parent)
+{
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/WorkloadRecorder"), this, QDBusConnection::ExportScriptableContents);
+
+    const QString fileName = qEnvironmentVariable("KWIN_RECORD_WORKLOAD");
+    if (!fileName.isEmpty()) {
+        // Wait until the compositor is fully set up, so the effects can be watched too.
+        QMetaObject::invokeMethod(
+            this, [this, fileName]() {
+                start(fileName);
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+WorkloadRecorder::~WorkloadRecorder()
+{
+    stop();
+}
+
+bool WorkloadRecorder::isRecording() const
+{
+    return m_writer != nullptr;
+}
+
+bool WorkloadRecorder::start(const QString &fileName)
+{
+    if (m_writer) {
+        return false;
+    }
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(KWIN_CORE) << "Failed to open" << fileName << "to record the workload:" << m_file.errorString();
+        return false;
+    }
+    startRecording();
+    return true;
+}
+
+bool WorkloadRecorder::checkPermissions() const
+{
+    // Calls from within the compositor, e.g. by the tests, are trusted.
+    if (!calledFromDBus()) {
+        return true;
+    }
+
+    const QDBusReply<uint> reply = connection().interface()->servicePid(message().service());
+    if (reply.isValid()) {
+        const uint pid = reply.value();
+        const auto interfaces = KWin::fetchRestrictedDBusInterfacesFromPid(pid);
+        if (!interfaces.contains(s_dbusInterface)) {
+            sendErrorReply(s_errorNotAuthorized, s_errorNotAuthorizedMessage);
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool WorkloadRecorder::start(QDBusUnixFileDescriptor fileDescriptor)
+{
+    if (!checkPermissions()) {
+        return false;
+    }
+    if (m_writer) {
+        return false;
+    }
+
+    // The file is opened by the caller, so it can't make the compositor write anywhere the
+    // caller itself can't write to.
+    const int fd = fcntl(fileDescriptor.fileDescriptor(), F_DUPFD_CLOEXEC, 0);
+    if (fd == -1) {
+        qCWarning(KWIN_CORE) << "Invalid file descriptor to record the workload";
+        return false;
+    }
+    if (!m_file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle)) {
+        qCWarning(KWIN_CORE) << "Failed to record the workload:" << m_file.errorString();
+        close(fd);
+        return false;
+    }
+    startRecording();
+    return true;
+}
+
+void WorkloadRecorder::startRecording()
+{
+    m_writer = std::make_unique<WorkloadTraceWriter>(&m_file);
+    m_timer.start();
+
+    const QList<Output *> outputs = workspace()->outputs();
+    for (Output *output : outputs) {
+        handleOutputAdded(output);
+    }
+
+    m_connections.append(connect(workspace(), &Workspace::outputAdded, this, &WorkloadRecorder::handleOutputAdded));
+    m_connections.append(connect(workspace(), &Workspace::outputRemoved, this, &WorkloadRecorder::handleOutputRemoved));
+    m_connections.append(connect(waylandServer()->compositor(), &KWaylandServer::CompositorInterface::surfaceCreated, this, &WorkloadRecorder::watchSurface));
+    m_connections.append(connect(workspace(), &Workspace::windowAdded, this, &WorkloadRecorder::handleWindowAdded));
+    m_connections.append(connect(workspace(), &Workspace::windowRemoved, this, &WorkloadRecorder::handleWindowRemoved));
+    m_connections.append(connect(workspace(), &Workspace::stackingOrderChanged, this, &WorkloadRecorder::handleStackingOrderChanged));
+    m_connections.append(connect(Compositor::self(), &Compositor::compositingToggled, this, &WorkloadRecorder::watchEffects));
+    watchEffects();
+
+    // Start with a snapshot of the windows that already exist, with their current contents.
+    const QList<Window *> windows = workspace()->allClientList();
+    for (Window *window : windows) {
+        handleWindowAdded(window);
+        KWaylandServer::SurfaceInterface *surface = window->surface();
+        if (surface && surface->buffer()) {
+            write(WorkloadEvent{
+                .type = WorkloadEvent::Type::SurfaceCommit,
+                .surface = m_surfaces.value(surface),
+                .rect = QRect(QPoint(0, 0), surface->bufferSize()),
+                .damage = QRect(QPoint(0, 0), surface->size().toSize()),
+            });
+        }
+    }
+    handleStackingOrderChanged();
+
+    input()->installInputEventSpy(this);
+    Q_EMIT recordingChanged();
+}
+
+void WorkloadRecorder::stop()
+{
+    if (!checkPermissions()) {
+        return;
+    }
+    if (!m_writer) {
+        return;
+    }
+
+    if (input()) {
+        input()->uninstallInputEventSpy(this);
+    }
+    for (const QMetaObject::Connection &connection : std::as_const(m_connections)) {
+        disconnect(connection);
+    }
+    m_connections.clear();
+    disconnect(m_effectsConnection);
+    for (Output *output : std::as_const(m_outputs)) {
+        disconnect(output->renderLoop(), nullptr, this, nullptr);
+    }
+    m_outputs.clear();
+    for (auto it = m_surfaces.keyBegin(); it != m_surfaces.keyEnd(); ++it) {
+        disconnect(*it, nullptr, this, nullptr);
+    }
+    for (auto it = m_windows.keyBegin(); it != m_windows.keyEnd(); ++it) {
+        disconnect(*it, nullptr, this, nullptr);
+    }
+    m_surfaces.clear();
+    m_damage.clear();
+    m_windows.clear();
+    m_stacking.clear();
+    m_activeEffect.clear();
+
+    m_writer.reset();
+    m_file.close();
+    Q_EMIT recordingChanged();
+}
+
+void WorkloadRecorder::handleOutputAdded(Output *output)
+{
+    if (m_outputs.contains(output)) {
+        return;
+    }
+    m_outputs.append(output);
+
+    write(WorkloadEvent{
+        .type = WorkloadEvent::Type::Output,
+        .rect = output->geometry(),
+    });
+    connect(output->renderLoop(), &RenderLoop::frameRequested, this, [this]() {
+        write(WorkloadEvent{
+            .type = WorkloadEvent::Type::Frame,
+        });
+    });
+}
+
+void WorkloadRecorder::handleOutputRemoved(Output *output)
+{
+    if (m_outputs.removeOne(output)) {
+        disconnect(output->renderLoop(), nullptr, this, nullptr);
+    }
+}
+
+void WorkloadRecorder::write(WorkloadEvent event)
+{
+    if (!m_writer) {
+        return;
+    }
+    event.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(m_timer.nsecsElapsed()));
+    if (!m_writer->write(event)) {
+        qCWarning(KWIN_CORE) << "Failed to write the workload trace:" << m_file.errorString();
+        stop();
+    }
+}
+
+quint32 WorkloadRecorder::watchSurface(KWaylandServer::SurfaceInterface *surface)
+{
+    auto it = m_surfaces.constFind(surface);
+    if (it != m_surfaces.constEnd()) {
+        return *it;
+    }
+
+    const quint32 id = ++m_lastSurfaceId;
+    m_surfaces.insert(surface, id);
+
+    // The damage is only known while the state is applied, before the commit is announced.
+    connect(surface, &KWaylandServer::SurfaceInterface::damaged, this, [this, surface](const QRegion &damage) {
+        m_damage[surface] += damage;
+    });
+    connect(surface, &KWaylandServer::SurfaceInterface::committed, this, [this, surface, id]() {
+        write(WorkloadEvent{
+            .type = WorkloadEvent::Type::SurfaceCommit,
+            .surface = id,
+            .rect = QRect(QPoint(0, 0), surface->bufferSize()),
+            .damage = m_damage.take(surface),
+        });
+    });
+    connect(surface, &KWaylandServer::SurfaceInterface::aboutToBeDestroyed, this, [this, surface, id]() {
+        disconnect(surface, nullptr, this, nullptr);
+        m_surfaces.remove(surface);
+        m_damage.remove(surface);
+        write(WorkloadEvent{
+            .type = WorkloadEvent::Type::SurfaceDestroyed,
+            .surface = id,
+        });
+    });
+    return id;
+}
+
+void WorkloadRecorder::handleWindowAdded(Window *window)
+{
+    if (!window->surface() || m_windows.contains(window)) {
+        return;
+    }
+
+    const quint32 id = watchSurface(window->surface());
+    m_windows.insert(window, id);
+    write(WorkloadEvent{
+        .type = WorkloadEvent::Type::WindowAdded,
+        .surface = id,
+        .rect = window->frameGeometry().toRect(),
+    });
+
+    connect(window, &Window::frameGeometryChanged, this, [this, window, id]() {
+        write(WorkloadEvent{
+            .type = WorkloadEvent::Type::WindowGeometry,
+            .surface = id,
+            .rect = window->frameGeometry().toRect(),
+        });
+    });
+}
+
+void WorkloadRecorder::handleWindowRemoved(Window *window)
+{
+    auto it = m_windows.find(window);
+    if (it == m_windows.end()) {
+        return;
+    }
+    const quint32 id = *it;
+    m_windows.erase(it);
+
+    disconnect(window, &Window::frameGeometryChanged, this, nullptr);
+    write(WorkloadEvent{
+        .type = WorkloadEvent::Type::WindowRemoved,
+        .surface = id,
+    });
+}
+
+void WorkloadRecorder::handleStackingOrderChanged()
+{
+    QVector<quint32> stacking;
+    const QList<Window *> &stackingOrder = workspace()->stackingOrder();
+    for (Window *window : stackingOrder) {
+        auto it = m_windows.constFind(window);
+        if (it != m_windows.constEnd()) {
+            stacking.append(*it);
+        }
+    }
+    if (stacking == m_stacking) {
+        return;
+    }
+    m_stacking = stacking;
+
+    write(WorkloadEvent{
+        .type = WorkloadEvent::Type::StackingOrder,
+        .stacking = stacking,
+    });
+}
+
+void WorkloadRecorder::watchEffects()
+{
+    if (!effects) {
+        return;
+    }
+    // The effects handler is recreated when compositing is restarted.
+    disconnect(m_effectsConnection);
+    m_effectsConnection = connect(effects, &EffectsHandler::activeFullScreenEffectChanged, this, &WorkloadRecorder::handleActiveFullScreenEffectChanged);
+    handleActiveFullScreenEffectChanged();
+}
+
+void WorkloadRecorder::handleActiveFullScreenEffectChanged()
+{
+    const QString name = effects ? effectName(effects->activeFullScreenEffect()) : QString();
+    if (name == m_activeEffect) {
+        return;
+    }
+
+    if (!m_activeEffect.isEmpty()) {
+        write(WorkloadEvent{
+            .type = WorkloadEvent::Type::Effect,
+            .pressed = false,
+            .name = m_activeEffect,
+        });
+    }
+    if (!name.isEmpty()) {
+        write(WorkloadEvent{
+            .type = WorkloadEvent::Type::Effect,
+            .pressed = true,
+            .name = name,
+        });
+    }
+    m_activeEffect = name;
+}
+
+QString WorkloadRecorder::effectName(Effect *effect) const
+{
+    if (!effect) {
+        return QString();
+    }
+    auto effectsImpl = static_cast<EffectsHandlerImpl *>(effects);
+    const QStringList names = effectsImpl->loadedEffects();
+    for (const QString &name : names) {
+        if (effectsImpl->findEffect(name) == effect) {
+            return name;
+        }
+    }
+    return QString();
+}
+
+void WorkloadRecorder::pointerEvent(MouseEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::MouseMove:
+        write(WorkloadEvent{
+            .type = WorkloadEvent::Type::PointerMotion,
+            .position = event->screenPos(),
+        });
+        break;
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+        write(WorkloadEvent{
+            .type = WorkloadEvent::Type::PointerButton,
+            .button = event->nativeButton() ? event->nativeButton() : qtMouseButtonToButton(event->button()),
+            .pressed = event->type() == QEvent::MouseButtonPress,
+        });
+        break;
+    default:
+        break;
+    }
+}
+
+void WorkloadRecorder::wheelEvent(WheelEvent *event)
+{
+    // Uses the axis numbering of wl_pointer.
+    write(WorkloadEvent{
+        .type = WorkloadEvent::Type::PointerAxis,
+        .position = QPointF(event->delta(), 0),
+        .button = event->orientation() == Qt::Horizontal ? 1u : 0u,
+    });
+}
+
+void WorkloadRecorder::keyEvent(KeyEvent *event)
+{
+    if (event->isAutoRepeat()) {
+        return;
+    }
+    write(WorkloadEvent{
+        .type = WorkloadEvent::Type::Key,
+        .pressed = event->type() == QEvent::KeyPress,
+    });
+}
+
+} // namespace KWin
@@ -0,0 +1,118 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 KWin Contributors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "input_event_spy.h"
+#include "utils/workloadtrace.h"
+
+#include <QDBusContext>
+#include <QDBusUnixFileDescriptor>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QObject>
+
+#include <memory>
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+}
+
+namespace KWin
+{
+
+class Effect;
+class Output;
+class Window;
+
+/**
+ * The WorkloadRecorder records what the compositor has to do into a compact binary trace,
+ * which can be replayed with synthetic clients to reproduce performance problems.
+ *
+ * The trace contains the surface commits with their buffer sizes and damage, the input
+ * events, the geometry and stacking order of the windows, the fullscreen effects that get
+ * activated and the start of every frame. It contains neither the contents of the surfaces nor
+ * which keys have been pressed.
+ *
+ * Usage: Either:
+ *  Set the KWIN_RECORD_WORKLOAD environment variable to the file name of the trace
+ *  Call on DBus /WorkloadRecorder org.kde.kwin.WorkloadRecorder.start with a file descriptor
+ *  that is open for writing
+ *
+ * The trace reveals what the user is doing, so the D-Bus interface is restricted. Only the
+ * applications that list org.kde.kwin.WorkloadRecorder in the X-KDE-DBUS-Restricted-Interfaces
+ * field of their desktop file may use it.
+ */
+class KWIN_EXPORT WorkloadRecorder : public QObject, public QDBusContext, public InputEventSpy
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.WorkloadRecorder")
+    Q_PROPERTY(bool recording READ isRecording NOTIFY recordingChanged)
+
+public:
+    explicit WorkloadRecorder(QObject *parent = nullptr);
+    ~WorkloadRecorder() override;
+
+    bool isRecording() const;
+
+    void pointerEvent(MouseEvent *event) override;
+    void wheelEvent(WheelEvent *event) override;
+    void keyEvent(KeyEvent *event) override;
+
+    /**
+     * Starts recording to @p fileName, the file is overwritten. Returns @c false if the file
+     * can't be written or if a recording is already in progress.
+     */
+    bool start(const QString &fileName);
+
+Q_SIGNALS:
+    void recordingChanged();
+
+public Q_SLOTS:
+    /**
+     * Starts recording to the file referred to by @p fileDescriptor, which the caller has
+     * opened for writing. Returns @c false if the file descriptor is invalid or if a recording
+     * is already in progress.
+     */
+    Q_SCRIPTABLE bool start(QDBusUnixFileDescriptor fileDescriptor);
+    Q_SCRIPTABLE void stop();
+
+private:
+    bool checkPermissions() const;
+    void startRecording();
+    void handleOutputAdded(Output *output);
+    void handleOutputRemoved(Output *output);
+    void write(WorkloadEvent event);
+    quint32 watchSurface(KWaylandServer::SurfaceInterface *surface);
+    void handleWindowAdded(Window *window);
+    void handleWindowRemoved(Window *window);
+    void handleStackingOrderChanged();
+    void watchEffects();
+    void handleActiveFullScreenEffectChanged();
+    QString effectName(Effect *effect) const;
+
+    QFile m_file;
+    std::unique_ptr<WorkloadTraceWriter> m_writer;
+    QElapsedTimer m_timer;
+    quint32 m_lastSurfaceId = 0;
+    QHash<KWaylandServer::SurfaceInterface *, quint32> m_surfaces;
+    QHash<KWaylandServer::SurfaceInterface *, QRegion> m_damage;
+    QHash<Window *, quint32> m_windows;
+    QVector<quint32> m_stacking;
+    QString m_activeEffect;
+    // Only the connections to objects that live as long as the recorder, the connections to
+    // the outputs, surfaces and windows are dropped together with them.
+    QVector<QMetaObject::Connection> m_connections;
+    QMetaObject::Connection m_effectsConnection;
+    QList<Output *> m_outputs;
+};
+
+} // namespace KWin
@@ -40,6 +40,7 @@
 #include "rules.h"
 #include "screenedge.h"
 #include "scripting/scripting.h"
+#include "snapedgeindex.h"
 #include "syncalarmx11filter.h"
 #include "tiles/tilemanager.h"
 #include "x11window.h"
@@ -59,6 +60,7 @@
 #include "virtualdesktops.h"
 #include "was_user_interaction_x11_filter.h"
 #include "wayland_server.h"
+#include "workloadrecorder.h"
 #include "xwaylandwindow.h"
 // KDE
 #include <KConfig>
@@ -66,10 +68,13 @@
 #include <KLocalizedString>
 #include <KStartupInfo>
 // Qt
+#include <QSet>
 #include <QtConcurrentRun>
 // xcb
 #include <xcb/xinerama.h>
 
+#include <algorithm>
+
 namespace KWin
 {
 
@@ -131,6 +136,7 @@ Workspace::Workspace()
     , m_focusChain(std::make_unique<FocusChain>())
     , m_applicationMenu(std::make_unique<ApplicationMenu>())
     , m_placementTracker(std::make_unique<PlacementTracker>(this))
+    , m_snapEdgeIndex(std::make_unique<SnapEdgeIndex>())
 {
     // If KWin was already running it saved its configuration after loosing the selection -> Reread
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -189,6 +195,9 @@ Workspace::Workspace()
 
     new DBusInterface(this);
     m_outline = std::make_unique<Outline>();
+    if (waylandServer()) {
+        m_workloadRecorder = std::make_unique<WorkloadRecorder>();
+    }
 
     initShortcuts();
 
@@ -474,6 +483,7 @@ void Workspace::cleanupX11()
 
 Workspace::~Workspace()
 {
+    m_workloadRecorder.reset();
     blockStackingUpdates(true);
 
     cleanupX11();
@@ -750,6 +760,7 @@ void Workspace::addX11Window(X11Window *window)
     }
     m_x11Clients.append(window);
     m_allClients.append(window);
+    m_snapEdgeIndex->add(window);
     addToStack(window);
     updateClientArea(); // This cannot be in manage(), because the window got added only now
     window->updateLayer();
@@ -841,6 +852,7 @@ void Workspace::addWaylandWindow(Window *window)
         }
     }
     m_allClients.append(window);
+    m_snapEdgeIndex->add(window);
     addToStack(window);
 
     updateStackingOrder(true);
@@ -868,6 +880,7 @@ void Workspace::removeWindow(Window *window)
     }
 
     m_allClients.removeAll(window);
+    m_snapEdgeIndex->remove(window);
     if (window == m_delayFocusWindow) {
         cancelDelayFocus();
     }
@@ -2341,6 +2354,54 @@ QRectF Workspace::adjustClientArea(Window *window, const QRectF &area) const
     return adjustedArea;
 }
 
+std::optional<Workspace::StrutContribution> Workspace::strutContribution(Window *window) const
+{
+    QRectF r = adjustClientArea(window, m_geometry);
+
+    // This happens sometimes when the workspace size changes and the
+    // struted windows haven't repositioned yet
+    if (!r.isValid()) {
+        return std::nullopt;
+    }
+    // sanity check that a strut doesn't exclude a complete screen geometry
+    // this is a violation to EWMH, as KWin just ignores the strut
+    for (const Output *output : std::as_const(m_outputs)) {
+        if (!r.intersects(output->geometry())) {
+            qCDebug(KWIN_CORE) << "Adjusted client area would exclude a complete screen, ignore";
+            r = m_geometry;
+            break;
+        }
+    }
+    StrutRects strutRegion = window->strutRects();
+    const QRect clientsScreenRect = window->output()->geometry();
+    for (int i = strutRegion.size() - 1; i >= 0; --i) {
+        const StrutRect clipped = StrutRect(strutRegion[i].intersected(clientsScreenRect), strutRegion[i].area());
+        if (clipped.isEmpty()) {
+            strutRegion.removeAt(i);
+        } else {
+            strutRegion[i] = clipped;
+        }
+    }
+
+    StrutContribution contribution;
+    contribution.workArea = r;
+    // Ignore offscreen xinerama struts. These interfere with the larger monitors on the setup
+    // and should be ignored so that applications that use the work area to work out where
+    // windows can go can use the entire visible area of the larger monitors.
+    // This goes against the EWMH description of the work area but it is a toss up between
+    // having unusable sections of the screen (Which can be quite large with newer monitors)
+    // or having some content appear offscreen (Relatively rare compared to other).
+    contribution.hasOffscreenStrut = hasOffscreenXineramaStrut(window);
+    contribution.restrictedArea = strutRegion;
+    for (const Output *output : std::as_const(m_outputs)) {
+        contribution.screenAreas.insert(output, adjustClientArea(window, output->fractionalGeometry()));
+    }
+    if (!window->isOnAllDesktops()) {
+        contribution.desktops = window->desktops();
+    }
+    return contribution;
+}
+
 /**
  * Updates the current client areas according to the current windows.
  *
@@ -2348,102 +2409,222 @@ QRectF Workspace::adjustClientArea(Window *window, const QRectF &area) const
  * which is not taken by windows like panels, the top-of-screen menu
  * etc).
  *
+ * Only the screen areas of the outputs that a changed strut overlaps are
+ * computed again, on the virtual desktops the strut is or was on. A strut on
+ * all desktops affects every desktop, but still only the outputs it overlaps.
+ * Only the windows on the outputs whose areas changed have their position
+ * checked. If the outputs or the virtual desktops changed, everything is
+ * computed again.
+ *
  * @see clientArea()
  */
 void Workspace::updateClientArea()
 {
     const QVector<VirtualDesktop *> desktops = VirtualDesktopManager::self()->desktops();
 
-    QHash<const VirtualDesktop *, QRectF> workAreas;
-    QHash<const VirtualDesktop *, StrutRects> restrictedAreas;
-    QHash<const VirtualDesktop *, QHash<const Output *, QRectF>> screenAreas;
-
-    for (const VirtualDesktop *desktop : desktops) {
-        workAreas[desktop] = m_geometry;
-
-        for (const Output *output : std::as_const(m_outputs)) {
-            screenAreas[desktop][output] = output->fractionalGeometry();
-        }
+    QHash<const Output *, QRectF> outputGeometries;
+    for (const Output *output : std::as_const(m_outputs)) {
+        outputGeometries.insert(output, output->fractionalGeometry());
     }
 
+    // The struts are applied in stacking order, a strut is ignored if it would remove an
+    // output completely from the client area of the desktop.
+    QVector<const Window *> strutWindows;
+    QHash<const Window *, StrutContribution> contributions;
     for (Window *window : std::as_const(m_allClients)) {
         if (!window->hasStrut()) {
             continue;
         }
-        QRectF r = adjustClientArea(window, m_geometry);
+        if (const auto contribution = strutContribution(window)) {
+            strutWindows.append(window);
+            contributions.insert(window, *contribution);
+        }
+    }
 
-        // This happens sometimes when the workspace size changes and the
-        // struted windows haven't repositioned yet
-        if (!r.isValid()) {
-            continue;
+    const bool layoutChanged = m_clientAreaGeometry != m_geometry
+        || m_clientAreaOutputs != outputGeometries
+        || m_clientAreaDesktops != desktops;
+
+    // The outputs whose screen areas have to be computed again, per virtual desktop. The work
+    // area and the restricted area of every desktop in here are computed again too.
+    QHash<const VirtualDesktop *, QSet<const Output *>> dirty;
+    if (layoutChanged) {
+        const QSet<const Output *> outputs(m_outputs.constBegin(), m_outputs.constEnd());
+        for (const VirtualDesktop *desktop : desktops) {
+            dirty.insert(desktop, outputs);
         }
-        // sanity check that a strut doesn't exclude a complete screen geometry
-        // this is a violation to EWMH, as KWin just ignores the strut
-        for (const Output *output : std::as_const(m_outputs)) {
-            if (!r.intersects(output->geometry())) {
-                qCDebug(KWIN_CORE) << "Adjusted client area would exclude a complete screen, ignore";
-                r = m_geometry;
-                break;
+    } else {
+        const auto markDirty = [&](const StrutContribution *before, const StrutContribution *after) {
+            // A strut only affects the screen areas of the outputs it overlaps.
+            QSet<const Output *> outputs;
+            for (const Output *output : std::as_const(m_outputs)) {
+                const QRectF geometry = outputGeometries.value(output);
+                if ((before ? before->screenAreas.value(output, geometry) : geometry) != (after ? after->screenAreas.value(output, geometry) : geometry)) {
+                    outputs.insert(output);
+                }
+            }
+            if ((before && before->desktops.isEmpty()) || (after && after->desktops.isEmpty())) {
+                for (const VirtualDesktop *desktop : desktops) {
+                    dirty[desktop] += outputs;
+                }
+                return;
+            }
+            for (const StrutContribution *contribution : {before, after}) {
+                if (contribution) {
+                    for (const VirtualDesktop *desktop : contribution->desktops) {
+                        dirty[desktop] += outputs;
+                    }
+                }
+            }
+        };
+        for (auto it = m_strutContributions.constBegin(); it != m_strutContributions.constEnd(); ++it) {
+            const auto newIt = contributions.constFind(it.key());
+            if (newIt == contributions.constEnd()) {
+                markDirty(&*it, nullptr);
+            } else if (*newIt != *it) {
+                markDirty(&*it, &*newIt);
             }
         }
-        StrutRects strutRegion = window->strutRects();
-        const QRect clientsScreenRect = window->output()->geometry();
-        for (int i = strutRegion.size() - 1; i >= 0; --i) {
-            const StrutRect clipped = StrutRect(strutRegion[i].intersected(clientsScreenRect), strutRegion[i].area());
-            if (clipped.isEmpty()) {
-                strutRegion.removeAt(i);
-            } else {
-                strutRegion[i] = clipped;
+        for (auto it = contributions.constBegin(); it != contributions.constEnd(); ++it) {
+            if (!m_strutContributions.contains(it.key())) {
+                markDirty(nullptr, &*it);
             }
         }
+    }
+
+    QVector<VirtualDesktop *> dirtyDesktops;
+    for (VirtualDesktop *desktop : desktops) {
+        if (dirty.contains(desktop)) {
+            dirtyDesktops.append(desktop);
+        }
+    }
 
-        // Ignore offscreen xinerama struts. These interfere with the larger monitors on the setup
-        // and should be ignored so that applications that use the work area to work out where
-        // windows can go can use the entire visible area of the larger monitors.
-        // This goes against the EWMH description of the work area but it is a toss up between
-        // having unusable sections of the screen (Which can be quite large with newer monitors)
-        // or having some content appear offscreen (Relatively rare compared to other).
-        bool hasOffscreenStrut = hasOffscreenXineramaStrut(window);
+    m_strutContributions = contributions;
+    m_clientAreaOutputs = outputGeometries;
+    m_clientAreaDesktops = desktops;
+    m_clientAreaGeometry = m_geometry;
 
-        const auto vds = window->isOnAllDesktops() ? desktops : window->desktops();
-        for (VirtualDesktop *vd : vds) {
-            if (!hasOffscreenStrut) {
-                workAreas[vd] &= r;
+    if (dirtyDesktops.isEmpty()) {
+        return;
+    }
+
+    QHash<const VirtualDesktop *, QRectF> workAreas;
+    QHash<const VirtualDesktop *, StrutRects> restrictedAreas;
+    QHash<const VirtualDesktop *, QHash<const Output *, QRectF>> screenAreas;
+    if (!layoutChanged) {
+        workAreas = m_workAreas;
+        restrictedAreas = m_restrictedAreas;
+        screenAreas = m_screenAreas;
+    }
+
+    for (VirtualDesktop *desktop : std::as_const(dirtyDesktops)) {
+        const QSet<const Output *> &dirtyOutputs = dirty[desktop];
+        QRectF workArea = m_geometry;
+        QHash<const Output *, QRectF> &screenArea = screenAreas[desktop];
+        for (const Output *output : dirtyOutputs) {
+            screenArea[output] = outputGeometries.value(output);
+        }
+        restrictedAreas.remove(desktop);
+
+        for (const Window *window : std::as_const(strutWindows)) {
+            const StrutContribution &contribution = *contributions.constFind(window);
+            if (!contribution.desktops.isEmpty() && !contribution.desktops.contains(desktop)) {
+                continue;
+            }
+            if (!contribution.hasOffscreenStrut) {
+                workArea &= contribution.workArea;
             }
-            restrictedAreas[vd] += strutRegion;
-            for (Output *output : std::as_const(m_outputs)) {
-                const auto geo = screenAreas[vd][output].intersected(adjustClientArea(window, output->fractionalGeometry()));
+            restrictedAreas[desktop] += contribution.restrictedArea;
+            for (const Output *output : dirtyOutputs) {
+                const auto geo = screenArea[output].intersected(contribution.screenAreas.value(output));
                 // ignore the geometry if it results in the screen getting removed completely
                 if (!geo.isEmpty()) {
-                    screenAreas[vd][output] = geo;
+                    screenArea[output] = geo;
                 }
             }
         }
+
+        workAreas[desktop] = workArea;
     }
 
-    if (m_workAreas != workAreas || m_restrictedAreas != restrictedAreas || m_screenAreas != screenAreas) {
-        m_workAreas = workAreas;
-        m_screenAreas = screenAreas;
+    if (m_workAreas == workAreas && m_restrictedAreas == restrictedAreas && m_screenAreas == screenAreas) {
+        return;
+    }
 
-        m_inUpdateClientArea = true;
-        m_oldRestrictedAreas = m_restrictedAreas;
-        m_restrictedAreas = restrictedAreas;
+    // The outputs on each desktop where either the screen area changed or a strut was added
+    // or removed. Windows elsewhere don't have to be checked.
+    QHash<const VirtualDesktop *, QVector<Output *>> changedOutputs;
+    QVector<VirtualDesktop *> changedDesktops;
+    for (VirtualDesktop *desktop : std::as_const(dirtyDesktops)) {
+        const StrutRects oldStruts = m_restrictedAreas.value(desktop);
+        const StrutRects newStruts = restrictedAreas.value(desktop);
+        const QHash<const Output *, QRectF> oldScreenArea = m_screenAreas.value(desktop);
+        const QHash<const Output *, QRectF> &newScreenArea = screenAreas[desktop];
+        if (m_workAreas.value(desktop) == workAreas[desktop] && oldStruts == newStruts && oldScreenArea == newScreenArea) {
+            continue;
+        }
+        changedDesktops.append(desktop);
 
-        if (rootInfo()) {
-            for (VirtualDesktop *desktop : desktops) {
-                const QRectF &workArea = m_workAreas[desktop];
-                NETRect r(Xcb::toXNative(workArea));
-                rootInfo()->setWorkArea(desktop->x11DesktopNumber(), r);
+        StrutRects changedStruts;
+        for (const StrutRect &strut : oldStruts) {
+            if (!newStruts.contains(strut)) {
+                changedStruts.append(strut);
+            }
+        }
+        for (const StrutRect &strut : newStruts) {
+            if (!oldStruts.contains(strut)) {
+                changedStruts.append(strut);
+            }
+        }
+        for (Output *output : std::as_const(m_outputs)) {
+            bool changed = oldScreenArea.value(output) != newScreenArea.value(output);
+            for (int i = 0; !changed && i < changedStruts.size(); ++i) {
+                changed = changedStruts[i].intersects(output->geometry());
+            }
+            if (changed) {
+                changedOutputs[desktop].append(output);
             }
         }
+    }
 
-        for (auto it = m_allClients.constBegin(); it != m_allClients.constEnd(); ++it) {
-            (*it)->checkWorkspacePosition();
+    m_workAreas = workAreas;
+    m_screenAreas = screenAreas;
+
+    m_inUpdateClientArea = true;
+    m_oldRestrictedAreas = m_restrictedAreas;
+    m_restrictedAreas = restrictedAreas;
+
+    if (rootInfo()) {
+        for (VirtualDesktop *desktop : std::as_const(changedDesktops)) {
+            const QRectF &workArea = m_workAreas[desktop];
+            NETRect r(Xcb::toXNative(workArea));
+            rootInfo()->setWorkArea(desktop->x11DesktopNumber(), r);
         }
+    }
 
-        m_oldRestrictedAreas.clear(); // reset, no longer valid or needed
-        m_inUpdateClientArea = false;
+    const VirtualDesktop *currentDesktop = VirtualDesktopManager::self()->currentDesktop();
+    const auto needsCheck = [&](const Window *window) {
+        if (layoutChanged) {
+            return true;
+        }
+        const VirtualDesktop *desktop = window->isOnCurrentDesktop() ? currentDesktop : (window->desktops().isEmpty() ? nullptr : window->desktops().constLast());
+        const auto it = changedOutputs.constFind(desktop);
+        if (it == changedOutputs.constEnd()) {
+            return false;
+        }
+        const QRectF geometry = window->moveResizeGeometry();
+        return std::any_of(it->constBegin(), it->constEnd(), [&](const Output *output) {
+            return window->moveResizeOutput() == output || geometry.intersects(output->geometry());
+        });
+    };
+    for (auto it = m_allClients.constBegin(); it != m_allClients.constEnd(); ++it) {
+        if (needsCheck(*it)) {
+            (*it)->checkWorkspacePosition();
+        }
     }
+
+    m_oldRestrictedAreas.clear(); // reset, no longer valid or needed
+    m_inUpdateClientArea = false;
 }
 
 /**
@@ -2718,7 +2899,12 @@ QPointF Workspace::adjustWindowPosition(Window *window, QPointF pos, bool unrest
         // windows snap
         const int windowSnapZone = options->windowSnapZone() * snapAdjust;
         if (windowSnapZone > 0) {
-            for (auto l = m_allClients.constBegin(); l != m_allClients.constEnd(); ++l) {
+            // Only windows with an edge in a snap zone can attract the window. The coordinates
+            // are truncated below, so look a bit further than the snap zone.
+            const qreal xs[] = {qreal(cx), qreal(rx)};
+            const qreal ys[] = {qreal(cy), qreal(ry)};
+            const QVector<Window *> candidates = m_snapEdgeIndex->windowsNear(VirtualDesktopManager::self()->currentDesktop(), xs, ys, windowSnapZone + 2);
+            for (auto l = candidates.constBegin(); l != candidates.constEnd(); ++l) {
                 if ((*l) == window) {
                     continue;
                 }
@@ -2911,7 +3097,25 @@ QRectF Workspace::adjustWindowSize(Window *window, QRectF moveResizeGeom, Gravit
         if (snap) {
             deltaX = int(snap);
             deltaY = int(snap);
-            for (auto l = m_allClients.constBegin(); l != m_allClients.constEnd(); ++l) {
+            // Only windows with an edge near the edges of the window can attract it. Snapping
+            // moves the edges onto the edges of those windows, so the windows near them are looked
+            // up as well, until no more windows turn up.
+            VirtualDesktop *desktop = VirtualDesktopManager::self()->currentDesktop();
+            QVector<Window *> candidates;
+            for (;;) {
+                QVector<qreal> xs{newcx, newrx};
+                QVector<qreal> ys{newcy, newry};
+                for (const Window *candidate : std::as_const(candidates)) {
+                    xs << candidate->x() << candidate->x() + candidate->width();
+                    ys << candidate->y() << candidate->y() + candidate->height();
+                }
+                const QVector<Window *> nearWindows = m_snapEdgeIndex->windowsNear(desktop, std::span(xs.constData(), xs.size()), std::span(ys.constData(), ys.size()), snap);
+                if (nearWindows.count() == candidates.count()) {
+                    break;
+                }
+                candidates = nearWindows;
+            }
+            for (auto l = candidates.constBegin(); l != candidates.constEnd(); ++l) {
                 if ((*l)->isOnCurrentDesktop() && !(*l)->isMinimized()
                     && (*l) != window) {
                     lx = (*l)->x();
@@ -3118,6 +3322,11 @@ ScreenEdges *Workspace::screenEdges() const
     return m_screenEdges.get();
 }
 
+WorkloadRecorder *Workspace::workloadRecorder() const
+{
+    return m_workloadRecorder.get();
+}
+
 TileManager *Workspace::tileManager(Output *output)
 {
     return m_tileManagers.at(output).get();
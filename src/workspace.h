@@ -24,6 +24,7 @@
 // std
 #include <functional>
 #include <memory>
+#include <optional>
 
 class KConfig;
 class KConfigGroup;
@@ -67,6 +68,8 @@ class X11EventFilter;
 class FocusChain;
 class ApplicationMenu;
 class PlacementTracker;
+class SnapEdgeIndex;
+class WorkloadRecorder;
 enum class Predicate;
 class Outline;
 class RuleBook;
@@ -469,6 +472,10 @@ public:
 #if KWIN_BUILD_ACTIVITIES
     Activities *activities() const;
 #endif
+    /**
+     * Returns the workload recorder, or @c nullptr if this is not a Wayland session.
+     */
+    WorkloadRecorder *workloadRecorder() const;
 
     /**
      * Apply the requested output configuration. Note that you must use this function
@@ -658,6 +665,22 @@ private:
     void updateOutputConfiguration();
     void updateOutputs(const QVector<Output *> &outputOrder = {});
 
+    /**
+     * The part of the client areas that a window with a strut takes away.
+     */
+    struct StrutContribution
+    {
+        QRectF workArea;
+        bool hasOffscreenStrut = false;
+        StrutRects restrictedArea;
+        QHash<const Output *, QRectF> screenAreas;
+        // Empty if the window is on all desktops.
+        QVector<VirtualDesktop *> desktops;
+
+        bool operator==(const StrutContribution &other) const = default;
+    };
+    std::optional<StrutContribution> strutContribution(Window *window) const;
+
     struct Constraint
     {
         Window *below;
@@ -746,6 +769,11 @@ private:
     QSize olddisplaysize; // previous sizes od displayWidth()/displayHeight()
     QHash<const VirtualDesktop *, StrutRects> m_oldRestrictedAreas;
     bool m_inUpdateClientArea = false;
+    // What the client areas were last computed from.
+    QHash<const Window *, StrutContribution> m_strutContributions;
+    QHash<const Output *, QRectF> m_clientAreaOutputs;
+    QVector<VirtualDesktop *> m_clientAreaDesktops;
+    QRect m_clientAreaGeometry;
 
     int m_setActiveWindowRecursion = 0;
     int m_blockStackingUpdates = 0; // When > 0, stacking updates are temporarily disabled
@@ -772,6 +800,8 @@ private:
     std::unique_ptr<Activities> m_activities;
 #endif
     std::unique_ptr<PlacementTracker> m_placementTracker;
+    std::unique_ptr<SnapEdgeIndex> m_snapEdgeIndex;
+    std::unique_ptr<WorkloadRecorder> m_workloadRecorder;
 
     PlaceholderOutput *m_placeholderOutput = nullptr;
     std::unique_ptr<PlaceholderInputEventFilter> m_placeholderFilter;